@@ -9,11 +9,8 @@ TARGET = qsqlfb
 
 DEFINES += QT_NO_CAST_TO_ASCII \
     QT_NO_CAST_FROM_ASCII
-HEADERS += src/qsql_ibpp.h
-
-SOURCES += src/main.cpp \
-    src/qsql_ibpp.cpp
-include(./ibpp2531/ibpp.pri) # +=   IBPP
+SOURCES += src/main.cpp
+include(./src/qsqlfb.pri) # +=   driver, IBPP
 contains(QT_CONFIG, reduce_exports):CONFIG += hide_symbols  # +=   hide_symbols
 
 target.path     += $$[QT_INSTALL_PLUGINS]/sqldrivers
@@ -96,13 +96,36 @@ namespace ibpp_internals
 
 using namespace ibpp_internals;
 
+#ifdef IBPP_UNIX
+//	The client library is linked in. Its optional entry points are searched in
+//	the module which provides isc_attach_database, that module not being
+//	necessarily in the global scope (a plugin loaded with RTLD_LOCAL).
+static void* ClientSymbol(const char* name)
+{
+	static void* module = 0;
+	if (module == 0)
+	{
+		Dl_info info;
+		if (dladdr((void*)isc_attach_database, &info) != 0 && info.dli_fname != 0)
+			module = dlopen(info.dli_fname, RTLD_NOW | RTLD_NOLOAD);
+		if (module == 0) module = RTLD_DEFAULT;
+	}
+	return dlsym(module, name);
+}
+#endif
+
 GDS* GDS::Call()
 {
 	// Let's load the CLIENT library, if it is not already loaded.
-	// The load is guaranteed to be done only once per application.
+	// The load is guaranteed to be done only once per application, even when
+	// several threads get here at the same time : the first one binds the
+	// entry points under mLock, the others wait for it and then find mReady.
 
-	if (! mReady)
+	if (mReady.Get() == 0)
 	{
+		MutexLocker guard(mLock);
+		if (mReady.Get() != 0) return this;	// Bound meanwhile by another thread
+
 #ifdef IBPP_WINDOWS
 
 		// Let's load the FBCLIENT.DLL or GDS32.DLL, we will never release it.
@@ -271,7 +294,32 @@ GDS* GDS::Call()
 		IB_ENTRYPOINT(service_start);
 		IB_ENTRYPOINT(service_query);
 
-		mReady = true;
+		// Optional entry points of later versions, looked up without failing
+#ifdef IBPP_WINDOWS
+#define FB_ENTRYPOINT(X) m_##X = (proto_##X*)GetProcAddress(mHandle, #X)
+#endif
+#ifdef IBPP_UNIX
+#define FB_ENTRYPOINT(X) m_##X = (proto_##X*)ClientSymbol(#X)
+#endif
+
+		FB_ENTRYPOINT(fb_cancel_operation);
+		FB_ENTRYPOINT(fb_get_master_interface);
+		FB_ENTRYPOINT(fb_get_database_handle);
+		FB_ENTRYPOINT(fb_get_transaction_handle);
+		FB_ENTRYPOINT(fb_get_transaction_interface);
+		FB_ENTRYPOINT(fb_get_statement_interface);
+
+		// The OO API backend needs the master interface, and the helpers
+		// going from the interfaces to the legacy handles and back
+		mOOApi = m_fb_get_master_interface != 0
+			&& m_fb_get_database_handle != 0
+			&& m_fb_get_transaction_handle != 0
+			&& m_fb_get_transaction_interface != 0
+			&& m_fb_get_statement_interface != 0;
+
+		TraceFromEnvironment();
+
+		mReady.Set(1);	// Publishes the entry points to the other threads
 	}
 
 	return this;
@@ -292,9 +340,20 @@ namespace IBPP
 		return gds.Call()->mGDSVersion;
 	}
 
+	void UseLegacyAPI(bool legacy)
+	{
+		gds.mLegacyForced.Set(legacy ? 1 : 0);
+	}
+
+	bool OOApiActive()
+	{
+		return gds.Call()->OOApi();
+	}
+
 #ifdef IBPP_WINDOWS
 	void ClientLibSearchPaths(const std::string& paths)
 	{
+		MutexLocker guard(gds.mLock);
 		gds.mSearchPaths.assign(paths);
 	}
 #else
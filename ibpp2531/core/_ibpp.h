@@ -48,6 +48,7 @@
 #endif
 
 #include "ibase.h"		// From Firebird 1.x or InterBase 6.x installation
+#include "_oo.h"		// Firebird OO API interfaces
 
 #if (defined(__GNUC__) && defined(IBPP_WINDOWS))
 //	UNSETTING flags used above for ibase.h -- Huge conflicts with libstdc++ !
@@ -55,13 +56,44 @@
 #undef _WIN32
 #endif
 
+//	Items of later Firebird versions, unknown to older ibase.h
+#ifndef isc_tpb_at_snapshot_number
+#define isc_tpb_at_snapshot_number	23		// Firebird 4
+#endif
+#ifndef isc_dpb_set_bind
+#define isc_dpb_set_bind			93		// Firebird 4
+#endif
+#ifndef SQL_BOOLEAN
+#define SQL_BOOLEAN				32764		// Firebird 3
+#endif
+#ifndef SQL_INT128
+#define SQL_INT128				32752		// Firebird 4 ...
+#define SQL_DEC16				32760
+#define SQL_DEC34				32762
+#define SQL_TIMESTAMP_TZ		32754
+#define SQL_TIME_TZ				32756
+#define SQL_TIMESTAMP_TZ_EX		32748		// With the offset (SET BIND)
+#define SQL_TIME_TZ_EX			32750
+#endif
+#ifndef fb_cancel_raise
+#define fb_cancel_disable		1			// Firebird 2.5
+#define fb_cancel_enable		2
+#define fb_cancel_raise			3
+#define fb_cancel_abort			4
+#endif
+
 #ifdef IBPP_WINDOWS
 #include <windows.h>
 #endif
+#ifdef IBPP_UNIX
+#include <pthread.h>
+#include <dlfcn.h>
+#endif
 
 #include <limits>
 #include <string>
 #include <vector>
+#include <map>
 #include <sstream>
 #include <cstdarg>
 
@@ -111,6 +143,70 @@ struct DebugStream
 
 #endif	// _DEBUG
 
+//
+//	Thread safety primitives (see the concurrency notes in ibpp.h)
+//
+
+//	Integer counter with atomic increment and decrement, used for the
+//	reference counts of the *Impl objects. The operators return the new
+//	value, so Release() must test the result of --mRefCount and never
+//	re-read the counter.
+class AtomicInt
+{
+#ifdef IBPP_WINDOWS
+	volatile LONG mValue;
+public:
+	int operator++() { return (int)InterlockedIncrement(&mValue); }
+	int operator--() { return (int)InterlockedDecrement(&mValue); }
+	int Get() const { return (int)InterlockedCompareExchange(const_cast<LONG*>(&mValue), 0, 0); }
+	void Set(int value) { InterlockedExchange(&mValue, (LONG)value); }
+#else
+	volatile int mValue;
+public:
+	int operator++() { return __sync_add_and_fetch(&mValue, 1); }
+	int operator--() { return __sync_sub_and_fetch(&mValue, 1); }
+	int Get() const { return __sync_add_and_fetch(const_cast<int*>(&mValue), 0); }
+	void Set(int value) { __sync_synchronize(); mValue = value; __sync_synchronize(); }
+#endif
+	operator int() const { return Get(); }
+
+	AtomicInt(int value = 0) : mValue(value) { }
+};
+
+//	Non recursive mutual exclusion lock and its scoped guard
+class Mutex
+{
+#ifdef IBPP_WINDOWS
+	CRITICAL_SECTION mSection;
+public:
+	void Lock() { EnterCriticalSection(&mSection); }
+	void Unlock() { LeaveCriticalSection(&mSection); }
+	Mutex() { InitializeCriticalSection(&mSection); }
+	~Mutex() { DeleteCriticalSection(&mSection); }
+#else
+	pthread_mutex_t mMutex;
+public:
+	void Lock() { pthread_mutex_lock(&mMutex); }
+	void Unlock() { pthread_mutex_unlock(&mMutex); }
+	Mutex() { pthread_mutex_init(&mMutex, 0); }
+	~Mutex() { pthread_mutex_destroy(&mMutex); }
+#endif
+private:
+	Mutex(const Mutex&);
+	Mutex& operator=(const Mutex&);
+};
+
+class MutexLocker
+{
+	Mutex& mMutex;
+public:
+	MutexLocker(Mutex& m) : mMutex(m) { mMutex.Lock(); }
+	~MutexLocker() { mMutex.Unlock(); }
+private:
+	MutexLocker(const MutexLocker&);
+	MutexLocker& operator=(const MutexLocker&);
+};
+
 class DatabaseImpl;
 class TransactionImpl;
 class StatementImpl;
@@ -118,10 +214,33 @@ class BlobImpl;
 class ArrayImpl;
 class EventsImpl;
 
+//	Slot tables
+//	An object listed in a table of its DatabaseImpl or TransactionImpl keeps
+//	its index in that table, so it is removed in constant time by moving the
+//	last entry into its slot. The order of the tables is not significant.
+
+template<class T>
+inline void SlotAttach(std::vector<T*>& table, T* obj, size_t T::* slot)
+{
+	obj->*slot = table.size();
+	table.push_back(obj);
+}
+
+template<class T>
+inline void SlotDetach(std::vector<T*>& table, T* obj, size_t T::* slot)
+{
+	size_t index = obj->*slot;
+	ASSERTION(index < table.size() && table[index] == obj);
+	T* last = table.back();
+	table[index] = last;
+	last->*slot = index;
+	table.pop_back();
+}
+
 //	Native data types
 typedef enum {ivArray, ivBlob, ivDate, ivTime, ivTimestamp, ivString,
 			ivInt16, ivInt32, ivInt64, ivFloat, ivDouble,
-			ivBool, ivDBKey, ivByte} IITYPE;
+			ivBool, ivDBKey, ivByte, ivInt128, ivTimestampTz, ivTimeTz} IITYPE;
 
 //
 //	Those are the Interbase C API prototypes that we use
@@ -366,6 +485,31 @@ typedef ISC_STATUS ISC_EXPORT proto_service_start (ISC_STATUS *,
     					 unsigned short,
     					 char*);
 
+//	Optional entry points of later Firebird versions. They are looked up
+//	without failing and stay null when the client library lacks them.
+
+typedef ISC_STATUS  ISC_EXPORT proto_fb_cancel_operation (ISC_STATUS *,	// Firebird 2.5
+					isc_db_handle *,
+					ISC_USHORT);
+
+typedef ibpp_oo::IMaster* ISC_EXPORT proto_fb_get_master_interface (void);	// Firebird 3
+
+typedef ISC_STATUS  ISC_EXPORT proto_fb_get_database_handle (ISC_STATUS *,	// Firebird 4
+					isc_db_handle *,
+					ibpp_oo::IAttachment *);
+
+typedef ISC_STATUS  ISC_EXPORT proto_fb_get_transaction_handle (ISC_STATUS *,	// Firebird 4
+					isc_tr_handle *,
+					ibpp_oo::ITransaction *);
+
+typedef ISC_STATUS  ISC_EXPORT proto_fb_get_transaction_interface (ISC_STATUS *,	// Firebird 4
+					ibpp_oo::ITransaction **,
+					isc_tr_handle *);
+
+typedef ISC_STATUS  ISC_EXPORT proto_fb_get_statement_interface (ISC_STATUS *,	// Firebird 4
+					ibpp_oo::IStatement **,
+					isc_stmt_handle *);
+
 typedef void        ISC_EXPORT proto_decode_sql_date (ISC_DATE *,
 					void *);
 
@@ -391,8 +535,12 @@ typedef void        ISC_EXPORT proto_encode_timestamp (void *,
 struct GDS
 {
 	// Attributes
-	bool mReady;
+	AtomicInt mReady;		// Set once all the entry points are bound
+	Mutex mLock;			// Serializes the binding done by Call()
 	int mGDSVersion; 		// Version of the GDS32.DLL (50 for 5.0, 60 for 6.0)
+	bool mOOApi;			// The client library exports the OO API (see _oo.cpp)
+	AtomicInt mLegacyForced;	// IBPP::UseLegacyAPI(true) is in effect
+	bool mTracing;			// The entry points are wrapped (see _trace.cpp)
 
 #ifdef IBPP_WINDOWS
 	HMODULE mHandle;			// The GDS32.DLL HMODULE
@@ -400,6 +548,9 @@ struct GDS
 #endif
 
 	GDS* Call();
+	bool OOApi() { return mOOApi && mLegacyForced.Get() == 0; }	// For new attachments
+	void Trace(bool enable, const char* file);
+	void TraceFromEnvironment();
 
 	// GDS32 Entry Points
 	proto_create_database*			m_create_database;
@@ -450,6 +601,14 @@ struct GDS
 	proto_service_detach*			m_service_detach;
 	proto_service_start*			m_service_start;
 	proto_service_query*			m_service_query;
+
+	// Optional entry points, null when not exported by the client library
+	proto_fb_cancel_operation*		m_fb_cancel_operation;
+	proto_fb_get_master_interface*		m_fb_get_master_interface;
+	proto_fb_get_database_handle*		m_fb_get_database_handle;
+	proto_fb_get_transaction_handle*	m_fb_get_transaction_handle;
+	proto_fb_get_transaction_interface*	m_fb_get_transaction_interface;
+	proto_fb_get_statement_interface*	m_fb_get_statement_interface;
 	//proto_decode_sql_date*			m_decode_sql_date;
 	//proto_decode_sql_time*			m_decode_sql_time;
 	//proto_decode_timestamp*			m_decode_timestamp;
@@ -460,8 +619,10 @@ struct GDS
 	// Constructor (No need for a specific destructor)
 	GDS()
 	{
-		mReady = false;
+		mReady.Set(0);
 		mGDSVersion = 0;
+		mOOApi = false;
+		mTracing = false;
 #ifdef IBPP_WINDOWS
 		mHandle = 0;
 #endif
@@ -542,6 +703,7 @@ class TPB
 public:
 	void Insert(char);				// Insert a flag item
 	void Insert(const std::string& data); // Insert a string (typically table name)
+	void InsertInt64(char type, int64_t data);	// Insert a counted 8 bytes value
 	void Reset();				// Clears the TPB
 	char* Self() { return mBuffer; }
 	int Size() { return mSize; }
@@ -753,7 +915,7 @@ class ServiceImpl : public IBPP::IService
 	//	(((((((( OBJECT INTERNALS ))))))))
 
 private:
-	int mRefCount;				// Reference counter
+	AtomicInt mRefCount;				// Reference counter
     isc_svc_handle mHandle;		// InterBase API Service Handle
 	std::string mServerName;	// Nom du serveur
     std::string mUserName;		// Nom de l'utilisateur
@@ -814,7 +976,7 @@ class DatabaseImpl : public IBPP::IDatabase
 {
 	//	(((((((( OBJECT INTERNALS ))))))))
 
-	int mRefCount;				// Reference counter
+	AtomicInt mRefCount;				// Reference counter
     isc_db_handle mHandle;		// InterBase API Session Handle
 	std::string mServerName;	// Server name
     std::string mDatabaseName;	// Database name (path/file)
@@ -830,10 +992,12 @@ class DatabaseImpl : public IBPP::IDatabase
 	std::vector<BlobImpl*> mBlobs;			// Table of Blob*
 	std::vector<ArrayImpl*> mArrays;		// Table of Array*
 	std::vector<EventsImpl*> mEvents;		// Table of Events*
+	ibpp_oo::IAttachment* mAttachment;		// OO API only
 
 public:
 	isc_db_handle* GetHandlePtr() { return &mHandle; }
 	isc_db_handle GetHandle() { return mHandle; }
+	ibpp_oo::IAttachment* GetInterface() { return mAttachment; }
 
 	void AttachTransactionImpl(TransactionImpl*);
 	void DetachTransactionImpl(TransactionImpl*);
@@ -869,6 +1033,8 @@ public:
 	void Statistics(int* Fetches, int* Marks, int* Reads, int* Writes);
 	void Counts(int* Insert, int* Update, int* Delete,
 		int* ReadIdx, int* ReadSeq);
+	void Activity(int* Fetches, int* Marks, int* Reads, int* Writes,
+		int* ReadIdx, int* ReadSeq);
 	void Users(std::vector<std::string>& users);
 	int Dialect() { return mDialect; }
 
@@ -878,6 +1044,8 @@ public:
 	void Inactivate();
 	void Disconnect();
     void Drop();
+	bool CancelOperation();
+	bool OOApiActive() { return mAttachment != 0; }
 
 	IBPP::IDatabase* AddRef();
 	void Release();
@@ -888,20 +1056,30 @@ class TransactionImpl : public IBPP::ITransaction
 	//	(((((((( OBJECT INTERNALS ))))))))
 
 private:
-	int mRefCount;					// Reference counter
+	AtomicInt mRefCount;					// Reference counter
     isc_tr_handle mHandle;			// Transaction InterBase
 
 	std::vector<DatabaseImpl*> mDatabases;   	// Tableau de IDatabase*
+	std::vector<size_t> mDbSlots;				// Slots in mDatabases[i]->mTransactions
 	std::vector<StatementImpl*> mStatements;	// Tableau de IStatement*
 	std::vector<BlobImpl*> mBlobs;				// Tableau de IBlob*
 	std::vector<ArrayImpl*> mArrays;			// Tableau de Array*
 	std::vector<TPB*> mTPBs;					// Tableau de TPB
+	ibpp_oo::ITransaction* mInterface;			// OO API only
+
+	typedef std::pair<DatabaseImpl*, std::string> ArrayKey;	// "table.column"
+	typedef std::map<ArrayKey, ISC_ARRAY_DESC> ArrayDescs;
+	ArrayDescs mArrayDescs;		// isc_array_lookup_bounds results
 
 	void Init();			// A usage exclusif des constructeurs
 
 public:
 	isc_tr_handle* GetHandlePtr() { return &mHandle; }
 	isc_tr_handle GetHandle() { return mHandle; }
+	ibpp_oo::ITransaction* GetInterface();
+
+	size_t DatabaseSlot(DatabaseImpl*);
+	void SetDatabaseSlot(DatabaseImpl*, size_t);
 
 	void AttachStatementImpl(StatementImpl*);
 	void DetachStatementImpl(StatementImpl*);
@@ -909,6 +1087,20 @@ public:
 	void DetachBlobImpl(BlobImpl*);
 	void AttachArrayImpl(ArrayImpl*);
 	void DetachArrayImpl(ArrayImpl*);
+
+	//	Array descriptors are kept for the life of the transaction: DDL
+	//	committed by another attachment is seen by the next one. Start(),
+	//	the ends of the transaction and the statements executing DDL call
+	//	ForgetArrayDescs().
+	const ISC_ARRAY_DESC* FindArrayDesc(DatabaseImpl* db, const std::string& key) const
+	{
+		ArrayDescs::const_iterator it = mArrayDescs.find(ArrayKey(db, key));
+		return it == mArrayDescs.end() ? 0 : &it->second;
+	}
+	void KeepArrayDesc(DatabaseImpl* db, const std::string& key, const ISC_ARRAY_DESC& desc)
+		{ mArrayDescs[ArrayKey(db, key)] = desc; }
+	void ForgetArrayDescs() { mArrayDescs.clear(); }
+
     void AttachDatabaseImpl(DatabaseImpl* dbi, IBPP::TAM am = IBPP::amWrite,
 			IBPP::TIL il = IBPP::ilConcurrency,
 			IBPP::TLR lr = IBPP::lrWait, IBPP::TFF flags = IBPP::TFF(0));
@@ -928,6 +1120,7 @@ public:
     void DetachDatabase(IBPP::Database db);
 	void AddReservation(IBPP::Database db,
 			const std::string& table, IBPP::TTR tr);
+	void SetSnapshotNumber(IBPP::Database db, int64_t number);
 
     void Start();
 	bool Started() { return mHandle == 0 ? false : true; }
@@ -945,7 +1138,7 @@ class RowImpl : public IBPP::IRow
 	//	(((((((( OBJECT INTERNALS ))))))))
 
 private:
-	int mRefCount;					// Reference counter
+	AtomicInt mRefCount;					// Reference counter
 
 	XSQLDA* mDescrArea;				// XSQLDA descriptor itself
 	std::vector<double> mNumerics;	// Temporary storage for Numerics
@@ -963,6 +1156,11 @@ private:
 
 	void SetValue(int, IITYPE, const void* value, int = 0);
 	void* GetValue(int, IITYPE, void* = 0);
+	IBPP::RSC SetValueRC(int, IITYPE, const void* value, int = 0);
+	IBPP::RSC GetValueRC(int, IITYPE, void*& value, void* = 0);
+	IBPP::RSC TrySetValue(int, IITYPE, const void* value);
+	IBPP::RSC TryGetValue(int, IITYPE, void*& value, void* = 0);
+	void RaiseRC(IBPP::RSC, const char* context, int, IITYPE);
 
 public:
 	void Free();
@@ -993,6 +1191,9 @@ public:
 	void Set(int, const IBPP::Timestamp&);
 	void Set(int, const IBPP::Date&);
 	void Set(int, const IBPP::Time&);
+	void Set(int, const IBPP::Int128&);
+	void Set(int, const IBPP::TimestampTz&);
+	void Set(int, const IBPP::TimeTz&);
 	void Set(int, const IBPP::DBKey&);
 	void Set(int, const IBPP::Blob&);
 	void Set(int, const IBPP::Array&);
@@ -1010,10 +1211,43 @@ public:
 	bool Get(int, IBPP::Timestamp&);
 	bool Get(int, IBPP::Date&);
 	bool Get(int, IBPP::Time&);
+	bool Get(int, IBPP::Int128&);
+	bool Get(int, IBPP::TimestampTz&);
+	bool Get(int, IBPP::TimeTz&);
 	bool Get(int, IBPP::DBKey&);
 	bool Get(int, IBPP::Blob&);
 	bool Get(int, IBPP::Array&);
 
+	IBPP::RSC TrySetNull(int);
+	IBPP::RSC TrySet(int, bool);
+	IBPP::RSC TrySet(int, const std::string&);
+	IBPP::RSC TrySet(int, int16_t);
+	IBPP::RSC TrySet(int, int32_t);
+	IBPP::RSC TrySet(int, int64_t);
+	IBPP::RSC TrySet(int, float);
+	IBPP::RSC TrySet(int, double);
+	IBPP::RSC TrySet(int, const IBPP::Timestamp&);
+	IBPP::RSC TrySet(int, const IBPP::Date&);
+	IBPP::RSC TrySet(int, const IBPP::Time&);
+	IBPP::RSC TrySet(int, const IBPP::Int128&);
+	IBPP::RSC TrySet(int, const IBPP::TimestampTz&);
+	IBPP::RSC TrySet(int, const IBPP::TimeTz&);
+	IBPP::RSC TrySet(int, const IBPP::Blob&);
+	IBPP::RSC TryGet(int, bool&);
+	IBPP::RSC TryGet(int, std::string&);
+	IBPP::RSC TryGet(int, int16_t&);
+	IBPP::RSC TryGet(int, int32_t&);
+	IBPP::RSC TryGet(int, int64_t&);
+	IBPP::RSC TryGet(int, float&);
+	IBPP::RSC TryGet(int, double&);
+	IBPP::RSC TryGet(int, IBPP::Timestamp&);
+	IBPP::RSC TryGet(int, IBPP::Date&);
+	IBPP::RSC TryGet(int, IBPP::Time&);
+	IBPP::RSC TryGet(int, IBPP::Int128&);
+	IBPP::RSC TryGet(int, IBPP::TimestampTz&);
+	IBPP::RSC TryGet(int, IBPP::TimeTz&);
+	IBPP::RSC TryGet(int, IBPP::Blob&);
+
 	bool IsNull(const std::string&);
 	bool Get(const std::string&, bool&);
 	bool Get(const std::string&, char*);	// c-strings, len unchecked
@@ -1027,6 +1261,9 @@ public:
 	bool Get(const std::string&, IBPP::Timestamp&);
 	bool Get(const std::string&, IBPP::Date&);
 	bool Get(const std::string&, IBPP::Time&);
+	bool Get(const std::string&, IBPP::Int128&);
+	bool Get(const std::string&, IBPP::TimestampTz&);
+	bool Get(const std::string&, IBPP::TimeTz&);
 	bool Get(const std::string&, IBPP::DBKey&);
 	bool Get(const std::string&, IBPP::Blob&);
 	bool Get(const std::string&, IBPP::Array&);
@@ -1052,18 +1289,79 @@ public:
 	void Release();
 };
 
+//
+//	Firebird OO API backend (_oo.cpp), used when GDS::OOApi() is true at the
+//	time of the attachment. Attachments and single database transactions are
+//	started through IProvider and IAttachment, then get a legacy handle
+//	(fb_get_xxx_handle) : both address the same objects, so the rest of IBPP
+//	(blobs, arrays, events, info calls, commits) keeps using the isc_* entry
+//	points on the handles.
+//
+
+ibpp_oo::IAttachment* OOAttach(const std::string& connect, DPB& dpb, isc_db_handle* handle);
+ibpp_oo::ITransaction* OOStart(ibpp_oo::IAttachment*, TPB& tpb, isc_tr_handle* handle);
+ibpp_oo::ITransaction* OOTransaction(isc_tr_handle* handle);
+void OORelease(ibpp_oo::IAttachment*);
+void OORelease(ibpp_oo::ITransaction*);
+std::string OOZoneName(int zoneid);
+
+//	OO API side of a prepared StatementImpl : the IStatement behind its handle
+//	executes it and fetches the rows, with the messages described by the
+//	statement itself. The values are copied between the messages and the
+//	XSQLDAs of the statement, where the usual RowImpl accessors find them.
+
+class OOStatement
+{
+	ibpp_oo::IStatus* mStatus;
+	ibpp_oo::IStatement* mStatement;
+	ibpp_oo::IMessageMetadata* mInMeta;
+	ibpp_oo::IMessageMetadata* mOutMeta;
+	ibpp_oo::IResultSet* mResultSet;
+	ibpp_oo::IBatch* mBatch;
+	bool mBatchable;				// IBatch usable (Firebird 4, no blob parameters)
+	bool mScrollable;				// mResultSet is a scrollable cursor
+	std::vector<char> mInBuffer;	// Input message
+	std::vector<char> mOutBuffer;	// Output message
+
+	void Raise(const char* context, const char* message);
+	void ToMessage(XSQLDA* sqlda);
+	void FromMessage(XSQLDA* sqlda);
+
+public:
+	enum Move {mvNext, mvPrior, mvFirst, mvLast, mvAbsolute, mvRelative};
+
+	bool Bind(isc_stmt_handle*, RowImpl* in, RowImpl* out);
+	bool Execute(IBS& status, ibpp_oo::ITransaction*, RowImpl* in, RowImpl* out,
+		bool cursor, bool scrollable = false);
+	bool CursorOpened() { return mResultSet != 0; }
+	bool Scrollable() { return mResultSet != 0 && mScrollable; }
+	// 0, 100 when the move leaves the result set, -1 on errors
+	int Fetch(IBS& status, RowImpl* row, Move move = mvNext, int position = 0);
+	void CloseCursor();
+	bool Batchable() { return mBatchable; }
+	void AddBatch(RowImpl* in);
+	int ExecuteBatch(ibpp_oo::ITransaction*);
+	void SetTimeout(unsigned msecs);
+
+	OOStatement();
+	~OOStatement();
+};
+
 class StatementImpl : public IBPP::IStatement
 {
 	//	(((((((( OBJECT INTERNALS ))))))))
 
 private:
+	friend class DatabaseImpl;
 	friend class TransactionImpl;
 
-	int mRefCount;				// Reference counter
+	AtomicInt mRefCount;				// Reference counter
 	isc_stmt_handle mHandle;	// Statement Handle
 
 	DatabaseImpl* mDatabase;		// Attached database
 	TransactionImpl* mTransaction;	// Attached transaction
+	size_t mDbSlot;					// Slot in mDatabase->mStatements
+	size_t mTrSlot;					// Slot in mTransaction->mStatements
 	RowImpl* mInRow;
 	//bool* mInMissing;			// Quels paramtres n'ont pas t spcifis
 	RowImpl* mOutRow;
@@ -1071,9 +1369,15 @@ private:
 	bool mCursorOpened;			// dsql_set_cursor_name was called
 	IBPP::STT mType;			// Type de requte
 	std::string mSql;			// Last SQL statement prepared or executed
+	IBS mLastStatus;			// Status of the last TryExecute()
+	std::vector<RowImpl*> mBatch;	// Parameter values queued by AddBatch()
+	OOStatement* mOO;			// OO API side, on the attachments using it
 
 	// Internal Methods
 	void CursorFree();
+	void BatchFree();
+	bool ScrollFetch(OOStatement::Move move, int position, const char* context);
+	bool ExecuteStatus(IBS& status);
 
 public:
 	// Properties and Attributes Access Methods
@@ -1099,6 +1403,7 @@ public:
 	bool Fetch();
 	bool Fetch(IBPP::Row&);
 	int AffectedRows();
+	void RecordCounts(int* Select, int* Insert, int* Update, int* Delete);
 	void Close();	// Free resources, attachments maintained
 	std::string& Sql() { return mSql; }
 	IBPP::STT Type() { return mType; }
@@ -1116,6 +1421,9 @@ public:
 	void Set(int, const IBPP::Timestamp&);
 	void Set(int, const IBPP::Date&);
 	void Set(int, const IBPP::Time&);
+	void Set(int, const IBPP::Int128&);
+	void Set(int, const IBPP::TimestampTz&);
+	void Set(int, const IBPP::TimeTz&);
 	void Set(int, const IBPP::DBKey&);
 	void Set(int, const IBPP::Blob&);
 	void Set(int, const IBPP::Array&);
@@ -1139,10 +1447,60 @@ public:
 	bool Get(int, IBPP::Timestamp&);
 	bool Get(int, IBPP::Date&);
 	bool Get(int, IBPP::Time&);
+	bool Get(int, IBPP::Int128&);
+	bool Get(int, IBPP::TimestampTz&);
+	bool Get(int, IBPP::TimeTz&);
 	bool Get(int, IBPP::DBKey&);
 	bool Get(int, IBPP::Blob&);
 	bool Get(int, IBPP::Array&);
 
+	IBPP::RSC TrySetNull(int);
+	IBPP::RSC TrySet(int, bool);
+	IBPP::RSC TrySet(int, const std::string&);
+	IBPP::RSC TrySet(int, int16_t);
+	IBPP::RSC TrySet(int, int32_t);
+	IBPP::RSC TrySet(int, int64_t);
+	IBPP::RSC TrySet(int, float);
+	IBPP::RSC TrySet(int, double);
+	IBPP::RSC TrySet(int, const IBPP::Timestamp&);
+	IBPP::RSC TrySet(int, const IBPP::Date&);
+	IBPP::RSC TrySet(int, const IBPP::Time&);
+	IBPP::RSC TrySet(int, const IBPP::Int128&);
+	IBPP::RSC TrySet(int, const IBPP::TimestampTz&);
+	IBPP::RSC TrySet(int, const IBPP::TimeTz&);
+	IBPP::RSC TrySet(int, const IBPP::Blob&);
+	IBPP::RSC TryGet(int, bool&);
+	IBPP::RSC TryGet(int, std::string&);
+	IBPP::RSC TryGet(int, int16_t&);
+	IBPP::RSC TryGet(int, int32_t&);
+	IBPP::RSC TryGet(int, int64_t&);
+	IBPP::RSC TryGet(int, float&);
+	IBPP::RSC TryGet(int, double&);
+	IBPP::RSC TryGet(int, IBPP::Timestamp&);
+	IBPP::RSC TryGet(int, IBPP::Date&);
+	IBPP::RSC TryGet(int, IBPP::Time&);
+	IBPP::RSC TryGet(int, IBPP::Int128&);
+	IBPP::RSC TryGet(int, IBPP::TimestampTz&);
+	IBPP::RSC TryGet(int, IBPP::TimeTz&);
+	IBPP::RSC TryGet(int, IBPP::Blob&);
+
+	IBPP::RSC TryExecute();
+	int LastSqlCode();
+	int LastEngineCode();
+	const char* LastErrorMessage();
+
+	void AddBatch();
+	int ExecuteBatch();
+	bool ServerBatch();
+	void SetTimeout(unsigned);
+	void ExecuteScrollable();
+	bool Scrollable();
+	bool FetchPrior();
+	bool FetchFirst();
+	bool FetchLast();
+	bool FetchAbsolute(int position);
+	bool FetchRelative(int offset);
+
 	bool IsNull(const std::string&);
 	bool Get(const std::string&, bool*);
 	bool Get(const std::string&, bool&);
@@ -1162,6 +1520,9 @@ public:
 	bool Get(const std::string&, IBPP::Timestamp&);
 	bool Get(const std::string&, IBPP::Date&);
 	bool Get(const std::string&, IBPP::Time&);
+	bool Get(const std::string&, IBPP::Int128&);
+	bool Get(const std::string&, IBPP::TimestampTz&);
+	bool Get(const std::string&, IBPP::TimeTz&);
 	bool Get(const std::string&, IBPP::DBKey&);
 	bool Get(const std::string&, IBPP::Blob&);
 	bool Get(const std::string&, IBPP::Array&);
@@ -1181,6 +1542,8 @@ public:
 	int ParameterSubtype(int);
 	int ParameterSize(int);
 	int ParameterScale(int);
+	const char* ParameterName(int);
+	const char* ParameterTable(int);
 	int Parameters();
 
 	void Plan(std::string&);
@@ -1198,14 +1561,18 @@ class BlobImpl : public IBPP::IBlob
 
 private:
 	friend class RowImpl;
+	friend class DatabaseImpl;
+	friend class TransactionImpl;
 
-	int mRefCount;
+	AtomicInt mRefCount;
 	bool					mIdAssigned;
 	ISC_QUAD				mId;
 	isc_blob_handle			mHandle;
 	bool					mWriteMode;
 	DatabaseImpl*  			mDatabase;		// Belongs to this database
 	TransactionImpl*		mTransaction;	// Belongs to this transaction
+	size_t					mDbSlot;		// Slot in mDatabase->mBlobs
+	size_t					mTrSlot;		// Slot in mTransaction->mBlobs
 
 	void Init();
 	void SetId(ISC_QUAD*);
@@ -1248,14 +1615,18 @@ class ArrayImpl : public IBPP::IArray
 
 private:
 	friend class RowImpl;
+	friend class DatabaseImpl;
+	friend class TransactionImpl;
 
-	int					mRefCount;		// Reference counter
+	AtomicInt			mRefCount;		// Reference counter
 	bool				mIdAssigned;
 	ISC_QUAD			mId;
 	bool				mDescribed;
 	ISC_ARRAY_DESC		mDesc;
 	DatabaseImpl*  		mDatabase;		// Database attache
 	TransactionImpl*	mTransaction;	// Transaction attache
+	size_t				mDbSlot;		// Slot in mDatabase->mArrays
+	size_t				mTrSlot;		// Slot in mTransaction->mArrays
 	void*				mBuffer;		// Buffer for native data
 	int					mBufferSize;	// Size of this buffer in bytes
 	int					mElemCount;		// Count of elements in this array
@@ -1340,6 +1711,8 @@ public:
 
 class EventsImpl : public IBPP::IEvents
 {
+	friend class DatabaseImpl;
+
 	static const size_t MAXEVENTNAMELEN;
 	static void EventHandler(const char*, short, const char*);
 
@@ -1350,9 +1723,10 @@ class EventsImpl : public IBPP::IEvents
 	Buffer mEventBuffer;
 	Buffer mResultsBuffer;
 
-	int mRefCount;		// Reference counter
+	AtomicInt mRefCount;		// Reference counter
 
 	DatabaseImpl* mDatabase;
+	size_t mDbSlot;			// Slot in mDatabase->mEvents
 	ISC_LONG mId;			// Firebird internal Id of these events
 	bool mQueued;			// Has isc_que_events() been called?
 	bool mTrapped;			// EventHandled() was called since last que_events()
@@ -1395,6 +1769,31 @@ void decodeTime(IBPP::Time& tm, const ISC_TIME& isc_tm);
 void encodeTimestamp(ISC_TIMESTAMP& isc_ts, const IBPP::Timestamp& ts);
 void decodeTimestamp(IBPP::Timestamp& ts, const ISC_TIMESTAMP& isc_ts);
 
+//	Array elements (array.cpp), between a slice buffer of count elements
+//	described by desc and the user array of Array::ReadTo() / WriteFrom()
+
+void decodeArraySlice(const ISC_ARRAY_DESC& desc, const char* slice,
+	IBPP::ADT adtype, void* data, int count);
+void encodeArraySlice(const ISC_ARRAY_DESC& desc, IBPP::ADT adtype,
+	const void* data, char* slice, int count);
+
+//	Firebird 4 types (types.cpp), from and to the sqldata of their XSQLVAR.
+//	The WITH TIME ZONE ones are the UTC value followed by the zone number
+//	and, in their _EX form, by the offset in minutes.
+
+void encodeInt128(char* isc_i128, const IBPP::Int128& value);
+void decodeInt128(IBPP::Int128& value, const char* isc_i128);
+
+bool encodeDecfloat(char* isc_dec, int digits, const std::string& text);
+bool encodeDecfloat(char* isc_dec, int digits, double value);
+void decodeDecfloat(std::string& text, const char* isc_dec, int digits);
+void decodeDecfloat(double& value, const char* isc_dec, int digits);
+
+void encodeTimestampTz(char* isc_tstz, const IBPP::TimestampTz& ts, bool extended);
+void decodeTimestampTz(IBPP::TimestampTz& ts, const char* isc_tstz, bool extended);
+void encodeTimeTz(char* isc_ttz, const IBPP::TimeTz& tm, bool extended);
+void decodeTimeTz(IBPP::TimeTz& tm, const char* isc_ttz, bool extended);
+
 struct consts	// See _ibpp.cpp for initializations of these constants
 {
 	static const double dscales[19];
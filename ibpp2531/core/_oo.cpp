@@ -0,0 +1,465 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//	File    : $Id$
+//	Subject : IBPP, Firebird OO API backend
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	(C) Copyright 2000-2006 T.I.P. Group S.A. and the IBPP Team (www.ibpp.org)
+//
+//	The contents of this file are subject to the IBPP License (the "License");
+//	you may not use this file except in compliance with the License.  You may
+//	obtain a copy of the License at http://www.ibpp.org or in the 'license.txt'
+//	file which must have been distributed along with this file.
+//
+//	This software, distributed under the License, is distributed on an "AS IS"
+//	basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.  See the
+//	License for the specific language governing rights and limitations
+//	under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	COMMENTS
+//	* Tabulations should be set every four characters when editing this file.
+//	* The interfaces are declared in _oo.h, no Firebird header is needed. The
+//	  functions below are only reached when GDS::OOApi() was true at the time
+//	  the database was attached.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef _MSC_VER
+#pragma warning(disable: 4786 4996)
+#ifndef _DEBUG
+#pragma warning(disable: 4702)
+#endif
+#endif
+
+#include "_ibpp.h"
+
+#ifdef HAS_HDRSTOP
+#pragma hdrstop
+#endif
+
+#include <cstring>
+
+using namespace ibpp_internals;
+
+namespace
+{
+	Mutex ZoneLock;						// Guards ZoneNames
+	std::map<int, std::string> ZoneNames;	// Of OOZoneName()
+
+	ibpp_oo::IMaster* Master()
+	{
+		return (*gds.Call()->m_fb_get_master_interface)();
+	}
+
+	bool Failed(ibpp_oo::IStatus* status)
+	{
+		return (status->getState() & ibpp_oo::IStatus::STATE_ERRORS) != 0;
+	}
+
+	//	Copies the errors of an OO API status into an old-style status vector,
+	//	as many clusters as fit. The message is compiled right away, while the
+	//	strings it refers to still belong to the OO status.
+	void ToIBS(ibpp_oo::IStatus* status, IBS& ibs)
+	{
+		ISC_STATUS* vector = ibs.Self();
+		const intptr_t* errors = status->getErrors();
+
+		int n = 0;
+		while (errors[n] != isc_arg_end)
+		{
+			int size = (errors[n] == isc_arg_cstring) ? 3 : 2;
+			if (n + size > 19) break;
+			for (int i = 0; i < size; i++) vector[n+i] = (ISC_STATUS)errors[n+i];
+			n += size;
+		}
+		vector[n] = isc_arg_end;
+		(void)ibs.ErrorMessage();
+	}
+
+	//	Bytes of the value of a column, as found in the XSQLVAR or the message
+	int DataLength(XSQLVAR* var, const char* data)
+	{
+		if ((var->sqltype & ~1) == SQL_VARYING)
+			return 2 + *(const unsigned short*)data;
+		return var->sqllen;
+	}
+
+	//	The messages of the statement must hold the columns of its XSQLDA, so
+	//	that the values are copied as they are between both.
+	bool SameColumns(ibpp_oo::IStatus* status, ibpp_oo::IMessageMetadata* meta,
+		XSQLDA* sqlda)
+	{
+		if (meta->getCount(status) != (unsigned)sqlda->sqld) return false;
+		for (int i = 0; i < sqlda->sqld; i++)
+		{
+			XSQLVAR* var = &sqlda->sqlvar[i];
+			if (meta->getType(status, i) != (unsigned)(var->sqltype & ~1)
+				|| meta->getLength(status, i) != (unsigned)var->sqllen)
+				return false;
+		}
+		return ! Failed(status);
+	}
+}
+
+namespace ibpp_internals
+{
+
+ibpp_oo::IAttachment* OOAttach(const std::string& connect, DPB& dpb, isc_db_handle* handle)
+{
+	ibpp_oo::IMaster* master = Master();
+	ibpp_oo::IStatus* status = master->getStatus();
+
+	ibpp_oo::IProvider* provider = master->getDispatcher();
+	ibpp_oo::IAttachment* attachment = provider->attachDatabase(status,
+		connect.c_str(), dpb.Size(), (const unsigned char*)dpb.Self());
+	provider->release();
+
+	IBS ibs;
+	bool failed = Failed(status);
+	if (failed) ToIBS(status, ibs);
+	status->dispose();
+	if (failed)
+		throw SQLExceptionImpl(ibs, "Database::Connect", _("IProvider::attachDatabase failed"));
+
+	(*gds.Call()->m_fb_get_database_handle)(ibs.Self(), handle, attachment);
+	if (ibs.Errors())
+	{
+		attachment->release();	// Detaches, nothing else refers to it
+		*handle = 0;
+		throw SQLExceptionImpl(ibs, "Database::Connect", _("fb_get_database_handle failed"));
+	}
+
+	return attachment;
+}
+
+ibpp_oo::ITransaction* OOStart(ibpp_oo::IAttachment* attachment, TPB& tpb,
+	isc_tr_handle* handle)
+{
+	ibpp_oo::IStatus* status = Master()->getStatus();
+
+	ibpp_oo::ITransaction* transaction = attachment->startTransaction(status,
+		tpb.Size(), (const unsigned char*)tpb.Self());
+
+	IBS ibs;
+	bool failed = Failed(status);
+	if (failed) ToIBS(status, ibs);
+	status->dispose();
+	if (failed)
+		throw SQLExceptionImpl(ibs, "Transaction::Start", _("IAttachment::startTransaction failed"));
+
+	(*gds.Call()->m_fb_get_transaction_handle)(ibs.Self(), handle, transaction);
+	if (ibs.Errors())
+	{
+		transaction->release();	// Rolls back, nothing else refers to it
+		*handle = 0;
+		throw SQLExceptionImpl(ibs, "Transaction::Start", _("fb_get_transaction_handle failed"));
+	}
+
+	return transaction;
+}
+
+ibpp_oo::ITransaction* OOTransaction(isc_tr_handle* handle)
+{
+	ibpp_oo::ITransaction* transaction = 0;
+
+	IBS ibs;
+	(*gds.Call()->m_fb_get_transaction_interface)(ibs.Self(), &transaction, handle);
+	if (ibs.Errors())
+		throw SQLExceptionImpl(ibs, "Transaction::GetInterface",
+			_("fb_get_transaction_interface failed"));
+
+	return transaction;
+}
+
+void OORelease(ibpp_oo::IAttachment* attachment)
+{
+	if (attachment != 0) attachment->release();
+}
+
+void OORelease(ibpp_oo::ITransaction* transaction)
+{
+	if (transaction != 0) transaction->release();
+}
+
+//	Name of a region zone, from the time zone database of the client library.
+//	Unlike the attachments, this doesn't depend on IBPP::UseLegacyAPI(). The
+//	names found, or not, are kept for the next values.
+std::string OOZoneName(int zoneid)
+{
+	GDS* lib = gds.Call();
+	if (! lib->mOOApi) return std::string();
+
+	MutexLocker guard(ZoneLock);
+	std::map<int, std::string>::const_iterator it = ZoneNames.find(zoneid);
+	if (it != ZoneNames.end()) return it->second;
+
+	std::string name;
+	ibpp_oo::IMaster* master = Master();
+	ibpp_oo::IUtil* util = master->getUtilInterface();
+	if (util != 0 && util->cloopVTable->version >= 4)
+	{
+		// Any instant does, the name doesn't depend on it
+		ibpp_oo::TimestampTz ts;
+		ts.utc_timestamp.timestamp_date = 58849;	// 2020-01-01
+		ts.utc_timestamp.timestamp_time = 0;
+		ts.time_zone = (unsigned short)zoneid;
+
+		unsigned year, month, day, hours, minutes, seconds, fractions;
+		char buffer[64];
+		buffer[0] = '\0';
+		ibpp_oo::IStatus* status = master->getStatus();
+		util->decodeTimeStampTz(status, &ts, &year, &month, &day, &hours,
+			&minutes, &seconds, &fractions, sizeof(buffer), buffer);
+		buffer[sizeof(buffer) - 1] = '\0';
+		if (! Failed(status)) name = buffer;
+		status->dispose();
+	}
+
+	ZoneNames[zoneid] = name;
+	return name;
+}
+
+}
+
+void OOStatement::Raise(const char* context, const char* message)
+{
+	IBS ibs;
+	ToIBS(mStatus, ibs);
+	throw SQLExceptionImpl(ibs, context, message);
+}
+
+void OOStatement::ToMessage(XSQLDA* sqlda)
+{
+	char* buffer = &mInBuffer[0];
+	for (int i = 0; i < sqlda->sqld; i++)
+	{
+		XSQLVAR* var = &sqlda->sqlvar[i];
+		short* null = (short*)(buffer + mInMeta->getNullOffset(mStatus, i));
+		*null = ((var->sqltype & 1) && *var->sqlind != 0) ? -1 : 0;
+		if (*null == 0)
+			memcpy(buffer + mInMeta->getOffset(mStatus, i), var->sqldata,
+				DataLength(var, var->sqldata));
+	}
+}
+
+void OOStatement::FromMessage(XSQLDA* sqlda)
+{
+	const char* buffer = &mOutBuffer[0];
+	for (int i = 0; i < sqlda->sqld; i++)
+	{
+		XSQLVAR* var = &sqlda->sqlvar[i];
+		bool null = *(const short*)(buffer + mOutMeta->getNullOffset(mStatus, i)) != 0;
+		if (var->sqltype & 1) *var->sqlind = null ? -1 : 0;
+		if (! null)
+		{
+			const char* data = buffer + mOutMeta->getOffset(mStatus, i);
+			memcpy(var->sqldata, data, DataLength(var, data));
+		}
+	}
+}
+
+//	Finds the IStatement behind the handle and its messages. False when they
+//	don't match the XSQLDAs, the statement then stays on the legacy API.
+bool OOStatement::Bind(isc_stmt_handle* handle, RowImpl* in, RowImpl* out)
+{
+	mStatus = Master()->getStatus();
+
+	IBS ibs;
+	(*gds.Call()->m_fb_get_statement_interface)(ibs.Self(), &mStatement, handle);
+	if (ibs.Errors())
+		throw SQLExceptionImpl(ibs, "Statement::Prepare",
+			_("fb_get_statement_interface failed."));
+
+	mStatus->init();
+	mBatchable = mStatement->cloopVTable->version >= ibpp_oo::IStatement::VERSION_FB4;
+	if (in != 0)
+	{
+		mInMeta = mStatement->getInputMetadata(mStatus);
+		if (Failed(mStatus))
+			Raise("Statement::Prepare", _("IStatement::getInputMetadata failed."));
+		if (! SameColumns(mStatus, mInMeta, in->Self())) return false;
+		mInBuffer.resize(mInMeta->getMessageLength(mStatus));
+
+		// Blob and array ids would have to be registered in the IBatch
+		for (int i = 0; i < in->Columns(); i++)
+		{
+			int type = in->Self()->sqlvar[i].sqltype & ~1;
+			if (type == SQL_BLOB || type == SQL_ARRAY) mBatchable = false;
+		}
+	}
+	if (out != 0)
+	{
+		mOutMeta = mStatement->getOutputMetadata(mStatus);
+		if (Failed(mStatus))
+			Raise("Statement::Prepare", _("IStatement::getOutputMetadata failed."));
+		if (! SameColumns(mStatus, mOutMeta, out->Self())) return false;
+		mOutBuffer.resize(mOutMeta->getMessageLength(mStatus));
+	}
+	return ! Failed(mStatus);
+}
+
+bool OOStatement::Execute(IBS& ibs, ibpp_oo::ITransaction* transaction,
+	RowImpl* in, RowImpl* out, bool cursor, bool scrollable)
+{
+	CloseCursor();
+	mStatus->init();
+
+	void* input = 0;
+	if (in != 0)
+	{
+		ToMessage(in->Self());
+		input = &mInBuffer[0];
+	}
+
+	mScrollable = cursor && scrollable;
+	if (cursor)
+		mResultSet = mStatement->openCursor(mStatus, transaction, mInMeta, input,
+			mOutMeta, mScrollable ? ibpp_oo::IStatement::CURSOR_TYPE_SCROLLABLE : 0);
+	else
+	{
+		mStatement->execute(mStatus, transaction, mInMeta, input,
+			mOutMeta, out == 0 ? 0 : &mOutBuffer[0]);
+		if (! Failed(mStatus) && out != 0)
+			FromMessage(out->Self());
+	}
+
+	if (Failed(mStatus))
+	{
+		mResultSet = 0;
+		ToIBS(mStatus, ibs);
+		return false;
+	}
+	return true;
+}
+
+int OOStatement::Fetch(IBS& ibs, RowImpl* row, Move move, int position)
+{
+	mStatus->init();
+	void* message = &mOutBuffer[0];
+	int result;
+	switch (move)
+	{
+		case mvPrior : result = mResultSet->fetchPrior(mStatus, message); break;
+		case mvFirst : result = mResultSet->fetchFirst(mStatus, message); break;
+		case mvLast : result = mResultSet->fetchLast(mStatus, message); break;
+		case mvAbsolute : result = mResultSet->fetchAbsolute(mStatus, position, message); break;
+		case mvRelative : result = mResultSet->fetchRelative(mStatus, position, message); break;
+		default : result = mResultSet->fetchNext(mStatus, message); break;
+	}
+	if (Failed(mStatus))
+	{
+		ToIBS(mStatus, ibs);
+		return -1;
+	}
+	if (result != ibpp_oo::IStatus::RESULT_OK) return 100;
+
+	FromMessage(row->Self());
+	return 0;
+}
+
+void OOStatement::CloseCursor()
+{
+	// Releasing an open result set closes it
+	if (mResultSet != 0)
+	{
+		mResultSet->release();
+		mResultSet = 0;
+	}
+}
+
+void OOStatement::AddBatch(RowImpl* in)
+{
+	mStatus->init();
+
+	if (mBatch == 0)
+	{
+		// Per row counts are asked for, ExecuteBatch() sums them
+		const unsigned char params[] = {ibpp_oo::IBatch::VERSION1,
+			ibpp_oo::IBatch::TAG_RECORD_COUNTS, 4, 0, 0, 0, 1, 0, 0, 0};
+		mBatch = mStatement->createBatch(mStatus, mInMeta, sizeof(params), params);
+		if (Failed(mStatus))
+		{
+			mBatch = 0;
+			Raise("Statement::AddBatch", _("IStatement::createBatch failed."));
+		}
+	}
+
+	ToMessage(in->Self());
+	mBatch->add(mStatus, 1, &mInBuffer[0]);
+	if (Failed(mStatus))
+		Raise("Statement::AddBatch", _("IBatch::add failed."));
+}
+
+//	Sends the queued rows. The IBatch is released in any case, its rows are
+//	not sent again.
+int OOStatement::ExecuteBatch(ibpp_oo::ITransaction* transaction)
+{
+	if (mBatch == 0) return 0;	// Nothing queued
+
+	mStatus->init();
+	ibpp_oo::IBatchCompletionState* state = mBatch->execute(mStatus, transaction);
+	mBatch->release();
+	mBatch = 0;
+	if (Failed(mStatus))
+		Raise("Statement::ExecuteBatch", _("IBatch::execute failed."));
+
+	int count = 0;
+	unsigned size = state->getSize(mStatus);
+	for (unsigned i = 0; i < size; i++)
+	{
+		int rows = state->getState(mStatus, i);
+		if (rows > 0) count += rows;	// Not EXECUTE_FAILED or SUCCESS_NO_INFO
+	}
+
+	unsigned failed = state->findError(mStatus, 0);
+	if (failed != ibpp_oo::IBatchCompletionState::NO_MORE_ERRORS)
+	{
+		ibpp_oo::IStatus* error = Master()->getStatus();
+		state->getStatus(mStatus, error, failed);
+		state->dispose();
+
+		IBS ibs;
+		ToIBS(error, ibs);
+		error->dispose();
+		throw SQLExceptionImpl(ibs, "Statement::ExecuteBatch",
+			_("Row %d of the batch failed."), (int)failed + 1);
+	}
+
+	state->dispose();
+	return count;
+}
+
+void OOStatement::SetTimeout(unsigned msecs)
+{
+	if (mStatement->cloopVTable->version < ibpp_oo::IStatement::VERSION_FB4)
+		throw LogicExceptionImpl("Statement::SetTimeout",
+			_("Statement timeouts need a Firebird 4 client library."));
+
+	mStatus->init();
+	mStatement->setTimeout(mStatus, msecs);
+	if (Failed(mStatus))
+		Raise("Statement::SetTimeout", _("IStatement::setTimeout failed."));
+}
+
+OOStatement::OOStatement()
+	: mStatus(0), mStatement(0), mInMeta(0), mOutMeta(0), mResultSet(0),
+	mBatch(0), mBatchable(false), mScrollable(false)
+{
+}
+
+OOStatement::~OOStatement()
+{
+	CloseCursor();
+	if (mBatch != 0) mBatch->release();
+	if (mOutMeta != 0) mOutMeta->release();
+	if (mInMeta != 0) mInMeta->release();
+	if (mStatement != 0) mStatement->release();
+	if (mStatus != 0) mStatus->dispose();
+}
+
+//
+//	EOF
+//
@@ -0,0 +1,497 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//	File    : $Id$
+//	Subject : IBPP, binary layout of the Firebird OO API interfaces
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	(C) Copyright 2000-2006 T.I.P. Group S.A. and the IBPP Team (www.ibpp.org)
+//
+//	The contents of this file are subject to the IBPP License (the "License");
+//	you may not use this file except in compliance with the License.  You may
+//	obtain a copy of the License at http://www.ibpp.org or in the 'license.txt'
+//	file which must have been distributed along with this file.
+//
+//	This software, distributed under the License, is distributed on an "AS IS"
+//	basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.  See the
+//	License for the specific language governing rights and limitations
+//	under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	COMMENTS
+//	* Tabulations should be set every four characters when editing this file.
+//	* The object interfaces of Firebird 3 and later (IdlFbInterfaces.h of the
+//	  Firebird headers, generated by cloop) are declared here with the layout
+//	  of their method tables, so that IBPP builds without those headers. An
+//	  object starts with a pointer to its table; a table holds the version of
+//	  the interface, then the methods of the base interfaces and its own, in
+//	  declaration order, each taking the object first.
+//	* Only the methods IBPP calls are typed, the other slots are kept as
+//	  plain pointers to preserve the offsets. A method added by a later
+//	  version of an interface is only called once the version of the table
+//	  has been checked.
+//	* The mock client library of the driver tests implements these same
+//	  declarations.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef __INTERNAL_IBPP_OO_H__
+#define __INTERNAL_IBPP_OO_H__
+
+#include <stddef.h>
+#if !defined(_MSC_VER) || _MSC_VER >= 1600
+#include <stdint.h>
+#endif
+
+#include "ibase.h"
+
+#ifndef CLOOP_CARG
+#if defined(_WIN32) && !defined(_WIN64)
+#define CLOOP_CARG __cdecl
+#else
+#define CLOOP_CARG
+#endif
+#endif
+
+namespace ibpp_oo
+{
+
+typedef void* Slot;				// A method IBPP doesn't call
+typedef unsigned char FB_BOOL;	// FB_BOOLEAN of the OO API
+
+struct IStatus;
+struct IMaster;
+struct IProvider;
+struct IUtil;
+struct IAttachment;
+struct ITransaction;
+struct IMessageMetadata;
+struct IStatement;
+struct IResultSet;
+struct IBatch;
+struct IBatchCompletionState;
+
+//	IStatus : IDisposable
+
+struct IStatusVTable
+{
+	void* cloopDummy[1];
+	uintptr_t version;
+	void (CLOOP_CARG *dispose)(IStatus* self);
+	void (CLOOP_CARG *init)(IStatus* self);
+	unsigned (CLOOP_CARG *getState)(const IStatus* self);
+	Slot setErrors2;
+	Slot setWarnings2;
+	Slot setErrors;
+	Slot setWarnings;
+	const intptr_t* (CLOOP_CARG *getErrors)(const IStatus* self);
+	Slot getWarnings;
+	Slot clone;
+};
+
+struct IStatus
+{
+	static const unsigned STATE_WARNINGS = 0x1;
+	static const unsigned STATE_ERRORS = 0x2;
+	static const int RESULT_ERROR = -1;
+	static const int RESULT_OK = 0;
+	static const int RESULT_NO_DATA = 1;
+	static const int RESULT_SEGMENT = 2;
+
+	void* cloopDummy[1];
+	IStatusVTable* cloopVTable;
+
+	void dispose() { cloopVTable->dispose(this); }
+	void init() { cloopVTable->init(this); }
+	unsigned getState() const { return cloopVTable->getState(this); }
+	const intptr_t* getErrors() const { return cloopVTable->getErrors(this); }
+};
+
+//	IMaster : IVersioned
+
+struct IMasterVTable
+{
+	void* cloopDummy[1];
+	uintptr_t version;
+	IStatus* (CLOOP_CARG *getStatus)(IMaster* self);
+	IProvider* (CLOOP_CARG *getDispatcher)(IMaster* self);
+	Slot getPluginManager;
+	Slot getTimerControl;
+	Slot getDtc;
+	Slot registerAttachment;
+	Slot registerTransaction;
+	Slot getMetadataBuilder;
+	Slot serverMode;
+	IUtil* (CLOOP_CARG *getUtilInterface)(IMaster* self);
+	Slot getConfigManager;
+	Slot getProcessExiting;
+};
+
+struct IMaster
+{
+	void* cloopDummy[1];
+	IMasterVTable* cloopVTable;
+
+	IStatus* getStatus() { return cloopVTable->getStatus(this); }
+	IProvider* getDispatcher() { return cloopVTable->getDispatcher(this); }
+	IUtil* getUtilInterface() { return cloopVTable->getUtilInterface(this); }
+};
+
+//	ISC_TIMESTAMP_TZ of Firebird 4
+
+struct TimestampTz
+{
+	ISC_TIMESTAMP utc_timestamp;
+	unsigned short time_zone;
+};
+
+//	IUtil : IVersioned. Version 4 (Firebird 4) adds the DECFLOAT, INT128 and
+//	time zone conversions.
+
+struct IUtilVTable
+{
+	void* cloopDummy[1];
+	uintptr_t version;
+	Slot getFbVersion;
+	Slot loadBlob;
+	Slot dumpBlob;
+	Slot getPerfCounters;
+	Slot executeCreateDatabase;
+	Slot decodeDate;
+	Slot decodeTime;
+	Slot encodeDate;
+	Slot encodeTime;
+	Slot formatStatus;
+	Slot getClientVersion;
+	Slot getXpbBuilder;
+	Slot setOffsets;
+	Slot getDecFloat16;
+	Slot getDecFloat34;
+	Slot decodeTimeTz;
+	void (CLOOP_CARG *decodeTimeStampTz)(IUtil* self, IStatus* status,
+		const TimestampTz* timeStampTz, unsigned* year, unsigned* month,
+		unsigned* day, unsigned* hours, unsigned* minutes, unsigned* seconds,
+		unsigned* fractions, unsigned timeZoneBufferLength, char* timeZoneBuffer);
+	Slot encodeTimeTz;
+	Slot encodeTimeStampTz;
+	Slot getInt128;
+	Slot decodeTimeTzEx;
+	Slot decodeTimeStampTzEx;
+};
+
+struct IUtil
+{
+	void* cloopDummy[1];
+	IUtilVTable* cloopVTable;
+
+	void decodeTimeStampTz(IStatus* status, const TimestampTz* timeStampTz,
+		unsigned* year, unsigned* month, unsigned* day, unsigned* hours,
+		unsigned* minutes, unsigned* seconds, unsigned* fractions,
+		unsigned timeZoneBufferLength, char* timeZoneBuffer)
+	{
+		cloopVTable->decodeTimeStampTz(this, status, timeStampTz, year, month,
+			day, hours, minutes, seconds, fractions, timeZoneBufferLength,
+			timeZoneBuffer);
+	}
+};
+
+//	IProvider : IPluginBase : IReferenceCounted
+
+struct IProviderVTable
+{
+	void* cloopDummy[1];
+	uintptr_t version;
+	void (CLOOP_CARG *addRef)(IProvider* self);
+	int (CLOOP_CARG *release)(IProvider* self);
+	Slot setOwner;
+	Slot getOwner;
+	IAttachment* (CLOOP_CARG *attachDatabase)(IProvider* self, IStatus* status,
+		const char* fileName, unsigned dpbLength, const unsigned char* dpb);
+	Slot createDatabase;
+	Slot attachServiceManager;
+	Slot shutdown;
+	Slot setDbCryptCallback;
+};
+
+struct IProvider
+{
+	void* cloopDummy[1];
+	IProviderVTable* cloopVTable;
+
+	int release() { return cloopVTable->release(this); }
+	IAttachment* attachDatabase(IStatus* status, const char* fileName,
+		unsigned dpbLength, const unsigned char* dpb)
+		{ return cloopVTable->attachDatabase(this, status, fileName, dpbLength, dpb); }
+};
+
+//	IAttachment : IReferenceCounted
+
+struct IAttachmentVTable
+{
+	void* cloopDummy[1];
+	uintptr_t version;
+	void (CLOOP_CARG *addRef)(IAttachment* self);
+	int (CLOOP_CARG *release)(IAttachment* self);
+	Slot getInfo;
+	ITransaction* (CLOOP_CARG *startTransaction)(IAttachment* self, IStatus* status,
+		unsigned tpbLength, const unsigned char* tpb);
+};
+
+struct IAttachment
+{
+	void* cloopDummy[1];
+	IAttachmentVTable* cloopVTable;
+
+	int release() { return cloopVTable->release(this); }
+	ITransaction* startTransaction(IStatus* status, unsigned tpbLength,
+		const unsigned char* tpb)
+		{ return cloopVTable->startTransaction(this, status, tpbLength, tpb); }
+};
+
+//	ITransaction : IReferenceCounted
+
+struct ITransactionVTable
+{
+	void* cloopDummy[1];
+	uintptr_t version;
+	void (CLOOP_CARG *addRef)(ITransaction* self);
+	int (CLOOP_CARG *release)(ITransaction* self);
+};
+
+struct ITransaction
+{
+	void* cloopDummy[1];
+	ITransactionVTable* cloopVTable;
+
+	int release() { return cloopVTable->release(this); }
+};
+
+//	IMessageMetadata : IReferenceCounted
+
+struct IMessageMetadataVTable
+{
+	void* cloopDummy[1];
+	uintptr_t version;
+	void (CLOOP_CARG *addRef)(IMessageMetadata* self);
+	int (CLOOP_CARG *release)(IMessageMetadata* self);
+	unsigned (CLOOP_CARG *getCount)(IMessageMetadata* self, IStatus* status);
+	Slot getField;
+	Slot getRelation;
+	Slot getOwner;
+	Slot getAlias;
+	unsigned (CLOOP_CARG *getType)(IMessageMetadata* self, IStatus* status, unsigned index);
+	Slot isNullable;
+	Slot getSubType;
+	unsigned (CLOOP_CARG *getLength)(IMessageMetadata* self, IStatus* status, unsigned index);
+	Slot getScale;
+	Slot getCharSet;
+	unsigned (CLOOP_CARG *getOffset)(IMessageMetadata* self, IStatus* status, unsigned index);
+	unsigned (CLOOP_CARG *getNullOffset)(IMessageMetadata* self, IStatus* status, unsigned index);
+	Slot getBuilder;
+	unsigned (CLOOP_CARG *getMessageLength)(IMessageMetadata* self, IStatus* status);
+};
+
+struct IMessageMetadata
+{
+	void* cloopDummy[1];
+	IMessageMetadataVTable* cloopVTable;
+
+	int release() { return cloopVTable->release(this); }
+	unsigned getCount(IStatus* status) { return cloopVTable->getCount(this, status); }
+	unsigned getType(IStatus* status, unsigned index)
+		{ return cloopVTable->getType(this, status, index); }
+	unsigned getLength(IStatus* status, unsigned index)
+		{ return cloopVTable->getLength(this, status, index); }
+	unsigned getOffset(IStatus* status, unsigned index)
+		{ return cloopVTable->getOffset(this, status, index); }
+	unsigned getNullOffset(IStatus* status, unsigned index)
+		{ return cloopVTable->getNullOffset(this, status, index); }
+	unsigned getMessageLength(IStatus* status)
+		{ return cloopVTable->getMessageLength(this, status); }
+};
+
+//	IStatement : IReferenceCounted. Version 4 (Firebird 4) adds the timeouts
+//	and the batches.
+
+struct IStatementVTable
+{
+	void* cloopDummy[1];
+	uintptr_t version;
+	void (CLOOP_CARG *addRef)(IStatement* self);
+	int (CLOOP_CARG *release)(IStatement* self);
+	Slot getInfo;
+	Slot getType;
+	Slot getPlan;
+	Slot getAffectedRecords;
+	IMessageMetadata* (CLOOP_CARG *getInputMetadata)(IStatement* self, IStatus* status);
+	IMessageMetadata* (CLOOP_CARG *getOutputMetadata)(IStatement* self, IStatus* status);
+	ITransaction* (CLOOP_CARG *execute)(IStatement* self, IStatus* status,
+		ITransaction* transaction, IMessageMetadata* inMetadata, void* inBuffer,
+		IMessageMetadata* outMetadata, void* outBuffer);
+	IResultSet* (CLOOP_CARG *openCursor)(IStatement* self, IStatus* status,
+		ITransaction* transaction, IMessageMetadata* inMetadata, void* inBuffer,
+		IMessageMetadata* outMetadata, unsigned flags);
+	Slot setCursorName;
+	Slot free;
+	Slot getFlags;
+	Slot getTimeout;
+	void (CLOOP_CARG *setTimeout)(IStatement* self, IStatus* status, unsigned timeOut);
+	IBatch* (CLOOP_CARG *createBatch)(IStatement* self, IStatus* status,
+		IMessageMetadata* inMetadata, unsigned parLength, const unsigned char* par);
+};
+
+struct IStatement
+{
+	static const unsigned VERSION_FB4 = 4;
+	static const unsigned CURSOR_TYPE_SCROLLABLE = 0x1;
+
+	void* cloopDummy[1];
+	IStatementVTable* cloopVTable;
+
+	int release() { return cloopVTable->release(this); }
+	IMessageMetadata* getInputMetadata(IStatus* status)
+		{ return cloopVTable->getInputMetadata(this, status); }
+	IMessageMetadata* getOutputMetadata(IStatus* status)
+		{ return cloopVTable->getOutputMetadata(this, status); }
+	ITransaction* execute(IStatus* status, ITransaction* transaction,
+		IMessageMetadata* inMetadata, void* inBuffer,
+		IMessageMetadata* outMetadata, void* outBuffer)
+		{ return cloopVTable->execute(this, status, transaction, inMetadata,
+			inBuffer, outMetadata, outBuffer); }
+	IResultSet* openCursor(IStatus* status, ITransaction* transaction,
+		IMessageMetadata* inMetadata, void* inBuffer,
+		IMessageMetadata* outMetadata, unsigned flags)
+		{ return cloopVTable->openCursor(this, status, transaction, inMetadata,
+			inBuffer, outMetadata, flags); }
+	void setTimeout(IStatus* status, unsigned timeOut)
+		{ cloopVTable->setTimeout(this, status, timeOut); }
+	IBatch* createBatch(IStatus* status, IMessageMetadata* inMetadata,
+		unsigned parLength, const unsigned char* par)
+		{ return cloopVTable->createBatch(this, status, inMetadata, parLength, par); }
+};
+
+//	IResultSet : IReferenceCounted. Only the cursors opened with
+//	IStatement::CURSOR_TYPE_SCROLLABLE move other than forward.
+
+struct IResultSetVTable
+{
+	void* cloopDummy[1];
+	uintptr_t version;
+	void (CLOOP_CARG *addRef)(IResultSet* self);
+	int (CLOOP_CARG *release)(IResultSet* self);
+	int (CLOOP_CARG *fetchNext)(IResultSet* self, IStatus* status, void* message);
+	int (CLOOP_CARG *fetchPrior)(IResultSet* self, IStatus* status, void* message);
+	int (CLOOP_CARG *fetchFirst)(IResultSet* self, IStatus* status, void* message);
+	int (CLOOP_CARG *fetchLast)(IResultSet* self, IStatus* status, void* message);
+	int (CLOOP_CARG *fetchAbsolute)(IResultSet* self, IStatus* status, int position,
+		void* message);
+	int (CLOOP_CARG *fetchRelative)(IResultSet* self, IStatus* status, int offset,
+		void* message);
+	Slot isEof;
+	Slot isBof;
+	Slot getMetadata;
+	Slot close;
+	Slot setDelayedOutputFormat;
+};
+
+struct IResultSet
+{
+	void* cloopDummy[1];
+	IResultSetVTable* cloopVTable;
+
+	int release() { return cloopVTable->release(this); }
+	int fetchNext(IStatus* status, void* message)
+		{ return cloopVTable->fetchNext(this, status, message); }
+	int fetchPrior(IStatus* status, void* message)
+		{ return cloopVTable->fetchPrior(this, status, message); }
+	int fetchFirst(IStatus* status, void* message)
+		{ return cloopVTable->fetchFirst(this, status, message); }
+	int fetchLast(IStatus* status, void* message)
+		{ return cloopVTable->fetchLast(this, status, message); }
+	int fetchAbsolute(IStatus* status, int position, void* message)
+		{ return cloopVTable->fetchAbsolute(this, status, position, message); }
+	int fetchRelative(IStatus* status, int offset, void* message)
+		{ return cloopVTable->fetchRelative(this, status, offset, message); }
+};
+
+//	IBatch : IReferenceCounted (Firebird 4). Its parameter block is the
+//	version byte, then items of a tag byte, a 4 bytes little endian length
+//	and the value.
+
+struct IBatchVTable
+{
+	void* cloopDummy[1];
+	uintptr_t version;
+	void (CLOOP_CARG *addRef)(IBatch* self);
+	int (CLOOP_CARG *release)(IBatch* self);
+	void (CLOOP_CARG *add)(IBatch* self, IStatus* status, unsigned count,
+		const void* inBuffer);
+	Slot addBlob;
+	Slot appendBlobData;
+	Slot addBlobStream;
+	Slot registerBlob;
+	IBatchCompletionState* (CLOOP_CARG *execute)(IBatch* self, IStatus* status,
+		ITransaction* transaction);
+	Slot cancel;
+	Slot getBlobAlignment;
+	Slot getMetadata;
+	Slot setDefaultBpb;
+};
+
+struct IBatch
+{
+	static const unsigned char VERSION1 = 1;
+	static const unsigned char TAG_MULTIERROR = 1;
+	static const unsigned char TAG_RECORD_COUNTS = 2;
+
+	void* cloopDummy[1];
+	IBatchVTable* cloopVTable;
+
+	int release() { return cloopVTable->release(this); }
+	void add(IStatus* status, unsigned count, const void* inBuffer)
+		{ cloopVTable->add(this, status, count, inBuffer); }
+	IBatchCompletionState* execute(IStatus* status, ITransaction* transaction)
+		{ return cloopVTable->execute(this, status, transaction); }
+};
+
+//	IBatchCompletionState : IDisposable
+
+struct IBatchCompletionStateVTable
+{
+	void* cloopDummy[1];
+	uintptr_t version;
+	void (CLOOP_CARG *dispose)(IBatchCompletionState* self);
+	unsigned (CLOOP_CARG *getSize)(IBatchCompletionState* self, IStatus* status);
+	int (CLOOP_CARG *getState)(IBatchCompletionState* self, IStatus* status, unsigned pos);
+	unsigned (CLOOP_CARG *findError)(IBatchCompletionState* self, IStatus* status, unsigned pos);
+	void (CLOOP_CARG *getStatus)(IBatchCompletionState* self, IStatus* status,
+		IStatus* to, unsigned pos);
+};
+
+struct IBatchCompletionState
+{
+	static const int EXECUTE_FAILED = -1;
+	static const int SUCCESS_NO_INFO = -2;
+	static const unsigned NO_MORE_ERRORS = 0xffffffff;
+
+	void* cloopDummy[1];
+	IBatchCompletionStateVTable* cloopVTable;
+
+	void dispose() { cloopVTable->dispose(this); }
+	unsigned getSize(IStatus* status) { return cloopVTable->getSize(this, status); }
+	int getState(IStatus* status, unsigned pos)
+		{ return cloopVTable->getState(this, status, pos); }
+	unsigned findError(IStatus* status, unsigned pos)
+		{ return cloopVTable->findError(this, status, pos); }
+	void getStatus(IStatus* status, IStatus* to, unsigned pos)
+		{ cloopVTable->getStatus(this, status, to, pos); }
+};
+
+}	// namespace ibpp_oo
+
+#endif
+
+//
+//	EOF
+//
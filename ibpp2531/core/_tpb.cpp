@@ -82,6 +82,18 @@ void TPB::Insert(const std::string& data)
 	mSize += len;
 }
 
+void TPB::InsertInt64(char type, int64_t data)
+{
+	Grow(1 + 1 + 8);
+	mBuffer[mSize++] = type;
+	mBuffer[mSize++] = (char)8;
+	for (int i = 0; i < 8; i++)		// Little-endian, as isc_vax_integer() reads it
+	{
+		mBuffer[mSize++] = (char)(data & 0xFF);
+		data >>= 8;
+	}
+}
+
 void TPB::Reset()
 {
 	if (mSize != 0)
@@ -0,0 +1,357 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//	File    : $Id$
+//	Subject : IBPP, tracing of the client library calls
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	(C) Copyright 2000-2006 T.I.P. Group S.A. and the IBPP Team (www.ibpp.org)
+//
+//	The contents of this file are subject to the IBPP License (the "License");
+//	you may not use this file except in compliance with the License.  You may
+//	obtain a copy of the License at http://www.ibpp.org or in the 'license.txt'
+//	file which must have been distributed along with this file.
+//
+//	This software, distributed under the License, is distributed on an "AS IS"
+//	basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.  See the
+//	License for the specific language governing rights and limitations
+//	under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	COMMENTS
+//	* Tabulations should be set every four characters when editing this file.
+//	* While tracing, the GDS entry points of the calls listed below point to
+//	  wrappers which time and count the call before returning its status,
+//	  and write it as a Chrome trace event when a trace file is open. The
+//	  real entry points are kept in TraceEntry<>::Real. Not tracing, the
+//	  GDS pointers are the real ones and nothing is added to the calls.
+//	* The OO API backend (_oo.cpp) doesn't go through these entry points.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef _MSC_VER
+#pragma warning(disable: 4786 4996)
+#ifndef _DEBUG
+#pragma warning(disable: 4702)
+#endif
+#endif
+
+#include "_ibpp.h"
+
+#ifdef HAS_HDRSTOP
+#pragma hdrstop
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#ifdef IBPP_UNIX
+#include <unistd.h>
+#endif
+
+using namespace ibpp_internals;
+
+//	The entry points which take a status vector, that is all of them except
+//	the local helpers (isc_vax_integer, isc_sqlcode, isc_*interprete)
+#define IBPP_TRACED_CALLS(X) \
+	X(create_database) X(attach_database) X(detach_database) X(drop_database) \
+	X(database_info) X(dsql_execute_immediate) X(open_blob2) X(create_blob2) \
+	X(close_blob) X(cancel_blob) X(get_segment) X(put_segment) X(blob_info) \
+	X(array_lookup_bounds) X(array_get_slice) X(array_put_slice) \
+	X(que_events) X(cancel_events) X(start_multiple) X(commit_transaction) \
+	X(commit_retaining) X(rollback_transaction) X(rollback_retaining) \
+	X(dsql_allocate_statement) X(dsql_describe) X(dsql_describe_bind) \
+	X(dsql_prepare) X(dsql_execute) X(dsql_execute2) X(dsql_fetch) \
+	X(dsql_free_statement) X(dsql_set_cursor_name) X(dsql_sql_info) \
+	X(service_attach) X(service_detach) X(service_start) X(service_query)
+
+namespace
+{
+#define IBPP_TRACE_ID(X) tc_##X,
+	enum TracedCall { IBPP_TRACED_CALLS(IBPP_TRACE_ID) tcCount };
+#undef IBPP_TRACE_ID
+
+#define IBPP_TRACE_NAME(X) "isc_"#X,
+	const char* const TraceNames[tcCount] = { IBPP_TRACED_CALLS(IBPP_TRACE_NAME) };
+#undef IBPP_TRACE_NAME
+
+	struct TraceCounter
+	{
+		volatile int64_t Calls;
+		volatile int64_t Errors;
+		volatile int64_t Nanoseconds;
+	};
+
+	TraceCounter TraceCounters[tcCount];
+
+	// The Chrome trace file, while spans are written
+	Mutex TraceFileLock;
+	FILE* TraceFile = 0;
+	bool TraceFirstEvent = true;
+	int64_t TraceOrigin = 0;
+	AtomicInt TraceSpans;
+
+	int64_t TraceAdd(volatile int64_t* value, int64_t delta)
+	{
+#ifdef IBPP_WINDOWS
+		return InterlockedExchangeAdd64((volatile LONGLONG*)value, delta) + delta;
+#else
+		return __sync_add_and_fetch(value, delta);
+#endif
+	}
+
+	// Monotonic time in nanoseconds
+	int64_t TraceNow()
+	{
+#ifdef IBPP_WINDOWS
+		static LARGE_INTEGER frequency = { { 0, 0 } };
+		if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+		LARGE_INTEGER counter;
+		QueryPerformanceCounter(&counter);
+		return (int64_t)(counter.QuadPart / (double)frequency.QuadPart * 1e9);
+#else
+		timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+	}
+
+	void TraceEvent(int id, int64_t start, int64_t end)
+	{
+#ifdef IBPP_WINDOWS
+		unsigned long pid = GetCurrentProcessId();
+		unsigned long tid = GetCurrentThreadId();
+#else
+		unsigned long pid = (unsigned long)getpid();
+		unsigned long tid = (unsigned long)pthread_self();
+#endif
+		MutexLocker guard(TraceFileLock);
+		if (TraceFile == 0) return;
+		fprintf(TraceFile, "%s{\"name\":\"%s\",\"cat\":\"gds\",\"ph\":\"X\",\"ts\":%.3f,"
+			"\"dur\":%.3f,\"pid\":%lu,\"tid\":%lu}", TraceFirstEvent ? "" : ",\n",
+			TraceNames[id], (start - TraceOrigin) / 1000.0, (end - start) / 1000.0, pid, tid);
+		TraceFirstEvent = false;
+	}
+
+	ISC_STATUS TraceEnd(int id, int64_t start, ISC_STATUS status)
+	{
+		int64_t end = TraceNow();
+		TraceCounter& c = TraceCounters[id];
+		TraceAdd(&c.Calls, 1);
+		TraceAdd(&c.Nanoseconds, end - start);
+		// 100 is the end of the rows of isc_dsql_fetch, not an error
+		if (status != 0 && ! (id == tc_dsql_fetch && status == 100))
+			TraceAdd(&c.Errors, 1);
+		if (TraceSpans.Get() != 0) TraceEvent(id, start, end);
+		return status;
+	}
+
+	// Ends the file as a JSON array, which Chrome and Perfetto also read
+	// when the program stopped before (without the closing bracket)
+	void TraceCloseFile()
+	{
+		MutexLocker guard(TraceFileLock);
+		TraceSpans.Set(0);
+		if (TraceFile == 0) return;
+		fputs("\n]\n", TraceFile);
+		fclose(TraceFile);
+		TraceFile = 0;
+	}
+
+	bool TraceOpenFile(const char* name)
+	{
+		TraceCloseFile();
+		MutexLocker guard(TraceFileLock);
+		TraceFile = fopen(name, "w");
+		if (TraceFile == 0) return false;
+		fputs("[\n", TraceFile);
+		TraceFirstEvent = true;
+		TraceOrigin = TraceNow();
+		TraceSpans.Set(1);
+		return true;
+	}
+
+	bool TraceByCost(const IBPP::TraceCount& a, const IBPP::TraceCount& b)
+	{
+		return a.Nanoseconds > b.Nanoseconds;
+	}
+
+	// IBPP_TRACE set: the counts are printed when the program ends
+	void TraceReportAtExit()
+	{
+		std::vector<IBPP::TraceCount> counts;
+		IBPP::TraceCounts(counts);
+		fprintf(stderr, "IBPP client calls                calls   errors     total ms    mean us\n");
+		for (size_t i = 0; i < counts.size(); i++)
+			fprintf(stderr, "%-28s %9lld %8lld %12.3f %10.3f\n", counts[i].Name.c_str(),
+				(long long)counts[i].Calls, (long long)counts[i].Errors,
+				counts[i].Nanoseconds / 1e6, counts[i].Nanoseconds / 1e3 / counts[i].Calls);
+		TraceCloseFile();
+	}
+
+	//	The wrappers, one per number of parameters. Id gives the counters and
+	//	the real entry point of the call.
+
+	template <int Id, class P> struct TraceEntry
+	{
+		static P* Real;
+	};
+	template <int Id, class P> P* TraceEntry<Id, P>::Real = 0;
+
+	template <int Id, class P> struct Tracer;
+
+#define IBPP_TRACED_BODY(TYPES, ARGS) \
+	{ \
+		int64_t start = TraceNow(); \
+		return TraceEnd(Id, start, (*TraceEntry<Id, ISC_STATUS ISC_EXPORT TYPES>::Real) ARGS); \
+	}
+
+	template <int Id, class A1, class A2>
+	struct Tracer<Id, ISC_STATUS ISC_EXPORT (A1, A2)>
+	{
+		static ISC_STATUS ISC_EXPORT Call(A1 a1, A2 a2)
+			IBPP_TRACED_BODY((A1, A2), (a1, a2))
+	};
+
+	template <int Id, class A1, class A2, class A3>
+	struct Tracer<Id, ISC_STATUS ISC_EXPORT (A1, A2, A3)>
+	{
+		static ISC_STATUS ISC_EXPORT Call(A1 a1, A2 a2, A3 a3)
+			IBPP_TRACED_BODY((A1, A2, A3), (a1, a2, a3))
+	};
+
+	template <int Id, class A1, class A2, class A3, class A4>
+	struct Tracer<Id, ISC_STATUS ISC_EXPORT (A1, A2, A3, A4)>
+	{
+		static ISC_STATUS ISC_EXPORT Call(A1 a1, A2 a2, A3 a3, A4 a4)
+			IBPP_TRACED_BODY((A1, A2, A3, A4), (a1, a2, a3, a4))
+	};
+
+	template <int Id, class A1, class A2, class A3, class A4, class A5>
+	struct Tracer<Id, ISC_STATUS ISC_EXPORT (A1, A2, A3, A4, A5)>
+	{
+		static ISC_STATUS ISC_EXPORT Call(A1 a1, A2 a2, A3 a3, A4 a4, A5 a5)
+			IBPP_TRACED_BODY((A1, A2, A3, A4, A5), (a1, a2, a3, a4, a5))
+	};
+
+	template <int Id, class A1, class A2, class A3, class A4, class A5, class A6>
+	struct Tracer<Id, ISC_STATUS ISC_EXPORT (A1, A2, A3, A4, A5, A6)>
+	{
+		static ISC_STATUS ISC_EXPORT Call(A1 a1, A2 a2, A3 a3, A4 a4, A5 a5, A6 a6)
+			IBPP_TRACED_BODY((A1, A2, A3, A4, A5, A6), (a1, a2, a3, a4, a5, a6))
+	};
+
+	template <int Id, class A1, class A2, class A3, class A4, class A5, class A6, class A7>
+	struct Tracer<Id, ISC_STATUS ISC_EXPORT (A1, A2, A3, A4, A5, A6, A7)>
+	{
+		static ISC_STATUS ISC_EXPORT Call(A1 a1, A2 a2, A3 a3, A4 a4, A5 a5, A6 a6, A7 a7)
+			IBPP_TRACED_BODY((A1, A2, A3, A4, A5, A6, A7), (a1, a2, a3, a4, a5, a6, a7))
+	};
+
+	template <int Id, class A1, class A2, class A3, class A4, class A5, class A6, class A7,
+		class A8, class A9>
+	struct Tracer<Id, ISC_STATUS ISC_EXPORT (A1, A2, A3, A4, A5, A6, A7, A8, A9)>
+	{
+		static ISC_STATUS ISC_EXPORT Call(A1 a1, A2 a2, A3 a3, A4 a4, A5 a5, A6 a6, A7 a7,
+				A8 a8, A9 a9)
+			IBPP_TRACED_BODY((A1, A2, A3, A4, A5, A6, A7, A8, A9),
+				(a1, a2, a3, a4, a5, a6, a7, a8, a9))
+	};
+
+#undef IBPP_TRACED_BODY
+}
+
+//	Swaps the entry points, mLock held. A thread calling meanwhile reads
+//	either the real entry point or its wrapper, both of them work.
+void GDS::Trace(bool enable, const char* file)
+{
+	if (enable && file != 0 && *file != 0)
+	{
+		if (! TraceOpenFile(file))
+			throw LogicExceptionImpl("IBPP::TraceCalls", _("Unable to create the trace file"));
+	}
+	else TraceCloseFile();
+
+	if (enable == mTracing) return;
+
+#define IBPP_TRACE_SWAP(X) \
+	if (enable) \
+	{ \
+		TraceEntry<tc_##X, proto_##X>::Real = m_##X; \
+		m_##X = &Tracer<tc_##X, proto_##X>::Call; \
+	} \
+	else m_##X = TraceEntry<tc_##X, proto_##X>::Real;
+
+	IBPP_TRACED_CALLS(IBPP_TRACE_SWAP)
+#undef IBPP_TRACE_SWAP
+
+	mTracing = enable;
+}
+
+//	IBPP_TRACE=1 traces the calls from the loading of the client library,
+//	IBPP_TRACE=<file> also writes them to the file; the counts are printed
+//	on stderr at exit. Called by GDS::Call(), mLock held.
+void GDS::TraceFromEnvironment()
+{
+	const char* env = getenv("IBPP_TRACE");
+	if (env == 0 || *env == 0 || strcmp(env, "0") == 0) return;
+
+	try { Trace(true, strcmp(env, "1") == 0 ? 0 : env); }
+	catch (LogicExceptionImpl&)
+	{
+		fprintf(stderr, "IBPP: unable to create the trace file %s\n", env);
+		Trace(true, 0);
+	}
+	atexit(TraceReportAtExit);
+}
+
+namespace IBPP
+{
+	void TraceCalls(bool enable, const char* chromeTraceFile)
+	{
+		GDS* g = gds.Call();
+		MutexLocker guard(g->mLock);
+		g->Trace(enable, chromeTraceFile);
+	}
+
+	bool TracingCalls()
+	{
+		GDS* g = gds.Call();
+		MutexLocker guard(g->mLock);
+		return g->mTracing;
+	}
+
+	void TraceCounts(std::vector<TraceCount>& counts)
+	{
+		counts.clear();
+		for (int i = 0; i < tcCount; i++)
+		{
+			TraceCounter& c = TraceCounters[i];
+			TraceCount count;
+			count.Name = TraceNames[i];
+			count.Calls = TraceAdd(&c.Calls, 0);
+			count.Errors = TraceAdd(&c.Errors, 0);
+			count.Nanoseconds = TraceAdd(&c.Nanoseconds, 0);
+			if (count.Calls != 0) counts.push_back(count);
+		}
+		std::sort(counts.begin(), counts.end(), TraceByCost);
+	}
+
+	void ResetTraceCounts()
+	{
+		for (int i = 0; i < tcCount; i++)
+		{
+			TraceCounter& c = TraceCounters[i];
+			TraceAdd(&c.Calls, -TraceAdd(&c.Calls, 0));
+			TraceAdd(&c.Errors, -TraceAdd(&c.Errors, 0));
+			TraceAdd(&c.Nanoseconds, -TraceAdd(&c.Nanoseconds, 0));
+		}
+	}
+}
+
+//
+//	EOF
+//
@@ -35,9 +35,11 @@
 #include "_ibpp.cpp"
 #include "_dpb.cpp"
 #include "_ibs.cpp"
+#include "_oo.cpp"
 #include "_rb.cpp"
 #include "_spb.cpp"
 #include "_tpb.cpp"
+#include "_trace.cpp"
 
 #include "array.cpp"
 #include "blob.cpp"
@@ -51,6 +53,7 @@
 #include "statement.cpp"
 #include "time.cpp"
 #include "transaction.cpp"
+#include "types.cpp"
 #include "user.cpp"
 
 // Eof
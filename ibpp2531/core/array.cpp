@@ -41,6 +41,105 @@
 
 using namespace ibpp_internals;
 
+#if defined(__GNUC__) && !defined(__clang__) && !defined(__INTEL_COMPILER) \
+	&& (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define IBPP_VECTORIZE __attribute__((optimize("tree-vectorize", "vect-cost-model=dynamic")))
+#else
+#define IBPP_VECTORIZE
+#endif
+
+namespace
+{
+	//	Element conversion kernels of ArrayImpl::ReadTo() and WriteFrom().
+	//	The numeric elements of a slice buffer are packed (array_desc_length
+	//	is the size of the C type), so each conversion is one loop over two
+	//	plain arrays, with no branch: range checks of the narrowing
+	//	conversions are a min/max reduction made before.
+	//	GCC only vectorizes such loops from -O3: at -O2 its cost model rejects
+	//	the runtime check of src and dst overlapping and the scalar epilogue.
+	//	IBPP_VECTORIZE asks for them on the kernels alone (see -fopt-info-vec,
+	//	and the array conversions of tests/rowbench). Clang and MSVC vectorize
+	//	them at -O2 already. The rounding kernels (ArrayToScaled, ArrayRound)
+	//	stay scalar for the usual targets: a vector floor() needs SSE4.1 on
+	//	x86 and, with GCC, -fno-trapping-math.
+
+	template<class S, class D>
+	IBPP_VECTORIZE void ArrayConvert(const char* src, char* dst, int count)
+	{
+		const S* s = (const S*)src;
+		D* d = (D*)dst;
+		for (int i = 0; i < count; i++) d[i] = D(s[i]);
+	}
+
+	template<class S>
+	IBPP_VECTORIZE void ArrayToBool(const char* src, char* dst, int count)
+	{
+		const S* s = (const S*)src;
+		bool* d = (bool*)dst;
+		for (int i = 0; i < count; i++) d[i] = s[i] != 0;
+	}
+
+	template<class D>
+	IBPP_VECTORIZE void ArrayFromBool(const char* src, char* dst, int count)
+	{
+		const unsigned char* s = (const unsigned char*)src;	// A bool is 0 or 1
+		D* d = (D*)dst;
+		for (int i = 0; i < count; i++) d[i] = D(s[i]);
+	}
+
+	template<class S>
+	IBPP_VECTORIZE bool ArrayInRange(const char* src, int count, int64_t low, int64_t high)
+	{
+		if (count <= 0) return true;
+		const S* s = (const S*)src;
+		S mn = s[0], mx = s[0];
+		for (int i = 1; i < count; i++)
+		{
+			mn = s[i] < mn ? s[i] : mn;
+			mx = s[i] > mx ? s[i] : mx;
+		}
+		return int64_t(mn) >= low && int64_t(mx) <= high;
+	}
+
+	// NUMERIC(x,y) elements to float or double
+	template<class S, class D>
+	IBPP_VECTORIZE void ArrayFromScaled(const char* src, char* dst, int count, int scale)
+	{
+		if (scale == 0) { ArrayConvert<S, D>(src, dst, count); return; }
+		const double divisor = consts::dscales[-scale];
+		const S* s = (const S*)src;
+		D* d = (D*)dst;
+		for (int i = 0; i < count; i++) d[i] = D(s[i] / divisor);
+	}
+
+	// Float or double to NUMERIC(x,y) elements, rounded
+	template<class S, class D>
+	IBPP_VECTORIZE void ArrayToScaled(const char* src, char* dst, int count, int scale)
+	{
+		const double multiplier = consts::dscales[-scale];
+		const S* s = (const S*)src;
+		D* d = (D*)dst;
+		for (int i = 0; i < count; i++) d[i] = D(floor(s[i] * multiplier + 0.5));
+	}
+
+	// Doubles rounded to the scale of a NUMERIC(x,y) stored as double
+	IBPP_VECTORIZE void ArrayRound(const char* src, char* dst, int count, double multiplier)
+	{
+		const double* s = (const double*)src;
+		double* d = (double*)dst;
+		for (int i = 0; i < count; i++) d[i] = floor(s[i] * multiplier + 0.5) / multiplier;
+	}
+
+	// Bytes of an element in the slice buffer
+	int ArrayElementSize(const ISC_ARRAY_DESC& desc)
+	{
+		int size = desc.array_desc_length;
+		if (desc.array_desc_dtype == blr_varying) size += 2;
+		else if (desc.array_desc_dtype == blr_cstring) size += 1;
+		return size;
+	}
+}
+
 //	(((((((( OBJECT INTERFACE IMPLEMENTATION ))))))))
 
 void ArrayImpl::Describe(const std::string& table, const std::string& column)
@@ -54,13 +153,22 @@ void ArrayImpl::Describe(const std::string& table, const std::string& column)
 
 	ResetId();	// Re-use this array object if was previously assigned
 
-	IBS status;
-	(*gds.Call()->m_array_lookup_bounds)(status.Self(), mDatabase->GetHandlePtr(),
-		mTransaction->GetHandlePtr(), const_cast<char*>(table.c_str()),
-			const_cast<char*>(column.c_str()), &mDesc);
-	if (status.Errors())
-		throw SQLExceptionImpl(status, "Array::Lookup",
-			_("isc_array_lookup_bounds failed."));
+	// The descriptor of a column is looked up once per transaction
+	std::string key(table);
+	key.append(1, '.').append(column);
+	const ISC_ARRAY_DESC* desc = mTransaction->FindArrayDesc(mDatabase, key);
+	if (desc != 0) mDesc = *desc;
+	else
+	{
+		IBS status;
+		(*gds.Call()->m_array_lookup_bounds)(status.Self(), mDatabase->GetHandlePtr(),
+			mTransaction->GetHandlePtr(), const_cast<char*>(table.c_str()),
+				const_cast<char*>(column.c_str()), &mDesc);
+		if (status.Errors())
+			throw SQLExceptionImpl(status, "Array::Lookup",
+				_("isc_array_lookup_bounds failed."));
+		mTransaction->KeepArrayDesc(mDatabase, key, mDesc);
+	}
 
 	AllocArrayBuffer();
 
@@ -212,32 +320,66 @@ void ArrayImpl::ReadTo(IBPP::ADT adtype, void* data, int datacount)
 	if (lenbuf != mBufferSize)
 		throw SQLExceptionImpl(status, "Array::ReadTo", _("Internal buffer size discrepancy."));
 
+	decodeArraySlice(mDesc, (const char*)mBuffer, adtype, data, mElemCount);
+}
+
+void ArrayImpl::WriteFrom(IBPP::ADT adtype, const void* data, int datacount)
+{
+	if (! mDescribed)
+		throw LogicExceptionImpl("Array::WriteFrom", _("Array description not set."));
+	if (mDatabase == 0)
+		throw LogicExceptionImpl("Array::WriteFrom", _("No Database is attached."));
+	if (mTransaction == 0)
+		throw LogicExceptionImpl("Array::WriteFrom", _("No Transaction is attached."));
+	if (datacount != mElemCount)
+		throw LogicExceptionImpl("Array::ReadTo", _("Wrong count of array elements"));
+
+	encodeArraySlice(mDesc, adtype, data, (char*)mBuffer, mElemCount);
+
+	IBS status;
+	ISC_LONG lenbuf = mBufferSize;
+	(*gds.Call()->m_array_put_slice)(status.Self(), mDatabase->GetHandlePtr(),
+		mTransaction->GetHandlePtr(), &mId, &mDesc, mBuffer, &lenbuf);
+	if (status.Errors())
+		throw SQLExceptionImpl(status, "Array::WriteFrom", _("isc_array_put_slice failed."));
+	if (lenbuf != mBufferSize)
+		throw SQLExceptionImpl(status, "Array::WriteFrom", _("Internal buffer size discrepancy."));
+}
+
+//	Conversions between a slice buffer of count elements described by desc
+//	and the user array of ReadTo() / WriteFrom()
+
+void ibpp_internals::decodeArraySlice(const ISC_ARRAY_DESC& desc, const char* slice,
+	IBPP::ADT adtype, void* data, int count)
+{
 	// Now, convert the types and copy values to the user array...
 	int len;
-	char* src = (char*)mBuffer;
+	const int elemSize = ArrayElementSize(desc);
+	const size_t bytes = size_t(count) * elemSize;
+	char* src = const_cast<char*>(slice);
 	char* dst = (char*)data;
 
-	switch (mDesc.array_desc_dtype)
+	switch (desc.array_desc_dtype)
 	{
 		case blr_text :
 			if (adtype == IBPP::adString)
 			{
-				for (int i = 0; i < mElemCount; i++)
+				for (int i = 0; i < count; i++)
 				{
-					strncpy(dst, src, mElemSize);
-					dst[mElemSize] = '\0';
-					src += mElemSize;
-					dst += (mElemSize + 1);
+					strncpy(dst, src, elemSize);
+					dst[elemSize] = '\0';
+					src += elemSize;
+					dst += (elemSize + 1);
 				}
 			}
 			else if (adtype == IBPP::adBool)
 			{
-				for (int i = 0; i < mElemCount; i++)
+				for (int i = 0; i < count; i++)
 				{
 					if (*src == 't' || *src == 'T' || *src == 'y' || *src == 'Y' ||	*src == '1')
 						*(bool*)dst = true;
 					else *(bool*)dst = false;
-					src += mElemSize;
+					src += elemSize;
 					dst += sizeof(bool);
 				}
 			}
@@ -247,24 +389,24 @@ void ArrayImpl::ReadTo(IBPP::ADT adtype, void* data, int datacount)
 		case blr_varying :
 			if (adtype == IBPP::adString)
 			{
-				for (int i = 0; i < mElemCount; i++)
+				for (int i = 0; i < count; i++)
 				{
 					len = (int)strlen(src);
-					if (len > mElemSize-2) len = mElemSize-2;
+					if (len > elemSize-2) len = elemSize-2;
 					strncpy(dst, src, len);
 					dst[len] = '\0';
-					src += mElemSize;
-					dst += (mElemSize - 2 + 1);
+					src += elemSize;
+					dst += (elemSize - 2 + 1);
 				}
 			}
 			else if (adtype == IBPP::adBool)
 			{
-				for (int i = 0; i < mElemCount; i++)
+				for (int i = 0; i < count; i++)
 				{
 					if (*src == 't' || *src == 'T' || *src == 'y' || *src == 'Y' ||	*src == '1')
 						*(bool*)dst = true;
 					else *(bool*)dst = false;
-					src += mElemSize;
+					src += elemSize;
 					dst += sizeof(bool);
 				}
 			}
@@ -272,243 +414,84 @@ void ArrayImpl::ReadTo(IBPP::ADT adtype, void* data, int datacount)
 			break;
 
 		case blr_short :
-			if (adtype == IBPP::adBool)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(bool*)dst = (*(short*)src != 0) ? true : false;
-					src += mElemSize;
-					dst += sizeof(bool);
-				}
-			}
-			else if (adtype == IBPP::adInt16)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(short*)dst = *(short*)src;
-					src += mElemSize;
-					dst += sizeof(short);
-				}
-			}
-			else if (adtype == IBPP::adInt32)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(int*)dst = (int)*(short*)src;
-					src += mElemSize;
-					dst += sizeof(int);
-				}
-			}
-			else if (adtype == IBPP::adInt64)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(int64_t*)dst = (int64_t)*(short*)src;
-					src += mElemSize;
-					dst += sizeof(int64_t);
-				}
-			}
+			if (adtype == IBPP::adBool) ArrayToBool<int16_t>(src, dst, count);
+			else if (adtype == IBPP::adInt16) memcpy(dst, src, bytes);
+			else if (adtype == IBPP::adInt32) ArrayConvert<int16_t, int32_t>(src, dst, count);
+			else if (adtype == IBPP::adInt64) ArrayConvert<int16_t, int64_t>(src, dst, count);
+			// This SQL_SHORT may be a NUMERIC(x,y), scale it !
 			else if (adtype == IBPP::adFloat)
-			{
-				// This SQL_SHORT is a NUMERIC(x,y), scale it !
-				double divisor = consts::dscales[-mDesc.array_desc_scale];
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(float*)dst = (float)(*(short*)src / divisor);
-					src += mElemSize;
-					dst += sizeof(float);
-				}
-			}
+				ArrayFromScaled<int16_t, float>(src, dst, count, desc.array_desc_scale);
 			else if (adtype == IBPP::adDouble)
-			{
-				// This SQL_SHORT is a NUMERIC(x,y), scale it !
-				double divisor = consts::dscales[-mDesc.array_desc_scale];
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(double*)dst = (double)(*(short*)src / divisor);
-					src += mElemSize;
-					dst += sizeof(double);
-				}
-			}
+				ArrayFromScaled<int16_t, double>(src, dst, count, desc.array_desc_scale);
 			else throw LogicExceptionImpl("Array::ReadTo", _("Incompatible types."));
 			break;
 
 		case blr_long :
-			if (adtype == IBPP::adBool)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(bool*)dst = (*(long*)src != 0) ? true : false;
-					src += mElemSize;
-					dst += sizeof(bool);
-				}
-			}
+			if (adtype == IBPP::adBool) ArrayToBool<int32_t>(src, dst, count);
 			else if (adtype == IBPP::adInt16)
 			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					if (*(long*)src < consts::min16 || *(long*)src > consts::max16)
-						throw LogicExceptionImpl("Array::ReadTo",
-							_("Out of range numeric conversion !"));
-					*(short*)dst = short(*(long*)src);
-					src += mElemSize;
-					dst += sizeof(short);
-				}
-			}
-			else if (adtype == IBPP::adInt32)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(long*)dst = *(long*)src;
-					src += mElemSize;
-					dst += sizeof(long);
-				}
-			}
-			else if (adtype == IBPP::adInt64)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(int64_t*)dst = (int64_t)*(long*)src;
-					src += mElemSize;
-					dst += sizeof(int64_t);
-				}
+				if (! ArrayInRange<int32_t>(src, count, consts::min16, consts::max16))
+					throw LogicExceptionImpl("Array::ReadTo",
+						_("Out of range numeric conversion !"));
+				ArrayConvert<int32_t, int16_t>(src, dst, count);
 			}
+			else if (adtype == IBPP::adInt32) memcpy(dst, src, bytes);
+			else if (adtype == IBPP::adInt64) ArrayConvert<int32_t, int64_t>(src, dst, count);
+			// This SQL_LONG may be a NUMERIC(x,y), scale it !
 			else if (adtype == IBPP::adFloat)
-			{
-				// This SQL_SHORT is a NUMERIC(x,y), scale it !
-				double divisor = consts::dscales[-mDesc.array_desc_scale];
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(float*)dst = (float)(*(long*)src / divisor);
-					src += mElemSize;
-					dst += sizeof(float);
-				}
-			}
+				ArrayFromScaled<int32_t, float>(src, dst, count, desc.array_desc_scale);
 			else if (adtype == IBPP::adDouble)
-			{
-				// This SQL_SHORT is a NUMERIC(x,y), scale it !
-				double divisor = consts::dscales[-mDesc.array_desc_scale];
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(double*)dst = (double)(*(long*)src / divisor);
-					src += mElemSize;
-					dst += sizeof(double);
-				}
-			}
+				ArrayFromScaled<int32_t, double>(src, dst, count, desc.array_desc_scale);
 			else throw LogicExceptionImpl("Array::ReadTo", _("Incompatible types."));
 			break;
 
 		case blr_int64 :
-			if (adtype == IBPP::adBool)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(bool*)dst = (*(int64_t*)src != 0) ? true : false;
-					src += mElemSize;
-					dst += sizeof(bool);
-				}
-			}
+			if (adtype == IBPP::adBool) ArrayToBool<int64_t>(src, dst, count);
 			else if (adtype == IBPP::adInt16)
 			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					if (*(int64_t*)src < consts::min16 || *(int64_t*)src > consts::max16)
-						throw LogicExceptionImpl("Array::ReadTo",
-							_("Out of range numeric conversion !"));
-					*(short*)dst = short(*(int64_t*)src);
-					src += mElemSize;
-					dst += sizeof(short);
-				}
+				if (! ArrayInRange<int64_t>(src, count, consts::min16, consts::max16))
+					throw LogicExceptionImpl("Array::ReadTo",
+						_("Out of range numeric conversion !"));
+				ArrayConvert<int64_t, int16_t>(src, dst, count);
 			}
 			else if (adtype == IBPP::adInt32)
 			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					if (*(int64_t*)src < consts::min32 || *(int64_t*)src > consts::max32)
-						throw LogicExceptionImpl("Array::ReadTo",
-							_("Out of range numeric conversion !"));
-					*(long*)dst = (long)*(int64_t*)src;
-					src += mElemSize;
-					dst += sizeof(long);
-				}
-			}
-			else if (adtype == IBPP::adInt64)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(int64_t*)dst = *(int64_t*)src;
-					src += mElemSize;
-					dst += sizeof(int64_t);
-				}
+				if (! ArrayInRange<int64_t>(src, count, consts::min32, consts::max32))
+					throw LogicExceptionImpl("Array::ReadTo",
+						_("Out of range numeric conversion !"));
+				ArrayConvert<int64_t, int32_t>(src, dst, count);
 			}
+			else if (adtype == IBPP::adInt64) memcpy(dst, src, bytes);
+			// This SQL_INT64 may be a NUMERIC(x,y), scale it !
 			else if (adtype == IBPP::adFloat)
-			{
-				// This SQL_SHORT is a NUMERIC(x,y), scale it !
-				double divisor = consts::dscales[-mDesc.array_desc_scale];
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(float*)dst = (float)(*(int64_t*)src / divisor);
-					src += mElemSize;
-					dst += sizeof(float);
-				}
-			}
+				ArrayFromScaled<int64_t, float>(src, dst, count, desc.array_desc_scale);
 			else if (adtype == IBPP::adDouble)
-			{
-				// This SQL_SHORT is a NUMERIC(x,y), scale it !
-				double divisor = consts::dscales[-mDesc.array_desc_scale];
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(double*)dst = (double)(*(int64_t*)src / divisor);
-					src += mElemSize;
-					dst += sizeof(double);
-				}
-			}
+				ArrayFromScaled<int64_t, double>(src, dst, count, desc.array_desc_scale);
 			else throw LogicExceptionImpl("Array::ReadTo", _("Incompatible types."));
 			break;
 
 		case blr_float :
-			if (adtype != IBPP::adFloat || mDesc.array_desc_scale != 0)
+			if (desc.array_desc_scale != 0)
 				throw LogicExceptionImpl("Array::ReadTo", _("Incompatible types."));
-			for (int i = 0; i < mElemCount; i++)
-			{
-				*(float*)dst = *(float*)src;
-				src += mElemSize;
-				dst += sizeof(float);
-			}
+			if (adtype == IBPP::adFloat) memcpy(dst, src, bytes);
+			else if (adtype == IBPP::adDouble) ArrayConvert<float, double>(src, dst, count);
+			else throw LogicExceptionImpl("Array::ReadTo", _("Incompatible types."));
 			break;
 
 		case blr_double :
 			if (adtype != IBPP::adDouble) throw LogicExceptionImpl("Array::ReadTo",
 										_("Incompatible types."));
-			if (mDesc.array_desc_scale != 0)
-			{
-				// Round to scale of NUMERIC(x,y)
-				double divisor = consts::dscales[-mDesc.array_desc_scale];
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(double*)dst =	(double)(*(double*)src / divisor);
-					src += mElemSize;
-					dst += sizeof(double);
-				}
-			}
-			else
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(double*)dst = *(double*)src;
-					src += mElemSize;
-					dst += sizeof(double);
-				}
-			}
+			// Round to scale of NUMERIC(x,y)
+			ArrayFromScaled<double, double>(src, dst, count, desc.array_desc_scale);
 			break;
 
 		case blr_timestamp :
 			if (adtype != IBPP::adTimestamp) throw LogicExceptionImpl("Array::ReadTo",
 												_("Incompatible types."));
-			for (int i = 0; i < mElemCount; i++)
+			for (int i = 0; i < count; i++)
 			{
 				decodeTimestamp(*(IBPP::Timestamp*)dst, *(ISC_TIMESTAMP*)src);
-				src += mElemSize;
+				src += elemSize;
 				dst += sizeof(IBPP::Timestamp);
 			}
 			break;
@@ -516,10 +499,10 @@ void ArrayImpl::ReadTo(IBPP::ADT adtype, void* data, int datacount)
 		case blr_sql_date :
 			if (adtype != IBPP::adDate) throw LogicExceptionImpl("Array::ReadTo",
 												_("Incompatible types."));
-			for (int i = 0; i < mElemCount; i++)
+			for (int i = 0; i < count; i++)
 			{
 				decodeDate(*(IBPP::Date*)dst, *(ISC_DATE*)src);
-				src += mElemSize;
+				src += elemSize;
 				dst += sizeof(IBPP::Date);
 			}
 			break;
@@ -527,10 +510,10 @@ void ArrayImpl::ReadTo(IBPP::ADT adtype, void* data, int datacount)
 		case blr_sql_time :
 			if (adtype != IBPP::adTime) throw LogicExceptionImpl("Array::ReadTo",
 												_("Incompatible types."));
-			for (int i = 0; i < mElemCount; i++)
+			for (int i = 0; i < count; i++)
 			{
 				decodeTime(*(IBPP::Time*)dst, *(ISC_TIME*)src);
-				src += mElemSize;
+				src += elemSize;
 				dst += sizeof(IBPP::Time);
 			}
 			break;
@@ -540,46 +523,40 @@ void ArrayImpl::ReadTo(IBPP::ADT adtype, void* data, int datacount)
 	}
 }
 
-void ArrayImpl::WriteFrom(IBPP::ADT adtype, const void* data, int datacount)
+void ibpp_internals::encodeArraySlice(const ISC_ARRAY_DESC& desc, IBPP::ADT adtype,
+	const void* data, char* slice, int count)
 {
-	if (! mDescribed)
-		throw LogicExceptionImpl("Array::WriteFrom", _("Array description not set."));
-	if (mDatabase == 0)
-		throw LogicExceptionImpl("Array::WriteFrom", _("No Database is attached."));
-	if (mTransaction == 0)
-		throw LogicExceptionImpl("Array::WriteFrom", _("No Transaction is attached."));
-	if (datacount != mElemCount)
-		throw LogicExceptionImpl("Array::ReadTo", _("Wrong count of array elements"));
-
-	// Read user data and convert types to the mBuffer
+	// Read user data and convert types to the slice
 	int len;
+	const int elemSize = ArrayElementSize(desc);
+	const size_t bytes = size_t(count) * elemSize;
 	char* src = (char*)data;
-	char* dst = (char*)mBuffer;
+	char* dst = slice;
 
-	switch (mDesc.array_desc_dtype)
+	switch (desc.array_desc_dtype)
 	{
 		case blr_text :
 			if (adtype == IBPP::adString)
 			{
-				for (int i = 0; i < mElemCount; i++)
+				for (int i = 0; i < count; i++)
 				{
 					len = (int)strlen(src);
-					if (len > mElemSize) len = mElemSize;
+					if (len > elemSize) len = elemSize;
 					strncpy(dst, src, len);
-					while (len < mElemSize) dst[len++] = ' ';
-					src += (mElemSize + 1);
-					dst += mElemSize;
+					while (len < elemSize) dst[len++] = ' ';
+					src += (elemSize + 1);
+					dst += elemSize;
 				}
 			}
 			else if (adtype == IBPP::adBool)
 			{
-				for (int i = 0; i < mElemCount; i++)
+				for (int i = 0; i < count; i++)
 				{
 					*dst = *(bool*)src ? 'T' : 'F';
 					len = 1;
-					while (len < mElemSize) dst[len++] = ' ';
+					while (len < elemSize) dst[len++] = ' ';
 					src += sizeof(bool);
-					dst += mElemSize;
+					dst += elemSize;
 				}
 			}
 			else throw LogicExceptionImpl("Array::WriteFrom", _("Incompatible types."));
@@ -588,314 +565,143 @@ void ArrayImpl::WriteFrom(IBPP::ADT adtype, const void* data, int datacount)
 		case blr_varying :
 			if (adtype == IBPP::adString)
 			{
-				for (int i = 0; i < mElemCount; i++)
+				for (int i = 0; i < count; i++)
 				{
 					len = (int)strlen(src);
-					if (len > mElemSize-2) len = mElemSize-2;
+					if (len > elemSize-2) len = elemSize-2;
 					strncpy(dst, src, len);
 					dst[len] = '\0';
-					src += (mElemSize - 2 + 1);
-					dst += mElemSize;
+					src += (elemSize - 2 + 1);
+					dst += elemSize;
 				}
 			}
 			else if (adtype == IBPP::adBool)
 			{
-				for (int i = 0; i < mElemCount; i++)
+				for (int i = 0; i < count; i++)
 				{
 					*(short*)dst = (short)1;
 					dst[2] = *(bool*)src ? 'T' : 'F';
 					src += sizeof(bool);
-					dst += mElemSize;
+					dst += elemSize;
 				}
 			}
 			else throw LogicExceptionImpl("Array::WriteFrom", _("Incompatible types."));
 			break;
 
 		case blr_short :
-			if (adtype == IBPP::adBool)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(short*)dst = short(*(bool*)src ? 1 : 0);
-					src += sizeof(bool);
-					dst += mElemSize;
-				}
-			}
-			else if (adtype == IBPP::adInt16)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(short*)dst = *(short*)src;
-					src += sizeof(short);
-					dst += mElemSize;
-				}
-			}
+			if (adtype == IBPP::adBool) ArrayFromBool<int16_t>(src, dst, count);
+			else if (adtype == IBPP::adInt16) memcpy(dst, src, bytes);
 			else if (adtype == IBPP::adInt32)
 			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					if (*(long*)src < consts::min16 || *(long*)src > consts::max16)
-						throw LogicExceptionImpl("Array::WriteFrom",
-							_("Out of range numeric conversion !"));
-					*(short*)dst = (short)*(int*)src;
-					src += sizeof(int);
-					dst += mElemSize;
-				}
+				if (! ArrayInRange<int32_t>(src, count, consts::min16, consts::max16))
+					throw LogicExceptionImpl("Array::WriteFrom",
+						_("Out of range numeric conversion !"));
+				ArrayConvert<int32_t, int16_t>(src, dst, count);
 			}
 			else if (adtype == IBPP::adInt64)
 			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					if (*(int64_t*)src < consts::min16 || *(int64_t*)src > consts::max16)
-						throw LogicExceptionImpl("Array::WriteFrom",
-							_("Out of range numeric conversion !"));
-					*(short*)dst = (short)*(int64_t*)src;
-					src += sizeof(int64_t);
-					dst += mElemSize;
-				}
+				if (! ArrayInRange<int64_t>(src, count, consts::min16, consts::max16))
+					throw LogicExceptionImpl("Array::WriteFrom",
+						_("Out of range numeric conversion !"));
+				ArrayConvert<int64_t, int16_t>(src, dst, count);
 			}
+			// This SQL_SHORT may be a NUMERIC(x,y), scale it !
 			else if (adtype == IBPP::adFloat)
-			{
-				// This SQL_SHORT is a NUMERIC(x,y), scale it !
-				double multiplier = consts::dscales[-mDesc.array_desc_scale];
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(short*)dst =
-						(short)floor(*(float*)src * multiplier + 0.5);
-					src += sizeof(float);
-					dst += mElemSize;
-				}
-			}
+				ArrayToScaled<float, int16_t>(src, dst, count, desc.array_desc_scale);
 			else if (adtype == IBPP::adDouble)
-			{
-				// This SQL_SHORT is a NUMERIC(x,y), scale it !
-				double multiplier = consts::dscales[-mDesc.array_desc_scale];
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(short*)dst =
-						(short)floor(*(double*)src * multiplier + 0.5);
-					src += sizeof(double);
-					dst += mElemSize;
-				}
-			}
+				ArrayToScaled<double, int16_t>(src, dst, count, desc.array_desc_scale);
 			else throw LogicExceptionImpl("Array::WriteFrom", _("Incompatible types."));
 			break;
 
 		case blr_long :
-			if (adtype == IBPP::adBool)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(long*)dst = *(bool*)src ? 1 : 0;
-					src += sizeof(bool);
-					dst += mElemSize;
-				}
-			}
-			else if (adtype == IBPP::adInt16)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(long*)dst = *(short*)src;
-					src += sizeof(short);
-					dst += mElemSize;
-				}
-			}
-			else if (adtype == IBPP::adInt32)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(long*)dst = *(long*)src;
-					src += sizeof(long);
-					dst += mElemSize;
-				}
-			}
+			if (adtype == IBPP::adBool) ArrayFromBool<int32_t>(src, dst, count);
+			else if (adtype == IBPP::adInt16) ArrayConvert<int16_t, int32_t>(src, dst, count);
+			else if (adtype == IBPP::adInt32) memcpy(dst, src, bytes);
 			else if (adtype == IBPP::adInt64)
 			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					if (*(int64_t*)src < consts::min32 || *(int64_t*)src > consts::max32)
-						throw LogicExceptionImpl("Array::WriteFrom",
-							_("Out of range numeric conversion !"));
-					*(long*)dst = (long)*(int64_t*)src;
-					src += sizeof(int64_t);
-					dst += mElemSize;
-				}
+				if (! ArrayInRange<int64_t>(src, count, consts::min32, consts::max32))
+					throw LogicExceptionImpl("Array::WriteFrom",
+						_("Out of range numeric conversion !"));
+				ArrayConvert<int64_t, int32_t>(src, dst, count);
 			}
+			// This SQL_LONG may be a NUMERIC(x,y), scale it !
 			else if (adtype == IBPP::adFloat)
-			{
-				// This SQL_INT is a NUMERIC(x,y), scale it !
-				double multiplier = consts::dscales[-mDesc.array_desc_scale];
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(long*)dst =
-						(long)floor(*(float*)src * multiplier + 0.5);
-					src += sizeof(float);
-					dst += mElemSize;
-				}
-			}
+				ArrayToScaled<float, int32_t>(src, dst, count, desc.array_desc_scale);
 			else if (adtype == IBPP::adDouble)
-			{
-				// This SQL_INT is a NUMERIC(x,y), scale it !
-				double multiplier = consts::dscales[-mDesc.array_desc_scale];
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(long*)dst =
-						(long)floor(*(double*)src * multiplier + 0.5);
-					src += sizeof(double);
-					dst += mElemSize;
-				}
-			}
+				ArrayToScaled<double, int32_t>(src, dst, count, desc.array_desc_scale);
 			else throw LogicExceptionImpl("Array::WriteFrom", _("Incompatible types."));
 			break;
 
 		case blr_int64 :
-			if (adtype == IBPP::adBool)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(int64_t*)dst = *(bool*)src ? 1 : 0;
-					src += sizeof(bool);
-					dst += mElemSize;
-				}
-			}
-			else if (adtype == IBPP::adInt16)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(int64_t*)dst = *(short*)src;
-					src += sizeof(short);
-					dst += mElemSize;
-				}
-			}
-			else if (adtype == IBPP::adInt32)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(int64_t*)dst = *(long*)src;
-					src += sizeof(long);
-					dst += mElemSize;
-				}
-			}
-			else if (adtype == IBPP::adInt64)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(int64_t*)dst = *(int64_t*)src;
-					src += sizeof(int64_t);
-					dst += mElemSize;
-				}
-			}
+			if (adtype == IBPP::adBool) ArrayFromBool<int64_t>(src, dst, count);
+			else if (adtype == IBPP::adInt16) ArrayConvert<int16_t, int64_t>(src, dst, count);
+			else if (adtype == IBPP::adInt32) ArrayConvert<int32_t, int64_t>(src, dst, count);
+			else if (adtype == IBPP::adInt64) memcpy(dst, src, bytes);
+			// This SQL_INT64 may be a NUMERIC(x,y), scale it !
 			else if (adtype == IBPP::adFloat)
-			{
-				// This SQL_INT is a NUMERIC(x,y), scale it !
-				double multiplier = consts::dscales[-mDesc.array_desc_scale];
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(int64_t*)dst =
-						(int64_t)floor(*(float*)src * multiplier + 0.5);
-					src += sizeof(float);
-					dst += mElemSize;
-				}
-			}
+				ArrayToScaled<float, int64_t>(src, dst, count, desc.array_desc_scale);
 			else if (adtype == IBPP::adDouble)
-			{
-				// This SQL_INT is a NUMERIC(x,y), scale it !
-				double multiplier = consts::dscales[-mDesc.array_desc_scale];
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(int64_t*)dst =
-						(int64_t)floor(*(double*)src * multiplier + 0.5);
-					src += sizeof(double);
-					dst += mElemSize;
-				}
-			}
+				ArrayToScaled<double, int64_t>(src, dst, count, desc.array_desc_scale);
 			else
 				throw LogicExceptionImpl("Array::WriteFrom",
 					_("Incompatible types (blr_int64 and ADT %d)."), (int)adtype);
 			break;
 
 		case blr_float :
-			if (adtype != IBPP::adFloat || mDesc.array_desc_scale != 0)
+			if (desc.array_desc_scale != 0)
 				throw LogicExceptionImpl("Array::WriteFrom", _("Incompatible types."));
-			for (int i = 0; i < mElemCount; i++)
-			{
-				*(float*)dst = *(float*)src;
-				src += sizeof(float);
-				dst += mElemSize;
-			}
+			if (adtype == IBPP::adFloat) memcpy(dst, src, bytes);
+			else if (adtype == IBPP::adDouble) ArrayConvert<double, float>(src, dst, count);
+			else throw LogicExceptionImpl("Array::WriteFrom", _("Incompatible types."));
 			break;
 
 		case blr_double :
 			if (adtype != IBPP::adDouble) throw LogicExceptionImpl("Array::WriteFrom",
 										_("Incompatible types."));
-			if (mDesc.array_desc_scale != 0)
+			if (desc.array_desc_scale != 0)
 			{
 				// Round to scale of NUMERIC(x,y)
-				double multiplier = consts::dscales[-mDesc.array_desc_scale];
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(double*)dst =
-						floor(*(double*)src * multiplier + 0.5) / multiplier;
-					src += sizeof(double);
-					dst += mElemSize;
-				}
-			}
-			else
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(double*)dst = *(double*)src;
-					src += sizeof(double);
-					dst += mElemSize;
-				}
+				ArrayRound(src, dst, count, consts::dscales[-desc.array_desc_scale]);
 			}
+			else memcpy(dst, src, bytes);
 			break;
 
 		case blr_timestamp :
 			if (adtype != IBPP::adTimestamp) throw LogicExceptionImpl("Array::ReadTo",
 												_("Incompatible types."));
-			for (int i = 0; i < mElemCount; i++)
+			for (int i = 0; i < count; i++)
 			{
 				encodeTimestamp(*(ISC_TIMESTAMP*)dst, *(IBPP::Timestamp*)src);
 				src += sizeof(IBPP::Timestamp);
-				dst += mElemSize;
+				dst += elemSize;
 			}
 			break;
 
 		case blr_sql_date :
 			if (adtype != IBPP::adDate) throw LogicExceptionImpl("Array::ReadTo",
 												_("Incompatible types."));
-			for (int i = 0; i < mElemCount; i++)
+			for (int i = 0; i < count; i++)
 			{
 				encodeDate(*(ISC_DATE*)dst, *(IBPP::Date*)src); 
 				src += sizeof(IBPP::Date);
-				dst += mElemSize;
+				dst += elemSize;
 			}
 			break;
 
 		case blr_sql_time :
 			if (adtype != IBPP::adTime) throw LogicExceptionImpl("Array::ReadTo",
 												_("Incompatible types."));
-			for (int i = 0; i < mElemCount; i++)
+			for (int i = 0; i < count; i++)
 			{
 				encodeTime(*(ISC_TIME*)dst, *(IBPP::Time*)src);
 				src += sizeof(IBPP::Time);
-				dst += mElemSize;
+				dst += elemSize;
 			}
 			break;
 
 		default :
 			throw LogicExceptionImpl("Array::WriteFrom", _("Unknown sql type."));
 	}
-
-	IBS status;
-	ISC_LONG lenbuf = mBufferSize;
-	(*gds.Call()->m_array_put_slice)(status.Self(), mDatabase->GetHandlePtr(),
-		mTransaction->GetHandlePtr(), &mId, &mDesc, mBuffer, &lenbuf);
-	if (status.Errors())
-		throw SQLExceptionImpl(status, "Array::WriteFrom", _("isc_array_put_slice failed."));
-	if (lenbuf != mBufferSize)
-		throw SQLExceptionImpl(status, "Array::WriteFrom", _("Internal buffer size discrepancy."));
 }
 
 IBPP::Database ArrayImpl::DatabasePtr() const
@@ -923,8 +729,7 @@ void ArrayImpl::Release()
 {
 	// Release cannot throw, except in DEBUG builds on assertion
 	ASSERTION(mRefCount >= 0);
-	--mRefCount;
-	try { if (mRefCount <= 0) delete this; }
+	try { if (--mRefCount <= 0) delete this; }
 		catch (...) { }
 }
 
@@ -965,10 +770,6 @@ void ArrayImpl::ResetId()
 
 void ArrayImpl::AllocArrayBuffer()
 {
-	// Clean previous buffer if any
-	if (mBuffer != 0) delete [] (char*)mBuffer;
-	mBuffer = 0;
-
 	// Computes total number of elements in the array or slice
 	mElemCount = 1;
 	for (int i = 0; i < mDesc.array_desc_dimensions; i++)
@@ -979,9 +780,11 @@ void ArrayImpl::AllocArrayBuffer()
 	}
 
 	// Allocates a buffer for this count of elements
-	mElemSize = mDesc.array_desc_length;
-	if (mDesc.array_desc_dtype == blr_varying) mElemSize += 2;
-	else if (mDesc.array_desc_dtype == blr_cstring) mElemSize += 1;
+	mElemSize = ArrayElementSize(mDesc);
+
+	// Keep the previous buffer when its size fits (same column described again)
+	if (mBuffer != 0 && mBufferSize == mElemSize * mElemCount) return;
+	if (mBuffer != 0) delete [] (char*)mBuffer;
 	mBufferSize = mElemSize * mElemCount;
 	mBuffer = (void*) new char[mBufferSize];
 }
@@ -92,20 +92,32 @@ void DatabaseImpl::Connect()
     dpb.Insert(isc_dpb_password, mUserPassword.c_str());
     if (! mRoleName.empty()) dpb.Insert(isc_dpb_sql_role_name, mRoleName.c_str());
     if (! mCharSet.empty()) dpb.Insert(isc_dpb_lc_ctype, mCharSet.c_str());
+	// The WITH TIME ZONE values of region zones come with their offset
+	// (Firebird 4, older servers skip the item)
+	dpb.Insert(isc_dpb_set_bind, "TIME ZONE TO EXTENDED");
 
 	std::string connect;
 	if (! mServerName.empty())
 		connect.assign(mServerName).append(":");
 	connect.append(mDatabaseName);
 
+	// Interface of a previous failed Connect(), if any
+	OORelease(mAttachment);
+	mAttachment = 0;
+
 	IBS status;
-	(*gds.Call()->m_attach_database)(status.Self(), (short)connect.size(),
-		const_cast<char*>(connect.c_str()), &mHandle, dpb.Size(), dpb.Self());
-    if (status.Errors())
-    {
-        mHandle = 0;     // Should be, but better be sure...
-		throw SQLExceptionImpl(status, "Database::Connect", _("isc_attach_database failed"));
-    }
+	if (gds.Call()->OOApi())
+		mAttachment = OOAttach(connect, dpb, &mHandle);
+	else
+	{
+		(*gds.Call()->m_attach_database)(status.Self(), (short)connect.size(),
+			const_cast<char*>(connect.c_str()), &mHandle, dpb.Size(), dpb.Self());
+		if (status.Errors())
+		{
+			mHandle = 0;     // Should be, but better be sure...
+			throw SQLExceptionImpl(status, "Database::Connect", _("isc_attach_database failed"));
+		}
+	}
 
 	// Now, get ODS version information and dialect.
 	// If ODS major is lower of equal to 9, we reject the connection.
@@ -200,6 +212,10 @@ void DatabaseImpl::Disconnect()
 	// Put the connection to rest
 	Inactivate();
 
+	// The handle keeps the attachment alive until it is detached
+	OORelease(mAttachment);
+	mAttachment = 0;
+
 	// Detach from the server
 	IBS status;
     (*gds.Call()->m_detach_database)(status.Self(), &mHandle);
@@ -219,6 +235,9 @@ void DatabaseImpl::Drop()
 	// Put the connection to a rest
 	Inactivate();
 
+	OORelease(mAttachment);
+	mAttachment = 0;
+
 	IBS vector;
 	(*gds.Call()->m_drop_database)(vector.Self(), &mHandle);
     if (vector.Errors())
@@ -227,6 +246,24 @@ void DatabaseImpl::Drop()
     mHandle = 0;
 }
 
+//	Asks the server to stop the operation running on the attachment, usually
+//	in another thread, which then fails with isc_cancelled. False is returned
+//	when the client library predates fb_cancel_operation (Firebird 2.5).
+bool DatabaseImpl::CancelOperation()
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Database::CancelOperation", _("Database is not connected."));
+
+	GDS* g = gds.Call();
+	if (g->m_fb_cancel_operation == 0) return false;
+
+	IBS status;
+	(*g->m_fb_cancel_operation)(status.Self(), &mHandle, fb_cancel_raise);
+	if (status.Errors())
+		throw SQLExceptionImpl(status, "Database::CancelOperation", _("fb_cancel_operation failed"));
+	return true;
+}
+
 void DatabaseImpl::Info(int* ODSMajor, int* ODSMinor,
 	int* PageSize, int* Pages, int* Buffers, int* Sweep,
 	bool* Sync, bool* Reserve)
@@ -317,6 +354,37 @@ void DatabaseImpl::Counts(int* Insert, int* Update, int* Delete,
 	if (ReadSeq != 0) *ReadSeq = result.GetCountValue(isc_info_read_seq_count);
 }
 
+//	Statistics() and the read Counts() of the attachment, in a single round trip
+void DatabaseImpl::Activity(int* Fetches, int* Marks, int* Reads, int* Writes,
+	int* ReadIdx, int* ReadSeq)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Database::Activity", _("Database is not connected."));
+
+	char items[] = {isc_info_fetches,
+					isc_info_marks,
+					isc_info_reads,
+					isc_info_writes,
+					isc_info_read_idx_count,
+					isc_info_read_seq_count,
+					isc_info_end};
+    IBS status;
+	RB result(1024);
+
+	status.Reset();
+	(*gds.Call()->m_database_info)(status.Self(), &mHandle, sizeof(items), items,
+		result.Size(), result.Self());
+	if (status.Errors())
+		throw SQLExceptionImpl(status, "Database::Activity", _("isc_database_info failed"));
+
+	if (Fetches != 0) *Fetches = result.GetValue(isc_info_fetches);
+	if (Marks != 0) *Marks = result.GetValue(isc_info_marks);
+	if (Reads != 0) *Reads = result.GetValue(isc_info_reads);
+	if (Writes != 0) *Writes = result.GetValue(isc_info_writes);
+	if (ReadIdx != 0) *ReadIdx = result.GetCountValue(isc_info_read_idx_count);
+	if (ReadSeq != 0) *ReadSeq = result.GetCountValue(isc_info_read_seq_count);
+}
+
 void DatabaseImpl::Users(std::vector<std::string>& users)
 {
 	if (mHandle == 0)
@@ -360,8 +428,7 @@ void DatabaseImpl::Release()
 {
 	// Release cannot throw, except in DEBUG builds on assertion
 	ASSERTION(mRefCount >= 0);
-	--mRefCount;
-	try { if (mRefCount <= 0) delete this; }
+	try { if (--mRefCount <= 0) delete this; }
 		catch (...) { }
 }
 
@@ -373,6 +440,7 @@ void DatabaseImpl::AttachTransactionImpl(TransactionImpl* tr)
 		throw LogicExceptionImpl("Database::AttachTransaction",
 					_("Transaction object is null."));
 
+	tr->SetDatabaseSlot(this, mTransactions.size());
 	mTransactions.push_back(tr);
 }
 
@@ -382,7 +450,12 @@ void DatabaseImpl::DetachTransactionImpl(TransactionImpl* tr)
 		throw LogicExceptionImpl("Database::DetachTransaction",
 				_("ITransaction object is null."));
 
-	mTransactions.erase(std::find(mTransactions.begin(), mTransactions.end(), tr));
+	size_t index = tr->DatabaseSlot(this);
+	ASSERTION(index < mTransactions.size() && mTransactions[index] == tr);
+	TransactionImpl* last = mTransactions.back();
+	mTransactions[index] = last;
+	last->SetDatabaseSlot(this, index);
+	mTransactions.pop_back();
 }
 
 void DatabaseImpl::AttachStatementImpl(StatementImpl* st)
@@ -391,7 +464,7 @@ void DatabaseImpl::AttachStatementImpl(StatementImpl* st)
 		throw LogicExceptionImpl("Database::AttachStatement",
 					_("Can't attach a null Statement object."));
 
-	mStatements.push_back(st);
+	SlotAttach(mStatements, st, &StatementImpl::mDbSlot);
 }
 
 void DatabaseImpl::DetachStatementImpl(StatementImpl* st)
@@ -400,7 +473,7 @@ void DatabaseImpl::DetachStatementImpl(StatementImpl* st)
 		throw LogicExceptionImpl("Database::DetachStatement",
 				_("Can't detach a null Statement object."));
 
-	mStatements.erase(std::find(mStatements.begin(), mStatements.end(), st));
+	SlotDetach(mStatements, st, &StatementImpl::mDbSlot);
 }
 
 void DatabaseImpl::AttachBlobImpl(BlobImpl* bb)
@@ -409,7 +482,7 @@ void DatabaseImpl::AttachBlobImpl(BlobImpl* bb)
 		throw LogicExceptionImpl("Database::AttachBlob",
 					_("Can't attach a null Blob object."));
 
-	mBlobs.push_back(bb);
+	SlotAttach(mBlobs, bb, &BlobImpl::mDbSlot);
 }
 
 void DatabaseImpl::DetachBlobImpl(BlobImpl* bb)
@@ -418,7 +491,7 @@ void DatabaseImpl::DetachBlobImpl(BlobImpl* bb)
 		throw LogicExceptionImpl("Database::DetachBlob",
 				_("Can't detach a null Blob object."));
 
-	mBlobs.erase(std::find(mBlobs.begin(), mBlobs.end(), bb));
+	SlotDetach(mBlobs, bb, &BlobImpl::mDbSlot);
 }
 
 void DatabaseImpl::AttachArrayImpl(ArrayImpl* ar)
@@ -427,7 +500,7 @@ void DatabaseImpl::AttachArrayImpl(ArrayImpl* ar)
 		throw LogicExceptionImpl("Database::AttachArray",
 					_("Can't attach a null Array object."));
 
-	mArrays.push_back(ar);
+	SlotAttach(mArrays, ar, &ArrayImpl::mDbSlot);
 }
 
 void DatabaseImpl::DetachArrayImpl(ArrayImpl* ar)
@@ -436,7 +509,7 @@ void DatabaseImpl::DetachArrayImpl(ArrayImpl* ar)
 		throw LogicExceptionImpl("Database::DetachArray",
 				_("Can't detach a null Array object."));
 
-	mArrays.erase(std::find(mArrays.begin(), mArrays.end(), ar));
+	SlotDetach(mArrays, ar, &ArrayImpl::mDbSlot);
 }
 
 void DatabaseImpl::AttachEventsImpl(EventsImpl* ev)
@@ -445,7 +518,7 @@ void DatabaseImpl::AttachEventsImpl(EventsImpl* ev)
 		throw LogicExceptionImpl("Database::AttachEventsImpl",
 					_("Can't attach a null Events object."));
 
-	mEvents.push_back(ev);
+	SlotAttach(mEvents, ev, &EventsImpl::mDbSlot);
 }
 
 void DatabaseImpl::DetachEventsImpl(EventsImpl* ev)
@@ -454,7 +527,7 @@ void DatabaseImpl::DetachEventsImpl(EventsImpl* ev)
 		throw LogicExceptionImpl("Database::DetachEventsImpl",
 				_("Can't detach a null Events object."));
 
-	mEvents.erase(std::find(mEvents.begin(), mEvents.end(), ev));
+	SlotDetach(mEvents, ev, &EventsImpl::mDbSlot);
 }
 
 DatabaseImpl::DatabaseImpl(const std::string& ServerName, const std::string& DatabaseName,
@@ -466,7 +539,7 @@ DatabaseImpl::DatabaseImpl(const std::string& ServerName, const std::string& Dat
 	mServerName(ServerName), mDatabaseName(DatabaseName),
 	mUserName(UserName), mUserPassword(UserPassword), mRoleName(RoleName),
 	mCharSet(CharSet), mCreateParams(CreateParams),
-	mDialect(3)
+	mDialect(3), mAttachment(0)
 {
 }
 
@@ -474,6 +547,7 @@ DatabaseImpl::~DatabaseImpl()
 {
 	try { if (Connected()) Disconnect(); }
 		catch(...) { }
+	OORelease(mAttachment);
 }
 
 //
@@ -53,7 +53,8 @@ void IBPP::Date::Today()
 
 void IBPP::Date::SetDate(int dt)
 {
-	if (! IBPP::dtoi(dt, 0, 0, 0))
+	// Range check only, dtoi() would split the date for nothing
+	if (dt < IBPP::MinDate || dt > IBPP::MaxDate)
 		throw LogicExceptionImpl("Date::SetDate", _("Out of range"));
 	mDate = dt;
 }
@@ -305,6 +305,14 @@ WrongTypeImpl::WrongTypeImpl(const std::string& context, int sqlType, IITYPE var
 		case SQL_TYPE_TIME :	info.append("TIME"); break;
 		case SQL_BLOB :			info.append("BLOB"); break;
 		case SQL_ARRAY :		info.append("ARRAY"); break;
+		case SQL_BOOLEAN :		info.append("BOOLEAN"); break;
+		case SQL_INT128 :		info.append("INT128"); break;
+		case SQL_DEC16 :
+		case SQL_DEC34 :		info.append("DECFLOAT"); break;
+		case SQL_TIMESTAMP_TZ :
+		case SQL_TIMESTAMP_TZ_EX :	info.append("TIMESTAMP WITH TIME ZONE"); break;
+		case SQL_TIME_TZ :
+		case SQL_TIME_TZ_EX :	info.append("TIME WITH TIME ZONE"); break;
 	}
 	info.append(" ").append(_(" and ")).append(" ");
 	switch (varType)
@@ -323,6 +331,9 @@ WrongTypeImpl::WrongTypeImpl(const std::string& context, int sqlType, IITYPE var
 		case ivBool :		info.append("bool"); break;
 		case ivDBKey :		info.append("DBKey"); break;
 		case ivByte :		info.append("int8_t"); break;
+		case ivInt128 :		info.append("Int128"); break;
+		case ivTimestampTz :	info.append("TimestampTz"); break;
+		case ivTimeTz :		info.append("TimeTz"); break;
 	}
 	mWhat.append(info).append("\n");
 }
@@ -42,6 +42,18 @@
 //
 //	Select the platform:	IBPP_WINDOWS | IBPP_LINUX | IBPP_DARWIN
 //
+//	CONCURRENCY
+//
+//	* The binding to the client library is done once, on the first use of a
+//	  factory, and that first use may happen on several threads at once.
+//	* The reference counts behind IBPP::Ptr are atomic : copies of a Ptr to
+//	  the same object may be made and dropped on different threads.
+//	* Everything else is NOT synchronized. All the objects depending on one
+//	  Database (its transactions, statements, blobs, arrays and events) must
+//	  be used by a single thread at a time. Use one Database attachment per
+//	  thread to run work in parallel ; the client library itself (Firebird
+//	  2.5 and later) is thread safe across attachments.
+//
 ///////////////////////////////////////////////////////////////////////////////
 
 #ifndef __IBPP_H__
@@ -79,6 +91,7 @@
 	typedef unsigned __int32 uint32_t;
 #endif
 	typedef __int64 int64_t;
+	typedef unsigned __int64 uint64_t;
 #else
 	#include <stdint.h>			// C99 (7.18) integer types definitions
 #endif
@@ -118,9 +131,18 @@ namespace IBPP
 		stSelect, stInsert, stUpdate, stDelete,	stDDL, stExecProcedure,
 		stSelectUpdate, stSetGenerator, stSavePoint};
 
-	//	SQL Data Types
+	//	SQL Data Types. BOOLEAN is accessed as bool, INT128 as Int128 (or the
+	//	other numeric types and std::string), DECFLOAT as std::string, which is
+	//	exact, or double. A NUMERIC(x,y) stored in a SMALLINT, INTEGER or
+	//	BIGINT may also be set from a std::string, read exactly at its scale.
 	enum SDT {sdArray, sdBlob, sdDate, sdTime, sdTimestamp, sdString,
-		sdSmallint, sdInteger, sdLargeint, sdFloat, sdDouble};
+		sdSmallint, sdInteger, sdLargeint, sdFloat, sdDouble,
+		sdBoolean, sdInt128, sdDecfloat16, sdDecfloat34,	// Firebird 3 and 4
+		sdTimestampTz, sdTimeTz};
+
+	//	Status codes of the non-throwing accessors (TrySet, TryGet, TryExecute)
+	enum RSC {rcOk, rcNull, rcWrongType, rcOutOfRange, rcBadIndex, rcNotReady,
+		rcSQLError};
 
 	//	Array Data Types
 	enum ADT {adDate, adTime, adTimestamp, adString,
@@ -342,6 +364,110 @@ namespace IBPP
 		~Timestamp() { }
 	};
 
+	/* Class Int128 holds the 128 bits integers of the Firebird 4 INT128 type,
+	 * which also stores the NUMERIC and DECIMAL of 19 to 38 digits. The scale
+	 * arguments are the number of digits after the decimal point (the
+	 * ColumnScale() of the column). The class only converts : arithmetic is
+	 * left to the application. FromString() and FromDouble() return false,
+	 * leaving the value untouched, when the number is invalid or too large. */
+
+	class Int128
+	{
+	protected:
+		uint64_t mLow;
+		int64_t mHigh;		// Two's complement, like the server
+
+	public:
+		void Clear()	{ mLow = 0; mHigh = 0; }
+		void SetValue(int64_t value)
+			{ mLow = (uint64_t)value; mHigh = value < 0 ? -1 : 0; }
+		void SetValue(int64_t high, uint64_t low)	{ mHigh = high; mLow = low; }
+		int64_t High() const	{ return mHigh; }
+		uint64_t Low() const	{ return mLow; }
+		bool FitsInt64() const
+			{ return mHigh == ((int64_t)mLow < 0 ? -1 : 0); }
+
+		std::string ToString(int scale = 0) const;
+		double ToDouble(int scale = 0) const;
+		bool FromString(const std::string&, int scale = 0);
+		bool FromDouble(double, int scale = 0);
+
+		Int128()				{ Clear(); }
+		Int128(int64_t value)	{ SetValue(value); }
+		Int128(int64_t high, uint64_t low)	{ SetValue(high, low); }
+
+		bool operator==(const Int128& rv) const
+			{ return mHigh == rv.mHigh && mLow == rv.mLow; }
+		bool operator!=(const Int128& rv) const
+			{ return mHigh != rv.mHigh || mLow != rv.mLow; }
+		bool operator<(const Int128& rv) const
+			{ return mHigh < rv.mHigh || (mHigh == rv.mHigh && mLow < rv.mLow); }
+		bool operator>(const Int128& rv) const
+			{ return rv < *this; }
+	};
+
+	/* Class TimeZone is the zone part of TimestampTz and TimeTz, the Firebird 4
+	 * WITH TIME ZONE types. ZoneId() is the Firebird zone number and Zone() its
+	 * name : "+03:00" for an offset, "Europe/Paris" for a region. Offset() is
+	 * the shift from UTC in minutes, at the date of the value. It is always
+	 * known for offsets; for regions when the server sent it, which Connect()
+	 * asks for (SET BIND OF TIME ZONE TO EXTENDED). Region names are looked up
+	 * in the time zone database of a Firebird 4 client library (IUtil of its
+	 * OO API) : with an older one Zone() is empty for them, except "GMT". */
+
+	class TimeZone
+	{
+	protected:
+		int mZoneId;
+		int mOffset;
+		bool mOffsetKnown;
+		std::string mZone;
+
+	public:
+		void SetOffset(int minutes);	// -23:59 to +23:59, like the server
+		void SetZone(int zoneid, const std::string& name, int minutes, bool known);
+		int ZoneId() const				{ return mZoneId; }
+		const std::string& Zone() const	{ return mZone; }
+		int Offset() const				{ return mOffset; }
+		bool OffsetKnown() const		{ return mOffsetKnown; }
+
+		TimeZone()	{ SetOffset(0); }
+		virtual ~TimeZone() { };
+	};
+
+	/* Class TimestampTz is a TIMESTAMP WITH TIME ZONE : the Timestamp part is
+	 * the UTC date and time, as stored by the server, and Local() the date and
+	 * time at the zone (when its offset is known). */
+
+	class TimestampTz : public Timestamp, public TimeZone
+	{
+	public:
+		void Clear()	{ Timestamp::Clear(); SetOffset(0); }
+		Timestamp Local() const;
+
+		TimestampTz()	{ Clear(); }
+		TimestampTz(const Timestamp& utc, int minutes = 0)
+			: Timestamp(utc) { SetOffset(minutes); }
+
+		~TimestampTz() { }
+	};
+
+	/* Class TimeTz is a TIME WITH TIME ZONE : the Time part is the UTC time and
+	 * Local() the time at the zone (when its offset is known). */
+
+	class TimeTz : public Time, public TimeZone
+	{
+	public:
+		void Clear()	{ Time::Clear(); SetOffset(0); }
+		Time Local() const;
+
+		TimeTz()	{ Clear(); }
+		TimeTz(const Time& utc, int minutes = 0)
+			: Time(utc) { SetOffset(minutes); }
+
+		~TimeTz() { }
+	};
+
 	/* Class DBKey can store a DBKEY, that special value which the hidden
 	 * RDB$DBKEY can give you from a select statement. A DBKey is nothing
 	 * specific to IBPP. It's a feature of the Firebird database engine. See its
@@ -579,6 +705,8 @@ namespace IBPP
 			int* Reads, int* Writes) = 0;
 		virtual void Counts(int* Insert, int* Update, int* Delete, 
 			int* ReadIdx, int* ReadSeq) = 0;
+		virtual void Activity(int* Fetches, int* Marks, int* Reads,
+			int* Writes, int* ReadIdx, int* ReadSeq) = 0;	// One info call
 		virtual void Users(std::vector<std::string>& users) = 0;
 		virtual int Dialect() = 0;
 
@@ -588,6 +716,8 @@ namespace IBPP
 		virtual void Inactivate() = 0;
 		virtual void Disconnect() = 0;
 		virtual void Drop() = 0;
+		virtual bool CancelOperation() = 0;	// From another thread
+		virtual bool OOApiActive() = 0;		// Attached through the OO API
 
 		virtual IDatabase* AddRef() = 0;
 		virtual void Release() = 0;
@@ -611,6 +741,9 @@ namespace IBPP
 	    virtual void DetachDatabase(Database db) = 0;
 	 	virtual void AddReservation(Database db,
 	 			const std::string& table, TTR tr) = 0;
+		// Firebird 4 : share the snapshot of another concurrency transaction,
+		// identified by RDB$GET_CONTEXT('SYSTEM', 'SNAPSHOT_NUMBER').
+		virtual void SetSnapshotNumber(Database db, int64_t number) = 0;
 
 		virtual void Start() = 0;
 		virtual bool Started() = 0;
@@ -645,6 +778,9 @@ namespace IBPP
 		virtual void Set(int, const Timestamp&) = 0;
 		virtual void Set(int, const Date&) = 0;
 		virtual void Set(int, const Time&) = 0;
+		virtual void Set(int, const Int128&) = 0;
+		virtual void Set(int, const TimestampTz&) = 0;
+		virtual void Set(int, const TimeTz&) = 0;
 		virtual void Set(int, const DBKey&) = 0;
 		virtual void Set(int, const Blob&) = 0;
 		virtual void Set(int, const Array&) = 0;
@@ -661,10 +797,47 @@ namespace IBPP
 		virtual bool Get(int, Timestamp&) = 0;
 		virtual bool Get(int, Date&) = 0;
 		virtual bool Get(int, Time&) = 0;
+		virtual bool Get(int, Int128&) = 0;
+		virtual bool Get(int, TimestampTz&) = 0;
+		virtual bool Get(int, TimeTz&) = 0;
 		virtual bool Get(int, DBKey&) = 0;
 		virtual bool Get(int, Blob&) = 0;
 		virtual bool Get(int, Array&) = 0;
 
+		/* Non-throwing accessors. Conversion problems are returned as a status
+		 * code instead of an exception, TryGet returns rcNull for SQL NULL and
+		 * leaves the value untouched. Blob I/O (strings stored in blobs) and
+		 * client library failures may still throw. */
+		virtual RSC TrySetNull(int) = 0;
+		virtual RSC TrySet(int, bool) = 0;
+		virtual RSC TrySet(int, const std::string&) = 0;
+		virtual RSC TrySet(int, int16_t) = 0;
+		virtual RSC TrySet(int, int32_t) = 0;
+		virtual RSC TrySet(int, int64_t) = 0;
+		virtual RSC TrySet(int, float) = 0;
+		virtual RSC TrySet(int, double) = 0;
+		virtual RSC TrySet(int, const Timestamp&) = 0;
+		virtual RSC TrySet(int, const Date&) = 0;
+		virtual RSC TrySet(int, const Time&) = 0;
+		virtual RSC TrySet(int, const Int128&) = 0;
+		virtual RSC TrySet(int, const TimestampTz&) = 0;
+		virtual RSC TrySet(int, const TimeTz&) = 0;
+		virtual RSC TrySet(int, const Blob&) = 0;
+		virtual RSC TryGet(int, bool&) = 0;
+		virtual RSC TryGet(int, std::string&) = 0;
+		virtual RSC TryGet(int, int16_t&) = 0;
+		virtual RSC TryGet(int, int32_t&) = 0;
+		virtual RSC TryGet(int, int64_t&) = 0;
+		virtual RSC TryGet(int, float&) = 0;
+		virtual RSC TryGet(int, double&) = 0;
+		virtual RSC TryGet(int, Timestamp&) = 0;
+		virtual RSC TryGet(int, Date&) = 0;
+		virtual RSC TryGet(int, Time&) = 0;
+		virtual RSC TryGet(int, Int128&) = 0;
+		virtual RSC TryGet(int, TimestampTz&) = 0;
+		virtual RSC TryGet(int, TimeTz&) = 0;
+		virtual RSC TryGet(int, Blob&) = 0;
+
 		virtual bool IsNull(const std::string&) = 0;
 		virtual bool Get(const std::string&, bool&) = 0;
 		virtual bool Get(const std::string&, void*, int&) = 0;	// byte buffers
@@ -677,6 +850,9 @@ namespace IBPP
 		virtual bool Get(const std::string&, Timestamp&) = 0;
 		virtual bool Get(const std::string&, Date&) = 0;
 		virtual bool Get(const std::string&, Time&) = 0;
+		virtual bool Get(const std::string&, Int128&) = 0;
+		virtual bool Get(const std::string&, TimestampTz&) = 0;
+		virtual bool Get(const std::string&, TimeTz&) = 0;
 		virtual bool Get(const std::string&, DBKey&) = 0;
 		virtual bool Get(const std::string&, Blob&) = 0;
 		virtual bool Get(const std::string&, Array&) = 0;
@@ -723,6 +899,8 @@ namespace IBPP
 		virtual bool Fetch() = 0;
 		virtual bool Fetch(Row&) = 0;
 		virtual int AffectedRows() = 0;
+		virtual void RecordCounts(int* Select, int* Insert, int* Update,
+			int* Delete) = 0;
 		virtual void Close() = 0;
 		virtual std::string& Sql() = 0;
 		virtual STT Type() = 0;
@@ -740,6 +918,9 @@ namespace IBPP
 		virtual void Set(int, const Timestamp& value) = 0;
 		virtual void Set(int, const Date& value) = 0;
 		virtual void Set(int, const Time& value) = 0;
+		virtual void Set(int, const Int128& value) = 0;
+		virtual void Set(int, const TimestampTz& value) = 0;
+		virtual void Set(int, const TimeTz& value) = 0;
 		virtual void Set(int, const DBKey& value) = 0;
 		virtual void Set(int, const Blob& value) = 0;
 		virtual void Set(int, const Array& value) = 0;
@@ -756,10 +937,88 @@ namespace IBPP
 		virtual bool Get(int, Timestamp& value) = 0;
 		virtual bool Get(int, Date& value) = 0;
 		virtual bool Get(int, Time& value) = 0;
+		virtual bool Get(int, Int128& value) = 0;
+		virtual bool Get(int, TimestampTz& value) = 0;
+		virtual bool Get(int, TimeTz& value) = 0;
 		virtual bool Get(int, DBKey& value) = 0;
 		virtual bool Get(int, Blob& value) = 0;
 		virtual bool Get(int, Array& value) = 0;
 
+		/* Non-throwing accessors. Conversion problems are returned as a status
+		 * code instead of an exception, TryGet returns rcNull for SQL NULL and
+		 * leaves the value untouched. Blob I/O (strings stored in blobs) and
+		 * client library failures may still throw. */
+		virtual RSC TrySetNull(int) = 0;
+		virtual RSC TrySet(int, bool) = 0;
+		virtual RSC TrySet(int, const std::string&) = 0;
+		virtual RSC TrySet(int, int16_t) = 0;
+		virtual RSC TrySet(int, int32_t) = 0;
+		virtual RSC TrySet(int, int64_t) = 0;
+		virtual RSC TrySet(int, float) = 0;
+		virtual RSC TrySet(int, double) = 0;
+		virtual RSC TrySet(int, const Timestamp&) = 0;
+		virtual RSC TrySet(int, const Date&) = 0;
+		virtual RSC TrySet(int, const Time&) = 0;
+		virtual RSC TrySet(int, const Int128&) = 0;
+		virtual RSC TrySet(int, const TimestampTz&) = 0;
+		virtual RSC TrySet(int, const TimeTz&) = 0;
+		virtual RSC TrySet(int, const Blob&) = 0;
+		virtual RSC TryGet(int, bool&) = 0;
+		virtual RSC TryGet(int, std::string&) = 0;
+		virtual RSC TryGet(int, int16_t&) = 0;
+		virtual RSC TryGet(int, int32_t&) = 0;
+		virtual RSC TryGet(int, int64_t&) = 0;
+		virtual RSC TryGet(int, float&) = 0;
+		virtual RSC TryGet(int, double&) = 0;
+		virtual RSC TryGet(int, Timestamp&) = 0;
+		virtual RSC TryGet(int, Date&) = 0;
+		virtual RSC TryGet(int, Time&) = 0;
+		virtual RSC TryGet(int, Int128&) = 0;
+		virtual RSC TryGet(int, TimestampTz&) = 0;
+		virtual RSC TryGet(int, TimeTz&) = 0;
+		virtual RSC TryGet(int, Blob&) = 0;
+
+		/* TryExecute() returns rcSQLError instead of throwing when the server
+		 * refuses the statement (constraint violation, ...). The status is kept
+		 * until the next TryExecute() and its message is only formatted when
+		 * LastErrorMessage() is called. */
+		virtual RSC TryExecute() = 0;
+		virtual int LastSqlCode() = 0;
+		virtual int LastEngineCode() = 0;
+		virtual const char* LastErrorMessage() = 0;
+
+		/* AddBatch() queues the current parameter values and ExecuteBatch()
+		 * executes the statement for the queued rows, in the order they were
+		 * added, returning the number of affected rows. On an attachment of
+		 * the OO API the rows go in an IBatch (Firebird 4), sent in one round
+		 * trip; otherwise, or when a parameter is a blob or an array, copies
+		 * of the rows are queued and executed one by one; ServerBatch() tells
+		 * which, once the statement is prepared. The queue is emptied in any
+		 * case; a failing row throws a SQLException, the rows before it
+		 * staying executed in the transaction.
+		 * SetTimeout() limits the execution time of the statement, in
+		 * milliseconds (0 : none). It needs the OO API and Firebird 4. */
+		virtual void AddBatch() = 0;
+		virtual int ExecuteBatch() = 0;
+		virtual bool ServerBatch() = 0;
+		virtual void SetTimeout(unsigned msecs) = 0;
+
+		/* ExecuteScrollable() opens a scrollable cursor on a SELECT, through
+		 * the OO API (see Database::OOApiActive()); remote attachments need a
+		 * Firebird 5 server, older ones refuse the cursor with a SQLException.
+		 * The result set stays on the server and is walked in any direction:
+		 * Fetch() moves to the next row and the FetchXxx() methods below do
+		 * the other moves. They return false when the move leaves the result
+		 * set, the cursor staying open. FetchAbsolute() counts rows from 1,
+		 * or from the end when negative. */
+		virtual void ExecuteScrollable() = 0;
+		virtual bool Scrollable() = 0;
+		virtual bool FetchPrior() = 0;
+		virtual bool FetchFirst() = 0;
+		virtual bool FetchLast() = 0;
+		virtual bool FetchAbsolute(int position) = 0;
+		virtual bool FetchRelative(int offset) = 0;
+
 		virtual bool IsNull(const std::string&) = 0;
 		virtual bool Get(const std::string&, bool&) = 0;
 		virtual bool Get(const std::string&, void*, int&) = 0;	// byte buffers
@@ -772,6 +1031,9 @@ namespace IBPP
 		virtual bool Get(const std::string&, Timestamp& value) = 0;
 		virtual bool Get(const std::string&, Date& value) = 0;
 		virtual bool Get(const std::string&, Time& value) = 0;
+		virtual bool Get(const std::string&, Int128& value) = 0;
+		virtual bool Get(const std::string&, TimestampTz& value) = 0;
+		virtual bool Get(const std::string&, TimeTz& value) = 0;
 		virtual bool Get(const std::string&, DBKey& value) = 0;
 		virtual bool Get(const std::string&, Blob& value) = 0;
 		virtual bool Get(const std::string&, Array& value) = 0;
@@ -790,6 +1052,8 @@ namespace IBPP
 		virtual int ParameterSubtype(int) = 0;
 		virtual int ParameterSize(int) = 0;
 		virtual int ParameterScale(int) = 0;
+		virtual const char* ParameterName(int) = 0;		// Column the parameter is assigned to
+		virtual const char* ParameterTable(int) = 0;	// (when the server tells it)
 		virtual int Parameters() = 0;
 
 		virtual void Plan(std::string&) = 0;
@@ -911,6 +1175,42 @@ namespace IBPP
 	 
 	void ClientLibSearchPaths(const std::string&);
 
+	/* When the client library has the Firebird OO API (Firebird 4 and later),
+	 * databases are attached, single database transactions started and
+	 * statements executed and fetched through its interfaces (IProvider,
+	 * IAttachment, IStatement, IResultSet, IBatch); the legacy isc_* entry
+	 * points are the fallback. OOApiActive() tells if the attachments
+	 * connected from now on use the OO API, UseLegacyAPI(true) keeps them on
+	 * the legacy one. Blobs, arrays, events, info requests, commits and
+	 * rollbacks always go through the legacy handles of the same objects. */
+
+	void UseLegacyAPI(bool);
+	bool OOApiActive();
+
+	/* TraceCalls(true) routes the calls to the isc_* entry points of the
+	 * client library through wrappers which count and time them; given a
+	 * file name, each call is also written to it as an event of a Chrome
+	 * trace (chrome://tracing, ui.perfetto.dev). TraceCalls(false) restores
+	 * the entry points and closes the file. The IBPP_TRACE environment
+	 * variable, set to 1 or to a file name, starts the tracing when the
+	 * client library is loaded and prints TraceCounts() on stderr at exit.
+	 * The calls made through the OO API interfaces are not seen.
+	 * TraceCounts() gives the entry points called since the last
+	 * ResetTraceCounts(), by decreasing total time. */
+
+	struct TraceCount
+	{
+		std::string Name;		// "isc_dsql_fetch"
+		int64_t Calls;
+		int64_t Errors;			// Calls which returned an error status
+		int64_t Nanoseconds;
+	};
+
+	void TraceCalls(bool enable, const char* chromeTraceFile = 0);
+	bool TracingCalls();
+	void TraceCounts(std::vector<TraceCount>&);
+	void ResetTraceCounts();
+
 	/* Finally, here are some date and time conversion routines used by IBPP and
 	 * that may be helpful at the application level. They do not depend on
 	 * anything related to Firebird/Interbase. Just a bonus. dtoi and itod
@@ -187,6 +187,33 @@ void RowImpl::Set(int param, const IBPP::Time& value)
 	mUpdated[param-1] = true;
 }
 
+void RowImpl::Set(int param, const IBPP::Int128& value)
+{
+	if (mDescrArea == 0)
+		throw LogicExceptionImpl("Row::Set[Int128]", _("The row is not initialized."));
+
+	SetValue(param, ivInt128, &value);
+	mUpdated[param-1] = true;
+}
+
+void RowImpl::Set(int param, const IBPP::TimestampTz& value)
+{
+	if (mDescrArea == 0)
+		throw LogicExceptionImpl("Row::Set[TimestampTz]", _("The row is not initialized."));
+
+	SetValue(param, ivTimestampTz, &value);
+	mUpdated[param-1] = true;
+}
+
+void RowImpl::Set(int param, const IBPP::TimeTz& value)
+{
+	if (mDescrArea == 0)
+		throw LogicExceptionImpl("Row::Set[TimeTz]", _("The row is not initialized."));
+
+	SetValue(param, ivTimeTz, &value);
+	mUpdated[param-1] = true;
+}
+
 void RowImpl::Set(int param, const IBPP::Blob& blob)
 {
 	if (mDescrArea == 0)
@@ -400,6 +427,33 @@ bool RowImpl::Get(int column, IBPP::Time& time)
 	return pvalue == 0 ? true : false;
 }
 
+bool RowImpl::Get(int column, IBPP::Int128& value)
+{
+	if (mDescrArea == 0)
+		throw LogicExceptionImpl("Row::Get", _("The row is not initialized."));
+
+	void* pvalue = GetValue(column, ivInt128, (void*)&value);
+	return pvalue == 0 ? true : false;
+}
+
+bool RowImpl::Get(int column, IBPP::TimestampTz& timestamp)
+{
+	if (mDescrArea == 0)
+		throw LogicExceptionImpl("Row::Get", _("The row is not initialized."));
+
+	void* pvalue = GetValue(column, ivTimestampTz, (void*)&timestamp);
+	return pvalue == 0 ? true : false;
+}
+
+bool RowImpl::Get(int column, IBPP::TimeTz& time)
+{
+	if (mDescrArea == 0)
+		throw LogicExceptionImpl("Row::Get", _("The row is not initialized."));
+
+	void* pvalue = GetValue(column, ivTimeTz, (void*)&time);
+	return pvalue == 0 ? true : false;
+}
+
 bool RowImpl::Get(int column, IBPP::Blob& retblob)
 {
 	if (mDescrArea == 0)
@@ -427,6 +481,220 @@ bool RowImpl::Get(int column, IBPP::Array& retarray)
 	return pvalue == 0 ? true : false;
 }
 
+IBPP::RSC RowImpl::TrySetValue(int param, IITYPE ivType, const void* value)
+{
+	if (mDescrArea == 0) return IBPP::rcNotReady;
+
+	IBPP::RSC rc = SetValueRC(param, ivType, value);
+	if (rc == IBPP::rcOk) mUpdated[param-1] = true;
+	return rc;
+}
+
+IBPP::RSC RowImpl::TryGetValue(int column, IITYPE ivType, void*& value, void* retvalue)
+{
+	if (mDescrArea == 0) return IBPP::rcNotReady;
+
+	return GetValueRC(column, ivType, value, retvalue);
+}
+
+IBPP::RSC RowImpl::TrySetNull(int param)
+{
+	if (mDescrArea == 0) return IBPP::rcNotReady;
+	if (param < 1 || param > mDescrArea->sqld) return IBPP::rcBadIndex;
+
+	XSQLVAR* var = &(mDescrArea->sqlvar[param-1]);
+	if (! (var->sqltype & 1)) return IBPP::rcWrongType;
+
+	*var->sqlind = -1;	// Set the column to SQL NULL
+	mUpdated[param-1] = true;
+	return IBPP::rcOk;
+}
+
+IBPP::RSC RowImpl::TrySet(int param, bool value)
+{
+	return TrySetValue(param, ivBool, &value);
+}
+
+IBPP::RSC RowImpl::TrySet(int param, const std::string& s)
+{
+	return TrySetValue(param, ivString, &s);
+}
+
+IBPP::RSC RowImpl::TrySet(int param, int16_t value)
+{
+	return TrySetValue(param, ivInt16, &value);
+}
+
+IBPP::RSC RowImpl::TrySet(int param, int32_t value)
+{
+	return TrySetValue(param, ivInt32, &value);
+}
+
+IBPP::RSC RowImpl::TrySet(int param, int64_t value)
+{
+	return TrySetValue(param, ivInt64, &value);
+}
+
+IBPP::RSC RowImpl::TrySet(int param, float value)
+{
+	return TrySetValue(param, ivFloat, &value);
+}
+
+IBPP::RSC RowImpl::TrySet(int param, double value)
+{
+	return TrySetValue(param, ivDouble, &value);
+}
+
+IBPP::RSC RowImpl::TrySet(int param, const IBPP::Timestamp& value)
+{
+	return TrySetValue(param, ivTimestamp, &value);
+}
+
+IBPP::RSC RowImpl::TrySet(int param, const IBPP::Date& value)
+{
+	if (mDialect == 1)
+	{
+		// Dialect 1 'DATE' fields are actually ISC_TIMESTAMP
+		IBPP::Timestamp timestamp(value);
+		return TrySetValue(param, ivTimestamp, &timestamp);
+	}
+	return TrySetValue(param, ivDate, &value);
+}
+
+IBPP::RSC RowImpl::TrySet(int param, const IBPP::Time& value)
+{
+	if (mDialect == 1) return IBPP::rcWrongType;
+
+	return TrySetValue(param, ivTime, &value);
+}
+
+IBPP::RSC RowImpl::TrySet(int param, const IBPP::Int128& value)
+{
+	return TrySetValue(param, ivInt128, &value);
+}
+
+IBPP::RSC RowImpl::TrySet(int param, const IBPP::TimestampTz& value)
+{
+	return TrySetValue(param, ivTimestampTz, &value);
+}
+
+IBPP::RSC RowImpl::TrySet(int param, const IBPP::TimeTz& value)
+{
+	return TrySetValue(param, ivTimeTz, &value);
+}
+
+IBPP::RSC RowImpl::TrySet(int param, const IBPP::Blob& blob)
+{
+	if (mDatabase != 0 && blob->DatabasePtr() != mDatabase) return IBPP::rcWrongType;
+	if (mTransaction != 0 && blob->TransactionPtr() != mTransaction) return IBPP::rcWrongType;
+
+	return TrySetValue(param, ivBlob, blob.intf());
+}
+
+IBPP::RSC RowImpl::TryGet(int column, bool& retvalue)
+{
+	void* pvalue;
+	IBPP::RSC rc = TryGetValue(column, ivBool, pvalue);
+	if (rc == IBPP::rcOk) retvalue = (*(char*)pvalue == 0 ? false : true);
+	return rc;
+}
+
+IBPP::RSC RowImpl::TryGet(int column, std::string& retvalue)
+{
+	void* pvalue;
+	return TryGetValue(column, ivString, pvalue, &retvalue);
+}
+
+IBPP::RSC RowImpl::TryGet(int column, int16_t& retvalue)
+{
+	void* pvalue;
+	IBPP::RSC rc = TryGetValue(column, ivInt16, pvalue);
+	if (rc == IBPP::rcOk) retvalue = *(int16_t*)pvalue;
+	return rc;
+}
+
+IBPP::RSC RowImpl::TryGet(int column, int32_t& retvalue)
+{
+	void* pvalue;
+	IBPP::RSC rc = TryGetValue(column, ivInt32, pvalue);
+	if (rc == IBPP::rcOk) retvalue = *(int32_t*)pvalue;
+	return rc;
+}
+
+IBPP::RSC RowImpl::TryGet(int column, int64_t& retvalue)
+{
+	void* pvalue;
+	IBPP::RSC rc = TryGetValue(column, ivInt64, pvalue);
+	if (rc == IBPP::rcOk) retvalue = *(int64_t*)pvalue;
+	return rc;
+}
+
+IBPP::RSC RowImpl::TryGet(int column, float& retvalue)
+{
+	void* pvalue;
+	IBPP::RSC rc = TryGetValue(column, ivFloat, pvalue);
+	if (rc == IBPP::rcOk) retvalue = *(float*)pvalue;
+	return rc;
+}
+
+IBPP::RSC RowImpl::TryGet(int column, double& retvalue)
+{
+	void* pvalue;
+	IBPP::RSC rc = TryGetValue(column, ivDouble, pvalue);
+	if (rc == IBPP::rcOk) retvalue = *(double*)pvalue;
+	return rc;
+}
+
+IBPP::RSC RowImpl::TryGet(int column, IBPP::Timestamp& timestamp)
+{
+	void* pvalue;
+	return TryGetValue(column, ivTimestamp, pvalue, &timestamp);
+}
+
+IBPP::RSC RowImpl::TryGet(int column, IBPP::Date& date)
+{
+	void* pvalue;
+	if (mDialect == 1)
+	{
+		// Dialect 1 'DATE' fields are actually ISC_TIMESTAMP
+		IBPP::Timestamp timestamp;
+		IBPP::RSC rc = TryGetValue(column, ivTimestamp, pvalue, &timestamp);
+		if (rc == IBPP::rcOk) date = timestamp;
+		return rc;
+	}
+	return TryGetValue(column, ivDate, pvalue, &date);
+}
+
+IBPP::RSC RowImpl::TryGet(int column, IBPP::Time& time)
+{
+	void* pvalue;
+	return TryGetValue(column, ivTime, pvalue, &time);
+}
+
+IBPP::RSC RowImpl::TryGet(int column, IBPP::Int128& value)
+{
+	void* pvalue;
+	return TryGetValue(column, ivInt128, pvalue, &value);
+}
+
+IBPP::RSC RowImpl::TryGet(int column, IBPP::TimestampTz& timestamp)
+{
+	void* pvalue;
+	return TryGetValue(column, ivTimestampTz, pvalue, &timestamp);
+}
+
+IBPP::RSC RowImpl::TryGet(int column, IBPP::TimeTz& time)
+{
+	void* pvalue;
+	return TryGetValue(column, ivTimeTz, pvalue, &time);
+}
+
+IBPP::RSC RowImpl::TryGet(int column, IBPP::Blob& retblob)
+{
+	void* pvalue;
+	return TryGetValue(column, ivBlob, pvalue, retblob.intf());
+}
+
 /*
 const IBPP::Value RowImpl::Get(int column)
 {
@@ -543,6 +811,30 @@ bool RowImpl::Get(const std::string& name, IBPP::Time& retvalue)
 	return Get(ColumnNum(name), retvalue);
 }
 
+bool RowImpl::Get(const std::string& name, IBPP::Int128& retvalue)
+{
+	if (mDescrArea == 0)
+		throw LogicExceptionImpl("Row::Get", _("The row is not initialized."));
+
+	return Get(ColumnNum(name), retvalue);
+}
+
+bool RowImpl::Get(const std::string& name, IBPP::TimestampTz& retvalue)
+{
+	if (mDescrArea == 0)
+		throw LogicExceptionImpl("Row::Get", _("The row is not initialized."));
+
+	return Get(ColumnNum(name), retvalue);
+}
+
+bool RowImpl::Get(const std::string& name, IBPP::TimeTz& retvalue)
+{
+	if (mDescrArea == 0)
+		throw LogicExceptionImpl("Row::Get", _("The row is not initialized."));
+
+	return Get(ColumnNum(name), retvalue);
+}
+
 bool RowImpl::Get(const std::string&name, IBPP::Blob& retblob)
 {
 	if (mDescrArea == 0)
@@ -707,6 +999,14 @@ IBPP::SDT RowImpl::ColumnType(int varnum)
 		case SQL_TYPE_TIME : value = IBPP::sdTime;      break;
 		case SQL_BLOB :      value = IBPP::sdBlob;      break;
 		case SQL_ARRAY :     value = IBPP::sdArray;     break;
+		case SQL_BOOLEAN :   value = IBPP::sdBoolean;   break;
+		case SQL_INT128 :    value = IBPP::sdInt128;    break;
+		case SQL_DEC16 :     value = IBPP::sdDecfloat16; break;
+		case SQL_DEC34 :     value = IBPP::sdDecfloat34; break;
+		case SQL_TIMESTAMP_TZ :
+		case SQL_TIMESTAMP_TZ_EX : value = IBPP::sdTimestampTz; break;
+		case SQL_TIME_TZ :
+		case SQL_TIME_TZ_EX : value = IBPP::sdTimeTz;   break;
 		default : throw LogicExceptionImpl("Row::ColumnType",
 						_("Found an unknown sqltype !"));
 	}
@@ -796,8 +1096,7 @@ void RowImpl::Release()
 {
 	// Release cannot throw, except in DEBUG builds on assertion
 	ASSERTION(mRefCount >= 0);
-	--mRefCount;
-	try { if (mRefCount <= 0) delete this; }
+	try { if (--mRefCount <= 0) delete this; }
 		catch (...) { }
 }
 
@@ -805,11 +1104,89 @@ void RowImpl::Release()
 
 void RowImpl::SetValue(int varnum, IITYPE ivType, const void* value, int userlen)
 {
-	if (varnum < 1 || varnum > mDescrArea->sqld)
-		throw LogicExceptionImpl("RowImpl::SetValue", _("Variable index out of range."));
 	if (value == 0)
 		throw LogicExceptionImpl("RowImpl::SetValue", _("Unexpected null pointer detected."));
 
+	IBPP::RSC rc = SetValueRC(varnum, ivType, value, userlen);
+	if (rc != IBPP::rcOk) RaiseRC(rc, "RowImpl::SetValue", varnum, ivType);
+}
+
+void* RowImpl::GetValue(int varnum, IITYPE ivType, void* retvalue)
+{
+	void* value;
+	IBPP::RSC rc = GetValueRC(varnum, ivType, value, retvalue);
+	if (rc != IBPP::rcOk && rc != IBPP::rcNull) RaiseRC(rc, "RowImpl::GetValue", varnum, ivType);
+	return value;
+}
+
+//	Turns a status code of SetValueRC() / GetValueRC() into the exception
+//	the throwing accessors have always raised.
+
+void RowImpl::RaiseRC(IBPP::RSC rc, const char* context, int varnum, IITYPE ivType)
+{
+	switch (rc)
+	{
+		case IBPP::rcBadIndex :
+			throw LogicExceptionImpl(context, _("Variable index out of range."));
+		case IBPP::rcOutOfRange :
+			throw LogicExceptionImpl(context, _("Out of range numeric conversion !"));
+		case IBPP::rcWrongType :
+			{
+				XSQLVAR* var = &(mDescrArea->sqlvar[varnum-1]);
+				switch (var->sqltype & ~1)
+				{
+					case SQL_TEXT :
+					case SQL_VARYING :
+					case SQL_SHORT :
+					case SQL_LONG :
+					case SQL_INT64 :
+					case SQL_FLOAT :
+					case SQL_DOUBLE :
+					case SQL_TIMESTAMP :
+					case SQL_TYPE_DATE :
+					case SQL_TYPE_TIME :
+					case SQL_BLOB :
+					case SQL_ARRAY :
+					case SQL_BOOLEAN :
+					case SQL_INT128 :
+					case SQL_DEC16 :
+					case SQL_DEC34 :
+					case SQL_TIMESTAMP_TZ :
+					case SQL_TIMESTAMP_TZ_EX :
+					case SQL_TIME_TZ :
+					case SQL_TIME_TZ_EX :
+						throw WrongTypeImpl(context, var->sqltype, ivType,
+											_("Incompatible types."));
+					default :
+						throw LogicExceptionImpl(context,
+							_("The field uses an unsupported SQL type !"));
+				}
+			}
+		default :
+			throw LogicExceptionImpl(context, _("The row is not initialized."));
+	}
+}
+
+//	The text of a NUMERIC(x,y) stored in a SQL_SHORT, SQL_LONG or SQL_INT64
+//	is read at the scale of the column, without going through a double
+
+static bool ScaledFromString(const XSQLVAR* var, const std::string& text, int64_t& result)
+{
+	IBPP::Int128 i128;
+	if (! i128.FromString(text, -var->sqlscale) || ! i128.FitsInt64())
+		return false;
+	result = (int64_t)i128.Low();
+	return true;
+}
+
+//	The status code versions do the actual work for both families of
+//	accessors (Get/Set and TryGet/TrySet).
+
+IBPP::RSC RowImpl::SetValueRC(int varnum, IITYPE ivType, const void* value, int userlen)
+{
+	if (varnum < 1 || varnum > mDescrArea->sqld)
+		return IBPP::rcBadIndex;
+
 	int16_t len;
 	XSQLVAR* var = &(mDescrArea->sqlvar[varnum-1]);
 	switch (var->sqltype & ~1)
@@ -840,8 +1217,7 @@ void RowImpl::SetValue(int varnum, IITYPE ivType, const void* value, int userlen
 				len = 1;
 				while (len < var->sqllen) var->sqldata[len++] = ' ';
 			}
-			else throw WrongTypeImpl("RowImpl::SetValue", var->sqltype, ivType,
-										_("Incompatible types."));
+			else return IBPP::rcWrongType;
 			break;
 
 		case SQL_VARYING :
@@ -864,8 +1240,7 @@ void RowImpl::SetValue(int varnum, IITYPE ivType, const void* value, int userlen
 				*(int16_t*)var->sqldata = (int16_t)1;
 				var->sqldata[2] = *(bool*)value ? 'T' : 'F';
 			}
-			else throw WrongTypeImpl("RowImpl::SetValue", var->sqltype, ivType,
-										_("Incompatible types."));
+			else return IBPP::rcWrongType;
 			break;
 
 		case SQL_SHORT :
@@ -880,15 +1255,13 @@ void RowImpl::SetValue(int varnum, IITYPE ivType, const void* value, int userlen
 			else if (ivType == ivInt32)
 			{
 				if (*(int32_t*)value < consts::min16 || *(int32_t*)value > consts::max16)
-					throw LogicExceptionImpl("RowImpl::SetValue",
-						_("Out of range numeric conversion !"));
+					return IBPP::rcOutOfRange;
 				*(int16_t*)var->sqldata = (int16_t)*(int32_t*)value;
 			}
 			else if (ivType == ivInt64)
 			{
 				if (*(int64_t*)value < consts::min16 || *(int64_t*)value > consts::max16)
-					throw LogicExceptionImpl("RowImpl::SetValue",
-						_("Out of range numeric conversion !"));
+					return IBPP::rcOutOfRange;
 				*(int16_t*)var->sqldata = (int16_t)*(int64_t*)value;
 			}
 			else if (ivType == ivFloat)
@@ -905,8 +1278,15 @@ void RowImpl::SetValue(int varnum, IITYPE ivType, const void* value, int userlen
 				*(int16_t*)var->sqldata =
 					(int16_t)floor(*(double*)value * multiplier + 0.5);
 			}
-			else throw WrongTypeImpl("RowImpl::SetValue",  var->sqltype, ivType,
-										_("Incompatible types."));
+			else if (ivType == ivString && var->sqlscale != 0)
+			{
+				int64_t scaled;
+				if (! ScaledFromString(var, *(std::string*)value, scaled)
+					|| scaled < consts::min16 || scaled > consts::max16)
+					return IBPP::rcOutOfRange;
+				*(int16_t*)var->sqldata = (int16_t)scaled;
+			}
+			else return IBPP::rcWrongType;
 			break;
 
 		case SQL_LONG :
@@ -925,8 +1305,7 @@ void RowImpl::SetValue(int varnum, IITYPE ivType, const void* value, int userlen
 			else if (ivType == ivInt64)
 			{
 				if (*(int64_t*)value < consts::min32 || *(int64_t*)value > consts::max32)
-					throw LogicExceptionImpl("RowImpl::SetValue",
-						_("Out of range numeric conversion !"));
+					return IBPP::rcOutOfRange;
 				*(ISC_LONG*)var->sqldata = (ISC_LONG)*(int64_t*)value;
 			}
 			else if (ivType == ivFloat)
@@ -943,8 +1322,15 @@ void RowImpl::SetValue(int varnum, IITYPE ivType, const void* value, int userlen
 				*(ISC_LONG*)var->sqldata =
 					(ISC_LONG)floor(*(double*)value * multiplier + 0.5);
 			}
-			else throw WrongTypeImpl("RowImpl::SetValue",  var->sqltype, ivType,
-										_("Incompatible types."));
+			else if (ivType == ivString && var->sqlscale != 0)
+			{
+				int64_t scaled;
+				if (! ScaledFromString(var, *(std::string*)value, scaled)
+					|| scaled < consts::min32 || scaled > consts::max32)
+					return IBPP::rcOutOfRange;
+				*(ISC_LONG*)var->sqldata = (ISC_LONG)scaled;
+			}
+			else return IBPP::rcWrongType;
 			break;
 
 		case SQL_INT64 :
@@ -978,21 +1364,24 @@ void RowImpl::SetValue(int varnum, IITYPE ivType, const void* value, int userlen
 				*(int64_t*)var->sqldata =
 					(int64_t)floor(*(double*)value * multiplier + 0.5);
 			}
-			else throw WrongTypeImpl("RowImpl::SetValue", var->sqltype, ivType,
-										_("Incompatible types."));
+			else if (ivType == ivString && var->sqlscale != 0)
+			{
+				if (! ScaledFromString(var, *(std::string*)value,
+						*(int64_t*)var->sqldata))
+					return IBPP::rcOutOfRange;
+			}
+			else return IBPP::rcWrongType;
 			break;
 
 		case SQL_FLOAT :
 			if (ivType != ivFloat || var->sqlscale != 0)
-				throw WrongTypeImpl("RowImpl::SetValue", var->sqltype, ivType,
-									_("Incompatible types."));
+				return IBPP::rcWrongType;
 			*(float*)var->sqldata = *(float*)value;
 			break;
 
 		case SQL_DOUBLE :
 			if (ivType != ivDouble)
-				throw WrongTypeImpl("RowImpl::SetValue", var->sqltype, ivType,
-										_("Incompatible types."));
+				return IBPP::rcWrongType;
 			if (var->sqlscale != 0)
 			{
 				// Round to scale of NUMERIC(x,y)
@@ -1005,22 +1394,19 @@ void RowImpl::SetValue(int varnum, IITYPE ivType, const void* value, int userlen
 
 		case SQL_TIMESTAMP :
 			if (ivType != ivTimestamp)
-				throw WrongTypeImpl("RowImpl::SetValue", var->sqltype, ivType,
-										_("Incompatible types."));
+				return IBPP::rcWrongType;
 			encodeTimestamp(*(ISC_TIMESTAMP*)var->sqldata, *(IBPP::Timestamp*)value);
 			break;
 
 		case SQL_TYPE_DATE :
 			if (ivType != ivDate)
-				throw WrongTypeImpl("RowImpl::SetValue", var->sqltype, ivType,
-										_("Incompatible types."));
+				return IBPP::rcWrongType;
 			encodeDate(*(ISC_DATE*)var->sqldata, *(IBPP::Date*)value);
 			break;
 
 		case SQL_TYPE_TIME :
 			if (ivType != ivTime)
-				throw WrongTypeImpl("RowImpl::SetValue", var->sqltype, ivType,
-											_("Incompatible types."));
+				return IBPP::rcWrongType;
 			encodeTime(*(ISC_TIME*)var->sqldata, *(IBPP::Time*)value);
 			break;
 
@@ -1036,14 +1422,12 @@ void RowImpl::SetValue(int varnum, IITYPE ivType, const void* value, int userlen
 				blob.Save(*(std::string*)value);
 				blob.GetId((ISC_QUAD*)var->sqldata);
 			}
-			else throw WrongTypeImpl("RowImpl::SetValue", var->sqltype, ivType,
-										_("Incompatible types."));
+			else return IBPP::rcWrongType;
 			break;
 
 		case SQL_ARRAY :
 			if (ivType != ivArray)
-				throw WrongTypeImpl("RowImpl::SetValue", var->sqltype, ivType,
-										_("Incompatible types."));
+				return IBPP::rcWrongType;
 			{
 				ArrayImpl* array = (ArrayImpl*)value;
 				array->GetId((ISC_QUAD*)var->sqldata);
@@ -1055,24 +1439,100 @@ void RowImpl::SetValue(int varnum, IITYPE ivType, const void* value, int userlen
 			}
 			break;
 
-		default : throw LogicExceptionImpl("RowImpl::SetValue",
-						_("The field uses an unsupported SQL type !"));
+		case SQL_BOOLEAN :
+			if (ivType == ivBool) var->sqldata[0] = *(bool*)value ? 1 : 0;
+			else if (ivType == ivInt16) var->sqldata[0] = *(int16_t*)value != 0 ? 1 : 0;
+			else if (ivType == ivInt32) var->sqldata[0] = *(int32_t*)value != 0 ? 1 : 0;
+			else if (ivType == ivInt64) var->sqldata[0] = *(int64_t*)value != 0 ? 1 : 0;
+			else return IBPP::rcWrongType;
+			break;
+
+		case SQL_INT128 :
+			{
+				// Integers are stored as is, like for SQL_INT64, the other
+				// types are scaled to the NUMERIC(x,y)
+				IBPP::Int128 i128;
+				if (ivType == ivInt128) i128 = *(IBPP::Int128*)value;
+				else if (ivType == ivBool) i128.SetValue(*(bool*)value ? 1 : 0);
+				else if (ivType == ivInt16) i128.SetValue(*(int16_t*)value);
+				else if (ivType == ivInt32) i128.SetValue(*(int32_t*)value);
+				else if (ivType == ivInt64) i128.SetValue(*(int64_t*)value);
+				else if (ivType == ivFloat)
+				{
+					if (! i128.FromDouble(*(float*)value, -var->sqlscale))
+						return IBPP::rcOutOfRange;
+				}
+				else if (ivType == ivDouble)
+				{
+					if (! i128.FromDouble(*(double*)value, -var->sqlscale))
+						return IBPP::rcOutOfRange;
+				}
+				else if (ivType == ivString)
+				{
+					if (! i128.FromString(*(std::string*)value, -var->sqlscale))
+						return IBPP::rcOutOfRange;
+				}
+				else return IBPP::rcWrongType;
+				encodeInt128(var->sqldata, i128);
+			}
+			break;
+
+		case SQL_DEC16 :
+		case SQL_DEC34 :
+			{
+				const int digits = (var->sqltype & ~1) == SQL_DEC16 ? 16 : 34;
+				bool ok;
+				if (ivType == ivString)
+					ok = encodeDecfloat(var->sqldata, digits, *(std::string*)value);
+				else if (ivType == ivDouble)
+					ok = encodeDecfloat(var->sqldata, digits, *(double*)value);
+				else if (ivType == ivFloat)
+					ok = encodeDecfloat(var->sqldata, digits, (double)*(float*)value);
+				else if (ivType == ivInt16)
+					ok = encodeDecfloat(var->sqldata, digits, IBPP::Int128(*(int16_t*)value).ToString());
+				else if (ivType == ivInt32)
+					ok = encodeDecfloat(var->sqldata, digits, IBPP::Int128(*(int32_t*)value).ToString());
+				else if (ivType == ivInt64)
+					ok = encodeDecfloat(var->sqldata, digits, IBPP::Int128(*(int64_t*)value).ToString());
+				else return IBPP::rcWrongType;
+				if (! ok) return IBPP::rcOutOfRange;
+			}
+			break;
+
+		case SQL_TIMESTAMP_TZ :
+		case SQL_TIMESTAMP_TZ_EX :
+			if (ivType != ivTimestampTz)
+				return IBPP::rcWrongType;
+			encodeTimestampTz(var->sqldata, *(IBPP::TimestampTz*)value,
+				(var->sqltype & ~1) == SQL_TIMESTAMP_TZ_EX);
+			break;
+
+		case SQL_TIME_TZ :
+		case SQL_TIME_TZ_EX :
+			if (ivType != ivTimeTz)
+				return IBPP::rcWrongType;
+			encodeTimeTz(var->sqldata, *(IBPP::TimeTz*)value,
+				(var->sqltype & ~1) == SQL_TIME_TZ_EX);
+			break;
+
+		default : return IBPP::rcWrongType;
 	}
 
 	if (var->sqltype & 1) *var->sqlind = 0;		// Remove the 0 flag
+	return IBPP::rcOk;
 }
 
-void* RowImpl::GetValue(int varnum, IITYPE ivType, void* retvalue)
+IBPP::RSC RowImpl::GetValueRC(int varnum, IITYPE ivType, void*& value, void* retvalue)
 {
 	if (varnum < 1 || varnum > mDescrArea->sqld)
-		throw LogicExceptionImpl("RowImpl::GetValue", _("Variable index out of range."));
+		return IBPP::rcBadIndex;
 
-	void* value;
 	int len;
 	XSQLVAR* var = &(mDescrArea->sqlvar[varnum-1]);
 
 	// When there is no value (SQL NULL)
-	if ((var->sqltype & 1) && *(var->sqlind) != 0) return 0;
+	value = 0;
+	if ((var->sqltype & 1) && *(var->sqlind) != 0) return IBPP::rcNull;
 
 	switch (var->sqltype & ~1)
 	{
@@ -1110,8 +1570,7 @@ void* RowImpl::GetValue(int varnum, IITYPE ivType, void* retvalue)
 				}
 				value = &mBools[varnum-1];
 			}
-			else throw WrongTypeImpl("RowImpl::GetValue", var->sqltype, ivType,
-										_("Incompatible types."));
+			else return IBPP::rcWrongType;
 			break;
 
 		case SQL_VARYING :
@@ -1143,8 +1602,7 @@ void* RowImpl::GetValue(int varnum, IITYPE ivType, void* retvalue)
 				}
 				value = &mBools[varnum-1];
 			}
-			else throw WrongTypeImpl("RowImpl::GetValue", var->sqltype, ivType,
-										_("Incompatible types."));
+			else return IBPP::rcWrongType;
 			break;
 
 		case SQL_SHORT :
@@ -1183,8 +1641,7 @@ void* RowImpl::GetValue(int varnum, IITYPE ivType, void* retvalue)
 				mNumerics[varnum-1] = *(int16_t*)var->sqldata / divisor;
 				value = &mNumerics[varnum-1];
 			}
-			else throw WrongTypeImpl("RowImpl::GetValue", var->sqltype, ivType,
-										_("Incompatible types."));
+			else return IBPP::rcWrongType;
 			break;
 
 		case SQL_LONG :
@@ -1202,8 +1659,7 @@ void* RowImpl::GetValue(int varnum, IITYPE ivType, void* retvalue)
 			{
 				int32_t tmp = *(int32_t*)var->sqldata;
 				if (tmp < consts::min16 || tmp > consts::max16)
-					throw LogicExceptionImpl("RowImpl::GetValue",
-						_("Out of range numeric conversion !"));
+					return IBPP::rcOutOfRange;
 				mInt16s[varnum-1] = (int16_t)tmp;
 				value = &mInt16s[varnum-1];
 			}
@@ -1226,8 +1682,7 @@ void* RowImpl::GetValue(int varnum, IITYPE ivType, void* retvalue)
 				mNumerics[varnum-1] = *(int32_t*)var->sqldata / divisor;
 				value = &mNumerics[varnum-1];
 			}
-			else throw WrongTypeImpl("RowImpl::GetValue", var->sqltype, ivType,
-										_("Incompatible types."));
+			else return IBPP::rcWrongType;
 			break;
 
 		case SQL_INT64 :
@@ -1245,8 +1700,7 @@ void* RowImpl::GetValue(int varnum, IITYPE ivType, void* retvalue)
 			{
 				int64_t tmp = *(int64_t*)var->sqldata;
 				if (tmp < consts::min16 || tmp > consts::max16)
-					throw LogicExceptionImpl("RowImpl::GetValue",
-						_("Out of range numeric conversion !"));
+					return IBPP::rcOutOfRange;
 				mInt16s[varnum-1] = (int16_t)tmp;
 				value = &mInt16s[varnum-1];
 			}
@@ -1254,8 +1708,7 @@ void* RowImpl::GetValue(int varnum, IITYPE ivType, void* retvalue)
 			{
 				int64_t tmp = *(int64_t*)var->sqldata;
 				if (tmp < consts::min32 || tmp > consts::max32)
-					throw LogicExceptionImpl("RowImpl::GetValue",
-						_("Out of range numeric conversion !"));
+					return IBPP::rcOutOfRange;
 				mInt32s[varnum-1] = (int32_t)tmp;
 				value = &mInt32s[varnum-1];
 			}
@@ -1273,21 +1726,18 @@ void* RowImpl::GetValue(int varnum, IITYPE ivType, void* retvalue)
 				mNumerics[varnum-1] = *(int64_t*)var->sqldata / divisor;
 				value = &mNumerics[varnum-1];
 			}
-			else throw WrongTypeImpl("RowImpl::GetValue", var->sqltype, ivType,
-										_("Incompatible types."));
+			else return IBPP::rcWrongType;
 			break;
 
 		case SQL_FLOAT :
 			if (ivType != ivFloat)
-				throw WrongTypeImpl("RowImpl::GetValue", var->sqltype, ivType,
-										_("Incompatible types."));
+				return IBPP::rcWrongType;
 			value = var->sqldata;
 			break;
 
 		case SQL_DOUBLE :
 			if (ivType != ivDouble)
-				throw WrongTypeImpl("RowImpl::GetValue", var->sqltype, ivType,
-										_("Incompatible types."));
+				return IBPP::rcWrongType;
 			if (var->sqlscale != 0)
 			{
 				// Round to scale y of NUMERIC(x,y)
@@ -1301,24 +1751,21 @@ void* RowImpl::GetValue(int varnum, IITYPE ivType, void* retvalue)
 
 		case SQL_TIMESTAMP :
 			if (ivType != ivTimestamp)
-				throw WrongTypeImpl("RowImpl::SetValue", var->sqltype, ivType,
-										_("Incompatible types."));
+				return IBPP::rcWrongType;
 			decodeTimestamp(*(IBPP::Timestamp*)retvalue, *(ISC_TIMESTAMP*)var->sqldata);
 			value = retvalue;
 			break;
 
 		case SQL_TYPE_DATE :
 			if (ivType != ivDate)
-				throw WrongTypeImpl("RowImpl::SetValue", var->sqltype, ivType,
-										_("Incompatible types."));
+				return IBPP::rcWrongType;
 			decodeDate(*(IBPP::Date*)retvalue, *(ISC_DATE*)var->sqldata);
 			value = retvalue;
 			break;
 
 		case SQL_TYPE_TIME :
 			if (ivType != ivTime)
-				throw WrongTypeImpl("RowImpl::SetValue", var->sqltype, ivType,
-										_("Incompatible types."));
+				return IBPP::rcWrongType;
 			decodeTime(*(IBPP::Time*)retvalue, *(ISC_TIME*)var->sqldata);
 			value = retvalue;
 			break;
@@ -1338,14 +1785,12 @@ void* RowImpl::GetValue(int varnum, IITYPE ivType, void* retvalue)
 				blob.Load(*str);
 				value = retvalue;
 			}
-			else throw WrongTypeImpl("RowImpl::GetValue", var->sqltype, ivType,
-										_("Incompatible types."));
+			else return IBPP::rcWrongType;
 			break;
 			
 		case SQL_ARRAY :
 			if (ivType != ivArray)
-				throw WrongTypeImpl("RowImpl::GetValue", var->sqltype, ivType,
-											_("Incompatible types."));
+				return IBPP::rcWrongType;
 			{
 				ArrayImpl* array = (ArrayImpl*)retvalue;
 				array->SetId((ISC_QUAD*)var->sqldata);
@@ -1353,11 +1798,120 @@ void* RowImpl::GetValue(int varnum, IITYPE ivType, void* retvalue)
 			}
 			break;
 
-		default : throw LogicExceptionImpl("RowImpl::GetValue",
-						_("Found an unknown sqltype !"));
+		case SQL_BOOLEAN :
+			if (ivType != ivBool)
+				return IBPP::rcWrongType;
+			mBools[varnum-1] = var->sqldata[0] != 0 ? 1 : 0;
+			value = &mBools[varnum-1];
+			break;
+
+		case SQL_INT128 :
+			{
+				IBPP::Int128 i128;
+				decodeInt128(i128, var->sqldata);
+				if (ivType == ivInt128)
+				{
+					*(IBPP::Int128*)retvalue = i128;
+					value = retvalue;
+				}
+				else if (ivType == ivString)
+				{
+					*(std::string*)retvalue = i128.ToString(-var->sqlscale);
+					value = retvalue;
+				}
+				else if (ivType == ivBool)
+				{
+					mBools[varnum-1] = i128 != IBPP::Int128() ? 1 : 0;
+					value = &mBools[varnum-1];
+				}
+				else if (ivType == ivInt16 || ivType == ivInt32 || ivType == ivInt64)
+				{
+					if (! i128.FitsInt64())
+						return IBPP::rcOutOfRange;
+					int64_t tmp = (int64_t)i128.Low();
+					if (ivType == ivInt64)
+					{
+						mInt64s[varnum-1] = tmp;
+						value = &mInt64s[varnum-1];
+					}
+					else if (ivType == ivInt32)
+					{
+						if (tmp < consts::min32 || tmp > consts::max32)
+							return IBPP::rcOutOfRange;
+						mInt32s[varnum-1] = (int32_t)tmp;
+						value = &mInt32s[varnum-1];
+					}
+					else
+					{
+						if (tmp < consts::min16 || tmp > consts::max16)
+							return IBPP::rcOutOfRange;
+						mInt16s[varnum-1] = (int16_t)tmp;
+						value = &mInt16s[varnum-1];
+					}
+				}
+				else if (ivType == ivFloat)
+				{
+					// This SQL_INT128 is a NUMERIC(x,y), scale it !
+					mFloats[varnum-1] = (float)i128.ToDouble(-var->sqlscale);
+					value = &mFloats[varnum-1];
+				}
+				else if (ivType == ivDouble)
+				{
+					// This SQL_INT128 is a NUMERIC(x,y), scale it !
+					mNumerics[varnum-1] = i128.ToDouble(-var->sqlscale);
+					value = &mNumerics[varnum-1];
+				}
+				else return IBPP::rcWrongType;
+			}
+			break;
+
+		case SQL_DEC16 :
+		case SQL_DEC34 :
+			{
+				const int digits = (var->sqltype & ~1) == SQL_DEC16 ? 16 : 34;
+				if (ivType == ivString)
+				{
+					decodeDecfloat(*(std::string*)retvalue, var->sqldata, digits);
+					value = retvalue;
+				}
+				else if (ivType == ivDouble)
+				{
+					decodeDecfloat(mNumerics[varnum-1], var->sqldata, digits);
+					value = &mNumerics[varnum-1];
+				}
+				else if (ivType == ivFloat)
+				{
+					double tmp;
+					decodeDecfloat(tmp, var->sqldata, digits);
+					mFloats[varnum-1] = (float)tmp;
+					value = &mFloats[varnum-1];
+				}
+				else return IBPP::rcWrongType;
+			}
+			break;
+
+		case SQL_TIMESTAMP_TZ :
+		case SQL_TIMESTAMP_TZ_EX :
+			if (ivType != ivTimestampTz)
+				return IBPP::rcWrongType;
+			decodeTimestampTz(*(IBPP::TimestampTz*)retvalue, var->sqldata,
+				(var->sqltype & ~1) == SQL_TIMESTAMP_TZ_EX);
+			value = retvalue;
+			break;
+
+		case SQL_TIME_TZ :
+		case SQL_TIME_TZ_EX :
+			if (ivType != ivTimeTz)
+				return IBPP::rcWrongType;
+			decodeTimeTz(*(IBPP::TimeTz*)retvalue, var->sqldata,
+				(var->sqltype & ~1) == SQL_TIME_TZ_EX);
+			value = retvalue;
+			break;
+
+		default : return IBPP::rcWrongType;
 	}
 
-	return value;
+	return IBPP::rcOk;
 }
 
 void RowImpl::Free()
@@ -1377,7 +1931,15 @@ void RowImpl::Free()
 					case SQL_TYPE_TIME :delete (ISC_TIME*) var->sqldata; break;
 					case SQL_TYPE_DATE :delete (ISC_DATE*) var->sqldata; break;
 					case SQL_TEXT :
-					case SQL_VARYING :	delete [] var->sqldata; break;
+					case SQL_VARYING :
+					case SQL_BOOLEAN :
+					case SQL_INT128 :
+					case SQL_DEC16 :
+					case SQL_DEC34 :
+					case SQL_TIMESTAMP_TZ :
+					case SQL_TIMESTAMP_TZ_EX :
+					case SQL_TIME_TZ :
+					case SQL_TIME_TZ_EX :	delete [] var->sqldata; break;
 					case SQL_SHORT :	delete (int16_t*) var->sqldata; break;
 					case SQL_LONG :		delete (int32_t*) var->sqldata; break;
 					case SQL_INT64 :	delete (int64_t*) var->sqldata; break;
@@ -1474,6 +2036,17 @@ void RowImpl::AllocVariables()
 			case SQL_INT64 :	var->sqldata = (char*) new int64_t(0); break;
 			case SQL_FLOAT : 	var->sqldata = (char*) new float(0.0); break;
 			case SQL_DOUBLE :	var->sqldata = (char*) new double(0.0); break;
+			case SQL_BOOLEAN :
+			case SQL_INT128 :
+			case SQL_DEC16 :
+			case SQL_DEC34 :
+			case SQL_TIMESTAMP_TZ :
+			case SQL_TIMESTAMP_TZ_EX :
+			case SQL_TIME_TZ :
+			case SQL_TIME_TZ_EX :	// Binary values, of sqllen bytes
+								var->sqldata = new char[var->sqllen];
+								memset(var->sqldata, 0, var->sqllen);
+								break;
 			default : throw LogicExceptionImpl("RowImpl::AllocVariables",
 						_("Found an unknown sqltype !"));
 		}
@@ -1530,6 +2103,16 @@ RowImpl& RowImpl::operator=(const RowImpl& copied)
 			case SQL_INT64 :	var->sqldata = (char*) new int64_t(*(int64_t*)org->sqldata); break;
 			case SQL_FLOAT : 	var->sqldata = (char*) new float(*(float*)org->sqldata); break;
 			case SQL_DOUBLE :	var->sqldata = (char*) new double(*(double*)org->sqldata); break;
+			case SQL_BOOLEAN :
+			case SQL_INT128 :
+			case SQL_DEC16 :
+			case SQL_DEC34 :
+			case SQL_TIMESTAMP_TZ :
+			case SQL_TIMESTAMP_TZ_EX :
+			case SQL_TIME_TZ :
+			case SQL_TIME_TZ_EX :	var->sqldata = new char[var->sqllen];
+								memcpy(var->sqldata, org->sqldata, var->sqllen);
+								break;
 			default : throw LogicExceptionImpl("RowImpl::Ctor",
 						_("Found an unknown sqltype !"));
 		}
@@ -232,6 +232,17 @@ void StatementImpl::Prepare(const std::string& sql)
 
 	// Allocates variables of the output descriptor
 	if (mOutRow != 0) mOutRow->AllocVariables();
+
+	// On the attachments of the OO API the statement is executed and fetched
+	// through the IStatement behind mHandle, unless its messages differ
+	if (mDatabase->GetInterface() != 0)
+	{
+		mOO = new OOStatement;
+		bool bound = false;
+		try { bound = mOO->Bind(&mHandle, mInRow, mOutRow); }
+		catch (...) { Close(); throw; }
+		if (! bound) { delete mOO; mOO = 0; }
+	}
 }
 
 void StatementImpl::Plan(std::string& plan)
@@ -272,40 +283,181 @@ void StatementImpl::Execute(const std::string& sql)
 	CursorFree();	// Free a previous 'cursor' if any
 
 	IBS status;
-	if (mType == IBPP::stSelect)
+	if (! ExecuteStatus(status))
 	{
-		// Could return a result set (none, single or multi rows)
-		(*gds.Call()->m_dsql_execute)(status.Self(), mTransaction->GetHandlePtr(),
-			&mHandle, 1, mInRow == 0 ? 0 : mInRow->Self());
-		if (status.Errors())
-		{
-			//Close();	Commented because Execute error should not free the statement
-			std::string context = "Statement::Execute( ";
-			context.append(mSql).append(" )");
-			throw SQLExceptionImpl(status, context.c_str(),
-				_("isc_dsql_execute failed"));
-		}
-		if (mOutRow != 0)
-		{
-			mResultSetAvailable = true;
-			mCursorOpened = true;
-		}
+		//Close();	Commented because Execute error should not free the statement
+		std::string context = "Statement::Execute( ";
+		context.append(mSql).append(" )");
+		throw SQLExceptionImpl(status, context.c_str(), mType == IBPP::stSelect ?
+			_("isc_dsql_execute failed") : _("isc_dsql_execute2 failed"));
 	}
-	else
+}
+
+IBPP::RSC StatementImpl::TryExecute()
+{
+	mLastStatus.Reset();
+
+	if (mHandle == 0) return IBPP::rcNotReady;
+	if (mInRow != 0 && mInRow->MissingValues()) return IBPP::rcNotReady;
+
+	CursorFree();	// Free a previous 'cursor' if any
+
+	return ExecuteStatus(mLastStatus) ? IBPP::rcOk : IBPP::rcSQLError;
+}
+
+int StatementImpl::LastSqlCode()
+{
+	return mLastStatus.Errors() ? mLastStatus.SqlCode() : 0;
+}
+
+int StatementImpl::LastEngineCode()
+{
+	return mLastStatus.Errors() ? mLastStatus.EngineCode() : 0;
+}
+
+const char* StatementImpl::LastErrorMessage()
+{
+	return mLastStatus.Errors() ? mLastStatus.ErrorMessage() : "";
+}
+
+void StatementImpl::AddBatch()
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::AddBatch",
+			_("No statement has been prepared."));
+	if (mInRow == 0)
+		throw LogicExceptionImpl("Statement::AddBatch",
+			_("The statement has no parameters."));
+	if (mInRow->MissingValues())
+		throw LogicExceptionImpl("Statement::AddBatch",
+			_("All parameters must be specified."));
+
+	if (mOO != 0 && mOO->Batchable())
 	{
-		// Should return at most a single row
-		(*gds.Call()->m_dsql_execute2)(status.Self(), mTransaction->GetHandlePtr(),
-			&mHandle, 1, mInRow == 0 ? 0 : mInRow->Self(),
-			mOutRow == 0 ? 0 : mOutRow->Self());
-		if (status.Errors())
+		mOO->AddBatch(mInRow);
+		return;
+	}
+
+	// A copy of the parameter values, sent by ExecuteBatch()
+	RowImpl* row = new RowImpl(*mInRow);
+	row->AddRef();
+	mBatch.push_back(row);
+}
+
+int StatementImpl::ExecuteBatch()
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::ExecuteBatch",
+			_("No statement has been prepared."));
+
+	if (mOO != 0 && mOO->Batchable())
+	{
+		CursorFree();
+		return mOO->ExecuteBatch(mTransaction->GetInterface());
+	}
+
+	// The queued rows are executed one after the other, the legacy API
+	// having no batches. The queue is emptied, even when a row fails.
+	int rows = 0;
+	RowImpl* current = mInRow;
+	try
+	{
+		for (size_t i = 0; i < mBatch.size(); i++)
 		{
-			//Close();	Commented because Execute error should not free the statement
-			std::string context = "Statement::Execute( ";
-			context.append(mSql).append(" )");
-			throw SQLExceptionImpl(status, context.c_str(),
-				_("isc_dsql_execute2 failed"));
+			CursorFree();
+			mInRow = mBatch[i];
+			IBS status;
+			if (! ExecuteStatus(status))
+				throw SQLExceptionImpl(status, "Statement::ExecuteBatch",
+					_("isc_dsql_execute2 failed"));
+			rows += AffectedRows();
 		}
 	}
+	catch (...)
+	{
+		mInRow = current;
+		BatchFree();
+		throw;
+	}
+	mInRow = current;
+	BatchFree();
+	return rows;
+}
+
+bool StatementImpl::ServerBatch()
+{
+	return mOO != 0 && mOO->Batchable();
+}
+
+void StatementImpl::SetTimeout(unsigned msecs)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::SetTimeout",
+			_("No statement has been prepared."));
+	if (mOO == 0)
+		throw LogicExceptionImpl("Statement::SetTimeout",
+			_("Statement timeouts need an attachment of the OO API."));
+
+	mOO->SetTimeout(msecs);
+}
+
+void StatementImpl::ExecuteScrollable()
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::ExecuteScrollable",
+			_("No statement has been prepared."));
+	if (mType != IBPP::stSelect || mOutRow == 0)
+		throw LogicExceptionImpl("Statement::ExecuteScrollable",
+			_("Only a SELECT statement can have a scrollable cursor."));
+	if (mOO == 0)
+		throw LogicExceptionImpl("Statement::ExecuteScrollable",
+			_("Scrollable cursors need an attachment of the OO API."));
+
+	// Check that a value has been set for each input parameter
+	if (mInRow != 0 && mInRow->MissingValues())
+		throw LogicExceptionImpl("Statement::ExecuteScrollable",
+			_("All parameters must be specified."));
+
+	CursorFree();	// Free a previous 'cursor' if any
+
+	IBS status;
+	if (! mOO->Execute(status, mTransaction->GetInterface(), mInRow, mOutRow, true, true))
+	{
+		std::string context = "Statement::ExecuteScrollable( ";
+		context.append(mSql).append(" )");
+		throw SQLExceptionImpl(status, context.c_str(), _("IStatement::openCursor failed"));
+	}
+	mResultSetAvailable = true;
+}
+
+bool StatementImpl::Scrollable()
+{
+	return mOO != 0 && mOO->Scrollable();
+}
+
+bool StatementImpl::FetchPrior()
+{
+	return ScrollFetch(OOStatement::mvPrior, 0, "Statement::FetchPrior");
+}
+
+bool StatementImpl::FetchFirst()
+{
+	return ScrollFetch(OOStatement::mvFirst, 0, "Statement::FetchFirst");
+}
+
+bool StatementImpl::FetchLast()
+{
+	return ScrollFetch(OOStatement::mvLast, 0, "Statement::FetchLast");
+}
+
+bool StatementImpl::FetchAbsolute(int position)
+{
+	return ScrollFetch(OOStatement::mvAbsolute, position, "Statement::FetchAbsolute");
+}
+
+bool StatementImpl::FetchRelative(int offset)
+{
+	return ScrollFetch(OOStatement::mvRelative, offset, "Statement::FetchRelative");
 }
 
 void StatementImpl::CursorExecute(const std::string& cursor, const std::string& sql)
@@ -369,6 +521,7 @@ void StatementImpl::ExecuteImmediate(const std::string& sql)
 
 	IBS status;
 	Close();
+	mTransaction->ForgetArrayDescs();	// Could be DDL
     (*gds.Call()->m_dsql_execute_immediate)(status.Self(), mDatabase->GetHandlePtr(),
     	mTransaction->GetHandlePtr(), 0, const_cast<char*>(sql.c_str()),
     		short(mDatabase->Dialect()), 0);
@@ -391,6 +544,29 @@ int StatementImpl::AffectedRows()
 		throw LogicExceptionImpl("Statement::AffectedRows", _("Database must be connected."));
 
 	int count;
+	if (mType == IBPP::stInsert)
+			RecordCounts(0, &count, 0, 0);
+	else if (mType == IBPP::stUpdate)
+			RecordCounts(0, 0, &count, 0);
+	else if (mType == IBPP::stDelete)
+			RecordCounts(0, 0, 0, &count);
+	else if (mType == IBPP::stSelect)
+			RecordCounts(&count, 0, 0, 0);
+	else	count = 0;	// Returns zero count for unknown cases
+
+	return count;
+}
+
+//	The four record counts of the last execution, in one isc_dsql_sql_info call
+void StatementImpl::RecordCounts(int* Select, int* Insert, int* Update, int* Delete)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::RecordCounts", _("No statement has been prepared."));
+	if (mDatabase == 0)
+		throw LogicExceptionImpl("Statement::RecordCounts", _("A Database must be attached."));
+	if (mDatabase->GetHandle() == 0)
+		throw LogicExceptionImpl("Statement::RecordCounts", _("Database must be connected."));
+
 	IBS status;
 	RB result;
 	char itemsReq[] = {isc_info_sql_records};
@@ -398,19 +574,16 @@ int StatementImpl::AffectedRows()
 	(*gds.Call()->m_dsql_sql_info)(status.Self(), &mHandle, 1, itemsReq,
 		result.Size(), result.Self());
 	if (status.Errors()) throw SQLExceptionImpl(status,
-			"Statement::AffectedRows", _("isc_dsql_sql_info failed."));
-
-	if (mType == IBPP::stInsert)
-			count = result.GetValue(isc_info_sql_records, isc_info_req_insert_count);
-	else if (mType == IBPP::stUpdate)
-			count = result.GetValue(isc_info_sql_records, isc_info_req_update_count);
-	else if (mType == IBPP::stDelete)
-			count = result.GetValue(isc_info_sql_records, isc_info_req_delete_count);
-	else if (mType == IBPP::stSelect)
-			count = result.GetValue(isc_info_sql_records, isc_info_req_select_count);
-	else	count = 0;	// Returns zero count for unknown cases
+			"Statement::RecordCounts", _("isc_dsql_sql_info failed."));
 
-	return count;
+	if (Select != 0)
+		*Select = result.GetValue(isc_info_sql_records, isc_info_req_select_count);
+	if (Insert != 0)
+		*Insert = result.GetValue(isc_info_sql_records, isc_info_req_insert_count);
+	if (Update != 0)
+		*Update = result.GetValue(isc_info_sql_records, isc_info_req_update_count);
+	if (Delete != 0)
+		*Delete = result.GetValue(isc_info_sql_records, isc_info_req_delete_count);
 }
 
 bool StatementImpl::Fetch()
@@ -419,14 +592,19 @@ bool StatementImpl::Fetch()
 		throw LogicExceptionImpl("Statement::Fetch",
 			_("No statement has been executed or no result set available."));
 
+	if (Scrollable())
+		return ScrollFetch(OOStatement::mvNext, 0, "Statement::Fetch");
+
 	IBS status;
-	int code = (*gds.Call()->m_dsql_fetch)(status.Self(), &mHandle, 1, mOutRow->Self());
+	bool oo = mOO != 0 && mOO->CursorOpened();
+	int code = oo ? mOO->Fetch(status, mOutRow)
+		: (*gds.Call()->m_dsql_fetch)(status.Self(), &mHandle, 1, mOutRow->Self());
 	if (code == 100)	// This special code means "no more rows"
 	{
 		mResultSetAvailable = false;
 		// Oddly enough, fetching rows up to the last one seems to open
 		// an 'implicit' cursor that needs to be closed.
-		mCursorOpened = true;
+		if (! oo) mCursorOpened = true;
 		CursorFree();	// Free the explicit or implicit cursor/result-set
 		return false;
 	}
@@ -434,7 +612,7 @@ bool StatementImpl::Fetch()
 	{
 		Close();
 		throw SQLExceptionImpl(status, "Statement::Fetch",
-			_("isc_dsql_fetch failed."));
+			oo ? _("IResultSet::fetchNext failed.") : _("isc_dsql_fetch failed."));
 	}
 
 	return true;
@@ -450,14 +628,20 @@ bool StatementImpl::Fetch(IBPP::Row& row)
 	row = rowimpl;
 
 	IBS status;
-	int code = (*gds.Call()->m_dsql_fetch)(status.Self(), &mHandle, 1,
-					rowimpl->Self());
+	bool oo = mOO != 0 && mOO->CursorOpened();
+	int code = oo ? mOO->Fetch(status, rowimpl)
+		: (*gds.Call()->m_dsql_fetch)(status.Self(), &mHandle, 1, rowimpl->Self());
+	if (code == 100 && Scrollable())
+	{
+		row.clear();	// Past the last row, the cursor stays open
+		return false;
+	}
 	if (code == 100)	// This special code means "no more rows"
 	{
 		mResultSetAvailable = false;
 		// Oddly enough, fetching rows up to the last one seems to open
 		// an 'implicit' cursor that needs to be closed.
-		mCursorOpened = true;
+		if (! oo) mCursorOpened = true;
 		CursorFree();	// Free the explicit or implicit cursor/result-set
 		row.clear();
 		return false;
@@ -467,7 +651,7 @@ bool StatementImpl::Fetch(IBPP::Row& row)
 		Close();
 		row.clear();
 		throw SQLExceptionImpl(status, "Statement::Fetch(row)",
-			_("isc_dsql_fetch failed."));
+			oo ? _("IResultSet::fetchNext failed.") : _("isc_dsql_fetch failed."));
 	}
 
 	return true;
@@ -478,6 +662,9 @@ void StatementImpl::Close()
 	// Free all statement resources.
 	// Used before preparing a new statement or from destructor.
 
+	BatchFree();
+	if (mOO != 0) { delete mOO; mOO = 0; }
+
 	if (mInRow != 0) { mInRow->Release(); mInRow = 0; }
 	if (mOutRow != 0) { mOutRow->Release(); mOutRow = 0; }
 
@@ -626,6 +813,36 @@ void StatementImpl::Set(int param, const IBPP::Time& value)
 	mInRow->Set(param, value);
 }
 
+void StatementImpl::Set(int param, const IBPP::Int128& value)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::Set[Int128]", _("No statement has been prepared."));
+	if (mInRow == 0)
+		throw LogicExceptionImpl("Statement::Set[Int128]", _("The statement does not take parameters."));
+
+	mInRow->Set(param, value);
+}
+
+void StatementImpl::Set(int param, const IBPP::TimestampTz& value)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::Set[TimestampTz]", _("No statement has been prepared."));
+	if (mInRow == 0)
+		throw LogicExceptionImpl("Statement::Set[TimestampTz]", _("The statement does not take parameters."));
+
+	mInRow->Set(param, value);
+}
+
+void StatementImpl::Set(int param, const IBPP::TimeTz& value)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::Set[TimeTz]", _("No statement has been prepared."));
+	if (mInRow == 0)
+		throw LogicExceptionImpl("Statement::Set[TimeTz]", _("The statement does not take parameters."));
+
+	mInRow->Set(param, value);
+}
+
 void StatementImpl::Set(int param, const IBPP::Blob& blob)
 {
 	if (mHandle == 0)
@@ -832,6 +1049,30 @@ bool StatementImpl::Get(int column, IBPP::Time& time)
 	return mOutRow->Get(column, time);
 }
 
+bool StatementImpl::Get(int column, IBPP::Int128& value)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(column, value);
+}
+
+bool StatementImpl::Get(int column, IBPP::TimestampTz& timestamp)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(column, timestamp);
+}
+
+bool StatementImpl::Get(int column, IBPP::TimeTz& time)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(column, time);
+}
+
 bool StatementImpl::Get(int column, IBPP::Blob& blob)
 {
 	if (mOutRow == 0)
@@ -856,6 +1097,209 @@ bool StatementImpl::Get(int column, IBPP::Array& array)
 	return mOutRow->Get(column, array);
 }
 
+IBPP::RSC StatementImpl::TrySetNull(int param)
+{
+	if (mHandle == 0 || mInRow == 0) return IBPP::rcNotReady;
+
+	return mInRow->TrySetNull(param);
+}
+
+IBPP::RSC StatementImpl::TrySet(int param, bool value)
+{
+	if (mHandle == 0 || mInRow == 0) return IBPP::rcNotReady;
+
+	return mInRow->TrySet(param, value);
+}
+
+IBPP::RSC StatementImpl::TrySet(int param, const std::string& s)
+{
+	if (mHandle == 0 || mInRow == 0) return IBPP::rcNotReady;
+
+	return mInRow->TrySet(param, s);
+}
+
+IBPP::RSC StatementImpl::TrySet(int param, int16_t value)
+{
+	if (mHandle == 0 || mInRow == 0) return IBPP::rcNotReady;
+
+	return mInRow->TrySet(param, value);
+}
+
+IBPP::RSC StatementImpl::TrySet(int param, int32_t value)
+{
+	if (mHandle == 0 || mInRow == 0) return IBPP::rcNotReady;
+
+	return mInRow->TrySet(param, value);
+}
+
+IBPP::RSC StatementImpl::TrySet(int param, int64_t value)
+{
+	if (mHandle == 0 || mInRow == 0) return IBPP::rcNotReady;
+
+	return mInRow->TrySet(param, value);
+}
+
+IBPP::RSC StatementImpl::TrySet(int param, float value)
+{
+	if (mHandle == 0 || mInRow == 0) return IBPP::rcNotReady;
+
+	return mInRow->TrySet(param, value);
+}
+
+IBPP::RSC StatementImpl::TrySet(int param, double value)
+{
+	if (mHandle == 0 || mInRow == 0) return IBPP::rcNotReady;
+
+	return mInRow->TrySet(param, value);
+}
+
+IBPP::RSC StatementImpl::TrySet(int param, const IBPP::Timestamp& value)
+{
+	if (mHandle == 0 || mInRow == 0) return IBPP::rcNotReady;
+
+	return mInRow->TrySet(param, value);
+}
+
+IBPP::RSC StatementImpl::TrySet(int param, const IBPP::Date& value)
+{
+	if (mHandle == 0 || mInRow == 0) return IBPP::rcNotReady;
+
+	return mInRow->TrySet(param, value);
+}
+
+IBPP::RSC StatementImpl::TrySet(int param, const IBPP::Time& value)
+{
+	if (mHandle == 0 || mInRow == 0) return IBPP::rcNotReady;
+
+	return mInRow->TrySet(param, value);
+}
+
+IBPP::RSC StatementImpl::TrySet(int param, const IBPP::Int128& value)
+{
+	if (mHandle == 0 || mInRow == 0) return IBPP::rcNotReady;
+
+	return mInRow->TrySet(param, value);
+}
+
+IBPP::RSC StatementImpl::TrySet(int param, const IBPP::TimestampTz& value)
+{
+	if (mHandle == 0 || mInRow == 0) return IBPP::rcNotReady;
+
+	return mInRow->TrySet(param, value);
+}
+
+IBPP::RSC StatementImpl::TrySet(int param, const IBPP::TimeTz& value)
+{
+	if (mHandle == 0 || mInRow == 0) return IBPP::rcNotReady;
+
+	return mInRow->TrySet(param, value);
+}
+
+IBPP::RSC StatementImpl::TrySet(int param, const IBPP::Blob& blob)
+{
+	if (mHandle == 0 || mInRow == 0) return IBPP::rcNotReady;
+
+	return mInRow->TrySet(param, blob);
+}
+
+IBPP::RSC StatementImpl::TryGet(int column, bool& retvalue)
+{
+	if (mOutRow == 0) return IBPP::rcNotReady;
+
+	return mOutRow->TryGet(column, retvalue);
+}
+
+IBPP::RSC StatementImpl::TryGet(int column, std::string& retvalue)
+{
+	if (mOutRow == 0) return IBPP::rcNotReady;
+
+	return mOutRow->TryGet(column, retvalue);
+}
+
+IBPP::RSC StatementImpl::TryGet(int column, int16_t& retvalue)
+{
+	if (mOutRow == 0) return IBPP::rcNotReady;
+
+	return mOutRow->TryGet(column, retvalue);
+}
+
+IBPP::RSC StatementImpl::TryGet(int column, int32_t& retvalue)
+{
+	if (mOutRow == 0) return IBPP::rcNotReady;
+
+	return mOutRow->TryGet(column, retvalue);
+}
+
+IBPP::RSC StatementImpl::TryGet(int column, int64_t& retvalue)
+{
+	if (mOutRow == 0) return IBPP::rcNotReady;
+
+	return mOutRow->TryGet(column, retvalue);
+}
+
+IBPP::RSC StatementImpl::TryGet(int column, float& retvalue)
+{
+	if (mOutRow == 0) return IBPP::rcNotReady;
+
+	return mOutRow->TryGet(column, retvalue);
+}
+
+IBPP::RSC StatementImpl::TryGet(int column, double& retvalue)
+{
+	if (mOutRow == 0) return IBPP::rcNotReady;
+
+	return mOutRow->TryGet(column, retvalue);
+}
+
+IBPP::RSC StatementImpl::TryGet(int column, IBPP::Timestamp& timestamp)
+{
+	if (mOutRow == 0) return IBPP::rcNotReady;
+
+	return mOutRow->TryGet(column, timestamp);
+}
+
+IBPP::RSC StatementImpl::TryGet(int column, IBPP::Date& date)
+{
+	if (mOutRow == 0) return IBPP::rcNotReady;
+
+	return mOutRow->TryGet(column, date);
+}
+
+IBPP::RSC StatementImpl::TryGet(int column, IBPP::Time& time)
+{
+	if (mOutRow == 0) return IBPP::rcNotReady;
+
+	return mOutRow->TryGet(column, time);
+}
+
+IBPP::RSC StatementImpl::TryGet(int column, IBPP::Int128& value)
+{
+	if (mOutRow == 0) return IBPP::rcNotReady;
+
+	return mOutRow->TryGet(column, value);
+}
+
+IBPP::RSC StatementImpl::TryGet(int column, IBPP::TimestampTz& timestamp)
+{
+	if (mOutRow == 0) return IBPP::rcNotReady;
+
+	return mOutRow->TryGet(column, timestamp);
+}
+
+IBPP::RSC StatementImpl::TryGet(int column, IBPP::TimeTz& time)
+{
+	if (mOutRow == 0) return IBPP::rcNotReady;
+
+	return mOutRow->TryGet(column, time);
+}
+
+IBPP::RSC StatementImpl::TryGet(int column, IBPP::Blob& blob)
+{
+	if (mOutRow == 0) return IBPP::rcNotReady;
+
+	return mOutRow->TryGet(column, blob);
+}
+
 /*
 const IBPP::Value StatementImpl::Get(int column)
 {
@@ -1030,6 +1474,30 @@ bool StatementImpl::Get(const std::string& name, IBPP::Time& retvalue)
 	return mOutRow->Get(name, retvalue);
 }
 
+bool StatementImpl::Get(const std::string& name, IBPP::Int128& retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(name, retvalue);
+}
+
+bool StatementImpl::Get(const std::string& name, IBPP::TimestampTz& retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(name, retvalue);
+}
+
+bool StatementImpl::Get(const std::string& name, IBPP::TimeTz& retvalue)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(name, retvalue);
+}
+
 bool StatementImpl::Get(const std::string&name, IBPP::Blob& retblob)
 {
 	if (mOutRow == 0)
@@ -1144,6 +1612,26 @@ int StatementImpl::ColumnScale(int varnum)
 	return mOutRow->ColumnScale(varnum);
 }
 
+const char* StatementImpl::ParameterName(int varnum)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::ParameterName", _("No statement has been prepared."));
+	if (mInRow == 0)
+		throw LogicExceptionImpl("Statement::ParameterName", _("The statement uses no parameters."));
+
+	return mInRow->ColumnName(varnum);
+}
+
+const char* StatementImpl::ParameterTable(int varnum)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::ParameterTable", _("No statement has been prepared."));
+	if (mInRow == 0)
+		throw LogicExceptionImpl("Statement::ParameterTable", _("The statement uses no parameters."));
+
+	return mInRow->ColumnTable(varnum);
+}
+
 int StatementImpl::Parameters()
 {
 	if (mHandle == 0)
@@ -1216,8 +1704,7 @@ void StatementImpl::Release()
 {
 	// Release cannot throw, except in DEBUG builds on assertion
 	ASSERTION(mRefCount >= 0);
-	--mRefCount;
-	try { if (mRefCount <= 0) delete this; }
+	try { if (--mRefCount <= 0) delete this; }
 		catch (...) { }
 }
 
@@ -1263,8 +1750,80 @@ void StatementImpl::DetachTransactionImpl()
 	mTransaction = 0;
 }
 
+//	Moves the scrollable cursor opened by ExecuteScrollable(). Leaving the
+//	result set doesn't close it.
+
+bool StatementImpl::ScrollFetch(OOStatement::Move move, int position, const char* context)
+{
+	if (! mResultSetAvailable || ! Scrollable())
+		throw LogicExceptionImpl(context,
+			_("No statement has been executed with a scrollable cursor."));
+
+	IBS status;
+	int code = mOO->Fetch(status, mOutRow, move, position);
+	if (code == 100) return false;
+	if (status.Errors())
+	{
+		Close();
+		throw SQLExceptionImpl(status, context, _("IResultSet fetch failed."));
+	}
+	return true;
+}
+
+//	Executes the prepared statement, errors are left in status
+
+bool StatementImpl::ExecuteStatus(IBS& status)
+{
+	if (mType == IBPP::stDDL) mTransaction->ForgetArrayDescs();
+
+	if (mOO != 0)
+	{
+		bool cursor = (mType == IBPP::stSelect && mOutRow != 0);
+		if (! mOO->Execute(status, mTransaction->GetInterface(), mInRow, mOutRow, cursor))
+			return false;
+		if (cursor) mResultSetAvailable = true;
+		return true;
+	}
+
+	if (mType == IBPP::stSelect)
+	{
+		// Could return a result set (none, single or multi rows)
+		(*gds.Call()->m_dsql_execute)(status.Self(), mTransaction->GetHandlePtr(),
+			&mHandle, 1, mInRow == 0 ? 0 : mInRow->Self());
+		if (status.Errors()) return false;
+		if (mOutRow != 0)
+		{
+			mResultSetAvailable = true;
+			mCursorOpened = true;
+		}
+	}
+	else
+	{
+		// Should return at most a single row
+		(*gds.Call()->m_dsql_execute2)(status.Self(), mTransaction->GetHandlePtr(),
+			&mHandle, 1, mInRow == 0 ? 0 : mInRow->Self(),
+			mOutRow == 0 ? 0 : mOutRow->Self());
+		if (status.Errors()) return false;
+	}
+	return true;
+}
+
+void StatementImpl::BatchFree()
+{
+	for (size_t i = 0; i < mBatch.size(); i++)
+		mBatch[i]->Release();
+	mBatch.clear();
+}
+
 void StatementImpl::CursorFree()
 {
+	if (mOO != 0 && mOO->CursorOpened())
+	{
+		// The OO API cursor is not known to the legacy handle
+		mOO->CloseCursor();
+		mResultSetAvailable = false;
+	}
+
 	if (mCursorOpened)
 	{
 		mCursorOpened = false;
@@ -1283,7 +1842,8 @@ StatementImpl::StatementImpl(DatabaseImpl* database, TransactionImpl* transactio
 	const std::string& sql)
 	: mRefCount(0), mHandle(0), mDatabase(0), mTransaction(0),
 	mInRow(0), mOutRow(0),
-	mResultSetAvailable(false), mCursorOpened(false), mType(IBPP::stUnknown)
+	mResultSetAvailable(false), mCursorOpened(false), mType(IBPP::stUnknown),
+	mOO(0)
 {
 	AttachDatabaseImpl(database);
 	if (transaction != 0) AttachTransactionImpl(transaction);
@@ -112,6 +112,24 @@ void TransactionImpl::AddReservation(IBPP::Database db,
 			_("The database connection you specified is not attached to this transaction."));
 }
 
+void TransactionImpl::SetSnapshotNumber(IBPP::Database db, int64_t number)
+{
+	if (mHandle != 0)
+		throw LogicExceptionImpl("Transaction::SetSnapshotNumber",
+				_("Can't set the snapshot number if Transaction started."));
+	if (db.intf() == 0)
+		throw LogicExceptionImpl("Transaction::SetSnapshotNumber",
+				_("Can't set the snapshot number on an unbound Database."));
+
+	std::vector<DatabaseImpl*>::iterator pos =
+		std::find(mDatabases.begin(), mDatabases.end(), dynamic_cast<DatabaseImpl*>(db.intf()));
+	if (pos == mDatabases.end())
+		throw LogicExceptionImpl("Transaction::SetSnapshotNumber",
+			_("The database connection you specified is not attached to this transaction."));
+
+	mTPBs[pos - mDatabases.begin()]->InsertInt64(isc_tpb_at_snapshot_number, number);
+}
+
 void TransactionImpl::Start()
 {
 	if (mHandle != 0) return;	// Already started anyway
@@ -119,6 +137,17 @@ void TransactionImpl::Start()
 	if (mDatabases.empty())
 		throw LogicExceptionImpl("Transaction::Start", _("No Database is attached."));
 
+	mArrayDescs.clear();
+
+	// A single database transaction goes through its IAttachment on the
+	// attachments of the OO API, isc_start_multiple() is kept for the others
+	if (mDatabases.size() == 1 && mDatabases[0]->GetHandle() != 0
+		&& mDatabases[0]->GetInterface() != 0)
+	{
+		mInterface = OOStart(mDatabases[0]->GetInterface(), *mTPBs[0], &mHandle);
+		return;
+	}
+
 	struct ISC_TEB
 	{
 		ISC_LONG* db_ptr;
@@ -156,11 +185,16 @@ void TransactionImpl::Commit()
 	if (mHandle == 0)
 		throw LogicExceptionImpl("Transaction::Commit", _("Transaction is not started."));
 		
+	// The handle keeps the transaction alive until it ends
+	OORelease(mInterface);
+	mInterface = 0;
+
 	IBS status;
 
 	(*gds.Call()->m_commit_transaction)(status.Self(), &mHandle);
 	if (status.Errors())
 		throw SQLExceptionImpl(status, "Transaction::Commit");
+	mArrayDescs.clear();
 	mHandle = 0;	// Should be, better be sure
 }
 
@@ -174,17 +208,22 @@ void TransactionImpl::CommitRetain()
 	(*gds.Call()->m_commit_retaining)(status.Self(), &mHandle);
 	if (status.Errors())
 		throw SQLExceptionImpl(status, "Transaction::CommitRetain");
+	mArrayDescs.clear();
 }
 
 void TransactionImpl::Rollback()
 {
 	if (mHandle == 0) return;	// Transaction not started anyway
 
+	OORelease(mInterface);
+	mInterface = 0;
+
 	IBS status;
 
 	(*gds.Call()->m_rollback_transaction)(status.Self(), &mHandle);
 	if (status.Errors())
 		throw SQLExceptionImpl(status, "Transaction::Rollback");
+	mArrayDescs.clear();
 	mHandle = 0;	// Should be, better be sure
 }
 
@@ -198,6 +237,15 @@ void TransactionImpl::RollbackRetain()
 	(*gds.Call()->m_rollback_retaining)(status.Self(), &mHandle);
 	if (status.Errors())
 		throw SQLExceptionImpl(status, "Transaction::RollbackRetain");
+	mArrayDescs.clear();
+}
+
+ibpp_oo::ITransaction* TransactionImpl::GetInterface()
+{
+	// Transactions started with isc_start_multiple() get theirs on demand
+	if (mInterface == 0 && mHandle != 0)
+		mInterface = OOTransaction(&mHandle);
+	return mInterface;
 }
 
 IBPP::ITransaction* TransactionImpl::AddRef()
@@ -211,8 +259,7 @@ void TransactionImpl::Release()
 {
 	// Release cannot throw, except in DEBUG builds on assertion
 	ASSERTION(mRefCount >= 0);
-	--mRefCount;
-	try { if (mRefCount <= 0) delete this; }
+	try { if (--mRefCount <= 0) delete this; }
 		catch (...) { }
 }
 
@@ -221,11 +268,14 @@ void TransactionImpl::Release()
 void TransactionImpl::Init()
 {
 	mHandle = 0;
+	mInterface = 0;
 	mDatabases.clear();
+	mDbSlots.clear();
 	mTPBs.clear();
 	mStatements.clear();
  	mBlobs.clear();
 	mArrays.clear();
+	mArrayDescs.clear();
 }
 
 void TransactionImpl::AttachStatementImpl(StatementImpl* st)
@@ -234,7 +284,7 @@ void TransactionImpl::AttachStatementImpl(StatementImpl* st)
 		throw LogicExceptionImpl("Transaction::AttachStatement",
 					_("Can't attach a 0 Statement object."));
 
-	mStatements.push_back(st);
+	SlotAttach(mStatements, st, &StatementImpl::mTrSlot);
 }
 
 void TransactionImpl::DetachStatementImpl(StatementImpl* st)
@@ -243,7 +293,7 @@ void TransactionImpl::DetachStatementImpl(StatementImpl* st)
 		throw LogicExceptionImpl("Transaction::DetachStatement",
 				_("Can't detach a 0 Statement object."));
 
-	mStatements.erase(std::find(mStatements.begin(), mStatements.end(), st));
+	SlotDetach(mStatements, st, &StatementImpl::mTrSlot);
 }
 
 void TransactionImpl::AttachBlobImpl(BlobImpl* bb)
@@ -252,7 +302,7 @@ void TransactionImpl::AttachBlobImpl(BlobImpl* bb)
 		throw LogicExceptionImpl("Transaction::AttachBlob",
 					_("Can't attach a 0 BlobImpl object."));
 
-	mBlobs.push_back(bb);
+	SlotAttach(mBlobs, bb, &BlobImpl::mTrSlot);
 }
 
 void TransactionImpl::DetachBlobImpl(BlobImpl* bb)
@@ -261,7 +311,7 @@ void TransactionImpl::DetachBlobImpl(BlobImpl* bb)
 		throw LogicExceptionImpl("Transaction::DetachBlob",
 				_("Can't detach a 0 BlobImpl object."));
 
-	mBlobs.erase(std::find(mBlobs.begin(), mBlobs.end(), bb));
+	SlotDetach(mBlobs, bb, &BlobImpl::mTrSlot);
 }
 
 void TransactionImpl::AttachArrayImpl(ArrayImpl* ar)
@@ -270,7 +320,7 @@ void TransactionImpl::AttachArrayImpl(ArrayImpl* ar)
 		throw LogicExceptionImpl("Transaction::AttachArray",
 					_("Can't attach a 0 ArrayImpl object."));
 
-	mArrays.push_back(ar);
+	SlotAttach(mArrays, ar, &ArrayImpl::mTrSlot);
 }
 
 void TransactionImpl::DetachArrayImpl(ArrayImpl* ar)
@@ -279,7 +329,7 @@ void TransactionImpl::DetachArrayImpl(ArrayImpl* ar)
 		throw LogicExceptionImpl("Transaction::DetachArray",
 				_("Can't detach a 0 ArrayImpl object."));
 
-	mArrays.erase(std::find(mArrays.begin(), mArrays.end(), ar));
+	SlotDetach(mArrays, ar, &ArrayImpl::mTrSlot);
 }
 
 void TransactionImpl::AttachDatabaseImpl(DatabaseImpl* dbi,
@@ -293,6 +343,7 @@ void TransactionImpl::AttachDatabaseImpl(DatabaseImpl* dbi,
 				_("Can't attach a null Database."));
 
 	mDatabases.push_back(dbi);
+	mDbSlots.push_back(0);		// Set by dbi->AttachTransactionImpl()
 
 	// Prepare a new TPB
 	TPB* tpb = new TPB;
@@ -335,15 +386,35 @@ void TransactionImpl::DetachDatabaseImpl(DatabaseImpl* dbi)
 		std::find(mDatabases.begin(), mDatabases.end(), dbi);
 	if (pos != mDatabases.end())
 	{
+		// Signals the Database object that it has been detached from the
+		// Transaction, while our slot in its table is still known
+		dbi->DetachTransactionImpl(this);
+
 		size_t index = pos - mDatabases.begin();
 		TPB* tpb = mTPBs[index];
 		mDatabases.erase(pos);
+		mDbSlots.erase(mDbSlots.begin()+index);
 		mTPBs.erase(mTPBs.begin()+index);
 		delete tpb;
 	}
+}
+
+//	A transaction spans very few databases: a linear lookup is fine here
+
+size_t TransactionImpl::DatabaseSlot(DatabaseImpl* dbi)
+{
+	for (size_t i = 0; i < mDatabases.size(); i++)
+		if (mDatabases[i] == dbi) return mDbSlots[i];
+	throw LogicExceptionImpl("Transaction::DatabaseSlot",
+			_("Database is not attached to this Transaction."));
+}
 
-	// Signals the Database object that it has been detached from the Transaction
-	dbi->DetachTransactionImpl(this);
+void TransactionImpl::SetDatabaseSlot(DatabaseImpl* dbi, size_t slot)
+{
+	for (size_t i = 0; i < mDatabases.size(); i++)
+		if (mDatabases[i] == dbi) { mDbSlots[i] = slot; return; }
+	throw LogicExceptionImpl("Transaction::SetDatabaseSlot",
+			_("Database is not attached to this Transaction."));
 }
 
 TransactionImpl::TransactionImpl(DatabaseImpl* db,
@@ -359,6 +430,7 @@ TransactionImpl::~TransactionImpl()
 	// Rollback the transaction if it was Started
 	try { if (Started()) Rollback(); }
 		catch (...) { }
+	OORelease(mInterface);
 
 	// Let's detach cleanly all Blobs from this Transaction.
 	// No Blob object can still maintain pointers to this
@@ -0,0 +1,814 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//	File    : $Id$
+//	Subject : IBPP, Firebird 4 data types (INT128, DECFLOAT, WITH TIME ZONE)
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	(C) Copyright 2000-2006 T.I.P. Group S.A. and the IBPP Team (www.ibpp.org)
+//
+//	The contents of this file are subject to the IBPP License (the "License");
+//	you may not use this file except in compliance with the License.  You may
+//	obtain a copy of the License at http://www.ibpp.org or in the 'license.txt'
+//	file which must have been distributed along with this file.
+//
+//	This software, distributed under the License, is distributed on an "AS IS"
+//	basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.  See the
+//	License for the specific language governing rights and limitations
+//	under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	COMMENTS
+//	* Tabulations should be set every four characters when editing this file.
+//	* The values are decoded from their binary form, as the server sends them,
+//	  without help from the client library : DECFLOAT is IEEE 754 decimal64
+//	  and decimal128 in densely packed decimal, INT128 two's complement with
+//	  its least significant 64 bits first.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef _MSC_VER
+#pragma warning(disable: 4786 4996)
+#ifndef _DEBUG
+#pragma warning(disable: 4702)
+#endif
+#endif
+
+#include "_ibpp.h"
+
+#ifdef HAS_HDRSTOP
+#pragma hdrstop
+#endif
+
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <locale>
+
+using namespace ibpp_internals;
+
+namespace
+{
+	const double Two64 = 18446744073709551616.0;
+	const double Two127 = 170141183460469231731687303715884105728.0;
+
+	//	Magnitude of a 128 bits value, as four 32 bits limbs, the most
+	//	significant first. Returns true for a negative value.
+	bool ToLimbs(int64_t high, uint64_t low, uint32_t* limb)
+	{
+		uint64_t h = (uint64_t)high;
+		uint64_t l = low;
+		bool negative = high < 0;
+		if (negative)
+		{
+			l = ~l + 1;
+			h = ~h + (l == 0 ? 1 : 0);
+		}
+		limb[0] = (uint32_t)(h >> 32);
+		limb[1] = (uint32_t)h;
+		limb[2] = (uint32_t)(l >> 32);
+		limb[3] = (uint32_t)l;
+		return negative;
+	}
+
+	void FromLimbs(const uint32_t* limb, bool negative, int64_t& high, uint64_t& low)
+	{
+		uint64_t h = ((uint64_t)limb[0] << 32) | limb[1];
+		uint64_t l = ((uint64_t)limb[2] << 32) | limb[3];
+		if (negative)
+		{
+			l = ~l + 1;
+			h = ~h + (l == 0 ? 1 : 0);
+		}
+		high = (int64_t)h;
+		low = l;
+	}
+
+	//	Divides the limbs in place, returns the remainder
+	uint32_t DivLimbs(uint32_t* limb, uint32_t divisor)
+	{
+		uint64_t rest = 0;
+		for (int i = 0; i < 4; i++)
+		{
+			uint64_t cur = (rest << 32) | limb[i];
+			limb[i] = (uint32_t)(cur / divisor);
+			rest = cur % divisor;
+		}
+		return (uint32_t)rest;
+	}
+
+	//	limb = limb * 10 + digit, false when the result needs more than 128 bits
+	bool MulAddLimbs(uint32_t* limb, unsigned digit)
+	{
+		uint64_t carry = digit;
+		for (int i = 3; i >= 0; i--)
+		{
+			uint64_t cur = (uint64_t)limb[i] * 10 + carry;
+			limb[i] = (uint32_t)cur;
+			carry = cur >> 32;
+		}
+		return carry == 0;
+	}
+
+	//	A magnitude fits in a signed 128 bits value : up to 2^127 - 1, or 2^127
+	//	for a negative one
+	bool FitsLimbs(const uint32_t* limb, bool negative)
+	{
+		if ((limb[0] & 0x80000000) == 0) return true;
+		return negative && limb[0] == 0x80000000 && (limb[1] | limb[2] | limb[3]) == 0;
+	}
+
+	bool IsZero(const uint32_t* limb)
+	{
+		return (limb[0] | limb[1] | limb[2] | limb[3]) == 0;
+	}
+
+	bool LittleEndian()
+	{
+		const unsigned short one = 1;
+		return *(const unsigned char*)&one == 1;
+	}
+
+	//	Layout of the IEEE 754 decimal formats used by DECFLOAT(16) and (34),
+	//	from the least significant bit : the coefficient continuation (declets
+	//	of 3 digits), the exponent continuation, the combination field (5 bits,
+	//	the exponent high bits and the leading digit) and the sign.
+	struct DecFormat
+	{
+		int digits;
+		int bits;
+		int ecbits;
+		int bias;
+		int emax;
+		int declets;
+	};
+
+	const DecFormat Dec16 = { 16, 64, 8, 398, 384, 5 };
+	const DecFormat Dec34 = { 34, 128, 12, 6176, 6144, 11 };
+
+	unsigned GetBits(const uint64_t* w, int pos, int n)
+	{
+		uint64_t v;
+		if (pos >= 64) v = w[1] >> (pos - 64);
+		else if (pos + n <= 64) v = w[0] >> pos;
+		else v = (w[0] >> pos) | (w[1] << (64 - pos));
+		return (unsigned)(v & ((1u << n) - 1));
+	}
+
+	void SetBits(uint64_t* w, int pos, int n, unsigned value)
+	{
+		uint64_t v = value;
+		if (pos >= 64) w[1] |= v << (pos - 64);
+		else
+		{
+			w[0] |= v << pos;
+			if (pos + n > 64) w[1] |= v >> (64 - pos);
+		}
+	}
+
+	//	decDouble and decQuad are a single unit in the byte order of the
+	//	platform.
+	void LoadWords(uint64_t* w, const char* data, const DecFormat& f)
+	{
+		w[1] = 0;
+		if (f.bits == 64) memcpy(&w[0], data, 8);
+		else if (LittleEndian())
+		{
+			memcpy(&w[0], data, 8);
+			memcpy(&w[1], data + 8, 8);
+		}
+		else
+		{
+			memcpy(&w[1], data, 8);
+			memcpy(&w[0], data + 8, 8);
+		}
+	}
+
+	void StoreWords(char* data, const uint64_t* w, const DecFormat& f)
+	{
+		if (f.bits == 64) memcpy(data, &w[0], 8);
+		else if (LittleEndian())
+		{
+			memcpy(data, &w[0], 8);
+			memcpy(data + 8, &w[1], 8);
+		}
+		else
+		{
+			memcpy(data, &w[1], 8);
+			memcpy(data + 8, &w[0], 8);
+		}
+	}
+
+	//	Densely packed decimal : 3 digits in 10 bits
+	unsigned DecodeDeclet(unsigned d)
+	{
+		unsigned b0 = d & 1, b4 = (d >> 4) & 1, b7 = (d >> 7) & 1;
+		unsigned hi = (d >> 7) & 7, mid = (d >> 4) & 7, lo = d & 7;
+		unsigned d2, d1, d0;
+
+		if ((d & 8) == 0) { d2 = hi; d1 = mid; d0 = lo; }
+		else switch ((d >> 1) & 3)
+		{
+			case 0 : d2 = hi; d1 = mid; d0 = 8 + b0; break;
+			case 1 : d2 = hi; d1 = 8 + b4; d0 = (((d >> 5) & 3) << 1) | b0; break;
+			case 2 : d2 = 8 + b7; d1 = mid; d0 = (((d >> 8) & 3) << 1) | b0; break;
+			default :
+				switch ((d >> 5) & 3)
+				{
+					case 0 : d2 = 8 + b7; d1 = 8 + b4; d0 = (((d >> 8) & 3) << 1) | b0; break;
+					case 1 : d2 = 8 + b7; d1 = (((d >> 8) & 3) << 1) | b4; d0 = 8 + b0; break;
+					case 2 : d2 = hi; d1 = 8 + b4; d0 = 8 + b0; break;
+					default : d2 = 8 + b7; d1 = 8 + b4; d0 = 8 + b0; break;
+				}
+		}
+		return d2 * 100 + d1 * 10 + d0;
+	}
+
+	//	The encoding table is the reverse of DecodeDeclet(), keeping the
+	//	canonical declet (the lowest) for each value.
+	struct DecletTable
+	{
+		unsigned short encode[1000];
+
+		DecletTable()
+		{
+			for (int i = 0; i < 1000; i++) encode[i] = 0xFFFF;
+			for (unsigned d = 0; d < 1024; d++)
+			{
+				unsigned v = DecodeDeclet(d);
+				if (encode[v] == 0xFFFF) encode[v] = (unsigned short)d;
+			}
+		}
+	};
+
+	const DecletTable declets;
+
+	const DecFormat& Format(int digits)
+	{
+		return digits == 16 ? Dec16 : Dec34;
+	}
+
+	//	A decoded DECFLOAT : the coefficient digits and the exponent, or one of
+	//	the special values.
+	struct Decimal
+	{
+		bool negative;
+		std::string special;	// "Infinity", "NaN", "sNaN" or empty
+		std::string coef;
+		int exponent;
+	};
+
+	void Decode(Decimal& dec, const char* data, const DecFormat& f)
+	{
+		uint64_t w[2];
+		LoadWords(w, data, f);
+
+		dec.negative = GetBits(w, f.bits - 1, 1) != 0;
+		dec.special.erase();
+		dec.coef.erase();
+		dec.exponent = 0;
+
+		unsigned comb = GetBits(w, f.bits - 6, 5);
+		if ((comb & 0x1E) == 0x1E)
+		{
+			if ((comb & 1) == 0) dec.special = "Infinity";
+			else dec.special = GetBits(w, f.bits - 7, 1) ? "sNaN" : "NaN";
+			dec.coef = "0";
+			return;
+		}
+
+		unsigned emsb, lead;
+		if ((comb & 0x18) == 0x18)
+		{
+			emsb = (comb >> 1) & 3;
+			lead = 8 + (comb & 1);
+		}
+		else
+		{
+			emsb = comb >> 3;
+			lead = comb & 7;
+		}
+		dec.exponent = (int)((emsb << f.ecbits) |
+			GetBits(w, f.declets * 10, f.ecbits)) - f.bias;
+
+		dec.coef.reserve(f.digits);
+		dec.coef.append(1, (char)('0' + lead));
+		for (int k = f.declets - 1; k >= 0; k--)
+		{
+			unsigned v = DecodeDeclet(GetBits(w, k * 10, 10));
+			dec.coef.append(1, (char)('0' + v / 100));
+			dec.coef.append(1, (char)('0' + (v / 10) % 10));
+			dec.coef.append(1, (char)('0' + v % 10));
+		}
+
+		std::string::size_type first = dec.coef.find_first_not_of('0');
+		if (first == std::string::npos) dec.coef = "0";
+		else dec.coef.erase(0, first);
+	}
+
+	//	Rounds the coefficient to its first 'keep' digits, half even. Returns
+	//	the number of digits dropped, which is added to the exponent.
+	int Round(std::string& coef, int keep)
+	{
+		int drop = (int)coef.length() - keep;
+		if (drop <= 0) return 0;
+
+		char first = coef[keep];
+		bool tail = coef.find_first_not_of('0', keep + 1) != std::string::npos;
+		coef.erase(keep);
+		bool odd = keep > 0 && (coef[keep - 1] - '0') % 2 == 1;
+
+		if (first > '5' || (first == '5' && (tail || odd)))
+		{
+			int k = keep - 1;
+			while (k >= 0 && coef[k] == '9') coef[k--] = '0';
+			if (k >= 0) coef[k]++;
+			else coef.insert(0, 1, '1');
+		}
+		if (coef.empty()) coef = "0";
+		return drop;
+	}
+
+	//	Parses a number as accepted by the server ("-1.5", "25E-3", "Inf",
+	//	...). False when the text is not a number.
+	bool Parse(Decimal& dec, const std::string& text)
+	{
+		std::string::size_type i = text.find_first_not_of(' ');
+		std::string::size_type n = text.find_last_not_of(' ');
+		if (i == std::string::npos) return false;
+		n++;
+
+		dec.negative = false;
+		dec.special.erase();
+		dec.coef.erase();
+		dec.exponent = 0;
+
+		if (text[i] == '-' || text[i] == '+') dec.negative = text[i++] == '-';
+
+		std::string word;
+		for (std::string::size_type k = i; k < n; k++)
+			word.append(1, (char)tolower((unsigned char)text[k]));
+		if (word == "inf" || word == "infinity") dec.special = "Infinity";
+		else if (word == "nan") dec.special = "NaN";
+		else if (word == "snan") dec.special = "sNaN";
+		if (! dec.special.empty())
+		{
+			dec.coef = "0";
+			return true;
+		}
+
+		bool digits = false, point = false;
+		for (; i < n; i++)
+		{
+			char c = text[i];
+			if (c >= '0' && c <= '9')
+			{
+				digits = true;
+				if (! dec.coef.empty() || c != '0') dec.coef.append(1, c);
+				if (point) dec.exponent--;
+			}
+			else if (c == '.' && ! point) point = true;
+			else break;
+		}
+		if (! digits) return false;
+		if (dec.coef.empty()) dec.coef = "0";
+
+		if (i < n && (text[i] == 'e' || text[i] == 'E'))
+		{
+			bool negexp = false;
+			if (++i < n && (text[i] == '-' || text[i] == '+')) negexp = text[i++] == '-';
+			if (i >= n) return false;
+			int e = 0;
+			for (; i < n && text[i] >= '0' && text[i] <= '9'; i++)
+				if (e < 100000) e = e * 10 + (text[i] - '0');
+			dec.exponent += negexp ? -e : e;
+		}
+
+		return i == n;
+	}
+
+	bool Encode(char* data, const DecFormat& f, Decimal& dec)
+	{
+		uint64_t w[2] = { 0, 0 };
+
+		if (dec.negative) SetBits(w, f.bits - 1, 1, 1);
+		if (! dec.special.empty())
+		{
+			SetBits(w, f.bits - 6, 5, dec.special == "Infinity" ? 0x1E : 0x1F);
+			if (dec.special == "sNaN") SetBits(w, f.bits - 7, 1, 1);
+			StoreWords(data, w, f);
+			return true;
+		}
+
+		std::string& coef = dec.coef;
+		int exponent = dec.exponent;
+		const int qmin = -f.bias;
+		const int qmax = f.emax - f.digits + 1;
+
+		exponent += Round(coef, f.digits);
+		if ((int)coef.length() > f.digits) exponent += Round(coef, f.digits);
+
+		if (exponent < qmin)
+		{
+			// Underflow, the digits under the smallest exponent are rounded
+			int keep = (int)coef.length() - (qmin - exponent);
+			if (keep < 0) coef = "0";
+			else Round(coef, keep);
+			exponent = qmin;
+		}
+		if (coef == "0")
+		{
+			if (exponent > qmax) exponent = qmax;
+		}
+		else if (exponent > qmax)
+		{
+			// Clamped with trailing zeros when they fit, else an overflow
+			int pad = exponent - qmax;
+			if ((int)coef.length() + pad > f.digits) return false;
+			coef.append(pad, '0');
+			exponent = qmax;
+		}
+
+		std::string padded(f.digits - coef.length(), '0');
+		padded.append(coef);
+
+		unsigned biased = (unsigned)(exponent + f.bias);
+		unsigned emsb = biased >> f.ecbits;
+		unsigned lead = padded[0] - '0';
+		unsigned comb = lead < 8 ? (emsb << 3) | lead : 0x18 | (emsb << 1) | (lead & 1);
+
+		SetBits(w, f.bits - 6, 5, comb);
+		SetBits(w, f.declets * 10, f.ecbits, biased & ((1u << f.ecbits) - 1));
+		for (int j = 0; j < f.declets; j++)
+		{
+			unsigned v = (padded[1 + j * 3] - '0') * 100 +
+				(padded[2 + j * 3] - '0') * 10 + (padded[3 + j * 3] - '0');
+			SetBits(w, (f.declets - 1 - j) * 10, 10, declets.encode[v]);
+		}
+
+		StoreWords(data, w, f);
+		return true;
+	}
+
+	//	Zones are numbered 0 to 2 * 1439 for the offsets -23:59 to +23:59,
+	//	and down from 65535 (GMT) for the regions.
+	const int OffsetBase = 1439;
+	const int GmtZone = 65535;
+
+	std::string OffsetName(int minutes)
+	{
+		char name[8];
+		int m = minutes < 0 ? -minutes : minutes;
+		name[0] = minutes < 0 ? '-' : '+';
+		name[1] = (char)('0' + m / 600);
+		name[2] = (char)('0' + (m / 60) % 10);
+		name[3] = ':';
+		name[4] = (char)('0' + (m % 60) / 10);
+		name[5] = (char)('0' + m % 10);
+		name[6] = '\0';
+		return name;
+	}
+
+	void DecodeZone(IBPP::TimeZone& tz, const char* isc_tz, int pos, bool extended)
+	{
+		unsigned short zone;
+		memcpy(&zone, isc_tz + pos, sizeof(zone));
+		if (zone <= 2 * OffsetBase)
+		{
+			tz.SetOffset((int)zone - OffsetBase);
+			return;
+		}
+
+		std::string name;
+		int offset = 0;
+		bool known = false;
+		if (extended)
+		{
+			short ext;
+			memcpy(&ext, isc_tz + pos + sizeof(zone), sizeof(ext));
+			offset = ext;
+			known = true;
+		}
+
+		if (zone == GmtZone)
+		{
+			name = "GMT";
+			known = true;
+		}
+		else name = OOZoneName(zone);
+
+		tz.SetZone(zone, name, offset, known);
+	}
+}
+
+//	(((((((( Int128 ))))))))
+
+std::string IBPP::Int128::ToString(int scale) const
+{
+	uint32_t limb[4];
+	bool negative = ToLimbs(mHigh, mLow, limb);
+
+	std::string digits;
+	do
+	{
+		uint32_t chunk = DivLimbs(limb, 1000000000);
+		for (int i = 0; i < 9; i++)
+		{
+			digits.insert(0, 1, (char)('0' + chunk % 10));
+			chunk /= 10;
+		}
+	} while (! IsZero(limb));
+
+	std::string::size_type first = digits.find_first_not_of('0');
+	if (first == std::string::npos) digits = "0";
+	else digits.erase(0, first);
+
+	if (scale > 0)
+	{
+		if ((int)digits.length() <= scale)
+			digits.insert(0, scale + 1 - digits.length(), '0');
+		digits.insert(digits.length() - scale, 1, '.');
+	}
+	else if (scale < 0 && digits != "0") digits.append(-scale, '0');
+
+	if (negative) digits.insert(0, 1, '-');
+	return digits;
+}
+
+double IBPP::Int128::ToDouble(int scale) const
+{
+	uint32_t limb[4];
+	bool negative = ToLimbs(mHigh, mLow, limb);
+
+	double value = ((double)limb[0] * 4294967296.0 + (double)limb[1]) * Two64 +
+		(double)limb[2] * 4294967296.0 + (double)limb[3];
+	if (scale != 0) value /= pow(10.0, scale);
+	return negative ? -value : value;
+}
+
+bool IBPP::Int128::FromString(const std::string& text, int scale)
+{
+	Decimal dec;
+	if (! Parse(dec, text) || ! dec.special.empty()) return false;
+
+	// Brings the number to the scale, rounded half up like the doubles
+	int exponent = dec.exponent + scale;
+	if (exponent < 0)
+	{
+		int keep = (int)dec.coef.length() + exponent;
+		if (keep < 0) dec.coef = "0";
+		else
+		{
+			bool up = keep < (int)dec.coef.length() && dec.coef[keep] >= '5';
+			dec.coef.erase(keep);
+			if (up)
+			{
+				int k = keep - 1;
+				while (k >= 0 && dec.coef[k] == '9') dec.coef[k--] = '0';
+				if (k >= 0) dec.coef[k]++;
+				else dec.coef.insert(0, 1, '1');
+			}
+			if (dec.coef.empty()) dec.coef = "0";
+		}
+	}
+	else if (dec.coef != "0")
+	{
+		if (exponent > 38) return false;
+		dec.coef.append(exponent, '0');
+	}
+
+	uint32_t limb[4] = { 0, 0, 0, 0 };
+	for (std::string::size_type i = 0; i < dec.coef.length(); i++)
+		if (! MulAddLimbs(limb, dec.coef[i] - '0')) return false;
+	if (! FitsLimbs(limb, dec.negative)) return false;
+
+	FromLimbs(limb, dec.negative, mHigh, mLow);
+	return true;
+}
+
+bool IBPP::Int128::FromDouble(double value, int scale)
+{
+	double x = value * pow(10.0, scale);
+	bool negative = x < 0;
+	if (negative) x = -x;
+	x = floor(x + 0.5);
+	if (! (x < Two127)) return false;		// NaN too
+
+	double h = floor(x / Two64);
+	double l = x - h * Two64;
+	uint32_t limb[4];
+	limb[0] = (uint32_t)(h / 4294967296.0);
+	limb[1] = (uint32_t)(h - (double)limb[0] * 4294967296.0);
+	limb[2] = (uint32_t)(l / 4294967296.0);
+	limb[3] = (uint32_t)(l - (double)limb[2] * 4294967296.0);
+
+	FromLimbs(limb, negative, mHigh, mLow);
+	return true;
+}
+
+//	(((((((( TimeZone, TimestampTz, TimeTz ))))))))
+
+void IBPP::TimeZone::SetOffset(int minutes)
+{
+	if (minutes < -OffsetBase || minutes > OffsetBase)
+		throw LogicExceptionImpl("TimeZone::SetOffset", _("Invalid time zone offset"));
+	mZoneId = minutes + OffsetBase;
+	mOffset = minutes;
+	mOffsetKnown = true;
+	mZone = OffsetName(minutes);
+}
+
+void IBPP::TimeZone::SetZone(int zoneid, const std::string& name, int minutes, bool known)
+{
+	mZoneId = zoneid;
+	mZone = name;
+	mOffset = known ? minutes : 0;
+	mOffsetKnown = known;
+}
+
+IBPP::Timestamp IBPP::TimestampTz::Local() const
+{
+	IBPP::Timestamp local(*this);
+	if (! mOffsetKnown || mOffset == 0) return local;
+
+	int tm = mTime + mOffset * 600000;
+	int dt = mDate;
+	if (tm < 0) { tm += 864000000; dt--; }
+	else if (tm >= 864000000) { tm -= 864000000; dt++; }
+	local.SetDate(dt);
+	local.SetTime(tm);
+	return local;
+}
+
+IBPP::Time IBPP::TimeTz::Local() const
+{
+	IBPP::Time local(*this);
+	if (! mOffsetKnown || mOffset == 0) return local;
+
+	int tm = mTime + mOffset * 600000;
+	if (tm < 0) tm += 864000000;
+	else if (tm >= 864000000) tm -= 864000000;
+	local.SetTime(tm);
+	return local;
+}
+
+namespace ibpp_internals
+{
+
+//
+//	The following functions are helper conversions functions between IBPP
+//	Int128, TimestampTz, TimeTz, the DECFLOAT text and the sqldata of the
+//	Firebird 4 types. They are used from row.cpp.
+//
+
+void encodeInt128(char* isc_i128, const IBPP::Int128& value)
+{
+	uint64_t words[2];
+	words[0] = value.Low();
+	words[1] = (uint64_t)value.High();
+	memcpy(isc_i128, words, sizeof(words));
+}
+
+void decodeInt128(IBPP::Int128& value, const char* isc_i128)
+{
+	uint64_t words[2];
+	memcpy(words, isc_i128, sizeof(words));
+	value.SetValue((int64_t)words[1], words[0]);
+}
+
+bool encodeDecfloat(char* isc_dec, int digits, const std::string& text)
+{
+	Decimal dec;
+	if (! Parse(dec, text)) return false;
+	return Encode(isc_dec, Format(digits), dec);
+}
+
+bool encodeDecfloat(char* isc_dec, int digits, double value)
+{
+	// The shortest text giving the same double back, so that 0.1 is stored
+	// as 0.1 and not as its binary approximation
+	std::string text;
+	for (int precision = 15; precision <= 17; precision++)
+	{
+		std::ostringstream os;
+		os.imbue(std::locale::classic());
+		os.precision(precision);
+		os << value;
+		text = os.str();
+
+		std::istringstream is(text);
+		is.imbue(std::locale::classic());
+		double back = 0;
+		if ((is >> back) && back == value) break;
+	}
+	return encodeDecfloat(isc_dec, digits, text);
+}
+
+void decodeDecfloat(std::string& text, const char* isc_dec, int digits)
+{
+	Decimal dec;
+	Decode(dec, isc_dec, Format(digits));
+
+	text.erase();
+	if (dec.negative) text.append("-");
+	if (! dec.special.empty())
+	{
+		text.append(dec.special);
+		return;
+	}
+
+	// Same text as the server (to-scientific-string of the standard)
+	const int length = (int)dec.coef.length();
+	const int adjusted = dec.exponent + length - 1;
+	if (dec.exponent <= 0 && adjusted >= -6)
+	{
+		const int point = length + dec.exponent;
+		if (dec.exponent == 0) text.append(dec.coef);
+		else if (point > 0)
+			text.append(dec.coef, 0, point).append(".").append(dec.coef, point, std::string::npos);
+		else text.append("0.").append(-point, '0').append(dec.coef);
+	}
+	else
+	{
+		text.append(dec.coef, 0, 1);
+		if (length > 1) text.append(".").append(dec.coef, 1, std::string::npos);
+		std::ostringstream os;
+		os.imbue(std::locale::classic());
+		os << (adjusted < 0 ? "E-" : "E+") << (adjusted < 0 ? -adjusted : adjusted);
+		text.append(os.str());
+	}
+}
+
+void decodeDecfloat(double& value, const char* isc_dec, int digits)
+{
+	Decimal dec;
+	Decode(dec, isc_dec, Format(digits));
+
+	if (dec.special == "Infinity")
+		value = std::numeric_limits<double>::infinity();
+	else if (! dec.special.empty())
+		value = std::numeric_limits<double>::quiet_NaN();
+	else
+	{
+		std::ostringstream os;
+		os.imbue(std::locale::classic());
+		os << dec.coef << 'E' << dec.exponent;
+		std::istringstream is(os.str());
+		is.imbue(std::locale::classic());
+		value = 0;
+		if (! (is >> value))
+			value = dec.exponent > 0 ? std::numeric_limits<double>::infinity() : 0.0;
+	}
+	if (dec.negative) value = -value;
+}
+
+void encodeTimestampTz(char* isc_tstz, const IBPP::TimestampTz& ts, bool extended)
+{
+	ISC_TIMESTAMP utc;
+	encodeTimestamp(utc, ts);
+	unsigned short zone = (unsigned short)ts.ZoneId();
+	memcpy(isc_tstz, &utc, sizeof(utc));
+	memcpy(isc_tstz + sizeof(utc), &zone, sizeof(zone));
+	if (extended)
+	{
+		short offset = (short)ts.Offset();
+		memcpy(isc_tstz + sizeof(utc) + sizeof(zone), &offset, sizeof(offset));
+	}
+}
+
+void decodeTimestampTz(IBPP::TimestampTz& ts, const char* isc_tstz, bool extended)
+{
+	ISC_TIMESTAMP utc;
+	memcpy(&utc, isc_tstz, sizeof(utc));
+	decodeTimestamp(ts, utc);
+	DecodeZone(ts, isc_tstz, sizeof(utc), extended);
+}
+
+void encodeTimeTz(char* isc_ttz, const IBPP::TimeTz& tm, bool extended)
+{
+	ISC_TIME utc;
+	encodeTime(utc, tm);
+	unsigned short zone = (unsigned short)tm.ZoneId();
+	memcpy(isc_ttz, &utc, sizeof(utc));
+	memcpy(isc_ttz + sizeof(utc), &zone, sizeof(zone));
+	if (extended)
+	{
+		short offset = (short)tm.Offset();
+		memcpy(isc_ttz + sizeof(utc) + sizeof(zone), &offset, sizeof(offset));
+	}
+}
+
+void decodeTimeTz(IBPP::TimeTz& tm, const char* isc_ttz, bool extended)
+{
+	ISC_TIME utc;
+	memcpy(&utc, isc_ttz, sizeof(utc));
+	decodeTime(tm, utc);
+	DecodeZone(tm, isc_ttz, sizeof(utc), extended);
+}
+
+}
+
+//
+//	EOF
+//
@@ -5,7 +5,16 @@ HEADERS		+= $$PWD/core/ibpp.h
 SOURCES		+= $$PWD/core/all_in_one.cpp
 
 unix{
-  LIBS += -lfbclient -L./lib
+  # CONFIG += fb_mock links the mock client library of tests/fbmock
+  # (built in lib/) instead of fbclient
+  fb_mock{
+    LIBS += -L$$PWD/../lib -lfbmock
+    QMAKE_RPATHDIR += $$PWD/../lib
+    INCLUDEPATH += $$PWD/../tests/fbmock
+  } else {
+    LIBS += -lfbclient -L./lib
+  }
+  LIBS += -ldl    # optional entry points (dladdr, dlsym)
   DEFINES += IBPP_LINUX \
   IBPP_GCC
 }
@@ -0,0 +1,343 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//	File    : $Id$
+//	Subject : IBPP, test vectors of the DECFLOAT and INT128 codecs
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	(C) Copyright 2000-2006 T.I.P. Group S.A. and the IBPP Team (www.ibpp.org)
+//
+//	The contents of this file are subject to the IBPP License (the "License");
+//	you may not use this file except in compliance with the License.  You may
+//	obtain a copy of the License at http://www.ibpp.org or in the 'license.txt'
+//	file which must have been distributed along with this file.
+//
+//	This software, distributed under the License, is distributed on an "AS IS"
+//	basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.  See the
+//	License for the specific language governing rights and limitations
+//	under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	COMMENTS
+//	* Tabulations should be set every four characters when editing this file.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	This file is NOT part of the IBPP core files.  It checks the conversions
+//	done by types.cpp between text and the sqldata of the Firebird 4 types
+//	against known bit patterns: DECFLOAT(16) and DECFLOAT(34) as IEEE 754
+//	decimal64 and decimal128 in densely packed decimal, INT128 as a two's
+//	complement 128 bits integer. It also checks the text set into the NUMERIC
+//	stored in a SMALLINT, INTEGER or BIGINT by row.cpp. No server and no
+//	client library call is involved.
+//
+//	Usage : codecs
+//
+//	Prints each failing vector and returns 1 when any failed.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef _MSC_VER
+#pragma warning(disable: 4786 4996)
+#endif
+
+#include "../core/_ibpp.h"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace ibpp_internals;
+
+namespace
+{
+	int Failures = 0;
+
+	void Fail(const char* what, const std::string& input, const std::string& got,
+		const std::string& expected)
+	{
+		Failures++;
+		printf("FAILED %s(%s) : '%s' while '%s' was expected\n", what,
+			input.c_str(), got.c_str(), expected.c_str());
+	}
+
+	bool LittleEndian()
+	{
+		const unsigned short one = 1;
+		return *(const unsigned char*)&one == 1;
+	}
+
+	//	A decimal64 or decimal128 is a single unit in the byte order of the
+	//	platform, the hexadecimal text of the vectors being its value
+	std::string ToHex(const char* data, int bytes)
+	{
+		static const char digits[] = "0123456789ABCDEF";
+		std::string hex;
+		for (int i = 0; i < bytes; i++)
+		{
+			unsigned char c = (unsigned char)data[LittleEndian() ? bytes - 1 - i : i];
+			hex.append(1, digits[c >> 4]).append(1, digits[c & 15]);
+		}
+		return hex;
+	}
+
+	void FromHex(char* data, const std::string& hex)
+	{
+		const int bytes = (int)hex.length() / 2;
+		for (int i = 0; i < bytes; i++)
+		{
+			unsigned value;
+			sscanf(hex.c_str() + 2 * i, "%2X", &value);
+			data[LittleEndian() ? bytes - 1 - i : i] = (char)value;
+		}
+	}
+
+	//	input is encoded to bits, bits decoded to text (the canonical form
+	//	of input, as the server prints it)
+	struct DecVector
+	{
+		int digits;
+		const char* input;
+		const char* bits;
+		const char* text;
+	};
+
+	const DecVector DecVectors[] =
+	{
+		{ 16, "0",							"2238000000000000",	"0" },
+		{ 16, "-0",							"A238000000000000",	"-0" },
+		{ 16, "1",							"2238000000000001",	"1" },
+		{ 16, "-1.5",						"A234000000000015",	"-1.5" },
+		{ 16, "0.1",						"2234000000000001",	"0.1" },
+		{ 16, "1.000",						"222C000000000400",	"1.000" },
+		{ 16, "1E3",						"2244000000000001",	"1E+3" },
+		{ 16, "0.000001",					"2220000000000001",	"0.000001" },
+		{ 16, "0.0000001",					"221C000000000001",	"1E-7" },
+		{ 16, "1234567890123456",			"263934B9C1E28E56",	"1234567890123456" },
+		{ 16, "12345678901234567",			"263D34B9C1E28E57",	"1.234567890123457E+16" },	// Rounded, half even
+		{ 16, "9999999999999999E369",		"77FCFF3FCFF3FCFF",	"9.999999999999999E+384" },
+		{ 16, "-9.999999999999999E+384",	"F7FCFF3FCFF3FCFF",	"-9.999999999999999E+384" },
+		{ 16, "1E+384",						"47FC000000000000",	"1.000000000000000E+384" },	// Clamped
+		{ 16, "1E-383",						"003C000000000001",	"1E-383" },
+		{ 16, "1E-398",						"0000000000000001",	"1E-398" },	// Subnormal
+		{ 16, "Infinity",					"7800000000000000",	"Infinity" },
+		{ 16, "-Inf",						"F800000000000000",	"-Infinity" },
+		{ 16, "NaN",						"7C00000000000000",	"NaN" },
+		{ 16, "sNaN",						"7E00000000000000",	"sNaN" },
+		{ 34, "0",							"22080000000000000000000000000000",	"0" },
+		{ 34, "1",							"22080000000000000000000000000001",	"1" },
+		{ 34, "-1.5",						"A207C000000000000000000000000015",	"-1.5" },
+		{ 34, "0.1",						"2207C000000000000000000000000001",	"0.1" },
+		{ 34, "-7.50",						"A20780000000000000000000000003D0",	"-7.50" },
+		{ 34, "1234567890123456789012345678901234",
+											"2608134B9C1E28E56F3C127177823534",
+											"1234567890123456789012345678901234" },
+		{ 34, "9999999999999999999999999999999999E6111",
+											"77FFCFF3FCFF3FCFF3FCFF3FCFF3FCFF",
+											"9.999999999999999999999999999999999E+6144" },
+		{ 34, "1E+6144",					"47FFC000000000000000000000000000",
+											"1.000000000000000000000000000000000E+6144" },	// Clamped
+		{ 34, "1E-6176",					"00000000000000000000000000000001",	"1E-6176" },	// Subnormal
+		{ 34, "Infinity",					"78000000000000000000000000000000",	"Infinity" },
+		{ 34, "NaN",						"7C000000000000000000000000000000",	"NaN" }
+	};
+
+	void CheckDecfloat(const DecVector& v)
+	{
+		const int bytes = v.digits == 16 ? 8 : 16;
+		char data[16];
+		memset(data, 0, sizeof(data));
+
+		if (! encodeDecfloat(data, v.digits, std::string(v.input)))
+			Fail("encodeDecfloat", v.input, "false", v.bits);
+		else if (ToHex(data, bytes) != v.bits)
+			Fail("encodeDecfloat", v.input, ToHex(data, bytes), v.bits);
+
+		FromHex(data, v.bits);
+		std::string text;
+		decodeDecfloat(text, data, v.digits);
+		if (text != v.text)
+			Fail("decodeDecfloat", v.bits, text, v.text);
+	}
+
+	//	Numbers which don't fit
+	void CheckDecfloatOverflow()
+	{
+		char data[16];
+		if (encodeDecfloat(data, 16, std::string("1E+385")))
+			Fail("encodeDecfloat", "1E+385", "true", "false");
+		if (encodeDecfloat(data, 34, std::string("1E+6145")))
+			Fail("encodeDecfloat", "1E+6145", "true", "false");
+		if (encodeDecfloat(data, 16, std::string("1.2.3")))
+			Fail("encodeDecfloat", "1.2.3", "true", "false");
+	}
+
+	//	The doubles are sent with their shortest round trip digits
+	void CheckDecfloatDouble()
+	{
+		char data[16];
+		std::string text;
+		encodeDecfloat(data, 16, 0.1);
+		decodeDecfloat(text, data, 16);
+		if (text != "0.1") Fail("encodeDecfloat", "0.1 (double)", text, "0.1");
+
+		double value = 0;
+		FromHex(data, "A234000000000015");
+		decodeDecfloat(value, data, 16);
+		if (value != -1.5) Fail("decodeDecfloat(double)", "-1.5", "other", "-1.5");
+	}
+
+	//	text is read at scale, the value stored as the high and low words
+	struct IntVector
+	{
+		const char* text;
+		int scale;
+		const char* high;
+		const char* low;
+		const char* back;		// ToString(scale)
+	};
+
+	const IntVector IntVectors[] =
+	{
+		{ "0",			0,	"0000000000000000",	"0000000000000000",	"0" },
+		{ "-1",			0,	"FFFFFFFFFFFFFFFF",	"FFFFFFFFFFFFFFFF",	"-1" },
+		{ "-123.45",	2,	"FFFFFFFFFFFFFFFF",	"FFFFFFFFFFFFCFC7",	"-123.45" },
+		{ "-123.449",	2,	"FFFFFFFFFFFFFFFF",	"FFFFFFFFFFFFCFC7",	"-123.45" },	// Rounded half up
+		{ "0.0005",		4,	"0000000000000000",	"0000000000000005",	"0.0005" },
+		{ "12345678901234567890123",	0,	"000000000000029D",	"42B64E76714244CB",
+			"12345678901234567890123" },
+		{ "-12345678901234567890123",	0,	"FFFFFFFFFFFFFD62",	"BD49B1898EBDBB35",
+			"-12345678901234567890123" },
+		{ "170141183460469231731687303715884105727",	0,	"7FFFFFFFFFFFFFFF",	"FFFFFFFFFFFFFFFF",
+			"170141183460469231731687303715884105727" },
+		{ "-170141183460469231731687303715884105728",	0,	"8000000000000000",	"0000000000000000",
+			"-170141183460469231731687303715884105728" },
+		{ "-1701411834604692317316873037158841057.28",	2,	"8000000000000000",	"0000000000000000",
+			"-1701411834604692317316873037158841057.28" }
+	};
+
+	std::string Word(uint64_t w)
+	{
+		char text[20];
+		sprintf(text, "%08X%08X", (unsigned)(w >> 32), (unsigned)w);
+		return text;
+	}
+
+	void CheckInt128(const IntVector& v)
+	{
+		IBPP::Int128 value;
+		if (! value.FromString(v.text, v.scale))
+		{
+			Fail("Int128::FromString", v.text, "false", v.back);
+			return;
+		}
+		if (Word((uint64_t)value.High()) != v.high || Word(value.Low()) != v.low)
+			Fail("Int128::FromString", v.text,
+				Word((uint64_t)value.High()) + Word(value.Low()),
+				std::string(v.high) + v.low);
+
+		// The sqldata is the low word then the high one, each in the byte
+		// order of the platform (FB_I128)
+		char data[16];
+		uint64_t words[2];
+		encodeInt128(data, value);
+		memcpy(words, data, sizeof(words));
+		if (Word(words[0]) != v.low || Word(words[1]) != v.high)
+			Fail("encodeInt128", v.text, Word(words[1]) + Word(words[0]),
+				std::string(v.high) + v.low);
+
+		IBPP::Int128 back;
+		decodeInt128(back, data);
+		if (back != value || back.ToString(v.scale) != v.back)
+			Fail("Int128::ToString", v.text, back.ToString(v.scale), v.back);
+	}
+
+	void CheckInt128Overflow()
+	{
+		IBPP::Int128 value;
+		if (value.FromString("170141183460469231731687303715884105728"))
+			Fail("Int128::FromString", "2^127", "true", "false");
+		if (value.FromString("-170141183460469231731687303715884105729"))
+			Fail("Int128::FromString", "-2^127 - 1", "true", "false");
+		if (value.FromString("1E39"))
+			Fail("Int128::FromString", "1E39", "true", "false");
+		if (value.FromString("NaN"))
+			Fail("Int128::FromString", "NaN", "true", "false");
+	}
+
+	//	text is set into a NUMERIC(x,scale) stored as sqltype, the sqldata
+	//	then holds value (rc being the expected status)
+	struct ScaledVector
+	{
+		short sqltype;
+		int scale;
+		const char* text;
+		IBPP::RSC rc;
+		int64_t value;
+	};
+
+	const ScaledVector ScaledVectors[] =
+	{
+		{ SQL_SHORT,	2,	"-123.45",					IBPP::rcOk,			-12345 },
+		{ SQL_SHORT,	2,	"327.67",					IBPP::rcOk,			32767 },
+		{ SQL_SHORT,	2,	"327.68",					IBPP::rcOutOfRange,	0 },
+		{ SQL_LONG,		2,	"12345678.91",				IBPP::rcOk,			1234567891 },
+		{ SQL_LONG,		2,	"0.005",					IBPP::rcOk,			1 },	// Rounded half up
+		{ SQL_LONG,		2,	"1,5",						IBPP::rcOutOfRange,	0 },
+		{ SQL_INT64,	4,	"922337203685477.5807",		IBPP::rcOk,			(int64_t)9223372036854775807LL },
+		{ SQL_INT64,	4,	"-922337203685477.5808",	IBPP::rcOk,			(int64_t)(-9223372036854775807LL - 1) },
+		{ SQL_INT64,	4,	"922337203685477.5808",		IBPP::rcOutOfRange,	0 },
+		{ SQL_INT64,	4,	"12345678901234.5678",		IBPP::rcOk,			(int64_t)123456789012345678LL },
+		{ SQL_INT64,	4,	"abc",						IBPP::rcOutOfRange,	0 }
+	};
+
+	void CheckScaled(const ScaledVector& v)
+	{
+		RowImpl row(3, 1, 0, 0);
+		XSQLVAR* var = &row.Self()->sqlvar[0];
+		row.Self()->sqld = 1;
+		var->sqltype = short(v.sqltype | 1);
+		var->sqllen = short(v.sqltype == SQL_SHORT ? 2 : v.sqltype == SQL_LONG ? 4 : 8);
+		var->sqlscale = short(-v.scale);
+		row.AllocVariables();
+
+		const IBPP::RSC rc = row.TrySet(1, std::string(v.text));
+		int64_t value = 0;
+		if (v.sqltype == SQL_SHORT) value = *(int16_t*)var->sqldata;
+		else if (v.sqltype == SQL_LONG) value = *(int32_t*)var->sqldata;
+		else value = *(int64_t*)var->sqldata;
+
+		char got[40], expected[40];
+		sprintf(got, "%d %s", (int)rc, Word((uint64_t)value).c_str());
+		sprintf(expected, "%d %s", (int)v.rc, Word((uint64_t)v.value).c_str());
+		if (rc != v.rc || (rc == IBPP::rcOk && value != v.value))
+			Fail("RowImpl::TrySet", v.text, got, expected);
+	}
+}
+
+int main()
+{
+	for (size_t i = 0; i < sizeof(DecVectors) / sizeof(DecVectors[0]); i++)
+		CheckDecfloat(DecVectors[i]);
+	CheckDecfloatOverflow();
+	CheckDecfloatDouble();
+
+	for (size_t i = 0; i < sizeof(IntVectors) / sizeof(IntVectors[0]); i++)
+		CheckInt128(IntVectors[i]);
+	CheckInt128Overflow();
+
+	for (size_t i = 0; i < sizeof(ScaledVectors) / sizeof(ScaledVectors[0]); i++)
+		CheckScaled(ScaledVectors[i]);
+
+	if (Failures != 0)
+	{
+		printf("\n*** FAILED ***\n%d checks failed.\n", Failures);
+		return 1;
+	}
+	printf("*** SUCCESS ***\nAll the codec vectors passed.\n");
+	return 0;
+}
+
+//
+//	EOF
+//
@@ -0,0 +1,385 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//	File    : $Id$
+//	Subject : IBPP, microbenchmark of the Row conversions
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	(C) Copyright 2000-2006 T.I.P. Group S.A. and the IBPP Team (www.ibpp.org)
+//
+//	The contents of this file are subject to the IBPP License (the "License");
+//	you may not use this file except in compliance with the License.  You may
+//	obtain a copy of the License at http://www.ibpp.org or in the 'license.txt'
+//	file which must have been distributed along with this file.
+//
+//	This software, distributed under the License, is distributed on an "AS IS"
+//	basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.  See the
+//	License for the specific language governing rights and limitations
+//	under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	COMMENTS
+//	* Tabulations should be set every four characters when editing this file.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	This file is NOT part of the IBPP core files.  It measures the cost of
+//	RowImpl::SetValue() and RowImpl::GetValue(), the conversions between the
+//	SQL types of the columns and the C++ types of Row::Set() and Row::Get().
+//	Each column is a one column row built by hand (a synthetic XSQLDA, as
+//	Statement::Prepare() would describe it), so that nothing but the
+//	conversion is timed: no server and no client library call is involved.
+//	The conversions of the array slices done by Array::ReadTo() and
+//	WriteFrom() are measured the same way, on a synthetic ISC_ARRAY_DESC.
+//
+//	Usage : rowbench [iterations]
+//
+//	Prints the ns per Set() and per Get() of each pair, '-' when the pair is
+//	not supported (WrongType) and 'range' when the value used doesn't fit.
+//	For the arrays, the ns per element written and read.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef _MSC_VER
+#pragma warning(disable: 4786 4996)
+#endif
+
+#include "../core/_ibpp.h"
+
+#ifdef IBPP_WINDOWS
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace ibpp_internals;
+
+namespace
+{
+	struct Column
+	{
+		const char* name;
+		short sqltype;
+		short sqlscale;
+		short sqllen;
+	};
+
+	const Column Columns[] =
+	{
+		{ "SMALLINT",			SQL_SHORT,			0,	2 },
+		{ "NUMERIC(4,2)",		SQL_SHORT,			-2,	2 },
+		{ "INTEGER",			SQL_LONG,			0,	4 },
+		{ "NUMERIC(9,4)",		SQL_LONG,			-4,	4 },
+		{ "BIGINT",				SQL_INT64,			0,	8 },
+		{ "NUMERIC(18,4)",		SQL_INT64,			-4,	8 },
+		{ "FLOAT",				SQL_FLOAT,			0,	4 },
+		{ "DOUBLE PRECISION",	SQL_DOUBLE,			0,	8 },
+		{ "NUMERIC(15,2) D1",	SQL_DOUBLE,			-2,	8 },	// Dialect 1
+		{ "CHAR(20)",			SQL_TEXT,			0,	20 },
+		{ "VARCHAR(40)",		SQL_VARYING,		0,	40 },
+		{ "TIMESTAMP",			SQL_TIMESTAMP,		0,	8 },
+		{ "DATE",				SQL_TYPE_DATE,		0,	4 },
+		{ "TIME",				SQL_TYPE_TIME,		0,	4 },
+		{ "BOOLEAN",			SQL_BOOLEAN,		0,	1 },
+		{ "INT128",				SQL_INT128,			0,	16 },
+		{ "NUMERIC(38,4)",		SQL_INT128,			-4,	16 },
+		{ "DECFLOAT(16)",		SQL_DEC16,			0,	8 },
+		{ "DECFLOAT(34)",		SQL_DEC34,			0,	16 },
+		{ "TIMESTAMP WITH TZ",	SQL_TIMESTAMP_TZ,	0,	12 },
+		{ "TIME WITH TZ",		SQL_TIME_TZ,		0,	8 }
+	};
+
+	int Iterations = 1000000;
+
+	int64_t NowNs()
+	{
+#ifdef IBPP_WINDOWS
+		static LARGE_INTEGER frequency;
+		if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+		LARGE_INTEGER now;
+		QueryPerformanceCounter(&now);
+		return (int64_t)((double)now.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+	}
+
+	std::string PerOp(int64_t start)
+	{
+		char text[32];
+		sprintf(text, "%.1f", (double)(NowNs() - start) / Iterations);
+		return text;
+	}
+
+	// The row of one nullable column of type c, as described by the server
+	void Describe(RowImpl& row, const Column& c)
+	{
+		XSQLDA* sqlda = row.Self();
+		sqlda->sqld = 1;
+		XSQLVAR* var = &sqlda->sqlvar[0];
+		var->sqltype = (short)(c.sqltype | 1);
+		var->sqlscale = c.sqlscale;
+		var->sqllen = c.sqllen;
+		row.AllocVariables();
+	}
+
+	//	Stores a value in the column with the first setter it accepts, so
+	//	that the Get() of every C++ type reads a non null value
+
+	template<class T>
+	bool TrySet(RowImpl& row, const T& value)
+	{
+		try { row.Set(1, value); }
+		catch (IBPP::LogicException&) { return false; }
+		return true;
+	}
+
+	void Prime(RowImpl& row)
+	{
+		if (TrySet(row, int32_t(12))) return;
+		if (TrySet(row, 12.25)) return;
+		if (TrySet(row, 12.25f)) return;
+		if (TrySet(row, std::string("12.25"))) return;
+		if (TrySet(row, IBPP::Timestamp(2024, 5, 17, 13, 45, 30, 1234))) return;
+		if (TrySet(row, IBPP::Date(2024, 5, 17))) return;
+		if (TrySet(row, IBPP::Time(13, 45, 30, 1234))) return;
+		if (TrySet(row, IBPP::TimestampTz(IBPP::Timestamp(2024, 5, 17, 13, 45, 30, 1234), 120))) return;
+		if (TrySet(row, IBPP::TimeTz(IBPP::Time(13, 45, 30, 1234), 120))) return;
+		TrySet(row, true);
+	}
+
+	template<class T>
+	std::string TimeSet(RowImpl& row, const T& value)
+	{
+		try { row.Set(1, value); }
+		catch (IBPP::WrongType&) { return "-"; }
+		catch (IBPP::LogicException&) { return "range"; }
+
+		const int64_t start = NowNs();
+		for (int i = 0; i < Iterations; i++)
+			row.Set(1, value);
+		return PerOp(start);
+	}
+
+	template<class T>
+	std::string TimeGet(RowImpl& row, T& value)
+	{
+		Prime(row);
+		try { row.Get(1, value); }
+		catch (IBPP::WrongType&) { return "-"; }
+		catch (IBPP::LogicException&) { return "range"; }
+
+		const int64_t start = NowNs();
+		for (int i = 0; i < Iterations; i++)
+			row.Get(1, value);
+		return PerOp(start);
+	}
+
+	//	The byte buffers have their own signatures
+
+	std::string TimeSetBytes(RowImpl& row)
+	{
+		static const char bytes[] = "0123456789";
+		try { row.Set(1, bytes, 10); }
+		catch (IBPP::WrongType&) { return "-"; }
+		catch (IBPP::LogicException&) { return "range"; }
+
+		const int64_t start = NowNs();
+		for (int i = 0; i < Iterations; i++)
+			row.Set(1, bytes, 10);
+		return PerOp(start);
+	}
+
+	std::string TimeGetBytes(RowImpl& row)
+	{
+		char bytes[64];
+		int len = sizeof(bytes);
+		Prime(row);
+		try { row.Get(1, bytes, len); }
+		catch (IBPP::WrongType&) { return "-"; }
+		catch (IBPP::LogicException&) { return "range"; }
+
+		const int64_t start = NowNs();
+		for (int i = 0; i < Iterations; i++)
+		{
+			len = sizeof(bytes);
+			row.Get(1, bytes, len);
+		}
+		return PerOp(start);
+	}
+
+	void Report(const Column& c, const char* type, const std::string& set,
+		const std::string& get)
+	{
+		if (set == "-" && get == "-") return;	// Not a pair at all
+		printf("%-20s %-12s %12s %12s\n", c.name, type, set.c_str(), get.c_str());
+	}
+
+	template<class T>
+	void Bench(const Column& c, const char* type, const T& value)
+	{
+		RowImpl row(3, 1, 0, 0);
+		Describe(row, c);
+		const std::string set = TimeSet(row, value);
+		T out = value;
+		const std::string get = TimeGet(row, out);
+		Report(c, type, set, get);
+	}
+
+	void BenchBytes(const Column& c)
+	{
+		RowImpl row(3, 1, 0, 0);
+		Describe(row, c);
+		const std::string set = TimeSetBytes(row);
+		const std::string get = TimeGetBytes(row);
+		Report(c, "bytes", set, get);
+	}
+
+	//	Array elements: slices of ArrayElements elements of a column, read to
+	//	and written from a user array of each ADT
+
+	struct ArrayColumn
+	{
+		const char* name;
+		unsigned char dtype;
+		char scale;
+		unsigned short length;
+	};
+
+	const ArrayColumn ArrayColumns[] =
+	{
+		{ "SMALLINT[]",			blr_short,	0,	2 },
+		{ "INTEGER[]",			blr_long,	0,	4 },
+		{ "NUMERIC(9,2)[]",		blr_long,	-2,	4 },
+		{ "BIGINT[]",			blr_int64,	0,	8 },
+		{ "NUMERIC(18,4)[]",	blr_int64,	-4,	8 },
+		{ "FLOAT[]",			blr_float,	0,	4 },
+		{ "DOUBLE PRECISION[]",	blr_double,	0,	8 }
+	};
+
+	struct ArrayType
+	{
+		const char* name;
+		IBPP::ADT adtype;
+		int size;
+	};
+
+	const ArrayType ArrayTypes[] =
+	{
+		{ "bool",		IBPP::adBool,	sizeof(bool) },
+		{ "int16_t",	IBPP::adInt16,	2 },
+		{ "int32_t",	IBPP::adInt32,	4 },
+		{ "int64_t",	IBPP::adInt64,	8 },
+		{ "float",		IBPP::adFloat,	4 },
+		{ "double",		IBPP::adDouble,	8 }
+	};
+
+	const int ArrayElements = 1024;
+
+	std::string TimeArray(const ISC_ARRAY_DESC& desc, const ArrayType& t, bool write,
+		char* slice, char* data)
+	{
+		try
+		{
+			if (write) encodeArraySlice(desc, t.adtype, data, slice, ArrayElements);
+			else decodeArraySlice(desc, slice, t.adtype, data, ArrayElements);
+		}
+		catch (IBPP::LogicException&) { return "-"; }
+
+		const int loops = Iterations / ArrayElements > 0 ? Iterations / ArrayElements : 1;
+		const int64_t start = NowNs();
+		for (int i = 0; i < loops; i++)
+		{
+			if (write) encodeArraySlice(desc, t.adtype, data, slice, ArrayElements);
+			else decodeArraySlice(desc, slice, t.adtype, data, ArrayElements);
+		}
+		char text[32];
+		sprintf(text, "%.2f", (double)(NowNs() - start) / ((double)loops * ArrayElements));
+		return text;
+	}
+
+	void BenchArray(const ArrayColumn& c, const ArrayType& t)
+	{
+		ISC_ARRAY_DESC desc;
+		memset(&desc, 0, sizeof(desc));
+		desc.array_desc_dtype = c.dtype;
+		desc.array_desc_scale = c.scale;
+		desc.array_desc_length = c.length;
+		desc.array_desc_dimensions = 1;
+		desc.array_desc_bounds[0].array_bound_lower = 1;
+		desc.array_desc_bounds[0].array_bound_upper = ArrayElements;
+
+		// Small values, in the range of every type
+		std::vector<char> slice(ArrayElements * 8, 0);
+		std::vector<char> data(ArrayElements * 8, 0);
+		for (int i = 0; i < ArrayElements; i++)
+		{
+			char* d = &data[i * t.size];
+			switch (t.adtype)
+			{
+				case IBPP::adBool : *(bool*)d = (i & 1) != 0; break;
+				case IBPP::adInt16 : *(int16_t*)d = (int16_t)(i % 100); break;
+				case IBPP::adInt32 : *(int32_t*)d = i % 100; break;
+				case IBPP::adInt64 : *(int64_t*)d = i % 100; break;
+				case IBPP::adFloat : *(float*)d = (float)(i % 100) / 4; break;
+				default : *(double*)d = (double)(i % 100) / 4; break;
+			}
+		}
+
+		const std::string set = TimeArray(desc, t, true, &slice[0], &data[0]);
+		const std::string get = TimeArray(desc, t, false, &slice[0], &data[0]);
+		if (set == "-" && get == "-") return;
+		printf("%-20s %-12s %12s %12s\n", c.name, t.name, set.c_str(), get.c_str());
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc > 1) Iterations = atoi(argv[1]);
+	if (Iterations <= 0)
+	{
+		printf("Usage : rowbench [iterations]\n");
+		return 2;
+	}
+
+	printf("%-20s %-12s %12s %12s\n", "column", "C++ type", "set ns/op", "get ns/op");
+
+	const IBPP::Timestamp timestamp(2024, 5, 17, 13, 45, 30, 1234);
+	const IBPP::Time time(13, 45, 30, 1234);
+	for (size_t i = 0; i < sizeof(Columns) / sizeof(Columns[0]); i++)
+	{
+		const Column& c = Columns[i];
+		Bench(c, "bool", true);
+		Bench(c, "int16_t", int16_t(12));
+		Bench(c, "int32_t", int32_t(12));
+		Bench(c, "int64_t", int64_t(12));
+		Bench(c, "float", 12.25f);
+		Bench(c, "double", 12.25);
+		Bench(c, "Int128", IBPP::Int128(12));
+		Bench(c, "string", std::string("12.25"));
+		BenchBytes(c);
+		Bench(c, "Timestamp", timestamp);
+		Bench(c, "Date", IBPP::Date(2024, 5, 17));
+		Bench(c, "Time", time);
+		Bench(c, "TimestampTz", IBPP::TimestampTz(timestamp, 120));
+		Bench(c, "TimeTz", IBPP::TimeTz(time, 120));
+	}
+
+	printf("\n%-20s %-12s %12s %12s\n", "array of", "C++ type", "write ns/el", "read ns/el");
+	for (size_t i = 0; i < sizeof(ArrayColumns) / sizeof(ArrayColumns[0]); i++)
+		for (size_t j = 0; j < sizeof(ArrayTypes) / sizeof(ArrayTypes[0]); j++)
+			BenchArray(ArrayColumns[i], ArrayTypes[j]);
+
+	return 0;
+}
+
+//
+//	EOF
+//
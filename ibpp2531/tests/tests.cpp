@@ -1032,6 +1032,61 @@ void Test::Test7()
 	printf("           Deletes   : %d\n", Deletes);
 	printf("           ReadIdx   : %d\n", ReadIdx);
 	printf("           ReadSeq   : %d\n", ReadSeq);
+
+	printf(_("           Non-throwing accessors (TrySet, TryGet, TryExecute)\n"));
+	tr1->Start();
+	st1->ExecuteImmediate("CREATE TABLE TRYTEST(ID INTEGER NOT NULL PRIMARY KEY, S SMALLINT)");
+	tr1->CommitRetain();
+
+	st1->Prepare("INSERT INTO TRYTEST(ID, S) VALUES(?, ?)");
+	if (st1->TrySet(1, int32_t(1)) != IBPP::rcOk ||
+		st1->TrySet(2, int64_t(100000)) != IBPP::rcOutOfRange ||
+		st1->TrySet(2, int16_t(7)) != IBPP::rcOk)
+	{
+		_Success = false;
+		printf(_("           Statement::TrySet() returned an unexpected status.\n"));
+	}
+	if (st1->TryExecute() != IBPP::rcOk)
+	{
+		_Success = false;
+		printf(_("           Statement::TryExecute() failed : %s\n"), st1->LastErrorMessage());
+	}
+	if (st1->TryExecute() != IBPP::rcSQLError || st1->LastSqlCode() != -803)
+	{
+		_Success = false;
+		printf(_("           Statement::TryExecute() did not report the duplicate key.\n"));
+	}
+	else printf(_("           Duplicate key reported, SQLCODE %d\n"), st1->LastSqlCode());
+
+	st1->Execute("SELECT ID, S FROM TRYTEST");
+	st1->Fetch();
+	std::string s;
+	int32_t id = 0;
+	if (st1->TryGet(1, s) != IBPP::rcWrongType ||
+		st1->TryGet(1, id) != IBPP::rcOk || id != 1)
+	{
+		_Success = false;
+		printf(_("           Statement::TryGet() returned an unexpected status.\n"));
+	}
+
+	// Batches : sent in one IBatch with the OO API (Firebird 4), queued and
+	// executed row by row by ExecuteBatch() otherwise : the count is the same
+	st1->Prepare("INSERT INTO TRYTEST(ID, S) VALUES(?, ?)");
+	printf(_("           Batch of 100 rows (%s)\n"),
+		st1->ServerBatch() ? "IBatch" : "queued rows");
+	for (int32_t i = 100; i < 200; i++)
+	{
+		st1->Set(1, i);
+		st1->Set(2, int16_t(i % 10));
+		st1->AddBatch();
+	}
+	if (st1->ExecuteBatch() != 100)
+	{
+		_Success = false;
+		printf(_("           Statement::ExecuteBatch() did not insert 100 rows.\n"));
+	}
+	st1->Close();
+	tr1->Commit();
 }
 
 class EventCatch : public IBPP::EventInterface
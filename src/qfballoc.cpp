@@ -0,0 +1,143 @@
+/*
+* This file is part of QtFirebirdIBPPSQLDriver - Qt SQL driver for Firebird with IBPP library
+* Copyright (C) 2006-2010 Alex Wencel
+*
+* Contact e-mail: Alex Wencel <alex.wencel@gmail.com>
+* Program URL   : http://code.google.com/p/qtfirebirdibppsqldriver
+*
+* GNU Lesser General Public License Usage
+* This file may be used under the terms of the GNU Lesser
+* General Public License version 2.1 as published by the Free Software
+* Foundation and appearing in the file LICENSE.LGPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU Lesser General Public License version 2.1 requirements
+* will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+*
+* GNU General Public License Usage
+* Alternatively, this file may be used under the terms of the GNU
+* General Public License version 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU General Public License version 3.0 requirements will be
+* met: http://www.gnu.org/copyleft/gpl.html.
+*
+*/
+
+// Allocation counters of the fb_alloc_stats build (QFB_ALLOC_STATS). The
+// allocation functions of the program are replaced by ones counting the
+// calls and sizes of each thread before calling the real allocator: malloc,
+// calloc and realloc with glibc (which also sees operator new and the Qt
+// containers), operator new elsewhere. The driver reads the counters of its
+// thread around each phase of a statement.
+
+#include "qsql_ibpp.h"
+#include "qsql_ibpp_p.h"
+
+#ifdef QFB_ALLOC_STATS
+
+#include <cstdlib>
+#include <new>
+
+// Initial exec: reading them must not allocate, even from a plugin
+#if defined(Q_CC_GNU)
+#define QFB_ALLOC_TLS __thread __attribute__((tls_model("initial-exec")))
+#else
+#define QFB_ALLOC_TLS thread_local
+#endif
+
+static QFB_ALLOC_TLS qint64 qFBAllocCount = 0;
+static QFB_ALLOC_TLS qint64 qFBAllocBytes = 0;
+
+static inline void qFBCountAlloc(size_t size)
+{
+    ++qFBAllocCount;
+    qFBAllocBytes += qint64(size);
+}
+
+#if defined(__GLIBC__)
+
+extern "C" {
+
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *p, size_t size);
+
+void *malloc(size_t size)
+{
+    qFBCountAlloc(size);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    qFBCountAlloc(count * size);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *p, size_t size)
+{
+    qFBCountAlloc(size);
+    return __libc_realloc(p, size);
+}
+
+}
+
+#else
+
+void *operator new(size_t size)
+{
+    qFBCountAlloc(size);
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    qFBCountAlloc(size);
+    return std::malloc(size ? size : 1);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { std::free(p); }
+
+#endif
+
+bool qFBAllocCounting()
+{
+    return true;
+}
+
+QFBAllocCount qFBAllocations()
+{
+    QFBAllocCount count;
+    count.allocations = qFBAllocCount;
+    count.bytes = qFBAllocBytes;
+    return count;
+}
+
+#else
+
+bool qFBAllocCounting()
+{
+    return false;
+}
+
+QFBAllocCount qFBAllocations()
+{
+    return QFBAllocCount();
+}
+
+#endif // QFB_ALLOC_STATS
@@ -0,0 +1,562 @@
+/*
+* This file is part of QtFirebirdIBPPSQLDriver - Qt SQL driver for Firebird with IBPP library
+* Copyright (C) 2006-2010 Alex Wencel
+*
+* Contact e-mail: Alex Wencel <alex.wencel@gmail.com>
+* Program URL   : http://code.google.com/p/qtfirebirdibppsqldriver
+*
+* GNU Lesser General Public License Usage
+* This file may be used under the terms of the GNU Lesser
+* General Public License version 2.1 as published by the Free Software
+* Foundation and appearing in the file LICENSE.LGPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU Lesser General Public License version 2.1 requirements
+* will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+*
+* GNU General Public License Usage
+* Alternatively, this file may be used under the terms of the GNU
+* General Public License version 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU General Public License version 3.0 requirements will be
+* met: http://www.gnu.org/copyleft/gpl.html.
+*
+*/
+
+#include <QtDebug>
+#include <QFile>
+#include <QIODevice>
+#include <QtEndian>
+#include <qsqlquery.h>
+#include <qvector.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "qfbarrowexport.h"
+#include "qsql_ibpp.h"
+
+//-----------------------------------------------------------------------//
+// Flatbuffers, the encoding of the Arrow metadata, written front to back:
+// each table before the objects it refers to, whose offsets (they must
+// point forward) are set by link() once they are written. The vtable of a
+// table is written just before it.
+class QFBFlatBuffer
+{
+public:
+    int size() const { return data.size(); }
+
+    // Zeros until size() + shift is a multiple of align
+    void pad(int align, int shift = 0)
+    {
+        while ((data.size() + shift) % align)
+            data.append('\0');
+    }
+
+    template <typename T> int put(T value)
+    {
+        const int at = data.size();
+        uchar le[sizeof(T)];
+        qToLittleEndian<T>(value, le);
+        data.append(reinterpret_cast<const char *>(le), int(sizeof(T)));
+        return at;
+    }
+
+    // Points the offset at position at to the object at target
+    void link(int at, int target)
+    {
+        qToLittleEndian<quint32>(quint32(target - at), data.data() + at);
+    }
+
+    int string(const QByteArray &s)
+    {
+        pad(4);
+        const int at = put<quint32>(quint32(s.size()));
+        data.append(s);
+        data.append('\0');
+        return at;
+    }
+
+    // A vector of count offsets, the i-th at at + 4 + 4 * i
+    int offsets(int count)
+    {
+        pad(4);
+        const int at = put<quint32>(quint32(count));
+        data.append(QByteArray(count * 4, '\0'));
+        return at;
+    }
+
+    // A vector of structs of two longs (FieldNode, Buffer), given flat
+    int longPairs(const QVector<qint64> &values)
+    {
+        pad(8, 4);
+        const int at = put<quint32>(quint32(values.count() / 2));
+        for (int i = 0; i < values.count(); ++i)
+            put<qint64>(values.at(i));
+        return at;
+    }
+
+    QByteArray data;
+};
+//-----------------------------------------------------------------------//
+// A table: its scalar fields are given by add(), the offsets with a value
+// of 0 and linked once write() has placed them (at()).
+class QFBFlatTable
+{
+public:
+    QFBFlatTable() : pos(0) {}
+
+    void add(int id, int size, qint64 value)
+    {
+        const Field f = { id, size, value };
+        fields.append(f);
+    }
+
+    void write(QFBFlatBuffer &fb)
+    {
+        // By decreasing size, each field aligned on its size
+        std::stable_sort(fields.begin(), fields.end(), bySize);
+        int slots = 0;
+        for (int i = 0; i < fields.count(); ++i)
+            slots = qMax(slots, fields.at(i).id + 1);
+        offs = QVector<int>(slots, 0);
+        int end = 4;        // After the offset to the vtable
+        int align = 4;
+        for (int i = 0; i < fields.count(); ++i)
+        {
+            const Field &f = fields.at(i);
+            end = (end + f.size - 1) / f.size * f.size;
+            offs[f.id] = end;
+            end += f.size;
+            align = qMax(align, f.size);
+        }
+
+        fb.pad(2);
+        const int vtable = fb.size();
+        fb.put<quint16>(quint16(4 + 2 * slots));
+        fb.put<quint16>(quint16(end));
+        for (int i = 0; i < slots; ++i)
+            fb.put<quint16>(quint16(offs.at(i)));
+
+        fb.pad(align);
+        pos = fb.size();
+        fb.put<qint32>(pos - vtable);
+        QByteArray table(end - 4, '\0');
+        for (int i = 0; i < fields.count(); ++i)
+        {
+            const Field &f = fields.at(i);
+            char *p = table.data() + offs.at(f.id) - 4;
+            switch (f.size)
+            {
+            case 1: *p = char(f.value); break;
+            case 2: qToLittleEndian<qint16>(qint16(f.value), p); break;
+            case 4: qToLittleEndian<qint32>(qint32(f.value), p); break;
+            default: qToLittleEndian<qint64>(f.value, p); break;
+            }
+        }
+        fb.data.append(table);
+    }
+
+    int position() const { return pos; }
+    int at(int id) const { return pos + offs.at(id); }
+
+private:
+    struct Field
+    {
+        int id;
+        int size;
+        qint64 value;
+    };
+    static bool bySize(const Field &a, const Field &b) { return a.size > b.size; }
+
+    QVector<Field> fields;
+    QVector<int> offs;
+    int pos;
+};
+//-----------------------------------------------------------------------//
+// Schema.fbs and Message.fbs values
+namespace QFBArrow
+{
+    enum { MetadataV5 = 4 };
+    enum { HeaderSchema = 1, HeaderRecordBatch = 3 };
+    enum { TypeInt = 2, TypeFloatingPoint = 3, TypeBinary = 4, TypeUtf8 = 5, TypeBool = 6,
+           TypeDecimal = 7, TypeDate = 8, TypeTime = 9, TypeTimestamp = 10 };
+    enum { PrecisionDouble = 2 };
+    enum { DateDay = 0 };
+    enum { TimeMicrosecond = 2 };
+}
+//-----------------------------------------------------------------------//
+class QFBArrowExporterPrivate
+{
+public:
+    QFBArrowExporterPrivate() : batchSize(65536), device(0), rows(0), batches(0), bytes(0) {}
+
+    void reset();
+    bool write(const char *data, qint64 length);
+    bool writeMessage(QFBFlatBuffer &fb);
+    int writeHeader(QFBFlatBuffer &fb, int headerType, qint64 bodyLength);
+    bool writeSchema();
+    bool writeBatch();
+    bool writeEnd();
+
+    int batchSize;
+    QIODevice *device;
+    QFBColumnBatch batch;
+    QVector<QByteArray> scratch;    // Buffers converted for Arrow, by column
+    qint64 rows;
+    qint64 batches;
+    qint64 bytes;
+    QSqlError error;
+};
+//-----------------------------------------------------------------------//
+void QFBArrowExporterPrivate::reset()
+{
+    rows = 0;
+    batches = 0;
+    bytes = 0;
+    error = QSqlError();
+}
+//-----------------------------------------------------------------------//
+bool QFBArrowExporterPrivate::write(const char *data, qint64 length)
+{
+    if (length == 0)
+        return true;
+    if (device->write(data, length) != length)
+    {
+        error = QSqlError(QLatin1String("Unable to write the Arrow stream"),
+                          device->errorString(), QSqlError::UnknownError);
+        return false;
+    }
+    bytes += length;
+    return true;
+}
+//-----------------------------------------------------------------------//
+// An encapsulated message: continuation marker, length of the metadata
+// padded to 8 bytes, metadata; its body follows
+bool QFBArrowExporterPrivate::writeMessage(QFBFlatBuffer &fb)
+{
+    fb.pad(8);
+    uchar prefix[8];
+    qToLittleEndian<quint32>(0xFFFFFFFFu, prefix);
+    qToLittleEndian<qint32>(fb.size(), prefix + 4);
+    return write(reinterpret_cast<const char *>(prefix), 8)
+            && write(fb.data.constData(), fb.size());
+}
+//-----------------------------------------------------------------------//
+// The root Message table; returns the position of its header offset
+int QFBArrowExporterPrivate::writeHeader(QFBFlatBuffer &fb, int headerType, qint64 bodyLength)
+{
+    const int root = fb.put<quint32>(0);
+    QFBFlatTable message;
+    message.add(0, 2, QFBArrow::MetadataV5);
+    message.add(1, 1, headerType);
+    message.add(2, 4, 0);
+    message.add(3, 8, bodyLength);
+    message.write(fb);
+    fb.link(root, message.position());
+    return message.at(2);
+}
+//-----------------------------------------------------------------------//
+bool QFBArrowExporterPrivate::writeSchema()
+{
+    QFBFlatBuffer fb;
+    const int header = writeHeader(fb, QFBArrow::HeaderSchema, 0);
+
+    // The buffers are written in the byte order of the host
+    QFBFlatTable schema;
+    schema.add(0, 2, Q_BYTE_ORDER == Q_LITTLE_ENDIAN ? 0 : 1);
+    schema.add(1, 4, 0);
+    schema.write(fb);
+    fb.link(header, schema.position());
+
+    const int cols = batch.columns.count();
+    const int fields = fb.offsets(cols);
+    fb.link(schema.at(1), fields);
+    for (int i = 0; i < cols; ++i)
+    {
+        const QFBColumn &c = batch.columns.at(i);
+        QFBFlatTable type;
+        int typeId;
+        switch (c.type)
+        {
+        case QFBColumn::Int64:
+            typeId = QFBArrow::TypeInt;
+            type.add(0, 4, 64);
+            type.add(1, 1, 1);
+            break;
+        case QFBColumn::Double:
+            typeId = QFBArrow::TypeFloatingPoint;
+            type.add(0, 2, QFBArrow::PrecisionDouble);
+            break;
+        case QFBColumn::Decimal:
+            typeId = QFBArrow::TypeDecimal;
+            type.add(0, 4, c.precision);
+            type.add(1, 4, c.scale);
+            type.add(2, 4, 128);
+            break;
+        case QFBColumn::Boolean:
+            typeId = QFBArrow::TypeBool;
+            break;
+        case QFBColumn::Date:
+            typeId = QFBArrow::TypeDate;
+            type.add(0, 2, QFBArrow::DateDay);
+            break;
+        case QFBColumn::Time:
+            typeId = QFBArrow::TypeTime;
+            type.add(0, 2, QFBArrow::TimeMicrosecond);
+            type.add(1, 4, 64);
+            break;
+        case QFBColumn::Timestamp:
+            typeId = QFBArrow::TypeTimestamp;
+            type.add(0, 2, QFBArrow::TimeMicrosecond);
+            if (c.utc)
+                type.add(1, 4, 0);
+            break;
+        case QFBColumn::Binary:
+            typeId = QFBArrow::TypeBinary;
+            break;
+        default:
+            typeId = QFBArrow::TypeUtf8;
+            break;
+        }
+
+        QFBFlatTable field;
+        field.add(0, 4, 0);         // name
+        field.add(1, 1, 1);         // nullable
+        field.add(2, 1, typeId);
+        field.add(3, 4, 0);         // type
+        field.add(5, 4, 0);         // children
+        field.write(fb);
+        fb.link(fields + 4 + 4 * i, field.position());
+        fb.link(field.at(0), fb.string(c.name.toUtf8()));
+        type.write(fb);
+        fb.link(field.at(3), type.position());
+        if (c.type == QFBColumn::Timestamp && c.utc)
+            fb.link(type.at(1), fb.string(QByteArray("UTC")));
+        fb.link(field.at(5), fb.offsets(0));
+    }
+    return writeMessage(fb);
+}
+//-----------------------------------------------------------------------//
+bool QFBArrowExporterPrivate::writeBatch()
+{
+    // The buffers of the body, in the order of the columns: validity (empty
+    // without NULL), then values, or offsets and data
+    const int cols = batch.columns.count();
+    const int n = batch.rows;
+    scratch.resize(cols);
+    QVector<const char *> data;
+    QVector<qint64> nodes;
+    QVector<qint64> buffers;
+    qint64 body = 0;
+    for (int i = 0; i < cols; ++i)
+    {
+        const QFBColumn &c = batch.columns.at(i);
+        nodes << n << c.nullCount;
+
+        const char *parts[3] = { 0, 0, 0 };
+        qint64 lengths[3] = { 0, 0, 0 };
+        int count = 2;
+        if (c.nullCount)
+        {
+            parts[0] = reinterpret_cast<const char *>(c.validity.constData());
+            lengths[0] = (n + 7) / 8;
+        }
+        QByteArray &conv = scratch[i];
+        switch (c.type)
+        {
+        case QFBColumn::Int64:
+        case QFBColumn::Time:
+        case QFBColumn::Timestamp:
+            parts[1] = reinterpret_cast<const char *>(c.ints.constData());
+            lengths[1] = qint64(n) * 8;
+            break;
+        case QFBColumn::Double:
+            parts[1] = reinterpret_cast<const char *>(c.doubles.constData());
+            lengths[1] = qint64(n) * 8;
+            break;
+        case QFBColumn::Decimal:
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+            conv.resize(c.bytes.size());
+            for (int b = 0; b < c.bytes.size(); ++b)
+                conv[b] = c.bytes.at((b & ~15) + 15 - (b & 15));
+            parts[1] = conv.constData();
+#else
+            parts[1] = c.bytes.constData();
+#endif
+            lengths[1] = c.bytes.size();
+            break;
+        case QFBColumn::Boolean:
+            conv.fill('\0', (n + 7) / 8);
+            for (int r = 0; r < n; ++r)
+                if (c.ints.at(r))
+                    conv[r >> 3] = char(conv.at(r >> 3) | (1 << (r & 7)));
+            parts[1] = conv.constData();
+            lengths[1] = conv.size();
+            break;
+        case QFBColumn::Date:
+            {
+                // date32 counts the days since 1970-01-01, Julian day 2440588
+                conv.resize(n * 4);
+                for (int r = 0; r < n; ++r)
+                {
+                    const qint32 day = qint32(c.ints.at(r) - 2440588);
+                    memcpy(conv.data() + r * 4, &day, 4);
+                }
+                parts[1] = conv.constData();
+                lengths[1] = conv.size();
+                break;
+            }
+        default:
+            parts[1] = reinterpret_cast<const char *>(c.offsets.constData());
+            lengths[1] = qint64(n + 1) * 4;
+            parts[2] = c.bytes.constData();
+            lengths[2] = c.bytes.size();
+            count = 3;
+            break;
+        }
+
+        for (int b = 0; b < count; ++b)
+        {
+            data << parts[b];
+            buffers << body << lengths[b];
+            body += (lengths[b] + 7) & ~qint64(7);
+        }
+    }
+
+    QFBFlatBuffer fb;
+    const int header = writeHeader(fb, QFBArrow::HeaderRecordBatch, body);
+    QFBFlatTable recordBatch;
+    recordBatch.add(0, 8, n);
+    recordBatch.add(1, 4, 0);
+    recordBatch.add(2, 4, 0);
+    recordBatch.write(fb);
+    fb.link(header, recordBatch.position());
+    fb.link(recordBatch.at(1), fb.longPairs(nodes));
+    fb.link(recordBatch.at(2), fb.longPairs(buffers));
+    if (!writeMessage(fb))
+        return false;
+
+    static const char zeros[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+    for (int b = 0; b < data.count(); ++b)
+    {
+        const qint64 length = buffers.at(2 * b + 1);
+        if (!write(data.at(b), length) || !write(zeros, -length & 7))
+            return false;
+    }
+    rows += n;
+    ++batches;
+    return true;
+}
+//-----------------------------------------------------------------------//
+bool QFBArrowExporterPrivate::writeEnd()
+{
+    uchar eos[8];
+    qToLittleEndian<quint32>(0xFFFFFFFFu, eos);
+    qToLittleEndian<quint32>(0, eos + 4);
+    return write(reinterpret_cast<const char *>(eos), 8);
+}
+
+//-----------------------------------------------------------------------//
+QFBArrowExporter::QFBArrowExporter()
+    : d(new QFBArrowExporterPrivate)
+{
+}
+//-----------------------------------------------------------------------//
+QFBArrowExporter::~QFBArrowExporter()
+{
+    delete d;
+}
+//-----------------------------------------------------------------------//
+void QFBArrowExporter::setBatchSize(int rows)
+{
+    d->batchSize = qMax(1, rows);
+}
+//-----------------------------------------------------------------------//
+int QFBArrowExporter::batchSize() const
+{
+    return d->batchSize;
+}
+//-----------------------------------------------------------------------//
+bool QFBArrowExporter::exportQuery(QSqlQuery &query, QIODevice *device)
+{
+    d->reset();
+    if (!device || !device->isWritable())
+    {
+        d->error = QSqlError(QLatin1String("Unable to write the Arrow stream"),
+                             QLatin1String("the device is not open for writing"),
+                             QSqlError::UnknownError);
+        return false;
+    }
+    d->device = device;
+
+    QFBColumnBatch &batch = d->batch;
+    batch.atEnd = false;
+    batch.decimals = true;
+    bool schema = false;
+    for (;;)
+    {
+        const bool fetched = QFBResult::fetchColumns(query, batch, d->batchSize);
+        if (!fetched && !batch.atEnd)
+        {
+            d->error = query.lastError();
+            if (!d->error.isValid())
+                d->error = QSqlError(QLatin1String("Unable to export the query"),
+                                     QLatin1String("not an active SELECT of a QFIREBIRD database"),
+                                     QSqlError::StatementError);
+            return false;
+        }
+        // The columns are described by the first call, even without rows
+        if (!schema && !d->writeSchema())
+            return false;
+        schema = true;
+        if (!fetched)
+            break;
+        if (!d->writeBatch())
+            return false;
+        if (batch.atEnd)
+            break;
+    }
+    return d->writeEnd();
+}
+//-----------------------------------------------------------------------//
+bool QFBArrowExporter::exportQuery(QSqlQuery &query, const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        d->reset();
+        d->error = QSqlError(QLatin1String("Unable to open the Arrow file"),
+                             file.errorString(), QSqlError::UnknownError);
+        return false;
+    }
+    if (!exportQuery(query, &file))
+        return false;
+    if (!file.flush())
+    {
+        d->error = QSqlError(QLatin1String("Unable to write the Arrow file"),
+                             file.errorString(), QSqlError::UnknownError);
+        return false;
+    }
+    return true;
+}
+//-----------------------------------------------------------------------//
+qint64 QFBArrowExporter::rows() const
+{
+    return d->rows;
+}
+//-----------------------------------------------------------------------//
+qint64 QFBArrowExporter::batches() const
+{
+    return d->batches;
+}
+//-----------------------------------------------------------------------//
+qint64 QFBArrowExporter::bytes() const
+{
+    return d->bytes;
+}
+//-----------------------------------------------------------------------//
+QSqlError QFBArrowExporter::lastError() const
+{
+    return d->error;
+}
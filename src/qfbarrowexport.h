@@ -0,0 +1,88 @@
+/*
+* This file is part of QtFirebirdIBPPSQLDriver - Qt SQL driver for Firebird with IBPP library
+* Copyright (C) 2006-2010 Alex Wencel
+*
+* Contact e-mail: Alex Wencel <alex.wencel@gmail.com>
+* Program URL   : http://code.google.com/p/qtfirebirdibppsqldriver
+*
+* GNU Lesser General Public License Usage
+* This file may be used under the terms of the GNU Lesser
+* General Public License version 2.1 as published by the Free Software
+* Foundation and appearing in the file LICENSE.LGPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU Lesser General Public License version 2.1 requirements
+* will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+*
+* GNU General Public License Usage
+* Alternatively, this file may be used under the terms of the GNU
+* General Public License version 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU General Public License version 3.0 requirements will be
+* met: http://www.gnu.org/copyleft/gpl.html.
+*
+*/
+
+#ifndef QFBARROWEXPORT_H
+#define QFBARROWEXPORT_H
+
+#include <QtCore/qglobal.h>
+#include <QtCore/qstring.h>
+#include <QtSql/qsqlerror.h>
+
+QT_BEGIN_HEADER
+class QIODevice;
+class QSqlQuery;
+class QFBArrowExporterPrivate;
+
+// Writes the rows of a SELECT as an Apache Arrow IPC stream (the streaming
+// format: a Schema message, one RecordBatch message per batchSize() rows,
+// then the end-of-stream marker), readable by pyarrow.ipc.open_stream(),
+// arrow::ipc::RecordBatchStreamReader and the like.
+//
+// The rows are read with QFBResult::fetchColumns() and the Arrow buffers
+// written from its column vectors as they are, so that only one batch is
+// held at a time. The columns map to
+//   SMALLINT, INTEGER, BIGINT      int64
+//   NUMERIC, DECIMAL, INT128       decimal128(5, 10, 19 or 38 digits, scale)
+//   FLOAT, DOUBLE PRECISION        double
+//   BOOLEAN                        bool
+//   DATE                           date32 (days)
+//   TIME [WITH TIME ZONE]          time64 (microseconds)
+//   TIMESTAMP                      timestamp (microseconds, no zone)
+//   TIMESTAMP WITH TIME ZONE       timestamp (microseconds, "UTC")
+//   CHAR, VARCHAR, text blobs      utf8
+//   OCTETS strings, other blobs    binary
+//   DECFLOAT                       utf8, as text
+// The precision of a NUMERIC is that of its storage (SMALLINT, INTEGER,
+// BIGINT or INT128): an INT128 value of 39 digits doesn't fit decimal128 and
+// fails the export. A SELECT with an array column is refused. All the fields
+// are nullable.
+class QFBArrowExporter
+{
+public:
+    QFBArrowExporter();
+    ~QFBArrowExporter();
+
+    void setBatchSize(int rows);
+    int batchSize() const;
+
+    // Writes the rows of query, a SELECT just executed on a QFIREBIRD
+    // database (forward only is best), to device or to the file fileName,
+    // created or truncated. Returns false on error, see lastError().
+    bool exportQuery(QSqlQuery &query, QIODevice *device);
+    bool exportQuery(QSqlQuery &query, const QString &fileName);
+
+    // Of the last export
+    qint64 rows() const;
+    qint64 batches() const;
+    qint64 bytes() const;   // Size of the stream
+    QSqlError lastError() const;
+
+private:
+    Q_DISABLE_COPY(QFBArrowExporter)
+    QFBArrowExporterPrivate *d;
+};
+
+QT_END_HEADER
+#endif // QFBARROWEXPORT_H
@@ -0,0 +1,445 @@
+/*
+* This file is part of QtFirebirdIBPPSQLDriver - Qt SQL driver for Firebird with IBPP library
+* Copyright (C) 2006-2010 Alex Wencel
+*
+* Contact e-mail: Alex Wencel <alex.wencel@gmail.com>
+* Program URL   : http://code.google.com/p/qtfirebirdibppsqldriver
+*
+* GNU Lesser General Public License Usage
+* This file may be used under the terms of the GNU Lesser
+* General Public License version 2.1 as published by the Free Software
+* Foundation and appearing in the file LICENSE.LGPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU Lesser General Public License version 2.1 requirements
+* will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+*
+* GNU General Public License Usage
+* Alternatively, this file may be used under the terms of the GNU
+* General Public License version 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU General Public License version 3.0 requirements will be
+* met: http://www.gnu.org/copyleft/gpl.html.
+*
+*/
+
+#include <QtDebug>
+#include <QElapsedTimer>
+#include <QTextCodec>
+#include <qlist.h>
+#include <qmutex.h>
+#include <qrunnable.h>
+#include <qthreadpool.h>
+
+#include "ibpp.h"
+#include "qfbasyncquery.h"
+#include "qsql_ibpp_p.h"
+
+//-----------------------------------------------------------------------//
+bool QFBRowStreamPrivate::push(const QFBRowBatch &batch)
+{
+    QMutexLocker locker(&mutex);
+    const bool isError = batch.error.isValid();
+    IBPP::IDatabase *db = busy;
+    busy = 0;           // waiting for the consumer, not for the server
+    while (!isError && !canceled && queue.count() >= maxPending)
+        notFull.wait(&mutex);
+    busy = db;
+
+    if (canceled)
+        return false;   // nobody is interested any more
+
+    queue.enqueue(batch);
+    notEmpty.wakeAll();
+    if (stream != 0)
+        QMetaObject::invokeMethod(stream, "batchReady", Qt::QueuedConnection);
+    return true;
+}
+//-----------------------------------------------------------------------//
+void QFBRowStreamPrivate::finish()
+{
+    QMutexLocker locker(&mutex);
+    done = true;
+    busy = 0;
+    notEmpty.wakeAll();
+    if (stream != 0)
+        QMetaObject::invokeMethod(stream, "finished", Qt::QueuedConnection);
+}
+//-----------------------------------------------------------------------//
+void QFBRowStreamPrivate::cancel()
+{
+    QMutexLocker locker(&mutex);
+    if (canceled)
+        return;
+
+    canceled = true;
+    queue.clear();
+    notFull.wakeAll();
+    notEmpty.wakeAll();
+
+    // the worker can't leave the server call, nor the attachment, meanwhile
+    if (busy != 0)
+    {
+        try
+        {
+            raised = busy->CancelOperation();
+        }
+        catch (IBPP::Exception& e)
+        {
+            qWarning("QFBRowStream::cancel: %s", e.ErrorMessage());
+        }
+    }
+}
+//-----------------------------------------------------------------------//
+bool QFBRowStreamPrivate::isCanceled() const
+{
+    QMutexLocker locker(&mutex);
+    return canceled;
+}
+//-----------------------------------------------------------------------//
+void QFBRowStreamPrivate::setBusy(IBPP::IDatabase *db)
+{
+    QMutexLocker locker(&mutex);
+    busy = db;
+}
+//-----------------------------------------------------------------------//
+bool QFBRowStreamPrivate::cancelRaised() const
+{
+    QMutexLocker locker(&mutex);
+    return raised;
+}
+
+//-----------------------------------------------------------------------//
+//-----------------------------------------------------------------------//
+QFBRowStream::QFBRowStream(const QSharedPointer<QFBRowStreamPrivate> &dd, QObject *parent)
+    : QObject(parent), d(dd)
+{
+    QMutexLocker locker(&d->mutex);
+    d->stream = this;
+}
+//-----------------------------------------------------------------------//
+QFBRowStream::~QFBRowStream()
+{
+    {
+        QMutexLocker locker(&d->mutex);
+        d->stream = 0;
+    }
+    d->cancel();
+}
+//-----------------------------------------------------------------------//
+bool QFBRowStream::hasBatch() const
+{
+    QMutexLocker locker(&d->mutex);
+    return !d->queue.isEmpty();
+}
+//-----------------------------------------------------------------------//
+QFBRowBatch QFBRowStream::takeBatch()
+{
+    QMutexLocker locker(&d->mutex);
+    if (d->queue.isEmpty())
+        return QFBRowBatch();
+
+    d->notFull.wakeAll();
+    return d->queue.dequeue();
+}
+//-----------------------------------------------------------------------//
+bool QFBRowStream::waitForBatch(int msecs)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QMutexLocker locker(&d->mutex);
+    while (d->queue.isEmpty() && !d->done && !d->canceled)
+    {
+        if (msecs < 0)
+            d->notEmpty.wait(&d->mutex);
+        else
+        {
+            const qint64 left = msecs - timer.elapsed();
+            if (left <= 0 || !d->notEmpty.wait(&d->mutex, (unsigned long)left))
+                break;
+        }
+    }
+    return !d->queue.isEmpty();
+}
+//-----------------------------------------------------------------------//
+int QFBRowStream::pendingBatches() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->queue.count();
+}
+//-----------------------------------------------------------------------//
+bool QFBRowStream::isFinished() const
+{
+    QMutexLocker locker(&d->mutex);
+    return (d->done || d->canceled) && d->queue.isEmpty();
+}
+//-----------------------------------------------------------------------//
+void QFBRowStream::cancel()
+{
+    d->cancel();
+}
+//-----------------------------------------------------------------------//
+bool QFBRowStream::isCanceled() const
+{
+    return d->isCanceled();
+}
+
+//-----------------------------------------------------------------------//
+//-----------------------------------------------------------------------//
+class QFBAsyncQueryPrivate
+{
+public:
+    QFBAsyncQueryPrivate()
+        : batchSize(256), maxPending(4), textCodec(0)
+    {
+        // one worker per connection: jobs run in submission order
+        pool.setMaxThreadCount(1);
+        pool.setExpiryTimeout(-1);
+    }
+
+    bool attach(QSqlError &error);
+    void detach();
+    void finish(const QSharedPointer<QFBRowStreamPrivate> &out);
+
+public:
+    QFBConnectionParams params;
+
+    int batchSize;
+    int maxPending;
+
+    QThreadPool pool;
+    QMutex mutex;
+    QList<QSharedPointer<QFBRowStreamPrivate> > pending;
+
+    // used from the worker thread only
+    IBPP::Database iDb;
+    QTextCodec *textCodec;
+};
+
+//-----------------------------------------------------------------------//
+bool QFBAsyncQueryPrivate::attach(QSqlError &error)
+{
+    if (iDb != 0 && iDb->Connected())
+        return true;
+
+    return qFBAttach(params, iDb, textCodec, error);
+}
+//-----------------------------------------------------------------------//
+void QFBAsyncQueryPrivate::detach()
+{
+    qFBDetach(iDb);
+}
+//-----------------------------------------------------------------------//
+void QFBAsyncQueryPrivate::finish(const QSharedPointer<QFBRowStreamPrivate> &out)
+{
+    {
+        QMutexLocker locker(&mutex);
+        pending.removeOne(out);
+    }
+    out->finish();
+}
+//-----------------------------------------------------------------------//
+class QFBAsyncJob : public QRunnable
+{
+public:
+    QFBAsyncJob(QFBAsyncQueryPrivate *dd, const QSharedPointer<QFBRowStreamPrivate> &o,
+                const QString &q, const QVector<QVariant> &v)
+        : d(dd), out(o), query(q), values(v), batchSize(dd->batchSize)
+    {}
+
+    void run() Q_DECL_OVERRIDE;
+
+private:
+    void execute();
+
+    QFBAsyncQueryPrivate *d;
+    QSharedPointer<QFBRowStreamPrivate> out;
+    QString query;
+    QVector<QVariant> values;
+    int batchSize;
+};
+
+//-----------------------------------------------------------------------//
+void QFBAsyncJob::run()
+{
+    if (!out->isCanceled())
+        execute();
+
+    // a cancel request could hit the next statement of this attachment
+    if (out->cancelRaised())
+        d->detach();
+    d->finish(out);
+}
+//-----------------------------------------------------------------------//
+void QFBAsyncJob::execute()
+{
+    QFBRowBatch batch;
+    if (!d->attach(batch.error))
+    {
+        out->push(batch);
+        return;
+    }
+
+    IBPP::Transaction tr;
+    IBPP::Statement st;
+    try
+    {
+        tr = IBPP::TransactionFactory(d->iDb);
+        tr->Start();
+        st = IBPP::StatementFactory(d->iDb, tr);
+
+        out->setBusy(d->iDb.intf());
+        st->Prepare(qFBToIBPPStr(query, d->textCodec));
+
+        if (!values.isEmpty() && !qFBBindValues(st, values, d->textCodec, batch.error))
+        {
+            out->setBusy(0);
+            tr->Rollback();
+            out->push(batch);
+            return;
+        }
+
+        st->Execute();
+
+        if (st->Type() == IBPP::stSelect)
+        {
+            batch.record = qFBRecord(st);
+            const int cols = st->Columns();
+            int reported = 0;
+            QFBArrayCache arrays;
+
+            while (!out->isCanceled() && st->Fetch())
+            {
+                QVector<QVariant> row(cols);
+                qFBFetchRow(d->iDb, tr, st, row.data(), d->textCodec, 0, 0, &arrays);
+                batch.rows.append(row);
+
+                if (batch.rows.count() >= batchSize)
+                {
+                    if (!out->push(batch))
+                        break;
+                    batch.rows.clear();
+                    ++reported;
+                }
+            }
+            out->setBusy(0);
+
+            if (out->isCanceled())
+            {
+                st->Close();
+                tr->Rollback();
+            }
+            else
+            {
+                tr->Commit();
+                if (!batch.rows.isEmpty() || reported == 0)
+                    out->push(batch);
+            }
+        }
+        else
+        {
+            out->setBusy(0);
+            batch.numRowsAffected = st->AffectedRows();
+            tr->Commit();
+            out->push(batch);
+        }
+    }
+    catch (IBPP::Exception& e)
+    {
+        out->setBusy(0);
+        try
+        {
+            if (tr != 0 && tr->Started())
+                tr->Rollback();
+        }
+        catch (IBPP::Exception&)
+        {
+        }
+
+        batch.rows.clear();
+        batch.error = QSqlError(QLatin1String("Unable execute statement"),
+                                QString::fromLatin1(e.ErrorMessage()), QSqlError::StatementError);
+        out->push(batch);
+    }
+}
+//-----------------------------------------------------------------------//
+class QFBAsyncDetach : public QRunnable
+{
+public:
+    explicit QFBAsyncDetach(QFBAsyncQueryPrivate *dd) : d(dd) {}
+    void run() Q_DECL_OVERRIDE { d->detach(); }
+
+private:
+    QFBAsyncQueryPrivate *d;
+};
+
+//-----------------------------------------------------------------------//
+//-----------------------------------------------------------------------//
+QFBAsyncQuery::QFBAsyncQuery(const QSqlDatabase &db, QObject *parent)
+    : QObject(parent), d(new QFBAsyncQueryPrivate)
+{
+    qRegisterMetaType<QFBRowBatch>("QFBRowBatch");
+
+    if (db.driverName() != QLatin1String("QFIREBIRD"))
+        qWarning("QFBAsyncQuery: '%s' is not a QFIREBIRD connection",
+                 db.connectionName().toLocal8Bit().constData());
+
+    d->params = QFBConnectionParams(db);
+}
+//-----------------------------------------------------------------------//
+QFBAsyncQuery::~QFBAsyncQuery()
+{
+    cancelAll();
+    d->pool.start(new QFBAsyncDetach(d));
+    d->pool.waitForDone();
+    delete d;
+}
+//-----------------------------------------------------------------------//
+void QFBAsyncQuery::setBatchSize(int rows)
+{
+    d->batchSize = qMax(1, rows);
+}
+//-----------------------------------------------------------------------//
+int QFBAsyncQuery::batchSize() const
+{
+    return d->batchSize;
+}
+//-----------------------------------------------------------------------//
+void QFBAsyncQuery::setMaxPendingBatches(int count)
+{
+    d->maxPending = qMax(1, count);
+}
+//-----------------------------------------------------------------------//
+int QFBAsyncQuery::maxPendingBatches() const
+{
+    return d->maxPending;
+}
+//-----------------------------------------------------------------------//
+QFBRowStream *QFBAsyncQuery::exec(const QString &query,
+                                  const QVector<QVariant> &boundValues)
+{
+    QSharedPointer<QFBRowStreamPrivate> out(new QFBRowStreamPrivate(d->maxPending));
+    QFBRowStream *stream = new QFBRowStream(out, this);
+
+    {
+        QMutexLocker locker(&d->mutex);
+        d->pending.append(out);
+    }
+    d->pool.start(new QFBAsyncJob(d, out, query, boundValues));
+
+    return stream;
+}
+//-----------------------------------------------------------------------//
+void QFBAsyncQuery::cancelAll()
+{
+    QMutexLocker locker(&d->mutex);
+    for (int i = 0; i < d->pending.count(); ++i)
+        d->pending[i]->cancel();
+}
+//-----------------------------------------------------------------------//
+bool QFBAsyncQuery::waitForDone(int msecs)
+{
+    return d->pool.waitForDone(msecs);
+}
+//-----------------------------------------------------------------------//
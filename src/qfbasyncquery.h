@@ -0,0 +1,126 @@
+/*
+* This file is part of QtFirebirdIBPPSQLDriver - Qt SQL driver for Firebird with IBPP library
+* Copyright (C) 2006-2010 Alex Wencel
+*
+* Contact e-mail: Alex Wencel <alex.wencel@gmail.com>
+* Program URL   : http://code.google.com/p/qtfirebirdibppsqldriver
+*
+* GNU Lesser General Public License Usage
+* This file may be used under the terms of the GNU Lesser
+* General Public License version 2.1 as published by the Free Software
+* Foundation and appearing in the file LICENSE.LGPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU Lesser General Public License version 2.1 requirements
+* will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+*
+* GNU General Public License Usage
+* Alternatively, this file may be used under the terms of the GNU
+* General Public License version 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU General Public License version 3.0 requirements will be
+* met: http://www.gnu.org/copyleft/gpl.html.
+*
+*/
+
+#ifndef QFBASYNCQUERY_H
+#define QFBASYNCQUERY_H
+
+#include <QtCore/qobject.h>
+#include <QtCore/qmetatype.h>
+#include <QtCore/qsharedpointer.h>
+#include <QtCore/qvariant.h>
+#include <QtCore/qvector.h>
+#include <QtSql/qsqldatabase.h>
+#include <QtSql/qsqlerror.h>
+#include <QtSql/qsqlrecord.h>
+
+QT_BEGIN_HEADER
+class QFBAsyncQueryPrivate;
+class QFBRowStreamPrivate;
+
+// One result of an asynchronous query. A SELECT reports one batch per
+// batchSize() rows, other statements report a single batch with
+// numRowsAffected set. If error is valid it is the last batch.
+struct QFBRowBatch
+{
+    QFBRowBatch() : numRowsAffected(-1) {}
+
+    QSqlRecord record;
+    QVector<QVector<QVariant> > rows;
+    int numRowsAffected;
+    QSqlError error;
+};
+
+// The batches of one query, handed over from the worker thread filling it.
+// At most maxPendingBatches() of the query wait to be taken: past them the
+// worker stops fetching until takeBatch() is called, and a taken batch is no
+// longer held by the stream. batchReady() and finished() are queued to the
+// thread of the stream; waitForBatch() blocks instead. Deleting the stream
+// cancels its query.
+class QFBRowStream : public QObject
+{
+    Q_OBJECT
+public:
+    virtual ~QFBRowStream();
+
+    bool hasBatch() const;
+    QFBRowBatch takeBatch();                // an empty batch if none waits
+    bool waitForBatch(int msecs = -1);      // false at the end, or on timeout
+    int pendingBatches() const;
+    bool isFinished() const;                // ended, every batch taken
+
+    void cancel();
+    bool isCanceled() const;
+
+Q_SIGNALS:
+    void batchReady();
+    void finished();
+
+private:
+    friend class QFBAsyncQuery;
+    friend class QFBParallelQuery;
+    QFBRowStream(const QSharedPointer<QFBRowStreamPrivate> &dd, QObject *parent);
+
+    Q_DISABLE_COPY(QFBRowStream)
+    QSharedPointer<QFBRowStreamPrivate> d;
+};
+
+// Runs prepare/execute/fetch for a QFIREBIRD connection on a worker thread.
+// Each QFBAsyncQuery owns its own attachment, opened with the parameters of
+// the QSqlDatabase it was created from, and a single worker thread, so the
+// queries given to exec() run one after another in submission order.
+//
+// exec() returns a stream owned by the QFBAsyncQuery. Cancelling it drops
+// the query from the queue; while the query runs it stops the fetch at the
+// next row and asks the server to stop a prepare or an execution in progress
+// (fb_cancel_operation, Firebird 2.5 and later; older client libraries let
+// it end first). An attachment whose operation was cancelled on the server
+// is closed, the next query opens a new one.
+class QFBAsyncQuery : public QObject
+{
+    Q_OBJECT
+public:
+    explicit QFBAsyncQuery(const QSqlDatabase &db, QObject *parent = nullptr);
+    virtual ~QFBAsyncQuery();
+
+    void setBatchSize(int rows);
+    int batchSize() const;
+    void setMaxPendingBatches(int count);
+    int maxPendingBatches() const;
+
+    QFBRowStream *exec(const QString &query,
+                       const QVector<QVariant> &boundValues = QVector<QVariant>());
+
+    void cancelAll();
+    bool waitForDone(int msecs = -1);
+
+private:
+    Q_DISABLE_COPY(QFBAsyncQuery)
+    QFBAsyncQueryPrivate *d;
+};
+
+Q_DECLARE_METATYPE(QFBRowBatch)
+
+QT_END_HEADER
+#endif // QFBASYNCQUERY_H
@@ -0,0 +1,1242 @@
+/*
+* This file is part of QtFirebirdIBPPSQLDriver - Qt SQL driver for Firebird with IBPP library
+* Copyright (C) 2006-2010 Alex Wencel
+*
+* Contact e-mail: Alex Wencel <alex.wencel@gmail.com>
+* Program URL   : http://code.google.com/p/qtfirebirdibppsqldriver
+*
+* GNU Lesser General Public License Usage
+* This file may be used under the terms of the GNU Lesser
+* General Public License version 2.1 as published by the Free Software
+* Foundation and appearing in the file LICENSE.LGPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU Lesser General Public License version 2.1 requirements
+* will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+*
+* GNU General Public License Usage
+* Alternatively, this file may be used under the terms of the GNU
+* General Public License version 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU General Public License version 3.0 requirements will be
+* met: http://www.gnu.org/copyleft/gpl.html.
+*
+*/
+
+#include <QtDebug>
+#include <QDataStream>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QIODevice>
+#include <QTextCodec>
+#include <qfutureinterface.h>
+#include <qlist.h>
+#include <qmutex.h>
+#include <qqueue.h>
+#include <qrunnable.h>
+#include <qthreadpool.h>
+#include <qwaitcondition.h>
+
+#include <climits>
+#include <cstring>
+
+#include "ibpp.h"
+#include "qfbbulkloader.h"
+#include "qsql_ibpp_p.h"
+
+//-----------------------------------------------------------------------//
+// Settings of one load, copied when it is started
+struct QFBBulkSettings
+{
+    QFBBulkSettings()
+        : format(QFBBulkLoader::Csv), delimiter(','), header(false),
+          method(QFBBulkLoader::Auto), batchSize(1000), commitRows(100000), maxRejected(-1)
+    {}
+
+    QString table;
+    QStringList columns;
+    QVector<int> fields;
+    QFBBulkLoader::Format format;
+    char delimiter;
+    bool header;
+    QFBBulkLoader::Method method;
+    int batchSize;
+    int commitRows;
+    qint64 maxRejected;
+};
+
+// Type of one target column, as described by the prepared INSERT
+struct QFBBulkColumn
+{
+    QFBBulkColumn() : type(IBPP::sdString), scale(0), subtype(0) {}
+
+    IBPP::SDT type;
+    int scale;
+    int subtype;
+};
+
+// Rows parsed by the reader, their values in the order of the columns
+struct QFBBulkChunk
+{
+    QFBBulkChunk() : rowsRead(0) {}
+
+    QVector<QVector<QVariant> > rows;
+    QVector<qint64> rowNumbers;
+    QList<QFBBulkRejectedRow> rejected;
+    qint64 rowsRead;
+    QString error;          // the input can't be read any further
+};
+
+//-----------------------------------------------------------------------//
+// Bounded FIFO of chunks between the reader and the loading job
+class QFBBulkQueue
+{
+public:
+    QFBBulkQueue() : mClosed(false), mAborted(false) {}
+
+    bool push(const QFBBulkChunk &chunk);
+    bool pop(QFBBulkChunk &chunk);
+    void close();
+    void abort();
+
+private:
+    enum { Capacity = 4 };
+
+    QMutex mMutex;
+    QWaitCondition mNotEmpty;
+    QWaitCondition mNotFull;
+    QQueue<QFBBulkChunk> mQueue;
+    bool mClosed;
+    bool mAborted;
+};
+
+//-----------------------------------------------------------------------//
+bool QFBBulkQueue::push(const QFBBulkChunk &chunk)
+{
+    QMutexLocker locker(&mMutex);
+    while (mQueue.count() >= Capacity && !mAborted)
+        mNotFull.wait(&mMutex);
+
+    if (mAborted)
+        return false;   // nobody is interested any more
+
+    mQueue.enqueue(chunk);
+    mNotEmpty.wakeAll();
+    return true;
+}
+//-----------------------------------------------------------------------//
+bool QFBBulkQueue::pop(QFBBulkChunk &chunk)
+{
+    QMutexLocker locker(&mMutex);
+    while (mQueue.isEmpty() && !mClosed)
+        mNotEmpty.wait(&mMutex);
+
+    if (mQueue.isEmpty())
+        return false;
+
+    chunk = mQueue.dequeue();
+    mNotFull.wakeAll();
+    return true;
+}
+//-----------------------------------------------------------------------//
+void QFBBulkQueue::close()
+{
+    QMutexLocker locker(&mMutex);
+    mClosed = true;
+    mNotEmpty.wakeAll();
+}
+//-----------------------------------------------------------------------//
+void QFBBulkQueue::abort()
+{
+    QMutexLocker locker(&mMutex);
+    mAborted = true;
+    mQueue.clear();
+    mNotFull.wakeAll();
+}
+
+//-----------------------------------------------------------------------//
+// Name of an SQL identifier as stored in the system tables
+static QString qFBBulkName(const QString &identifier)
+{
+    const QString id = identifier.trimmed();
+    if (id.length() >= 2 && id.startsWith(QLatin1Char('"')) && id.endsWith(QLatin1Char('"')))
+        return id.mid(1, id.length() - 2).replace(QLatin1String("\"\""), QLatin1String("\""));
+    return id.toUpper();
+}
+//-----------------------------------------------------------------------//
+static QString qFBBulkQuoted(QString name)
+{
+    return QLatin1Char('"') + name.replace(QLatin1String("\""), QLatin1String("\"\""))
+            + QLatin1Char('"');
+}
+//-----------------------------------------------------------------------//
+// Converts a Csv field to a value of the type of col. An empty unquoted
+// field is NULL.
+static bool qFBBulkValue(const QFBBulkColumn &col, const QByteArray &text, bool quoted,
+                         QVariant &value, QString &message)
+{
+    if (text.isEmpty() && !quoted)
+    {
+        value = QVariant();
+        return true;
+    }
+
+    bool ok = true;
+    switch (col.type)
+    {
+    case IBPP::sdSmallint:
+    case IBPP::sdInteger:
+    case IBPP::sdLargeint:
+        if (col.scale == 0)
+        {
+            const qlonglong v = text.trimmed().toLongLong(&ok);
+            if (ok && col.type == IBPP::sdSmallint)
+                ok = v >= SHRT_MIN && v <= SHRT_MAX;
+            else if (ok && col.type == IBPP::sdInteger)
+                ok = v >= INT_MIN && v <= INT_MAX;
+            value = v;
+            break;
+        }
+        {
+            // A NUMERIC is checked at its scale and bound as text, which
+            // IBPP reads exactly: through a double its last digits change
+            const std::string number(text.trimmed().constData());
+            IBPP::Int128 scaled;
+            ok = scaled.FromString(number, col.scale) && scaled.FitsInt64();
+            const qint64 v = qint64(scaled.Low());
+            if (ok && col.type == IBPP::sdSmallint)
+                ok = v >= SHRT_MIN && v <= SHRT_MAX;
+            else if (ok && col.type == IBPP::sdInteger)
+                ok = v >= INT_MIN && v <= INT_MAX;
+            value = QString::fromLatin1(number.c_str());
+            break;
+        }
+    case IBPP::sdFloat:
+    case IBPP::sdDouble:
+        value = text.trimmed().toDouble(&ok);
+        break;
+    case IBPP::sdInt128:
+    case IBPP::sdDecfloat16:
+    case IBPP::sdDecfloat34:
+        value = QString::fromLatin1(text.trimmed());    // parsed by IBPP
+        break;
+    case IBPP::sdDate:
+        {
+            const QDate date = QDate::fromString(QString::fromLatin1(text.trimmed()), Qt::ISODate);
+            ok = date.isValid();
+            value = date;
+            break;
+        }
+    case IBPP::sdTime:
+    case IBPP::sdTimeTz:
+        {
+            const QTime time = QTime::fromString(QString::fromLatin1(text.trimmed()), Qt::ISODate);
+            ok = time.isValid();
+            value = time;
+            break;
+        }
+    case IBPP::sdTimestamp:
+    case IBPP::sdTimestampTz:
+        {
+            QString s = QString::fromLatin1(text.trimmed());
+            if (s.length() > 10 && s.at(10) == QLatin1Char(' '))
+                s[10] = QLatin1Char('T');
+            const QDateTime dateTime = QDateTime::fromString(s, Qt::ISODate);
+            ok = dateTime.isValid();
+            value = dateTime;
+            break;
+        }
+    case IBPP::sdBoolean:
+        {
+            const QByteArray b = text.trimmed().toLower();
+            if (b == "true" || b == "t" || b == "yes" || b == "y" || b == "1")
+                value = true;
+            else if (b == "false" || b == "f" || b == "no" || b == "n" || b == "0")
+                value = false;
+            else
+                ok = false;
+            break;
+        }
+    case IBPP::sdString:
+        value = QString::fromUtf8(text);
+        break;
+    case IBPP::sdBlob:
+        if (col.subtype == 1)
+            value = QString::fromUtf8(text);
+        else
+            value = QByteArray(text.constData(), text.size());  // text may be raw data
+        break;
+    default:
+        message = QLatin1String("type not supported by the loader");
+        return false;
+    }
+
+    if (!ok)
+        message = QString::fromLatin1("invalid value '%1'").arg(QString::fromUtf8(text.left(64)));
+    return ok;
+}
+
+//-----------------------------------------------------------------------//
+enum QFBCsvStatus { CsvRecord, CsvNeedData, CsvEnd, CsvUnterminated };
+
+// Splits the record of buf starting at pos into fields. CsvNeedData is
+// returned when the record may go on past the end of buf and more input
+// follows. Unquoted fields are raw data of buf.
+static QFBCsvStatus qFBCsvRecord(const QByteArray &buf, int &pos, bool atEnd, char delimiter,
+                                 QVector<QByteArray> &fields, QVector<bool> &quoted)
+{
+    const char *data = buf.constData();
+    const int n = buf.size();
+    int p = pos;
+    fields.resize(0);
+    quoted.resize(0);
+    if (p >= n)
+        return atEnd ? CsvEnd : CsvNeedData;
+
+    for (;;)
+    {
+        QByteArray field;
+        const bool q = data[p] == '"';
+        if (q)
+        {
+            ++p;
+            for (;;)
+            {
+                const char *quote = p < n ? static_cast<const char *>(memchr(data + p, '"', n - p)) : 0;
+                if (!quote)
+                    return atEnd ? CsvUnterminated : CsvNeedData;
+                field.append(data + p, int(quote - data) - p);
+                p = int(quote - data) + 1;
+                if (p >= n && !atEnd)
+                    return CsvNeedData;
+                if (p < n && data[p] == '"')
+                {
+                    field.append('"');
+                    ++p;
+                    continue;
+                }
+                break;
+            }
+            // Text after the closing quote is kept, as its writer meant it
+            const int start = p;
+            while (p < n && data[p] != delimiter && data[p] != '\n' && data[p] != '\r')
+                ++p;
+            field.append(data + start, p - start);
+        }
+        else
+        {
+            const int start = p;
+            while (p < n && data[p] != delimiter && data[p] != '\n' && data[p] != '\r')
+                ++p;
+            field = QByteArray::fromRawData(data + start, p - start);
+        }
+        fields.append(field);
+        quoted.append(q);
+
+        if (p >= n)
+        {
+            if (!atEnd)
+                return CsvNeedData;
+            pos = p;
+            return CsvRecord;
+        }
+        if (data[p] == delimiter)
+        {
+            ++p;
+            continue;
+        }
+        if (data[p] == '\r')
+        {
+            if (p + 1 >= n && !atEnd)
+                return CsvNeedData;
+            if (++p < n && data[p] == '\n')
+                ++p;
+        }
+        else
+            ++p;
+        pos = p;
+        return CsvRecord;
+    }
+}
+
+//-----------------------------------------------------------------------//
+// Reads and converts the input on its own thread, feeding the queue
+class QFBBulkReader : public QRunnable
+{
+public:
+    QFBBulkReader(const QFBBulkSettings &settings, const QVector<QFBBulkColumn> &types,
+                  QIODevice *device, QFBBulkQueue *queue)
+        : s(settings), mTypes(types), mDevice(device), mQueue(queue)
+    {}
+
+    void run() Q_DECL_OVERRIDE;
+
+private:
+    enum { ChunkRows = 1024, ReadSize = 1 << 20 };
+
+    void readCsv();
+    void readBinary();
+    bool mapHeader(const QVector<QByteArray> &names, QString &error);
+    void reject(qint64 row, const QString &message);
+    bool push(bool full);
+
+    QFBBulkSettings s;
+    QVector<QFBBulkColumn> mTypes;
+    QVector<int> mMap;              // field of each column
+    QIODevice *mDevice;
+    QFBBulkQueue *mQueue;
+    QFBBulkChunk mChunk;
+};
+
+//-----------------------------------------------------------------------//
+void QFBBulkReader::run()
+{
+    mMap = s.fields;
+    if (mMap.isEmpty())
+    {
+        for (int c = 0; c < mTypes.count(); ++c)
+            mMap.append(c);
+    }
+
+    if (s.format == QFBBulkLoader::Binary)
+        readBinary();
+    else
+        readCsv();
+
+    push(false);
+    mQueue->close();
+}
+//-----------------------------------------------------------------------//
+void QFBBulkReader::reject(qint64 row, const QString &message)
+{
+    QFBBulkRejectedRow r;
+    r.row = row;
+    r.message = message;
+    mChunk.rejected.append(r);
+}
+//-----------------------------------------------------------------------//
+// Hands the chunk over when full (or anyway); false once the load stopped
+bool QFBBulkReader::push(bool full)
+{
+    if (full && mChunk.rows.count() + mChunk.rejected.count() < ChunkRows)
+        return true;
+
+    const bool pushed = mQueue->push(mChunk);
+    mChunk = QFBBulkChunk();
+    return pushed;
+}
+//-----------------------------------------------------------------------//
+bool QFBBulkReader::mapHeader(const QVector<QByteArray> &names, QString &error)
+{
+    if (!s.fields.isEmpty())
+        return true;    // fields given by index, the header is skipped
+
+    for (int c = 0; c < s.columns.count(); ++c)
+    {
+        const QString column = qFBBulkName(s.columns.at(c));
+        int f = 0;
+        while (f < names.count()
+               && QString::fromUtf8(names.at(f)).trimmed().compare(column, Qt::CaseInsensitive) != 0)
+            ++f;
+        if (f == names.count())
+        {
+            error = QString::fromLatin1("Column %1 is not in the header").arg(column);
+            return false;
+        }
+        mMap[c] = f;
+    }
+    return true;
+}
+//-----------------------------------------------------------------------//
+void QFBBulkReader::readCsv()
+{
+    QByteArray buf;
+    int pos = 0;
+    bool atEnd = false;
+    bool headerRead = !s.header;
+    qint64 number = 0;
+    QVector<QByteArray> fields;
+    QVector<bool> quoted;
+    QString message;
+
+    for (;;)
+    {
+        const QFBCsvStatus status = qFBCsvRecord(buf, pos, atEnd, s.delimiter, fields, quoted);
+        if (status == CsvEnd)
+            break;
+
+        if (status == CsvNeedData)
+        {
+            buf.remove(0, pos);
+            pos = 0;
+            const int size = buf.size();
+            buf.resize(size + ReadSize);
+            const qint64 read = mDevice->read(buf.data() + size, ReadSize);
+            if (read < 0)
+            {
+                mChunk.error = mDevice->errorString();
+                return;
+            }
+            buf.resize(size + int(read));
+            atEnd = read == 0;
+            continue;
+        }
+
+        if (status == CsvUnterminated)
+        {
+            ++number;
+            ++mChunk.rowsRead;
+            reject(number, QLatin1String("unterminated quoted field"));
+            return;
+        }
+
+        if (fields.count() == 1 && fields.at(0).isEmpty() && !quoted.at(0))
+            continue;   // blank line
+
+        if (!headerRead)
+        {
+            headerRead = true;
+            if (!mapHeader(fields, mChunk.error))
+                return;
+            continue;
+        }
+
+        ++number;
+        ++mChunk.rowsRead;
+        QVector<QVariant> row(mTypes.count());
+        message.clear();
+        for (int c = 0; c < mTypes.count() && message.isEmpty(); ++c)
+        {
+            const int f = mMap.at(c);
+            if (f >= fields.count())
+                message = QString::fromLatin1("%1: missing field %2").arg(s.columns.at(c)).arg(f + 1);
+            else if (!qFBBulkValue(mTypes.at(c), fields.at(f), quoted.at(f), row[c], message))
+                message.prepend(s.columns.at(c) + QLatin1String(": "));
+        }
+
+        if (message.isEmpty())
+        {
+            mChunk.rows.append(row);
+            mChunk.rowNumbers.append(number);
+        }
+        else
+            reject(number, message);
+
+        if (!push(true))
+            return;
+    }
+}
+//-----------------------------------------------------------------------//
+void QFBBulkReader::readBinary()
+{
+    QDataStream in(mDevice);
+    in.setVersion(QDataStream::Qt_5_0);
+    qint64 number = 0;
+    QVector<QVariant> input;
+
+    while (!in.atEnd())
+    {
+        in >> input;
+        if (in.status() != QDataStream::Ok)
+        {
+            mChunk.error = QString::fromLatin1("Row %1 is truncated or corrupt").arg(number + 1);
+            return;
+        }
+
+        ++number;
+        ++mChunk.rowsRead;
+        QVector<QVariant> row(mTypes.count());
+        int c = 0;
+        while (c < mTypes.count() && mMap.at(c) < input.count())
+        {
+            row[c] = input.at(mMap.at(c));
+            ++c;
+        }
+
+        if (c == mTypes.count())
+        {
+            mChunk.rows.append(row);
+            mChunk.rowNumbers.append(number);
+        }
+        else
+            reject(number, QString::fromLatin1("%1: missing field %2")
+                   .arg(s.columns.at(c)).arg(mMap.at(c) + 1));
+
+        if (!push(true))
+            return;
+    }
+}
+
+//-----------------------------------------------------------------------//
+class QFBBulkLoaderPrivate
+{
+public:
+    QFBBulkLoaderPrivate()
+        : textCodec(0)
+    {
+        // one load at a time, and one reader for it
+        pool.setMaxThreadCount(1);
+        pool.setExpiryTimeout(-1);
+        readers.setMaxThreadCount(1);
+    }
+
+    bool attach(QSqlError &error);
+    void detach();
+    void finish(QFutureInterface<QFBBulkLoadResult> &fi);
+
+public:
+    QFBConnectionParams params;
+    QFBBulkSettings settings;
+
+    QThreadPool pool;
+    QThreadPool readers;
+    QMutex mutex;
+    QList<QFutureInterface<QFBBulkLoadResult> > pending;
+
+    // used from the worker thread only
+    IBPP::Database iDb;
+    QTextCodec *textCodec;
+};
+
+//-----------------------------------------------------------------------//
+bool QFBBulkLoaderPrivate::attach(QSqlError &error)
+{
+    if (iDb != 0 && iDb->Connected())
+        return true;
+
+    return qFBAttach(params, iDb, textCodec, error);
+}
+//-----------------------------------------------------------------------//
+void QFBBulkLoaderPrivate::detach()
+{
+    qFBDetach(iDb);
+}
+//-----------------------------------------------------------------------//
+void QFBBulkLoaderPrivate::finish(QFutureInterface<QFBBulkLoadResult> &fi)
+{
+    {
+        QMutexLocker locker(&mutex);
+        pending.removeOne(fi);
+    }
+    fi.reportFinished();
+}
+
+//-----------------------------------------------------------------------//
+// One load: prepares the INSERT, consumes the reader's chunks and sends
+// the rows with the chosen method.
+class QFBBulkJob : public QRunnable
+{
+public:
+    QFBBulkJob(QFBBulkLoaderPrivate *dd, QIODevice *device)
+        : d(dd), s(dd->settings), mDevice(device), mRowsPerBlock(1), mTailRows(0), mSent(0)
+    {}
+
+    void run() Q_DECL_OVERRIDE;
+
+public:
+    QFutureInterface<QFBBulkLoadResult> fi;
+
+private:
+    // Blocks stay within the limits of the servers before Firebird 3:
+    // 255 contexts per request, 64 KB messages and statement texts
+    enum { MaxBlockRows = 255, MaxBlockBytes = 60000, MaxRejectedKept = 1000 };
+
+    bool prepare(QSqlError &error);
+    bool readColumns(QSqlError &error);
+    QString blockSql(int rows) const;
+    void load();
+    void consume(QFBBulkQueue &queue);
+    void flush();
+    void sendBatch();
+    void sendBlock(IBPP::Statement &st, int from, int rows);
+    void sendRows(const QVector<int> &rows);
+    void reject(qint64 row, const QString &message);
+    void commit(bool restart);
+    void stop(const QSqlError &error);
+
+    QFBBulkLoaderPrivate *d;
+    QFBBulkSettings s;
+    QIODevice *mDevice;
+    QFBBulkLoadResult mResult;
+
+    IBPP::Transaction mTr;
+    IBPP::Statement mInsert;        // one row
+    IBPP::Statement mBatch;         // Batch
+    IBPP::Statement mBlock;         // ExecuteBlock, mRowsPerBlock rows
+    IBPP::Statement mTail;          // ExecuteBlock, mTailRows rows
+    IBPP::Statement mSavepoint;
+    QVector<QFBBulkColumn> mTypes;
+    QString mColumnList;
+    int mRowsPerBlock;
+    int mTailRows;
+
+    QVector<QVector<QVariant> > mRows;  // waiting to be sent
+    QVector<qint64> mRowNumbers;
+    qint64 mSent;                       // since the last commit
+};
+
+//-----------------------------------------------------------------------//
+void QFBBulkJob::run()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    if (fi.isCanceled())
+    {
+        d->finish(fi);
+        return;
+    }
+
+    if (d->attach(mResult.error))
+    {
+        try
+        {
+            mTr = IBPP::TransactionFactory(d->iDb, IBPP::amWrite, IBPP::ilConcurrency, IBPP::lrWait);
+            mTr->Start();
+
+            QSqlError error;
+            if (prepare(error))
+                load();
+            else
+                stop(error);
+        }
+        catch (IBPP::Exception& e)
+        {
+            stop(QSqlError(QLatin1String("Unable to load the rows"),
+                           QString::fromLatin1(e.ErrorMessage()), QSqlError::StatementError));
+        }
+    }
+
+    mInsert.clear();
+    mBatch.clear();
+    mBlock.clear();
+    mTail.clear();
+    mSavepoint.clear();
+    mTr.clear();
+
+    mResult.elapsedNs = timer.nsecsElapsed();
+    fi.reportResult(mResult);
+    d->finish(fi);
+}
+//-----------------------------------------------------------------------//
+// Rolls back the rows not committed yet and records why the load stopped
+void QFBBulkJob::stop(const QSqlError &error)
+{
+    try
+    {
+        if (mTr != 0 && mTr->Started())
+            mTr->Rollback();
+    }
+    catch (IBPP::Exception&)
+    {
+    }
+    mSent = 0;
+    if (!mResult.error.isValid())
+        mResult.error = error;
+}
+//-----------------------------------------------------------------------//
+// All the stored columns of the table, by default
+bool QFBBulkJob::readColumns(QSqlError &error)
+{
+    IBPP::Statement st = IBPP::StatementFactory(d->iDb, mTr);
+    st->Prepare("SELECT a.RDB$FIELD_NAME FROM RDB$RELATION_FIELDS a, RDB$FIELDS b "
+                "WHERE b.RDB$FIELD_NAME = a.RDB$FIELD_SOURCE AND a.RDB$RELATION_NAME = ? "
+                "AND b.RDB$COMPUTED_BLR IS NULL ORDER BY a.RDB$FIELD_POSITION");
+    st->Set(1, qFBToIBPPStr(qFBBulkName(s.table), d->textCodec));
+    st->Execute();
+    std::string name;
+    while (st->Fetch())
+    {
+        st->Get(1, name);
+        const QString column = d->textCodec ? d->textCodec->toUnicode(name.c_str())
+                                             : QString::fromLatin1(name.c_str());
+        s.columns.append(qFBBulkQuoted(column.trimmed()));
+    }
+
+    if (s.columns.isEmpty())
+    {
+        error = QSqlError(QLatin1String("Unable to load the rows"),
+                          QString::fromLatin1("Table %1 not found").arg(s.table),
+                          QSqlError::StatementError);
+        return false;
+    }
+    return true;
+}
+//-----------------------------------------------------------------------//
+QString QFBBulkJob::blockSql(int rows) const
+{
+    const int cols = mTypes.count();
+    QString params;
+    QString body;
+    for (int r = 0; r < rows; ++r)
+    {
+        body += QLatin1String("INSERT INTO ") + s.table + QLatin1String(" (") + mColumnList
+                + QLatin1String(") VALUES (");
+        for (int c = 0; c < cols; ++c)
+        {
+            const QString name = QString::fromLatin1("P%1").arg(r * cols + c);
+            if (!params.isEmpty())
+                params += QLatin1String(", ");
+            params += name + QLatin1String(" TYPE OF COLUMN ") + s.table + QLatin1Char('.')
+                    + s.columns.at(c) + QLatin1String(" = ?");
+            body += (c ? QLatin1String(", :") : QLatin1String(":")) + name;
+        }
+        body += QLatin1String(");\n");
+    }
+    return QLatin1String("EXECUTE BLOCK (") + params + QLatin1String(") AS BEGIN\n")
+            + body + QLatin1String("END");
+}
+//-----------------------------------------------------------------------//
+bool QFBBulkJob::prepare(QSqlError &error)
+{
+    if (s.columns.isEmpty() && !readColumns(error))
+        return false;
+    if (!s.fields.isEmpty() && s.fields.count() != s.columns.count())
+    {
+        error = QSqlError(QLatin1String("Unable to load the rows"),
+                          QString::fromLatin1("%1 columns but %2 field indexes")
+                          .arg(s.columns.count()).arg(s.fields.count()),
+                          QSqlError::StatementError);
+        return false;
+    }
+
+    mColumnList = s.columns.join(QLatin1String(", "));
+    QString values;
+    for (int c = 0; c < s.columns.count(); ++c)
+        values += c ? QLatin1String(", ?") : QLatin1String("?");
+    const QString insert = QLatin1String("INSERT INTO ") + s.table + QLatin1String(" (")
+            + mColumnList + QLatin1String(") VALUES (") + values + QLatin1String(")");
+
+    mInsert = IBPP::StatementFactory(d->iDb, mTr);
+    mInsert->Prepare(qFBToIBPPStr(insert, d->textCodec));
+
+    int rowBytes = 0;
+    mTypes.resize(mInsert->Parameters());
+    for (int i = 1; i <= mTypes.count(); ++i)
+    {
+        QFBBulkColumn &col = mTypes[i - 1];
+        col.type = mInsert->ParameterType(i);
+        col.scale = mInsert->ParameterScale(i);
+        col.subtype = mInsert->ParameterSubtype(i);
+        rowBytes += mInsert->ParameterSize(i) + 8;  // null indicator, VARCHAR length
+    }
+
+    // Batch only sends the rows together in an IBatch (OO API, Firebird 4,
+    // no blob or array column): EXECUTE BLOCK packs them otherwise
+    if (s.method == QFBBulkLoader::Auto || s.method == QFBBulkLoader::Batch)
+        s.method = mInsert->ServerBatch() ? QFBBulkLoader::Batch : QFBBulkLoader::ExecuteBlock;
+    mResult.method = s.method;
+
+    if (s.method == QFBBulkLoader::Batch)
+    {
+        mBatch = IBPP::StatementFactory(d->iDb, mTr);
+        mBatch->Prepare(qFBToIBPPStr(insert, d->textCodec));
+        mSavepoint = IBPP::StatementFactory(d->iDb, mTr);
+    }
+    else if (s.method == QFBBulkLoader::ExecuteBlock)
+    {
+        const int textBytes = qFBToIBPPStr(blockSql(1), d->textCodec).size();
+        mRowsPerBlock = qMin(qMin(int(MaxBlockRows), s.batchSize),
+                             qMin(MaxBlockBytes / qMax(1, rowBytes), MaxBlockBytes / textBytes));
+        mRowsPerBlock = qMax(1, mRowsPerBlock);
+        mBlock = IBPP::StatementFactory(d->iDb, mTr);
+        mBlock->Prepare(qFBToIBPPStr(blockSql(mRowsPerBlock), d->textCodec));
+    }
+    return true;
+}
+//-----------------------------------------------------------------------//
+void QFBBulkJob::load()
+{
+    QFBBulkQueue queue;
+    d->readers.start(new QFBBulkReader(s, mTypes, mDevice, &queue));
+    try
+    {
+        consume(queue);
+    }
+    catch (IBPP::Exception& e)
+    {
+        stop(QSqlError(QLatin1String("Unable to load the rows"),
+                       QString::fromLatin1(e.ErrorMessage()), QSqlError::StatementError));
+    }
+
+    // The reader may still be running: wait for it before the queue goes
+    queue.abort();
+    QFBBulkChunk chunk;
+    while (queue.pop(chunk))
+        ;
+}
+//-----------------------------------------------------------------------//
+void QFBBulkJob::consume(QFBBulkQueue &queue)
+{
+    const int flushRows = s.method == QFBBulkLoader::ExecuteBlock ? mRowsPerBlock : s.batchSize;
+    QFBBulkChunk chunk;
+    while (queue.pop(chunk))
+    {
+        mResult.rowsRead += chunk.rowsRead;
+        for (int i = 0; i < chunk.rejected.count(); ++i)
+            reject(chunk.rejected.at(i).row, chunk.rejected.at(i).message);
+
+        for (int i = 0; i < chunk.rows.count(); ++i)
+        {
+            mRows.append(chunk.rows.at(i));
+            mRowNumbers.append(chunk.rowNumbers.at(i));
+            if (mRows.count() >= flushRows)
+            {
+                flush();
+                if (s.commitRows > 0 && mSent >= s.commitRows)
+                    commit(true);
+            }
+        }
+
+        if (!chunk.error.isEmpty())
+            stop(QSqlError(QLatin1String("Unable to read the input"), chunk.error,
+                           QSqlError::UnknownError));
+        else if (s.maxRejected >= 0 && mResult.rowsRejected > s.maxRejected)
+            stop(QSqlError(QLatin1String("Unable to load the rows"),
+                           QString::fromLatin1("More than %1 rejected rows").arg(s.maxRejected),
+                           QSqlError::StatementError));
+        else if (fi.isCanceled())
+            stop(QSqlError());
+
+        if (mResult.error.isValid() || fi.isCanceled())
+            return;
+        fi.setProgressValue(int(qMin<qint64>(mResult.rowsLoaded + mSent, INT_MAX)));
+    }
+
+    flush();
+    commit(false);
+}
+//-----------------------------------------------------------------------//
+void QFBBulkJob::commit(bool restart)
+{
+    mTr->Commit();
+    mResult.rowsLoaded += mSent;
+    mSent = 0;
+    if (restart)
+        mTr->Start();
+}
+//-----------------------------------------------------------------------//
+void QFBBulkJob::reject(qint64 row, const QString &message)
+{
+    ++mResult.rowsRejected;
+    if (mResult.rejected.count() < MaxRejectedKept)
+    {
+        QFBBulkRejectedRow r;
+        r.row = row;
+        r.message = message;
+        mResult.rejected.append(r);
+    }
+}
+//-----------------------------------------------------------------------//
+void QFBBulkJob::flush()
+{
+    if (mRows.isEmpty())
+        return;
+
+    if (s.method == QFBBulkLoader::Batch)
+        sendBatch();
+    else if (s.method == QFBBulkLoader::ExecuteBlock)
+    {
+        int from = 0;
+        for (; mRows.count() - from >= mRowsPerBlock; from += mRowsPerBlock)
+            sendBlock(mBlock, from, mRowsPerBlock);
+
+        const int tail = mRows.count() - from;
+        if (tail > 0)
+        {
+            if (mTailRows != tail)
+            {
+                mTail = IBPP::StatementFactory(d->iDb, mTr);
+                mTail->Prepare(qFBToIBPPStr(blockSql(tail), d->textCodec));
+                mTailRows = tail;
+            }
+            sendBlock(mTail, from, tail);
+        }
+    }
+    else
+    {
+        QVector<int> rows(mRows.count());
+        for (int i = 0; i < rows.count(); ++i)
+            rows[i] = i;
+        sendRows(rows);
+    }
+
+    mRows.clear();
+    mRowNumbers.clear();
+}
+//-----------------------------------------------------------------------//
+// The errors caused by the values of a row: a constraint, a conversion, a
+// value too long or an exception raised by a trigger. The others (lost
+// connection, deadlock, update conflict, transaction state...) would fail
+// every row alike: they stop the load instead of rejecting the rows.
+static bool qFBBulkRowError(const IBPP::SQLException &e)
+{
+    switch (e.SqlCode())
+    {
+    case -297:      // CHECK constraint
+    case -413:      // Conversion error
+    case -530:      // FOREIGN KEY
+    case -625:      // NOT NULL, domain
+    case -802:      // Arithmetic overflow, string truncation
+    case -803:      // PRIMARY KEY, UNIQUE
+    case -836:      // Exception raised by a trigger
+        return true;
+    default:
+        return false;
+    }
+}
+//-----------------------------------------------------------------------//
+// Inserts rows one at a time, rejecting the failing ones. A failed INSERT
+// leaves nothing behind.
+void QFBBulkJob::sendRows(const QVector<int> &rows)
+{
+    for (int i = 0; i < rows.count(); ++i)
+    {
+        const int r = rows.at(i);
+        QSqlError error;
+        try
+        {
+            if (!qFBBindValues(mInsert, mRows.at(r), d->textCodec, error))
+            {
+                reject(mRowNumbers.at(r), error.databaseText());
+                continue;
+            }
+            mInsert->Execute();
+            ++mSent;
+        }
+        catch (IBPP::SQLException& e)
+        {
+            if (!qFBBulkRowError(e))
+                throw;
+            reject(mRowNumbers.at(r), QString::fromLatin1(e.ErrorMessage()));
+        }
+    }
+}
+//-----------------------------------------------------------------------//
+// Queues the rows on the prepared INSERT and executes them together. When
+// one fails the batch is undone to the savepoint taken before it and its
+// rows are sent one at a time.
+void QFBBulkJob::sendBatch()
+{
+    mSavepoint->ExecuteImmediate("SAVEPOINT QFB_BULK");
+
+    QVector<int> queued;
+    queued.reserve(mRows.count());
+    try
+    {
+        for (int r = 0; r < mRows.count(); ++r)
+        {
+            QSqlError error;
+            if (qFBBindValues(mBatch, mRows.at(r), d->textCodec, error))
+            {
+                queued.append(r);
+                mBatch->AddBatch();
+            }
+            else
+                reject(mRowNumbers.at(r), error.databaseText());
+        }
+        mBatch->ExecuteBatch();
+        mSent += queued.count();
+    }
+    catch (IBPP::SQLException& e)
+    {
+        if (!qFBBulkRowError(e))
+            throw;
+        // ExecuteBatch() has emptied its queue
+        mSavepoint->ExecuteImmediate("ROLLBACK TO SAVEPOINT QFB_BULK");
+        sendRows(queued);
+    }
+
+    mSavepoint->ExecuteImmediate("RELEASE SAVEPOINT QFB_BULK ONLY");
+}
+//-----------------------------------------------------------------------//
+// Sends rows [from, from + rows) in one EXECUTE BLOCK. It fails or
+// succeeds as a whole; when it fails its rows are sent one at a time.
+void QFBBulkJob::sendBlock(IBPP::Statement &st, int from, int rows)
+{
+    QVector<QVariant> values;
+    values.reserve(rows * mTypes.count());
+    for (int r = from; r < from + rows; ++r)
+        values += mRows.at(r);
+
+    QSqlError error;
+    try
+    {
+        if (qFBBindValues(st, values, d->textCodec, error))
+        {
+            st->Execute();
+            mSent += rows;
+            return;
+        }
+    }
+    catch (IBPP::SQLException& e)
+    {
+        if (!qFBBulkRowError(e))
+            throw;
+    }
+
+    QVector<int> retry(rows);
+    for (int i = 0; i < rows; ++i)
+        retry[i] = from + i;
+    sendRows(retry);
+}
+
+//-----------------------------------------------------------------------//
+class QFBBulkDetach : public QRunnable
+{
+public:
+    explicit QFBBulkDetach(QFBBulkLoaderPrivate *dd) : d(dd) {}
+    void run() Q_DECL_OVERRIDE { d->detach(); }
+
+private:
+    QFBBulkLoaderPrivate *d;
+};
+
+//-----------------------------------------------------------------------//
+//-----------------------------------------------------------------------//
+QFBBulkLoader::QFBBulkLoader(const QSqlDatabase &db, QObject *parent)
+    : QObject(parent), d(new QFBBulkLoaderPrivate)
+{
+    qRegisterMetaType<QFBBulkLoadResult>("QFBBulkLoadResult");
+
+    if (db.driverName() != QLatin1String("QFIREBIRD"))
+        qWarning("QFBBulkLoader: '%s' is not a QFIREBIRD connection",
+                 db.connectionName().toLocal8Bit().constData());
+
+    d->params = QFBConnectionParams(db);
+}
+//-----------------------------------------------------------------------//
+QFBBulkLoader::~QFBBulkLoader()
+{
+    {
+        QMutexLocker locker(&d->mutex);
+        for (int i = 0; i < d->pending.count(); ++i)
+            d->pending[i].cancel();
+    }
+    d->pool.start(new QFBBulkDetach(d));
+    d->pool.waitForDone();
+    delete d;
+}
+//-----------------------------------------------------------------------//
+void QFBBulkLoader::setTable(const QString &table)
+{
+    d->settings.table = table;
+}
+//-----------------------------------------------------------------------//
+QString QFBBulkLoader::table() const
+{
+    return d->settings.table;
+}
+//-----------------------------------------------------------------------//
+void QFBBulkLoader::setColumns(const QStringList &columns, const QVector<int> &fields)
+{
+    d->settings.columns = columns;
+    d->settings.fields = fields;
+}
+//-----------------------------------------------------------------------//
+QStringList QFBBulkLoader::columns() const
+{
+    return d->settings.columns;
+}
+//-----------------------------------------------------------------------//
+QVector<int> QFBBulkLoader::fields() const
+{
+    return d->settings.fields;
+}
+//-----------------------------------------------------------------------//
+void QFBBulkLoader::setFormat(Format format)
+{
+    d->settings.format = format;
+}
+//-----------------------------------------------------------------------//
+QFBBulkLoader::Format QFBBulkLoader::format() const
+{
+    return d->settings.format;
+}
+//-----------------------------------------------------------------------//
+void QFBBulkLoader::setDelimiter(char delimiter)
+{
+    d->settings.delimiter = delimiter;
+}
+//-----------------------------------------------------------------------//
+char QFBBulkLoader::delimiter() const
+{
+    return d->settings.delimiter;
+}
+//-----------------------------------------------------------------------//
+void QFBBulkLoader::setHeader(bool header)
+{
+    d->settings.header = header;
+}
+//-----------------------------------------------------------------------//
+bool QFBBulkLoader::header() const
+{
+    return d->settings.header;
+}
+//-----------------------------------------------------------------------//
+void QFBBulkLoader::setMethod(Method method)
+{
+    d->settings.method = method;
+}
+//-----------------------------------------------------------------------//
+QFBBulkLoader::Method QFBBulkLoader::method() const
+{
+    return d->settings.method;
+}
+//-----------------------------------------------------------------------//
+void QFBBulkLoader::setBatchSize(int rows)
+{
+    d->settings.batchSize = qMax(1, rows);
+}
+//-----------------------------------------------------------------------//
+int QFBBulkLoader::batchSize() const
+{
+    return d->settings.batchSize;
+}
+//-----------------------------------------------------------------------//
+void QFBBulkLoader::setCommitRows(int rows)
+{
+    d->settings.commitRows = qMax(0, rows);
+}
+//-----------------------------------------------------------------------//
+int QFBBulkLoader::commitRows() const
+{
+    return d->settings.commitRows;
+}
+//-----------------------------------------------------------------------//
+void QFBBulkLoader::setMaxRejected(qint64 rows)
+{
+    d->settings.maxRejected = rows;
+}
+//-----------------------------------------------------------------------//
+qint64 QFBBulkLoader::maxRejected() const
+{
+    return d->settings.maxRejected;
+}
+//-----------------------------------------------------------------------//
+QFuture<QFBBulkLoadResult> QFBBulkLoader::load(QIODevice *device)
+{
+    QFBBulkJob *job = new QFBBulkJob(d, device);
+    job->fi.reportStarted();
+    QFuture<QFBBulkLoadResult> future = job->fi.future();
+
+    {
+        QMutexLocker locker(&d->mutex);
+        d->pending.append(job->fi);
+    }
+    d->pool.start(job);
+
+    return future;
+}
+//-----------------------------------------------------------------------//
+bool QFBBulkLoader::waitForDone(int msecs)
+{
+    return d->pool.waitForDone(msecs);
+}
+//-----------------------------------------------------------------------//
+void QFBBulkLoader::writeBinaryRow(QDataStream &out, const QVector<QVariant> &row)
+{
+    out.setVersion(QDataStream::Qt_5_0);
+    out << row;
+}
+//-----------------------------------------------------------------------//
@@ -0,0 +1,156 @@
+/*
+* This file is part of QtFirebirdIBPPSQLDriver - Qt SQL driver for Firebird with IBPP library
+* Copyright (C) 2006-2010 Alex Wencel
+*
+* Contact e-mail: Alex Wencel <alex.wencel@gmail.com>
+* Program URL   : http://code.google.com/p/qtfirebirdibppsqldriver
+*
+* GNU Lesser General Public License Usage
+* This file may be used under the terms of the GNU Lesser
+* General Public License version 2.1 as published by the Free Software
+* Foundation and appearing in the file LICENSE.LGPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU Lesser General Public License version 2.1 requirements
+* will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+*
+* GNU General Public License Usage
+* Alternatively, this file may be used under the terms of the GNU
+* General Public License version 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU General Public License version 3.0 requirements will be
+* met: http://www.gnu.org/copyleft/gpl.html.
+*
+*/
+
+#ifndef QFBBULKLOADER_H
+#define QFBBULKLOADER_H
+
+#include <QtCore/qfuture.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qmetatype.h>
+#include <QtCore/qobject.h>
+#include <QtCore/qstringlist.h>
+#include <QtCore/qvariant.h>
+#include <QtCore/qvector.h>
+#include <QtSql/qsqldatabase.h>
+#include <QtSql/qsqlerror.h>
+
+QT_BEGIN_HEADER
+class QDataStream;
+class QIODevice;
+class QFBBulkLoaderPrivate;
+
+// A row of the input the loader did not insert: row is its number in the
+// input (1 for the first row after the header), message tells why.
+struct QFBBulkRejectedRow
+{
+    QFBBulkRejectedRow() : row(0) {}
+
+    qint64 row;
+    QString message;
+};
+
+// Outcome of QFBBulkLoader::load(). rowsLoaded counts the committed rows.
+// The first 1000 rejected rows are kept in rejected, rowsRejected counts
+// them all. If error is valid the load stopped early: the transaction in
+// progress was rolled back, the rows committed before stay in the table.
+struct QFBBulkLoadResult
+{
+    QFBBulkLoadResult() : rowsRead(0), rowsLoaded(0), rowsRejected(0), elapsedNs(0), method(0) {}
+
+    double rowsPerSecond() const { return elapsedNs > 0 ? rowsLoaded * 1e9 / elapsedNs : 0.0; }
+
+    qint64 rowsRead;
+    qint64 rowsLoaded;
+    qint64 rowsRejected;
+    qint64 elapsedNs;
+    int method;             // QFBBulkLoader::Method used
+    QList<QFBBulkRejectedRow> rejected;
+    QSqlError error;
+};
+
+// Loads rows from a QIODevice into a table without the QSqlQuery exec path.
+// Each QFBBulkLoader opens its own attachment, with the parameters of the
+// QSqlDatabase it was created from.
+//
+// load() runs on two worker threads: one reads and parses the device into
+// values of the types of the target columns, the other binds them into the
+// parameters of a prepared INSERT and sends them in batches of batchSize()
+// rows, committing every commitRows() rows.
+//
+// Csv input is RFC 4180 text in UTF-8: fields separated by delimiter(),
+// quoted with '"' when they hold a delimiter, a quote or a line break,
+// records ended by LF or CRLF. An empty unquoted field is NULL. Numbers use
+// '.', dates, times and timestamps the ISO 8601 forms ("2024-05-17",
+// "13:45:30.250", "2024-05-17 13:45:30"), booleans true/false, t/f, yes/no
+// or 1/0. Binary input is a sequence of rows written by writeBinaryRow().
+//
+// setColumns() gives the target columns (all the columns of the table when
+// empty) and for each one the index of its field in the input rows. With no
+// field indexes the columns take the fields in order, or, with a Csv header,
+// the field of the same name.
+//
+// The Batch method sends batchSize() rows at a time in one IBatch of the
+// Firebird 4 OO API (IBPP::Statement::AddBatch()); ExecuteBlock packs as many
+// rows as fit in one EXECUTE BLOCK statement. Auto picks Batch when the
+// attachment uses the OO API and no column is a blob or an array, else
+// ExecuteBlock, as Batch does in those cases; QFBBulkLoadResult::method
+// tells which.
+// When a batch fails on the values of a row (a constraint, a conversion, a
+// trigger exception), it is undone and its rows are inserted one at a time
+// to find the rejected ones. A row that can't be parsed or converted is
+// rejected too; above maxRejected() rejected rows the load stops. Any other
+// error (connection lost, deadlock, update conflict) stops the load.
+// NUMERIC fields are read exactly at the scale of their column.
+//
+// QFuture::cancel() stops the load after the batch in progress and rolls
+// back the uncommitted rows. The progress value of the future is the count
+// of rows sent. The device must stay valid until the future finishes and be
+// readable from another thread (QFile, QBuffer); it is not closed.
+class QFBBulkLoader : public QObject
+{
+    Q_OBJECT
+public:
+    enum Format { Csv, Binary };
+    enum Method { Auto, Batch, ExecuteBlock, SingleRows };
+
+    explicit QFBBulkLoader(const QSqlDatabase &db, QObject *parent = nullptr);
+    virtual ~QFBBulkLoader();
+
+    void setTable(const QString &table);
+    QString table() const;
+    void setColumns(const QStringList &columns, const QVector<int> &fields = QVector<int>());
+    QStringList columns() const;
+    QVector<int> fields() const;
+
+    void setFormat(Format format);
+    Format format() const;
+    void setDelimiter(char delimiter);
+    char delimiter() const;
+    void setHeader(bool header);
+    bool header() const;
+
+    void setMethod(Method method);
+    Method method() const;
+    void setBatchSize(int rows);
+    int batchSize() const;
+    void setCommitRows(int rows);
+    int commitRows() const;
+    void setMaxRejected(qint64 rows);
+    qint64 maxRejected() const;
+
+    QFuture<QFBBulkLoadResult> load(QIODevice *device);
+    bool waitForDone(int msecs = -1);
+
+    static void writeBinaryRow(QDataStream &out, const QVector<QVariant> &row);
+
+private:
+    Q_DISABLE_COPY(QFBBulkLoader)
+    QFBBulkLoaderPrivate *d;
+};
+
+Q_DECLARE_METATYPE(QFBBulkLoadResult)
+
+QT_END_HEADER
+#endif // QFBBULKLOADER_H
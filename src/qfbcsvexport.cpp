@@ -0,0 +1,710 @@
+/*
+* This file is part of QtFirebirdIBPPSQLDriver - Qt SQL driver for Firebird with IBPP library
+* Copyright (C) 2006-2010 Alex Wencel
+*
+* Contact e-mail: Alex Wencel <alex.wencel@gmail.com>
+* Program URL   : http://code.google.com/p/qtfirebirdibppsqldriver
+*
+* GNU Lesser General Public License Usage
+* This file may be used under the terms of the GNU Lesser
+* General Public License version 2.1 as published by the Free Software
+* Foundation and appearing in the file LICENSE.LGPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU Lesser General Public License version 2.1 requirements
+* will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+*
+* GNU General Public License Usage
+* Alternatively, this file may be used under the terms of the GNU
+* General Public License version 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU General Public License version 3.0 requirements will be
+* met: http://www.gnu.org/copyleft/gpl.html.
+*
+*/
+
+#include <QtDebug>
+#include <QElapsedTimer>
+#include <QFileDevice>
+#include <QIODevice>
+#include <QLocale>
+#include <QTextCodec>
+#include <QtEndian>
+#include <qfutureinterface.h>
+#include <qlist.h>
+#include <qmutex.h>
+#include <qnumeric.h>
+#include <qrunnable.h>
+#include <qthreadpool.h>
+#include <qwaitcondition.h>
+
+#include <climits>
+#include <cstring>
+
+#include "ibpp.h"
+#include "qfbcsvexport.h"
+#include "qsql_ibpp.h"
+#include "qsql_ibpp_p.h"
+
+//-----------------------------------------------------------------------//
+// Settings of an export, copied when it is queued
+struct QFBCsvSettings
+{
+    QFBCsvSettings()
+        : delimiter(','), header(true), batchSize(4096), bufferSize(1024 * 1024)
+    {}
+
+    char delimiter;
+    bool header;
+    int batchSize;
+    int bufferSize;
+};
+
+//-----------------------------------------------------------------------//
+// The values are formatted straight into the output buffer, without
+// QString. Digits go two at a time, from the end of a small buffer.
+static const char qFBCsvDigits[] =
+    "0001020304050607080910111213141516171819202122232425262728293031323334353637383940414243444546474849"
+    "5051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+//-----------------------------------------------------------------------//
+// Writes the digits of v before end, returns where they start
+static inline char *qFBCsvDigitsOf(char *end, quint64 v)
+{
+    while (v >= 100)
+    {
+        const int two = int(v % 100) * 2;
+        v /= 100;
+        *--end = qFBCsvDigits[two + 1];
+        *--end = qFBCsvDigits[two];
+    }
+    if (v >= 10)
+    {
+        const int two = int(v) * 2;
+        *--end = qFBCsvDigits[two + 1];
+        *--end = qFBCsvDigits[two];
+    }
+    else
+        *--end = char('0' + v);
+    return end;
+}
+//-----------------------------------------------------------------------//
+static inline char *qFBCsvTwoDigits(char *p, int v)
+{
+    *p++ = qFBCsvDigits[v * 2];
+    *p++ = qFBCsvDigits[v * 2 + 1];
+    return p;
+}
+//-----------------------------------------------------------------------//
+static void qFBCsvInteger(QByteArray &out, qint64 v)
+{
+    char buf[24];
+    char *end = buf + sizeof(buf);
+    char *p = qFBCsvDigitsOf(end, v < 0 ? 0 - quint64(v) : quint64(v));
+    if (v < 0)
+        *--p = '-';
+    out.append(p, int(end - p));
+}
+//-----------------------------------------------------------------------//
+// A Decimal value of QFBColumn: the 16 bytes of the unscaled value, written
+// with scale (> 0) digits after the point
+static void qFBCsvDecimal(QByteArray &out, const char *le, int scale)
+{
+    const quint64 low = qFromLittleEndian<quint64>(le);
+    const qint64 high = qFromLittleEndian<qint64>(le + 8);
+    if (high != (qint64(low) < 0 ? -1 : 0))
+    {
+        // Beyond 64 bits, only INT128 and NUMERIC(38) values
+        const std::string text = IBPP::Int128(high, low).ToString(scale);
+        out.append(text.data(), int(text.size()));
+        return;
+    }
+
+    const qint64 v = qint64(low);
+    quint64 u = v < 0 ? 0 - quint64(v) : quint64(v);
+    char buf[64];
+    char *end = buf + sizeof(buf);
+    char *p = end;
+    for (int i = 0; i < scale && i < 40; ++i)
+    {
+        *--p = char('0' + u % 10);
+        u /= 10;
+    }
+    if (scale > 0)
+        *--p = '.';
+    p = qFBCsvDigitsOf(p, u);
+    if (v < 0)
+        *--p = '-';
+    out.append(p, int(end - p));
+}
+//-----------------------------------------------------------------------//
+static void qFBCsvDouble(QByteArray &out, double v)
+{
+    if (qAbs(v) < 1e15 && v == double(qint64(v)))
+        qFBCsvInteger(out, qint64(v));
+    else if (qIsNaN(v))
+        out.append("NaN");
+    else if (qIsInf(v))
+        out.append(v < 0 ? "-Infinity" : "Infinity");
+    else
+        out.append(QByteArray::number(v, 'g', QLocale::FloatingPointShortest));
+}
+//-----------------------------------------------------------------------//
+// "YYYY-MM-DD" of a Julian day (Fliegel and Van Flandern)
+static char *qFBCsvDate(char *p, qint64 julianDay)
+{
+    qint64 l = julianDay + 68569;
+    const qint64 n = 4 * l / 146097;
+    l -= (146097 * n + 3) / 4;
+    const qint64 i = 4000 * (l + 1) / 1461001;
+    l += 31 - 1461 * i / 4;
+    const qint64 j = 80 * l / 2447;
+    const int day = int(l - 2447 * j / 80);
+    l = j / 11;
+    const int month = int(j + 2 - 12 * l);
+    const int year = int(100 * (n - 49) + i + l);
+
+    p = qFBCsvTwoDigits(p, (year / 100) % 100);
+    p = qFBCsvTwoDigits(p, year % 100);
+    *p++ = '-';
+    p = qFBCsvTwoDigits(p, month);
+    *p++ = '-';
+    return qFBCsvTwoDigits(p, day);
+}
+//-----------------------------------------------------------------------//
+// "HH:MM:SS.ffff" of microseconds since midnight, to the 100 microseconds
+// of the Firebird times
+static char *qFBCsvTime(char *p, qint64 us)
+{
+    const int fraction = int(us % 1000000 / 100);
+    const qint64 secs = us / 1000000;
+    p = qFBCsvTwoDigits(p, int(secs / 3600));
+    *p++ = ':';
+    p = qFBCsvTwoDigits(p, int(secs / 60 % 60));
+    *p++ = ':';
+    p = qFBCsvTwoDigits(p, int(secs % 60));
+    *p++ = '.';
+    p = qFBCsvTwoDigits(p, fraction / 100);
+    return qFBCsvTwoDigits(p, fraction % 100);
+}
+//-----------------------------------------------------------------------//
+static void qFBCsvTimestamp(QByteArray &out, qint64 us, bool utc)
+{
+    static const qint64 usPerDay = Q_INT64_C(86400000000);
+    qint64 days = us / usPerDay;
+    if (us % usPerDay < 0)
+        --days;
+
+    char buf[40];
+    char *p = qFBCsvDate(buf, days + 2440588);
+    *p++ = ' ';
+    p = qFBCsvTime(p, us - days * usPerDay);
+    if (utc)
+    {
+        memcpy(p, "+00:00", 6);
+        p += 6;
+    }
+    out.append(buf, int(p - buf));
+}
+//-----------------------------------------------------------------------//
+// Text, quoted when it holds the delimiter, a quote or a line break, or
+// when it is empty (an empty field is NULL)
+static void qFBCsvText(QByteArray &out, const char *text, int len, char delimiter)
+{
+    bool quote = len == 0;
+    for (int i = 0; i < len && !quote; ++i)
+    {
+        const char c = text[i];
+        quote = c == delimiter || c == '"' || c == '\n' || c == '\r';
+    }
+    if (!quote)
+    {
+        out.append(text, len);
+        return;
+    }
+
+    out.append('"');
+    const char *end = text + len;
+    for (const char *q; (q = static_cast<const char *>(memchr(text, '"', end - text))); text = q + 1)
+    {
+        out.append(text, int(q - text + 1));
+        out.append('"');
+    }
+    out.append(text, int(end - text));
+    out.append('"');
+}
+//-----------------------------------------------------------------------//
+static void qFBCsvHex(QByteArray &out, const char *data, int len)
+{
+    static const char hex[] = "0123456789ABCDEF";
+    const int at = out.size();
+    out.resize(at + len * 2);
+    char *p = out.data() + at;
+    for (int i = 0; i < len; ++i)
+    {
+        *p++ = hex[uchar(data[i]) >> 4];
+        *p++ = hex[uchar(data[i]) & 15];
+    }
+}
+//-----------------------------------------------------------------------//
+static void qFBCsvField(QByteArray &out, const QFBColumn &c, int row, char delimiter)
+{
+    if (c.nullCount && c.isNull(row))
+        return;
+
+    char buf[40];
+    switch (c.type)
+    {
+    case QFBColumn::Int64:
+        qFBCsvInteger(out, c.ints.at(row));
+        break;
+    case QFBColumn::Double:
+        qFBCsvDouble(out, c.doubles.at(row));
+        break;
+    case QFBColumn::Decimal:
+        qFBCsvDecimal(out, c.bytes.constData() + row * 16, c.scale);
+        break;
+    case QFBColumn::Boolean:
+        if (c.ints.at(row))
+            out.append("true", 4);
+        else
+            out.append("false", 5);
+        break;
+    case QFBColumn::Date:
+        out.append(buf, int(qFBCsvDate(buf, c.ints.at(row)) - buf));
+        break;
+    case QFBColumn::Time:
+        out.append(buf, int(qFBCsvTime(buf, c.ints.at(row)) - buf));
+        break;
+    case QFBColumn::Timestamp:
+        qFBCsvTimestamp(out, c.ints.at(row), c.utc);
+        break;
+    case QFBColumn::Binary:
+        qFBCsvHex(out, c.bytes.constData() + c.offsets.at(row),
+                  c.offsets.at(row + 1) - c.offsets.at(row));
+        break;
+    default:
+        qFBCsvText(out, c.bytes.constData() + c.offsets.at(row),
+                   c.offsets.at(row + 1) - c.offsets.at(row), delimiter);
+        break;
+    }
+}
+
+//-----------------------------------------------------------------------//
+// Writes, on its own thread, the buffers handed over by the exporting job:
+// the job fills one buffer while the other one is being written.
+class QFBCsvWriter : public QRunnable
+{
+public:
+    QFBCsvWriter(QIODevice *device, int bufferSize)
+        : mDevice(device), mFull(false), mClosed(false), mDone(false), mFailed(false),
+          mWritten(0)
+    {
+        setAutoDelete(false);
+        mBuffer.reserve(bufferSize);
+    }
+
+    // Gives buf to the writer once the previous buffer is written; buf
+    // comes back as that one, empty. False when a write failed.
+    bool put(QByteArray &buf);
+    // Waits for the last buffer to be written and flushes the device
+    bool finish();
+
+    QString errorString() const { return mError; }
+    qint64 written() const { return mWritten; }
+
+    void run() Q_DECL_OVERRIDE;
+
+private:
+    QMutex mMutex;
+    QWaitCondition mChanged;
+    QIODevice *mDevice;
+    QByteArray mBuffer;
+    bool mFull;
+    bool mClosed;
+    bool mDone;
+    bool mFailed;
+    QString mError;
+    qint64 mWritten;
+};
+
+//-----------------------------------------------------------------------//
+bool QFBCsvWriter::put(QByteArray &buf)
+{
+    QMutexLocker locker(&mMutex);
+    while (mFull && !mFailed)
+        mChanged.wait(&mMutex);
+    if (mFailed)
+        return false;
+
+    mBuffer.swap(buf);
+    mFull = true;
+    mChanged.wakeAll();
+    return true;
+}
+//-----------------------------------------------------------------------//
+bool QFBCsvWriter::finish()
+{
+    QMutexLocker locker(&mMutex);
+    mClosed = true;
+    mChanged.wakeAll();
+    while (!mDone)
+        mChanged.wait(&mMutex);
+    return !mFailed;
+}
+//-----------------------------------------------------------------------//
+void QFBCsvWriter::run()
+{
+    QMutexLocker locker(&mMutex);
+    for (;;)
+    {
+        while (!mFull && !mClosed)
+            mChanged.wait(&mMutex);
+        if (!mFull)
+            break;
+
+        // The job does not touch mBuffer while it is full
+        locker.unlock();
+        const qint64 length = mBuffer.size();
+        const bool written = mDevice->write(mBuffer.constData(), length) == length;
+        locker.relock();
+
+        if (written)
+            mWritten += length;
+        else
+        {
+            mFailed = true;
+            mError = mDevice->errorString();
+        }
+        mBuffer.resize(0);      // The capacity reserved is kept
+        mFull = false;
+        mChanged.wakeAll();
+        if (mFailed)
+            break;
+    }
+
+    QFileDevice *file = qobject_cast<QFileDevice *>(mDevice);
+    if (!mFailed && file && !file->flush())
+    {
+        mFailed = true;
+        mError = file->errorString();
+    }
+    mDone = true;
+    mChanged.wakeAll();
+}
+
+//-----------------------------------------------------------------------//
+class QFBCsvExporterPrivate
+{
+public:
+    QFBCsvExporterPrivate()
+        : textCodec(0)
+    {
+        // one export at a time, and one writer for it
+        pool.setMaxThreadCount(1);
+        pool.setExpiryTimeout(-1);
+        writers.setMaxThreadCount(1);
+    }
+
+    bool attach(QSqlError &error);
+    void detach();
+    void finish(QFutureInterface<QFBCsvExportResult> &fi);
+
+public:
+    QFBConnectionParams params;
+    QFBCsvSettings settings;
+
+    QThreadPool pool;
+    QThreadPool writers;
+    QMutex mutex;
+    QList<QFutureInterface<QFBCsvExportResult> > pending;
+
+    // used from the worker thread only
+    IBPP::Database iDb;
+    QTextCodec *textCodec;
+};
+
+//-----------------------------------------------------------------------//
+bool QFBCsvExporterPrivate::attach(QSqlError &error)
+{
+    if (iDb != 0 && iDb->Connected())
+        return true;
+
+    return qFBAttach(params, iDb, textCodec, error);
+}
+//-----------------------------------------------------------------------//
+void QFBCsvExporterPrivate::detach()
+{
+    qFBDetach(iDb);
+}
+//-----------------------------------------------------------------------//
+void QFBCsvExporterPrivate::finish(QFutureInterface<QFBCsvExportResult> &fi)
+{
+    {
+        QMutexLocker locker(&mutex);
+        pending.removeOne(fi);
+    }
+    fi.reportFinished();
+}
+
+//-----------------------------------------------------------------------//
+class QFBCsvJob : public QRunnable
+{
+public:
+    QFBCsvJob(QFBCsvExporterPrivate *dd, const QString &query, QIODevice *device,
+              const QVector<QVariant> &values)
+        : s(dd->settings), d(dd), mQuery(query), mDevice(device), mValues(values)
+    {}
+
+    void run() Q_DECL_OVERRIDE;
+
+public:
+    QFutureInterface<QFBCsvExportResult> fi;
+
+private:
+    void exportRows(IBPP::Transaction &tr, IBPP::Statement &st);
+    bool formatRows(IBPP::Transaction &tr, IBPP::Statement &st, QFBCsvWriter &writer);
+
+    const QFBCsvSettings s;
+    QFBCsvExporterPrivate *d;
+    QString mQuery;
+    QIODevice *mDevice;
+    QVector<QVariant> mValues;
+    QFBCsvExportResult mResult;
+};
+
+//-----------------------------------------------------------------------//
+void QFBCsvJob::run()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    if (fi.isCanceled())
+    {
+        d->finish(fi);
+        return;
+    }
+
+    if (d->attach(mResult.error))
+    {
+        IBPP::Transaction tr;
+        IBPP::Statement st;
+        try
+        {
+            tr = IBPP::TransactionFactory(d->iDb, IBPP::amRead, IBPP::ilConcurrency, IBPP::lrWait);
+            tr->Start();
+            st = IBPP::StatementFactory(d->iDb, tr);
+            st->Prepare(qFBToIBPPStr(mQuery, d->textCodec));
+
+            if (st->Type() != IBPP::stSelect && st->Type() != IBPP::stSelectUpdate)
+                mResult.error = QSqlError(QLatin1String("Unable to export the rows"),
+                                          QLatin1String("the statement is not a SELECT"),
+                                          QSqlError::StatementError);
+            else if (mValues.isEmpty() || qFBBindValues(st, mValues, d->textCodec, mResult.error))
+            {
+                st->Execute();
+                exportRows(tr, st);
+            }
+            st->Close();
+            tr->Commit();
+        }
+        catch (IBPP::Exception& e)
+        {
+            try
+            {
+                if (tr != 0 && tr->Started())
+                    tr->Rollback();
+            }
+            catch (IBPP::Exception&)
+            {
+            }
+            if (!mResult.error.isValid())
+                mResult.error = QSqlError(QLatin1String("Unable to export the rows"),
+                                          QString::fromLatin1(e.ErrorMessage()),
+                                          QSqlError::StatementError);
+        }
+    }
+
+    mResult.elapsedNs = timer.nsecsElapsed();
+    fi.reportResult(mResult);
+    d->finish(fi);
+}
+//-----------------------------------------------------------------------//
+// Formats the rows on this thread while the writer writes them on its own
+void QFBCsvJob::exportRows(IBPP::Transaction &tr, IBPP::Statement &st)
+{
+    QFBCsvWriter writer(mDevice, s.bufferSize);
+    d->writers.start(&writer);
+
+    bool formatted;
+    try
+    {
+        formatted = formatRows(tr, st, writer);
+    }
+    catch (IBPP::Exception&)
+    {
+        writer.finish();
+        mResult.bytes = writer.written();
+        throw;
+    }
+
+    if (!writer.finish() || !formatted)
+    {
+        if (!mResult.error.isValid())
+            mResult.error = QSqlError(QLatin1String("Unable to write the rows"),
+                                      writer.errorString(), QSqlError::UnknownError);
+    }
+    mResult.bytes = writer.written();
+}
+//-----------------------------------------------------------------------//
+bool QFBCsvJob::formatRows(IBPP::Transaction &tr, IBPP::Statement &st, QFBCsvWriter &writer)
+{
+    QFBColumnBatch batch;
+    batch.decimals = true;
+    batch.wideDecimals = true;
+    QByteArray out;
+    out.reserve(s.bufferSize);
+    bool header = s.header;
+
+    for (;;)
+    {
+        QSqlError error;
+        if (!qFBFetchColumns(d->iDb, tr, st, batch, s.batchSize, d->textCodec, error))
+        {
+            mResult.error = error;
+            return false;
+        }
+
+        const int cols = batch.columns.count();
+        if (header)
+        {
+            for (int c = 0; c < cols; ++c)
+            {
+                if (c)
+                    out.append(s.delimiter);
+                const QByteArray name = batch.columns.at(c).name.toUtf8();
+                qFBCsvText(out, name.constData(), name.size(), s.delimiter);
+            }
+            out.append("\r\n", 2);
+            header = false;
+        }
+
+        for (int r = 0; r < batch.rows; ++r)
+        {
+            for (int c = 0; c < cols; ++c)
+            {
+                if (c)
+                    out.append(s.delimiter);
+                qFBCsvField(out, batch.columns.at(c), r, s.delimiter);
+            }
+            out.append("\r\n", 2);
+
+            if (out.size() >= s.bufferSize && !writer.put(out))
+                return false;
+        }
+
+        mResult.rows += batch.rows;
+        fi.setProgressValue(int(qMin<qint64>(mResult.rows, INT_MAX)));
+        if (batch.atEnd || fi.isCanceled())
+            break;
+    }
+
+    return out.isEmpty() || writer.put(out);
+}
+
+//-----------------------------------------------------------------------//
+class QFBCsvDetach : public QRunnable
+{
+public:
+    explicit QFBCsvDetach(QFBCsvExporterPrivate *dd) : d(dd) {}
+    void run() Q_DECL_OVERRIDE { d->detach(); }
+
+private:
+    QFBCsvExporterPrivate *d;
+};
+
+//-----------------------------------------------------------------------//
+//-----------------------------------------------------------------------//
+QFBCsvExporter::QFBCsvExporter(const QSqlDatabase &db, QObject *parent)
+    : QObject(parent), d(new QFBCsvExporterPrivate)
+{
+    qRegisterMetaType<QFBCsvExportResult>("QFBCsvExportResult");
+
+    if (db.driverName() != QLatin1String("QFIREBIRD"))
+        qWarning("QFBCsvExporter: '%s' is not a QFIREBIRD connection",
+                 db.connectionName().toLocal8Bit().constData());
+
+    d->params = QFBConnectionParams(db);
+}
+//-----------------------------------------------------------------------//
+QFBCsvExporter::~QFBCsvExporter()
+{
+    {
+        QMutexLocker locker(&d->mutex);
+        for (int i = 0; i < d->pending.count(); ++i)
+            d->pending[i].cancel();
+    }
+    d->pool.start(new QFBCsvDetach(d));
+    d->pool.waitForDone();
+    delete d;
+}
+//-----------------------------------------------------------------------//
+void QFBCsvExporter::setDelimiter(char delimiter)
+{
+    d->settings.delimiter = delimiter;
+}
+//-----------------------------------------------------------------------//
+char QFBCsvExporter::delimiter() const
+{
+    return d->settings.delimiter;
+}
+//-----------------------------------------------------------------------//
+void QFBCsvExporter::setHeader(bool header)
+{
+    d->settings.header = header;
+}
+//-----------------------------------------------------------------------//
+bool QFBCsvExporter::header() const
+{
+    return d->settings.header;
+}
+//-----------------------------------------------------------------------//
+void QFBCsvExporter::setBatchSize(int rows)
+{
+    d->settings.batchSize = qMax(1, rows);
+}
+//-----------------------------------------------------------------------//
+int QFBCsvExporter::batchSize() const
+{
+    return d->settings.batchSize;
+}
+//-----------------------------------------------------------------------//
+void QFBCsvExporter::setBufferSize(int bytes)
+{
+    d->settings.bufferSize = qMax(4096, bytes);
+}
+//-----------------------------------------------------------------------//
+int QFBCsvExporter::bufferSize() const
+{
+    return d->settings.bufferSize;
+}
+//-----------------------------------------------------------------------//
+QFuture<QFBCsvExportResult> QFBCsvExporter::exportQuery(const QString &query, QIODevice *device,
+                                                        const QVector<QVariant> &boundValues)
+{
+    QFBCsvJob *job = new QFBCsvJob(d, query, device, boundValues);
+    job->fi.reportStarted();
+    QFuture<QFBCsvExportResult> future = job->fi.future();
+
+    {
+        QMutexLocker locker(&d->mutex);
+        d->pending.append(job->fi);
+    }
+    d->pool.start(job);
+
+    return future;
+}
+//-----------------------------------------------------------------------//
+bool QFBCsvExporter::waitForDone(int msecs)
+{
+    return d->pool.waitForDone(msecs);
+}
@@ -0,0 +1,110 @@
+/*
+* This file is part of QtFirebirdIBPPSQLDriver - Qt SQL driver for Firebird with IBPP library
+* Copyright (C) 2006-2010 Alex Wencel
+*
+* Contact e-mail: Alex Wencel <alex.wencel@gmail.com>
+* Program URL   : http://code.google.com/p/qtfirebirdibppsqldriver
+*
+* GNU Lesser General Public License Usage
+* This file may be used under the terms of the GNU Lesser
+* General Public License version 2.1 as published by the Free Software
+* Foundation and appearing in the file LICENSE.LGPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU Lesser General Public License version 2.1 requirements
+* will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+*
+* GNU General Public License Usage
+* Alternatively, this file may be used under the terms of the GNU
+* General Public License version 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU General Public License version 3.0 requirements will be
+* met: http://www.gnu.org/copyleft/gpl.html.
+*
+*/
+
+#ifndef QFBCSVEXPORT_H
+#define QFBCSVEXPORT_H
+
+#include <QtCore/qfuture.h>
+#include <QtCore/qmetatype.h>
+#include <QtCore/qobject.h>
+#include <QtCore/qvariant.h>
+#include <QtCore/qvector.h>
+#include <QtSql/qsqldatabase.h>
+#include <QtSql/qsqlerror.h>
+
+QT_BEGIN_HEADER
+class QIODevice;
+class QFBCsvExporterPrivate;
+
+// Outcome of QFBCsvExporter::exportQuery(). If error is valid the export
+// stopped early, the device holds the rows written before.
+struct QFBCsvExportResult
+{
+    QFBCsvExportResult() : rows(0), bytes(0), elapsedNs(0) {}
+
+    double rowsPerSecond() const { return elapsedNs > 0 ? rows * 1e9 / elapsedNs : 0.0; }
+
+    qint64 rows;
+    qint64 bytes;
+    qint64 elapsedNs;
+    QSqlError error;
+};
+
+// Writes the rows of a SELECT to a QIODevice as CSV (RFC 4180) or, with a
+// '\t' delimiter, TSV, without the QSqlQuery and QVariant path. Each
+// QFBCsvExporter opens its own attachment, with the parameters of the
+// QSqlDatabase it was created from, and reads in a concurrency (snapshot)
+// transaction.
+//
+// exportQuery() runs on two worker threads: one fetches the rows column by
+// column (QFBResult::fetchColumns()) and formats them straight into a byte
+// buffer; each time bufferSize() bytes are filled the buffer is handed to
+// the other thread, which writes it to the device while the first one fills
+// the second buffer.
+//
+// The fields are separated by delimiter() and the records ended by CRLF.
+// Text is UTF-8, quoted with '"' when it holds the delimiter, a quote or a
+// line break; an empty string is written "" and NULL as an empty field, as
+// QFBBulkLoader reads them. Integers and NUMERIC values are written exactly,
+// with the digits of their scale, doubles in the shortest form that reads
+// back the same, booleans as true or false. Dates are "2024-05-17", times
+// "13:45:30.1234", timestamps "2024-05-17 13:45:30.1234", in UTC with a
+// "+00:00" suffix for TIMESTAMP WITH TIME ZONE. OCTETS strings and binary
+// blobs are written in hexadecimal. With header() the first record holds the
+// column names.
+//
+// QFuture::cancel() stops the export after the batch in progress. The
+// progress value of the future is the count of rows formatted. The device
+// must stay valid until the future finishes and be writable from another
+// thread (QFile, QBuffer); it is flushed but not closed.
+class QFBCsvExporter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit QFBCsvExporter(const QSqlDatabase &db, QObject *parent = nullptr);
+    virtual ~QFBCsvExporter();
+
+    void setDelimiter(char delimiter);
+    char delimiter() const;
+    void setHeader(bool header);
+    bool header() const;
+    void setBatchSize(int rows);
+    int batchSize() const;
+    void setBufferSize(int bytes);
+    int bufferSize() const;
+
+    QFuture<QFBCsvExportResult> exportQuery(const QString &query, QIODevice *device,
+                                            const QVector<QVariant> &boundValues = QVector<QVariant>());
+    bool waitForDone(int msecs = -1);
+
+private:
+    Q_DISABLE_COPY(QFBCsvExporter)
+    QFBCsvExporterPrivate *d;
+};
+
+Q_DECLARE_METATYPE(QFBCsvExportResult)
+
+QT_END_HEADER
+#endif // QFBCSVEXPORT_H
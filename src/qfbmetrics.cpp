@@ -0,0 +1,239 @@
+/*
+* This file is part of QtFirebirdIBPPSQLDriver - Qt SQL driver for Firebird with IBPP library
+* Copyright (C) 2006-2010 Alex Wencel
+*
+* Contact e-mail: Alex Wencel <alex.wencel@gmail.com>
+* Program URL   : http://code.google.com/p/qtfirebirdibppsqldriver
+*
+* GNU Lesser General Public License Usage
+* This file may be used under the terms of the GNU Lesser
+* General Public License version 2.1 as published by the Free Software
+* Foundation and appearing in the file LICENSE.LGPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU Lesser General Public License version 2.1 requirements
+* will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+*
+* GNU General Public License Usage
+* Alternatively, this file may be used under the terms of the GNU
+* General Public License version 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU General Public License version 3.0 requirements will be
+* met: http://www.gnu.org/copyleft/gpl.html.
+*
+*/
+
+#include <QtDebug>
+#include <qmap.h>
+#include <qmutex.h>
+
+#include <atomic>
+
+#include "qfbmetrics.h"
+#include "qsql_ibpp.h"
+#include "qsql_ibpp_p.h"
+
+//-----------------------------------------------------------------------//
+namespace {
+
+struct QFBMetricsData
+{
+    QFBMetricsData()
+        : enabled(false), driverAttachments(0), helperAttachments(0), transactions(0)
+    { reset(); }
+
+    void reset()
+    {
+        prepares = 0;
+        executions = 0;
+        reuses = 0;
+        failures = 0;
+        rows = 0;
+        bytesDecoded = 0;
+        blobBytes = 0;
+        executeNs = 0;
+        fetchNs = 0;
+        decodeNs = 0;
+        blobNs = 0;
+        QMutexLocker locker(&errorMutex);
+        errors.clear();
+    }
+
+    std::atomic<bool> enabled;
+
+    std::atomic<qint64> driverAttachments;  // QFBDriver::open()
+    std::atomic<qint64> helperAttachments;  // QFBAsyncQuery, QFBParallelQuery
+    std::atomic<qint64> transactions;
+
+    std::atomic<qint64> prepares;
+    std::atomic<qint64> executions;
+    std::atomic<qint64> reuses;
+    std::atomic<qint64> failures;
+    std::atomic<qint64> rows;
+    std::atomic<qint64> bytesDecoded;
+    std::atomic<qint64> blobBytes;
+    std::atomic<qint64> executeNs;
+    std::atomic<qint64> fetchNs;
+    std::atomic<qint64> decodeNs;
+    std::atomic<qint64> blobNs;
+
+    // Errors are rare, a lock is fine
+    QMutex errorMutex;
+    QMap<int, qint64> errors;   // By SQLCODE, 0 for the other errors
+};
+
+}
+
+Q_GLOBAL_STATIC(QFBMetricsData, qFBMetrics)
+
+//-----------------------------------------------------------------------//
+bool qFBMetricsEnabled()
+{
+    return qFBMetrics()->enabled.load(std::memory_order_relaxed);
+}
+//-----------------------------------------------------------------------//
+void qFBMetricsAttachments(int delta, bool helper)
+{
+    QFBMetricsData *m = qFBMetrics();
+    (helper ? m->helperAttachments : m->driverAttachments).fetch_add(delta, std::memory_order_relaxed);
+}
+//-----------------------------------------------------------------------//
+void qFBMetricsTransactions(int delta)
+{
+    qFBMetrics()->transactions.fetch_add(delta, std::memory_order_relaxed);
+}
+//-----------------------------------------------------------------------//
+void qFBMetricsPrepared()
+{
+    qFBMetrics()->prepares.fetch_add(1, std::memory_order_relaxed);
+}
+//-----------------------------------------------------------------------//
+void qFBMetricsExecuted(const QFBStatementStats &stats, bool reused)
+{
+    QFBMetricsData *m = qFBMetrics();
+    m->executions.fetch_add(1, std::memory_order_relaxed);
+    if (reused)
+        m->reuses.fetch_add(1, std::memory_order_relaxed);
+    if (stats.failed)
+        m->failures.fetch_add(1, std::memory_order_relaxed);
+    m->rows.fetch_add(stats.rows, std::memory_order_relaxed);
+    m->bytesDecoded.fetch_add(stats.bytesDecoded, std::memory_order_relaxed);
+    m->blobBytes.fetch_add(stats.blobBytes, std::memory_order_relaxed);
+    m->executeNs.fetch_add(stats.executeNs, std::memory_order_relaxed);
+    m->fetchNs.fetch_add(stats.fetchNs, std::memory_order_relaxed);
+    m->decodeNs.fetch_add(stats.decodeNs, std::memory_order_relaxed);
+    m->blobNs.fetch_add(stats.blobNs, std::memory_order_relaxed);
+}
+//-----------------------------------------------------------------------//
+void qFBMetricsError(int sqlCode)
+{
+    QFBMetricsData *m = qFBMetrics();
+    QMutexLocker locker(&m->errorMutex);
+    ++m->errors[sqlCode];
+}
+//-----------------------------------------------------------------------//
+void QFBMetrics::setEnabled(bool enable)
+{
+    qFBMetrics()->enabled.store(enable, std::memory_order_relaxed);
+}
+//-----------------------------------------------------------------------//
+bool QFBMetrics::isEnabled()
+{
+    return qFBMetricsEnabled();
+}
+//-----------------------------------------------------------------------//
+void QFBMetrics::reset()
+{
+    qFBMetrics()->reset();
+}
+//-----------------------------------------------------------------------//
+static void qFBMetricFamily(QByteArray &out, const char *name, const char *type,
+                            const char *unit, const char *help)
+{
+    out += "# TYPE "; out += name; out += ' '; out += type; out += '\n';
+    if (unit)
+    {
+        out += "# UNIT "; out += name; out += ' '; out += unit; out += '\n';
+    }
+    out += "# HELP "; out += name; out += ' '; out += help; out += '\n';
+}
+
+static void qFBMetricSample(QByteArray &out, const char *name, const char *suffix,
+                            const QByteArray &labels, const QByteArray &value)
+{
+    out += name;
+    out += suffix;
+    if (!labels.isEmpty())
+    {
+        out += '{'; out += labels; out += '}';
+    }
+    out += ' ';
+    out += value;
+    out += '\n';
+}
+
+static void qFBMetricCounter(QByteArray &out, const char *name, const char *help,
+                             const std::atomic<qint64> &value)
+{
+    qFBMetricFamily(out, name, "counter", 0, help);
+    qFBMetricSample(out, name, "_total", QByteArray(),
+                    QByteArray::number(value.load(std::memory_order_relaxed)));
+}
+
+static void qFBMetricSeconds(QByteArray &out, const char *name, const char *help,
+                             const std::atomic<qint64> &ns)
+{
+    qFBMetricFamily(out, name, "counter", "seconds", help);
+    qFBMetricSample(out, name, "_total", QByteArray(),
+                    QByteArray::number(ns.load(std::memory_order_relaxed) / 1e9, 'f', 9));
+}
+
+QByteArray QFBMetrics::render()
+{
+    QFBMetricsData *m = qFBMetrics();
+    QByteArray out;
+    out.reserve(4096);
+
+    qFBMetricFamily(out, "fb_attachments", "gauge", 0,
+                    "Open attachments, of the QFIREBIRD connections or of their helper classes.");
+    qFBMetricSample(out, "fb_attachments", "", "owner=\"driver\"",
+                    QByteArray::number(m->driverAttachments.load(std::memory_order_relaxed)));
+    qFBMetricSample(out, "fb_attachments", "", "owner=\"helper\"",
+                    QByteArray::number(m->helperAttachments.load(std::memory_order_relaxed)));
+    qFBMetricFamily(out, "fb_transactions_active", "gauge", 0,
+                    "Transactions started with QSqlDatabase::transaction() and not ended.");
+    qFBMetricSample(out, "fb_transactions_active", "", QByteArray(),
+                    QByteArray::number(m->transactions.load(std::memory_order_relaxed)));
+
+    qFBMetricCounter(out, "fb_statement_prepares", "Statements prepared.", m->prepares);
+    qFBMetricCounter(out, "fb_statement_executions", "Statement executions.", m->executions);
+    qFBMetricCounter(out, "fb_statement_reuses",
+                     "Executions of a statement already executed since its prepare.", m->reuses);
+    qFBMetricCounter(out, "fb_statement_failures", "Statement executions that failed.", m->failures);
+    qFBMetricCounter(out, "fb_rows_fetched", "Rows fetched.", m->rows);
+    qFBMetricFamily(out, "fb_decoded_bytes", "counter", "bytes", "Column data converted, blobs excluded.");
+    qFBMetricSample(out, "fb_decoded_bytes", "_total", QByteArray(),
+                    QByteArray::number(m->bytesDecoded.load(std::memory_order_relaxed)));
+    qFBMetricFamily(out, "fb_blob_read_bytes", "counter", "bytes", "Blob data read.");
+    qFBMetricSample(out, "fb_blob_read_bytes", "_total", QByteArray(),
+                    QByteArray::number(m->blobBytes.load(std::memory_order_relaxed)));
+    qFBMetricSeconds(out, "fb_execute_seconds", "Time of the executions on the server.", m->executeNs);
+    qFBMetricSeconds(out, "fb_fetch_seconds", "Time of the row fetches on the server.", m->fetchNs);
+    qFBMetricSeconds(out, "fb_decode_seconds", "Time of the row conversions, blobs excluded.", m->decodeNs);
+    qFBMetricSeconds(out, "fb_blob_read_seconds", "Time of the blob reads.", m->blobNs);
+
+    qFBMetricFamily(out, "fb_errors", "counter", 0,
+                    "Errors reported by the driver, by SQLCODE (none: not an SQL error).");
+    {
+        QMutexLocker locker(&m->errorMutex);
+        for (QMap<int, qint64>::const_iterator it = m->errors.constBegin();
+             it != m->errors.constEnd(); ++it)
+            qFBMetricSample(out, "fb_errors", "_total",
+                            "sqlcode=\"" + (it.key() ? QByteArray::number(it.key())
+                                                     : QByteArray("none")) + '"',
+                            QByteArray::number(it.value()));
+    }
+
+    out += "# EOF\n";
+    return out;
+}
@@ -0,0 +1,53 @@
+/*
+* This file is part of QtFirebirdIBPPSQLDriver - Qt SQL driver for Firebird with IBPP library
+* Copyright (C) 2006-2010 Alex Wencel
+*
+* Contact e-mail: Alex Wencel <alex.wencel@gmail.com>
+* Program URL   : http://code.google.com/p/qtfirebirdibppsqldriver
+*
+* GNU Lesser General Public License Usage
+* This file may be used under the terms of the GNU Lesser
+* General Public License version 2.1 as published by the Free Software
+* Foundation and appearing in the file LICENSE.LGPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU Lesser General Public License version 2.1 requirements
+* will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+*
+* GNU General Public License Usage
+* Alternatively, this file may be used under the terms of the GNU
+* General Public License version 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU General Public License version 3.0 requirements will be
+* met: http://www.gnu.org/copyleft/gpl.html.
+*
+*/
+
+#ifndef QFBMETRICS_H
+#define QFBMETRICS_H
+
+#include <QtCore/qbytearray.h>
+#include <QtCore/qstring.h>
+
+QT_BEGIN_HEADER
+
+// Process wide counters of the QFIREBIRD connections, rendered in the
+// OpenMetrics text format (Prometheus): open attachments, transactions
+// started with QSqlDatabase::transaction(), statements prepared, executed
+// and reused, rows, bytes and times of the executions, and errors by SQLCODE.
+// The attachments, transactions and errors are always counted; the
+// statement counters once enabled, which times the executions as the
+// statement statistics do.
+class QFBMetrics
+{
+public:
+    static void setEnabled(bool enable);
+    static bool isEnabled();
+    // Zeroes the counters, the attachments and transactions are kept
+    static void reset();
+    // The metrics in the OpenMetrics text format, ending with "# EOF"
+    static QByteArray render();
+};
+
+QT_END_HEADER
+#endif // QFBMETRICS_H
@@ -0,0 +1,101 @@
+/*
+* This file is part of QtFirebirdIBPPSQLDriver - Qt SQL driver for Firebird with IBPP library
+* Copyright (C) 2006-2010 Alex Wencel
+*
+* Contact e-mail: Alex Wencel <alex.wencel@gmail.com>
+* Program URL   : http://code.google.com/p/qtfirebirdibppsqldriver
+*
+* GNU Lesser General Public License Usage
+* This file may be used under the terms of the GNU Lesser
+* General Public License version 2.1 as published by the Free Software
+* Foundation and appearing in the file LICENSE.LGPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU Lesser General Public License version 2.1 requirements
+* will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+*
+* GNU General Public License Usage
+* Alternatively, this file may be used under the terms of the GNU
+* General Public License version 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU General Public License version 3.0 requirements will be
+* met: http://www.gnu.org/copyleft/gpl.html.
+*
+*/
+
+#include <QTimer>
+#include <qhostaddress.h>
+#include <qtcpserver.h>
+#include <qtcpsocket.h>
+
+#include "qfbmetrics.h"
+#include "qfbmetricsserver.h"
+
+//-----------------------------------------------------------------------//
+QFBMetricsServer::QFBMetricsServer(QObject *parent)
+    : QObject(parent), server(new QTcpServer(this))
+{
+    connect(server, &QTcpServer::newConnection, this, &QFBMetricsServer::newConnection);
+}
+//-----------------------------------------------------------------------//
+QFBMetricsServer::~QFBMetricsServer()
+{
+}
+//-----------------------------------------------------------------------//
+bool QFBMetricsServer::listen(quint16 port)
+{
+    return server->listen(QHostAddress::LocalHost, port);
+}
+//-----------------------------------------------------------------------//
+void QFBMetricsServer::close()
+{
+    server->close();
+}
+//-----------------------------------------------------------------------//
+bool QFBMetricsServer::isListening() const
+{
+    return server->isListening();
+}
+//-----------------------------------------------------------------------//
+quint16 QFBMetricsServer::serverPort() const
+{
+    return server->serverPort();
+}
+//-----------------------------------------------------------------------//
+QString QFBMetricsServer::errorString() const
+{
+    return server->errorString();
+}
+//-----------------------------------------------------------------------//
+// One response per connection, once the request headers have come; the
+// request line is only checked for GET
+void QFBMetricsServer::newConnection()
+{
+    while (QTcpSocket *socket = server->nextPendingConnection())
+    {
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        QTimer::singleShot(10000, socket, &QTcpSocket::abort);
+
+        connect(socket, &QTcpSocket::readyRead, socket, [socket]() {
+            const QByteArray request = socket->peek(socket->bytesAvailable());
+            if (!request.contains("\r\n\r\n") && !request.contains("\n\n") && request.size() < 8192)
+                return;
+            socket->readAll();
+
+            QByteArray response;
+            if (request.startsWith("GET "))
+            {
+                const QByteArray body = QFBMetrics::render();
+                response = "HTTP/1.1 200 OK\r\n"
+                           "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+                           "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+                           "Connection: close\r\n\r\n" + body;
+            }
+            else
+                response = "HTTP/1.1 405 Method Not Allowed\r\n"
+                           "Allow: GET\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+            socket->write(response);
+            socket->disconnectFromHost();
+        });
+    }
+}
@@ -0,0 +1,61 @@
+/*
+* This file is part of QtFirebirdIBPPSQLDriver - Qt SQL driver for Firebird with IBPP library
+* Copyright (C) 2006-2010 Alex Wencel
+*
+* Contact e-mail: Alex Wencel <alex.wencel@gmail.com>
+* Program URL   : http://code.google.com/p/qtfirebirdibppsqldriver
+*
+* GNU Lesser General Public License Usage
+* This file may be used under the terms of the GNU Lesser
+* General Public License version 2.1 as published by the Free Software
+* Foundation and appearing in the file LICENSE.LGPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU Lesser General Public License version 2.1 requirements
+* will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+*
+* GNU General Public License Usage
+* Alternatively, this file may be used under the terms of the GNU
+* General Public License version 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU General Public License version 3.0 requirements will be
+* met: http://www.gnu.org/copyleft/gpl.html.
+*
+*/
+
+#ifndef QFBMETRICSSERVER_H
+#define QFBMETRICSSERVER_H
+
+#include <QtCore/qobject.h>
+#include <QtCore/qstring.h>
+
+QT_BEGIN_HEADER
+class QTcpServer;
+
+// Serves QFBMetrics::render() over HTTP on the loopback interface, to be
+// scraped at http://127.0.0.1:<port>/metrics (any path is answered). The
+// requests are handled by the event loop of the thread of the server.
+class QFBMetricsServer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit QFBMetricsServer(QObject *parent = nullptr);
+    virtual ~QFBMetricsServer();
+
+    // Port 0 picks a free port, given by serverPort()
+    bool listen(quint16 port = 0);
+    void close();
+    bool isListening() const;
+    quint16 serverPort() const;
+    QString errorString() const;
+
+private Q_SLOTS:
+    void newConnection();
+
+private:
+    Q_DISABLE_COPY(QFBMetricsServer)
+    QTcpServer *server;
+};
+
+QT_END_HEADER
+#endif // QFBMETRICSSERVER_H
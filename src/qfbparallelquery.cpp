@@ -0,0 +1,748 @@
+/*
+* This file is part of QtFirebirdIBPPSQLDriver - Qt SQL driver for Firebird with IBPP library
+* Copyright (C) 2006-2010 Alex Wencel
+*
+* Contact e-mail: Alex Wencel <alex.wencel@gmail.com>
+* Program URL   : http://code.google.com/p/qtfirebirdibppsqldriver
+*
+* GNU Lesser General Public License Usage
+* This file may be used under the terms of the GNU Lesser
+* General Public License version 2.1 as published by the Free Software
+* Foundation and appearing in the file LICENSE.LGPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU Lesser General Public License version 2.1 requirements
+* will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+*
+* GNU General Public License Usage
+* Alternatively, this file may be used under the terms of the GNU
+* General Public License version 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU General Public License version 3.0 requirements will be
+* met: http://www.gnu.org/copyleft/gpl.html.
+*
+*/
+
+#include <QtDebug>
+#include <QTextCodec>
+#include <qatomic.h>
+#include <qlist.h>
+#include <qmutex.h>
+#include <qqueue.h>
+#include <qrunnable.h>
+#include <qsemaphore.h>
+#include <qthread.h>
+#include <qthreadpool.h>
+#include <qwaitcondition.h>
+
+#include "ibpp.h"
+#include "qfbparallelquery.h"
+#include "qsql_ibpp_p.h"
+
+//-----------------------------------------------------------------------//
+// Bounded FIFO of batches between partitions (producers) and the merger
+class QFBBatchQueue
+{
+public:
+    explicit QFBBatchQueue(int producers = 1)
+        : mProducers(producers)
+    {}
+
+    void push(const QFBRowBatch &batch, const QAtomicInt &abort);
+    bool pop(QFBRowBatch &batch);
+    void close();
+    void wake();
+
+private:
+    enum { Capacity = 16 };
+
+    QMutex mMutex;
+    QWaitCondition mNotEmpty;
+    QWaitCondition mNotFull;
+    QQueue<QFBRowBatch> mQueue;
+    int mProducers;
+};
+
+//-----------------------------------------------------------------------//
+void QFBBatchQueue::push(const QFBRowBatch &batch, const QAtomicInt &abort)
+{
+    QMutexLocker locker(&mMutex);
+    const bool isError = batch.error.type() != QSqlError::NoError;
+    while (!isError && mQueue.count() >= Capacity && !abort.load())
+        mNotFull.wait(&mMutex);
+
+    if (!isError && abort.load())
+        return;         // nobody is interested any more
+
+    mQueue.enqueue(batch);
+    mNotEmpty.wakeAll();
+}
+//-----------------------------------------------------------------------//
+bool QFBBatchQueue::pop(QFBRowBatch &batch)
+{
+    QMutexLocker locker(&mMutex);
+    while (mQueue.isEmpty() && mProducers > 0)
+        mNotEmpty.wait(&mMutex);
+
+    if (mQueue.isEmpty())
+        return false;
+
+    batch = mQueue.dequeue();
+    mNotFull.wakeAll();
+    return true;
+}
+//-----------------------------------------------------------------------//
+void QFBBatchQueue::close()
+{
+    QMutexLocker locker(&mMutex);
+    --mProducers;
+    mNotEmpty.wakeAll();
+}
+//-----------------------------------------------------------------------//
+void QFBBatchQueue::wake()
+{
+    QMutexLocker locker(&mMutex);
+    mNotFull.wakeAll();
+}
+
+//-----------------------------------------------------------------------//
+struct QFBPartition
+{
+    QString sql;
+    QVector<QVariant> values;
+};
+
+// State of one running query, shared by its coordinator and partitions
+struct QFBParallelRun
+{
+    QFBParallelRun() : snapshot(0) {}
+
+    QVector<QFBPartition> partitions;
+    QVector<QFBBatchQueue *> queues;    // one per partition, or a shared one
+    int64_t snapshot;
+    QAtomicInt abort;
+};
+
+//-----------------------------------------------------------------------//
+class QFBParallelQueryPrivate
+{
+public:
+    QFBParallelQueryPrivate()
+        : connections(qMax(1, QThread::idealThreadCount())), partitions(0),
+          batchSize(256), maxPending(4), order(QFBParallelQuery::Unordered), started(false),
+          textCodec(0), coordinatorCodec(0)
+    {
+        // one coordinator at a time, the partitions on a pool of their own:
+        // a coordinator waiting for its partitions never holds their threads
+        pool.setMaxThreadCount(1);
+        pool.setExpiryTimeout(-1);
+        partitionPool.setExpiryTimeout(-1);
+    }
+
+    void start();
+    bool acquire(IBPP::Database &db, QTextCodec *&codec, QSqlError &error);
+    void release(IBPP::Database &db);
+    void finish(const QSharedPointer<QFBRowStreamPrivate> &out);
+
+public:
+    QFBConnectionParams params;
+
+    int connections;
+    int partitions;
+    int batchSize;
+    int maxPending;
+    QFBParallelQuery::MergeOrder order;
+
+    QThreadPool pool;           // coordinators, one query at a time
+    QThreadPool partitionPool;
+    QAtomicInt snapshotShared;
+
+    QMutex mutex;               // guards the members below
+    QList<QSharedPointer<QFBRowStreamPrivate> > pending;
+    QList<IBPP::Database> idle;
+    QSemaphore available;
+    bool started;
+    QTextCodec *textCodec;      // of the pooled attachments
+
+    // used by the coordinator only (a single thread)
+    IBPP::Database coordinator;
+    QTextCodec *coordinatorCodec;
+};
+
+//-----------------------------------------------------------------------//
+void QFBParallelQueryPrivate::start()
+{
+    QMutexLocker locker(&mutex);
+    if (started)
+        return;
+
+    started = true;
+    available.release(connections);
+    partitionPool.setMaxThreadCount(connections);
+}
+//-----------------------------------------------------------------------//
+bool QFBParallelQueryPrivate::acquire(IBPP::Database &db, QTextCodec *&codec, QSqlError &error)
+{
+    available.acquire();
+    {
+        QMutexLocker locker(&mutex);
+        if (!idle.isEmpty())
+        {
+            db = idle.takeLast();
+            codec = textCodec;
+            return true;
+        }
+    }
+
+    if (!qFBAttach(params, db, codec, error))
+    {
+        available.release();
+        return false;
+    }
+
+    QMutexLocker locker(&mutex);
+    textCodec = codec;
+    return true;
+}
+//-----------------------------------------------------------------------//
+void QFBParallelQueryPrivate::release(IBPP::Database &db)
+{
+    {
+        QMutexLocker locker(&mutex);
+        idle.append(db);
+    }
+    db.clear();
+    available.release();
+}
+//-----------------------------------------------------------------------//
+void QFBParallelQueryPrivate::finish(const QSharedPointer<QFBRowStreamPrivate> &out)
+{
+    {
+        QMutexLocker locker(&mutex);
+        pending.removeOne(out);
+    }
+    out->finish();
+}
+
+//-----------------------------------------------------------------------//
+// Runs one partition on a pooled attachment and feeds its queue
+class QFBPartitionJob : public QRunnable
+{
+public:
+    QFBPartitionJob(QFBParallelQueryPrivate *dd, QFBParallelRun *r, int p, QFBBatchQueue *q)
+        : d(dd), run_(r), partition(p), queue(q)
+    {}
+
+    void run() Q_DECL_OVERRIDE;
+
+private:
+    QFBParallelQueryPrivate *d;
+    QFBParallelRun *run_;
+    int partition;
+    QFBBatchQueue *queue;
+};
+
+//-----------------------------------------------------------------------//
+void QFBPartitionJob::run()
+{
+    QFBRowBatch batch;
+    IBPP::Database db;
+    QTextCodec *textCodec = 0;
+
+    if (run_->abort.load() || !d->acquire(db, textCodec, batch.error))
+    {
+        if (batch.error.isValid())
+            queue->push(batch, run_->abort);
+        queue->close();
+        return;
+    }
+
+    const QFBPartition &p = run_->partitions.at(partition);
+    IBPP::Transaction tr;
+    IBPP::Statement st;
+    try
+    {
+        tr = IBPP::TransactionFactory(db, IBPP::amRead, IBPP::ilConcurrency, IBPP::lrWait);
+        if (run_->snapshot > 0)
+            tr->SetSnapshotNumber(db, run_->snapshot);
+        tr->Start();
+
+        st = IBPP::StatementFactory(db, tr);
+        st->Prepare(qFBToIBPPStr(p.sql, textCodec));
+        if (!qFBBindValues(st, p.values, textCodec, batch.error))
+        {
+            tr->Rollback();
+            queue->push(batch, run_->abort);
+            st.clear();
+            tr.clear();
+            d->release(db);
+            queue->close();
+            return;
+        }
+        st->Execute();
+
+        batch.record = qFBRecord(st);
+        const int cols = st->Columns();
+        QFBArrayCache arrays;
+        while (!run_->abort.load() && st->Fetch())
+        {
+            QVector<QVariant> row(cols);
+            qFBFetchRow(db, tr, st, row.data(), textCodec, 0, 0, &arrays);
+            batch.rows.append(row);
+
+            if (batch.rows.count() >= d->batchSize)
+            {
+                queue->push(batch, run_->abort);
+                batch.rows.clear();
+            }
+        }
+        if (!batch.rows.isEmpty())
+            queue->push(batch, run_->abort);
+
+        st->Close();
+        tr->Commit();
+    }
+    catch (IBPP::Exception& e)
+    {
+        try
+        {
+            if (tr != 0 && tr->Started())
+                tr->Rollback();
+        }
+        catch (IBPP::Exception&)
+        {
+        }
+
+        batch.rows.clear();
+        batch.error = QSqlError(QString::fromLatin1("Unable to run partition %1").arg(partition),
+                                QString::fromLatin1(e.ErrorMessage()), QSqlError::StatementError);
+        queue->push(batch, run_->abort);
+    }
+
+    st.clear();
+    tr.clear();
+    d->release(db);
+    queue->close();
+}
+
+//-----------------------------------------------------------------------//
+// Plans the partitions in a snapshot of its own attachment, starts them
+// and merges their batches into the stream.
+class QFBParallelJob : public QRunnable
+{
+public:
+    QFBParallelJob(QFBParallelQueryPrivate *dd, bool byKey, const QString &source,
+                   const QString &key, const QString &where, const QVector<QVariant> &values)
+        : d(dd), mByKey(byKey), mSource(source), mKey(key), mWhere(where), mValues(values)
+    {}
+
+    void run() Q_DECL_OVERRIDE;
+
+public:
+    QSharedPointer<QFBRowStreamPrivate> out;
+
+private:
+    bool planByKey(IBPP::Transaction &tr, QFBParallelRun &r, QSqlError &error);
+    void planByDbKey(IBPP::Transaction &tr, QFBParallelRun &r);
+    void merge(QFBParallelRun &r);
+
+    QFBParallelQueryPrivate *d;
+    bool mByKey;
+    QString mSource;        // query (by key) or table (by RDB$DB_KEY)
+    QString mKey;           // key column (by key) or column list (by RDB$DB_KEY)
+    QString mWhere;
+    QVector<QVariant> mValues;
+};
+
+//-----------------------------------------------------------------------//
+void QFBParallelJob::run()
+{
+    if (out->isCanceled())
+    {
+        d->finish(out);
+        return;
+    }
+
+    QFBRowBatch batch;
+    if (d->coordinator == 0 || !d->coordinator->Connected())
+    {
+        if (!qFBAttach(d->params, d->coordinator, d->coordinatorCodec, batch.error))
+        {
+            out->push(batch);
+            d->finish(out);
+            return;
+        }
+    }
+
+    QFBParallelRun r;
+    IBPP::Transaction tr;
+    try
+    {
+        // This transaction holds the snapshot the partitions share
+        tr = IBPP::TransactionFactory(d->coordinator, IBPP::amRead,
+                                      IBPP::ilConcurrency, IBPP::lrWait);
+        tr->Start();
+
+        try
+        {
+            IBPP::Statement st = IBPP::StatementFactory(d->coordinator, tr);
+            st->Prepare("SELECT RDB$GET_CONTEXT('SYSTEM', 'SNAPSHOT_NUMBER') FROM RDB$DATABASE");
+            st->Execute();
+            std::string number;
+            if (st->Fetch() && !st->IsNull(1))
+            {
+                st->Get(1, number);
+                r.snapshot = QString::fromStdString(number).trimmed().toLongLong();
+            }
+            st->Close();
+        }
+        catch (IBPP::Exception&)
+        {
+            r.snapshot = 0;     // before Firebird 4
+        }
+        d->snapshotShared.store(r.snapshot > 0 ? 1 : 0);
+
+        if (mByKey)
+        {
+            if (!planByKey(tr, r, batch.error))
+            {
+                tr->Rollback();
+                out->push(batch);
+                d->finish(out);
+                return;
+            }
+        }
+        else
+            planByDbKey(tr, r);
+    }
+    catch (IBPP::Exception& e)
+    {
+        try
+        {
+            if (tr != 0 && tr->Started())
+                tr->Rollback();
+        }
+        catch (IBPP::Exception&)
+        {
+        }
+
+        batch.error = QSqlError(QLatin1String("Unable to plan partitions"),
+                                QString::fromLatin1(e.ErrorMessage()), QSqlError::StatementError);
+        out->push(batch);
+        d->finish(out);
+        return;
+    }
+
+    merge(r);
+
+    try
+    {
+        tr->Commit();
+    }
+    catch (IBPP::Exception& e)
+    {
+        qWarning("QFBParallelQuery: Unable to end the snapshot transaction: %s", e.ErrorMessage());
+    }
+    d->finish(out);
+}
+//-----------------------------------------------------------------------//
+bool QFBParallelJob::planByKey(IBPP::Transaction &tr, QFBParallelRun &r, QSqlError &error)
+{
+    QTextCodec *textCodec = d->coordinatorCodec;
+    const QString key = QLatin1String("QFB_P.") + mKey;
+    const QString derived = QLatin1String(" FROM (") + mSource + QLatin1String(") QFB_P");
+
+    IBPP::Statement st = IBPP::StatementFactory(d->coordinator, tr);
+    st->Prepare(qFBToIBPPStr(QLatin1String("SELECT MIN(") + key + QLatin1String("), MAX(") + key +
+                             QLatin1String(")") + derived, textCodec));
+    if (!qFBBindValues(st, mValues, textCodec, error))
+        return false;
+    st->Execute();
+
+    bool ranged = false;
+    int64_t lo = 0, hi = 0;
+    if (st->Fetch() && !st->IsNull(1) && !st->IsNull(2) && st->ColumnScale(1) == 0)
+    {
+        switch (st->ColumnType(1))
+        {
+        case IBPP::sdSmallint:
+        case IBPP::sdInteger:
+        case IBPP::sdLargeint:
+            st->Get(1, lo);
+            st->Get(2, hi);
+            ranged = true;
+            break;
+        default:
+            qWarning("QFBParallelQuery: partition key %s is not an integer, running one partition",
+                     mKey.toLocal8Bit().constData());
+            break;
+        }
+    }
+    st->Close();
+
+    const uint64_t span = ranged ? uint64_t(hi) - uint64_t(lo) + 1 : 0;
+    int count = d->partitions > 0 ? d->partitions : d->connections;
+    if (span != 0 && uint64_t(count) > span)
+        count = int(span);
+
+    if (!ranged || count <= 1)
+    {
+        QFBPartition p;
+        p.sql = mSource;
+        p.values = mValues;
+        r.partitions.append(p);
+        return true;
+    }
+
+    const QString order = d->order == QFBParallelQuery::Ordered ?
+                          QLatin1String(" ORDER BY ") + key : QString();
+    // span wraps to 0 for the full 64 bit range
+    const uint64_t step = span != 0 ? span / count + (span % count ? 1 : 0)
+                                    : ~uint64_t(0) / count + 1;
+    for (int k = 0; k < count; ++k)
+    {
+        const uint64_t first = uint64_t(lo) + step * k;
+        if (first > uint64_t(hi) || first < uint64_t(lo))
+            break;
+        uint64_t last = first + step - 1;
+        if (last > uint64_t(hi) || last < first)
+            last = uint64_t(hi);
+
+        QFBPartition p;
+        p.sql = QLatin1String("SELECT *") + derived + QLatin1String(" WHERE ") + key +
+                QLatin1String(" BETWEEN ? AND ?");
+        if (k == 0)
+            p.sql += QLatin1String(" OR ") + key + QLatin1String(" IS NULL");
+        p.sql += order;
+        p.values = mValues;
+        p.values << QVariant(qlonglong(first)) << QVariant(qlonglong(last));
+        r.partitions.append(p);
+    }
+    return true;
+}
+//-----------------------------------------------------------------------//
+void QFBParallelJob::planByDbKey(IBPP::Transaction &tr, QFBParallelRun &r)
+{
+    QTextCodec *textCodec = d->coordinatorCodec;
+    QString relation = mSource.trimmed();
+    if (relation.startsWith(QLatin1Char('"')) && relation.endsWith(QLatin1Char('"')))
+        relation = relation.mid(1, relation.length() - 2);
+    else
+        relation = relation.toUpper();
+
+    IBPP::Statement st = IBPP::StatementFactory(d->coordinator, tr);
+    st->Prepare("SELECT COUNT(*) FROM RDB$PAGES P "
+                "JOIN RDB$RELATIONS R ON R.RDB$RELATION_ID = P.RDB$RELATION_ID "
+                "WHERE R.RDB$RELATION_NAME = ? AND P.RDB$PAGE_TYPE = 4");
+    st->Set(1, qFBToIBPPStr(relation, textCodec));
+    st->Execute();
+    int pointerPages = 0;
+    if (st->Fetch())
+        st->Get(1, pointerPages);
+    st->Close();
+
+    const QString select = QLatin1String("SELECT ") + mKey + QLatin1String(" FROM ") + mSource;
+    const QString filter = mWhere.trimmed().isEmpty() ?
+                           QString() : QLatin1String(" AND (") + mWhere + QLatin1String(")");
+
+    int count = d->partitions > 0 ? d->partitions : d->connections;
+    if (count > pointerPages)
+        count = pointerPages;
+
+    // MAKE_DBKEY is a Firebird 4 function, as the snapshot number: without
+    // the latter the table is read in one partition
+    if (count <= 1 || r.snapshot == 0)
+    {
+        QFBPartition p;
+        p.sql = select;
+        if (!filter.isEmpty())
+            p.sql += QLatin1String(" WHERE ") + mWhere;
+        r.partitions.append(p);
+        return;
+    }
+
+    QString quoted = relation;
+    quoted.replace(QLatin1Char('\''), QLatin1String("''"));
+    const QString dbkey = QLatin1String("MAKE_DBKEY('") + quoted + QLatin1String("', 0, 0, %1)");
+
+    for (int k = 0; k < count; ++k)
+    {
+        const int first = int(qint64(pointerPages) * k / count);
+        const int next = int(qint64(pointerPages) * (k + 1) / count);
+
+        QFBPartition p;
+        p.sql = select + QLatin1String(" WHERE RDB$DB_KEY >= ") + dbkey.arg(first);
+        if (k < count - 1)
+            p.sql += QLatin1String(" AND RDB$DB_KEY < ") + dbkey.arg(next);
+        p.sql += filter;
+        r.partitions.append(p);
+    }
+}
+//-----------------------------------------------------------------------//
+void QFBParallelJob::merge(QFBParallelRun &r)
+{
+    const int count = r.partitions.count();
+    const bool ordered = d->order == QFBParallelQuery::Ordered;
+
+    if (ordered)
+    {
+        for (int k = 0; k < count; ++k)
+            r.queues.append(new QFBBatchQueue(1));
+    }
+    else
+        r.queues.append(new QFBBatchQueue(count));
+
+    for (int k = 0; k < count; ++k)
+        d->partitionPool.start(new QFBPartitionJob(d, &r, k, r.queues.at(ordered ? k : 0)));
+
+    bool failed = false;
+    for (int q = 0; q < r.queues.count(); ++q)
+    {
+        QFBRowBatch batch;
+        while (r.queues.at(q)->pop(batch))
+        {
+            if (failed)
+                continue;           // draining
+
+            // blocks while the consumer is behind, false once cancelled
+            if (!out->push(batch) || batch.error.isValid())
+                failed = true;
+
+            if (failed)
+            {
+                failed = true;
+                r.abort.store(1);
+                for (int i = 0; i < r.queues.count(); ++i)
+                    r.queues.at(i)->wake();
+            }
+        }
+    }
+
+    // all the partitions have closed their queue
+    qDeleteAll(r.queues);
+    r.queues.clear();
+}
+
+//-----------------------------------------------------------------------//
+//-----------------------------------------------------------------------//
+QFBParallelQuery::QFBParallelQuery(const QSqlDatabase &db, QObject *parent)
+    : QObject(parent), d(new QFBParallelQueryPrivate)
+{
+    qRegisterMetaType<QFBRowBatch>("QFBRowBatch");
+
+    if (db.driverName() != QLatin1String("QFIREBIRD"))
+        qWarning("QFBParallelQuery: '%s' is not a QFIREBIRD connection",
+                 db.connectionName().toLocal8Bit().constData());
+
+    d->params = QFBConnectionParams(db);
+}
+//-----------------------------------------------------------------------//
+QFBParallelQuery::~QFBParallelQuery()
+{
+    {
+        QMutexLocker locker(&d->mutex);
+        for (int i = 0; i < d->pending.count(); ++i)
+            d->pending[i]->cancel();
+    }
+    d->pool.waitForDone();
+    d->partitionPool.waitForDone();
+
+    for (int i = 0; i < d->idle.count(); ++i)
+        qFBDetach(d->idle[i]);
+    qFBDetach(d->coordinator);
+    delete d;
+}
+//-----------------------------------------------------------------------//
+void QFBParallelQuery::setConnections(int count)
+{
+    QMutexLocker locker(&d->mutex);
+    if (d->started)
+    {
+        qWarning("QFBParallelQuery::setConnections: the pool is already in use");
+        return;
+    }
+    d->connections = qMax(1, count);
+}
+//-----------------------------------------------------------------------//
+int QFBParallelQuery::connections() const
+{
+    return d->connections;
+}
+//-----------------------------------------------------------------------//
+void QFBParallelQuery::setPartitions(int count)
+{
+    d->partitions = qMax(0, count);
+}
+//-----------------------------------------------------------------------//
+int QFBParallelQuery::partitions() const
+{
+    return d->partitions > 0 ? d->partitions : d->connections;
+}
+//-----------------------------------------------------------------------//
+void QFBParallelQuery::setBatchSize(int rows)
+{
+    d->batchSize = qMax(1, rows);
+}
+//-----------------------------------------------------------------------//
+int QFBParallelQuery::batchSize() const
+{
+    return d->batchSize;
+}
+//-----------------------------------------------------------------------//
+void QFBParallelQuery::setMaxPendingBatches(int count)
+{
+    d->maxPending = qMax(1, count);
+}
+//-----------------------------------------------------------------------//
+int QFBParallelQuery::maxPendingBatches() const
+{
+    return d->maxPending;
+}
+//-----------------------------------------------------------------------//
+void QFBParallelQuery::setMergeOrder(MergeOrder order)
+{
+    d->order = order;
+}
+//-----------------------------------------------------------------------//
+QFBParallelQuery::MergeOrder QFBParallelQuery::mergeOrder() const
+{
+    return d->order;
+}
+//-----------------------------------------------------------------------//
+QFBRowStream *QFBParallelQuery::start(QFBParallelJob *job)
+{
+    d->start();
+    job->out = QSharedPointer<QFBRowStreamPrivate>(new QFBRowStreamPrivate(d->maxPending));
+    QFBRowStream *stream = new QFBRowStream(job->out, this);
+
+    {
+        QMutexLocker locker(&d->mutex);
+        d->pending.append(job->out);
+    }
+    d->pool.start(job);
+
+    return stream;
+}
+//-----------------------------------------------------------------------//
+QFBRowStream *QFBParallelQuery::execByKey(const QString &query, const QString &keyColumn,
+                                          const QVector<QVariant> &boundValues)
+{
+    return start(new QFBParallelJob(d, true, query, keyColumn, QString(), boundValues));
+}
+//-----------------------------------------------------------------------//
+QFBRowStream *QFBParallelQuery::execByDbKey(const QString &table, const QString &columns,
+                                            const QString &where)
+{
+    return start(new QFBParallelJob(d, false, table, columns, where, QVector<QVariant>()));
+}
+//-----------------------------------------------------------------------//
+bool QFBParallelQuery::snapshotShared() const
+{
+    return d->snapshotShared.load() != 0;
+}
+//-----------------------------------------------------------------------//
+bool QFBParallelQuery::waitForDone(int msecs)
+{
+    return d->pool.waitForDone(msecs) && d->partitionPool.waitForDone(msecs);
+}
+//-----------------------------------------------------------------------//
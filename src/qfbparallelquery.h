@@ -0,0 +1,101 @@
+/*
+* This file is part of QtFirebirdIBPPSQLDriver - Qt SQL driver for Firebird with IBPP library
+* Copyright (C) 2006-2010 Alex Wencel
+*
+* Contact e-mail: Alex Wencel <alex.wencel@gmail.com>
+* Program URL   : http://code.google.com/p/qtfirebirdibppsqldriver
+*
+* GNU Lesser General Public License Usage
+* This file may be used under the terms of the GNU Lesser
+* General Public License version 2.1 as published by the Free Software
+* Foundation and appearing in the file LICENSE.LGPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU Lesser General Public License version 2.1 requirements
+* will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+*
+* GNU General Public License Usage
+* Alternatively, this file may be used under the terms of the GNU
+* General Public License version 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU General Public License version 3.0 requirements will be
+* met: http://www.gnu.org/copyleft/gpl.html.
+*
+*/
+
+#ifndef QFBPARALLELQUERY_H
+#define QFBPARALLELQUERY_H
+
+#include <QtCore/qobject.h>
+
+#include "qfbasyncquery.h"
+
+QT_BEGIN_HEADER
+class QFBParallelJob;
+class QFBParallelQueryPrivate;
+
+// Splits a SELECT in partitions and runs them in parallel over a pool of
+// attachments opened with the parameters of the given QSqlDatabase.
+//
+// execByKey() wraps the query as a derived table and partitions it on an
+// integer output column: the MIN/MAX of the key are read first and the
+// range is cut in partitions() slices (NULL keys go to the first one).
+// execByDbKey() scans one table by RDB$DB_KEY ranges of its pointer pages
+// (MAKE_DBKEY, Firebird 4 and later; older servers read it in one partition).
+//
+// On Firebird 4 and later every partition runs in a read-only transaction
+// started at the same snapshot (isc_tpb_at_snapshot_number). With older
+// servers each partition gets its own concurrency transaction when it starts
+// and snapshotShared() returns false.
+//
+// The executor opens up to connections() attachments for the partitions,
+// plus one that plans the query and holds the shared snapshot. The partitions
+// run on a thread pool of their own, so queries queued behind a running one
+// never take the threads it waits for.
+//
+// With Ordered the batches of the returned stream come partition after
+// partition, rows ordered by the key inside each partition (execByKey) or
+// in storage order (execByDbKey); Unordered hands batches over as soon as
+// any partition produces them. As with QFBAsyncQuery, at most
+// maxPendingBatches() batches wait in the stream: the partitions stop
+// fetching while the consumer is behind. Cancelling or deleting the stream
+// stops the partitions at their next row. Queries run one at a time per
+// executor.
+class QFBParallelQuery : public QObject
+{
+    Q_OBJECT
+public:
+    enum MergeOrder { Unordered, Ordered };
+
+    explicit QFBParallelQuery(const QSqlDatabase &db, QObject *parent = nullptr);
+    virtual ~QFBParallelQuery();
+
+    void setConnections(int count);
+    int connections() const;
+    void setPartitions(int count);
+    int partitions() const;
+    void setBatchSize(int rows);
+    int batchSize() const;
+    void setMaxPendingBatches(int count);
+    int maxPendingBatches() const;
+    void setMergeOrder(MergeOrder order);
+    MergeOrder mergeOrder() const;
+
+    QFBRowStream *execByKey(const QString &query, const QString &keyColumn,
+                            const QVector<QVariant> &boundValues = QVector<QVariant>());
+    QFBRowStream *execByDbKey(const QString &table,
+                              const QString &columns = QLatin1String("*"),
+                              const QString &where = QString());
+
+    bool snapshotShared() const;
+    bool waitForDone(int msecs = -1);
+
+private:
+    QFBRowStream *start(QFBParallelJob *job);
+
+    Q_DISABLE_COPY(QFBParallelQuery)
+    QFBParallelQueryPrivate *d;
+};
+
+QT_END_HEADER
+#endif // QFBPARALLELQUERY_H
@@ -24,8 +24,14 @@
 */
 
 #include <QtDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QtEndian>
 #include <QTextCodec>
 #include <qdatetime.h>
+#include <qtimezone.h>
 #include <qvariant.h>
 #include <qsqlerror.h>
 #include <qsqlfield.h>
@@ -35,8 +41,17 @@
 #include <qlist.h>
 #include <qvector.h>
 
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstring>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
 #include "ibpp.h"
 #include "qsql_ibpp.h"
+#include "qsql_ibpp_p.h"
 
 #include <QtCore/private/qglobal_p.h>
 #include <QtCore/private/qobject_p.h>
@@ -63,6 +78,12 @@
 #define blr_sql_date	(unsigned char)12
 #define blr_sql_time	(unsigned char)13
 #define blr_int64       (unsigned char)16
+#define blr_bool        (unsigned char)23	/* Firebird 3 */
+#define blr_dec64       (unsigned char)24	/* Firebird 4 */
+#define blr_dec128      (unsigned char)25
+#define blr_int128      (unsigned char)26
+#define blr_sql_time_tz (unsigned char)28
+#define blr_timestamp_tz (unsigned char)29
 //-----------------------------------------------------------------------//
 static QVariant::Type qIBaseTypeName(int iType)
 {
@@ -79,7 +100,15 @@ static QVariant::Type qIBaseTypeName(int iType)
     case blr_sql_date:
         return QVariant::Date;
     case blr_timestamp:
+    case blr_timestamp_tz:
+    case blr_sql_time_tz:
         return QVariant::DateTime;
+    case blr_bool:
+        return QVariant::Bool;
+    case blr_int128:
+    case blr_dec64:
+    case blr_dec128:
+        return QVariant::String;
     case blr_blob:
         return QVariant::ByteArray;
     case blr_quad:
@@ -112,11 +141,20 @@ static QVariant::Type qIBPPTypeName(int iType)
     case IBPP::sdDouble:
         return QVariant::Double;
     case IBPP::sdTimestamp:
+    case IBPP::sdTimestampTz:
+    case IBPP::sdTimeTz:
         return QVariant::DateTime;
     case IBPP::sdTime:
         return QVariant::Time;
     case IBPP::sdDate:
         return QVariant::Date;
+    case IBPP::sdBoolean:
+        return QVariant::Bool;
+    case IBPP::sdInt128:
+    case IBPP::sdDecfloat16:
+    case IBPP::sdDecfloat34:
+        // exact decimal text, neither qlonglong nor double can hold them
+        return QVariant::String;
     case IBPP::sdArray:
         return QVariant::List;
     case IBPP::sdBlob:
@@ -126,7 +164,26 @@ static QVariant::Type qIBPPTypeName(int iType)
     }
 }
 //-----------------------------------------------------------------------//
-static std::string toIBPPStr(const QString &s, const QTextCodec *textCodec)
+// Allocations of the thread between start() and addTo(), as QElapsedTimer
+// measures the time; addTo() starts again. Counts nothing unless built with
+// fb_alloc_stats.
+class QFBAllocMeter
+{
+public:
+    void start() { base = qFBAllocations(); }
+    void addTo(QFBAllocCount &count)
+    {
+        const QFBAllocCount now = qFBAllocations();
+        count.allocations += now.allocations - base.allocations;
+        count.bytes += now.bytes - base.bytes;
+        base = now;
+    }
+
+private:
+    QFBAllocCount base;
+};
+//-----------------------------------------------------------------------//
+std::string qFBToIBPPStr(const QString &s, const QTextCodec *textCodec)
 {
     if (!textCodec)
         return s.toStdString();
@@ -143,287 +200,2336 @@ static QString fromIBPPStr(std::string &s, const QTextCodec *textCodec)
     return textCodec->toUnicode(s.data(), s.size()).trimmed();
 }
 //-----------------------------------------------------------------------//
-static IBPP::Timestamp toIBPPTimeStamp(const QDateTime &dt)
+// Dates and times go straight between the IBPP day and ten-thousandths of
+// second counts and QDate's Julian day and QTime's milliseconds, without
+// splitting them in year, month, day... IBPP day 0 is 31 Dec 1899.
+static const qint64 qFBJulianDay0 = 2415020;
+//-----------------------------------------------------------------------//
+static IBPP::Date toIBPPDate(const QDate &t)
 {
-    IBPP::Timestamp ts;
-    if (dt.isValid())
-        ts = IBPP::Timestamp(dt.date().year(), dt.date().month(), dt.date().day(),
-                             dt.time().hour(), dt.time().minute(), dt.time().second(), dt.time().msec());
-    return ts;
+    IBPP::Date id;
+    if (t.isValid())
+        id.SetDate(int(t.toJulianDay() - qFBJulianDay0));
+    return id;
 }
 //-----------------------------------------------------------------------//
-static QDateTime fromIBPPTimeStamp(IBPP::Timestamp &dt)
+static QDate fromIBPPDate(const IBPP::Date &id)
 {
-    return QDateTime(QDate(dt.Year(), dt.Month(), dt.Day()),
-                     QTime(dt.Hours(), dt.Minutes(), dt.Seconds(), dt.SubSeconds()/10));
+    return QDate::fromJulianDay(id.GetDate() + qFBJulianDay0);
 }
 //-----------------------------------------------------------------------//
 static IBPP::Time toIBPPTime(const QTime &t)
 {
     IBPP::Time it;
     if (t.isValid())
-        it.SetTime(t.hour(), t.minute(), t.second(), t.msec());
+        it.SetTime(t.msecsSinceStartOfDay() * 10);
     return it;
 }
 //-----------------------------------------------------------------------//
-static QTime fromIBPPTime(IBPP::Time & it)
+static QTime fromIBPPTime(const IBPP::Time &it)
 {
-    return QTime(it.Hours(), it.Minutes(), it.Seconds(), it.SubSeconds()/10);
+    // QTime holds milliseconds, the 100 microseconds digit is dropped
+    return QTime::fromMSecsSinceStartOfDay(it.GetTime() / 10);
 }
 //-----------------------------------------------------------------------//
-static IBPP::Date toIBPPDate(const QDate &t)
+// TIME_TEXT: "13:45:30.1234" and "2024-05-17T13:45:30.1234", with all the
+// digits of the ten-thousandths of second
+static QString qFBTimeText(const IBPP::Time &it)
 {
-    IBPP::Date id;
-    if (t.isValid())
-        id.SetDate(t.year(), t.month(), t.day());
-    return id;
+    const int ticks = it.GetTime();
+    char text[16];
+    qsnprintf(text, sizeof(text), "%02d:%02d:%02d.%04d", ticks / 36000000,
+              ticks / 600000 % 60, ticks / 10000 % 60, ticks % 10000);
+    return QString::fromLatin1(text);
 }
 //-----------------------------------------------------------------------//
-static QDate fromIBPPDate(IBPP::Date &id)
+static QString qFBTimestampText(const IBPP::Timestamp &ts)
 {
-    return QDate(id.Year(), id.Month(), id.Day());
+    return fromIBPPDate(ts).toString(Qt::ISODate) + QLatin1Char('T') + qFBTimeText(ts);
 }
 //-----------------------------------------------------------------------//
-class QFBDriverPrivate: public QSqlDriverPrivate
+// Reads "HH:mm:ss" with up to four fraction digits, as bound to a TIME or
+// TIMESTAMP parameter
+static bool qFBParseTimeText(const QString &text, IBPP::Time &it)
 {
-    Q_DECLARE_PUBLIC(QFBDriver)
-public:
-    QFBDriverPrivate()
-         : QSqlDriverPrivate(), textCodec(0)
+    const QByteArray t = text.trimmed().toLatin1();
+    int h, m, s, n = 0;
+    if (sscanf(t.constData(), "%2d:%2d:%2d%n", &h, &m, &s, &n) != 3
+            || h > 23 || m > 59 || s > 59 || h < 0 || m < 0 || s < 0)
+        return false;
+    int ticks = 0;
+    int digits = 0;
+    if (n < t.size())
     {
-        iDb.clear();
-        iTr.clear();
-
-        tam = IBPP::amWrite;
-        til = IBPP::ilConcurrency;
-        tlr = IBPP::lrWait;
-        tff = IBPP::TFF(0);
+        if (t.at(n) != '.' && t.at(n) != ',')
+            return false;
+        for (++n; n < t.size() && digits < 4; ++n, ++digits)
+        {
+            if (t.at(n) < '0' || t.at(n) > '9')
+                return false;
+            ticks = ticks * 10 + (t.at(n) - '0');
+        }
+        if (n < t.size() || digits == 0)
+            return false;
+        for (; digits < 4; ++digits)
+            ticks *= 10;
     }
-
-    void setError(const std::string &err, IBPP::Exception &e, QSqlError::ErrorType type);
-    void checkTransactionArguments();
-
-public:
-    IBPP::Database iDb;
-    IBPP::Transaction iTr;
-    QList<IBPP::Transaction> iL;
-
-    IBPP::TAM tam;
-    IBPP::TIL til;
-    IBPP::TLR tlr;
-    IBPP::TFF tff;
-
-    QTextCodec *textCodec;
-};
-
+    it.SetTime(((h * 60 + m) * 60 + s) * 10000 + ticks);
+    return true;
+}
 //-----------------------------------------------------------------------//
-void QFBDriverPrivate::setError(const std::string &err, IBPP::Exception &e, QSqlError::ErrorType type)
+static IBPP::Time toIBPPTime(const QVariant &val)
 {
-//	qWarning(err.data());
-    Q_Q(QFBDriver);
-    q->setLastError(QSqlError(QString::fromLatin1(err.data()),
-                              QString::fromLatin1(e.ErrorMessage()), type));
+    IBPP::Time it;
+    if (val.type() == QVariant::String && qFBParseTimeText(val.toString(), it))
+        return it;
+    return toIBPPTime(val.toTime());
 }
 //-----------------------------------------------------------------------//
-void QFBDriverPrivate::checkTransactionArguments()
+static IBPP::Timestamp toIBPPTimeStamp(const QDateTime &dt)
 {
-    Q_Q(QFBDriver);
-    if (!q->property("Transaction").isValid())
-    {
-        tam = IBPP::amWrite;
-        til = IBPP::ilConcurrency;
-        tlr = IBPP::lrWait;
-        tff = IBPP::TFF(0);
-        return;
-    }
-
-    QString args = q->property("Transaction").toString();
-    const QStringList opts(args.split(QLatin1Char(','), QString::SkipEmptyParts));
-    for (int i = 0; i < opts.count(); ++i)
+    IBPP::Timestamp ts;
+    if (dt.isValid())
     {
-        const QString tmp(opts.at(i));
-        int idx;
-        if ((idx = tmp.indexOf(QLatin1Char('='))) == -1)
-        {
-            qWarning("QFBDriver::checkTransactionArguments: Illegal option value '%s'",
-                     tmp.toLocal8Bit().constData());
-            continue;
-        }
-
-        const QString opt(tmp.left(idx).simplified());
-        const QString val(tmp.mid(idx + 1).simplified());
-
-        if (opt == QLatin1String("TAM"))
-        {
-            if (val == QLatin1String("amWrite"))
-                tam = IBPP::amWrite;
-            else
-                if (val == QLatin1String("amRead"))
-                    tam = IBPP::amRead;
-                else
-                    qWarning("QFBDriver::checkTransactionArguments: Unknown IBPP::TAM value '%s'",
-                             tmp.toLocal8Bit().constData());
-            continue;
-        }
-        else
-            if (opt == QLatin1String("TIL"))
-            {
-                if (val == QLatin1String("ilConcurrency"))
-                    til = IBPP::ilConcurrency;
-                else
-                    if (val == QLatin1String("ilReadDirty"))
-                        til = IBPP::ilReadDirty;
-                    else
-                        if (val == QLatin1String("ilReadCommitted"))
-                            til = IBPP::ilReadCommitted;
-                        else
-                            if (val == QLatin1String("ilConsistency"))
-                                til = IBPP::ilConsistency;
-                            else
-                                qWarning("QFBDriver::checkTransactionArguments: Unknown IBPP::TIL value '%s'",
-                                         tmp.toLocal8Bit().constData());
-                continue;
-            }
-            else
-                if (opt == QLatin1String("TLR"))
-                {
-                    if (val == QLatin1String("lrWait"))
-                        tlr = IBPP::lrWait;
-                    else
-                        if (val == QLatin1String("lrNoWait"))
-                            tlr = IBPP::lrNoWait;
-                        else
-                            qWarning("QFBDriver::checkTransactionArguments: Unknown IBPP::TLR value '%s'",
-                                     tmp.toLocal8Bit().constData());
-                    continue;
-                }
-                else
-                    if (opt == QLatin1String("TFF"))
-                    {
-                        if (val == QLatin1String("0"))
-                            tff = IBPP::TFF(0);
-                        else
-                            if (val == QLatin1String("tfIgnoreLimbo"))
-                                tff = IBPP::tfIgnoreLimbo;
-                            else
-                                if (val == QLatin1String("tfAutoCommit"))
-                                    tff = IBPP::tfAutoCommit;
-                                else
-                                    if (val == QLatin1String("tfNoAutoUndo"))
-                                        tff = IBPP::tfNoAutoUndo;
-                                    else
-                                        qWarning("QFBDriver::checkTransactionArguments: Unknown IBPP::TLR value '%s'",
-                                                 tmp.toLocal8Bit().constData());
-                        continue;
-                    }
-                    else
-                        qWarning("QFBDriver::checkTransactionArguments: Unknown transaction attribute '%s'",
-                                 tmp.toLocal8Bit().constData());
+        ts.SetDate(int(dt.date().toJulianDay() - qFBJulianDay0));
+        ts.SetTime(dt.time().msecsSinceStartOfDay() * 10);
     }
-//    qWarning("IBPP::Transaction arguments(TAM=%d, TIL=%d, TLR=%d, TFF=%d)", tam, til, tlr, tff);
-    q->setProperty("Transaction",QVariant());
-
+    return ts;
 }
 //-----------------------------------------------------------------------//
-class QFBResultPrivate: public QSqlCachedResultPrivate
+static QDateTime fromIBPPTimeStamp(const IBPP::Timestamp &ts)
 {
-    Q_DECLARE_PUBLIC(QFBResult)
-
-public:
-    Q_DECLARE_SQLDRIVER_PRIVATE(QFBDriver)
-
-    QFBResultPrivate(QFBResult *rr, const QFBDriver *dd, QTextCodec *tc);
-    ~QFBResultPrivate() { cleanup(); }
-
-    void cleanup();
-
-    bool transaction();
-    bool commit();
-
-    bool isSelect();
-
-    void setError(const std::string &err,
-                  IBPP::Exception &e,
-                  QSqlError::ErrorType type = QSqlError::UnknownError);
-
-public:
-
-    bool localTransaction;
-
-    int queryType;
-
-    IBPP::Database iDb;
-    IBPP::Transaction iTr;
-    IBPP::Statement iSt;
-
-    QTextCodec *textCodec;
-};
-
+    return QDateTime(fromIBPPDate(ts), fromIBPPTime(ts));
+}
 //-----------------------------------------------------------------------//
-QFBResultPrivate::QFBResultPrivate(QFBResult *rr, const QFBDriver *dd, QTextCodec *tc)
-        : QSqlCachedResultPrivate(rr, dd), queryType(-1), textCodec(tc)
+// ISO 8601 text keeps its four fraction digits, other values go through
+// QDateTime
+static IBPP::Timestamp toIBPPTimeStamp(const QVariant &val)
 {
-    localTransaction = true;
-    iDb = drv_d_func()->iDb;
-
-    try
-    {
-        iTr = IBPP::TransactionFactory(iDb);
-        iSt = IBPP::StatementFactory(iDb,iTr);
-    }
-    catch (IBPP::Exception& e)
+    if (val.type() == QVariant::String)
     {
-        setError("Unable create local transaction and statement", e, QSqlError::StatementError);
+        const QString text = val.toString().trimmed();
+        int sep = text.indexOf(QLatin1Char('T'));
+        if (sep < 0)
+            sep = text.indexOf(QLatin1Char(' '));
+        IBPP::Time it;
+        const QDate date = QDate::fromString(text.left(sep), Qt::ISODate);
+        if (sep > 0 && date.isValid() && qFBParseTimeText(text.mid(sep + 1), it))
+        {
+            IBPP::Timestamp ts;
+            ts.SetDate(int(date.toJulianDay() - qFBJulianDay0));
+            ts.SetTime(it.GetTime());
+            return ts;
+        }
     }
+    return toIBPPTimeStamp(val.toDateTime());
 }
-
 //-----------------------------------------------------------------------//
-void QFBResultPrivate::cleanup()
+static IBPP::TimestampTz toIBPPTimeStampTz(const QDateTime &dt)
 {
-    Q_Q(QFBResult);
-    commit();
-
-    //if (!localTransaction)
-    //iTr = 0;
-
-    try
-    {
-        iSt->Close();
-    }
-    catch (IBPP::Exception& e)
-    {
-        setError("Unable close statement", e, QSqlError::StatementError);
-    }
-
-    queryType = -1;
-
-    q->cleanup();
+    IBPP::TimestampTz ts;
+    if (dt.isValid())
+        ts = IBPP::TimestampTz(toIBPPTimeStamp(dt.toUTC()), dt.offsetFromUtc() / 60);
+    return ts;
 }
 //-----------------------------------------------------------------------//
-void QFBResultPrivate::setError(const std::string &err, IBPP::Exception &e, QSqlError::ErrorType type)
+// The region of a WITH TIME ZONE value, invalid for an offset. IBPP names
+// the regions with a Firebird 4 client library (GMT only otherwise), the
+// offset the server sends for them (EXTENDED binding, asked on attach) is
+// used when Qt doesn't know the name.
+static QTimeZone qFBRegion(const IBPP::TimeZone &zone)
 {
-//	qWarning(err.data());
-    Q_Q(QFBResult);
-    qWarning(e.ErrorMessage());
-    q->setLastError(QSqlError(QString::fromLatin1(err.data()),
-                              QString::fromLatin1(e.ErrorMessage()), type));
+    const std::string &name = zone.Zone();
+    if (name.empty() || name[0] == '+' || name[0] == '-')
+        return QTimeZone();
+    return QTimeZone(QByteArray(name.c_str()));
 }
 //-----------------------------------------------------------------------//
-bool QFBResultPrivate::isSelect()
+static QDateTime fromIBPPTimeStampTz(const IBPP::TimestampTz &ts)
 {
-    bool iss = false;
-    try
+    const QDateTime utc(fromIBPPDate(ts), fromIBPPTime(ts), Qt::UTC);
+    const QTimeZone tz = qFBRegion(ts);
+    if (tz.isValid())
+        return utc.toTimeZone(tz);
+    if (ts.OffsetKnown())
+        return utc.toOffsetFromUtc(ts.Offset() * 60);
+    return utc;
+}
+//-----------------------------------------------------------------------//
+// A TIME WITH TIME ZONE is the time at its zone on 2020-01-01, the date at
+// which the server takes the offset of a region
+static QDateTime fromIBPPTimeTz(const IBPP::TimeTz &tm)
+{
+    const QDate date(2020, 1, 1);
+    const QTimeZone tz = qFBRegion(tm);
+    if (!tm.OffsetKnown())
     {
-        iss = (iSt->Type() == IBPP::stSelect);
+        const QDateTime utc(date, fromIBPPTime(tm), Qt::UTC);
+        return tz.isValid() ? utc.toTimeZone(tz) : utc;
     }
-    catch (IBPP::Exception& e)
+    const QTime local = fromIBPPTime(tm.Local());
+    if (tz.isValid())
+        return QDateTime(date, local, tz);
+    return QDateTime(date, local, Qt::OffsetFromUTC, tm.Offset() * 60);
+}
+//-----------------------------------------------------------------------//
+static IBPP::TimeTz toIBPPTimeTz(const QVariant &val)
+{
+    // The offset is the one of the value at its own date, so that a summer
+    // QDateTime keeps its summer offset. A QTime has no date nor zone: it is
+    // taken as a local time of the current date.
+    QDateTime dt;
+    if (val.type() == QVariant::DateTime)
+        dt = val.toDateTime();
+    else
+        dt = QDateTime(QDate::currentDate(), val.toTime());
+
+    IBPP::TimeTz it;
+    if (dt.isValid())
     {
-        setError("Unable get type of statement", e, QSqlError::StatementError);
+        const int offset = dt.offsetFromUtc();
+        it = IBPP::TimeTz(toIBPPTime(dt.time().addSecs(-offset)), offset / 60);
     }
-    return iss;
+    return it;
 }
 //-----------------------------------------------------------------------//
-bool QFBResultPrivate::transaction()
+bool qFBParseConnectOptions(const QString &connOpts, QFBConnectOptions &options)
+{
+    bool ok = true;
+    const QStringList opts(connOpts.split(QLatin1Char(';'), QString::SkipEmptyParts));
+    for (int i = 0; i < opts.count(); ++i)
+    {
+        const QString tmp(opts.at(i));
+        int idx;
+        if ((idx = tmp.indexOf(QLatin1Char('='))) == -1)
+        {
+            qWarning("QFBDriver::open: Illegal connect option value '%s'",
+                     tmp.toLocal8Bit().constData());
+            ok = false;
+            continue;
+        }
+
+        const QString opt(tmp.left(idx));
+        const QString val(tmp.mid(idx + 1).simplified());
+
+        if (opt == QLatin1String("CHARSET"))
+        {
+            options.charSet = val.toUpper();
+        }
+        else if (opt == QLatin1String("ROLE"))
+        {
+            options.role = val;
+        }
+        else if (opt == QLatin1String("SCROLLABLE_CURSORS"))
+        {
+            options.scrollableCursors = (val == QLatin1String("1")
+                                         || val.compare(QLatin1String("TRUE"), Qt::CaseInsensitive) == 0);
+        }
+        else if (opt == QLatin1String("ARRAY_VECTORS"))
+        {
+            options.typedArrays = (val == QLatin1String("1")
+                                   || val.compare(QLatin1String("TRUE"), Qt::CaseInsensitive) == 0);
+        }
+        else if (opt == QLatin1String("TIME_TEXT"))
+        {
+            options.timeText = (val == QLatin1String("1")
+                                || val.compare(QLatin1String("TRUE"), Qt::CaseInsensitive) == 0);
+        }
+        else if (opt == QLatin1String("SLOW_QUERY_MS"))
+        {
+            bool isInt;
+            options.slowQueryMs = val.toInt(&isInt);
+            if (!isInt || options.slowQueryMs < 0)
+            {
+                qWarning("QFBDriver::open: Illegal SLOW_QUERY_MS value '%s'",
+                         val.toLocal8Bit().constData());
+                options.slowQueryMs = -1;
+                ok = false;
+            }
+        }
+        else if (opt == QLatin1String("SLOW_QUERY_LOG"))
+        {
+            options.slowQueryLog = val;
+        }
+        else
+        {
+            qWarning("QFBDriver::open: Unknown connection attribute '%s'",
+                     tmp.toLocal8Bit().constData());
+            ok = false;
+        }
+    }
+    return ok;
+}
+//-----------------------------------------------------------------------//
+QTextCodec *qFBCodecForCharSet(const QString &charSet)
+{
+    QByteArray codecName;
+    if (charSet == QLatin1String("ASCII"))
+        codecName = "ISO 8859-1";
+    else if (charSet == QLatin1String("BIG_5"))
+        codecName = "Big5";
+    else if (charSet == QLatin1String("CYRL"))
+        codecName = "IBM 866";
+    else if (charSet == QLatin1String("DOS850"))
+        codecName = "IBM 850";
+    else if (charSet == QLatin1String("DOS866"))
+        codecName = "IBM 866";
+    else if (charSet == QLatin1String("KOI8-R"))
+        codecName = "KOI8-R";
+    else if (charSet == QLatin1String("KOI8-U"))
+        codecName = "KOI8-U";
+    else if (charSet == QLatin1String("EUCJ_0208"))
+        codecName = "JIS X 0208";
+    else if (charSet == QLatin1String("GB_2312"))
+        codecName = "GB18030-0";
+
+    else if (charSet == QLatin1String("ISO8859_1"))
+        codecName = "ISO 8859-1";
+    else if (charSet == QLatin1String("ISO8859_2"))
+        codecName = "ISO 8859-2";
+    else if (charSet == QLatin1String("ISO8859_3"))
+        codecName = "ISO 8859-3";
+    else if (charSet == QLatin1String("ISO8859_4"))
+        codecName = "ISO 8859-4";
+    else if (charSet == QLatin1String("ISO8859_5"))
+        codecName = "ISO 8859-5";
+    else if (charSet == QLatin1String("ISO8859_6"))
+        codecName = "ISO 8859-6";
+    else if (charSet == QLatin1String("ISO8859_7"))
+        codecName = "ISO 8859-7";
+    else if (charSet == QLatin1String("ISO8859_8"))
+        codecName = "ISO 8859-8";
+    else if (charSet == QLatin1String("ISO8859_9"))
+        codecName = "ISO 8859-9";
+    else if (charSet == QLatin1String("ISO8859_13"))
+        codecName = "ISO 8859-13";
+
+    else if (charSet == QLatin1String("KSC_5601"))
+        codecName = "Big5-HKSCS";
+    else if (charSet == QLatin1String("SJIS_0208"))
+        codecName = "JIS X 0208";
+    else if (charSet == QLatin1String("UNICODE_FSS"))
+        codecName = "UTF-8";
+    else if (charSet == QLatin1String("UTF8"))
+        codecName = "UTF-8";
+
+    else if (charSet == QLatin1String("WIN1250"))
+        codecName = "Windows-1250";
+    else if (charSet == QLatin1String("WIN1251"))
+        codecName = "Windows-1251";
+    else if (charSet == QLatin1String("WIN1252"))
+        codecName = "Windows-1252";
+    else if (charSet == QLatin1String("WIN1253"))
+        codecName = "Windows-1253";
+    else if (charSet == QLatin1String("WIN1254"))
+        codecName = "Windows-1254";
+    else if (charSet == QLatin1String("WIN1255"))
+        codecName = "Windows-1255";
+    else if (charSet == QLatin1String("WIN1256"))
+        codecName = "Windows-1256";
+    else if (charSet == QLatin1String("WIN1257"))
+        codecName = "Windows-1257";
+    else if (charSet == QLatin1String("WIN1258"))
+        codecName = "Windows-1258";
+    else if (charSet == QLatin1String("WIN1258"))
+        codecName = "Windows-1258";
+
+    QTextCodec *textCodec;
+    if (codecName.isEmpty())
+        textCodec = QTextCodec::codecForName(charSet.toLatin1()); //try codec with charSet
+    else
+        textCodec = QTextCodec::codecForName(codecName);
+
+    if (!textCodec)
+        textCodec = QTextCodec::codecForLocale(); //if unknown set locale
+    return textCodec;
+}
+//-----------------------------------------------------------------------//
+QFBConnectionParams::QFBConnectionParams(const QSqlDatabase &db)
+    : host(db.hostName()), dbName(db.databaseName()), user(db.userName()),
+      password(db.password()), connOpts(db.connectOptions())
+{
+}
+//-----------------------------------------------------------------------//
+bool qFBAttach(const QFBConnectionParams &params, IBPP::Database &db,
+               QTextCodec *&textCodec, QSqlError &error)
+{
+    // An attachment lost by the helper is still counted: it is released
+    // before being replaced
+    qFBDetach(db);
+
+    QFBConnectOptions options;
+    qFBParseConnectOptions(params.connOpts, options);
+    textCodec = qFBCodecForCharSet(options.charSet);
+
+    try
+    {
+        db = IBPP::DatabaseFactory(params.host.toStdString(),
+                                   params.dbName.toStdString(),
+                                   params.user.toStdString(),
+                                   params.password.toStdString(),
+                                   options.role.toStdString(),
+                                   options.charSet.toStdString(),
+                                   "");
+        db->Connect();
+    }
+    catch (IBPP::Exception& e)
+    {
+        db.clear();
+        error = QSqlError(QLatin1String("Unable to connect"),
+                          QString::fromLatin1(e.ErrorMessage()), QSqlError::ConnectionError);
+        IBPP::SQLException *se = dynamic_cast<IBPP::SQLException *>(&e);
+        qFBMetricsError(se ? se->SqlCode() : 0);
+        return false;
+    }
+    qFBMetricsAttachments(1, true);
+    return true;
+}
+//-----------------------------------------------------------------------//
+void qFBDetach(IBPP::Database &db)
+{
+    if (db == 0)
+        return;
+
+    try
+    {
+        db->Disconnect();
+    }
+    catch (IBPP::Exception& e)
+    {
+        qWarning("QFBDriver: Unable to disconnect: %s", e.ErrorMessage());
+    }
+    db.clear();
+    qFBMetricsAttachments(-1, true);
+}
+//-----------------------------------------------------------------------//
+static QString qFBStatusText(IBPP::RSC rc)
+{
+    switch (rc)
+    {
+    case IBPP::rcWrongType:
+        return QLatin1String("incompatible types");
+    case IBPP::rcOutOfRange:
+        return QLatin1String("out of range numeric conversion");
+    case IBPP::rcBadIndex:
+        return QLatin1String("index out of range");
+    case IBPP::rcNotReady:
+        return QLatin1String("statement not ready");
+    default:
+        return QString::number(rc);
+    }
+}
+//-----------------------------------------------------------------------//
+// Array columns are read and written with a single slice through a flat
+// buffer of the element type. A multi dimensional array is a QVariantList
+// per dimension, the last dimension varying fastest.
+static inline QVariant qFBArrayElem(qint32 v) { return QVariant(int(v)); }
+static inline QVariant qFBArrayElem(qint64 v) { return QVariant(qlonglong(v)); }
+static inline QVariant qFBArrayElem(float v) { return QVariant(v); }
+static inline QVariant qFBArrayElem(double v) { return QVariant(v); }
+static inline QVariant qFBArrayElem(const QString &v) { return QVariant(v); }
+static inline QVariant qFBArrayElem(const IBPP::Timestamp &v) { return fromIBPPTimeStamp(v); }
+static inline QVariant qFBArrayElem(const IBPP::Date &v) { return fromIBPPDate(v); }
+static inline QVariant qFBArrayElem(const IBPP::Time &v) { return fromIBPPTime(v); }
+//-----------------------------------------------------------------------//
+template<class T>
+static QVariantList qFBArrayToList(const T *&elem, const int *counts, int dims)
+{
+    QVariantList list;
+    list.reserve(counts[0]);
+    for (int i = 0; i < counts[0]; ++i)
+    {
+        if (dims > 1)
+            list.append(QVariant(qFBArrayToList(elem, counts + 1, dims - 1)));
+        else
+            list.append(qFBArrayElem(*elem++));
+    }
+    return list;
+}
+//-----------------------------------------------------------------------//
+template<class T>
+static QVariant qFBArrayValue(IBPP::Array &ar, IBPP::ADT adt, const QVector<int> &counts,
+                              int total, bool typedArrays)
+{
+    QVector<T> v(total);
+    ar->ReadTo(adt, v.data(), total);
+    if (typedArrays && counts.size() == 1)
+        return QVariant::fromValue(v);
+    const T *elem = v.constData();
+    return qFBArrayToList(elem, counts.constData(), counts.size());
+}
+//-----------------------------------------------------------------------//
+template<class T>
+static QVariant qFBArrayValue(IBPP::Array &ar, IBPP::ADT adt, const QVector<int> &counts, int total)
+{
+    std::vector<T> v(total);
+    ar->ReadTo(adt, &v[0], total);
+    const T *elem = &v[0];
+    return qFBArrayToList(elem, counts.constData(), counts.size());
+}
+//-----------------------------------------------------------------------//
+static QVariant qFBReadArray(IBPP::Database &db, IBPP::Transaction &tr, IBPP::Statement &st,
+                             int col, bool typedArrays, const QTextCodec *textCodec,
+                             QFBArrayCache *arrays)
+{
+    // The array of the column is described once per execution, Describe()
+    // asks the server once per transaction and column
+    IBPP::Array local;
+    if (arrays && arrays->size() < col)
+        arrays->resize(st->Columns());
+    IBPP::Array &ar = arrays ? (*arrays)[col - 1] : local;
+    if (ar.intf() == 0)
+    {
+        ar = IBPP::ArrayFactory(db, tr);
+        ar->Describe(st->ColumnTable(col), st->ColumnName(col));
+    }
+    st->Get(col, ar);
+
+    QVector<int> counts(ar->Dimensions());
+    int total = 1;
+    for (int d = 0; d < counts.size(); ++d)
+    {
+        int low, high;
+        ar->Bounds(d, &low, &high);
+        counts[d] = high - low + 1;
+        total *= counts[d];
+    }
+
+    const bool scaled = ar->ElementScale() != 0;
+    switch (ar->ElementType())
+    {
+    case IBPP::sdSmallint:
+    case IBPP::sdInteger:
+        if (scaled)
+            return qFBArrayValue<double>(ar, IBPP::adDouble, counts, total, typedArrays);
+        return qFBArrayValue<qint32>(ar, IBPP::adInt32, counts, total, typedArrays);
+    case IBPP::sdLargeint:
+        if (scaled)
+            return qFBArrayValue<double>(ar, IBPP::adDouble, counts, total, typedArrays);
+        return qFBArrayValue<qint64>(ar, IBPP::adInt64, counts, total, typedArrays);
+    case IBPP::sdFloat:
+        return qFBArrayValue<float>(ar, IBPP::adFloat, counts, total, typedArrays);
+    case IBPP::sdDouble:
+        return qFBArrayValue<double>(ar, IBPP::adDouble, counts, total, typedArrays);
+    case IBPP::sdTimestamp:
+        return qFBArrayValue<IBPP::Timestamp>(ar, IBPP::adTimestamp, counts, total);
+    case IBPP::sdDate:
+        return qFBArrayValue<IBPP::Date>(ar, IBPP::adDate, counts, total);
+    case IBPP::sdTime:
+        return qFBArrayValue<IBPP::Time>(ar, IBPP::adTime, counts, total);
+    case IBPP::sdString:
+        {
+            // Elements of ElementSize() characters, each one '\0' terminated
+            const int stride = ar->ElementSize() + 1;
+            QByteArray buf(total * stride, '\0');
+            ar->ReadTo(IBPP::adString, buf.data(), total);
+            QVector<QString> strs(total);
+            for (int i = 0; i < total; ++i)
+            {
+                std::string s(buf.constData() + i * stride);
+                strs[i] = fromIBPPStr(s, textCodec);
+            }
+            const QString *elem = strs.constData();
+            return qFBArrayToList(elem, counts.constData(), counts.size());
+        }
+    default:
+        qWarning("QFBResult::gotoNext: Unknown array element type %d", ar->ElementType());
+        return QVariant();
+    }
+}
+//-----------------------------------------------------------------------//
+static void qFBFlattenList(const QVariantList &list, QVariantList &flat)
+{
+    for (int i = 0; i < list.size(); ++i)
+    {
+        if (list.at(i).type() == QVariant::List)
+            qFBFlattenList(list.at(i).toList(), flat);
+        else
+            flat.append(list.at(i));
+    }
+}
+//-----------------------------------------------------------------------//
+// Elements of a typed vector, or of a flattened QVariantList, as T
+template<class T, class V>
+static bool qFBVectorElems(const QVariant &val, QVector<T> &out)
+{
+    if (val.userType() != qMetaTypeId<QVector<V> >())
+        return false;
+    const QVector<V> v = val.value<QVector<V> >();
+    out.resize(v.size());
+    for (int i = 0; i < v.size(); ++i)
+        out[i] = T(v.at(i));
+    return true;
+}
+//-----------------------------------------------------------------------//
+template<class T>
+static void qFBArrayElems(const QVariant &val, QVector<T> &out)
+{
+    if (qFBVectorElems<T, double>(val, out) || qFBVectorElems<T, float>(val, out)
+            || qFBVectorElems<T, qint32>(val, out) || qFBVectorElems<T, qint64>(val, out))
+        return;
+
+    QVariantList flat;
+    qFBFlattenList(val.toList(), flat);
+    out.resize(flat.size());
+    for (int i = 0; i < flat.size(); ++i)
+        out[i] = qvariant_cast<T>(flat.at(i));
+}
+//-----------------------------------------------------------------------//
+// Writes the buffer to a new array; a one dimension array may be given
+// less elements than its bounds, the slice is narrowed to them.
+static IBPP::RSC qFBPutArray(IBPP::Array &ar, IBPP::ADT adt, const void *data, int count, int total)
+{
+    if (count != total)
+    {
+        int low, high;
+        ar->Bounds(0, &low, &high);
+        if (ar->Dimensions() != 1 || count == 0 || count > total)
+            return IBPP::rcOutOfRange;
+        ar->SetBounds(0, low, low + count - 1);
+    }
+    ar->WriteFrom(adt, data, count);
+    return IBPP::rcOk;
+}
+//-----------------------------------------------------------------------//
+template<class T>
+static IBPP::RSC qFBWriteArrayOf(IBPP::Array &ar, IBPP::ADT adt, const QVariant &val, int total)
+{
+    QVector<T> v;
+    qFBArrayElems(val, v);
+    return qFBPutArray(ar, adt, v.constData(), v.size(), total);
+}
+//-----------------------------------------------------------------------//
+static IBPP::RSC qFBWriteArray(IBPP::Statement &st, int param, const QVariant &val,
+                               const QTextCodec *textCodec)
+{
+    const char *table = st->ParameterTable(param);
+    if (!table || !*table)
+    {
+        // The server names the column of INSERT values and UPDATE assignments only
+        qWarning("QFBResult::exec: Array parameter %d is not assigned to a column", param);
+        return IBPP::rcWrongType;
+    }
+
+    IBPP::Array ar = IBPP::ArrayFactory(st->DatabasePtr(), st->TransactionPtr());
+    ar->Describe(table, st->ParameterName(param));
+
+    int total = 1;
+    for (int d = 0; d < ar->Dimensions(); ++d)
+    {
+        int low, high;
+        ar->Bounds(d, &low, &high);
+        total *= high - low + 1;
+    }
+
+    const bool scaled = ar->ElementScale() != 0;
+    IBPP::RSC rc;
+    switch (ar->ElementType())
+    {
+    case IBPP::sdSmallint:
+    case IBPP::sdInteger:
+        rc = scaled ? qFBWriteArrayOf<double>(ar, IBPP::adDouble, val, total)
+                    : qFBWriteArrayOf<qint32>(ar, IBPP::adInt32, val, total);
+        break;
+    case IBPP::sdLargeint:
+        rc = scaled ? qFBWriteArrayOf<double>(ar, IBPP::adDouble, val, total)
+                    : qFBWriteArrayOf<qint64>(ar, IBPP::adInt64, val, total);
+        break;
+    case IBPP::sdFloat:
+        rc = qFBWriteArrayOf<float>(ar, IBPP::adFloat, val, total);
+        break;
+    case IBPP::sdDouble:
+        rc = qFBWriteArrayOf<double>(ar, IBPP::adDouble, val, total);
+        break;
+    case IBPP::sdTimestamp:
+    case IBPP::sdDate:
+    case IBPP::sdTime:
+        {
+            QVariantList flat;
+            qFBFlattenList(val.toList(), flat);
+            const int n = flat.size();
+            if (ar->ElementType() == IBPP::sdTimestamp)
+            {
+                std::vector<IBPP::Timestamp> v(n);
+                for (int i = 0; i < n; ++i)
+                    v[i] = toIBPPTimeStamp(flat.at(i).toDateTime());
+                rc = qFBPutArray(ar, IBPP::adTimestamp, n ? &v[0] : 0, n, total);
+            }
+            else if (ar->ElementType() == IBPP::sdDate)
+            {
+                std::vector<IBPP::Date> v(n);
+                for (int i = 0; i < n; ++i)
+                    v[i] = toIBPPDate(flat.at(i).toDate());
+                rc = qFBPutArray(ar, IBPP::adDate, n ? &v[0] : 0, n, total);
+            }
+            else
+            {
+                std::vector<IBPP::Time> v(n);
+                for (int i = 0; i < n; ++i)
+                    v[i] = toIBPPTime(flat.at(i).toTime());
+                rc = qFBPutArray(ar, IBPP::adTime, n ? &v[0] : 0, n, total);
+            }
+            break;
+        }
+    case IBPP::sdString:
+        {
+            QVariantList flat;
+            qFBFlattenList(val.toList(), flat);
+            const int size = ar->ElementSize();
+            const int stride = size + 1;
+            QByteArray buf(flat.size() * stride, '\0');
+            for (int i = 0; i < flat.size(); ++i)
+            {
+                const std::string s = qFBToIBPPStr(flat.at(i).toString(), textCodec);
+                memcpy(buf.data() + i * stride, s.data(), qMin(int(s.size()), size));
+            }
+            rc = qFBPutArray(ar, IBPP::adString, buf.constData(), flat.size(), total);
+            break;
+        }
+    default:
+        return IBPP::rcWrongType;
+    }
+
+    if (rc == IBPP::rcOk)
+        st->Set(param, ar);
+    return rc;
+}
+//-----------------------------------------------------------------------//
+// A NUMERIC(x,y) of 18 digits or less: the strings are read exactly at the
+// scale of the parameter by IBPP, the other values go through a double
+static IBPP::RSC qFBSetScaled(IBPP::Statement &st, int i, const QVariant &val)
+{
+    if (val.type() == QVariant::String)
+        return st->TrySet(i, val.toString().trimmed().toStdString());
+    return st->TrySet(i, val.toDouble());
+}
+//-----------------------------------------------------------------------//
+bool qFBBindValues(IBPP::Statement &st, const QVector<QVariant> &values,
+                   const QTextCodec *textCodec, QSqlError &error)
+{
+    const int paramCount = st->Parameters();
+    if (values.count() > paramCount)
+    {
+        qWarning("QFBResult::exec: Parameter mismatch, expected %d, got %d parameters",
+                 paramCount, values.count());
+        error = QSqlError(QLatin1String("Unable to bind value"),
+                          QString::fromLatin1("Parameter mismatch, expected %1, got %2 parameters")
+                          .arg(paramCount).arg(values.count()), QSqlError::StatementError);
+        return false;
+    }
+
+    int i;
+    for (i = 1; i <= values.count(); ++i)
+    {
+        const IBPP::SDT type = st->ParameterType(i);
+        if (!type)
+            continue;
+
+        const QVariant val(values[i-1]);
+        IBPP::RSC rc = IBPP::rcOk;
+
+        if (val.isNull())
+            rc = st->TrySetNull(i);
+        else
+        {
+            switch (type)
+            {
+            case IBPP::sdLargeint:
+                if (st->ParameterScale(i))
+                    rc = qFBSetScaled(st, i, val);
+                else
+                    rc = st->TrySet(i, static_cast<int64_t>(val.toLongLong()));
+                break;
+            case IBPP::sdInteger:
+                if (st->ParameterScale(i))
+                    rc = qFBSetScaled(st, i, val);
+                else
+                    rc = st->TrySet(i, static_cast<int32_t>(val.toInt()));
+                break;
+            case IBPP::sdSmallint:
+                if (st->ParameterScale(i))
+                    rc = qFBSetScaled(st, i, val);
+                else
+                    rc = st->TrySet(i, static_cast<int16_t>(val.toInt()));
+                break;
+            case IBPP::sdFloat:
+                rc = st->TrySet(i, (float)val.toDouble());
+                break;
+            case IBPP::sdDouble:
+                rc = st->TrySet(i, val.toDouble());
+                break;
+            case IBPP::sdTimestamp:
+                rc = st->TrySet(i, toIBPPTimeStamp(val));
+                break;
+            case IBPP::sdTime:
+                rc = st->TrySet(i, toIBPPTime(val));
+                break;
+            case IBPP::sdDate:
+                rc = st->TrySet(i, toIBPPDate(val.toDate()));
+                break;
+            case IBPP::sdTimestampTz:
+                rc = st->TrySet(i, toIBPPTimeStampTz(val.toDateTime()));
+                break;
+            case IBPP::sdTimeTz:
+                rc = st->TrySet(i, toIBPPTimeTz(val));
+                break;
+            case IBPP::sdBoolean:
+                rc = st->TrySet(i, val.toBool());
+                break;
+            case IBPP::sdInt128:
+            case IBPP::sdDecfloat16:
+            case IBPP::sdDecfloat34:
+                if (val.type() == QVariant::Double)
+                    rc = st->TrySet(i, val.toDouble());
+                else
+                    rc = st->TrySet(i, val.toString().toStdString());
+                break;
+            case IBPP::sdString:
+                rc = st->TrySet(i, qFBToIBPPStr(val.toString(), textCodec));
+                break;
+            case IBPP::sdBlob:
+                {
+                    const QByteArray ba = val.toByteArray();
+                    rc = st->TrySet(i, std::string(ba.constData(), ba.size()));
+                    break;
+                }
+            case IBPP::sdArray:
+                rc = qFBWriteArray(st, i, val, textCodec);
+                break;
+            default:
+                qWarning("QFBResult::exec: Unknown datatype %d", type);
+                rc = IBPP::rcWrongType;
+                break;
+            }
+        }
+
+        if (rc != IBPP::rcOk)
+        {
+            error = QSqlError(QLatin1String("Unable to bind value"),
+                              QString::fromLatin1("Parameter %1: %2").arg(i).arg(qFBStatusText(rc)),
+                              QSqlError::StatementError);
+            return false;
+        }
+    }
+    return true;
+}
+//-----------------------------------------------------------------------//
+void qFBFetchRow(IBPP::Database &db, IBPP::Transaction &tr, IBPP::Statement &st,
+                 QVariant *values, const QTextCodec *textCodec, int options,
+                 QFBStatementStats *stats, QFBArrayCache *arrays)
+{
+    const bool typedArrays = options & QFBTypedArrays;
+    const bool timeText = options & QFBTimeText;
+    const int cols = st->Columns();
+    for (int i = 1; i <= cols; ++i)
+    {
+        const int idx = i - 1;
+        const IBPP::SDT type = st->ColumnType(i);
+        IBPP::RSC rc = IBPP::rcOk;
+
+        switch (type)
+        {
+        case IBPP::sdDate:
+            {
+                IBPP::Date dt;
+                if ((rc = st->TryGet(i, dt)) == IBPP::rcOk)
+                    values[idx] = fromIBPPDate(dt);
+                break;
+            }
+        case IBPP::sdTime:
+            {
+                IBPP::Time tm;
+                if ((rc = st->TryGet(i, tm)) == IBPP::rcOk)
+                {
+                    if (timeText)
+                        values[idx] = qFBTimeText(tm);
+                    else
+                        values[idx] = fromIBPPTime(tm);
+                }
+                break;
+            }
+        case IBPP::sdTimestamp:
+            {
+                IBPP::Timestamp ts;
+                if ((rc = st->TryGet(i, ts)) == IBPP::rcOk)
+                {
+                    if (timeText)
+                        values[idx] = qFBTimestampText(ts);
+                    else
+                        values[idx] = fromIBPPTimeStamp(ts);
+                }
+                break;
+            }
+        case IBPP::sdTimestampTz:
+            {
+                IBPP::TimestampTz ts;
+                if ((rc = st->TryGet(i, ts)) == IBPP::rcOk)
+                    values[idx] = fromIBPPTimeStampTz(ts);
+                break;
+            }
+        case IBPP::sdTimeTz:
+            {
+                IBPP::TimeTz tz;
+                if ((rc = st->TryGet(i, tz)) == IBPP::rcOk)
+                    values[idx] = fromIBPPTimeTz(tz);
+                break;
+            }
+        case IBPP::sdBoolean:
+            {
+                bool l_Bool;
+                if ((rc = st->TryGet(i, l_Bool)) == IBPP::rcOk)
+                    values[idx] = l_Bool;
+                break;
+            }
+        case IBPP::sdInt128:
+        case IBPP::sdDecfloat16:
+        case IBPP::sdDecfloat34:
+            {
+                std::string l_Decimal;
+                if ((rc = st->TryGet(i, l_Decimal)) == IBPP::rcOk)
+                    values[idx] = QString::fromLatin1(l_Decimal.c_str());
+                break;
+            }
+        case IBPP::sdSmallint:
+            {
+                if (st->ColumnScale(i))
+                {
+                    double l_Double;
+                    if ((rc = st->TryGet(i, l_Double)) == IBPP::rcOk)
+                        values[idx] = l_Double;
+                }
+                else
+                {
+                    int16_t l_Short;
+                    if ((rc = st->TryGet(i, l_Short)) == IBPP::rcOk)
+                        values[idx] = l_Short;
+                }
+                break;
+            }
+        case IBPP::sdInteger:
+            {
+                if (st->ColumnScale(i))
+                {
+                    double l_Double;
+                    if ((rc = st->TryGet(i, l_Double)) == IBPP::rcOk)
+                        values[idx] = l_Double;
+                }
+                else
+                {
+                    int32_t l_Integer;
+                    if ((rc = st->TryGet(i, l_Integer)) == IBPP::rcOk)
+                        values[idx] = l_Integer;
+                }
+                break;
+            }
+        case IBPP::sdLargeint:
+            {
+                if (st->ColumnScale(i))
+                {
+                    double l_Double;
+                    if ((rc = st->TryGet(i, l_Double)) == IBPP::rcOk)
+                        values[idx] = l_Double;
+                }
+                else
+                {
+                    int64_t l_Long;
+                    if ((rc = st->TryGet(i, l_Long)) == IBPP::rcOk)
+                        values[idx] = static_cast<qlonglong>(l_Long);
+                }
+                break;
+            }
+        case IBPP::sdFloat:
+            {
+                float l_Float;
+                if ((rc = st->TryGet(i, l_Float)) == IBPP::rcOk)
+                    values[idx] = l_Float;
+                break;
+            }
+        case IBPP::sdDouble:
+            {
+                double l_Double;
+                if ((rc = st->TryGet(i, l_Double)) == IBPP::rcOk)
+                    values[idx] = l_Double;
+                break;
+            }
+        case IBPP::sdString:
+            {
+                std::string l_String;
+                if ((rc = st->TryGet(i, l_String)) == IBPP::rcOk)
+                {
+                    values[idx] = fromIBPPStr(l_String, textCodec);
+                    if (stats)
+                        stats->bytesDecoded += qint64(l_String.size());
+                }
+                break;
+            }
+        case IBPP::sdArray:
+            {
+                if (st->IsNull(i))
+                    rc = IBPP::rcNull;
+                else
+                    values[idx] = qFBReadArray(db, tr, st, i, typedArrays, textCodec, arrays);
+                break;
+            }
+        case IBPP::sdBlob:
+            {
+                QFBAllocMeter l_Allocs;
+                if (stats)
+                    l_Allocs.start();
+
+                IBPP::Blob l_Blob = IBPP::BlobFactory(db, tr);
+                if ((rc = st->TryGet(i, l_Blob)) != IBPP::rcOk)
+                    break;
+
+                QElapsedTimer l_Timer;
+                if (stats)
+                    l_Timer.start();
+
+                QByteArray l_QBlob;
+
+                l_Blob->Open();
+                int l_Read, l_Offset = 0;
+                char buffer[1024];
+                while ((l_Read = l_Blob->Read(buffer, 1024)))
+                {
+                    l_QBlob.resize(l_QBlob.size() + l_Read);
+                    memcpy(l_QBlob.data() + l_Offset, buffer, l_Read);
+                    l_Offset += l_Read;
+                }
+                l_Blob->Close();
+
+                if (stats)
+                {
+                    stats->blobNs += l_Timer.nsecsElapsed();
+                    stats->blobBytes += l_QBlob.size();
+                    l_Allocs.addTo(stats->blobAllocs);
+                }
+                values[idx] = l_QBlob;
+                break;
+            }
+        default:
+            values[idx] =  QVariant();
+            break;
+        }
+
+        if (stats && rc == IBPP::rcOk && type != IBPP::sdString && type != IBPP::sdBlob)
+            stats->bytesDecoded += st->ColumnSize(i);
+
+        if (rc == IBPP::rcNull)
+        {
+            // null value
+            QVariant v;
+            v.convert(qIBPPTypeName(type));
+            values[idx] = v;
+        }
+        else if (rc != IBPP::rcOk)
+        {
+            qWarning("QFBResult::gotoNext: Unable to read column %d: %s", i,
+                     qFBStatusText(rc).toLatin1().constData());
+            values[idx] = QVariant();
+        }
+    }
+}
+//-----------------------------------------------------------------------//
+// Microseconds since 1970-01-01 00:00 (Julian day 2440588) of a timestamp
+static inline qint64 qFBEpochMicros(const IBPP::Timestamp &ts)
+{
+    return (ts.GetDate() + qFBJulianDay0 - 2440588) * Q_INT64_C(86400000000)
+            + qint64(ts.GetTime()) * 100;
+}
+//-----------------------------------------------------------------------//
+// Appends the 16 bytes of a decimal128, little endian
+static void qFBAppendDecimal(QByteArray &bytes, const IBPP::Int128 &v)
+{
+    uchar le[16];
+    qToLittleEndian<quint64>(v.Low(), le);
+    qToLittleEndian<qint64>(v.High(), le + 8);
+    bytes.append(reinterpret_cast<const char *>(le), 16);
+}
+//-----------------------------------------------------------------------//
+// An INT128 holds up to 39 digits, a decimal128 of precision 38 one less
+static bool qFBFitsDecimal(const IBPP::Int128 &v)
+{
+    static const IBPP::Int128 max(Q_INT64_C(0x4B3B4CA85A86C47A), Q_UINT64_C(0x098A224000000000));
+    static const IBPP::Int128 min(Q_INT64_C(-0x4B3B4CA85A86C47B), Q_UINT64_C(0xF675DDC000000000));
+    return min < v && v < max;    // 10^38 and -10^38 excluded
+}
+//-----------------------------------------------------------------------//
+static inline bool qFBIsBlank(char c)
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+//-----------------------------------------------------------------------//
+// Removes the white space around bytes[from..] as QString::trimmed() does
+// for the strings of the other character sets
+static void qFBTrimUtf8(QByteArray &bytes, int from)
+{
+    int end = bytes.size();
+    while (end > from && qFBIsBlank(bytes.at(end - 1)))
+        --end;
+    int start = from;
+    while (start < end && qFBIsBlank(bytes.at(start)))
+        ++start;
+    if (start > from)
+        memmove(bytes.data() + from, bytes.constData() + start, end - start);
+    bytes.resize(from + end - start);
+}
+//-----------------------------------------------------------------------//
+bool qFBFetchColumns(IBPP::Database &db, IBPP::Transaction &tr, IBPP::Statement &st,
+                     QFBColumnBatch &batch, int maxRows, const QTextCodec *textCodec,
+                     QSqlError &error, QFBStatementStats *stats)
+{
+    const int cols = st->Columns();
+    QVector<IBPP::SDT> types(cols);
+    batch.rows = 0;
+    batch.atEnd = false;
+    batch.columns.resize(cols);
+    for (int i = 1; i <= cols; ++i)
+    {
+        QFBColumn &c = batch.columns[i - 1];
+        const IBPP::SDT type = st->ColumnType(i);
+        types[i - 1] = type;
+        c.name = QString::fromLatin1(st->ColumnAlias(i)).simplified();
+        c.utc = false;
+        c.precision = 0;
+        c.scale = 0;
+        switch (type)
+        {
+        case IBPP::sdArray:
+            error = QSqlError(QLatin1String("Unable to fetch the columns"),
+                              QString::fromLatin1("column %1 (%2) is an array")
+                              .arg(i).arg(c.name), QSqlError::StatementError);
+            return false;
+        case IBPP::sdSmallint:
+        case IBPP::sdInteger:
+        case IBPP::sdLargeint:
+            if (!st->ColumnScale(i))
+                c.type = QFBColumn::Int64;
+            else if (!batch.decimals)
+                c.type = QFBColumn::Double;
+            else
+            {
+                c.type = QFBColumn::Decimal;
+                c.precision = type == IBPP::sdSmallint ? 5 : type == IBPP::sdInteger ? 10 : 19;
+                c.scale = st->ColumnScale(i);
+            }
+            break;
+        case IBPP::sdInt128:
+            c.type = batch.decimals ? QFBColumn::Decimal : QFBColumn::String;
+            c.precision = batch.wideDecimals ? 39 : 38;
+            c.scale = st->ColumnScale(i);
+            break;
+        case IBPP::sdFloat:
+        case IBPP::sdDouble:
+            c.type = QFBColumn::Double;
+            break;
+        case IBPP::sdBoolean:
+            c.type = QFBColumn::Boolean;
+            break;
+        case IBPP::sdDate:
+            c.type = QFBColumn::Date;
+            break;
+        case IBPP::sdTime:
+        case IBPP::sdTimeTz:
+            c.type = QFBColumn::Time;
+            break;
+        case IBPP::sdTimestampTz:
+            c.utc = true;
+            // fall through
+        case IBPP::sdTimestamp:
+            c.type = QFBColumn::Timestamp;
+            break;
+        case IBPP::sdBlob:
+            c.type = st->ColumnSubtype(i) == 1 ? QFBColumn::String : QFBColumn::Binary;
+            break;
+        case IBPP::sdString:
+            // The subtype of a string holds its character set, 1 is OCTETS
+            c.type = (st->ColumnSubtype(i) & 0xff) == 1 ? QFBColumn::Binary : QFBColumn::String;
+            break;
+        default:
+            c.type = QFBColumn::String;
+            break;
+        }
+
+        // The buffers keep their capacity for the next batch
+        c.nullCount = 0;
+        c.validity.resize(0);
+        c.ints.resize(0);
+        c.doubles.resize(0);
+        c.offsets.resize(0);
+        c.bytes.resize(0);
+        if (c.type == QFBColumn::String || c.type == QFBColumn::Binary)
+            c.offsets.append(0);
+    }
+
+    // Text in the connection character set goes as is when it is UTF-8
+    const bool utf8 = !textCodec || textCodec->mibEnum() == 106;
+    IBPP::Blob blob;
+    std::string text;
+    QElapsedTimer timer;
+
+    while (batch.rows < maxRows)
+    {
+        if (stats)
+            timer.start();
+        const bool fetched = st->Fetch();
+        if (stats)
+            stats->fetchNs += timer.nsecsElapsed();
+        if (!fetched)
+        {
+            batch.atEnd = true;
+            break;
+        }
+
+        const int row = batch.rows++;
+        for (int i = 1; i <= cols; ++i)
+        {
+            QFBColumn &c = batch.columns[i - 1];
+            if ((row & 7) == 0)
+                c.validity.append(0);
+
+            IBPP::RSC rc = IBPP::rcOk;
+            int decoded = 0;
+            switch (types[i - 1])
+            {
+            case IBPP::sdSmallint:
+            case IBPP::sdInteger:
+            case IBPP::sdLargeint:
+                if (c.type == QFBColumn::Double)
+                {
+                    double v = 0;
+                    rc = st->TryGet(i, v);
+                    c.doubles.append(rc == IBPP::rcOk ? v : 0);
+                }
+                else if (c.type == QFBColumn::Decimal)
+                {
+                    // The int64_t of a NUMERIC is its unscaled value
+                    int64_t v = 0;
+                    rc = st->TryGet(i, v);
+                    qFBAppendDecimal(c.bytes, IBPP::Int128(rc == IBPP::rcOk ? v : 0));
+                }
+                else
+                {
+                    // The integers of any size are read as they are stored
+                    int64_t v = 0;
+                    rc = st->TryGet(i, v);
+                    c.ints.append(rc == IBPP::rcOk ? v : 0);
+                }
+                break;
+            case IBPP::sdFloat:
+                {
+                    float v = 0;
+                    rc = st->TryGet(i, v);
+                    c.doubles.append(rc == IBPP::rcOk ? v : 0);
+                    break;
+                }
+            case IBPP::sdDouble:
+                {
+                    double v = 0;
+                    rc = st->TryGet(i, v);
+                    c.doubles.append(rc == IBPP::rcOk ? v : 0);
+                    break;
+                }
+            case IBPP::sdBoolean:
+                {
+                    bool v = false;
+                    rc = st->TryGet(i, v);
+                    c.ints.append(rc == IBPP::rcOk && v ? 1 : 0);
+                    break;
+                }
+            case IBPP::sdDate:
+                {
+                    IBPP::Date v;
+                    rc = st->TryGet(i, v);
+                    c.ints.append(rc == IBPP::rcOk ? v.GetDate() + qFBJulianDay0 : 0);
+                    break;
+                }
+            case IBPP::sdTime:
+                {
+                    IBPP::Time v;
+                    rc = st->TryGet(i, v);
+                    c.ints.append(rc == IBPP::rcOk ? qint64(v.GetTime()) * 100 : 0);
+                    break;
+                }
+            case IBPP::sdTimeTz:
+                {
+                    IBPP::TimeTz v;
+                    rc = st->TryGet(i, v);
+                    c.ints.append(rc == IBPP::rcOk ? qint64(v.Local().GetTime()) * 100 : 0);
+                    break;
+                }
+            case IBPP::sdTimestamp:
+                {
+                    IBPP::Timestamp v;
+                    rc = st->TryGet(i, v);
+                    c.ints.append(rc == IBPP::rcOk ? qFBEpochMicros(v) : 0);
+                    break;
+                }
+            case IBPP::sdTimestampTz:
+                {
+                    // The date and time of a TimestampTz are those in UTC
+                    IBPP::TimestampTz v;
+                    rc = st->TryGet(i, v);
+                    c.ints.append(rc == IBPP::rcOk ? qFBEpochMicros(v) : 0);
+                    break;
+                }
+            case IBPP::sdString:
+                {
+                    // Copied from the column buffer to the end of bytes
+                    const int at = c.bytes.size();
+                    int len = st->ColumnSize(i);
+                    c.bytes.resize(at + len);
+                    if (st->Get(i, c.bytes.data() + at, len))
+                    {
+                        rc = IBPP::rcNull;
+                        len = 0;
+                    }
+                    c.bytes.resize(at + len);
+                    decoded = len;
+                    if (c.type == QFBColumn::Binary || !textCodec || rc != IBPP::rcOk)
+                        break;
+                    if (utf8)
+                    {
+                        qFBTrimUtf8(c.bytes, at);
+                        break;
+                    }
+                    const QByteArray converted =
+                            textCodec->toUnicode(c.bytes.constData() + at, len).trimmed().toUtf8();
+                    c.bytes.resize(at);
+                    c.bytes.append(converted);
+                    break;
+                }
+            case IBPP::sdBlob:
+                {
+                    if (blob.intf() == 0)
+                        blob = IBPP::BlobFactory(db, tr);
+                    if ((rc = st->TryGet(i, blob)) != IBPP::rcOk)
+                        break;
+
+                    if (stats)
+                        timer.start();
+                    const int at = c.bytes.size();
+                    int len = 0;
+                    int read;
+                    blob->Open();
+                    do
+                    {
+                        c.bytes.resize(at + len + 16384);
+                        read = blob->Read(c.bytes.data() + at + len, 16384);
+                        len += read;
+                    }
+                    while (read > 0);
+                    blob->Close();
+                    c.bytes.resize(at + len);
+                    if (stats)
+                    {
+                        stats->blobNs += timer.nsecsElapsed();
+                        stats->blobBytes += len;
+                    }
+
+                    if (c.type == QFBColumn::String && !utf8)
+                    {
+                        const QByteArray converted =
+                                textCodec->toUnicode(c.bytes.constData() + at, len).toUtf8();
+                        c.bytes.resize(at);
+                        c.bytes.append(converted);
+                    }
+                    break;
+                }
+            case IBPP::sdInt128:
+                if (c.type == QFBColumn::Decimal)
+                {
+                    IBPP::Int128 v;
+                    rc = st->TryGet(i, v);
+                    if (rc == IBPP::rcOk && !batch.wideDecimals && !qFBFitsDecimal(v))
+                    {
+                        error = QSqlError(QLatin1String("Unable to fetch the columns"),
+                                          QString::fromLatin1("column %1 (%2): %3 has more than the "
+                                                              "38 digits of a decimal, read it as text")
+                                          .arg(i).arg(c.name)
+                                          .arg(QString::fromLatin1(v.ToString(c.scale).c_str())),
+                                          QSqlError::StatementError);
+                        return false;
+                    }
+                    qFBAppendDecimal(c.bytes, rc == IBPP::rcOk ? v : IBPP::Int128());
+                    break;
+                }
+                // fall through
+            default:
+                {
+                    // INT128 and DECFLOAT, as text
+                    rc = st->TryGet(i, text);
+                    if (rc == IBPP::rcOk)
+                        c.bytes.append(text.data(), int(text.size()));
+                    break;
+                }
+            }
+
+            if (c.type == QFBColumn::String || c.type == QFBColumn::Binary)
+                c.offsets.append(c.bytes.size());
+
+            if (rc == IBPP::rcOk)
+            {
+                c.validity[row >> 3] |= quint8(1 << (row & 7));
+                if (stats)
+                    stats->bytesDecoded += types[i - 1] == IBPP::sdString ? decoded
+                            : types[i - 1] == IBPP::sdBlob ? 0 : st->ColumnSize(i);
+                continue;
+            }
+
+            if (rc != IBPP::rcNull)
+                qWarning("QFBResult::fetchColumns: Unable to read column %d: %s", i,
+                         qFBStatusText(rc).toLatin1().constData());
+            ++c.nullCount;
+        }
+    }
+    return true;
+}
+//-----------------------------------------------------------------------//
+QSqlRecord qFBRecord(const IBPP::Statement &st)
+{
+    QSqlRecord rec;
+    const int cols = st->Columns();
+    for (int i = 1; i <= cols; ++i)
+    {
+        const QString& column_alias = QString::fromLatin1(st->ColumnAlias(i)).simplified();
+        QString alias = column_alias;
+
+        int num(1);
+        while (rec.indexOf(alias) >= 0) {
+            alias = column_alias + QString::number(num);
+            num++;
+        }
+
+        QSqlField f(alias,
+                    qIBPPTypeName(st->ColumnType(i)));
+        f.setLength(st->ColumnSize(i));
+        f.setPrecision(st->ColumnScale(i));
+        f.setSqlType(st->ColumnType(i));
+
+        rec.append(f);
+    }
+    return rec;
+}
+//-----------------------------------------------------------------------//
+int QFBLatencyHistogram::bucketOf(qint64 ns)
+{
+    if (ns < SubBuckets)
+        return ns < 0 ? 0 : int(ns);
+
+    const quint64 v = qMin(quint64(ns), (Q_UINT64_C(1) << 40) - 1);
+    const int e = 63 - qCountLeadingZeroBits(v);    // 5 to 39
+    return (e - 4) * SubBuckets + int((v >> (e - 5)) & (SubBuckets - 1));
+}
+//-----------------------------------------------------------------------//
+qint64 QFBLatencyHistogram::bucketMaxNs(int bucket)
+{
+    if (bucket < SubBuckets)
+        return bucket;
+
+    const int e = bucket / SubBuckets + 4;
+    const qint64 low = qint64(SubBuckets + bucket % SubBuckets) << (e - 5);
+    return low + (Q_INT64_C(1) << (e - 5)) - 1;
+}
+//-----------------------------------------------------------------------//
+qint64 QFBLatencyHistogram::percentile(double percent) const
+{
+    if (count <= 0 || counts.isEmpty())
+        return 0;
+
+    const qint64 rank = qBound(Q_INT64_C(1), qint64(std::ceil(percent / 100.0 * count)), count);
+    qint64 seen = 0;
+    for (int i = 0; i < counts.size(); ++i)
+    {
+        seen += counts.at(i);
+        if (seen >= rank)
+            return qBound(minNs, bucketMaxNs(i), maxNs);
+    }
+    return maxNs;
+}
+//-----------------------------------------------------------------------//
+// Counters of one fingerprint, updated by the queries without lock
+struct QFBFingerprintEntry
+{
+    QFBFingerprintEntry(const QString &fp, const QString &query)
+        : fingerprint(fp), example(query)
+    { reset(); }
+
+    void reset();
+    void record(const QFBStatementStats &stats);
+    QFBFingerprintStats snapshot() const;
+
+    const QString fingerprint;
+    const QString example;
+    std::atomic<qint64> executions;
+    std::atomic<qint64> failed;
+    std::atomic<qint64> rows;
+    std::atomic<qint64> totalNs;
+    std::atomic<qint64> minNs;
+    std::atomic<qint64> maxNs;
+    std::atomic<qint64> buckets[QFBLatencyHistogram::BucketCount];
+};
+//-----------------------------------------------------------------------//
+void QFBFingerprintEntry::reset()
+{
+    executions.store(0, std::memory_order_relaxed);
+    failed.store(0, std::memory_order_relaxed);
+    rows.store(0, std::memory_order_relaxed);
+    totalNs.store(0, std::memory_order_relaxed);
+    minNs.store(std::numeric_limits<qint64>::max(), std::memory_order_relaxed);
+    maxNs.store(0, std::memory_order_relaxed);
+    for (int i = 0; i < QFBLatencyHistogram::BucketCount; ++i)
+        buckets[i].store(0, std::memory_order_relaxed);
+}
+//-----------------------------------------------------------------------//
+void QFBFingerprintEntry::record(const QFBStatementStats &stats)
+{
+    const qint64 ns = stats.totalNs();
+    executions.fetch_add(1, std::memory_order_relaxed);
+    if (stats.failed)
+        failed.fetch_add(1, std::memory_order_relaxed);
+    rows.fetch_add(stats.rows, std::memory_order_relaxed);
+    totalNs.fetch_add(ns, std::memory_order_relaxed);
+    buckets[QFBLatencyHistogram::bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+
+    qint64 m = minNs.load(std::memory_order_relaxed);
+    while (ns < m && !minNs.compare_exchange_weak(m, ns, std::memory_order_relaxed))
+        ;
+    m = maxNs.load(std::memory_order_relaxed);
+    while (ns > m && !maxNs.compare_exchange_weak(m, ns, std::memory_order_relaxed))
+        ;
+}
+//-----------------------------------------------------------------------//
+// The counters are read one by one while the queries may update them: the
+// histogram count is the sum of its buckets, not executions
+QFBFingerprintStats QFBFingerprintEntry::snapshot() const
+{
+    QFBFingerprintStats s;
+    s.fingerprint = fingerprint;
+    s.example = example;
+    s.executions = executions.load(std::memory_order_relaxed);
+    s.failed = failed.load(std::memory_order_relaxed);
+    s.rows = rows.load(std::memory_order_relaxed);
+    s.totalNs = totalNs.load(std::memory_order_relaxed);
+
+    QFBLatencyHistogram &h = s.latency;
+    h.counts.resize(QFBLatencyHistogram::BucketCount);
+    for (int i = 0; i < QFBLatencyHistogram::BucketCount; ++i)
+    {
+        h.counts[i] = buckets[i].load(std::memory_order_relaxed);
+        h.count += h.counts.at(i);
+    }
+    if (h.count == 0)
+    {
+        h.counts.clear();
+        return s;
+    }
+    h.minNs = minNs.load(std::memory_order_relaxed);
+    h.maxNs = maxNs.load(std::memory_order_relaxed);
+    if (h.minNs > h.maxNs)
+        h.minNs = h.maxNs;
+    return s;
+}
+//-----------------------------------------------------------------------//
+class QFBDriverPrivate: public QSqlDriverPrivate
+{
+    Q_DECLARE_PUBLIC(QFBDriver)
+public:
+    QFBDriverPrivate()
+         : QSqlDriverPrivate(), scrollableCursors(false), typedArrays(false), timeText(false),
+           statisticsEnabled(false), serverStatistics(false), activityValid(false),
+           slowQueryMs(-1), fingerprintStatistics(false), textCodec(0)
+    {
+        iDb.clear();
+        iTr.clear();
+
+        tam = IBPP::amWrite;
+        til = IBPP::ilConcurrency;
+        tlr = IBPP::lrWait;
+        tff = IBPP::TFF(0);
+    }
+    ~QFBDriverPrivate() { qDeleteAll(fingerprints); }
+
+    void setError(const std::string &err, IBPP::Exception &e, QSqlError::ErrorType type);
+    void checkTransactionArguments();
+    void addStatistics(const QFBStatementStats &stats);
+    void logSlowQuery(const QFBSlowQuery &slow);
+    QFBFingerprintEntry *fingerprintEntry(const QString &query);
+
+    // QFBFetchOption flags of the connect options
+    int fetchOptions() const
+    {
+        return (typedArrays ? QFBTypedArrays : 0) | (timeText ? QFBTimeText : 0);
+    }
+
+    // The executions are timed for the statistics, the slow query log, the
+    // fingerprints or the metrics
+    bool timing() const
+    {
+        return statisticsEnabled || slowQueryMs >= 0 || fingerprintStatistics
+                || qFBMetricsEnabled();
+    }
+
+public:
+    IBPP::Database iDb;
+    IBPP::Transaction iTr;
+    QList<IBPP::Transaction> iL;
+
+    IBPP::TAM tam;
+    IBPP::TIL til;
+    IBPP::TLR tlr;
+    IBPP::TFF tff;
+
+    // SCROLLABLE_CURSORS option, cleared when the server refuses them
+    bool scrollableCursors;
+    // ARRAY_VECTORS and TIME_TEXT options
+    bool typedArrays;
+    bool timeText;
+
+    bool statisticsEnabled;
+    bool serverStatistics;
+    std::function<void(const QFBStatementStats &)> statisticsCallback;
+    // The statistics are read by monitoring threads while the connection
+    // thread adds to them; the callback runs outside the lock
+    mutable QMutex statisticsMutex;
+    QFBStatementStats lastStatistics;
+    QFBStatementStats totalStatistics;
+
+    // Attachment counters read when the last execution finished. The next
+    // execution starts from them instead of asking the server again, unless
+    // anything else (a fetch, a prepare, a transaction started or ended)
+    // was sent on the attachment in between
+    int activity[6];
+    bool activityValid;
+
+    int slowQueryMs;
+    QString slowQueryLog;
+    std::function<void(const QFBSlowQuery &)> slowQueryCallback;
+
+    // The entries live as long as the driver, the queries keep a pointer to
+    // theirs; the mutex only guards the hash
+    bool fingerprintStatistics;
+    mutable QMutex fingerprintMutex;
+    QHash<QString, QFBFingerprintEntry *> fingerprints;
+
+    QTextCodec *textCodec;
+};
+
+//-----------------------------------------------------------------------//
+void QFBDriverPrivate::setError(const std::string &err, IBPP::Exception &e, QSqlError::ErrorType type)
+{
+//	qWarning(err.data());
+    Q_Q(QFBDriver);
+    IBPP::SQLException *se = dynamic_cast<IBPP::SQLException *>(&e);
+    qFBMetricsError(se ? se->SqlCode() : 0);
+    q->setLastError(QSqlError(QString::fromLatin1(err.data()),
+                              QString::fromLatin1(e.ErrorMessage()), type));
+}
+//-----------------------------------------------------------------------//
+void QFBDriverPrivate::checkTransactionArguments()
+{
+    Q_Q(QFBDriver);
+    if (!q->property("Transaction").isValid())
+    {
+        tam = IBPP::amWrite;
+        til = IBPP::ilConcurrency;
+        tlr = IBPP::lrWait;
+        tff = IBPP::TFF(0);
+        return;
+    }
+
+    QString args = q->property("Transaction").toString();
+    const QStringList opts(args.split(QLatin1Char(','), QString::SkipEmptyParts));
+    for (int i = 0; i < opts.count(); ++i)
+    {
+        const QString tmp(opts.at(i));
+        int idx;
+        if ((idx = tmp.indexOf(QLatin1Char('='))) == -1)
+        {
+            qWarning("QFBDriver::checkTransactionArguments: Illegal option value '%s'",
+                     tmp.toLocal8Bit().constData());
+            continue;
+        }
+
+        const QString opt(tmp.left(idx).simplified());
+        const QString val(tmp.mid(idx + 1).simplified());
+
+        if (opt == QLatin1String("TAM"))
+        {
+            if (val == QLatin1String("amWrite"))
+                tam = IBPP::amWrite;
+            else
+                if (val == QLatin1String("amRead"))
+                    tam = IBPP::amRead;
+                else
+                    qWarning("QFBDriver::checkTransactionArguments: Unknown IBPP::TAM value '%s'",
+                             tmp.toLocal8Bit().constData());
+            continue;
+        }
+        else
+            if (opt == QLatin1String("TIL"))
+            {
+                if (val == QLatin1String("ilConcurrency"))
+                    til = IBPP::ilConcurrency;
+                else
+                    if (val == QLatin1String("ilReadDirty"))
+                        til = IBPP::ilReadDirty;
+                    else
+                        if (val == QLatin1String("ilReadCommitted"))
+                            til = IBPP::ilReadCommitted;
+                        else
+                            if (val == QLatin1String("ilConsistency"))
+                                til = IBPP::ilConsistency;
+                            else
+                                qWarning("QFBDriver::checkTransactionArguments: Unknown IBPP::TIL value '%s'",
+                                         tmp.toLocal8Bit().constData());
+                continue;
+            }
+            else
+                if (opt == QLatin1String("TLR"))
+                {
+                    if (val == QLatin1String("lrWait"))
+                        tlr = IBPP::lrWait;
+                    else
+                        if (val == QLatin1String("lrNoWait"))
+                            tlr = IBPP::lrNoWait;
+                        else
+                            qWarning("QFBDriver::checkTransactionArguments: Unknown IBPP::TLR value '%s'",
+                                     tmp.toLocal8Bit().constData());
+                    continue;
+                }
+                else
+                    if (opt == QLatin1String("TFF"))
+                    {
+                        if (val == QLatin1String("0"))
+                            tff = IBPP::TFF(0);
+                        else
+                            if (val == QLatin1String("tfIgnoreLimbo"))
+                                tff = IBPP::tfIgnoreLimbo;
+                            else
+                                if (val == QLatin1String("tfAutoCommit"))
+                                    tff = IBPP::tfAutoCommit;
+                                else
+                                    if (val == QLatin1String("tfNoAutoUndo"))
+                                        tff = IBPP::tfNoAutoUndo;
+                                    else
+                                        qWarning("QFBDriver::checkTransactionArguments: Unknown IBPP::TLR value '%s'",
+                                                 tmp.toLocal8Bit().constData());
+                        continue;
+                    }
+                    else
+                        qWarning("QFBDriver::checkTransactionArguments: Unknown transaction attribute '%s'",
+                                 tmp.toLocal8Bit().constData());
+    }
+//    qWarning("IBPP::Transaction arguments(TAM=%d, TIL=%d, TLR=%d, TFF=%d)", tam, til, tlr, tff);
+    q->setProperty("Transaction",QVariant());
+
+}
+//-----------------------------------------------------------------------//
+static inline void qFBAddAllocs(QFBAllocCount &total, const QFBAllocCount &count)
+{
+    total.allocations += count.allocations;
+    total.bytes += count.bytes;
+}
+
+void QFBDriverPrivate::addStatistics(const QFBStatementStats &stats)
+{
+    QMutexLocker locker(&statisticsMutex);
+    lastStatistics = stats;
+
+    QFBStatementStats &t = totalStatistics;
+    t.executions += stats.executions;
+    t.prepareNs += stats.prepareNs;
+    t.bindNs += stats.bindNs;
+    t.executeNs += stats.executeNs;
+    t.fetchNs += stats.fetchNs;
+    t.decodeNs += stats.decodeNs;
+    t.blobNs += stats.blobNs;
+    t.rows += stats.rows;
+    t.bytesDecoded += stats.bytesDecoded;
+    t.blobBytes += stats.blobBytes;
+    if (stats.serverCounters)
+    {
+        t.serverCounters = true;
+        t.pageFetches += stats.pageFetches;
+        t.pageReads += stats.pageReads;
+        t.pageWrites += stats.pageWrites;
+        t.pageMarks += stats.pageMarks;
+        t.indexedReads += stats.indexedReads;
+        t.sequentialReads += stats.sequentialReads;
+        t.recordsSelected += stats.recordsSelected;
+        t.recordsInserted += stats.recordsInserted;
+        t.recordsUpdated += stats.recordsUpdated;
+        t.recordsDeleted += stats.recordsDeleted;
+    }
+    if (stats.allocCounters)
+    {
+        t.allocCounters = true;
+        qFBAddAllocs(t.prepareAllocs, stats.prepareAllocs);
+        qFBAddAllocs(t.bindAllocs, stats.bindAllocs);
+        qFBAddAllocs(t.executeAllocs, stats.executeAllocs);
+        qFBAddAllocs(t.fetchAllocs, stats.fetchAllocs);
+        qFBAddAllocs(t.decodeAllocs, stats.decodeAllocs);
+        qFBAddAllocs(t.blobAllocs, stats.blobAllocs);
+    }
+    locker.unlock();
+
+    if (statisticsCallback)
+        statisticsCallback(stats);
+}
+//-----------------------------------------------------------------------//
+// Serializes the writes of all the connections to the log files
+Q_GLOBAL_STATIC(QMutex, qFBSlowLogMutex)
+
+void QFBDriverPrivate::logSlowQuery(const QFBSlowQuery &slow)
+{
+    if (slowQueryCallback)
+    {
+        slowQueryCallback(slow);
+        return;
+    }
+
+    const QString text = slow.toString();
+    if (!slowQueryLog.isEmpty())
+    {
+        QMutexLocker locker(qFBSlowLogMutex());
+        QFile file(slowQueryLog);
+        if (file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text))
+        {
+            file.write(text.toUtf8());
+            file.write("\n");
+            return;
+        }
+        qWarning("QFBDriver: unable to write the slow query log %s",
+                 slowQueryLog.toLocal8Bit().constData());
+    }
+    qWarning("%s", text.toLocal8Bit().constData());
+}
+//-----------------------------------------------------------------------//
+QFBFingerprintEntry *QFBDriverPrivate::fingerprintEntry(const QString &query)
+{
+    const int maxFingerprints = 1000;
+
+    QString fp = QFBDriver::fingerprint(query);
+    QMutexLocker locker(&fingerprintMutex);
+    QFBFingerprintEntry *entry = fingerprints.value(fp);
+    if (!entry && fingerprints.count() >= maxFingerprints)
+    {
+        fp = QLatin1String("(other)");
+        entry = fingerprints.value(fp);
+    }
+    if (!entry)
+    {
+        entry = new QFBFingerprintEntry(fp, query);
+        fingerprints.insert(fp, entry);
+    }
+    return entry;
+}
+//-----------------------------------------------------------------------//
+static QString qFBMsecs(qint64 ns)
+{
+    return QString::number(ns / 1e6, 'f', 3);
+}
+//-----------------------------------------------------------------------//
+QString QFBSlowQuery::toString() const
+{
+    const QFBStatementStats &s = statistics;
+    QString text = QString::fromLatin1("%1 slow query: %2 ms (prepare %3, bind %4, execute %5, "
+                                       "fetch %6, decode %7, blob %8), %9 rows")
+            .arg(time.toString(QLatin1String("yyyy-MM-dd hh:mm:ss.zzz")),
+                 qFBMsecs(s.totalNs()), qFBMsecs(s.prepareNs), qFBMsecs(s.bindNs),
+                 qFBMsecs(s.executeNs), qFBMsecs(s.fetchNs), qFBMsecs(s.decodeNs),
+                 qFBMsecs(s.blobNs))
+            .arg(s.rows);
+    if (s.failed)
+        text += QLatin1String(", failed");
+    if (s.serverCounters)
+        text += QString::fromLatin1("\n  server: %1 fetches, %2 reads, %3 writes, %4 marks, "
+                                    "%5 indexed and %6 sequential reads, "
+                                    "records %7 selected %8 inserted %9 updated %10 deleted")
+                .arg(s.pageFetches).arg(s.pageReads).arg(s.pageWrites).arg(s.pageMarks)
+                .arg(s.indexedReads).arg(s.sequentialReads)
+                .arg(s.recordsSelected).arg(s.recordsInserted).arg(s.recordsUpdated)
+                .arg(s.recordsDeleted);
+    if (s.allocCounters)
+        text += QString::fromLatin1("\n  allocations: prepare %1 (%2 bytes), bind %3 (%4), "
+                                    "execute %5 (%6), fetch %7 (%8), decode %9 (%10), blob %11 (%12)")
+                .arg(s.prepareAllocs.allocations).arg(s.prepareAllocs.bytes)
+                .arg(s.bindAllocs.allocations).arg(s.bindAllocs.bytes)
+                .arg(s.executeAllocs.allocations).arg(s.executeAllocs.bytes)
+                .arg(s.fetchAllocs.allocations).arg(s.fetchAllocs.bytes)
+                .arg(s.decodeAllocs.allocations).arg(s.decodeAllocs.bytes)
+                .arg(s.blobAllocs.allocations).arg(s.blobAllocs.bytes);
+    text += QLatin1String("\n  SQL: ") + s.query.simplified();
+    if (!parameters.isEmpty())
+        text += QLatin1String("\n  parameters: ") + parameters;
+    if (!plan.isEmpty())
+        text += QLatin1String("\n  plan: ") + plan.simplified();
+    return text;
+}
+//-----------------------------------------------------------------------//
+// A short form of the bound values: the first ones, long values cut
+static QString qFBParamSummary(const QVector<QVariant> &values)
+{
+    const int shown = 10;
+    QStringList parts;
+    for (int i = 0; i < values.count() && i < shown; ++i)
+    {
+        const QVariant &v = values.at(i);
+        if (v.isNull())
+            parts << QLatin1String("NULL");
+        else if (v.type() == QVariant::ByteArray)
+            parts << QString::fromLatin1("<%1 bytes>").arg(v.toByteArray().size());
+        else if (v.type() == QVariant::List)
+            parts << QString::fromLatin1("<array of %1>").arg(v.toList().count());
+        else if (v.type() == QVariant::String)
+        {
+            const QString s = v.toString();
+            parts << QLatin1String("'") + (s.length() > 40 ? s.left(40) + QLatin1String("...") : s)
+                     + QLatin1String("'");
+        }
+        else
+            parts << v.toString();
+    }
+    if (values.count() > shown)
+        parts << QString::fromLatin1("... (%1 values)").arg(values.count());
+    return parts.join(QLatin1String(", "));
+}
+//-----------------------------------------------------------------------//
+class QFBResultPrivate: public QSqlCachedResultPrivate
+{
+    Q_DECLARE_PUBLIC(QFBResult)
+
+public:
+    Q_DECLARE_SQLDRIVER_PRIVATE(QFBDriver)
+
+    QFBResultPrivate(QFBResult *rr, const QFBDriver *dd, QTextCodec *tc);
+    ~QFBResultPrivate() { cleanup(); }
+
+    void cleanup();
+
+    bool transaction();
+    bool commit();
+
+    bool isSelect();
+
+    enum ScrollMove { ScrollNext, ScrollPrior, ScrollFirst, ScrollAbsolute };
+
+    bool executeScrollable();
+    bool scrollTo(ScrollMove move, int position = 0);
+    bool countRows();
+
+    void startStatistics();
+    void finishStatistics();
+    bool fetchRow(QVariant *values);
+
+    void setError(const std::string &err,
+                  IBPP::Exception &e,
+                  QSqlError::ErrorType type = QSqlError::UnknownError);
+    void setError(const std::string &err,
+                  IBPP::Statement &st,
+                  QSqlError::ErrorType type = QSqlError::UnknownError);
+
+public:
+
+    bool localTransaction;
+
+    int queryType;
+
+    IBPP::Database iDb;
+    IBPP::Transaction iTr;
+    IBPP::Statement iSt;
+    QFBArrayCache arrays;   // Of the running execution
+
+    // Rows read through a server-side scrollable cursor instead of the
+    // cache: row holds the current one, rowCount is -1 until fetchLast()
+    bool scrolling;
+    QVector<QVariant> row;
+    int rowCount;
+
+    // Statistics of the running execution, when the driver collects them:
+    // the prepare time is kept for the next execution
+    bool statsPending;
+    qint64 prepareNs;
+    QFBAllocCount prepareAllocs;
+    QFBStatementStats stats;
+    int activity[6];        // Attachment counters when the execution started
+
+    // Slow query log: the values bound to the execution, and the plan of the
+    // prepared statement, read the first time it is logged
+    QVector<QVariant> slowParams;
+    bool planRead;
+    QString plan;
+
+    // Counters of the fingerprint of the prepared statement, when enabled
+    QFBFingerprintEntry *fingerprint;
+
+    // The prepared statement was executed before (metrics)
+    bool executed;
+    bool reused;
+
+    int affectedRows;       // -1 until asked to the server
+
+    QTextCodec *textCodec;
+};
+
+//-----------------------------------------------------------------------//
+QFBResultPrivate::QFBResultPrivate(QFBResult *rr, const QFBDriver *dd, QTextCodec *tc)
+        : QSqlCachedResultPrivate(rr, dd), queryType(-1),
+          scrolling(false), rowCount(-1), statsPending(false), prepareNs(0),
+          planRead(false), fingerprint(0), executed(false),
+          reused(false), affectedRows(-1), textCodec(tc)
+{
+    localTransaction = true;
+    iDb = drv_d_func()->iDb;
+
+    try
+    {
+        iTr = IBPP::TransactionFactory(iDb);
+        iSt = IBPP::StatementFactory(iDb,iTr);
+    }
+    catch (IBPP::Exception& e)
+    {
+        setError("Unable create local transaction and statement", e, QSqlError::StatementError);
+    }
+}
+
+//-----------------------------------------------------------------------//
+void QFBResultPrivate::cleanup()
+{
+    Q_Q(QFBResult);
+    finishStatistics();
+    commit();
+
+    //if (!localTransaction)
+    //iTr = 0;
+
+    try
+    {
+        iSt->Close();
+    }
+    catch (IBPP::Exception& e)
+    {
+        setError("Unable close statement", e, QSqlError::StatementError);
+    }
+
+    arrays.clear();
+    queryType = -1;
+    affectedRows = -1;
+    planRead = false;
+    plan.clear();
+
+    scrolling = false;
+    row.clear();
+    rowCount = -1;
+
+    q->cleanup();
+}
+//-----------------------------------------------------------------------//
+void QFBResultPrivate::setError(const std::string &err, IBPP::Exception &e, QSqlError::ErrorType type)
+{
+//	qWarning(err.data());
+    Q_Q(QFBResult);
+    qWarning(e.ErrorMessage());
+    IBPP::SQLException *se = dynamic_cast<IBPP::SQLException *>(&e);
+    qFBMetricsError(se ? se->SqlCode() : 0);
+    q->setLastError(QSqlError(QString::fromLatin1(err.data()),
+                              QString::fromLatin1(e.ErrorMessage()), type));
+}
+//-----------------------------------------------------------------------//
+void QFBResultPrivate::setError(const std::string &err, IBPP::Statement &st, QSqlError::ErrorType type)
+{
+    Q_Q(QFBResult);
+    const char *message = st->LastErrorMessage();
+    qWarning("%s", message);
+    qFBMetricsError(st->LastSqlCode());
+    q->setLastError(QSqlError(QString::fromLatin1(err.data()),
+                              QString::fromLatin1(message), type,
+                              QString::number(st->LastSqlCode())));
+}
+//-----------------------------------------------------------------------//
+bool QFBResultPrivate::isSelect()
+{
+    bool iss = false;
+    try
+    {
+        iss = (iSt->Type() == IBPP::stSelect);
+    }
+    catch (IBPP::Exception& e)
+    {
+        setError("Unable get type of statement", e, QSqlError::StatementError);
+    }
+    return iss;
+}
+//-----------------------------------------------------------------------//
+bool QFBResultPrivate::executeScrollable()
+{
+    try
+    {
+        iSt->ExecuteScrollable();
+        row.fill(QVariant(), iSt->Columns());
+    }
+    catch (IBPP::Exception& e)
+    {
+        qWarning("QFBResult::exec: unable to open a scrollable cursor\n%s", e.ErrorMessage());
+        return false;
+    }
+
+    rowCount = -1;
+    return true;
+}
+//-----------------------------------------------------------------------//
+bool QFBResultPrivate::scrollTo(ScrollMove move, int position)
+{
+    bool stat = false;
+    QElapsedTimer timer;
+    QFBAllocMeter allocs;
+    if (statsPending)
+    {
+        timer.start();
+        allocs.start();
+    }
+    try
+    {
+        switch (move)
+        {
+        case ScrollNext:
+            stat = iSt->Fetch();
+            break;
+        case ScrollPrior:
+            stat = iSt->FetchPrior();
+            break;
+        case ScrollFirst:
+            stat = iSt->FetchFirst();
+            break;
+        case ScrollAbsolute:
+            stat = iSt->FetchAbsolute(position);
+            break;
+        }
+    }
+    catch (IBPP::Exception& e)
+    {
+        setError("Could not fetch row", e, QSqlError::StatementError);
+        return false;
+    }
+    if (statsPending)
+    {
+        stats.fetchNs += timer.nsecsElapsed();
+        allocs.addTo(stats.fetchAllocs);
+    }
+
+    if (stat && !fetchRow(row.data()))
+        return false;
+
+    return stat;
+}
+//-----------------------------------------------------------------------//
+bool QFBResultPrivate::countRows()
+{
+    // The cursor doesn't report its position: the size of the result set is
+    // found by probing absolute positions, in O(log n) fetches
+    try
+    {
+        if (!iSt->FetchFirst())
+        {
+            rowCount = 0;
+            return true;
+        }
+
+        int low = 1;
+        int high = 2;
+        while (iSt->FetchAbsolute(high))
+        {
+            low = high;
+            if (high > INT_MAX / 2)
+            {
+                high = INT_MAX;
+                break;
+            }
+            high *= 2;
+        }
+
+        while (high - low > 1)
+        {
+            const int mid = low + (high - low) / 2;
+            if (iSt->FetchAbsolute(mid))
+                low = mid;
+            else
+                high = mid;
+        }
+        rowCount = low;
+    }
+    catch (IBPP::Exception& e)
+    {
+        setError("Could not count rows", e, QSqlError::StatementError);
+        return false;
+    }
+
+    return true;
+}
+//-----------------------------------------------------------------------//
+void QFBResultPrivate::startStatistics()
+{
+    finishStatistics();
+    affectedRows = -1;
+    reused = executed;
+    executed = true;
+
+    QFBDriverPrivate *drv = drv_d_func();
+    const bool activityValid = drv->activityValid;
+    drv->activityValid = false;
+    statsPending = drv->timing();
+    if (!statsPending)
+        return;
+
+    const QString query = stats.query;
+    stats = QFBStatementStats();
+    stats.query = query;
+    stats.executions = 1;
+    stats.prepareNs = prepareNs;
+    stats.failed = true;    // Until exec() succeeds
+    prepareNs = 0;
+    stats.allocCounters = qFBAllocCounting();
+    stats.prepareAllocs = prepareAllocs;
+    prepareAllocs = QFBAllocCount();
+
+    if (drv->serverStatistics && activityValid)
+    {
+        std::copy(drv->activity, drv->activity + 6, activity);
+        stats.serverCounters = true;
+    }
+    else if (drv->serverStatistics)
+    {
+        try
+        {
+            iDb->Activity(&activity[0], &activity[1], &activity[2], &activity[3],
+                          &activity[4], &activity[5]);
+            stats.serverCounters = true;
+        }
+        catch (IBPP::Exception& e)
+        {
+            qWarning("QFBResult::exec: unable to read the server counters\n%s", e.ErrorMessage());
+        }
+    }
+}
+//-----------------------------------------------------------------------//
+void QFBResultPrivate::finishStatistics()
+{
+    if (!statsPending)
+        return;
+    statsPending = false;
+
+    // The driver may be gone when the query is destroyed
+    if (!sqldriver)
+        return;
+
+    if (stats.serverCounters)
+    {
+        // The statement is still prepared here: its record counts and the
+        // attachment counters are read once, after the execution. The two
+        // calls can't be merged, isc_database_info doesn't know the records
+        // of a statement and isc_dsql_sql_info doesn't know the pages
+        QFBDriverPrivate *drv = drv_d_func();
+        int now[6];
+        int counts[4];
+        try
+        {
+            iDb->Activity(&now[0], &now[1], &now[2], &now[3], &now[4], &now[5]);
+            std::copy(now, now + 6, drv->activity);
+            drv->activityValid = true;
+            iSt->RecordCounts(&counts[0], &counts[1], &counts[2], &counts[3]);
+
+            stats.pageFetches = now[0] - activity[0];
+            stats.pageMarks = now[1] - activity[1];
+            stats.pageReads = now[2] - activity[2];
+            stats.pageWrites = now[3] - activity[3];
+            stats.indexedReads = now[4] - activity[4];
+            stats.sequentialReads = now[5] - activity[5];
+            stats.recordsSelected = counts[0];
+            stats.recordsInserted = counts[1];
+            stats.recordsUpdated = counts[2];
+            stats.recordsDeleted = counts[3];
+
+            const int type = iSt->Type();
+            if (type == IBPP::stInsert) affectedRows = counts[1];
+            else if (type == IBPP::stUpdate) affectedRows = counts[2];
+            else if (type == IBPP::stDelete) affectedRows = counts[3];
+        }
+        catch (IBPP::Exception& e)
+        {
+            qWarning("QFBResult: unable to read the server counters\n%s", e.ErrorMessage());
+            stats.serverCounters = false;
+        }
+    }
+
+    QFBDriverPrivate *drv = drv_d_func();
+    if (drv->statisticsEnabled)
+        drv->addStatistics(stats);
+    if (fingerprint && drv->fingerprintStatistics)
+        fingerprint->record(stats);
+    if (qFBMetricsEnabled())
+        qFBMetricsExecuted(stats, reused);
+
+    if (drv->slowQueryMs >= 0 && stats.totalNs() >= drv->slowQueryMs * Q_INT64_C(1000000))
+    {
+        if (!planRead)
+        {
+            planRead = true;
+            try
+            {
+                std::string p;
+                iSt->Plan(p);
+                plan = fromIBPPStr(p, textCodec);
+            }
+            catch (IBPP::Exception& e)
+            {
+                Q_UNUSED(e);    // No plan for this kind of statement
+            }
+        }
+
+        QFBSlowQuery slow;
+        slow.time = QDateTime::currentDateTime();
+        slow.statistics = stats;
+        slow.parameters = qFBParamSummary(slowParams);
+        slow.plan = plan;
+        drv->logSlowQuery(slow);
+    }
+    slowParams.clear();
+}
+//-----------------------------------------------------------------------//
+// Converts the current row, timing the conversion when statistics are on
+bool QFBResultPrivate::fetchRow(QVariant *values)
+{
+    try
+    {
+        if (!statsPending)
+        {
+            qFBFetchRow(iDb, iTr, iSt, values, textCodec, drv_d_func()->fetchOptions(), 0, &arrays);
+            return true;
+        }
+
+        QElapsedTimer timer;
+        QFBAllocMeter allocs;
+        timer.start();
+        allocs.start();
+        const qint64 blobNs = stats.blobNs;
+        const QFBAllocCount blobAllocs = stats.blobAllocs;
+        qFBFetchRow(iDb, iTr, iSt, values, textCodec, drv_d_func()->fetchOptions(), &stats, &arrays);
+        stats.decodeNs += timer.nsecsElapsed() - (stats.blobNs - blobNs);
+        allocs.addTo(stats.decodeAllocs);
+        stats.decodeAllocs.allocations -= stats.blobAllocs.allocations - blobAllocs.allocations;
+        stats.decodeAllocs.bytes -= stats.blobAllocs.bytes - blobAllocs.bytes;
+        ++stats.rows;
+    }
+    catch (IBPP::Exception& e)
+    {
+        setError("Could not read row values", e, QSqlError::StatementError);
+        return false;
+    }
+    return true;
+}
+//-----------------------------------------------------------------------//
+bool QFBResultPrivate::transaction()
 {
     if (iTr->Started())
         return true;
@@ -451,6 +2557,7 @@ bool QFBResultPrivate::transaction()
                                        drv_d_func()->tlr,
                                        drv_d_func()->tff);
         iSt = IBPP::StatementFactory(iDb,iTr);
+        drv_d_func()->activityValid = false;
         iTr->Start();
     }
     catch (IBPP::Exception& e)
@@ -472,6 +2579,7 @@ bool QFBResultPrivate::commit()
 
     try
     {
+        drv_d_func()->activityValid = false;
         iTr->Commit();
     }
     catch (IBPP::Exception& e)
@@ -511,9 +2619,19 @@ bool QFBResult::prepare(const QString& query)
         return false;
     }
 
+    QElapsedTimer timer;
+    QFBAllocMeter allocs;
+    const bool timed = d->drv_d_func()->timing();
+    if (timed)
+    {
+        timer.start();
+        allocs.start();
+    }
+
     try
     {
-        d->iSt->Prepare(toIBPPStr(query, d->textCodec));
+        d->drv_d_func()->activityValid = false;
+        d->iSt->Prepare(qFBToIBPPStr(query, d->textCodec));
     }
     catch (IBPP::Exception& e)
     {
@@ -521,6 +2639,17 @@ bool QFBResult::prepare(const QString& query)
         return false;
     }
 
+    d->prepareNs = timed ? timer.nsecsElapsed() : 0;
+    d->prepareAllocs = QFBAllocCount();
+    if (timed)
+        allocs.addTo(d->prepareAllocs);
+    d->stats.query = query;
+    QFBDriverPrivate *drv = d->drv_d_func();
+    d->fingerprint = drv->fingerprintStatistics ? drv->fingerprintEntry(query) : 0;
+    d->executed = false;
+    if (qFBMetricsEnabled())
+        qFBMetricsPrepared();
+
     setSelect(d->isSelect());
 
     return true;
@@ -542,122 +2671,102 @@ bool QFBResult::exec()
     setActive(false);
     setAt(QSql::BeforeFirstRow);
 
-    int paramCount = 0;
-
-    try
-    {
-        paramCount = d->iSt->Parameters();
-    }
-    catch (IBPP::Exception& e)
+    d->arrays.clear();
+    d->startStatistics();
+    QElapsedTimer timer;
+    QFBAllocMeter allocs;
+    if (d->statsPending)
     {
-        Q_UNUSED(e);
-        paramCount = 0;
+        timer.start();
+        allocs.start();
     }
 
-    bool ok = true;
-    if (paramCount)
-    {
-        QVector<QVariant>& values = boundValues();
-        int i;
-        if (values.count() > paramCount)
-        {
-            qWarning("QFBResult::exec: Parameter mismatch, expected %d, got %d parameters",
-                     d->iSt->Parameters(), values.count());
-            return false;
-        }
-        for (i = 1; i <= values.count(); ++i)
-        {
-
-            if (!d->iSt->ParameterType(i))
-                continue;
-
-            const QVariant val(values[i-1]);
-
-            if (val.isNull())
-            {
-                try
-                {
-                    d->iSt->SetNull(i);
-                }
-                catch (IBPP::Exception& e)
-                {
-                    d->setError("Unable to set NULL", e, QSqlError::StatementError);
-                    return false;
-                }
-                continue;
-            }
+    int paramCount = 0;
 
-            switch (d->iSt->ParameterType(i))
-            {
-            //int64_t i;
-            case IBPP::sdLargeint:
-                if (d->iSt->ParameterScale(i))
-                    d->iSt->Set(i, val.toDouble());
-                else
-                    d->iSt->Set(i, static_cast<int64_t>(val.toLongLong()));
-                break;
-            case IBPP::sdInteger:
-                if (d->iSt->ParameterScale(i))
-                    d->iSt->Set(i, val.toDouble());
-                else
-                    d->iSt->Set(i, val.toInt());
-                break;
-            case IBPP::sdSmallint:
-                if (d->iSt->ParameterScale(i))
-                    d->iSt->Set(i, val.toDouble());
-                else
-                    d->iSt->Set(i, (short)val.toInt());
-                break;
-            case IBPP::sdFloat:
-                d->iSt->Set(i, (float)val.toDouble());
-                break;
-            case IBPP::sdDouble:
-                d->iSt->Set(i, val.toDouble());
-                break;
-            case IBPP::sdTimestamp:
-                d->iSt->Set(i, toIBPPTimeStamp(val.toDateTime()));
-                break;
-            case IBPP::sdTime:
-                d->iSt->Set(i, toIBPPTime(val.toTime()));
-                break;
-            case IBPP::sdDate:
-                d->iSt->Set(i, toIBPPDate(val.toDate()));
-                break;
-            case IBPP::sdString:
-                d->iSt->Set(i, toIBPPStr(val.toString(), d->textCodec));
-                break;
-            case IBPP::sdBlob:
-                {
-                    std::string  ss;
-                    QByteArray ba = val.toByteArray();
-                    ss.resize(ba.size());
-                    ss.assign(ba.constData(), ba.size());
-                    d->iSt->Set(i, ss);
-                    break;
-                }
-            case IBPP::sdArray:
-//                ok &= d->writeArray(i, val.toList());
-                break;
-            default:
-                qWarning("QFBResult::exec: Unknown datatype %d",
-                         d->iSt->ParameterType(i));
-                ok = false;
-                break;
+    try
+    {
+        paramCount = d->iSt->Parameters();
+    }
+    catch (IBPP::Exception& e)
+    {
+        Q_UNUSED(e);
+        paramCount = 0;
+    }
+
+    if (paramCount)
+    {
+        QVector<QVariant>& values = boundValues();
+        if (d->drv_d_func()->slowQueryMs >= 0)
+            d->slowParams = values;
+        try
+        {
+            QSqlError error;
+            if (!qFBBindValues(d->iSt, values, d->textCodec, error))
+            {
+                setLastError(error);
+                d->finishStatistics();
+                return false;
             }
         }
+        catch (IBPP::Exception& e)
+        {
+            d->setError("Unable to bind value", e, QSqlError::StatementError);
+            d->finishStatistics();
+            return false;
+        }
     }
 
-    if (!ok)
-        return false;
+    if (d->statsPending)
+    {
+        d->stats.bindNs = timer.nsecsElapsed();
+        allocs.addTo(d->stats.bindAllocs);
+        timer.restart();
+    }
 
-    try
+    // Random access on the server instead of the client cache when the
+    // SCROLLABLE_CURSORS option is set
+    d->scrolling = false;
+    bool scrollRefused = false;
+    if (!isForwardOnly() && d->drv_d_func()->scrollableCursors && d->isSelect())
     {
-        d->iSt->Execute();
+        d->scrolling = d->executeScrollable();
+        scrollRefused = !d->scrolling;
     }
-    catch (IBPP::Exception& e)
+
+    // Expected failures (constraint violations, ...) come back as a
+    // status: no exception is built for them
+    if (!d->scrolling)
     {
-        d->setError("Unable execute statement", e ,QSqlError::StatementError);
-        return false;
+        try
+        {
+            if (d->iSt->TryExecute() != IBPP::rcOk)
+            {
+                d->setError("Unable execute statement", d->iSt, QSqlError::StatementError);
+                d->finishStatistics();
+                return false;
+            }
+        }
+        catch (IBPP::Exception& e)
+        {
+            d->setError("Unable execute statement", e ,QSqlError::StatementError);
+            d->finishStatistics();
+            return false;
+        }
+    }
+
+    if (d->statsPending)
+    {
+        d->stats.executeNs = timer.nsecsElapsed();
+        allocs.addTo(d->stats.executeAllocs);
+        d->stats.failed = false;
+    }
+
+    // The statement itself is fine, so the server doesn't provide the
+    // cursors (Firebird 4 and older): don't try again on this connection
+    if (scrollRefused)
+    {
+        qWarning("QFBResult::exec: scrollable cursors disabled, rows are cached on the client");
+        d->drv_d_func()->scrollableCursors = false;
     }
     int cols = 0;
     try
@@ -675,7 +2784,10 @@ bool QFBResult::exec()
         cleanup(); // cleanup
 
     if (!d->isSelect())
+    {
+        d->finishStatistics();
         d->commit();
+    }
 
     setActive(true);
     return true;
@@ -693,8 +2805,16 @@ bool QFBResult::gotoNext(QSqlCachedResult::ValueCache& row, int rowIdx)
 
     bool stat;
     Q_D(QFBResult);
+    QElapsedTimer timer;
+    QFBAllocMeter allocs;
+    if (d->statsPending)
+    {
+        timer.start();
+        allocs.start();
+    }
     try
     {
+        d->drv_d_func()->activityValid = false;
         stat = d->iSt->Fetch();
     }
     catch (IBPP::Exception& e)
@@ -702,165 +2822,215 @@ bool QFBResult::gotoNext(QSqlCachedResult::ValueCache& row, int rowIdx)
         d->setError("Could not fetch next item", e, QSqlError::StatementError);
         return false;
     }
+    if (d->statsPending)
+    {
+        d->stats.fetchNs += timer.nsecsElapsed();
+        allocs.addTo(d->stats.fetchAllocs);
+    }
 
     if (!stat)
     {
         // no more rows
         setAt(QSql::AfterLastRow);
+        d->finishStatistics();
         return false;
     }
 
     if (rowIdx < 0) // not interested in actual values
+    {
+        if (d->statsPending)
+            ++d->stats.rows;
         return true;
+    }
 
-    int cols = 0;
+    return d->fetchRow(row.data() + rowIdx);
+}
+//-----------------------------------------------------------------------//
+bool QFBResult::fetchColumns(QFBColumnBatch &batch, int maxRows)
+{
+    Q_D(QFBResult);
+    batch.rows = 0;
+    if (!isActive() || !isSelect() || at() == QSql::AfterLastRow || maxRows <= 0)
+    {
+        batch.atEnd = at() == QSql::AfterLastRow;
+        return false;
+    }
+
+    QElapsedTimer timer;
+    QFBAllocMeter allocs;
+    const qint64 fetchNs = d->stats.fetchNs;
+    const qint64 blobNs = d->stats.blobNs;
+    if (d->statsPending)
+    {
+        timer.start();
+        allocs.start();
+    }
+
+    QSqlError error;
+    bool ok;
     try
     {
-        cols = d->iSt->Columns();
+        d->drv_d_func()->activityValid = false;
+        ok = qFBFetchColumns(d->iDb, d->iTr, d->iSt, batch, maxRows, d->textCodec, error,
+                             d->statsPending ? &d->stats : 0);
     }
     catch (IBPP::Exception& e)
     {
-        Q_UNUSED(e);
+        d->setError("Could not fetch the columns", e, QSqlError::StatementError);
+        return false;
+    }
+    if (!ok)
+    {
+        setLastError(error);
+        return false;
     }
 
-    for (int i = 1; i <= cols; ++i)
+    if (d->statsPending)
     {
-        int idx = rowIdx + i - 1;
+        // Fetches and blob reads are interleaved with the conversions
+        d->stats.decodeNs += timer.nsecsElapsed() - (d->stats.fetchNs - fetchNs)
+                - (d->stats.blobNs - blobNs);
+        allocs.addTo(d->stats.decodeAllocs);
+        d->stats.rows += batch.rows;
+    }
 
-        if (d->iSt->IsNull(i))
-        {
-            // null value
-            QVariant v;
-            v.convert(qIBPPTypeName(d->iSt->ColumnType(i)));
-            row[idx] = v;
-            continue;
-        }
+    if (batch.atEnd)
+    {
+        setAt(QSql::AfterLastRow);
+        d->finishStatistics();
+    }
+    return batch.rows > 0;
+}
+//-----------------------------------------------------------------------//
+bool QFBResult::fetchColumns(QSqlQuery &query, QFBColumnBatch &batch, int maxRows)
+{
+    QFBResult *result = dynamic_cast<QFBResult *>(const_cast<QSqlResult *>(query.result()));
+    if (!result)
+    {
+        qWarning("QFBResult::fetchColumns: the query is not one of a QFIREBIRD database");
+        batch.rows = 0;
+        return false;
+    }
+    return result->fetchColumns(batch, maxRows);
+}
+//-----------------------------------------------------------------------//
+QVariant QFBResult::data(int field)
+{
+    Q_D(QFBResult);
+    if (!d->scrolling)
+        return QSqlCachedResult::data(field);
 
-        switch (d->iSt->ColumnType(i))
-        {
-        case IBPP::sdDate:
-            {
-                IBPP::Date dt;
-                d->iSt->Get(i, dt);
-                row[idx] = fromIBPPDate(dt);
-                break;
-            }
-        case IBPP::sdTime:
-            {
-                IBPP::Time tm;
-                d->iSt->Get(i, tm);
-                row[idx] = fromIBPPTime(tm);
-                break;
-            }
-        case IBPP::sdTimestamp:
-            {
-                IBPP::Timestamp ts;
-                d->iSt->Get(i, ts);
-                row[idx] = fromIBPPTimeStamp(ts);
-                break;
-            }
-        case IBPP::sdSmallint:
-            {
-                if (d->iSt->ColumnScale(i))
-                {
-                    double l_Double;
-                    d->iSt->Get(i, l_Double);
-                    row[idx] = l_Double;
-                }
-                else
-                {
-                    short l_Short;
-                    d->iSt->Get(i, l_Short);
-                    row[idx] =l_Short;
-                }
-                break;
-            }
-        case IBPP::sdInteger:
-            {
-                if (d->iSt->ColumnScale(i))
-                {
-                    double l_Double;
-                    d->iSt->Get(i, l_Double);
-                    row[idx] = l_Double;
-                }
-                else
-                {
-                    int l_Integer;
-                    d->iSt->Get(i, l_Integer);
-                    row[idx] = l_Integer;
-                }
-                break;
-            }
-        case IBPP::sdLargeint:
-            {
-                if (d->iSt->ColumnScale(i))
-                {
-                    double l_Double;
-                    d->iSt->Get(i, l_Double);
-                    row[idx] = l_Double;
-                }
-                else
-                {
-                    int64_t l_Long;
-                    d->iSt->Get(i, l_Long);
-                    row[idx] = static_cast<qlonglong>(l_Long);
+    if (field < 0 || field >= d->row.count())
+    {
+        qWarning("QFBResult::data: column %d out of range", field);
+        return QVariant();
+    }
+    return d->row.at(field);
+}
+//-----------------------------------------------------------------------//
+bool QFBResult::fetch(int i)
+{
+    Q_D(QFBResult);
+    if (!d->scrolling)
+        return QSqlCachedResult::fetch(i);
 
-                }
-                break;
-            }
-        case IBPP::sdFloat:
-            {
-                float l_Float;
-                d->iSt->Get(i, l_Float);
-                row[idx] = l_Float;
-                break;
-            }
-        case IBPP::sdDouble:
-            {
-                double l_Double;
-                d->iSt->Get(i, l_Double);
-                row[idx] = l_Double;
-                break;
-            }
-        case IBPP::sdString:
-            {
-                std::string l_String;
-                d->iSt->Get(i, l_String);
-                row[idx] = fromIBPPStr(l_String, d->textCodec);
-                break;
-            }
-        case IBPP::sdArray:
-            {
-//	            row[idx] = d->fetchArray(i, (ISC_QUAD*)buf);
-                break;
-            }
-        case IBPP::sdBlob:
-            {
-                IBPP::Blob l_Blob = IBPP::BlobFactory(d->iDb, d->iTr);
-                d->iSt->Get(i, l_Blob);
+    if (!isActive() || i < 0)
+        return false;
+    if (at() == i)
+        return true;
 
-                QByteArray l_QBlob;
+    bool stat;
+    if (i == at() + 1)
+        stat = d->scrollTo(QFBResultPrivate::ScrollNext);
+    else if (i == at() - 1)
+        stat = d->scrollTo(QFBResultPrivate::ScrollPrior);
+    else
+        stat = d->scrollTo(QFBResultPrivate::ScrollAbsolute, i + 1);
 
-                l_Blob->Open();
-                int l_Read, l_Offset = 0;
-                char buffer[1024];
-                while ((l_Read = l_Blob->Read(buffer, 1024)))
-                {
-                    l_QBlob.resize(l_QBlob.size() + l_Read);
-                    memcpy(l_QBlob.data() + l_Offset, buffer, l_Read);
-                    l_Offset += l_Read;
-                }
-                l_Blob->Close();
+    if (!stat)
+    {
+        setAt(QSql::AfterLastRow);
+        return false;
+    }
+    setAt(i);
+    return true;
+}
+//-----------------------------------------------------------------------//
+bool QFBResult::fetchNext()
+{
+    Q_D(QFBResult);
+    if (!d->scrolling)
+        return QSqlCachedResult::fetchNext();
 
-                row[idx] = l_QBlob;
-                break;
-            }
-        default:
-            row[idx] =  QVariant();
-            break;
-        }
+    if (!isActive() || at() == QSql::AfterLastRow)
+        return false;
+
+    if (!d->scrollTo(QFBResultPrivate::ScrollNext))
+    {
+        setAt(QSql::AfterLastRow);
+        return false;
+    }
+    setAt(at() + 1);
+    return true;
+}
+//-----------------------------------------------------------------------//
+bool QFBResult::fetchPrevious()
+{
+    Q_D(QFBResult);
+    if (!d->scrolling)
+        return QSqlCachedResult::fetchPrevious();
+
+    if (!isActive() || at() == QSql::BeforeFirstRow)
+        return false;
+    if (at() == QSql::AfterLastRow)
+        return fetchLast();
+
+    if (!d->scrollTo(QFBResultPrivate::ScrollPrior))
+    {
+        setAt(QSql::BeforeFirstRow);
+        return false;
+    }
+    setAt(at() - 1);
+    return true;
+}
+//-----------------------------------------------------------------------//
+bool QFBResult::fetchFirst()
+{
+    Q_D(QFBResult);
+    if (!d->scrolling)
+        return QSqlCachedResult::fetchFirst();
+
+    if (!isActive())
+        return false;
+
+    if (!d->scrollTo(QFBResultPrivate::ScrollFirst))
+    {
+        setAt(QSql::AfterLastRow);
+        return false;
     }
+    setAt(0);
+    return true;
+}
+//-----------------------------------------------------------------------//
+bool QFBResult::fetchLast()
+{
+    Q_D(QFBResult);
+    if (!d->scrolling)
+        return QSqlCachedResult::fetchLast();
 
+    if (!isActive())
+        return false;
+
+    // at() must be known after the move: the last row is reached through
+    // its absolute position
+    if ((d->rowCount < 0 && !d->countRows())
+        || d->rowCount == 0
+        || !d->scrollTo(QFBResultPrivate::ScrollAbsolute, d->rowCount))
+    {
+        setAt(QSql::AfterLastRow);
+        return false;
+    }
+    setAt(d->rowCount - 1);
     return true;
 }
 //-----------------------------------------------------------------------//
@@ -887,6 +3057,8 @@ bool QFBResult::isNull(int field)
 {
     int cols = 0;
     Q_D(QFBResult);
+    if (d->scrolling)
+        return field < 0 || field >= d->row.count() || d->row.at(field).isNull();
     try
     {
         cols = d->iSt->Columns();
@@ -913,10 +3085,13 @@ int QFBResult::numRowsAffected()
     if (isSelect())
         return nra;
 
+    // The count doesn't change until the next execution: asked once
     Q_D(QFBResult);
+    if (d->affectedRows >= 0)
+        return d->affectedRows;
     try
     {
-        nra = d->iSt->AffectedRows();
+        nra = d->affectedRows = d->iSt->AffectedRows();
     }
     catch (IBPP::Exception& e)
     {
@@ -928,37 +3103,17 @@ int QFBResult::numRowsAffected()
 QSqlRecord QFBResult::record() const
 {
     QSqlRecord rec;
-    if (!isActive())
-        return rec;
-
-    int cols = 0;
-    Q_D(const QFBResult);
-    try
-    {
-        cols = d->iSt->Columns();
-    }
-    catch (IBPP::Exception& e)
-    {
-        Q_UNUSED(e);
-    }
-    for (int i = 1; i <= cols; ++i)
-    {
-        const QString& column_alias = QString::fromLatin1(d->iSt->ColumnAlias(i)).simplified();
-        QString alias = column_alias;
-
-        int num(1);
-        while (rec.indexOf(alias) >= 0) {
-            alias = column_alias + QString::number(num);
-            num++;
-        }
-
-        QSqlField f(alias,
-                    qIBPPTypeName(d->iSt->ColumnType(i)));
-        f.setLength(d->iSt->ColumnSize(i));
-        f.setPrecision(d->iSt->ColumnScale(i));
-        f.setSqlType(d->iSt->ColumnType(i));
+    if (!isActive())
+        return rec;
 
-        rec.append(f);
+    Q_D(const QFBResult);
+    try
+    {
+        rec = qFBRecord(d->iSt);
+    }
+    catch (IBPP::Exception& e)
+    {
+        Q_UNUSED(e);
     }
     return rec;
 }
@@ -980,12 +3135,19 @@ QFBDriver::QFBDriver(void *connection, QObject *parent)
 {
     Q_D(QFBDriver);
     d->iDb=(IBPP::IDatabase*)connection;
+    qFBMetricsAttachments(1, false);
     setOpen(true);
     setOpenError(false);
 }
 //-----------------------------------------------------------------------//
 QFBDriver::~QFBDriver()
 {
+    Q_D(QFBDriver);
+    if (isOpen())
+    {
+        qFBMetricsAttachments(-1, false);
+        qFBMetricsTransactions(-d->iL.count());
+    }
 }
 //-----------------------------------------------------------------------//
 bool QFBDriver::hasFeature(DriverFeature f) const
@@ -1012,39 +3174,9 @@ bool QFBDriver::open(const QString & db,
                      const QString & connOpts )
 {
 
-    QString charSet = QLatin1String("NONE");
-    QString role = QLatin1String("");
-
-    // Set connection attributes
-    const QStringList opts(connOpts.split(QLatin1Char(';'), QString::SkipEmptyParts));
-    for (int i = 0; i < opts.count(); ++i)
-    {
-        const QString tmp(opts.at(i));
-        int idx;
-        if ((idx = tmp.indexOf(QLatin1Char('='))) == -1)
-        {
-            qWarning("QFBDriver::open: Illegal connect option value '%s'",
-                     tmp.toLocal8Bit().constData());
-            continue;
-        }
-
-        const QString opt(tmp.left(idx));
-        const QString val(tmp.mid(idx + 1).simplified());
-
-        if (opt == QLatin1String("CHARSET"))
-        {
-            charSet = val.toUpper();
-        }
-        else if (opt == QLatin1String("ROLE"))
-        {
-            role = val;
-        }
-        else
-        {
-            qWarning("QFBDriver::open: Unknown connection attribute '%s'",
-                     tmp.toLocal8Bit().constData());
-        }
-    }
+    QFBConnectOptions options;
+    qFBParseConnectOptions(connOpts, options);
+    const QString &charSet = options.charSet;
 
     if (charSet.isEmpty())
     {
@@ -1055,86 +3187,16 @@ bool QFBDriver::open(const QString & db,
     if (isOpen())
         close();
 
-//    set textCodec
-    QByteArray codecName;
-    if (charSet == QLatin1String("ASCII"))
-        codecName = "ISO 8859-1";
-    else if (charSet == QLatin1String("BIG_5"))
-        codecName = "Big5";
-    else if (charSet == QLatin1String("CYRL"))
-        codecName = "IBM 866";
-    else if (charSet == QLatin1String("DOS850"))
-        codecName = "IBM 850";
-    else if (charSet == QLatin1String("DOS866"))
-        codecName = "IBM 866";
-    else if (charSet == QLatin1String("KOI8-R"))
-        codecName = "KOI8-R";
-    else if (charSet == QLatin1String("KOI8-U"))
-        codecName = "KOI8-U";
-    else if (charSet == QLatin1String("EUCJ_0208"))
-        codecName = "JIS X 0208";
-    else if (charSet == QLatin1String("GB_2312"))
-        codecName = "GB18030-0";
-
-    else if (charSet == QLatin1String("ISO8859_1"))
-        codecName = "ISO 8859-1";
-    else if (charSet == QLatin1String("ISO8859_2"))
-        codecName = "ISO 8859-2";
-    else if (charSet == QLatin1String("ISO8859_3"))
-        codecName = "ISO 8859-3";
-    else if (charSet == QLatin1String("ISO8859_4"))
-        codecName = "ISO 8859-4";
-    else if (charSet == QLatin1String("ISO8859_5"))
-        codecName = "ISO 8859-5";
-    else if (charSet == QLatin1String("ISO8859_6"))
-        codecName = "ISO 8859-6";
-    else if (charSet == QLatin1String("ISO8859_7"))
-        codecName = "ISO 8859-7";
-    else if (charSet == QLatin1String("ISO8859_8"))
-        codecName = "ISO 8859-8";
-    else if (charSet == QLatin1String("ISO8859_9"))
-        codecName = "ISO 8859-9";
-    else if (charSet == QLatin1String("ISO8859_13"))
-        codecName = "ISO 8859-13";
-
-    else if (charSet == QLatin1String("KSC_5601"))
-        codecName = "Big5-HKSCS";
-    else if (charSet == QLatin1String("SJIS_0208"))
-        codecName = "JIS X 0208";
-    else if (charSet == QLatin1String("UNICODE_FSS"))
-        codecName = "UTF-8";
-    else if (charSet == QLatin1String("UTF8"))
-        codecName = "UTF-8";
-
-    else if (charSet == QLatin1String("WIN1250"))
-        codecName = "Windows-1250";
-    else if (charSet == QLatin1String("WIN1251"))
-        codecName = "Windows-1251";
-    else if (charSet == QLatin1String("WIN1252"))
-        codecName = "Windows-1252";
-    else if (charSet == QLatin1String("WIN1253"))
-        codecName = "Windows-1253";
-    else if (charSet == QLatin1String("WIN1254"))
-        codecName = "Windows-1254";
-    else if (charSet == QLatin1String("WIN1255"))
-        codecName = "Windows-1255";
-    else if (charSet == QLatin1String("WIN1256"))
-        codecName = "Windows-1256";
-    else if (charSet == QLatin1String("WIN1257"))
-        codecName = "Windows-1257";
-    else if (charSet == QLatin1String("WIN1258"))
-        codecName = "Windows-1258";
-    else if (charSet == QLatin1String("WIN1258"))
-        codecName = "Windows-1258";
-
     Q_D(QFBDriver);
-    if (codecName.isEmpty())
-        d->textCodec = QTextCodec::codecForName(charSet.toLatin1()); //try codec with charSet
-    else
-        d->textCodec = QTextCodec::codecForName(codecName);
+    d->textCodec = qFBCodecForCharSet(charSet);
 
-    if (!d->textCodec)
-        d->textCodec = QTextCodec::codecForLocale(); //if unknown set locale
+    d->scrollableCursors = options.scrollableCursors;
+    d->typedArrays = options.typedArrays;
+    d->timeText = options.timeText;
+    if (options.slowQueryMs >= 0)
+        d->slowQueryMs = options.slowQueryMs;
+    if (!options.slowQueryLog.isEmpty())
+        d->slowQueryLog = options.slowQueryLog;
 
     try
     {
@@ -1142,11 +3204,12 @@ bool QFBDriver::open(const QString & db,
                                       db.toStdString(),
                                       user.toStdString(),
                                       password.toStdString(),
-                                      role.toStdString(),
+                                      options.role.toStdString(),
                                       charSet.toStdString(),
                                       "");
 
         d->iDb->Connect();
+        d->activityValid = false;
 
     }
     catch (IBPP::Exception& e)
@@ -1156,6 +3219,14 @@ bool QFBDriver::open(const QString & db,
         return false;
     }
 
+    // The cursors are opened through the OO API of the client library
+    if (d->scrollableCursors && !d->iDb->OOApiActive())
+    {
+        qWarning("QFBDriver::open: scrollable cursors are not available with this client library");
+        d->scrollableCursors = false;
+    }
+
+    qFBMetricsAttachments(1, false);
     setOpen(true);
     return true;
 }
@@ -1177,6 +3248,11 @@ void QFBDriver::close()
         d->setError("Unable to disconnect", e, QSqlError::ConnectionError);
         return;
     }
+    // The server rolled back the transactions still started
+    qFBMetricsAttachments(-1, false);
+    qFBMetricsTransactions(-d->iL.count());
+    d->iL.clear();
+    d->iTr.clear();
     setOpen(false);
     setOpenError(false);
 }
@@ -1202,6 +3278,7 @@ bool QFBDriver::beginTransaction()
     {
         d->checkTransactionArguments();
         d->iTr = IBPP::TransactionFactory(d->iDb, d->tam, d->til, d->tlr, d->tff);
+        d->activityValid = false;
         d->iTr->Start();
     }
     catch (IBPP::Exception& e)
@@ -1212,6 +3289,7 @@ bool QFBDriver::beginTransaction()
     }
 
     d->iL.push_back(d->iTr);
+    qFBMetricsTransactions(1);
     if (d->iL.count() > 1)
         qWarning("QFBDriver::transaction : Start transactions  %d.",d->iL.count());
 
@@ -1228,6 +3306,7 @@ bool QFBDriver::commitTransaction()
 
     try
     {
+        d->activityValid = false;
         d->iTr->Commit();
     }
     catch (IBPP::Exception& e)
@@ -1238,6 +3317,7 @@ bool QFBDriver::commitTransaction()
 
     d->iTr.clear();
     d->iL.removeLast ();
+    qFBMetricsTransactions(-1);
     if (!d->iL.isEmpty())
     {
         d->iTr = d->iL.last();
@@ -1256,6 +3336,7 @@ bool QFBDriver::rollbackTransaction()
 
     try
     {
+        d->activityValid = false;
         d->iTr->Rollback();
     }
     catch (IBPP::Exception& e)
@@ -1266,6 +3347,7 @@ bool QFBDriver::rollbackTransaction()
 
     d->iTr.clear();
     d->iL.removeLast ();
+    qFBMetricsTransactions(-1);
     if (!d->iL.isEmpty())
     {
         d->iTr = d->iL.last();
@@ -1413,3 +3495,333 @@ QVariant QFBDriver::handle() const
     return QVariant(qRegisterMetaType<IBPP::IDatabase *>("ibbp_db_handle"), d->iDb.intf());
 }
 //-----------------------------------------------------------------------//
+void QFBDriver::setStatisticsEnabled(bool enable)
+{
+    Q_D(QFBDriver);
+    d->statisticsEnabled = enable;
+}
+//-----------------------------------------------------------------------//
+bool QFBDriver::statisticsEnabled() const
+{
+    Q_D(const QFBDriver);
+    return d->statisticsEnabled;
+}
+//-----------------------------------------------------------------------//
+void QFBDriver::setStatisticsCallback(const std::function<void(const QFBStatementStats &)> &callback)
+{
+    Q_D(QFBDriver);
+    d->statisticsCallback = callback;
+}
+//-----------------------------------------------------------------------//
+QFBStatementStats QFBDriver::lastStatistics() const
+{
+    Q_D(const QFBDriver);
+    QMutexLocker locker(&d->statisticsMutex);
+    return d->lastStatistics;
+}
+//-----------------------------------------------------------------------//
+QFBStatementStats QFBDriver::totalStatistics() const
+{
+    Q_D(const QFBDriver);
+    QMutexLocker locker(&d->statisticsMutex);
+    return d->totalStatistics;
+}
+//-----------------------------------------------------------------------//
+void QFBDriver::resetStatistics()
+{
+    Q_D(QFBDriver);
+    QMutexLocker locker(&d->statisticsMutex);
+    d->lastStatistics = QFBStatementStats();
+    d->totalStatistics = QFBStatementStats();
+}
+//-----------------------------------------------------------------------//
+void QFBDriver::setServerStatisticsEnabled(bool enable)
+{
+    Q_D(QFBDriver);
+    d->serverStatistics = enable;
+}
+//-----------------------------------------------------------------------//
+bool QFBDriver::serverStatisticsEnabled() const
+{
+    Q_D(const QFBDriver);
+    return d->serverStatistics;
+}
+//-----------------------------------------------------------------------//
+void QFBDriver::setSlowQueryThreshold(int msecs)
+{
+    Q_D(QFBDriver);
+    d->slowQueryMs = msecs < 0 ? -1 : msecs;
+}
+//-----------------------------------------------------------------------//
+int QFBDriver::slowQueryThreshold() const
+{
+    Q_D(const QFBDriver);
+    return d->slowQueryMs;
+}
+//-----------------------------------------------------------------------//
+void QFBDriver::setSlowQueryLogFile(const QString &fileName)
+{
+    Q_D(QFBDriver);
+    d->slowQueryLog = fileName;
+}
+//-----------------------------------------------------------------------//
+QString QFBDriver::slowQueryLogFile() const
+{
+    Q_D(const QFBDriver);
+    return d->slowQueryLog;
+}
+//-----------------------------------------------------------------------//
+void QFBDriver::setSlowQueryCallback(const std::function<void(const QFBSlowQuery &)> &callback)
+{
+    Q_D(QFBDriver);
+    d->slowQueryCallback = callback;
+}
+//-----------------------------------------------------------------------//
+void QFBDriver::setFingerprintStatisticsEnabled(bool enable)
+{
+    Q_D(QFBDriver);
+    d->fingerprintStatistics = enable;
+}
+//-----------------------------------------------------------------------//
+bool QFBDriver::fingerprintStatisticsEnabled() const
+{
+    Q_D(const QFBDriver);
+    return d->fingerprintStatistics;
+}
+//-----------------------------------------------------------------------//
+static bool qFBByTotalTime(const QFBFingerprintStats &a, const QFBFingerprintStats &b)
+{
+    return a.totalNs > b.totalNs;
+}
+
+QList<QFBFingerprintStats> QFBDriver::fingerprintStatistics() const
+{
+    Q_D(const QFBDriver);
+    QList<QFBFingerprintStats> list;
+    {
+        QMutexLocker locker(&d->fingerprintMutex);
+        for (QHash<QString, QFBFingerprintEntry *>::const_iterator it = d->fingerprints.constBegin();
+             it != d->fingerprints.constEnd(); ++it)
+            list.append(it.value()->snapshot());
+    }
+    std::sort(list.begin(), list.end(), qFBByTotalTime);
+    return list;
+}
+//-----------------------------------------------------------------------//
+// The entries are zeroed, not freed: the queries may hold them
+void QFBDriver::resetFingerprintStatistics()
+{
+    Q_D(QFBDriver);
+    QMutexLocker locker(&d->fingerprintMutex);
+    for (QHash<QString, QFBFingerprintEntry *>::const_iterator it = d->fingerprints.constBegin();
+         it != d->fingerprints.constEnd(); ++it)
+        it.value()->reset();
+}
+//-----------------------------------------------------------------------//
+// Characters of the unquoted identifiers and keywords
+static inline bool qFBIsWordChar(QChar c)
+{
+    return c.isLetterOrNumber() || c == QLatin1Char('_') || c == QLatin1Char('$');
+}
+
+static inline bool qFBIsOneOf(QChar c, const char *chars)
+{
+    return c.unicode() > 0 && c.unicode() < 128 && strchr(chars, char(c.unicode()));
+}
+
+// Index just past the quoted text starting at i, doubled quotes included
+static int qFBSkipQuoted(const QString &sql, int i)
+{
+    const QChar quote = sql.at(i);
+    const int n = sql.length();
+    for (++i; i < n; ++i)
+    {
+        if (sql.at(i) != quote)
+            continue;
+        if (i + 1 < n && sql.at(i + 1) == quote)
+            ++i;
+        else
+            return i + 1;
+    }
+    return n;
+}
+
+QString QFBDriver::fingerprint(const QString &query)
+{
+    enum Token { None, Word, Value, Open, Close, Comma, Dot, Operator };
+
+    const int n = query.length();
+    QString out;
+    out.reserve(n);
+    QVector<int> opens;     // Positions in out of the open parentheses
+    Token last = None;
+
+    // One space between tokens, none inside parentheses, before a comma or
+    // around a dot, and none between a word and its parenthesis
+    auto put = [&](Token token) {
+        if (last != None && last != Open && last != Dot
+                && token != Close && token != Comma && token != Dot
+                && !(token == Open && last == Word))
+            out += QLatin1Char(' ');
+        last = token;
+    };
+
+    int i = 0;
+    while (i < n)
+    {
+        const QChar c = query.at(i);
+        const QChar next = i + 1 < n ? query.at(i + 1) : QChar();
+
+        if (c.isSpace())
+        {
+            ++i;
+        }
+        else if (c == QLatin1Char('-') && next == QLatin1Char('-'))
+        {
+            i = query.indexOf(QLatin1Char('\n'), i);
+            if (i < 0)
+                i = n;
+        }
+        else if (c == QLatin1Char('/') && next == QLatin1Char('*'))
+        {
+            i = query.indexOf(QLatin1String("*/"), i + 2);
+            i = i < 0 ? n : i + 2;
+        }
+        else if (c == QLatin1Char('\''))
+        {
+            i = qFBSkipQuoted(query, i);
+            put(Value);
+            out += QLatin1Char('?');
+        }
+        else if ((c == QLatin1Char('x') || c == QLatin1Char('X')) && next == QLatin1Char('\''))
+        {
+            i = qFBSkipQuoted(query, i + 1);
+            put(Value);
+            out += QLatin1Char('?');
+        }
+        else if ((c == QLatin1Char('q') || c == QLatin1Char('Q')) && next == QLatin1Char('\'')
+                 && i + 2 < n)
+        {
+            // q'{text}': the text ends at the closing delimiter and a quote
+            QChar close = query.at(i + 2);
+            if (close == QLatin1Char('(')) close = QLatin1Char(')');
+            else if (close == QLatin1Char('[')) close = QLatin1Char(']');
+            else if (close == QLatin1Char('{')) close = QLatin1Char('}');
+            else if (close == QLatin1Char('<')) close = QLatin1Char('>');
+            i += 3;
+            while (i < n && !(query.at(i) == close && i + 1 < n && query.at(i + 1) == QLatin1Char('\'')))
+                ++i;
+            i = qMin(i + 2, n);
+            put(Value);
+            out += QLatin1Char('?');
+        }
+        else if (c == QLatin1Char('"'))
+        {
+            const int end = qFBSkipQuoted(query, i);
+            put(Word);
+            out += query.midRef(i, end - i);
+            i = end;
+        }
+        else if (c.isDigit() || (c == QLatin1Char('.') && next.isDigit())
+                 || ((c == QLatin1Char('-') || c == QLatin1Char('+'))
+                     && (next.isDigit() || next == QLatin1Char('.'))
+                     && last != Word && last != Value && last != Close))
+        {
+            // Numbers, with their sign when it can't be an operator
+            if (c == QLatin1Char('-') || c == QLatin1Char('+'))
+                ++i;
+            if (query.at(i) == QLatin1Char('0') && i + 1 < n
+                    && (query.at(i + 1) == QLatin1Char('x') || query.at(i + 1) == QLatin1Char('X')))
+            {
+                i += 2;
+                while (i < n && qFBIsOneOf(query.at(i), "0123456789abcdefABCDEF"))
+                    ++i;
+            }
+            else
+            {
+                while (i < n && (query.at(i).isDigit() || query.at(i) == QLatin1Char('.')))
+                    ++i;
+                if (i + 1 < n && (query.at(i) == QLatin1Char('e') || query.at(i) == QLatin1Char('E')))
+                {
+                    int j = i + 1;
+                    if (query.at(j) == QLatin1Char('-') || query.at(j) == QLatin1Char('+'))
+                        ++j;
+                    if (j < n && query.at(j).isDigit())
+                    {
+                        i = j;
+                        while (i < n && query.at(i).isDigit())
+                            ++i;
+                    }
+                }
+            }
+            put(Value);
+            out += QLatin1Char('?');
+        }
+        else if (c == QLatin1Char('?'))
+        {
+            put(Value);
+            out += c;
+            ++i;
+        }
+        else if (qFBIsWordChar(c) || (c == QLatin1Char(':') && qFBIsWordChar(next)))
+        {
+            // Words, and the :variables of PSQL blocks
+            put(Word);
+            out += c.toUpper();
+            for (++i; i < n && qFBIsWordChar(query.at(i)); ++i)
+                out += query.at(i).toUpper();
+        }
+        else if (c == QLatin1Char('('))
+        {
+            put(Open);
+            opens.append(out.length());
+            out += c;
+            ++i;
+        }
+        else if (c == QLatin1Char(')'))
+        {
+            // A list of two values or more, as in IN (1, 2, 3), becomes (?...)
+            if (!opens.isEmpty())
+            {
+                const int open = opens.takeLast();
+                const int length = out.length() - open - 1;
+                bool list = length >= 4 && (length - 1) % 3 == 0;
+                for (int k = 0; list && k < length; ++k)
+                    list = out.at(open + 1 + k) == QLatin1Char(k % 3 == 0 ? '?' : k % 3 == 1 ? ',' : ' ');
+                if (list)
+                {
+                    out.truncate(open + 1);
+                    out += QLatin1String("?...");
+                }
+            }
+            put(Close);
+            out += c;
+            ++i;
+        }
+        else if (c == QLatin1Char(','))
+        {
+            put(Comma);
+            out += c;
+            ++i;
+        }
+        else if (c == QLatin1Char('.'))
+        {
+            put(Dot);
+            out += c;
+            ++i;
+        }
+        else
+        {
+            // Operators, the comparisons of two characters kept together
+            put(Operator);
+            out += c;
+            ++i;
+            if (i < n && qFBIsOneOf(c, "<>=!^~|") && qFBIsOneOf(query.at(i), "<>=|"))
+            {
+                out += query.at(i);
+                ++i;
+            }
+        }
+    }
+    return out;
+}
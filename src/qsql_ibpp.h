@@ -31,11 +31,18 @@
 #include <qsqldriverplugin.h>
 #include <QtSql/private/qsqlcachedresult_p.h>
 
+#include <QtCore/qdatetime.h>
+#include <QtCore/qvector.h>
+
+#include <functional>
+
 QT_BEGIN_HEADER
 class QFBDriverPrivate;
 class QFBResultPrivate;
 class QFBDriver;
 class QTextCodec;
+class QSqlQuery;
+struct QFBColumnBatch;
 
 class QFBDriverPlugin : public QSqlDriverPlugin
 {
@@ -61,17 +68,205 @@ public:
     bool exec() Q_DECL_OVERRIDE;
     QVariant handle() const Q_DECL_OVERRIDE;
 
+    // Fetches the next rows of an executed SELECT, at most maxRows, column by
+    // column into batch, whose vectors are reused from call to call. Returns
+    // false when no row was left, or on error (lastError()). The rows are
+    // taken from the cursor: next() goes on after them, and does not see
+    // them. The static version is for the QSqlQuery of a QFIREBIRD database.
+    bool fetchColumns(QFBColumnBatch &batch, int maxRows = 65536);
+    static bool fetchColumns(QSqlQuery &query, QFBColumnBatch &batch, int maxRows = 65536);
+
 protected:
     bool gotoNext(QSqlCachedResult::ValueCache& row, int rowIdx) Q_DECL_OVERRIDE;
     bool reset (const QString& query) Q_DECL_OVERRIDE;
     int size() Q_DECL_OVERRIDE;
     bool isNull(int field) Q_DECL_OVERRIDE;
+    QVariant data(int field) Q_DECL_OVERRIDE;
+    bool fetch(int i) Q_DECL_OVERRIDE;
+    bool fetchNext() Q_DECL_OVERRIDE;
+    bool fetchPrevious() Q_DECL_OVERRIDE;
+    bool fetchFirst() Q_DECL_OVERRIDE;
+    bool fetchLast() Q_DECL_OVERRIDE;
     int numRowsAffected() Q_DECL_OVERRIDE;
     QSqlRecord record() const Q_DECL_OVERRIDE;
 };
 
 class QSqlResult;
 
+// Heap allocations (malloc, operator new) made by the thread of a query,
+// counted when the driver is built in with CONFIG += fb_alloc_stats
+struct QFBAllocCount
+{
+    QFBAllocCount() : allocations(0), bytes(0) {}
+
+    qint64 allocations;
+    qint64 bytes;           // Sizes asked
+};
+
+// Where one statement execution spent its time, in nanoseconds, and how much
+// it read. A SELECT is reported when its last row is fetched or when the
+// query is reused or destroyed; prepareNs is given to the first execution
+// after prepare(). Summed by QFBDriver::totalStatistics(), with executions
+// counting the statements.
+// With setServerStatisticsEnabled(), the page fetches, reads, writes and
+// marks and the table reads are the changes of the attachment counters
+// during the execution (other statements run meanwhile on the connection
+// are counted too), the records are those of the statement.
+// Built with fb_alloc_stats, the allocations of each phase are counted too.
+struct QFBStatementStats
+{
+    QFBStatementStats()
+        : executions(0), prepareNs(0), bindNs(0), executeNs(0), fetchNs(0),
+          decodeNs(0), blobNs(0), rows(0), bytesDecoded(0), blobBytes(0), failed(false),
+          serverCounters(false), pageFetches(0), pageReads(0), pageWrites(0), pageMarks(0),
+          indexedReads(0), sequentialReads(0), recordsSelected(0), recordsInserted(0),
+          recordsUpdated(0), recordsDeleted(0), allocCounters(false)
+    {}
+
+    qint64 totalNs() const
+    { return prepareNs + bindNs + executeNs + fetchNs + decodeNs + blobNs; }
+
+    QString query;
+    qint64 executions;
+    qint64 prepareNs;       // isc_dsql_prepare and the descriptors
+    qint64 bindNs;          // Conversion of the bound values
+    qint64 executeNs;       // Execution on the server
+    qint64 fetchNs;         // Row fetches on the server
+    qint64 decodeNs;        // Conversion of the rows to QVariant, blobs excluded
+    qint64 blobNs;          // Blob reads
+    qint64 rows;
+    qint64 bytesDecoded;    // Column data converted, blobs excluded
+    qint64 blobBytes;
+    bool failed;
+
+    bool serverCounters;    // The fields below were read from the server
+    qint64 pageFetches;
+    qint64 pageReads;       // Physical reads
+    qint64 pageWrites;
+    qint64 pageMarks;
+    qint64 indexedReads;    // Records read through an index
+    qint64 sequentialReads; // Records read in natural order
+    qint64 recordsSelected;
+    qint64 recordsInserted;
+    qint64 recordsUpdated;
+    qint64 recordsDeleted;
+
+    bool allocCounters;     // The fields below were counted (fb_alloc_stats)
+    QFBAllocCount prepareAllocs;
+    QFBAllocCount bindAllocs;
+    QFBAllocCount executeAllocs;
+    QFBAllocCount fetchAllocs;
+    QFBAllocCount decodeAllocs;
+    QFBAllocCount blobAllocs;
+};
+
+// An execution slower than QFBDriver::slowQueryThreshold(): its statistics,
+// a summary of the bound values and the plan of the statement
+struct QFBSlowQuery
+{
+    QDateTime time;         // When it was reported
+    QFBStatementStats statistics;
+    QString parameters;
+    QString plan;
+
+    QString toString() const;
+};
+
+// Distribution of execution times in nanoseconds, in the log-linear buckets
+// of HdrHistogram: the values below 32 ns are exact, the larger ones fall in
+// one of 32 buckets per power of two (at most 3% wide), up to 2^40 ns.
+struct QFBLatencyHistogram
+{
+    enum { SubBuckets = 32, BucketCount = 36 * SubBuckets };
+
+    QFBLatencyHistogram() : count(0), minNs(0), maxNs(0) {}
+
+    static int bucketOf(qint64 ns);
+    static qint64 bucketMaxNs(int bucket);  // Highest value of the bucket
+    // Time within which percent % of the executions ended, 50 for the median
+    qint64 percentile(double percent) const;
+
+    qint64 count;
+    qint64 minNs;
+    qint64 maxNs;
+    QVector<qint64> counts;     // BucketCount counts, empty when count is 0
+};
+
+// Executions of the statements sharing one QFBDriver::fingerprint()
+struct QFBFingerprintStats
+{
+    QFBFingerprintStats() : executions(0), failed(0), rows(0), totalNs(0) {}
+
+    qint64 meanNs() const { return executions ? totalNs / executions : 0; }
+
+    QString fingerprint;
+    QString example;        // Text of the first statement seen
+    qint64 executions;
+    qint64 failed;
+    qint64 rows;
+    qint64 totalNs;         // As QFBStatementStats::totalNs()
+    QFBLatencyHistogram latency;
+};
+
+// One column of a QFBColumnBatch: the value of row r is at index r of the
+// vector of its type, with a 0 (or an empty string) at the NULL rows.
+//   Int64      ints, SMALLINT, INTEGER and BIGINT
+//   Double     doubles, FLOAT, DOUBLE PRECISION and the scaled NUMERIC
+//   Boolean    ints, 0 or 1
+//   Date       ints, Julian day as QDate::toJulianDay()
+//   Time       ints, microseconds since midnight (TIME WITH TIME ZONE at its
+//              zone, as next() gives it)
+//   Timestamp  ints, microseconds since 1970-01-01 00:00; in UTC when utc
+//              (TIMESTAMP WITH TIME ZONE), else in no zone
+//   String     bytes in UTF-8, from offsets[r] to offsets[r + 1]; CHAR,
+//              VARCHAR, text blobs and INT128 and DECFLOAT as text
+//   Binary     bytes as for String; OCTETS strings and the other blobs
+//   Decimal    bytes, 16 per row: the unscaled value as a little endian two's
+//              complement integer (Arrow's decimal128), for the NUMERIC,
+//              DECIMAL and INT128 columns when the batch asks for decimals.
+//              An INT128 value of 39 digits, beyond the 38 of a decimal128,
+//              fails the fetch (such columns are read as String instead)
+//              unless the batch asks for wide decimals.
+// The strings are trimmed as next() trims them.
+struct QFBColumn
+{
+    enum Type { Int64, Double, Boolean, Date, Time, Timestamp, String, Binary, Decimal };
+
+    QFBColumn() : type(Int64), utc(false), precision(0), scale(0), nullCount(0) {}
+
+    bool isNull(int row) const { return !(validity.at(row >> 3) & (1 << (row & 7))); }
+    QByteArray bytesAt(int row) const
+    { return QByteArray(bytes.constData() + offsets.at(row), offsets.at(row + 1) - offsets.at(row)); }
+    QString stringAt(int row) const
+    { return QString::fromUtf8(bytes.constData() + offsets.at(row), offsets.at(row + 1) - offsets.at(row)); }
+
+    QString name;
+    Type type;
+    bool utc;
+    int precision;              // Decimal: 5, 10, 19 or 38 (39 if wide) digits, from the storage size
+    int scale;                  // Decimal: digits after the decimal point
+    int nullCount;
+    QVector<quint8> validity;   // Bit r % 8 of byte r / 8 set when row r is not NULL
+    QVector<qint64> ints;
+    QVector<double> doubles;
+    QVector<qint32> offsets;    // rows + 1 offsets in bytes
+    QByteArray bytes;
+};
+
+// Rows read by QFBResult::fetchColumns(), atEnd once the cursor is exhausted.
+// decimals is set by the caller to get the exact numbers as Decimal columns,
+// wideDecimals too when they may hold every INT128 value (no decimal128).
+struct QFBColumnBatch
+{
+    QFBColumnBatch() : rows(0), atEnd(false), decimals(false), wideDecimals(false) {}
+
+    int rows;
+    bool atEnd;
+    bool decimals;
+    bool wideDecimals;
+    QVector<QFBColumn> columns;
+};
+
 class QFBDriver : public QSqlDriver
 {
     friend class QFBResultPrivate;
@@ -106,6 +301,47 @@ public:
     QString formatValue(const QSqlField &field, bool trimStrings) const Q_DECL_OVERRIDE;
     QVariant handle() const Q_DECL_OVERRIDE;
 
+    // Statement statistics, off by default: when disabled the queries only
+    // test a flag. The callback is called on the thread running the query.
+    void setStatisticsEnabled(bool enable);
+    bool statisticsEnabled() const;
+    void setStatisticsCallback(const std::function<void(const QFBStatementStats &)> &callback);
+    QFBStatementStats lastStatistics() const;
+    QFBStatementStats totalStatistics() const;
+    void resetStatistics();
+    // Adds the server counters to the statistics, at the cost of one
+    // isc_database_info and one isc_dsql_sql_info calls per execution, and
+    // one more isc_database_info when the execution starts a transaction
+    // (autocommit) or follows a fetch or a prepare
+    void setServerStatisticsEnabled(bool enable);
+    bool serverStatisticsEnabled() const;
+
+    // Slow query log, off by default (threshold -1) or set by the
+    // SLOW_QUERY_MS / SLOW_QUERY_LOG connect options. Executions taking at
+    // least msecs are given to the callback when there is one, else appended
+    // to the log file when there is one, else written with qWarning().
+    void setSlowQueryThreshold(int msecs);
+    int slowQueryThreshold() const;
+    void setSlowQueryLogFile(const QString &fileName);
+    QString slowQueryLogFile() const;
+    void setSlowQueryCallback(const std::function<void(const QFBSlowQuery &)> &callback);
+
+    // Statistics by fingerprint, off by default: the statements prepared
+    // while enabled are grouped by fingerprint(), each with a histogram of
+    // its execution times. The queries record them without lock, and
+    // fingerprintStatistics() may be called from any thread; it returns them
+    // by decreasing total time. Past 1000 fingerprints the new ones are
+    // counted together as "(other)".
+    void setFingerprintStatisticsEnabled(bool enable);
+    bool fingerprintStatisticsEnabled() const;
+    QList<QFBFingerprintStats> fingerprintStatistics() const;
+    void resetFingerprintStatistics();
+    // The query without comments and literals (replaced by ?), lists of
+    // values collapsed to (?...), words in upper case and one space between
+    // tokens: "select * from T where ID in (1, 2,3)" gives
+    // "SELECT * FROM T WHERE ID IN(?...)"
+    static QString fingerprint(const QString &query);
+
 //TODO
 //    QString escapeIdentifier(const QString &identifier, IdentifierType type) const Q_DECL_OVERRIDE;
 
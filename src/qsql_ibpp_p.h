@@ -0,0 +1,186 @@
+/*
+* This file is part of QtFirebirdIBPPSQLDriver - Qt SQL driver for Firebird with IBPP library
+* Copyright (C) 2006-2010 Alex Wencel
+*
+* Contact e-mail: Alex Wencel <alex.wencel@gmail.com>
+* Program URL   : http://code.google.com/p/qtfirebirdibppsqldriver
+*
+* GNU Lesser General Public License Usage
+* This file may be used under the terms of the GNU Lesser
+* General Public License version 2.1 as published by the Free Software
+* Foundation and appearing in the file LICENSE.LGPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU Lesser General Public License version 2.1 requirements
+* will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+*
+* GNU General Public License Usage
+* Alternatively, this file may be used under the terms of the GNU
+* General Public License version 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU General Public License version 3.0 requirements will be
+* met: http://www.gnu.org/copyleft/gpl.html.
+*
+*/
+
+#ifndef QSQL_IBPP_P_H
+#define QSQL_IBPP_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the driver API. It is shared by QFBResult and
+// the helper classes built on top of it (QFBAsyncQuery, ...) and may
+// change from version to version without notice.
+//
+
+#include <QtCore/qmutex.h>
+#include <QtCore/qqueue.h>
+#include <QtCore/qstring.h>
+#include <QtCore/qvariant.h>
+#include <QtCore/qvector.h>
+#include <QtCore/qwaitcondition.h>
+#include <QtSql/qsqldatabase.h>
+#include <QtSql/qsqlerror.h>
+#include <QtSql/qsqlrecord.h>
+
+#include "ibpp.h"
+#include "qfbasyncquery.h"
+
+class QTextCodec;
+struct QFBAllocCount;
+struct QFBColumnBatch;
+struct QFBStatementStats;
+
+// Connection attributes parsed from QSqlDatabase::connectOptions()
+struct QFBConnectOptions
+{
+    QFBConnectOptions()
+        : charSet(QLatin1String("NONE")), scrollableCursors(false), typedArrays(false),
+          timeText(false), slowQueryMs(-1)
+    {}
+
+    QString charSet;
+    QString role;
+    bool scrollableCursors; // SCROLLABLE_CURSORS
+    bool typedArrays;       // ARRAY_VECTORS
+    bool timeText;          // TIME_TEXT
+    int slowQueryMs;        // SLOW_QUERY_MS, -1 if not set
+    QString slowQueryLog;   // SLOW_QUERY_LOG
+};
+
+bool qFBParseConnectOptions(const QString &connOpts, QFBConnectOptions &options);
+QTextCodec *qFBCodecForCharSet(const QString &charSet);
+
+// Parameters of a QSqlDatabase, used to open additional attachments
+struct QFBConnectionParams
+{
+    QFBConnectionParams() {}
+    explicit QFBConnectionParams(const QSqlDatabase &db);
+
+    QString host;
+    QString dbName;
+    QString user;
+    QString password;
+    QString connOpts;
+};
+
+// Opens a new attachment in db, releasing the one db held (a disconnected
+// one too); textCodec is set from its CHARSET option.
+bool qFBAttach(const QFBConnectionParams &params, IBPP::Database &db,
+               QTextCodec *&textCodec, QSqlError &error);
+void qFBDetach(IBPP::Database &db);
+
+std::string qFBToIBPPStr(const QString &s, const QTextCodec *textCodec);
+
+// Binds values to the statement parameters (1..values.count()) with the
+// non-throwing IBPP accessors. False is returned, and error set, on a
+// parameter mismatch or a value the parameter can't take. Blob and array
+// I/O exceptions are passed to the caller.
+bool qFBBindValues(IBPP::Statement &st, const QVector<QVariant> &values,
+                   const QTextCodec *textCodec, QSqlError &error);
+
+// Array objects of the columns of a result set, indexed by column: each one
+// is described on the first value of its column and reused for the next
+// rows. Cleared when the execution, or its transaction, ends.
+typedef QVector<IBPP::Array> QFBArrayCache;
+
+// Conversions of qFBFetchRow() set by the connect options
+enum QFBFetchOption
+{
+    QFBTypedArrays = 0x1,   // ARRAY_VECTORS: one dimension numeric arrays come
+                            // as QVector<qint32>, QVector<qint64>, QVector<float>
+                            // or QVector<double> instead of QVariantList
+    QFBTimeText = 0x2       // TIME_TEXT: TIME and TIMESTAMP come as ISO 8601
+                            // text with their four fraction digits
+};
+
+// Converts the current row of st into values[0..Columns()-1], options being
+// QFBFetchOption flags. Blob and array columns are read with db and tr,
+// their I/O exceptions are passed to the caller. A non null stats gets the
+// bytes decoded and the blob bytes, time and allocations added. Without
+// arrays, an array value is described on its own.
+void qFBFetchRow(IBPP::Database &db, IBPP::Transaction &tr, IBPP::Statement &st,
+                 QVariant *values, const QTextCodec *textCodec, int options = 0,
+                 QFBStatementStats *stats = 0, QFBArrayCache *arrays = 0);
+
+// Fetches the next rows of st, at most maxRows, into batch as told by
+// QFBResult::fetchColumns(). False is returned, and error set, when a column
+// is an array; the IBPP exceptions are passed to the caller. A non null stats
+// gets the fetch time, the bytes decoded and the blob bytes and time added.
+bool qFBFetchColumns(IBPP::Database &db, IBPP::Transaction &tr, IBPP::Statement &st,
+                     QFBColumnBatch &batch, int maxRows, const QTextCodec *textCodec,
+                     QSqlError &error, QFBStatementStats *stats = 0);
+
+QSqlRecord qFBRecord(const IBPP::Statement &st);
+
+// Queue of a QFBRowStream, shared by the stream and the worker filling it
+// (push() and finish()), so that the worker outlives a deleted stream. The
+// worker marks with setBusy() the attachment of the server calls cancel()
+// may interrupt; push() unmarks it while it waits for the consumer.
+class QFBRowStreamPrivate
+{
+public:
+    explicit QFBRowStreamPrivate(int maxPendingBatches)
+        : stream(0), maxPending(maxPendingBatches), canceled(false),
+          done(false), busy(0), raised(false)
+    {}
+
+    bool push(const QFBRowBatch &batch);    // false once canceled
+    void finish();
+    void cancel();
+    bool isCanceled() const;
+
+    void setBusy(IBPP::IDatabase *db);
+    bool cancelRaised() const;              // the server was asked to stop
+
+public:
+    mutable QMutex mutex;                   // guards the members below
+    QWaitCondition notFull;
+    QWaitCondition notEmpty;
+    QQueue<QFBRowBatch> queue;
+    QFBRowStream *stream;                   // null once deleted
+    int maxPending;
+    bool canceled;
+    bool done;
+    IBPP::IDatabase *busy;
+    bool raised;
+};
+
+// Allocations of the calling thread since it started (qfballoc.cpp). Only
+// counted when built with fb_alloc_stats, qFBAllocCounting() tells.
+bool qFBAllocCounting();
+QFBAllocCount qFBAllocations();
+
+// Process wide metrics rendered by QFBMetrics. The attachments (helper: of
+// qFBAttach()), transactions and errors are always counted, the statements
+// only while qFBMetricsEnabled(). sqlCode is 0 for the non SQL errors.
+bool qFBMetricsEnabled();
+void qFBMetricsAttachments(int delta, bool helper);
+void qFBMetricsTransactions(int delta);
+void qFBMetricsPrepared();
+void qFBMetricsExecuted(const QFBStatementStats &stats, bool reused);
+void qFBMetricsError(int sqlCode);
+
+#endif // QSQL_IBPP_P_H
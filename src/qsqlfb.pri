@@ -0,0 +1,40 @@
+# Driver sources, shared by the plugin project and by applications that
+# build the driver in directly to use its extensions (QFBAsyncQuery, ...).
+DEPENDPATH += $$PWD
+INCLUDEPATH += $$PWD \
+    $$PWD/..    # moc looks up sqlfb.json from here
+
+HEADERS += $$PWD/qsql_ibpp.h \
+    $$PWD/qsql_ibpp_p.h \
+    $$PWD/qfbasyncquery.h \
+    $$PWD/qfbparallelquery.h \
+    $$PWD/qfbbulkloader.h \
+    $$PWD/qfbarrowexport.h \
+    $$PWD/qfbcsvexport.h \
+    $$PWD/qfbmetrics.h
+
+SOURCES += $$PWD/qsql_ibpp.cpp \
+    $$PWD/qfbasyncquery.cpp \
+    $$PWD/qfbparallelquery.cpp \
+    $$PWD/qfbbulkloader.cpp \
+    $$PWD/qfbarrowexport.cpp \
+    $$PWD/qfbcsvexport.cpp \
+    $$PWD/qfbmetrics.cpp \
+    $$PWD/qfballoc.cpp
+
+# CONFIG += fb_alloc_stats counts the heap allocations of each phase of the
+# statements (QFBStatementStats). It replaces malloc (glibc) or operator new
+# of the whole program, so it is meant for programs building the driver in.
+fb_alloc_stats{
+  DEFINES += QFB_ALLOC_STATS
+}
+
+# CONFIG += fb_metrics_server adds QFBMetricsServer (qfbmetricsserver.h),
+# which serves QFBMetrics::render() over HTTP. It needs the QtNetwork module.
+fb_metrics_server{
+  QT += network
+  HEADERS += $$PWD/qfbmetricsserver.h
+  SOURCES += $$PWD/qfbmetricsserver.cpp
+}
+
+include($$PWD/../ibpp2531/ibpp.pri) # +=   IBPP
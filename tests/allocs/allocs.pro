@@ -0,0 +1,18 @@
+# Allocation budgets of the fetch path: runs SELECTs per column type on the
+# mock client library and fails when a fetched row allocates more than its
+# budget. Built in the allocation accounting mode (fb_alloc_stats).
+# Usage: allocs [rows]
+QT += core sql sql-private core-private
+QT -= gui
+CONFIG += console fb_mock fb_alloc_stats
+CONFIG -= app_bundle
+TEMPLATE = app
+TARGET = allocs
+
+DEFINES += QT_NO_CAST_TO_ASCII \
+    QT_NO_CAST_FROM_ASCII
+
+INCLUDEPATH += ../fbmock
+
+SOURCES += main.cpp
+include(../../src/qsqlfb.pri) # +=   driver, IBPP
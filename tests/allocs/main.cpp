@@ -0,0 +1,135 @@
+/*
+* This file is part of QtFirebirdIBPPSQLDriver - Qt SQL driver for Firebird with IBPP library
+* Copyright (C) 2006-2010 Alex Wencel
+*
+* Contact e-mail: Alex Wencel <alex.wencel@gmail.com>
+* Program URL   : http://code.google.com/p/qtfirebirdibppsqldriver
+*
+* GNU Lesser General Public License Usage
+* This file may be used under the terms of the GNU Lesser
+* General Public License version 2.1 as published by the Free Software
+* Foundation and appearing in the file LICENSE.LGPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU Lesser General Public License version 2.1 requirements
+* will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+*
+* GNU General Public License Usage
+* Alternatively, this file may be used under the terms of the GNU
+* General Public License version 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU General Public License version 3.0 requirements will be
+* met: http://www.gnu.org/copyleft/gpl.html.
+*
+*/
+
+// Allocation budgets of the fetch path. Every column type is fetched from the
+// mock client library with the statement statistics on, and the allocations
+// of the fetch and decode phases divided by the rows fetched are compared
+// with the budget of the type: a change adding a heap allocation per row to
+// the fetch path makes this program fail.
+
+#include <QtDebug>
+#include <QCoreApplication>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStringList>
+
+#include "fbmock.h"
+#include "qsql_ibpp.h"
+
+static bool failed = false;
+
+static void fail(const QString &what)
+{
+    failed = true;
+    qWarning("allocs: %s", what.toLocal8Bit().constData());
+}
+
+//-----------------------------------------------------------------------//
+struct AllocBudget
+{
+    const char *name;
+    const char *columns;
+    double allocsPerRow;
+};
+
+// QVariant holds the fixed-size types in place; QDateTime has a shared
+// private part, a VARCHAR allocates the std::string of IBPP, the QString
+// and its QVariant copy.
+static const AllocBudget budgets[] =
+{
+    { "integer",   "INTEGER",          0 },
+    { "bigint",    "BIGINT",           0 },
+    { "double",    "DOUBLE PRECISION", 0 },
+    { "numeric",   "NUMERIC(18,4)",    0 },
+    { "date",      "DATE",             0 },
+    { "timestamp", "TIMESTAMP",        1 },
+    { "varchar",   "VARCHAR(40)",      3 },
+    { "all",       "INTEGER,BIGINT,DOUBLE PRECISION,NUMERIC(18,4),DATE,TIMESTAMP,VARCHAR(40)", 4 }
+};
+
+static void checkBudget(QFBDriver &driver, const AllocBudget &budget, int rows)
+{
+    if (fbmock_configure(budget.columns, rows, -1) != 0)
+    {
+        fail(QString::fromLatin1("%1: bad columns").arg(QLatin1String(budget.name)));
+        return;
+    }
+
+    QSqlQuery q(driver.createResult());
+    q.setForwardOnly(true);
+    if (!q.exec(QLatin1String("SELECT * FROM T")))
+    {
+        fail(QString::fromLatin1("%1: %2").arg(QLatin1String(budget.name), q.lastError().text()));
+        return;
+    }
+    while (q.next())
+        q.value(0);
+    q.finish();
+
+    const QFBStatementStats stats = driver.lastStatistics();
+    if (!stats.allocCounters)
+    {
+        fail(QLatin1String("the driver was not built with CONFIG += fb_alloc_stats"));
+        return;
+    }
+    if (stats.rows != rows)
+    {
+        fail(QString::fromLatin1("%1: %2 rows, expected %3")
+             .arg(QLatin1String(budget.name)).arg(stats.rows).arg(rows));
+        return;
+    }
+
+    const double perRow = double(stats.fetchAllocs.allocations + stats.decodeAllocs.allocations) / rows;
+    const double bytesPerRow = double(stats.fetchAllocs.bytes + stats.decodeAllocs.bytes) / rows;
+    qDebug("%-10s %8.2f allocations/row %10.1f bytes/row (budget %g)",
+           budget.name, perRow, bytesPerRow, budget.allocsPerRow);
+    if (perRow > budget.allocsPerRow)
+        fail(QString::fromLatin1("%1: %2 allocations per row, budget %3")
+             .arg(QLatin1String(budget.name)).arg(perRow).arg(budget.allocsPerRow));
+}
+//-----------------------------------------------------------------------//
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    const int rows = args.value(1, QLatin1String("10000")).toInt();
+
+    QFBDriver driver;
+    if (!driver.open(QLatin1String("allocs.fdb"), QLatin1String("SYSDBA"), QLatin1String("masterkey"),
+                     QString(), 0, QLatin1String("CHARSET=UTF8")))
+    {
+        fail(QLatin1String("open: ") + driver.lastError().text());
+        return 1;
+    }
+    driver.setStatisticsEnabled(true);
+
+    driver.beginTransaction();
+    for (size_t i = 0; i < sizeof(budgets) / sizeof(budgets[0]); ++i)
+        checkBudget(driver, budgets[i], rows);
+    driver.commitTransaction();
+    driver.close();
+
+    return failed ? 1 : 0;
+}
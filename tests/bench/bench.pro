@@ -0,0 +1,15 @@
+# Throughput benchmark: creates a scratch database, measures the driver
+# (fetch by column type, inserts, prepare, blobs, transactions) and drops it.
+# Usage: bench <new database file> [user] [password] [rows] [-o results.json]
+QT += core sql sql-private core-private
+QT -= gui
+CONFIG += console
+CONFIG -= app_bundle
+TEMPLATE = app
+TARGET = bench
+
+DEFINES += QT_NO_CAST_TO_ASCII \
+    QT_NO_CAST_FROM_ASCII
+
+SOURCES += main.cpp
+include(../../src/qsqlfb.pri) # +=   driver, IBPP
@@ -0,0 +1,503 @@
+/*
+* This file is part of QtFirebirdIBPPSQLDriver - Qt SQL driver for Firebird with IBPP library
+* Copyright (C) 2006-2010 Alex Wencel
+*
+* Contact e-mail: Alex Wencel <alex.wencel@gmail.com>
+* Program URL   : http://code.google.com/p/qtfirebirdibppsqldriver
+*
+* GNU Lesser General Public License Usage
+* This file may be used under the terms of the GNU Lesser
+* General Public License version 2.1 as published by the Free Software
+* Foundation and appearing in the file LICENSE.LGPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU Lesser General Public License version 2.1 requirements
+* will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+*
+* GNU General Public License Usage
+* Alternatively, this file may be used under the terms of the GNU
+* General Public License version 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU General Public License version 3.0 requirements will be
+* met: http://www.gnu.org/copyleft/gpl.html.
+*
+*/
+
+// Throughput benchmark of the driver. A scratch database is created, filled
+// and dropped; every measure is printed and written as JSON so that runs
+// before and after a change can be compared by a script.
+
+#include <QtDebug>
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSqlDatabase>
+#include <QSqlDriverCreator>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QVariantList>
+
+#include <cstdio>
+
+#include "ibpp.h"
+#include "qfbarrowexport.h"
+#include "qfbbulkloader.h"
+#include "qfbcsvexport.h"
+#include "qsql_ibpp.h"
+
+static QString dbName, dbUser, dbPassword;
+static QJsonArray results;
+static bool failed = false;
+
+static void fail(const QString &what)
+{
+    failed = true;
+    qWarning("bench: %s", what.toLocal8Bit().constData());
+}
+
+// Records one measure: value is in unit (rows/s, MB/s, us...)
+static void report(const QString &name, double value, const QString &unit, qint64 count)
+{
+    QJsonObject r;
+    r.insert(QLatin1String("name"), name);
+    r.insert(QLatin1String("value"), value);
+    r.insert(QLatin1String("unit"), unit);
+    r.insert(QLatin1String("count"), count);
+    results.append(r);
+    qDebug("%-28s %14.2f %s", name.toLatin1().constData(), value, unit.toLatin1().constData());
+}
+
+static double perSecond(qint64 count, qint64 nsecs)
+{
+    return nsecs > 0 ? count * 1e9 / nsecs : 0.0;
+}
+
+//-----------------------------------------------------------------------//
+// Creates the scratch database and its tables through IBPP
+static bool createDatabase()
+{
+    try
+    {
+        IBPP::Database db = IBPP::DatabaseFactory("", dbName.toStdString(),
+                                                  dbUser.toStdString(), dbPassword.toStdString(),
+                                                  "", "UTF8",
+                                                  "PAGE_SIZE 16384 DEFAULT CHARACTER SET UTF8");
+        db->Create(3);
+        db->Connect();
+
+        IBPP::Transaction tr = IBPP::TransactionFactory(db);
+        tr->Start();
+        IBPP::Statement st = IBPP::StatementFactory(db, tr);
+        st->ExecuteImmediate("CREATE TABLE FETCH_T (I INTEGER, L BIGINT, D DOUBLE PRECISION, "
+                             "N NUMERIC(18,4), S VARCHAR(40), TS TIMESTAMP, DT DATE)");
+        st->ExecuteImmediate("CREATE TABLE BATCH_T (I INTEGER, L BIGINT, D DOUBLE PRECISION, "
+                             "N NUMERIC(18,4), S VARCHAR(40), TS TIMESTAMP, DT DATE)");
+        st->ExecuteImmediate("CREATE TABLE BLOB_T (ID INTEGER, DATA BLOB SUB_TYPE 0)");
+        tr->Commit();
+        db->Disconnect();
+    }
+    catch (IBPP::Exception &e)
+    {
+        fail(QLatin1String("create: ") + QString::fromLatin1(e.ErrorMessage()));
+        return false;
+    }
+    return true;
+}
+//-----------------------------------------------------------------------//
+static void dropDatabase()
+{
+    try
+    {
+        IBPP::Database db = IBPP::DatabaseFactory("", dbName.toStdString(),
+                                                  dbUser.toStdString(), dbPassword.toStdString());
+        db->Connect();
+        db->Drop();
+    }
+    catch (IBPP::Exception &e)
+    {
+        fail(QLatin1String("drop: ") + QString::fromLatin1(e.ErrorMessage()));
+    }
+}
+//-----------------------------------------------------------------------//
+static QVariantList rowValues(int i)
+{
+    static const QDateTime base(QDate(2020, 1, 1), QTime(0, 0));
+    const QDateTime ts = base.addMSecs(qint64(i) * 1000 + i % 1000);
+    return QVariantList() << i << qint64(i) * 1000003 << i * 0.5 << i / 16.0
+                          << QString::fromLatin1("row %1").arg(i) << ts << ts.date();
+}
+//-----------------------------------------------------------------------//
+static void benchTransactions(QFBDriver &driver, int count)
+{
+    QElapsedTimer t;
+    t.start();
+    for (int i = 0; i < count; ++i)
+    {
+        if (!driver.beginTransaction() || !driver.commitTransaction())
+        {
+            fail(QLatin1String("transaction: ") + driver.lastError().text());
+            return;
+        }
+    }
+    report(QLatin1String("transaction_start_commit"), t.nsecsElapsed() / 1000.0 / count,
+           QLatin1String("us"), count);
+}
+//-----------------------------------------------------------------------//
+static void benchPrepare(QFBDriver &driver, int count)
+{
+    driver.beginTransaction();
+    QElapsedTimer t;
+    t.start();
+    for (int i = 0; i < count; ++i)
+    {
+        QSqlQuery q(driver.createResult());
+        if (!q.prepare(QLatin1String("SELECT I, L, D, N, S, TS, DT FROM FETCH_T WHERE I = ?")))
+        {
+            fail(QLatin1String("prepare: ") + q.lastError().text());
+            break;
+        }
+    }
+    report(QLatin1String("prepare_latency"), t.nsecsElapsed() / 1000.0 / count,
+           QLatin1String("us"), count);
+    driver.commitTransaction();
+}
+//-----------------------------------------------------------------------//
+static void benchInsert(QFBDriver &driver, int rows)
+{
+    driver.beginTransaction();
+    {
+        QSqlQuery q(driver.createResult());
+        q.prepare(QLatin1String("INSERT INTO FETCH_T (I, L, D, N, S, TS, DT) VALUES (?, ?, ?, ?, ?, ?, ?)"));
+        QElapsedTimer t;
+        t.start();
+        for (int i = 0; i < rows; ++i)
+        {
+            const QVariantList v = rowValues(i);
+            for (int c = 0; c < v.count(); ++c)
+                q.bindValue(c, v.at(c));
+            if (!q.exec())
+            {
+                fail(QLatin1String("insert: ") + q.lastError().text());
+                break;
+            }
+        }
+        report(QLatin1String("insert_single"), perSecond(rows, t.nsecsElapsed()),
+               QLatin1String("rows/s"), rows);
+    }
+    driver.commitTransaction();
+
+    // The same rows, one list per column
+    QVector<QVariantList> columns(7);
+    for (int i = 0; i < rows; ++i)
+    {
+        const QVariantList v = rowValues(i);
+        for (int c = 0; c < v.count(); ++c)
+            columns[c] << v.at(c);
+    }
+
+    driver.beginTransaction();
+    {
+        QSqlQuery q(driver.createResult());
+        q.prepare(QLatin1String("INSERT INTO BATCH_T (I, L, D, N, S, TS, DT) VALUES (?, ?, ?, ?, ?, ?, ?)"));
+        for (int c = 0; c < columns.count(); ++c)
+            q.addBindValue(columns.at(c));
+        QElapsedTimer t;
+        t.start();
+        if (!q.execBatch())
+            fail(QLatin1String("insert batch: ") + q.lastError().text());
+        report(QLatin1String("insert_batch"), perSecond(rows, t.nsecsElapsed()),
+               QLatin1String("rows/s"), rows);
+    }
+    driver.commitTransaction();
+}
+//-----------------------------------------------------------------------//
+// QFBBulkLoader from CSV and binary rows held in memory
+static void benchBulkLoad(int rows)
+{
+    QSqlDatabase::registerSqlDriver(QLatin1String("QFIREBIRD"), new QSqlDriverCreator<QFBDriver>);
+    QSqlDatabase db = QSqlDatabase::addDatabase(QLatin1String("QFIREBIRD"), QLatin1String("bulk"));
+    db.setDatabaseName(dbName);
+    db.setUserName(dbUser);
+    db.setPassword(dbPassword);
+    db.setConnectOptions(QLatin1String("CHARSET=UTF8"));
+
+    QByteArray csv("I,L,D,N,S,TS,DT\n");
+    QBuffer binary;
+    binary.open(QIODevice::WriteOnly);
+    QDataStream out(&binary);
+    for (int i = 0; i < rows; ++i)
+    {
+        const QVariantList v = rowValues(i);
+        csv += QString::fromLatin1("%1,%2,%3,%4,\"%5\",%6,%7\n")
+                .arg(v.at(0).toInt()).arg(v.at(1).toLongLong()).arg(v.at(2).toDouble(), 0, 'g', 17)
+                .arg(v.at(3).toDouble(), 0, 'g', 17).arg(v.at(4).toString())
+                .arg(v.at(5).toDateTime().toString(QLatin1String("yyyy-MM-dd HH:mm:ss.zzz")))
+                .arg(v.at(6).toDate().toString(Qt::ISODate)).toUtf8();
+        QFBBulkLoader::writeBinaryRow(out, v.toVector());
+    }
+    binary.close();
+
+    {
+        QFBBulkLoader loader(db);
+        loader.setTable(QLatin1String("BATCH_T"));
+        loader.setColumns(QStringList() << QLatin1String("I") << QLatin1String("L")
+                          << QLatin1String("D") << QLatin1String("N") << QLatin1String("S")
+                          << QLatin1String("TS") << QLatin1String("DT"));
+
+        QBuffer input(&csv);
+        input.open(QIODevice::ReadOnly);
+        loader.setHeader(true);
+        QFBBulkLoadResult result = loader.load(&input).result();
+        if (result.error.isValid() || result.rowsLoaded != rows)
+            fail(QString::fromLatin1("bulk load csv: %1 rows, %2 rejected %3")
+                 .arg(result.rowsLoaded).arg(result.rowsRejected).arg(result.error.text()));
+        report(QLatin1String("bulk_load_csv"), result.rowsPerSecond(),
+               QLatin1String("rows/s"), result.rowsLoaded);
+
+        binary.open(QIODevice::ReadOnly);
+        loader.setFormat(QFBBulkLoader::Binary);
+        result = loader.load(&binary).result();
+        if (result.error.isValid() || result.rowsLoaded != rows)
+            fail(QString::fromLatin1("bulk load binary: %1 rows, %2 rejected %3")
+                 .arg(result.rowsLoaded).arg(result.rowsRejected).arg(result.error.text()));
+        report(QLatin1String("bulk_load_binary"), result.rowsPerSecond(),
+               QLatin1String("rows/s"), result.rowsLoaded);
+    }
+
+    db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(QLatin1String("bulk"));
+}
+//-----------------------------------------------------------------------//
+static void benchFetch(QFBDriver &driver, int rows)
+{
+    static const char *const columns[] = { "I", "L", "D", "N", "S", "TS", "DT",
+                                           "I, L, D, N, S, TS, DT" };
+    static const char *const names[] = { "integer", "bigint", "double", "numeric",
+                                         "varchar", "timestamp", "date", "all" };
+
+    driver.beginTransaction();
+    for (size_t c = 0; c < sizeof(columns) / sizeof(columns[0]); ++c)
+    {
+        QSqlQuery q(driver.createResult());
+        q.setForwardOnly(true);
+        QElapsedTimer t;
+        t.start();
+        if (!q.exec(QLatin1String("SELECT ") + QLatin1String(columns[c])
+                    + QLatin1String(" FROM FETCH_T")))
+        {
+            fail(QLatin1String("fetch: ") + q.lastError().text());
+            continue;
+        }
+        qint64 count = 0;
+        while (q.next())
+        {
+            q.value(0);
+            ++count;
+        }
+        if (count != rows)
+            fail(QString::fromLatin1("fetch %1: %2 rows, expected %3")
+                 .arg(QLatin1String(names[c])).arg(count).arg(rows));
+        report(QLatin1String("fetch_") + QLatin1String(names[c]),
+               perSecond(count, t.nsecsElapsed()), QLatin1String("rows/s"), count);
+    }
+
+    // All the columns again, fetched into column vectors
+    QSqlQuery q(driver.createResult());
+    q.setForwardOnly(true);
+    QElapsedTimer t;
+    t.start();
+    if (q.exec(QLatin1String("SELECT I, L, D, N, S, TS, DT FROM FETCH_T")))
+    {
+        QFBColumnBatch batch;
+        qint64 count = 0;
+        while (QFBResult::fetchColumns(q, batch))
+            count += batch.rows;
+        if (q.lastError().isValid())
+            fail(QLatin1String("fetch columns: ") + q.lastError().text());
+        else if (count != rows)
+            fail(QString::fromLatin1("fetch columns: %1 rows, expected %2").arg(count).arg(rows));
+        report(QLatin1String("fetch_columns_all"), perSecond(count, t.nsecsElapsed()),
+               QLatin1String("rows/s"), count);
+    }
+    else
+        fail(QLatin1String("fetch columns: ") + q.lastError().text());
+    driver.commitTransaction();
+}
+//-----------------------------------------------------------------------//
+static void benchExport(QFBDriver &driver, int rows)
+{
+    driver.beginTransaction();
+    QSqlQuery q(driver.createResult());
+    q.setForwardOnly(true);
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QElapsedTimer t;
+    t.start();
+    QFBArrowExporter arrow;
+    if (!q.exec(QLatin1String("SELECT I, L, D, N, S, TS, DT FROM FETCH_T")))
+        fail(QLatin1String("export arrow: ") + q.lastError().text());
+    else if (!arrow.exportQuery(q, &buffer))
+        fail(QLatin1String("export arrow: ") + arrow.lastError().text());
+    else if (arrow.rows() != rows)
+        fail(QString::fromLatin1("export arrow: %1 rows, expected %2").arg(arrow.rows()).arg(rows));
+    else
+        report(QLatin1String("export_arrow"), perSecond(arrow.rows(), t.nsecsElapsed()),
+               QLatin1String("rows/s"), arrow.rows());
+    driver.commitTransaction();
+}
+//-----------------------------------------------------------------------//
+// QFBCsvExporter, on its own connection (QFIREBIRD registered by benchBulkLoad())
+static void benchExportCsv(int rows)
+{
+    QSqlDatabase db = QSqlDatabase::addDatabase(QLatin1String("QFIREBIRD"), QLatin1String("csv"));
+    db.setDatabaseName(dbName);
+    db.setUserName(dbUser);
+    db.setPassword(dbPassword);
+    db.setConnectOptions(QLatin1String("CHARSET=UTF8"));
+
+    {
+        QFBCsvExporter csv(db);
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        const QFBCsvExportResult result =
+            csv.exportQuery(QLatin1String("SELECT I, L, D, N, S, TS, DT FROM FETCH_T"), &buffer).result();
+        if (result.error.isValid())
+            fail(QLatin1String("export csv: ") + result.error.text());
+        else if (result.rows != rows)
+            fail(QString::fromLatin1("export csv: %1 rows, expected %2").arg(result.rows).arg(rows));
+        else
+            report(QLatin1String("export_csv"), result.rowsPerSecond(),
+                   QLatin1String("rows/s"), result.rows);
+    }
+
+    db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(QLatin1String("csv"));
+}
+//-----------------------------------------------------------------------//
+static void benchBlobs(QFBDriver &driver, int count, int size)
+{
+    QByteArray data(size, '\0');
+    for (int i = 0; i < size; ++i)
+        data[i] = char(i * 31 + 7);
+    const double mb = double(count) * size / (1024.0 * 1024.0);
+
+    driver.beginTransaction();
+    {
+        QSqlQuery q(driver.createResult());
+        q.prepare(QLatin1String("INSERT INTO BLOB_T (ID, DATA) VALUES (?, ?)"));
+        QElapsedTimer t;
+        t.start();
+        for (int i = 0; i < count; ++i)
+        {
+            q.bindValue(0, i);
+            q.bindValue(1, data);
+            if (!q.exec())
+            {
+                fail(QLatin1String("blob write: ") + q.lastError().text());
+                break;
+            }
+        }
+        report(QLatin1String("blob_write"), perSecond(1, t.nsecsElapsed()) * mb,
+               QLatin1String("MB/s"), count);
+    }
+    driver.commitTransaction();
+
+    driver.beginTransaction();
+    {
+        QSqlQuery q(driver.createResult());
+        q.setForwardOnly(true);
+        QElapsedTimer t;
+        t.start();
+        q.exec(QLatin1String("SELECT DATA FROM BLOB_T"));
+        int read = 0;
+        while (q.next())
+        {
+            if (q.value(0).toByteArray().size() != size)
+                fail(QLatin1String("blob read: wrong size"));
+            ++read;
+        }
+        if (read != count)
+            fail(QLatin1String("blob read: ") + q.lastError().text());
+        report(QLatin1String("blob_read"), perSecond(1, t.nsecsElapsed()) * mb,
+               QLatin1String("MB/s"), read);
+    }
+    driver.commitTransaction();
+}
+//-----------------------------------------------------------------------//
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+
+    QString output;
+    const int o = args.indexOf(QLatin1String("-o"));
+    if (o > 0 && o + 1 < args.count())
+    {
+        output = args.at(o + 1);
+        args.erase(args.begin() + o, args.begin() + o + 2);
+    }
+
+    if (args.count() < 2)
+    {
+        qWarning("usage: bench <new database file> [user] [password] [rows] [-o results.json]");
+        return 2;
+    }
+
+    dbName = args.at(1);
+    dbUser = args.value(2, QString::fromLocal8Bit(qgetenv("ISC_USER")));
+    dbPassword = args.value(3, QString::fromLocal8Bit(qgetenv("ISC_PASSWORD")));
+    const int rows = args.value(4, QLatin1String("100000")).toInt();
+
+    if (!createDatabase())
+        return 2;
+
+    {
+        QFBDriver driver;
+        if (!driver.open(dbName, dbUser, dbPassword, QString(), 0, QLatin1String("CHARSET=UTF8")))
+        {
+            fail(QLatin1String("open: ") + driver.lastError().text());
+        }
+        else
+        {
+            qDebug("bench: %d rows, client %s", rows,
+                   IBPP::OOApiActive() ? "OO API" : "legacy API");
+            benchTransactions(driver, 1000);
+            benchPrepare(driver, 1000);
+            benchInsert(driver, rows);
+            benchBulkLoad(rows);
+            benchFetch(driver, rows);
+            benchExport(driver, rows);
+            benchExportCsv(rows);
+            benchBlobs(driver, 64, 1024 * 1024);
+            driver.close();
+        }
+    }
+
+    dropDatabase();
+
+    QJsonObject doc;
+    doc.insert(QLatin1String("database"), dbName);
+    doc.insert(QLatin1String("rows"), rows);
+    doc.insert(QLatin1String("date"), QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+    doc.insert(QLatin1String("results"), results);
+    const QByteArray json = QJsonDocument(doc).toJson();
+    if (output.isEmpty())
+    {
+        fputs(json.constData(), stdout);
+    }
+    else
+    {
+        QFile f(output);
+        if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate) || f.write(json) != json.size())
+            fail(QLatin1String("unable to write ") + output);
+    }
+
+    return failed ? 1 : 0;
+}
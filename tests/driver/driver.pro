@@ -0,0 +1,17 @@
+# Server-free checks of the driver: runs queries on the mock client library
+# and compares what comes back with the values it generates.
+# Usage: driver
+QT += core sql sql-private core-private
+QT -= gui
+CONFIG += console fb_mock
+CONFIG -= app_bundle
+TEMPLATE = app
+TARGET = driver
+
+DEFINES += QT_NO_CAST_TO_ASCII \
+    QT_NO_CAST_FROM_ASCII
+
+INCLUDEPATH += ../fbmock
+
+SOURCES += main.cpp
+include(../../src/qsqlfb.pri) # +=   driver, IBPP
@@ -0,0 +1,1404 @@
+/*
+* This file is part of QtFirebirdIBPPSQLDriver - Qt SQL driver for Firebird with IBPP library
+* Copyright (C) 2006-2010 Alex Wencel
+*
+* Contact e-mail: Alex Wencel <alex.wencel@gmail.com>
+* Program URL   : http://code.google.com/p/qtfirebirdibppsqldriver
+*
+* GNU Lesser General Public License Usage
+* This file may be used under the terms of the GNU Lesser
+* General Public License version 2.1 as published by the Free Software
+* Foundation and appearing in the file LICENSE.LGPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU Lesser General Public License version 2.1 requirements
+* will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+*
+* GNU General Public License Usage
+* Alternatively, this file may be used under the terms of the GNU
+* General Public License version 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU General Public License version 3.0 requirements will be
+* met: http://www.gnu.org/copyleft/gpl.html.
+*
+*/
+
+// Server-free checks of the driver. The mock client library answers every
+// SELECT with generated rows of the configured columns (tests/fbmock), the
+// values read through the driver are compared with them and the calls made
+// to the client library are counted with IBPP::TraceCalls().
+
+#include <QtDebug>
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSqlDatabase>
+#include <QSqlDriverCreator>
+#include <QSqlError>
+#include <QSqlField>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QTime>
+#include <QTimeZone>
+#include <QtEndian>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "fbmock.h"
+#include "ibpp.h"
+#include "qfbarrowexport.h"
+#include "qfbasyncquery.h"
+#include "qfbbulkloader.h"
+#include "qfbcsvexport.h"
+#include "qfbmetrics.h"
+#include "qsql_ibpp.h"
+#include "qsql_ibpp_p.h"
+
+static int failures = 0;
+
+static void fail(const QString &what)
+{
+    ++failures;
+    qWarning("driver: %s", what.toLocal8Bit().constData());
+}
+
+static void check(bool ok, const char *what)
+{
+    if (!ok)
+        fail(QLatin1String(what));
+}
+
+// Calls made to an isc_* entry point since the last IBPP::ResetTraceCounts()
+static qint64 calls(const char *name)
+{
+    std::vector<IBPP::TraceCount> counts;
+    IBPP::TraceCounts(counts);
+    for (size_t i = 0; i < counts.size(); ++i)
+        if (counts[i].Name == name)
+            return counts[i].Calls;
+    return 0;
+}
+
+static bool exec(QSqlQuery &q, const char *sql)
+{
+    if (q.exec(QLatin1String(sql)))
+        return true;
+    fail(QString::fromLatin1("%1: %2").arg(QLatin1String(sql), q.lastError().text()));
+    return false;
+}
+
+//-----------------------------------------------------------------------//
+// Array columns: the element j of row r is r + j. The array of a column is
+// described once per execution, the server asked once per transaction, and
+// again after DDL.
+static void checkArrays(QFBDriver &driver)
+{
+    const int rows = 50;
+    fbmock_configure("INTEGER,INTEGER[4]", rows, -1);
+    IBPP::ResetTraceCounts();
+
+    driver.beginTransaction();
+    QSqlQuery q(driver.createResult());
+    q.setForwardOnly(true);
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        if (!exec(q, "SELECT * FROM T"))
+            return;
+        int r = 0;
+        for (; q.next(); ++r)
+        {
+            const QVariantList elems = q.value(1).toList();
+            bool ok = elems.size() == 4;
+            for (int j = 0; ok && j < 4; ++j)
+                ok = elems.at(j).toInt() == r + j;
+            if (!ok)
+            {
+                fail(QString::fromLatin1("arrays: row %1 is wrong").arg(r));
+                break;
+            }
+        }
+        check(r == rows, "arrays: rows missing");
+    }
+    check(calls("isc_array_lookup_bounds") == 1, "arrays: described more than once in a transaction");
+    check(calls("isc_array_get_slice") == 2 * rows, "arrays: one slice per value expected");
+
+    exec(q, "CREATE TABLE A (I INTEGER)");
+    exec(q, "SELECT * FROM T");
+    q.next();
+    check(calls("isc_array_lookup_bounds") == 2, "arrays: descriptor kept after DDL");
+    q.finish();
+    driver.commitTransaction();
+
+    driver.beginTransaction();
+    exec(q, "SELECT * FROM T");
+    q.next();
+    check(calls("isc_array_lookup_bounds") == 3, "arrays: descriptor kept by the next transaction");
+    q.finish();
+    driver.commitTransaction();
+}
+//-----------------------------------------------------------------------//
+// TIME_TEXT: the TIME of column i, row r, is r seconds and i ten-thousandths
+// (tests/fbmock), the fourth fraction digit only comes as text
+static void checkTimeText()
+{
+    const int rows = 50;
+    fbmock_configure("INTEGER,TIME", rows, -1);
+
+    QFBDriver driver;
+    if (!driver.open(QLatin1String("driver.fdb"), QLatin1String("SYSDBA"), QLatin1String("masterkey"),
+                     QString(), 0, QLatin1String("CHARSET=UTF8;TIME_TEXT=1")))
+    {
+        fail(QLatin1String("open TIME_TEXT: ") + driver.lastError().text());
+        return;
+    }
+    QSqlQuery q(driver.createResult());
+    q.setForwardOnly(true);
+    if (!exec(q, "SELECT * FROM T"))
+        return;
+    for (int r = 0; q.next(); ++r)
+    {
+        const QString expected = QString::fromLatin1("00:00:%1.0001").arg(r, 2, 10, QLatin1Char('0'));
+        if (q.value(1).toString() != expected)
+        {
+            fail(QString::fromLatin1("time text: '%1' instead of '%2'")
+                 .arg(q.value(1).toString(), expected));
+            break;
+        }
+    }
+    q.finish();
+
+    // Without the option the value is a QTime, to the millisecond
+    fbmock_configure("INTEGER,TIME", 2, -1);
+    QFBDriver plain;
+    plain.open(QLatin1String("driver.fdb"), QLatin1String("SYSDBA"), QLatin1String("masterkey"),
+               QString(), 0, QLatin1String("CHARSET=UTF8"));
+    QSqlQuery p(plain.createResult());
+    exec(p, "SELECT * FROM T");
+    check(p.next() && p.next() && p.value(1).type() == QVariant::Time
+          && p.value(1).toTime() == QTime(0, 0, 1), "time: QTime expected without TIME_TEXT");
+    p.finish();
+    plain.close();
+    driver.close();
+}
+//-----------------------------------------------------------------------//
+// Server counters: in a transaction, the attachment counters read after an
+// execution are the start of the next one
+static void checkServerStatistics(QFBDriver &driver)
+{
+    const int executions = 10;
+    driver.setStatisticsEnabled(true);
+    driver.setServerStatisticsEnabled(true);
+
+    driver.beginTransaction();
+    QSqlQuery q(driver.createResult());
+    if (!q.prepare(QLatin1String("INSERT INTO T (I) VALUES (1)")))
+    {
+        fail(QLatin1String("prepare INSERT: ") + q.lastError().text());
+        return;
+    }
+    IBPP::ResetTraceCounts();
+    for (int i = 0; i < executions; ++i)
+        if (!q.exec())
+            fail(QLatin1String("exec INSERT: ") + q.lastError().text());
+    check(calls("isc_database_info") == executions + 1,
+          "server statistics: attachment counters read twice per execution");
+    check(calls("isc_dsql_sql_info") == executions,
+          "server statistics: record counts read more than once per execution");
+    const QFBStatementStats last = driver.lastStatistics();
+    check(last.serverCounters && last.recordsInserted == 1,
+          "server statistics: records inserted not counted");
+    q.finish();
+    driver.commitTransaction();
+
+    driver.setServerStatisticsEnabled(false);
+    driver.setStatisticsEnabled(false);
+    driver.resetStatistics();
+}
+//-----------------------------------------------------------------------//
+// Fingerprints: literals, comments and spacing don't matter
+static void checkFingerprint()
+{
+    static const char *const cases[][2] = {
+        { "select * from T where ID in (1, 2,3)", "SELECT * FROM T WHERE ID IN(?...)" },
+        { "SELECT a.NAME, 'it''s' -- note\nFROM t /* x */ WHERE v = -1.5e3 AND w IN (1, 2,3)",
+          "SELECT A.NAME, ? FROM T WHERE V = ? AND W IN(?...)" },
+        { "SELECT A-1 FROM T", "SELECT A - ? FROM T" },
+        { "SELECT * FROM T WHERE ID = ?", "SELECT * FROM T WHERE ID = ?" },
+        { "INSERT INTO T (A, B) VALUES (1, 'a')", "INSERT INTO T(A, B) VALUES(?...)" },
+        { "select \"Mixed\" from t where x <> X'FF'", "SELECT \"Mixed\" FROM T WHERE X <> ?" }
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i)
+    {
+        const QString fp = QFBDriver::fingerprint(QLatin1String(cases[i][0]));
+        if (fp != QLatin1String(cases[i][1]))
+            fail(QString::fromLatin1("fingerprint of '%1': '%2' instead of '%3'")
+                 .arg(QLatin1String(cases[i][0]), fp, QLatin1String(cases[i][1])));
+    }
+
+    // The bucket of a value holds it, and is at most 1/32 wider than it
+    check(QFBLatencyHistogram::bucketOf(31) == 31 && QFBLatencyHistogram::bucketMaxNs(31) == 31,
+          "histogram: the small values are not exact");
+    for (qint64 ns = 32; ns < (Q_INT64_C(1) << 40); ns = ns * 3 + 7)
+    {
+        const qint64 max = QFBLatencyHistogram::bucketMaxNs(QFBLatencyHistogram::bucketOf(ns));
+        if (max < ns || max > ns + ns / 32)
+            fail(QString::fromLatin1("histogram: %1 ns in a bucket ending at %2").arg(ns).arg(max));
+    }
+}
+//-----------------------------------------------------------------------//
+// Statements of one fingerprint are counted together, with their rows
+static void checkFingerprintStatistics(QFBDriver &driver)
+{
+    const int rows = 5;
+    fbmock_configure("INTEGER", rows, -1);
+    driver.setFingerprintStatisticsEnabled(true);
+    driver.resetFingerprintStatistics();
+
+    const char *const queries[] = { "SELECT * FROM T WHERE I = 1", "select *  from t where i=2",
+                                    "SELECT * FROM T WHERE I = 3" };
+    for (size_t i = 0; i < sizeof(queries) / sizeof(queries[0]); ++i)
+    {
+        QSqlQuery q(driver.createResult());
+        q.setForwardOnly(true);
+        if (!exec(q, queries[i]))
+            return;
+        while (q.next())
+            ;
+    }
+
+    const QList<QFBFingerprintStats> stats = driver.fingerprintStatistics();
+    if (stats.count() != 1)
+    {
+        fail(QString::fromLatin1("fingerprint statistics: %1 fingerprints instead of 1").arg(stats.count()));
+        return;
+    }
+    const QFBFingerprintStats &s = stats.first();
+    check(s.fingerprint == QLatin1String("SELECT * FROM T WHERE I = ?"),
+          "fingerprint statistics: wrong fingerprint");
+    check(s.example == QLatin1String(queries[0]), "fingerprint statistics: example is not the first text");
+    check(s.executions == 3 && s.failed == 0 && s.rows == 3 * rows,
+          "fingerprint statistics: executions or rows wrong");
+    check(s.latency.count == 3 && s.latency.minNs <= s.latency.maxNs
+          && s.latency.percentile(100) == s.latency.maxNs,
+          "fingerprint statistics: histogram wrong");
+
+    driver.setFingerprintStatisticsEnabled(false);
+    driver.resetFingerprintStatistics();
+}
+//-----------------------------------------------------------------------//
+// Statement statistics: last and total, the callback, and the totals read by
+// another thread while the queries add to them
+static void checkStatistics(QFBDriver &driver)
+{
+    const int rows = 20;
+    fbmock_configure("INTEGER,VARCHAR(10)", rows, -1);
+    driver.resetStatistics();
+    driver.setStatisticsEnabled(true);
+    int reported = 0;
+    driver.setStatisticsCallback([&reported](const QFBStatementStats &) { ++reported; });
+
+    const char *const sql = "SELECT * FROM T";
+    QSqlQuery q(driver.createResult());
+    q.setForwardOnly(true);
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        if (!exec(q, sql))
+            return;
+        while (q.next())
+            ;
+    }
+    const QFBStatementStats last = driver.lastStatistics();
+    check(last.query == QLatin1String(sql) && last.executions == 1 && last.rows == rows
+          && !last.failed && last.bytesDecoded > 0, "statistics: last execution wrong");
+    const QFBStatementStats total = driver.totalStatistics();
+    check(total.executions == 2 && total.rows == 2 * rows, "statistics: totals wrong");
+    check(reported == 2, "statistics: callback not called once per execution");
+
+    driver.setStatisticsCallback(std::function<void(const QFBStatementStats &)>());
+    driver.resetStatistics();
+    check(driver.totalStatistics().executions == 0, "statistics: reset kept the totals");
+
+    const int executions = 200;
+    std::atomic<bool> done(false);
+    std::atomic<bool> ordered(true);
+    std::thread reader([&]() {
+        qint64 seen = 0;
+        while (!done.load())
+        {
+            const QFBStatementStats t = driver.totalStatistics();
+            if (t.executions < seen || t.rows != t.executions * rows)
+                ordered = false;
+            seen = t.executions;
+        }
+    });
+    for (int i = 0; i < executions; ++i)
+    {
+        exec(q, sql);
+        while (q.next())
+            ;
+    }
+    done = true;
+    reader.join();
+    check(ordered, "statistics: totals read half updated");
+    check(driver.totalStatistics().executions == executions, "statistics: executions lost");
+
+    q.finish();
+    driver.setStatisticsEnabled(false);
+    driver.resetStatistics();
+}
+//-----------------------------------------------------------------------//
+// Slow query log: with SLOW_QUERY_MS=0 every execution is written to
+// SLOW_QUERY_LOG with its SQL, values and plan, the plan asked once
+static void checkSlowQueryLog()
+{
+    fbmock_configure("INTEGER", 3, -1);
+    QTemporaryDir dir;
+    const QString log = dir.path() + QLatin1String("/slow.log");
+
+    QFBDriver driver;
+    if (!driver.open(QLatin1String("driver.fdb"), QLatin1String("SYSDBA"), QLatin1String("masterkey"),
+                     QString(), 0, QLatin1String("CHARSET=UTF8;SLOW_QUERY_MS=0;SLOW_QUERY_LOG=") + log))
+    {
+        fail(QLatin1String("open SLOW_QUERY_MS: ") + driver.lastError().text());
+        return;
+    }
+    check(driver.slowQueryThreshold() == 0 && driver.slowQueryLogFile() == log,
+          "slow query log: connect options not read");
+
+    QSqlQuery q(driver.createResult());
+    q.setForwardOnly(true);
+    if (!q.prepare(QLatin1String("SELECT * FROM T WHERE I = ?")))
+    {
+        fail(QLatin1String("prepare: ") + q.lastError().text());
+        return;
+    }
+    IBPP::ResetTraceCounts();
+    for (int i = 0; i < 3; ++i)
+    {
+        q.addBindValue(i + 40);
+        if (!q.exec())
+            fail(QLatin1String("exec: ") + q.lastError().text());
+        while (q.next())
+            ;
+    }
+    check(calls("isc_dsql_sql_info") == 1, "slow query log: plan asked more than once");
+
+    QFile file(log);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        fail(QLatin1String("slow query log: nothing written to ") + log);
+        return;
+    }
+    const QString text = QString::fromUtf8(file.readAll());
+    check(text.count(QLatin1String(" slow query: ")) == 3, "slow query log: one entry per execution expected");
+    check(text.contains(QLatin1String("3 rows\n")), "slow query log: rows missing");
+    check(text.contains(QLatin1String("\n  SQL: SELECT * FROM T WHERE I = ?\n")), "slow query log: SQL missing");
+    check(text.contains(QLatin1String("\n  parameters: 42\n")), "slow query log: parameters missing");
+    check(text.contains(QLatin1String("\n  plan: PLAN (MOCK NATURAL)\n")), "slow query log: plan missing");
+    file.close();
+
+    // A callback takes the entries instead of the file
+    QList<QFBSlowQuery> slow;
+    driver.setSlowQueryCallback([&slow](const QFBSlowQuery &s) { slow.append(s); });
+    q.addBindValue(7);
+    q.exec();
+    while (q.next())
+        ;
+    check(slow.count() == 1 && slow.first().parameters == QLatin1String("7")
+          && slow.first().plan == QLatin1String("PLAN (MOCK NATURAL)")
+          && slow.first().statistics.rows == 3, "slow query log: callback not given the entry");
+    q.finish();
+    driver.close();
+}
+//-----------------------------------------------------------------------//
+// Decimal columns of fetchColumns(): column i of row r holds the unscaled
+// values of tests/fbmock, (r + i) % 10000 for SMALLINT, r + i for INTEGER,
+// r * 1000003 + i for BIGINT, and (r - 2) * 2^120 + r * 1000003 + i for
+// INT128
+static void checkDecimals(QFBDriver &driver)
+{
+    const int rows = 78;    // Row 78 has 39 digits in INT128
+    fbmock_configure("NUMERIC(4,1),NUMERIC(9,2),NUMERIC(18,4),NUMERIC(38,6)", rows, -1);
+
+    QSqlQuery q(driver.createResult());
+    q.setForwardOnly(true);
+    if (!exec(q, "SELECT * FROM T"))
+        return;
+    QFBColumnBatch batch;
+    batch.decimals = true;
+    if (!QFBResult::fetchColumns(q, batch, rows))
+    {
+        fail(QLatin1String("decimals: ") + q.lastError().text());
+        return;
+    }
+    check(batch.rows == rows, "decimals: rows missing");
+
+    static const int precisions[] = { 5, 10, 19, 38 };
+    static const int scales[] = { 1, 2, 4, 6 };
+    for (int i = 0; i < 4; ++i)
+    {
+        const QFBColumn &c = batch.columns.at(i);
+        if (c.type != QFBColumn::Decimal || c.precision != precisions[i] || c.scale != scales[i])
+        {
+            fail(QString::fromLatin1("decimals: column %1 is DECIMAL(%2,%3)")
+                 .arg(i).arg(c.precision).arg(c.scale));
+            continue;
+        }
+        for (int r = 0; r < batch.rows; ++r)
+        {
+            const qint64 v = i == 0 ? (r + i) % 10000 : i == 1 ? r + i : qint64(r) * 1000003 + i;
+            const IBPP::Int128 expected(i == 3 ? qint64(quint64(r - 2) << 56) : v < 0 ? -1 : 0, quint64(v));
+            const char *le = c.bytes.constData() + 16 * r;
+            const IBPP::Int128 got(qFromLittleEndian<qint64>(le + 8), qFromLittleEndian<quint64>(le));
+            if (got != expected)
+            {
+                fail(QString::fromLatin1("decimals: column %1 row %2 is %3 instead of %4").arg(i).arg(r)
+                     .arg(QString::fromLatin1(got.ToString(c.scale).c_str()),
+                          QString::fromLatin1(expected.ToString(c.scale).c_str())));
+                break;
+            }
+        }
+    }
+
+    // Without decimals the NUMERIC come as doubles, INT128 as text
+    exec(q, "SELECT * FROM T");
+    batch.decimals = false;
+    QFBResult::fetchColumns(q, batch, 4);
+    check(batch.columns.at(1).type == QFBColumn::Double && batch.columns.at(1).doubles.at(3) == 0.04,
+          "decimals: NUMERIC(9,2) double wrong");
+    check(batch.columns.at(3).type == QFBColumn::String
+          && batch.columns.at(3).stringAt(2) == QLatin1String("2.000009"),
+          "decimals: NUMERIC(38,6) text wrong");
+
+    // A value of 39 digits doesn't fit a decimal128: the fetch fails
+    fbmock_configure(0, rows + 1, -1);
+    exec(q, "SELECT * FROM T");
+    batch.decimals = true;
+    check(!QFBResult::fetchColumns(q, batch, rows + 1)
+          && q.lastError().text().contains(QLatin1String("38 digits")),
+          "decimals: INT128 of 39 digits accepted");
+    q.finish();
+}
+//-----------------------------------------------------------------------//
+// A QSqlDatabase of the driver built in, for the classes opening attachments
+// of their own
+static QSqlDatabase addConnection(const char *name)
+{
+    if (!QSqlDatabase::isDriverAvailable(QLatin1String("QFIREBIRD")))
+        QSqlDatabase::registerSqlDriver(QLatin1String("QFIREBIRD"), new QSqlDriverCreator<QFBDriver>);
+    QSqlDatabase db = QSqlDatabase::addDatabase(QLatin1String("QFIREBIRD"), QLatin1String(name));
+    db.setDatabaseName(QLatin1String("driver.fdb"));
+    db.setUserName(QLatin1String("SYSDBA"));
+    db.setPassword(QLatin1String("masterkey"));
+    db.setConnectOptions(QLatin1String("CHARSET=UTF8"));
+    return db;
+}
+//-----------------------------------------------------------------------//
+// The NUMERIC and INT128 text of QFBCsvExporter, on its own connection, INT128
+// values of 39 digits included
+static void checkCsvDecimals()
+{
+    const int rows = 80;
+    fbmock_configure("NUMERIC(9,2),NUMERIC(18,4),INT128", rows, -1);
+
+    QSqlDatabase db = addConnection("csv");
+
+    {
+        QFBCsvExporter csv(db);
+        csv.setHeader(false);
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        const QFBCsvExportResult result =
+            csv.exportQuery(QLatin1String("SELECT * FROM T"), &buffer).result();
+        const QList<QByteArray> lines = buffer.data().split('\n');
+        if (result.error.isValid())
+            fail(QLatin1String("csv decimals: ") + result.error.text());
+        else if (result.rows != rows || lines.count() != rows + 1)
+            fail(QString::fromLatin1("csv decimals: %1 rows").arg(result.rows));
+        else
+        {
+            check(lines.at(0) == "0.00,0.0001,-144115188075855870\r"
+                  && lines.at(1) == "0.01,100.0004,-72057594036927931\r"
+                  && lines.at(2) == "0.02,200.0007,2000008\r",
+                  "csv decimals: first rows wrong");
+            for (int r = 0; r < rows; ++r)
+            {
+                const qint64 high = qint64(quint64(r - 2) << 56);
+                const QByteArray expected = QByteArray::number(r / 100) + '.'
+                        + QByteArray::number(r % 100).rightJustified(2, '0') + ','
+                        + IBPP::Int128(0, quint64(qint64(r) * 1000003 + 1)).ToString(4).c_str() + ','
+                        + IBPP::Int128(high, quint64(qint64(r) * 1000003 + 2)).ToString(0).c_str() + '\r';
+                if (lines.at(r) != expected)
+                {
+                    fail(QString::fromLatin1("csv decimals: row %1 is %2 instead of %3").arg(r)
+                         .arg(QString::fromLatin1(lines.at(r)), QString::fromLatin1(expected)));
+                    break;
+                }
+            }
+            check(lines.at(78).size() > 40, "csv decimals: INT128 of 39 digits missing");
+        }
+    }
+
+    db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(QLatin1String("csv"));
+}
+//-----------------------------------------------------------------------//
+// Flatbuffers of the Arrow metadata: the position of field id of the table
+// at table, 0 when the field is absent
+static int flatField(const QByteArray &fb, int table, int id)
+{
+    if (table < 4 || table + 4 > fb.size())
+        return 0;
+    const int vtable = table - qFromLittleEndian<qint32>(fb.constData() + table);
+    if (vtable < 0 || vtable + 4 > fb.size())
+        return 0;
+    const int size = qFromLittleEndian<quint16>(fb.constData() + vtable);
+    if (4 + 2 * id + 2 > size)
+        return 0;
+    const int offset = qFromLittleEndian<quint16>(fb.constData() + vtable + 4 + 2 * id);
+    return offset == 0 ? 0 : table + offset;
+}
+
+template <typename T> static T flatScalar(const QByteArray &fb, int table, int id)
+{
+    const int at = flatField(fb, table, id);
+    return at == 0 ? T(0) : qFromLittleEndian<T>(fb.constData() + at);
+}
+
+// The table, vector or string field id refers to, -1 when absent
+static int flatRef(const QByteArray &fb, int table, int id)
+{
+    const int at = flatField(fb, table, id);
+    return at == 0 ? -1 : at + int(qFromLittleEndian<quint32>(fb.constData() + at));
+}
+
+// An encapsulated message of an Arrow stream
+struct ArrowMessage
+{
+    QByteArray meta;        // Flatbuffer of the Message
+    int headerType;
+    int header;             // Position of the header table in meta
+    QByteArray body;
+};
+
+// Reads the message at pos and moves pos past its body. False at the end
+// of the stream or on a malformed message, which problem tells.
+static bool readArrowMessage(const QByteArray &stream, int &pos, ArrowMessage &m, QString &problem)
+{
+    if (pos + 8 > stream.size()
+            || qFromLittleEndian<quint32>(stream.constData() + pos) != 0xFFFFFFFFu)
+    {
+        problem = QString::fromLatin1("no continuation marker at %1").arg(pos);
+        return false;
+    }
+    const int length = qFromLittleEndian<qint32>(stream.constData() + pos + 4);
+    if (length == 0)
+    {
+        problem = QString::fromLatin1("end of stream at %1").arg(pos);
+        return false;
+    }
+    if (length < 0 || length % 8 != 0 || pos + 8 + length > stream.size())
+    {
+        problem = QString::fromLatin1("metadata length %1 at %2").arg(length).arg(pos);
+        return false;
+    }
+    m.meta = stream.mid(pos + 8, length);
+    const int message = int(qFromLittleEndian<quint32>(m.meta.constData()));
+    m.headerType = flatScalar<quint8>(m.meta, message, 1);
+    m.header = flatRef(m.meta, message, 2);
+    const qint64 body = flatScalar<qint64>(m.meta, message, 3);
+    if (flatScalar<qint16>(m.meta, message, 0) != 4 || m.header < 0)
+    {
+        problem = QString::fromLatin1("no MetadataV5 Message at %1").arg(pos);
+        return false;
+    }
+    if (body < 0 || body % 8 != 0 || pos + 8 + length + body > stream.size())
+    {
+        problem = QString::fromLatin1("body length %1 at %2").arg(body).arg(pos);
+        return false;
+    }
+    m.body = stream.mid(pos + 8 + length, int(body));
+    pos += 8 + length + int(body);
+    return true;
+}
+
+// The bytes QFBArrowExporter writes, decoded: Schema message, RecordBatch
+// messages of batchSize() rows whose buffers are laid end to end on 8 bytes
+// boundaries with zero padding, end-of-stream marker. The mock rows: column
+// i of row r holds r + i (INTEGER, NUMERIC(9,2)), the text of r then letters
+// (VARCHAR), (r + i) & 1 (BOOLEAN); every third row is NULL.
+static void checkArrowStream(QFBDriver &driver)
+{
+    const int rows = 5;
+    fbmock_configure("INTEGER,NUMERIC(9,2),VARCHAR(10),BOOLEAN", rows, -1);
+    fbmock_set_null_every(3);
+
+    QSqlQuery q(driver.createResult());
+    q.setForwardOnly(true);
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QFBArrowExporter arrow;
+    arrow.setBatchSize(2);
+    const bool exported = exec(q, "SELECT * FROM T") && arrow.exportQuery(q, &buffer);
+    q.finish();
+    fbmock_set_null_every(0);
+    fbmock_configure("INTEGER,BIGINT,DOUBLE PRECISION,NUMERIC(18,4),VARCHAR(40),TIMESTAMP,DATE", 1000, -1);
+    if (!exported)
+    {
+        fail(QLatin1String("arrow stream: ") + arrow.lastError().text());
+        return;
+    }
+    const QByteArray stream = buffer.data();
+    check(arrow.rows() == rows && arrow.batches() == 3 && arrow.bytes() == stream.size(),
+          "arrow stream: counts wrong");
+
+    int pos = 0;
+    ArrowMessage m;
+    QString problem;
+    if (!readArrowMessage(stream, pos, m, problem) || m.headerType != 1)
+    {
+        fail(QLatin1String("arrow stream: schema: ") + problem);
+        return;
+    }
+    check(m.body.isEmpty(), "arrow stream: schema with a body");
+    static const int typeIds[] = { 2, 7, 5, 6 };    // Int, Decimal, Utf8, Bool
+    const int fields = flatRef(m.meta, m.header, 1);
+    if (fields < 0 || qFromLittleEndian<quint32>(m.meta.constData() + fields) != 4)
+    {
+        fail(QLatin1String("arrow stream: schema fields missing"));
+        return;
+    }
+    for (int i = 0; i < 4; ++i)
+    {
+        const int at = fields + 4 + 4 * i;
+        const int field = at + int(qFromLittleEndian<quint32>(m.meta.constData() + at));
+        const int name = flatRef(m.meta, field, 0);
+        const int type = flatRef(m.meta, field, 3);
+        if (name < 0 || type < 0
+                || m.meta.mid(name + 4, qFromLittleEndian<quint32>(m.meta.constData() + name))
+                   != "F" + QByteArray::number(i + 1)
+                || flatScalar<quint8>(m.meta, field, 1) != 1
+                || flatScalar<quint8>(m.meta, field, 2) != typeIds[i])
+            fail(QString::fromLatin1("arrow stream: field %1 wrong").arg(i));
+        else if (i == 0)
+            check(flatScalar<qint32>(m.meta, type, 0) == 64 && flatScalar<quint8>(m.meta, type, 1) == 1,
+                  "arrow stream: INTEGER not an int64");
+        else if (i == 1)
+            check(flatScalar<qint32>(m.meta, type, 0) == 10 && flatScalar<qint32>(m.meta, type, 1) == 2
+                  && flatScalar<qint32>(m.meta, type, 2) == 128,
+                  "arrow stream: NUMERIC(9,2) not a decimal128(10, 2)");
+    }
+
+    static const int sizes[] = { 2, 2, 1 };
+    static const int buffersOf[] = { 2, 2, 3, 2 };
+    int first = 0;
+    for (int b = 0; b < 3; first += sizes[b++])
+    {
+        if (!readArrowMessage(stream, pos, m, problem) || m.headerType != 3)
+        {
+            fail(QString::fromLatin1("arrow stream: batch %1: %2").arg(b).arg(problem));
+            return;
+        }
+        const int n = sizes[b];
+        const int nodes = flatRef(m.meta, m.header, 1);
+        const int buffers = flatRef(m.meta, m.header, 2);
+        if (flatScalar<qint64>(m.meta, m.header, 0) != n || nodes < 0 || buffers < 0
+                || qFromLittleEndian<quint32>(m.meta.constData() + nodes) != 4
+                || qFromLittleEndian<quint32>(m.meta.constData() + buffers) != 9)
+        {
+            fail(QString::fromLatin1("arrow stream: batch %1 header wrong").arg(b));
+            return;
+        }
+
+        // Row 2 is the NULL one: the only one of the second batch to have
+        // a validity buffer, 0b10
+        const int nulls = first <= 2 && 2 < first + n ? 1 : 0;
+        qint64 next = 0;
+        int k = 0;
+        for (int c = 0; c < 4; ++c)
+        {
+            const char *node = m.meta.constData() + nodes + 4 + 16 * c;
+            check(qFromLittleEndian<qint64>(node) == n && qFromLittleEndian<qint64>(node + 8) == nulls,
+                  "arrow stream: field node wrong");
+            QByteArray parts[3];
+            for (int p = 0; p < buffersOf[c]; ++p, ++k)
+            {
+                const char *entry = m.meta.constData() + buffers + 4 + 16 * k;
+                const qint64 offset = qFromLittleEndian<qint64>(entry);
+                const qint64 length = qFromLittleEndian<qint64>(entry + 8);
+                const qint64 padded = (length + 7) & ~qint64(7);
+                if (offset != next || offset + padded > m.body.size()
+                        || m.body.mid(int(offset + length), int(padded - length))
+                           != QByteArray(int(padded - length), '\0'))
+                {
+                    fail(QString::fromLatin1("arrow stream: batch %1 buffer %2 at %3, %4 bytes")
+                         .arg(b).arg(k).arg(offset).arg(length));
+                    return;
+                }
+                parts[p] = m.body.mid(int(offset), int(length));
+                next = offset + padded;
+            }
+            check(nulls ? parts[0] == QByteArray(1, '\2') : parts[0].isEmpty(),
+                  "arrow stream: validity buffer wrong");
+
+            for (int j = 0; j < n; ++j)
+            {
+                const int r = first + j;
+                if (r == 2)
+                    continue;
+                bool ok;
+                if (c == 0)
+                    ok = parts[1].size() == 8 * n
+                        && qFromLittleEndian<qint64>(parts[1].constData() + 8 * j) == r;
+                else if (c == 1)
+                    ok = parts[1].size() == 16 * n
+                        && qFromLittleEndian<qint64>(parts[1].constData() + 16 * j) == r + 1
+                        && qFromLittleEndian<qint64>(parts[1].constData() + 16 * j + 8) == 0;
+                else if (c == 2)
+                {
+                    const char *offsets = parts[1].constData();
+                    const int from = qFromLittleEndian<qint32>(offsets + 4 * j);
+                    const int to = qFromLittleEndian<qint32>(offsets + 4 * j + 4);
+                    ok = parts[1].size() == 4 * (n + 1)
+                        && qFromLittleEndian<qint32>(offsets + 4 * n) == parts[2].size()
+                        && parts[2].mid(from, to - from).startsWith(QByteArray::number(r));
+                }
+                else
+                    ok = parts[1].size() == 1 && ((parts[1].at(0) >> j) & 1) == ((r + 3) & 1);
+                if (!ok)
+                    fail(QString::fromLatin1("arrow stream: column %1 row %2 wrong").arg(c).arg(r));
+            }
+        }
+        check(next == m.body.size(), "arrow stream: body longer than its buffers");
+    }
+
+    check(stream.mid(pos) == QByteArray("\xff\xff\xff\xff\0\0\0\0", 8),
+          "arrow stream: no end-of-stream marker");
+}
+//-----------------------------------------------------------------------//
+// Takes the batches of s, at most 5 s apart, into sizes (rows of each), the
+// first column of the rows being checked to count from 0. Returns the error
+// batch, which must be the last one.
+static QSqlError takeBatches(QFBRowStream *s, QVector<int> &sizes)
+{
+    QSqlError error;
+    int next = 0;
+    while (s->waitForBatch(5000))
+    {
+        const QFBRowBatch b = s->takeBatch();
+        if (error.isValid())
+            fail(QLatin1String("async: batch after the error"));
+        if (b.error.isValid())
+        {
+            error = b.error;
+            continue;
+        }
+        sizes << b.rows.count();
+        for (int r = 0; r < b.rows.count(); ++r)
+        {
+            if (b.rows.at(r).count() != b.record.count() || b.rows.at(r).at(0).toInt() != next++)
+            {
+                fail(QString::fromLatin1("async: row %1 wrong").arg(next - 1));
+                return error;
+            }
+        }
+    }
+    check(s->isFinished(), "async: stream not finished");
+    return error;
+}
+//-----------------------------------------------------------------------//
+// QFBAsyncQuery: batches of batchSize() rows, at most maxPendingBatches() of
+// them waiting for the consumer, the count of a DML statement, a fetch error
+// ending the stream, and cancellation before, during the execution and
+// during the fetch
+static void checkAsyncQuery()
+{
+    const char *select = "SELECT * FROM T";
+    fbmock_configure("INTEGER,VARCHAR(10)", 1000, -1);
+    IBPP::UseLegacyAPI(true);   // Its fetches are counted as isc_dsql_fetch calls
+    QSqlDatabase db = addConnection("async");
+    {
+        QFBAsyncQuery async(db);
+        async.setBatchSize(256);
+        async.setMaxPendingBatches(2);
+
+        QFBRowStream *s = async.exec(QLatin1String(select));
+        QThread::msleep(200);
+        check(s->pendingBatches() == 2, "async: the worker doesn't wait for the consumer");
+        QVector<int> sizes;
+        QSqlError error = takeBatches(s, sizes);
+        check(!error.isValid(), "async: SELECT failed");
+        check(sizes == QVector<int>() << 256 << 256 << 256 << 232, "async: batches not split at batchSize()");
+        delete s;
+
+        s = async.exec(QLatin1String("UPDATE T SET F1 = ?"), QVector<QVariant>() << 1);
+        if (s->waitForBatch(5000))
+        {
+            const QFBRowBatch b = s->takeBatch();
+            check(!b.error.isValid() && b.numRowsAffected == 1 && b.rows.isEmpty(),
+                  "async: UPDATE batch wrong");
+        }
+        else
+            fail(QLatin1String("async: no UPDATE batch"));
+        check(!s->waitForBatch(5000) && s->isFinished(), "async: UPDATE gives more than one batch");
+        delete s;
+
+        // The rows fetched before the error come first
+        fbmock_set_fetch_error(600);
+        s = async.exec(QLatin1String(select));
+        sizes.clear();
+        error = takeBatches(s, sizes);
+        check(error.isValid() && error.databaseText().contains(QLatin1String("fetch error")),
+              "async: fetch error not reported");
+        check(sizes == QVector<int>() << 256 << 256, "async: rows before the fetch error wrong");
+        fbmock_set_fetch_error(-1);
+        delete s;
+
+        // An execution of 10 s is interrupted on the server
+        fbmock_set_execute_delay(10000);
+        s = async.exec(QLatin1String(select));
+        QThread::msleep(100);
+        QElapsedTimer timer;
+        timer.start();
+        s->cancel();
+        check(!s->waitForBatch(5000) && async.waitForDone(5000) && timer.elapsed() < 5000,
+              "async: execution not cancelled");
+        check(s->isCanceled() && s->isFinished(), "async: cancelled stream not finished");
+        delete s;
+
+        // A query cancelled while queued never runs
+        fbmock_set_execute_delay(200);
+        s = async.exec(QLatin1String(select));
+        QFBRowStream *queued = async.exec(QLatin1String(select));
+        queued->cancel();
+        sizes.clear();
+        takeBatches(s, sizes);
+        check(sizes.count() == 4, "async: query before the cancelled one incomplete");
+        check(async.waitForDone(5000) && !queued->hasBatch() && queued->isFinished(),
+              "async: cancelled query ran");
+        fbmock_set_execute_delay(0);
+        delete queued;
+        delete s;
+
+        // Cancel, or deletion, during the fetch of 100000 rows stops it
+        fbmock_configure(0, 100000, -1);
+        const qint64 fetches = calls("isc_dsql_fetch");
+        s = async.exec(QLatin1String(select));
+        check(s->waitForBatch(5000) && s->takeBatch().rows.count() == 256, "async: first batch missing");
+        s->cancel();
+        check(async.waitForDone(5000), "async: fetch not cancelled");
+        check(!s->hasBatch() && s->isFinished(), "async: batches after the cancel");
+        delete s;
+        s = async.exec(QLatin1String(select));
+        s->waitForBatch(5000);
+        delete s;
+        check(async.waitForDone(5000) && calls("isc_dsql_fetch") - fetches < 5000,
+              "async: fetch goes on after the stream is deleted");
+    }
+    fbmock_configure(0, 1000, -1);
+    db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(QLatin1String("async"));
+    IBPP::UseLegacyAPI(false);
+}
+//-----------------------------------------------------------------------//
+// WITH TIME ZONE values of the mock: an offset, a region and GMT in turn.
+// The server sends the offset of the region (EXTENDED binding asked on
+// attach) and the client library its name; TIME WITH TIME ZONE comes as a
+// QDateTime of 2020-01-01 at the zone of the value.
+static void checkTimeZones(bool legacy)
+{
+    fbmock_configure("INTEGER,TIMESTAMP WITH TIME ZONE,TIME WITH TIME ZONE", 3, -1);
+    IBPP::UseLegacyAPI(legacy);
+    QFBDriver driver;
+    if (!driver.open(QLatin1String("driver.fdb"), QLatin1String("SYSDBA"), QLatin1String("masterkey"),
+                     QString(), 0, QLatin1String("CHARSET=UTF8")))
+    {
+        fail(QLatin1String("time zones: open: ") + driver.lastError().text());
+        IBPP::UseLegacyAPI(false);
+        return;
+    }
+
+    static const int offsets[] = { 120, 330, 0 };
+    const bool kolkata = QTimeZone(QByteArray("Asia/Kolkata")).isValid();
+    QSqlQuery q(driver.createResult());
+    q.setForwardOnly(true);
+    int r = 0;
+    if (exec(q, "SELECT * FROM T"))
+    {
+        check(q.record().field(1).type() == QVariant::DateTime
+              && q.record().field(2).type() == QVariant::DateTime,
+              "time zones: columns not of QDateTime");
+        for (; q.next(); ++r)
+        {
+            const QDateTime ts = q.value(1).toDateTime();
+            const QDateTime tm = q.value(2).toDateTime();
+            const QDateTime utc(QDate(2020, 1, 1).addDays(r), QTime(0, 0, r), Qt::UTC);
+            const int offset = offsets[r % 3] * 60;
+            if (ts.toUTC() != utc || ts.offsetFromUtc() != offset)
+                fail(QString::fromLatin1("time zones: timestamp of row %1 is %2")
+                     .arg(r).arg(ts.toString(Qt::ISODate)));
+            if (tm.date() != QDate(2020, 1, 1) || tm.time() != QTime(0, 0, r).addSecs(offset)
+                    || tm.offsetFromUtc() != offset)
+                fail(QString::fromLatin1("time zones: time of row %1 is %2")
+                     .arg(r).arg(tm.toString(Qt::ISODate)));
+            if (r % 3 == 1 && kolkata)
+                check(ts.timeZone().id() == "Asia/Kolkata" && tm.timeZone().id() == "Asia/Kolkata",
+                      "time zones: region name lost");
+        }
+    }
+    check(r == 3, "time zones: rows missing");
+    q.finish();
+    driver.close();
+    IBPP::UseLegacyAPI(false);
+    fbmock_configure("INTEGER,BIGINT,DOUBLE PRECISION,NUMERIC(18,4),VARCHAR(40),TIMESTAMP,DATE", 1000, -1);
+}
+//-----------------------------------------------------------------------//
+// The rows of SELECT * FROM T read through the driver, on an attachment of
+// the OO API or of the legacy one
+static QStringList readRows(bool legacy, int columns)
+{
+    IBPP::UseLegacyAPI(legacy);
+    QStringList rows;
+    QFBDriver driver;
+    if (!driver.open(QLatin1String("driver.fdb"), QLatin1String("SYSDBA"), QLatin1String("masterkey"),
+                     QString(), 0, QLatin1String("CHARSET=UTF8")))
+    {
+        fail(QLatin1String("open: ") + driver.lastError().text());
+        return rows;
+    }
+    QSqlQuery q(driver.createResult());
+    q.setForwardOnly(true);
+    if (exec(q, "SELECT * FROM T"))
+        while (q.next())
+        {
+            QStringList values;
+            for (int i = 0; i < columns; ++i)
+                values << (q.isNull(i) ? QString::fromLatin1("NULL") : q.value(i).toString());
+            rows << values.join(QLatin1Char('|'));
+        }
+    q.finish();
+    driver.close();
+    return rows;
+}
+
+// The method a QFBBulkLoader left on Auto uses for a few CSV rows
+static int bulkMethod(bool legacy)
+{
+    IBPP::UseLegacyAPI(legacy);
+    QSqlDatabase db = addConnection("bulk");
+    int method = -1;
+    {
+        QFBBulkLoader loader(db);
+        loader.setTable(QLatin1String("T"));
+        loader.setColumns(QStringList() << QLatin1String("A") << QLatin1String("B"));
+        loader.setHeader(false);
+        QBuffer buffer;
+        buffer.setData("1,one\n2,two\n3,three\n");
+        buffer.open(QIODevice::ReadOnly);
+        const QFBBulkLoadResult result = loader.load(&buffer).result();
+        if (result.error.isValid())
+            fail(QLatin1String("oo api: bulk load: ") + result.error.text());
+        else
+            check(result.rowsLoaded == 3, "oo api: bulk load: rows missing");
+        method = result.method;
+    }
+    db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(QLatin1String("bulk"));
+    return method;
+}
+
+// The OO API of the mock library is used unless IBPP::UseLegacyAPI(true):
+// the values read are the same on both, INSERT batches go in an IBatch (not
+// with a blob parameter), statement timeouts and fetch errors are raised
+static void checkOOApi()
+{
+    fbmock_configure("INTEGER,BIGINT,DOUBLE PRECISION,NUMERIC(18,4),VARCHAR(40),TIMESTAMP,DATE", 40, -1);
+    fbmock_set_null_every(7);
+    const QStringList legacyRows = readRows(true, 7);
+    check(!IBPP::OOApiActive(), "oo api: used after UseLegacyAPI(true)");
+    const QStringList ooRows = readRows(false, 7);
+    check(IBPP::OOApiActive(), "oo api: not found in the mock library");
+    check(ooRows.count() == 40 && ooRows == legacyRows, "oo api: values differ from the legacy API");
+    fbmock_set_null_every(0);
+
+    fbmock_configure("INTEGER,VARCHAR(20)", 10, -1);
+    check(bulkMethod(false) == QFBBulkLoader::Batch, "oo api: bulk loader doesn't pick Batch");
+    check(bulkMethod(true) == QFBBulkLoader::ExecuteBlock, "oo api: bulk loader Batch without IBatch");
+    IBPP::UseLegacyAPI(false);
+
+    try
+    {
+        IBPP::Database db = IBPP::DatabaseFactory("", "driver.fdb", "SYSDBA", "masterkey");
+        db->Connect();
+        check(db->OOApiActive(), "oo api: attachment not made through it");
+        IBPP::Transaction tr = IBPP::TransactionFactory(db);
+        tr->Start();
+        IBPP::Statement st = IBPP::StatementFactory(db, tr);
+        st->Prepare("INSERT INTO T (A, B) VALUES (?, ?)");
+        check(st->ServerBatch(), "oo api: no IBatch for the INSERT");
+        for (int i = 0; i < 5; ++i)
+        {
+            st->Set(1, i);
+            st->Set(2, std::string("row"));
+            st->AddBatch();
+        }
+        check(st->ExecuteBatch() == 5, "oo api: wrong count of batch rows");
+
+        st->SetTimeout(20);
+        fbmock_set_execute_delay(2000);
+        QElapsedTimer timer;
+        timer.start();
+        bool timedOut = false;
+        try
+        {
+            st->Execute();
+        }
+        catch (IBPP::SQLException &)
+        {
+            timedOut = true;
+        }
+        fbmock_set_execute_delay(0);
+        check(timedOut && timer.elapsed() < 1000, "oo api: statement timeout ignored");
+
+        fbmock_set_fetch_error(3);
+        st->Execute("SELECT * FROM T");
+        int fetched = 0;
+        bool failed = false;
+        try
+        {
+            while (st->Fetch())
+                ++fetched;
+        }
+        catch (IBPP::SQLException &)
+        {
+            failed = true;
+        }
+        fbmock_set_fetch_error(-1);
+        check(failed && fetched == 3, "oo api: fetch error not raised");
+
+        fbmock_configure("INTEGER,BLOB SUB_TYPE TEXT", -1, -1);
+        st->Prepare("INSERT INTO T (A, B) VALUES (?, ?)");
+        check(!st->ServerBatch(), "oo api: IBatch with a blob parameter");
+        for (int i = 0; i < 3; ++i)
+        {
+            st->Set(1, i);
+            st->SetNull(2);
+            st->AddBatch();
+        }
+        check(st->ExecuteBatch() == 3, "oo api: wrong count of queued rows");
+
+        tr->Commit();
+        db->Disconnect();
+    }
+    catch (IBPP::Exception &e)
+    {
+        fail(QLatin1String("oo api: ") + QString::fromLatin1(e.what()));
+    }
+    fbmock_configure("INTEGER,BIGINT,DOUBLE PRECISION,NUMERIC(18,4),VARCHAR(40),TIMESTAMP,DATE", 1000, -1);
+}
+//-----------------------------------------------------------------------//
+// The INTEGER column of the current row, -1 off the result set
+static int rowValue(const QSqlQuery &q)
+{
+    return q.isValid() ? q.value(0).toInt() : -1;
+}
+
+// Moves of a query that isn't forward only, row r of the mock holding r.
+// Jumping reads only the row asked for: a fetch error on an earlier row
+// isn't met.
+static void scrollRows(QFBDriver &driver, bool jumps, const char *what)
+{
+    QSqlQuery q(driver.createResult());
+    if (!exec(q, "SELECT * FROM T"))
+        return;
+    const QString prefix = QString::fromLatin1("scrollable cursors (%1): ").arg(QLatin1String(what));
+    if (jumps)
+        fbmock_set_fetch_error(10);
+    const bool jumped = q.seek(50) && rowValue(q) == 50;
+    fbmock_set_fetch_error(-1);
+    if (!jumped)
+        fail(prefix + (jumps ? QLatin1String("seek(50) read the rows before it")
+                             : QLatin1String("seek(50) failed")));
+    else if (!(q.previous() && rowValue(q) == 49
+               && q.first() && rowValue(q) == 0 && !q.previous()
+               && q.last() && rowValue(q) == 99 && q.at() == 99
+               && !q.next()
+               && q.seek(20) && rowValue(q) == 20 && !q.isNull(1)
+               && !q.seek(200)))
+        fail(prefix + QLatin1String("wrong row after a move"));
+    q.finish();
+}
+
+// SCROLLABLE_CURSORS=1 moves through an IResultSet opened scrollable. A
+// cursor the server refuses, or an attachment of the legacy API, goes back
+// to the client cache with the same rows.
+static void checkScrollableCursors()
+{
+    fbmock_configure("INTEGER,VARCHAR(10)", 100, -1);
+    QFBDriver driver;
+    if (!driver.open(QLatin1String("driver.fdb"), QLatin1String("SYSDBA"), QLatin1String("masterkey"),
+                     QString(), 0, QLatin1String("CHARSET=UTF8;SCROLLABLE_CURSORS=1")))
+    {
+        fail(QLatin1String("scrollable cursors: open: ") + driver.lastError().text());
+        return;
+    }
+    scrollRows(driver, true, "oo api");
+    fbmock_set_scrollable_cursors(0);
+    scrollRows(driver, false, "refused");
+    fbmock_set_scrollable_cursors(1);
+    driver.close();
+
+    IBPP::UseLegacyAPI(true);
+    QFBDriver legacy;
+    if (legacy.open(QLatin1String("driver.fdb"), QLatin1String("SYSDBA"), QLatin1String("masterkey"),
+                    QString(), 0, QLatin1String("CHARSET=UTF8;SCROLLABLE_CURSORS=1")))
+    {
+        scrollRows(legacy, false, "legacy api");
+        legacy.close();
+    }
+    else
+        fail(QLatin1String("scrollable cursors: open: ") + legacy.lastError().text());
+    IBPP::UseLegacyAPI(false);
+    fbmock_configure("INTEGER,BIGINT,DOUBLE PRECISION,NUMERIC(18,4),VARCHAR(40),TIMESTAMP,DATE", 1000, -1);
+}
+//-----------------------------------------------------------------------//
+// Value of the fb_attachments{owner="helper"} gauge
+static qint64 helperAttachments()
+{
+    const QByteArray sample("fb_attachments{owner=\"helper\"} ");
+    const QByteArray metrics = QFBMetrics::render();
+    const int at = metrics.indexOf(sample);
+    if (at < 0)
+        return -1;
+    const int start = at + sample.size();
+    return metrics.mid(start, metrics.indexOf('\n', start) - start).toLongLong();
+}
+//-----------------------------------------------------------------------//
+// A helper attachment found disconnected is uncounted when it is replaced
+static void checkHelperAttachments()
+{
+    const qint64 before = helperAttachments();
+    QFBConnectionParams params;
+    params.dbName = QLatin1String("driver.fdb");
+    params.user = QLatin1String("SYSDBA");
+    params.password = QLatin1String("masterkey");
+    params.connOpts = QLatin1String("CHARSET=UTF8");
+
+    IBPP::Database db;
+    QTextCodec *codec = 0;
+    QSqlError error;
+    if (!qFBAttach(params, db, codec, error))
+    {
+        fail(QLatin1String("attach: ") + error.text());
+        return;
+    }
+    check(helperAttachments() == before + 1, "helper attachments: attachment not counted");
+    db->Disconnect();
+    qFBAttach(params, db, codec, error);
+    check(helperAttachments() == before + 1, "helper attachments: lost attachment still counted");
+    qFBDetach(db);
+    check(helperAttachments() == before, "helper attachments: detached attachment still counted");
+}
+//-----------------------------------------------------------------------//
+// The rows committed in the mock library since the last call
+static QStringList insertedRows()
+{
+    QStringList rows;
+    char row[256];
+    for (int i = 0; fbmock_inserted_row(i, row, sizeof(row)) >= 0; ++i)
+        rows << QString::fromUtf8(row);
+    fbmock_clear_inserted_rows();
+    return rows;
+}
+
+static QFBBulkLoadResult loadCsv(QFBBulkLoader &loader, const QByteArray &csv)
+{
+    fbmock_clear_inserted_rows();
+    loader.setTable(QLatin1String("T"));
+    QBuffer buffer;
+    buffer.setData(csv);
+    buffer.open(QIODevice::ReadOnly);
+    return loader.load(&buffer).result();
+}
+
+// Rows 1 to count as "r,br,cr", a header first; the rows of bad hold "bad"
+// in their second field, those of unparsed "xr" in their first
+static QByteArray bulkRows(int count, const QVector<int> &bad, const QVector<int> &unparsed)
+{
+    QByteArray csv("a,b,c\n");
+    for (int r = 1; r <= count; ++r)
+    {
+        const QByteArray n = QByteArray::number(r);
+        csv += (unparsed.contains(r) ? "x" + n : n) + ','
+                + (bad.contains(r) ? QByteArray("bad") : "b" + n) + ",c" + n + '\n';
+    }
+    return csv;
+}
+
+// "r|br|cr" of the given rows
+static QStringList bulkExpected(const QVector<int> &rows)
+{
+    QStringList expected;
+    for (int i = 0; i < rows.count(); ++i)
+        expected << QString::fromLatin1("%1|b%1|c%1").arg(rows.at(i));
+    return expected;
+}
+
+// Csv parsing, header mapping and rejected rows of QFBBulkLoader, checked on
+// the rows the mock library commits. A batch (or EXECUTE BLOCK) failing on
+// one row is undone and sent again row by row: every good row is committed
+// once, the bad ones are reported by their number in the input.
+static void checkBulkLoader()
+{
+    fbmock_configure("INTEGER,VARCHAR(20),VARCHAR(20)", -1, -1);
+    const QStringList columns = QStringList() << QLatin1String("A") << QLatin1String("B")
+                                              << QLatin1String("C");
+    QSqlDatabase db = addConnection("bulkcsv");
+    {
+        // Quoted delimiters, quotes and line breaks, CRLF, a blank line; ""
+        // is an empty string, an empty unquoted field NULL
+        QFBBulkLoader loader(db);
+        loader.setColumns(columns);
+        const QFBBulkLoadResult result = loadCsv(loader, "1,\"a,b\",\"say \"\"hi\"\"\"\r\n"
+                                                 "2,\"two\nlines\",\r\n\n3,\"\",x\n4,,\"\"");
+        const QStringList rows = insertedRows();
+        if (result.error.isValid())
+            fail(QLatin1String("bulk loader: csv: ") + result.error.text());
+        else if (rows != (QStringList() << QLatin1String("1|a,b|say \"hi\"")
+                          << QLatin1String("2|two\nlines|NULL") << QLatin1String("3||x")
+                          << QLatin1String("4|NULL|")))
+            fail(QLatin1String("bulk loader: csv rows are ") + rows.join(QLatin1String(", ")));
+        check(result.rowsRead == 4 && result.rowsLoaded == 4 && result.rowsRejected == 0,
+              "bulk loader: csv counts wrong");
+    }
+    {
+        // Header fields matched by name, trimmed and case insensitive
+        QFBBulkLoader loader(db);
+        loader.setColumns(columns);
+        loader.setHeader(true);
+        QFBBulkLoadResult result = loadCsv(loader, "c, B ,a\nz,y,1\nw,v,2\n");
+        check(!result.error.isValid() && insertedRows() == (QStringList() << QLatin1String("1|y|z")
+                                                            << QLatin1String("2|v|w")),
+              "bulk loader: header not mapped");
+
+        loader.setColumns(QStringList() << QLatin1String("A") << QLatin1String("D"));
+        result = loadCsv(loader, "a,b,c\n1,2,3\n");
+        check(result.error.databaseText() == QLatin1String("Column D is not in the header")
+              && result.rowsLoaded == 0 && insertedRows().isEmpty(),
+              "bulk loader: missing header column not reported");
+    }
+
+    // Rows 3 and 7 fail in the server, row 6 can't be parsed: batches of 4
+    // rows, one failing in each of the first two
+    fbmock_set_insert_error("bad");
+    for (int legacy = 0; legacy < 2; ++legacy)
+    {
+        IBPP::UseLegacyAPI(legacy != 0);
+        const char *const what = legacy ? "bulk loader: ExecuteBlock" : "bulk loader: Batch";
+        QFBBulkLoader loader(db);
+        loader.setColumns(columns);
+        loader.setHeader(true);
+        loader.setBatchSize(4);
+        const QFBBulkLoadResult result =
+            loadCsv(loader, bulkRows(10, QVector<int>() << 3 << 7, QVector<int>() << 6));
+        const QStringList rows = insertedRows();
+        QVector<qint64> rejected;
+        for (int i = 0; i < result.rejected.count(); ++i)
+            rejected << result.rejected.at(i).row;
+        std::sort(rejected.begin(), rejected.end());
+
+        if (result.error.isValid())
+            fail(QString::fromLatin1("%1: %2").arg(QLatin1String(what), result.error.text()));
+        check(result.method == (legacy ? QFBBulkLoader::ExecuteBlock : QFBBulkLoader::Batch),
+              "bulk loader: method not used");
+        if (rows != bulkExpected(QVector<int>() << 1 << 2 << 4 << 5 << 8 << 9 << 10))
+            fail(QString::fromLatin1("%1: rows committed are %2")
+                 .arg(QLatin1String(what), rows.join(QLatin1String(", "))));
+        if (rejected != (QVector<qint64>() << 3 << 6 << 7))
+            fail(QString::fromLatin1("%1: %2 rejected rows").arg(QLatin1String(what)).arg(rejected.count()));
+        check(result.rowsRead == 10 && result.rowsLoaded == 7 && result.rowsRejected == 3,
+              "bulk loader: counts of the rejected rows wrong");
+        for (int i = 0; i < result.rejected.count(); ++i)
+        {
+            const QFBBulkRejectedRow &r = result.rejected.at(i);
+            if (r.row == 6 ? !r.message.startsWith(QLatin1String("A: "))
+                           : !r.message.contains(QLatin1String("PRIMARY KEY")))
+                fail(QString::fromLatin1("%1: row %2 rejected for %3")
+                     .arg(QLatin1String(what)).arg(r.row).arg(r.message));
+        }
+    }
+    IBPP::UseLegacyAPI(false);
+
+    {
+        // Batches of 2 rows committed every 4: the third rejected row stops
+        // the load at the end of the chunk read, rolling back rows 7 to 10
+        QFBBulkLoader loader(db);
+        loader.setColumns(columns);
+        loader.setHeader(true);
+        loader.setBatchSize(2);
+        loader.setCommitRows(4);
+        loader.setMaxRejected(1);
+        const QFBBulkLoadResult result =
+            loadCsv(loader, bulkRows(10, QVector<int>() << 3 << 6 << 9, QVector<int>()));
+        check(result.error.databaseText() == QLatin1String("More than 1 rejected rows"),
+              "bulk loader: maxRejected() not applied");
+        check(result.rowsLoaded == 4 && result.rowsRejected == 3
+              && insertedRows() == bulkExpected(QVector<int>() << 1 << 2 << 4 << 5),
+              "bulk loader: rows kept after maxRejected() wrong");
+    }
+    fbmock_set_insert_error(0);
+
+    db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(QLatin1String("bulkcsv"));
+    fbmock_configure("INTEGER,BIGINT,DOUBLE PRECISION,NUMERIC(18,4),VARCHAR(40),TIMESTAMP,DATE", 1000, -1);
+}
+//-----------------------------------------------------------------------//
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QFBDriver driver;
+    if (!driver.open(QLatin1String("driver.fdb"), QLatin1String("SYSDBA"), QLatin1String("masterkey"),
+                     QString(), 0, QLatin1String("CHARSET=UTF8")))
+    {
+        fail(QLatin1String("open: ") + driver.lastError().text());
+        return 1;
+    }
+    IBPP::TraceCalls(true);
+
+    checkArrays(driver);
+    checkServerStatistics(driver);
+    checkFingerprint();
+    checkFingerprintStatistics(driver);
+    checkStatistics(driver);
+    checkSlowQueryLog();
+    checkHelperAttachments();
+    checkDecimals(driver);
+    checkCsvDecimals();
+    checkArrowStream(driver);
+    checkAsyncQuery();
+    checkTimeText();
+    checkOOApi();
+    checkScrollableCursors();
+    checkTimeZones(false);
+    checkTimeZones(true);
+    checkBulkLoader();
+
+    IBPP::TraceCalls(false);
+    driver.close();
+
+    if (failures != 0)
+    {
+        qWarning("driver: %d checks failed", failures);
+        return 1;
+    }
+    qDebug("driver: all the checks passed");
+    return 0;
+}
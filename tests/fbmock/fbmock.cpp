@@ -0,0 +1,2302 @@
+/*
+* This file is part of QtFirebirdIBPPSQLDriver - Qt SQL driver for Firebird with IBPP library
+* Copyright (C) 2006-2010 Alex Wencel
+*
+* Contact e-mail: Alex Wencel <alex.wencel@gmail.com>
+* Program URL   : http://code.google.com/p/qtfirebirdibppsqldriver
+*
+* GNU Lesser General Public License Usage
+* This file may be used under the terms of the GNU Lesser
+* General Public License version 2.1 as published by the Free Software
+* Foundation and appearing in the file LICENSE.LGPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU Lesser General Public License version 2.1 requirements
+* will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+*
+* GNU General Public License Usage
+* Alternatively, this file may be used under the terms of the GNU
+* General Public License version 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU General Public License version 3.0 requirements will be
+* met: http://www.gnu.org/copyleft/gpl.html.
+*
+*/
+
+// Mock Firebird client library. It exports the isc_* entry points bound by
+// IBPP's GDS::Call() and answers them from memory: every attachment and
+// transaction succeeds, every SELECT returns rows of the configured columns
+// with generated values, other statements affect one row, blobs are read
+// as generated bytes and arrays as generated numbers (written blobs and
+// arrays are discarded). The parameters of INSERT and EXECUTE BLOCK are
+// kept as rows of text, per transaction until it commits. Executions may be slowed down by a delay which
+// fb_cancel_operation() interrupts. The Firebird 4 OO API is answered too,
+// through fb_get_master_interface() and the fb_get_*_handle/interface()
+// bridges IBPP uses between both APIs. Linked in place of
+// fbclient, it leaves only the client side cost of IBPP and the driver to be
+// measured.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "ibase.h"
+#include "iberror.h"
+#include "_oo.h"
+#include "fbmock.h"
+
+#ifndef SQL_BOOLEAN
+#define SQL_BOOLEAN 32764
+#endif
+#ifndef SQL_INT128
+#define SQL_INT128 32752
+#endif
+#ifndef SQL_TIMESTAMP_TZ
+#define SQL_TIMESTAMP_TZ 32754
+#define SQL_TIME_TZ 32756
+#define SQL_TIMESTAMP_TZ_EX 32748
+#define SQL_TIME_TZ_EX 32750
+#endif
+#ifndef isc_dpb_set_bind
+#define isc_dpb_set_bind 93
+#endif
+#ifndef fb_cancel_raise
+#define fb_cancel_raise 3
+#endif
+
+namespace {
+
+//-----------------------------------------------------------------------//
+// Configuration
+
+struct MockColumn
+{
+    short type;         // SQL_* without the nullable bit
+    short scale;
+    short subtype;
+    short length;       // sqllen
+    short elementType;  // Arrays: SQL_* of the elements, their sqllen
+    short elementLength;
+    short elements;     // and count, in one dimension (1..elements)
+};
+
+typedef std::vector<MockColumn> MockColumns;
+
+struct MockConfig
+{
+    std::shared_ptr<const MockColumns> columns;
+    long rows;
+    long blobSize;
+    int nullEvery;
+};
+
+const char *const defaultColumns =
+    "INTEGER,BIGINT,DOUBLE PRECISION,NUMERIC(18,4),VARCHAR(40),TIMESTAMP,DATE";
+
+std::mutex configLock;
+MockConfig config;
+bool configured = false;
+
+std::atomic<unsigned long long> callCount(0);
+std::atomic<int> executeDelay(0);      // Milliseconds
+std::atomic<long> fetchError(-1);      // Row whose fetch fails
+std::atomic<bool> scrollable(true);    // Scrollable cursors are opened
+
+// Parses one type ("NUMERIC(18,4)", "blob sub_type text"...), spaces ignored
+bool parseColumn(const std::string &spec, MockColumn &col)
+{
+    std::string t;
+    for (size_t i = 0; i < spec.size(); ++i)
+        if (!isspace((unsigned char)spec[i]))
+            t += char(toupper((unsigned char)spec[i]));
+
+    int p = 0, s = 0, n = 0;
+    col.scale = 0;
+    col.subtype = 0;
+    col.elementType = col.elementLength = col.elements = 0;
+    const size_t bracket = t.find('[');
+    if (bracket != std::string::npos)
+    {
+        // "INTEGER[4]": a one dimension array of a numeric type
+        MockColumn elem;
+        if (sscanf(t.c_str() + bracket, "[%d]", &n) != 1 || n < 1 || n > 32767
+                || !parseColumn(t.substr(0, bracket), elem)
+                || (elem.type != SQL_SHORT && elem.type != SQL_LONG && elem.type != SQL_INT64
+                    && elem.type != SQL_FLOAT && elem.type != SQL_DOUBLE))
+            return false;
+        col.type = SQL_ARRAY;
+        col.length = 8;
+        col.scale = elem.scale;
+        col.elementType = elem.type;
+        col.elementLength = elem.length;
+        col.elements = short(n);
+        return true;
+    }
+    if (t == "SMALLINT") { col.type = SQL_SHORT; col.length = 2; }
+    else if (t == "INTEGER" || t == "INT") { col.type = SQL_LONG; col.length = 4; }
+    else if (t == "BIGINT") { col.type = SQL_INT64; col.length = 8; }
+    else if (t == "INT128") { col.type = SQL_INT128; col.length = 16; }
+    else if (t == "FLOAT") { col.type = SQL_FLOAT; col.length = 4; }
+    else if (t == "DOUBLEPRECISION" || t == "DOUBLE") { col.type = SQL_DOUBLE; col.length = 8; }
+    else if (t == "DATE") { col.type = SQL_TYPE_DATE; col.length = 4; }
+    else if (t == "TIME") { col.type = SQL_TYPE_TIME; col.length = 4; }
+    else if (t == "TIMESTAMP") { col.type = SQL_TIMESTAMP; col.length = 8; }
+    else if (t == "TIMEWITHTIMEZONE") { col.type = SQL_TIME_TZ; col.length = 6; }
+    else if (t == "TIMESTAMPWITHTIMEZONE") { col.type = SQL_TIMESTAMP_TZ; col.length = 10; }
+    else if (t == "BOOLEAN") { col.type = SQL_BOOLEAN; col.length = 1; }
+    else if (t == "BLOB" || t == "BLOBSUB_TYPE0" || t == "BLOBSUB_TYPEBINARY")
+    { col.type = SQL_BLOB; col.length = 8; }
+    else if (t == "BLOBSUB_TYPE1" || t == "BLOBSUB_TYPETEXT")
+    { col.type = SQL_BLOB; col.length = 8; col.subtype = 1; }
+    else if ((sscanf(t.c_str(), "NUMERIC(%d,%d)", &p, &s) == 2
+              || sscanf(t.c_str(), "DECIMAL(%d,%d)", &p, &s) == 2)
+             && p >= 1 && p <= 38 && s >= 0 && s <= p)
+    {
+        col.type = p <= 4 ? SQL_SHORT : p <= 9 ? SQL_LONG : p <= 18 ? SQL_INT64 : SQL_INT128;
+        col.length = p <= 4 ? 2 : p <= 9 ? 4 : p <= 18 ? 8 : 16;
+        col.scale = short(-s);
+    }
+    else if (sscanf(t.c_str(), "VARCHAR(%d)", &n) == 1 && n >= 1 && n <= 32765)
+    { col.type = SQL_VARYING; col.length = short(n); }
+    else if (sscanf(t.c_str(), "CHAR(%d)", &n) == 1 && n >= 1 && n <= 32767)
+    { col.type = SQL_TEXT; col.length = short(n); }
+    else
+        return false;
+    return true;
+}
+
+// Splits on the commas outside parentheses
+bool parseColumns(const char *text, MockColumns &cols)
+{
+    std::string spec;
+    int depth = 0;
+    for (const char *c = text; ; ++c)
+    {
+        if (*c == '\0' || (*c == ',' && depth == 0))
+        {
+            MockColumn col;
+            if (!parseColumn(spec, col))
+                return false;
+            cols.push_back(col);
+            spec.clear();
+            if (*c == '\0')
+                break;
+            continue;
+        }
+        if (*c == '(') ++depth;
+        else if (*c == ')') --depth;
+        spec += *c;
+    }
+    return !cols.empty();
+}
+
+long envLong(const char *name, long fallback)
+{
+    const char *v = getenv(name);
+    if (v == 0 || *v == '\0')
+        return fallback;
+    long n = strtol(v, 0, 10);
+    return n >= 0 ? n : fallback;
+}
+
+// Settings, read from the environment on first use. Callers hold configLock.
+MockConfig &currentConfig()
+{
+    if (!configured)
+    {
+        MockColumns *cols = new MockColumns;
+        const char *env = getenv("FBMOCK_COLUMNS");
+        if (env == 0 || !parseColumns(env, *cols))
+        {
+            if (env != 0)
+                fprintf(stderr, "fbmock: can't parse FBMOCK_COLUMNS \"%s\", using \"%s\"\n",
+                        env, defaultColumns);
+            cols->clear();
+            parseColumns(defaultColumns, *cols);
+        }
+        config.columns.reset(cols);
+        config.rows = envLong("FBMOCK_ROWS", 1000);
+        config.blobSize = envLong("FBMOCK_BLOB_SIZE", 4096);
+        config.nullEvery = int(envLong("FBMOCK_NULL_EVERY", 0));
+        configured = true;
+    }
+    return config;
+}
+
+//-----------------------------------------------------------------------//
+// Objects behind the handles
+
+struct MockStatement
+{
+    MockStatement() : db(0), type(0), params(0), inserts(false), open(false), row(0), rows(0),
+        nullEvery(0), fetched(0), affected(0), timeout(0) {}
+
+    unsigned long db;                           // Attachment
+    int type;                                   // isc_info_sql_stmt_*
+    int params;
+    bool inserts;                               // INSERT or EXECUTE BLOCK: rows kept
+    std::shared_ptr<const MockColumns> columns; // Result set, empty if none
+    bool open;
+    long row;
+    long rows;
+    int nullEvery;
+    long fetched;
+    long affected;
+    unsigned timeout;                           // IStatement::setTimeout(), msecs
+};
+
+struct MockBlob
+{
+    bool write;
+    long size;
+    long pos;
+};
+
+std::mutex handleLock;
+std::map<unsigned long, MockStatement *> statements;
+std::map<unsigned long, MockBlob *> blobs;
+std::set<unsigned long> extendedZones;     // Attachments with the EXTENDED binding
+unsigned long lastHandle = 0;
+
+template <typename H> unsigned long handleId(const H *h)
+{
+    return h == 0 ? 0 : (unsigned long)(uintptr_t)*h;
+}
+
+template <typename H> void setHandle(H *h, unsigned long id)
+{
+    *h = (H)(uintptr_t)id;
+}
+
+unsigned long newHandle()
+{
+    std::lock_guard<std::mutex> guard(handleLock);
+    return ++lastHandle;
+}
+
+// The items of a database parameter block the mock follows: a bind of "TIME
+// ZONE TO EXTENDED" (isc_dpb_set_bind) describes the time zone columns of
+// the attachment with their offset
+void attachOptions(unsigned long db, const unsigned char *dpb, unsigned length)
+{
+    bool extended = false;
+    unsigned i = 1;     // After the version
+    while (i + 2 <= length && i + 2 + dpb[i + 1] <= length)
+    {
+        const unsigned len = dpb[i + 1];
+        if (dpb[i] == isc_dpb_set_bind)
+        {
+            std::string bind;
+            for (unsigned j = 0; j < len; ++j)
+                if (!isspace(dpb[i + 2 + j]))
+                    bind += char(toupper(dpb[i + 2 + j]));
+            extended = bind.find("TIMEZONETOEXTENDED") != std::string::npos;
+        }
+        i += 2 + len;
+    }
+    std::lock_guard<std::mutex> guard(handleLock);
+    if (extended)
+        extendedZones.insert(db);
+}
+
+// The columns of a statement prepared on db
+std::shared_ptr<const MockColumns> attachmentColumns(unsigned long db,
+                                                     const std::shared_ptr<const MockColumns> &cols)
+{
+    {
+        std::lock_guard<std::mutex> guard(handleLock);
+        if (extendedZones.count(db) == 0)
+            return cols;
+    }
+    MockColumns *ext = new MockColumns(*cols);
+    for (size_t i = 0; i < ext->size(); ++i)
+    {
+        MockColumn &col = (*ext)[i];
+        if (col.type == SQL_TIMESTAMP_TZ || col.type == SQL_TIME_TZ)
+        {
+            col.type = col.type == SQL_TIMESTAMP_TZ ? SQL_TIMESTAMP_TZ_EX : SQL_TIME_TZ_EX;
+            col.length += 2;
+        }
+    }
+    return std::shared_ptr<const MockColumns>(ext);
+}
+
+// A statement or blob handle is used by one thread at a time: the object is
+// looked up under the lock and used without it
+template <typename T>
+T *lookup(std::map<unsigned long, T *> &objects, unsigned long id)
+{
+    std::lock_guard<std::mutex> guard(handleLock);
+    typename std::map<unsigned long, T *>::iterator it = objects.find(id);
+    return it == objects.end() ? 0 : it->second;
+}
+
+//-----------------------------------------------------------------------//
+// Cancellation: fb_cancel_operation() stops the execution delay running on
+// the attachment; a request made while none runs is dropped
+
+std::mutex cancelLock;
+std::condition_variable cancelRaised;
+std::set<unsigned long> executing;
+std::set<unsigned long> cancelled;
+
+// Waits for the execution delay, or the timeout of the statement when it is
+// shorter (0: none); false if cancelled meanwhile or timed out
+bool executionDelay(unsigned long db, unsigned timeout)
+{
+    int ms = executeDelay.load();
+    if (ms <= 0)
+        return true;
+    const bool timedOut = timeout != 0 && unsigned(ms) > timeout;
+    if (timedOut)
+        ms = int(timeout);
+    std::unique_lock<std::mutex> lock(cancelLock);
+    executing.insert(db);
+    const bool done = !cancelRaised.wait_for(lock, std::chrono::milliseconds(ms),
+                                             [db] { return cancelled.count(db) != 0; });
+    executing.erase(db);
+    cancelled.erase(db);
+    return done && !timedOut;
+}
+
+//-----------------------------------------------------------------------//
+// Status vectors
+
+ISC_STATUS success(ISC_STATUS *status)
+{
+    if (status != 0)
+    {
+        status[0] = isc_arg_gds;
+        status[1] = 0;
+        status[2] = isc_arg_end;
+    }
+    return 0;
+}
+
+ISC_STATUS failure(ISC_STATUS *status, ISC_STATUS code, const char *message)
+{
+    if (status != 0)
+    {
+        status[0] = isc_arg_gds;
+        status[1] = code;
+        status[2] = isc_arg_string;
+        status[3] = (ISC_STATUS)(uintptr_t)message;
+        status[4] = isc_arg_end;
+    }
+    return code;
+}
+
+//-----------------------------------------------------------------------//
+// Info buffers: item, 2 bytes length, value, ..., isc_info_end
+
+struct InfoWriter
+{
+    InfoWriter(char *buffer, short size) : p(buffer), end(buffer + size), full(false) {}
+
+    void put2(int v) { p[0] = char(v); p[1] = char(v >> 8); p += 2; }
+    void put4(int v) { put2(v); put2(v >> 16); }
+
+    bool room(int bytes)
+    {
+        // Keeps one byte for isc_info_end or isc_info_truncated
+        if (full || p + bytes + 1 > end)
+        {
+            full = true;
+            return false;
+        }
+        return true;
+    }
+    void value(char item, int v)
+    {
+        if (!room(7)) return;
+        *p++ = item; put2(4); put4(v);
+    }
+    void empty(char item)
+    {
+        if (!room(3)) return;
+        *p++ = item; put2(0);
+    }
+    void string(char item, const char *s)
+    {
+        int len = int(strlen(s));
+        if (!room(3 + len)) return;
+        *p++ = item; put2(len);
+        memcpy(p, s, len);
+        p += len;
+    }
+    void finish()
+    {
+        if (p < end)
+            *p++ = full ? isc_info_truncated : isc_info_end;
+    }
+
+    char *p;
+    char *end;
+    bool full;
+};
+
+int databaseInfo(char item)
+{
+    switch (item)
+    {
+    case isc_info_ods_version: return 12;       // Firebird 3
+    case isc_info_db_SQL_dialect: return 3;
+    case isc_info_page_size: return 16384;
+    case isc_info_num_buffers: return 2048;
+    case isc_info_sweep_interval: return 20000;
+    case isc_info_forced_writes: return 1;
+    case isc_info_allocation: return 1000;
+    default: return 0;
+    }
+}
+
+//-----------------------------------------------------------------------//
+// Statements
+
+// First keyword of the statement, upper case, comments skipped
+std::string firstKeyword(const char *sql, size_t len)
+{
+    size_t i = 0;
+    for (;;)
+    {
+        while (i < len && isspace((unsigned char)sql[i])) ++i;
+        if (i + 1 < len && sql[i] == '-' && sql[i + 1] == '-')
+        {
+            while (i < len && sql[i] != '\n') ++i;
+        }
+        else if (i + 1 < len && sql[i] == '/' && sql[i + 1] == '*')
+        {
+            const char *e = strstr(sql + i + 2, "*/");
+            i = e == 0 ? len : size_t(e - sql) + 2;
+        }
+        else
+            break;
+    }
+    std::string word;
+    while (i < len && (isalpha((unsigned char)sql[i]) || sql[i] == '_'))
+        word += char(toupper((unsigned char)sql[i++]));
+    return word;
+}
+
+// '?' outside of string literals and quoted names
+int countParams(const char *sql, size_t len)
+{
+    int count = 0;
+    char quote = 0;
+    for (size_t i = 0; i < len; ++i)
+    {
+        char c = sql[i];
+        if (quote != 0) { if (c == quote) quote = 0; }
+        else if (c == '\'' || c == '"') quote = c;
+        else if (c == '?') ++count;
+    }
+    return count;
+}
+
+// The first max words of the statement (keywords, names), upper case
+std::vector<std::string> statementWords(const char *sql, size_t len, size_t max)
+{
+    std::vector<std::string> words;
+    for (size_t i = 0; i < len && words.size() < max; )
+    {
+        std::string word;
+        while (i < len && (isalnum((unsigned char)sql[i]) || sql[i] == '_' || sql[i] == '$'))
+            word += char(toupper((unsigned char)sql[i++]));
+        if (word.empty())
+            ++i;
+        else
+            words.push_back(word);
+    }
+    return words;
+}
+
+int statementType(const std::string &word)
+{
+    if (word == "SELECT" || word == "WITH") return isc_info_sql_stmt_select;
+    if (word == "INSERT") return isc_info_sql_stmt_insert;
+    if (word == "UPDATE" || word == "MERGE") return isc_info_sql_stmt_update;
+    if (word == "DELETE") return isc_info_sql_stmt_delete;
+    if (word == "EXECUTE") return isc_info_sql_stmt_exec_procedure;
+    if (word == "SAVEPOINT" || word == "RELEASE") return isc_info_sql_stmt_savepoint;
+    return isc_info_sql_stmt_ddl;
+}
+
+void describeVar(XSQLVAR &var, const MockColumn &col, int index, bool output)
+{
+    var.sqltype = short(col.type | 1);
+    var.sqlscale = col.scale;
+    var.sqlsubtype = col.subtype;
+    var.sqllen = col.length;
+    if (output)
+    {
+        var.sqlname_length = short(sprintf(var.sqlname, "F%d", index + 1));
+        var.aliasname_length = short(sprintf(var.aliasname, "F%d", index + 1));
+        var.relname_length = short(sprintf(var.relname, "MOCK"));
+        var.ownname_length = short(sprintf(var.ownname, "SYSDBA"));
+    }
+    else
+    {
+        var.sqlname_length = var.aliasname_length = 0;
+        var.relname_length = var.ownname_length = 0;
+    }
+}
+
+// Describes count columns of cols, cycling through them, in da
+void describe(XSQLDA *da, const MockColumns *cols, int count, bool output)
+{
+    if (da == 0)
+        return;
+    da->sqld = short(count);
+    for (int i = 0; i < count && i < da->sqln; ++i)
+        describeVar(da->sqlvar[i], (*cols)[i % cols->size()], i, output);
+}
+
+const char letters[] = "abcdefghijklmnopqrstuvwxyz";
+
+// Generated text: the row number, then letters up to half the declared length
+int fillText(char *out, int capacity, long long row)
+{
+    char digits[24];
+    int n = sprintf(digits, "%lld", row);
+    if (n > capacity) n = capacity;
+    memcpy(out, digits, n);
+    int len = capacity / 2 > n ? capacity / 2 : n;
+    for (int i = n; i < len; ++i)
+        out[i] = letters[(row + i) % 26];
+    return len;
+}
+
+// Zones of the WITH TIME ZONE values, row after row: an offset, a region
+// and GMT. The numbers of the regions other than GMT are those of the mock.
+struct MockZone
+{
+    unsigned short id;
+    const char *name;
+    short offset;       // Minutes
+};
+
+const MockZone zones[] =
+{
+    { 1439 + 120, "+02:00", 120 },
+    { 65000, "Asia/Kolkata", 330 },
+    { 65535, "GMT", 0 },
+};
+
+const MockZone *findZone(unsigned id)
+{
+    for (size_t i = 0; i < sizeof(zones) / sizeof(zones[0]); ++i)
+        if (zones[i].id == id)
+            return &zones[i];
+    return 0;
+}
+
+// The zone of a row after its UTC value, and the offset for the _EX types
+void fillZone(char *data, long long row, bool extended)
+{
+    const MockZone &zone = zones[row % (sizeof(zones) / sizeof(zones[0]))];
+    memcpy(data, &zone.id, sizeof(zone.id));
+    if (extended)
+        memcpy(data + sizeof(zone.id), &zone.offset, sizeof(zone.offset));
+}
+
+void fillRow(XSQLDA *da, const MockStatement *st, long long row)
+{
+    const MockColumns &cols = *st->columns;
+    bool null = st->nullEvery > 0 && (row + 1) % st->nullEvery == 0;
+    for (int i = 0; i < da->sqld && i < da->sqln && i < int(cols.size()); ++i)
+    {
+        XSQLVAR &var = da->sqlvar[i];
+        if (var.sqlind != 0)
+            *var.sqlind = null ? -1 : 0;
+        if (null || var.sqldata == 0)
+            continue;
+        char *data = var.sqldata;
+        switch (var.sqltype & ~1)
+        {
+        case SQL_SHORT: *(ISC_SHORT *)data = ISC_SHORT((row + i) % 10000); break;
+        case SQL_LONG: *(ISC_LONG *)data = ISC_LONG(row + i); break;
+        case SQL_INT64: *(ISC_INT64 *)data = row * 1000003 + i; break;
+        case SQL_INT128:
+        {
+            // The low word, then the high one: (row - 2) * 2^120 + row * 1000003 + i
+            const ISC_UINT64 words[2] = { ISC_UINT64(row * 1000003 + i), ISC_UINT64(row - 2) << 56 };
+            memcpy(data, words, sizeof(words));
+            break;
+        }
+        case SQL_FLOAT: *(float *)data = float(row) * 0.25f + i; break;
+        case SQL_DOUBLE: *(double *)data = double(row) * 0.5 + i; break;
+        case SQL_BOOLEAN: *data = char((row + i) & 1); break;
+        case SQL_TYPE_DATE: *(ISC_DATE *)data = ISC_DATE(58849 + row % 3653); break;   // From 2020-01-01
+        case SQL_TYPE_TIME: *(ISC_TIME *)data = ISC_TIME((row % 86400) * 10000 + i); break;
+        case SQL_TIMESTAMP:
+        case SQL_TIMESTAMP_TZ:
+        case SQL_TIMESTAMP_TZ_EX:
+            ((ISC_TIMESTAMP *)data)->timestamp_date = ISC_DATE(58849 + row % 3653);
+            ((ISC_TIMESTAMP *)data)->timestamp_time = ISC_TIME((row % 86400) * 10000);
+            if ((var.sqltype & ~1) != SQL_TIMESTAMP)
+                fillZone(data + sizeof(ISC_TIMESTAMP), row, (var.sqltype & ~1) == SQL_TIMESTAMP_TZ_EX);
+            break;
+        case SQL_TIME_TZ:
+        case SQL_TIME_TZ_EX:
+            *(ISC_TIME *)data = ISC_TIME((row % 86400) * 10000);
+            fillZone(data + sizeof(ISC_TIME), row, (var.sqltype & ~1) == SQL_TIME_TZ_EX);
+            break;
+        case SQL_TEXT:
+        {
+            int len = fillText(data, var.sqllen, row);
+            memset(data + len, ' ', var.sqllen - len);
+            break;
+        }
+        case SQL_VARYING:
+            *(ISC_USHORT *)data = ISC_USHORT(fillText(data + 2, var.sqllen, row));
+            break;
+        case SQL_BLOB:
+        case SQL_ARRAY:
+            ((ISC_QUAD *)data)->gds_quad_high = ISC_LONG(i + 1);
+            ((ISC_QUAD *)data)->gds_quad_low = ISC_ULONG(row);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------//
+// Inserted rows: the parameters of the INSERT and EXECUTE BLOCK statements
+// as text, "1|abc|NULL", cut in rows of as many values as the configured
+// columns. They wait in the work of their transaction until it commits, a
+// rollback drops them, and so does a ROLLBACK TO SAVEPOINT back to the
+// savepoint.
+
+struct MockWork
+{
+    std::vector<std::string> rows;
+    std::vector<std::pair<std::string, size_t> > savepoints;   // Name, rows before
+};
+
+std::mutex tableLock;
+std::map<unsigned long, MockWork> works;    // By transaction
+std::vector<std::string> committedRows;
+std::string insertError;                    // Value of the rows that fail
+
+std::string scaledText(long long value, int scale)
+{
+    char digits[24];
+    snprintf(digits, sizeof(digits), "%llu",
+             value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value);
+    std::string text(digits);
+    if (scale < 0)
+    {
+        if (int(text.size()) <= -scale)
+            text.insert(0, size_t(1 - scale) - text.size(), '0');
+        text.insert(text.size() + scale, ".");
+    }
+    return value < 0 ? "-" + text : text;
+}
+
+// Dates and times are written as their ISC_DATE and ISC_TIME numbers
+std::string valueText(const XSQLVAR &var)
+{
+    if ((var.sqlind != 0 && *var.sqlind < 0) || var.sqldata == 0)
+        return "NULL";
+    const char *data = var.sqldata;
+    char text[32];
+    switch (var.sqltype & ~1)
+    {
+    case SQL_TEXT:
+    {
+        std::string value(data, var.sqllen);
+        value.erase(value.find_last_not_of(' ') + 1);
+        return value;
+    }
+    case SQL_VARYING: return std::string(data + 2, *(const ISC_USHORT *)data);
+    case SQL_SHORT: return scaledText(*(const ISC_SHORT *)data, var.sqlscale);
+    case SQL_LONG: return scaledText(*(const ISC_LONG *)data, var.sqlscale);
+    case SQL_INT64: return scaledText(*(const ISC_INT64 *)data, var.sqlscale);
+    case SQL_FLOAT: snprintf(text, sizeof(text), "%g", double(*(const float *)data)); return text;
+    case SQL_DOUBLE: snprintf(text, sizeof(text), "%g", *(const double *)data); return text;
+    case SQL_BOOLEAN: return *data != 0 ? "true" : "false";
+    case SQL_TYPE_DATE: return std::to_string(*(const ISC_DATE *)data);
+    case SQL_TYPE_TIME: return std::to_string(*(const ISC_TIME *)data);
+    case SQL_TIMESTAMP:
+        return std::to_string(((const ISC_TIMESTAMP *)data)->timestamp_date) + " "
+            + std::to_string(((const ISC_TIMESTAMP *)data)->timestamp_time);
+    default: return "?";
+    }
+}
+
+// Keeps the rows of the parameters in the work of tr; none if one of their
+// values is the one set by fbmock_set_insert_error()
+bool insertRows(unsigned long tr, const MockStatement *st, const XSQLDA *in)
+{
+    const int width = int(st->columns->size());
+    std::vector<std::string> rows;
+    std::string row;
+    for (int i = 0; i < in->sqld && i < in->sqln; ++i)
+    {
+        const std::string value = valueText(in->sqlvar[i]);
+        {
+            std::lock_guard<std::mutex> guard(tableLock);
+            if (!insertError.empty() && value == insertError)
+                return false;
+        }
+        row += (i % width == 0 ? "" : "|") + value;
+        if ((i + 1) % width == 0 || i + 1 == in->sqld)
+        {
+            rows.push_back(row);
+            row.clear();
+        }
+    }
+    std::lock_guard<std::mutex> guard(tableLock);
+    std::vector<std::string> &work = works[tr].rows;
+    work.insert(work.end(), rows.begin(), rows.end());
+    return true;
+}
+
+// Commits or drops the rows of tr, whose savepoints go
+void endWork(unsigned long tr, bool commit)
+{
+    std::lock_guard<std::mutex> guard(tableLock);
+    std::map<unsigned long, MockWork>::iterator it = works.find(tr);
+    if (it == works.end())
+        return;
+    if (commit)
+        committedRows.insert(committedRows.end(), it->second.rows.begin(), it->second.rows.end());
+    works.erase(it);
+}
+
+// SAVEPOINT name, ROLLBACK [WORK] TO [SAVEPOINT] name and RELEASE SAVEPOINT
+// name [ONLY]; the other statements are ignored
+void savepointStatement(unsigned long tr, const char *sql, size_t len)
+{
+    const std::vector<std::string> words = statementWords(sql, len, 6);
+    if (words.size() < 2)
+        return;
+    std::lock_guard<std::mutex> guard(tableLock);
+    MockWork &work = works[tr];
+    std::vector<std::pair<std::string, size_t> > &marks = work.savepoints;
+    if (words[0] == "SAVEPOINT")
+    {
+        marks.push_back(std::make_pair(words[1], work.rows.size()));
+        return;
+    }
+    const bool rollback = words[0] == "ROLLBACK" && words.size() >= 3
+        && std::find(words.begin(), words.end(), "TO") != words.end();
+    const bool release = words[0] == "RELEASE" && words.size() >= 3;
+    if (!rollback && !release)
+        return;
+    const std::string &name = release ? words[2] : words.back();
+    size_t i = marks.size();
+    while (i > 0 && marks[i - 1].first != name)
+        --i;
+    if (i == 0)
+        return;
+    if (rollback)
+    {
+        // The savepoint stays, those started after it go
+        work.rows.resize(marks[i - 1].second);
+        marks.resize(i);
+    }
+    else if (words.back() == "ONLY")
+        marks.erase(marks.begin() + (i - 1));
+    else
+        marks.resize(i - 1);
+}
+
+//-----------------------------------------------------------------------//
+// Executions
+
+// in: the parameters, out: the row of a singleton SELECT
+ISC_STATUS executeStatement(ISC_STATUS *status, unsigned long tr, isc_stmt_handle *stmt,
+                            const XSQLDA *in, XSQLDA *out)
+{
+    MockStatement *st = lookup(statements, handleId(stmt));
+    if (st == 0)
+        return failure(status, isc_bad_stmt_handle, "fbmock: invalid statement handle");
+    if (!executionDelay(st->db, st->timeout))
+        return failure(status, isc_cancelled, "fbmock: operation was cancelled");
+    if (st->inserts && in != 0 && !insertRows(tr, st, in))
+        return failure(status, isc_unique_key_violation, "fbmock: violation of PRIMARY KEY constraint");
+    if (st->type == isc_info_sql_stmt_select)
+    {
+        if (out != 0)
+        {
+            // Singleton SELECT
+            fillRow(out, st, 0);
+            st->fetched = 1;
+            return success(status);
+        }
+        std::lock_guard<std::mutex> guard(configLock);
+        st->open = true;
+        st->row = 0;
+        st->rows = currentConfig().rows;
+        st->nullEvery = currentConfig().nullEvery;
+        st->fetched = 0;
+    }
+    else if (st->type == isc_info_sql_stmt_insert || st->type == isc_info_sql_stmt_update
+             || st->type == isc_info_sql_stmt_delete)
+        st->affected = 1;
+    return success(status);
+}
+
+// The next row of the open cursor in out: 0, 100 at the end
+ISC_STATUS fetchStatement(ISC_STATUS *status, isc_stmt_handle *stmt, XSQLDA *out)
+{
+    MockStatement *st = lookup(statements, handleId(stmt));
+    if (st == 0)
+        return failure(status, isc_bad_stmt_handle, "fbmock: invalid statement handle");
+    if (!st->open)
+        return failure(status, isc_dsql_cursor_err, "fbmock: the cursor is not open");
+    if (st->row == fetchError.load())
+        return failure(status, isc_io_error, "fbmock: fetch error");
+    success(status);
+    if (st->row >= st->rows)
+        return 100;
+    fillRow(out, st, st->row++);
+    st->fetched = st->row;
+    return 0;
+}
+
+//-----------------------------------------------------------------------//
+// Blobs
+
+const int patternSize = 65536 + 26;
+char pattern[patternSize];
+std::once_flag patternOnce;
+
+void makePattern()
+{
+    for (int i = 0; i < patternSize; ++i)
+        pattern[i] = letters[i % 26];
+}
+
+ISC_STATUS openBlob(ISC_STATUS *status, isc_blob_handle *blob, bool write)
+{
+    MockBlob *b = new MockBlob;
+    b->write = write;
+    b->pos = 0;
+    {
+        std::lock_guard<std::mutex> guard(configLock);
+        b->size = write ? 0 : currentConfig().blobSize;
+    }
+    unsigned long id = newHandle();
+    {
+        std::lock_guard<std::mutex> guard(handleLock);
+        blobs[id] = b;
+    }
+    setHandle(blob, id);
+    return success(status);
+}
+
+ISC_STATUS closeBlob(ISC_STATUS *status, isc_blob_handle *blob)
+{
+    MockBlob *b = 0;
+    {
+        std::lock_guard<std::mutex> guard(handleLock);
+        std::map<unsigned long, MockBlob *>::iterator it = blobs.find(handleId(blob));
+        if (it != blobs.end())
+        {
+            b = it->second;
+            blobs.erase(it);
+        }
+    }
+    if (b == 0)
+        return failure(status, isc_bad_segstr_handle, "fbmock: invalid blob handle");
+    delete b;
+    setHandle(blob, 0);
+    return success(status);
+}
+
+//-----------------------------------------------------------------------//
+// Arrays: the columns are named F1, F2..., the element j of the array of row
+// r has the value r + j
+
+bool arrayColumn(const ISC_SCHAR *field, MockColumn &col)
+{
+    int index = 0;
+    if (field == 0 || sscanf(field, "F%d", &index) != 1 || index < 1)
+        return false;
+    std::lock_guard<std::mutex> guard(configLock);
+    const MockColumns &cols = *currentConfig().columns;
+    col = cols[(index - 1) % cols.size()];
+    return col.type == SQL_ARRAY;
+}
+
+unsigned char arrayType(short type)
+{
+    switch (type)
+    {
+    case SQL_SHORT: return blr_short;
+    case SQL_LONG: return blr_long;
+    case SQL_INT64: return blr_int64;
+    case SQL_FLOAT: return blr_float;
+    default: return blr_double;
+    }
+}
+
+template <typename T> void fillArray(void *slice, long count, unsigned long row)
+{
+    T *elem = (T *)slice;
+    for (long j = 0; j < count; ++j)
+        elem[j] = T(row + j);
+}
+
+#define FBMOCK_CALL() callCount.fetch_add(1, std::memory_order_relaxed)
+
+} // namespace
+
+//-----------------------------------------------------------------------//
+// Extra entry points
+
+int fbmock_configure(const char *columns, int rows, int blobSize)
+{
+    MockColumns *cols = 0;
+    if (columns != 0)
+    {
+        cols = new MockColumns;
+        if (!parseColumns(columns, *cols))
+        {
+            delete cols;
+            return -1;
+        }
+    }
+    std::lock_guard<std::mutex> guard(configLock);
+    MockConfig &c = currentConfig();
+    if (cols != 0) c.columns.reset(cols);
+    if (rows >= 0) c.rows = rows;
+    if (blobSize >= 0) c.blobSize = blobSize;
+    return 0;
+}
+
+void fbmock_set_null_every(int nullEvery)
+{
+    std::lock_guard<std::mutex> guard(configLock);
+    currentConfig().nullEvery = nullEvery > 0 ? nullEvery : 0;
+}
+
+unsigned long long fbmock_calls(void)
+{
+    return callCount.load(std::memory_order_relaxed);
+}
+
+void fbmock_set_execute_delay(int msecs)
+{
+    executeDelay.store(msecs > 0 ? msecs : 0);
+}
+
+void fbmock_set_fetch_error(int row)
+{
+    fetchError.store(row >= 0 ? row : -1);
+}
+
+void fbmock_set_scrollable_cursors(int enabled)
+{
+    scrollable.store(enabled != 0);
+}
+
+void fbmock_set_insert_error(const char *value)
+{
+    std::lock_guard<std::mutex> guard(tableLock);
+    insertError = value != 0 ? value : "";
+}
+
+int fbmock_inserted_rows(void)
+{
+    std::lock_guard<std::mutex> guard(tableLock);
+    return int(committedRows.size());
+}
+
+int fbmock_inserted_row(int index, char *buffer, int size)
+{
+    std::lock_guard<std::mutex> guard(tableLock);
+    if (index < 0 || index >= int(committedRows.size()))
+        return -1;
+    const std::string &row = committedRows[index];
+    if (buffer != 0 && size > 0)
+        snprintf(buffer, size_t(size), "%s", row.c_str());
+    return int(row.size());
+}
+
+void fbmock_clear_inserted_rows(void)
+{
+    std::lock_guard<std::mutex> guard(tableLock);
+    committedRows.clear();
+}
+
+//-----------------------------------------------------------------------//
+// Attachments and transactions
+
+ISC_STATUS ISC_EXPORT isc_create_database(ISC_STATUS *status, short, const ISC_SCHAR *,
+                                          isc_db_handle *db, short, const ISC_SCHAR *, short)
+{
+    FBMOCK_CALL();
+    setHandle(db, newHandle());
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_attach_database(ISC_STATUS *status, short, const ISC_SCHAR *,
+                                          isc_db_handle *db, short dpbLength, const ISC_SCHAR *dpb)
+{
+    FBMOCK_CALL();
+    const unsigned long id = newHandle();
+    attachOptions(id, (const unsigned char *)dpb, dpbLength < 0 ? 0 : unsigned(dpbLength));
+    setHandle(db, id);
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_detach_database(ISC_STATUS *status, isc_db_handle *db)
+{
+    FBMOCK_CALL();
+    if (handleId(db) == 0)
+        return failure(status, isc_bad_db_handle, "fbmock: invalid database handle");
+    {
+        std::lock_guard<std::mutex> guard(handleLock);
+        extendedZones.erase(handleId(db));
+    }
+    setHandle(db, 0);
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_drop_database(ISC_STATUS *status, isc_db_handle *db)
+{
+    return isc_detach_database(status, db);
+}
+
+// Not declared by this ibase.h (Firebird 2.5)
+extern "C" ISC_STATUS ISC_EXPORT fb_cancel_operation(ISC_STATUS *status, isc_db_handle *db, ISC_USHORT option)
+{
+    FBMOCK_CALL();
+    if (handleId(db) == 0)
+        return failure(status, isc_bad_db_handle, "fbmock: invalid database handle");
+    if (option == fb_cancel_raise)
+    {
+        std::lock_guard<std::mutex> guard(cancelLock);
+        if (executing.count(handleId(db)) != 0)
+        {
+            cancelled.insert(handleId(db));
+            cancelRaised.notify_all();
+        }
+    }
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_database_info(ISC_STATUS *status, isc_db_handle *db,
+                                        short itemsLength, const ISC_SCHAR *items,
+                                        short bufferLength, ISC_SCHAR *buffer)
+{
+    FBMOCK_CALL();
+    if (handleId(db) == 0)
+        return failure(status, isc_bad_db_handle, "fbmock: invalid database handle");
+    InfoWriter w(buffer, bufferLength);
+    for (int i = 0; i < itemsLength && items[i] != isc_info_end; ++i)
+    {
+        // The per table counts (isc_info_read_seq_count...) are empty lists
+        if (items[i] >= isc_info_read_seq_count && items[i] <= isc_info_expunge_count)
+            w.empty(items[i]);
+        else
+            w.value(items[i], databaseInfo(items[i]));
+    }
+    w.finish();
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_start_multiple(ISC_STATUS *status, isc_tr_handle *tr, short, void *)
+{
+    FBMOCK_CALL();
+    setHandle(tr, newHandle());
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_commit_transaction(ISC_STATUS *status, isc_tr_handle *tr)
+{
+    FBMOCK_CALL();
+    if (handleId(tr) == 0)
+        return failure(status, isc_bad_trans_handle, "fbmock: invalid transaction handle");
+    endWork(handleId(tr), true);
+    setHandle(tr, 0);
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_rollback_transaction(ISC_STATUS *status, isc_tr_handle *tr)
+{
+    FBMOCK_CALL();
+    if (handleId(tr) == 0)
+        return failure(status, isc_bad_trans_handle, "fbmock: invalid transaction handle");
+    endWork(handleId(tr), false);
+    setHandle(tr, 0);
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_commit_retaining(ISC_STATUS *status, isc_tr_handle *tr)
+{
+    FBMOCK_CALL();
+    if (handleId(tr) == 0)
+        return failure(status, isc_bad_trans_handle, "fbmock: invalid transaction handle");
+    endWork(handleId(tr), true);
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_rollback_retaining(ISC_STATUS *status, isc_tr_handle *tr)
+{
+    FBMOCK_CALL();
+    if (handleId(tr) == 0)
+        return failure(status, isc_bad_trans_handle, "fbmock: invalid transaction handle");
+    endWork(handleId(tr), false);
+    return success(status);
+}
+
+//-----------------------------------------------------------------------//
+// Statements
+
+ISC_STATUS ISC_EXPORT isc_dsql_allocate_statement(ISC_STATUS *status, isc_db_handle *db,
+                                                  isc_stmt_handle *stmt)
+{
+    FBMOCK_CALL();
+    if (handleId(db) == 0)
+        return failure(status, isc_bad_db_handle, "fbmock: invalid database handle");
+    unsigned long id = newHandle();
+    MockStatement *st = new MockStatement;
+    st->db = handleId(db);
+    {
+        std::lock_guard<std::mutex> guard(handleLock);
+        statements[id] = st;
+    }
+    setHandle(stmt, id);
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_dsql_free_statement(ISC_STATUS *status, isc_stmt_handle *stmt,
+                                              unsigned short option)
+{
+    FBMOCK_CALL();
+    MockStatement *st = 0;
+    {
+        std::lock_guard<std::mutex> guard(handleLock);
+        std::map<unsigned long, MockStatement *>::iterator it = statements.find(handleId(stmt));
+        if (it != statements.end())
+        {
+            st = it->second;
+            if (option == DSQL_drop)
+                statements.erase(it);
+        }
+    }
+    if (st == 0)
+        return failure(status, isc_bad_stmt_handle, "fbmock: invalid statement handle");
+    if (option == DSQL_drop)
+    {
+        delete st;
+        setHandle(stmt, 0);
+    }
+    else
+        st->open = false;
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_dsql_prepare(ISC_STATUS *status, isc_tr_handle *, isc_stmt_handle *stmt,
+                                       unsigned short length, const ISC_SCHAR *sql,
+                                       unsigned short, XSQLDA *out)
+{
+    FBMOCK_CALL();
+    MockStatement *st = lookup(statements, handleId(stmt));
+    if (st == 0)
+        return failure(status, isc_bad_stmt_handle, "fbmock: invalid statement handle");
+    size_t len = length != 0 ? length : strlen(sql);
+    const std::string keyword = firstKeyword(sql, len);
+    st->type = statementType(keyword);
+    st->params = countParams(sql, len);
+    st->inserts = keyword == "INSERT"
+        || (keyword == "EXECUTE" && statementWords(sql, len, 2).back() == "BLOCK");
+    st->open = false;
+    st->fetched = st->affected = 0;
+    {
+        std::lock_guard<std::mutex> guard(configLock);
+        st->columns = currentConfig().columns;
+    }
+    st->columns = attachmentColumns(st->db, st->columns);
+    if (out != 0)
+    {
+        if (st->type == isc_info_sql_stmt_select)
+            describe(out, st->columns.get(), int(st->columns->size()), true);
+        else
+            out->sqld = 0;
+    }
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_dsql_describe(ISC_STATUS *status, isc_stmt_handle *stmt,
+                                        unsigned short, XSQLDA *out)
+{
+    FBMOCK_CALL();
+    MockStatement *st = lookup(statements, handleId(stmt));
+    if (st == 0 || !st->columns)
+        return failure(status, isc_bad_stmt_handle, "fbmock: invalid statement handle");
+    if (st->type == isc_info_sql_stmt_select)
+        describe(out, st->columns.get(), int(st->columns->size()), true);
+    else
+        out->sqld = 0;
+    return success(status);
+}
+
+// Parameters take the types of the configured columns, in turn
+ISC_STATUS ISC_EXPORT isc_dsql_describe_bind(ISC_STATUS *status, isc_stmt_handle *stmt,
+                                             unsigned short, XSQLDA *in)
+{
+    FBMOCK_CALL();
+    MockStatement *st = lookup(statements, handleId(stmt));
+    if (st == 0 || !st->columns)
+        return failure(status, isc_bad_stmt_handle, "fbmock: invalid statement handle");
+    describe(in, st->columns.get(), st->params, false);
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_dsql_sql_info(ISC_STATUS *status, isc_stmt_handle *stmt,
+                                        short itemsLength, const ISC_SCHAR *items,
+                                        short bufferLength, ISC_SCHAR *buffer)
+{
+    FBMOCK_CALL();
+    MockStatement *st = lookup(statements, handleId(stmt));
+    if (st == 0)
+        return failure(status, isc_bad_stmt_handle, "fbmock: invalid statement handle");
+    InfoWriter w(buffer, bufferLength);
+    for (int i = 0; i < itemsLength && items[i] != isc_info_end; ++i)
+    {
+        switch (items[i])
+        {
+        case isc_info_sql_stmt_type:
+            w.value(items[i], st->type);
+            break;
+        case isc_info_sql_get_plan:
+            w.string(items[i], "\nPLAN (MOCK NATURAL)");
+            break;
+        case isc_info_sql_records:
+            if (w.room(3 + 4 * 7))
+            {
+                *w.p++ = items[i];
+                w.put2(4 * 7);
+                int counts[4] = { 0, 0, 0, 0 };
+                if (st->type == isc_info_sql_stmt_select) counts[0] = int(st->fetched);
+                else if (st->type == isc_info_sql_stmt_insert) counts[1] = int(st->affected);
+                else if (st->type == isc_info_sql_stmt_update) counts[2] = int(st->affected);
+                else if (st->type == isc_info_sql_stmt_delete) counts[3] = int(st->affected);
+                for (int k = 0; k < 4; ++k)
+                {
+                    *w.p++ = char(isc_info_req_select_count + k);
+                    w.put2(4);
+                    w.put4(counts[k]);
+                }
+            }
+            break;
+        default:
+            w.empty(items[i]);
+            break;
+        }
+    }
+    w.finish();
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_dsql_execute(ISC_STATUS *status, isc_tr_handle *tr, isc_stmt_handle *stmt,
+                                       unsigned short, XSQLDA *in)
+{
+    FBMOCK_CALL();
+    return executeStatement(status, handleId(tr), stmt, in, 0);
+}
+
+ISC_STATUS ISC_EXPORT isc_dsql_execute2(ISC_STATUS *status, isc_tr_handle *tr, isc_stmt_handle *stmt,
+                                        unsigned short, XSQLDA *in, XSQLDA *out)
+{
+    FBMOCK_CALL();
+    return executeStatement(status, handleId(tr), stmt, in, out);
+}
+
+// Savepoints are followed, the other statements do nothing
+ISC_STATUS ISC_EXPORT isc_dsql_execute_immediate(ISC_STATUS *status, isc_db_handle *db,
+                                                 isc_tr_handle *tr, unsigned short length,
+                                                 const ISC_SCHAR *sql, unsigned short, XSQLDA *)
+{
+    FBMOCK_CALL();
+    if (handleId(db) == 0)
+        return failure(status, isc_bad_db_handle, "fbmock: invalid database handle");
+    if (sql != 0 && handleId(tr) != 0)
+        savepointStatement(handleId(tr), sql, length != 0 ? length : strlen(sql));
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_dsql_fetch(ISC_STATUS *status, isc_stmt_handle *stmt,
+                                     unsigned short, XSQLDA *out)
+{
+    FBMOCK_CALL();
+    return fetchStatement(status, stmt, out);
+}
+
+ISC_STATUS ISC_EXPORT isc_dsql_set_cursor_name(ISC_STATUS *status, isc_stmt_handle *,
+                                               const ISC_SCHAR *, unsigned short)
+{
+    FBMOCK_CALL();
+    return success(status);
+}
+
+//-----------------------------------------------------------------------//
+// Blobs, arrays and events
+
+ISC_STATUS ISC_EXPORT isc_open_blob2(ISC_STATUS *status, isc_db_handle *, isc_tr_handle *,
+                                     isc_blob_handle *blob, ISC_QUAD *, ISC_USHORT,
+                                     const ISC_UCHAR *)
+{
+    FBMOCK_CALL();
+    std::call_once(patternOnce, makePattern);
+    return openBlob(status, blob, false);
+}
+
+ISC_STATUS ISC_EXPORT isc_create_blob2(ISC_STATUS *status, isc_db_handle *, isc_tr_handle *,
+                                       isc_blob_handle *blob, ISC_QUAD *id, short,
+                                       const ISC_SCHAR *)
+{
+    FBMOCK_CALL();
+    unsigned long n = newHandle();
+    id->gds_quad_high = ISC_LONG(-1);
+    id->gds_quad_low = ISC_ULONG(n);
+    return openBlob(status, blob, true);
+}
+
+ISC_STATUS ISC_EXPORT isc_close_blob(ISC_STATUS *status, isc_blob_handle *blob)
+{
+    FBMOCK_CALL();
+    return closeBlob(status, blob);
+}
+
+ISC_STATUS ISC_EXPORT isc_cancel_blob(ISC_STATUS *status, isc_blob_handle *blob)
+{
+    FBMOCK_CALL();
+    if (handleId(blob) == 0)
+        return success(status);
+    return closeBlob(status, blob);
+}
+
+ISC_STATUS ISC_EXPORT isc_get_segment(ISC_STATUS *status, isc_blob_handle *blob,
+                                      unsigned short *read, unsigned short bufferLength,
+                                      ISC_SCHAR *buffer)
+{
+    FBMOCK_CALL();
+    MockBlob *b = lookup(blobs, handleId(blob));
+    *read = 0;
+    if (b == 0)
+        return failure(status, isc_bad_segstr_handle, "fbmock: invalid blob handle");
+    if (b->write)
+        return failure(status, isc_segstr_no_read, "fbmock: the blob is opened for write");
+    long left = b->size - b->pos;
+    if (left <= 0)
+        return failure(status, isc_segstr_eof, "fbmock: end of blob");
+    unsigned short n = left < bufferLength ? (unsigned short)left : bufferLength;
+    memcpy(buffer, pattern + b->pos % 26, n);
+    b->pos += n;
+    *read = n;
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_put_segment(ISC_STATUS *status, isc_blob_handle *blob,
+                                      unsigned short length, const ISC_SCHAR *)
+{
+    FBMOCK_CALL();
+    MockBlob *b = lookup(blobs, handleId(blob));
+    if (b == 0)
+        return failure(status, isc_bad_segstr_handle, "fbmock: invalid blob handle");
+    if (!b->write)
+        return failure(status, isc_segstr_no_write, "fbmock: the blob is opened for read");
+    b->size += length;
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_blob_info(ISC_STATUS *status, isc_blob_handle *blob,
+                                    short itemsLength, const ISC_SCHAR *items,
+                                    short bufferLength, ISC_SCHAR *buffer)
+{
+    FBMOCK_CALL();
+    MockBlob *b = lookup(blobs, handleId(blob));
+    if (b == 0)
+        return failure(status, isc_bad_segstr_handle, "fbmock: invalid blob handle");
+    const long segment = 32767;
+    InfoWriter w(buffer, bufferLength);
+    for (int i = 0; i < itemsLength && items[i] != isc_info_end; ++i)
+    {
+        switch (items[i])
+        {
+        case isc_info_blob_total_length: w.value(items[i], int(b->size)); break;
+        case isc_info_blob_max_segment: w.value(items[i], int(b->size < segment ? b->size : segment)); break;
+        case isc_info_blob_num_segments: w.value(items[i], int((b->size + segment - 1) / segment)); break;
+        case isc_info_blob_type: w.value(items[i], 0); break;
+        default: w.empty(items[i]); break;
+        }
+    }
+    w.finish();
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_array_lookup_bounds(ISC_STATUS *status, isc_db_handle *, isc_tr_handle *,
+                                              const ISC_SCHAR *relation, const ISC_SCHAR *field,
+                                              ISC_ARRAY_DESC *desc)
+{
+    FBMOCK_CALL();
+    MockColumn col;
+    if (!arrayColumn(field, col))
+        return failure(status, isc_wish_list, "fbmock: the column is not an array");
+    memset(desc, 0, sizeof(*desc));
+    desc->array_desc_dtype = arrayType(col.elementType);
+    desc->array_desc_scale = ISC_SCHAR(col.scale);
+    desc->array_desc_length = ISC_USHORT(col.elementLength);
+    strncpy(desc->array_desc_field_name, field, sizeof(desc->array_desc_field_name) - 1);
+    if (relation != 0)
+        strncpy(desc->array_desc_relation_name, relation, sizeof(desc->array_desc_relation_name) - 1);
+    desc->array_desc_dimensions = 1;
+    desc->array_desc_bounds[0].array_bound_lower = 1;
+    desc->array_desc_bounds[0].array_bound_upper = col.elements;
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_array_get_slice(ISC_STATUS *status, isc_db_handle *, isc_tr_handle *,
+                                          ISC_QUAD *id, const ISC_ARRAY_DESC *desc, void *slice,
+                                          ISC_LONG *sliceLength)
+{
+    FBMOCK_CALL();
+    long count = 1;
+    for (int d = 0; d < desc->array_desc_dimensions; ++d)
+        count *= desc->array_desc_bounds[d].array_bound_upper
+                 - desc->array_desc_bounds[d].array_bound_lower + 1;
+    const long bytes = count * desc->array_desc_length;
+    if (*sliceLength < bytes)
+        return failure(status, isc_wish_list, "fbmock: the slice buffer is too small");
+    const unsigned long row = id->gds_quad_low;
+    switch (desc->array_desc_dtype)
+    {
+    case blr_short: fillArray<ISC_SHORT>(slice, count, row); break;
+    case blr_long: fillArray<ISC_LONG>(slice, count, row); break;
+    case blr_int64: fillArray<ISC_INT64>(slice, count, row); break;
+    case blr_float: fillArray<float>(slice, count, row); break;
+    case blr_double: fillArray<double>(slice, count, row); break;
+    default: return failure(status, isc_wish_list, "fbmock: arrays of this type are not simulated");
+    }
+    *sliceLength = ISC_LONG(bytes);
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_array_put_slice(ISC_STATUS *status, isc_db_handle *, isc_tr_handle *,
+                                          ISC_QUAD *id, const ISC_ARRAY_DESC *, void *, ISC_LONG *)
+{
+    FBMOCK_CALL();
+    id->gds_quad_high = ISC_LONG(-1);
+    id->gds_quad_low = ISC_ULONG(newHandle());
+    return success(status);
+}
+
+// Events are accepted and never posted
+ISC_STATUS ISC_EXPORT isc_que_events(ISC_STATUS *status, isc_db_handle *, ISC_LONG *id, short,
+                                     const ISC_UCHAR *, ISC_EVENT_CALLBACK, void *)
+{
+    FBMOCK_CALL();
+    *id = ISC_LONG(newHandle());
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_cancel_events(ISC_STATUS *status, isc_db_handle *, ISC_LONG *)
+{
+    FBMOCK_CALL();
+    return success(status);
+}
+
+//-----------------------------------------------------------------------//
+// Services are not simulated
+
+ISC_STATUS ISC_EXPORT isc_service_attach(ISC_STATUS *status, unsigned short, const ISC_SCHAR *,
+                                         isc_svc_handle *, unsigned short, const ISC_SCHAR *)
+{
+    FBMOCK_CALL();
+    return failure(status, isc_wish_list, "fbmock: services are not simulated");
+}
+
+ISC_STATUS ISC_EXPORT isc_service_detach(ISC_STATUS *status, isc_svc_handle *svc)
+{
+    FBMOCK_CALL();
+    setHandle(svc, 0);
+    return success(status);
+}
+
+ISC_STATUS ISC_EXPORT isc_service_start(ISC_STATUS *status, isc_svc_handle *, isc_resv_handle *,
+                                        unsigned short, const ISC_SCHAR *)
+{
+    FBMOCK_CALL();
+    return failure(status, isc_wish_list, "fbmock: services are not simulated");
+}
+
+ISC_STATUS ISC_EXPORT isc_service_query(ISC_STATUS *status, isc_svc_handle *, isc_resv_handle *,
+                                        unsigned short, const ISC_SCHAR *, unsigned short,
+                                        const ISC_SCHAR *, unsigned short, ISC_SCHAR *)
+{
+    FBMOCK_CALL();
+    return failure(status, isc_wish_list, "fbmock: services are not simulated");
+}
+
+//-----------------------------------------------------------------------//
+// Status vectors and integers
+
+ISC_LONG ISC_EXPORT isc_vax_integer(const ISC_SCHAR *p, short length)
+{
+    ISC_ULONG value = 0;
+    for (int i = 0; i < length && i < 4; ++i)
+        value |= ISC_ULONG((unsigned char)p[i]) << (8 * i);
+    return ISC_LONG(value);
+}
+
+ISC_LONG ISC_EXPORT isc_sqlcode(const ISC_STATUS *status)
+{
+    if (status[1] == isc_unique_key_violation)
+        return -803;
+    return status[1] == 0 ? 0 : -901;
+}
+
+void ISC_EXPORT isc_sql_interprete(short sqlcode, ISC_SCHAR *buffer, short length)
+{
+    snprintf(buffer, length, "SQLCODE %d (fbmock)", int(sqlcode));
+}
+
+// Formats the message of the error at *vector and moves it past that error
+ISC_LONG ISC_EXPORT isc_interprete(ISC_SCHAR *buffer, ISC_STATUS **vector)
+{
+    ISC_STATUS *v = *vector;
+    if (v[0] != isc_arg_gds || v[1] == 0)
+    {
+        buffer[0] = '\0';
+        return 0;
+    }
+    const char *message = "fbmock: error";
+    if (v[2] == isc_arg_string)
+    {
+        message = (const char *)(uintptr_t)v[3];
+        *vector = v + 4;
+    }
+    else
+        *vector = v + 2;
+    strcpy(buffer, message);
+    return ISC_LONG(strlen(buffer));
+}
+
+//-----------------------------------------------------------------------//
+// Firebird OO API: the interfaces IBPP calls (declared by _oo.h), in their
+// Firebird 4 versions, over the same handles and statements as the isc_*
+// entry points. The calls of their methods are not counted.
+
+namespace {
+
+using namespace ibpp_oo;
+
+struct MockStatus : IStatus
+{
+    MockStatus() { cloopDummy[0] = 0; cloopVTable = table(); clear(); }
+
+    void clear()
+    {
+        errors.assign(3, isc_arg_end);
+        errors[0] = isc_arg_gds;
+        errors[1] = 0;
+    }
+
+    // Copies the status vector of an isc_* call
+    void set(const ISC_STATUS *vector)
+    {
+        errors.clear();
+        for (int i = 0; vector[i] != isc_arg_end; )
+        {
+            const int size = vector[i] == isc_arg_cstring ? 3 : 2;
+            errors.insert(errors.end(), vector + i, vector + i + size);
+            i += size;
+        }
+        errors.push_back(isc_arg_end);
+    }
+
+    static IStatusVTable *table();
+
+    std::vector<intptr_t> errors;
+};
+
+IStatusVTable *MockStatus::table()
+{
+    static IStatusVTable t = [] {
+        IStatusVTable v = IStatusVTable();
+        v.version = 3;
+        v.dispose = [](IStatus *self) { delete static_cast<MockStatus *>(self); };
+        v.init = [](IStatus *self) { static_cast<MockStatus *>(self)->clear(); };
+        v.getState = [](const IStatus *self) {
+            return static_cast<const MockStatus *>(self)->errors[1] != 0 ? IStatus::STATE_ERRORS : 0u;
+        };
+        v.getErrors = [](const IStatus *self) {
+            return (const intptr_t *)&static_cast<const MockStatus *>(self)->errors[0];
+        };
+        return v;
+    }();
+    return &t;
+}
+
+// The result of an isc_* style call in status, true if it succeeded
+bool report(IStatus *status, const ISC_STATUS *vector)
+{
+    if (vector[1] == 0)
+        return true;
+    static_cast<MockStatus *>(status)->set(vector);
+    return false;
+}
+
+// Deletes a reference counted object on its last release. An object is used
+// by one thread at a time, as its handle.
+template <typename T, typename I> int releaseRef(I *self)
+{
+    T *object = static_cast<T *>(self);
+    if (--object->refs != 0)
+        return object->refs;
+    delete object;
+    return 0;
+}
+
+template <typename T, typename I> void addRef(I *self)
+{
+    ++static_cast<T *>(self)->refs;
+}
+
+//-----------------------------------------------------------------------//
+// Messages: every column at an offset aligned for its type, its NULL flag
+// (a short) after it
+
+struct MockField
+{
+    unsigned type;
+    unsigned length;
+    short scale;
+    unsigned offset;
+    unsigned nullOffset;
+};
+
+unsigned alignment(const MockColumn &col)
+{
+    switch (col.type)
+    {
+    case SQL_TEXT: case SQL_BOOLEAN: return 1;
+    case SQL_VARYING: case SQL_SHORT: return 2;
+    case SQL_TIMESTAMP: case SQL_BLOB: case SQL_ARRAY: return 4;
+    case SQL_TIMESTAMP_TZ: case SQL_TIMESTAMP_TZ_EX: return 4;
+    case SQL_TIME_TZ: case SQL_TIME_TZ_EX: return 4;
+    default: return col.length < 8 ? unsigned(col.length) : 8;
+    }
+}
+
+unsigned alignUp(unsigned n, unsigned a)
+{
+    return (n + a - 1) / a * a;
+}
+
+struct MockMetadata : IMessageMetadata
+{
+    // The first count columns of cols, cycling through them
+    MockMetadata(const MockColumns &cols, int count) : length(0), refs(1)
+    {
+        cloopDummy[0] = 0;
+        cloopVTable = table();
+        for (int i = 0; i < count; ++i)
+        {
+            const MockColumn &col = cols[i % cols.size()];
+            MockField f;
+            f.type = unsigned(col.type);
+            f.length = unsigned(col.length);
+            f.scale = col.scale;
+            f.offset = alignUp(length, alignment(col));
+            f.nullOffset = alignUp(f.offset + f.length + (col.type == SQL_VARYING ? 2 : 0), 2);
+            length = f.nullOffset + 2;
+            fields.push_back(f);
+        }
+        length = alignUp(length, 8);
+    }
+
+    static IMessageMetadataVTable *table();
+
+    std::vector<MockField> fields;
+    unsigned length;
+    int refs;
+};
+
+IMessageMetadataVTable *MockMetadata::table()
+{
+    static IMessageMetadataVTable t = [] {
+        IMessageMetadataVTable v = IMessageMetadataVTable();
+        v.version = 4;
+        v.addRef = addRef<MockMetadata, IMessageMetadata>;
+        v.release = releaseRef<MockMetadata, IMessageMetadata>;
+        v.getCount = [](IMessageMetadata *self, IStatus *) {
+            return unsigned(static_cast<MockMetadata *>(self)->fields.size());
+        };
+        v.getType = [](IMessageMetadata *self, IStatus *, unsigned i) {
+            return static_cast<MockMetadata *>(self)->fields.at(i).type;
+        };
+        v.getLength = [](IMessageMetadata *self, IStatus *, unsigned i) {
+            return static_cast<MockMetadata *>(self)->fields.at(i).length;
+        };
+        v.getOffset = [](IMessageMetadata *self, IStatus *, unsigned i) {
+            return static_cast<MockMetadata *>(self)->fields.at(i).offset;
+        };
+        v.getNullOffset = [](IMessageMetadata *self, IStatus *, unsigned i) {
+            return static_cast<MockMetadata *>(self)->fields.at(i).nullOffset;
+        };
+        v.getMessageLength = [](IMessageMetadata *self, IStatus *) {
+            return static_cast<MockMetadata *>(self)->length;
+        };
+        return v;
+    }();
+    return &t;
+}
+
+// An XSQLDA whose columns point in a message, for fillRow()
+class MessageDA
+{
+public:
+    MessageDA(IMessageMetadata *meta, void *message)
+    {
+        const MockMetadata *m = static_cast<MockMetadata *>(meta);
+        const int n = int(m->fields.size());
+        da = (XSQLDA *)calloc(1, XSQLDA_LENGTH(n > 0 ? n : 1));
+        da->version = SQLDA_VERSION1;
+        da->sqln = da->sqld = short(n);
+        for (int i = 0; i < n; ++i)
+        {
+            XSQLVAR &var = da->sqlvar[i];
+            var.sqltype = short(m->fields[i].type | 1);
+            var.sqllen = short(m->fields[i].length);
+            var.sqlscale = m->fields[i].scale;
+            var.sqldata = (char *)message + m->fields[i].offset;
+            var.sqlind = (short *)((char *)message + m->fields[i].nullOffset);
+        }
+    }
+    ~MessageDA() { free(da); }
+
+    XSQLDA *da;
+
+private:
+    MessageDA(const MessageDA &);
+    MessageDA &operator=(const MessageDA &);
+};
+
+//-----------------------------------------------------------------------//
+// Attachments and transactions
+
+struct MockTransaction : ITransaction
+{
+    explicit MockTransaction(unsigned long handle) : id(handle), refs(1)
+    {
+        cloopDummy[0] = 0;
+        cloopVTable = table();
+    }
+
+    static ITransactionVTable *table()
+    {
+        static ITransactionVTable t = [] {
+            ITransactionVTable v = ITransactionVTable();
+            v.version = 3;
+            v.addRef = addRef<MockTransaction, ITransaction>;
+            v.release = releaseRef<MockTransaction, ITransaction>;
+            return v;
+        }();
+        return &t;
+    }
+
+    unsigned long id;
+    int refs;
+};
+
+unsigned long transactionId(ITransaction *transaction)
+{
+    return transaction == 0 ? 0 : static_cast<MockTransaction *>(transaction)->id;
+}
+
+struct MockAttachment : IAttachment
+{
+    explicit MockAttachment(unsigned long handle) : id(handle), refs(1)
+    {
+        cloopDummy[0] = 0;
+        cloopVTable = table();
+    }
+
+    static IAttachmentVTable *table()
+    {
+        static IAttachmentVTable t = [] {
+            IAttachmentVTable v = IAttachmentVTable();
+            v.version = 4;
+            v.addRef = addRef<MockAttachment, IAttachment>;
+            v.release = releaseRef<MockAttachment, IAttachment>;
+            v.startTransaction = [](IAttachment *, IStatus *, unsigned, const unsigned char *) {
+                return (ITransaction *)new MockTransaction(newHandle());
+            };
+            return v;
+        }();
+        return &t;
+    }
+
+    unsigned long id;
+    int refs;
+};
+
+struct MockProvider : IProvider
+{
+    MockProvider() : refs(1) { cloopDummy[0] = 0; cloopVTable = table(); }
+
+    static IProviderVTable *table()
+    {
+        static IProviderVTable t = [] {
+            IProviderVTable v = IProviderVTable();
+            v.version = 4;
+            v.addRef = addRef<MockProvider, IProvider>;
+            v.release = releaseRef<MockProvider, IProvider>;
+            v.attachDatabase = [](IProvider *, IStatus *, const char *, unsigned length,
+                                  const unsigned char *dpb) {
+                const unsigned long id = newHandle();
+                attachOptions(id, dpb, length);
+                return (IAttachment *)new MockAttachment(id);
+            };
+            return v;
+        }();
+        return &t;
+    }
+
+    int refs;
+};
+
+//-----------------------------------------------------------------------//
+// Statements
+
+// A scrollable cursor keeps its position in current: -1 before the first
+// row, rows after the last one
+struct MockResultSet : IResultSet
+{
+    MockResultSet(unsigned long stmt, IMessageMetadata *outMeta, bool scroll)
+        : id(stmt), meta(outMeta), scrollable(scroll), current(-1), refs(1)
+    {
+        cloopDummy[0] = 0;
+        cloopVTable = table();
+        meta->cloopVTable->addRef(meta);
+    }
+    ~MockResultSet()
+    {
+        MockStatement *st = lookup(statements, id);
+        if (st != 0)
+            st->open = false;
+        meta->release();
+    }
+
+    static IResultSetVTable *table();
+    int fetchNext(IStatus *status, void *message);
+    int move(IStatus *status, void *message, long target);
+
+    unsigned long id;
+    IMessageMetadata *meta;
+    bool scrollable;
+    long current;
+    int refs;
+};
+
+int MockResultSet::fetchNext(IStatus *status, void *message)
+{
+    if (scrollable)
+        return move(status, message, current + 1);
+    isc_stmt_handle stmt;
+    setHandle(&stmt, id);
+    MessageDA out(meta, message);
+    ISC_STATUS vector[20];
+    const ISC_STATUS result = fetchStatement(vector, &stmt, out.da);
+    if (!report(status, vector))
+        return IStatus::RESULT_ERROR;
+    return result == 0 ? IStatus::RESULT_OK : IStatus::RESULT_NO_DATA;
+}
+
+// Moves a scrollable cursor to the row target (from 0)
+int MockResultSet::move(IStatus *status, void *message, long target)
+{
+    ISC_STATUS vector[20];
+    MockStatement *st = lookup(statements, id);
+    if (st == 0 || !st->open)
+        failure(vector, isc_dsql_cursor_err, "fbmock: the cursor is not open");
+    else if (!scrollable)
+        failure(vector, isc_dsql_cursor_err, "fbmock: the cursor is not scrollable");
+    else if (target >= 0 && target == fetchError.load())
+        failure(vector, isc_io_error, "fbmock: fetch error");
+    else
+        success(vector);
+    if (!report(status, vector))
+        return IStatus::RESULT_ERROR;
+
+    if (target < 0 || target >= st->rows)
+    {
+        current = target < 0 ? -1 : st->rows;
+        return IStatus::RESULT_NO_DATA;
+    }
+    current = target;
+    MessageDA out(meta, message);
+    fillRow(out.da, st, target);
+    if (st->fetched < target + 1)
+        st->fetched = target + 1;
+    return IStatus::RESULT_OK;
+}
+
+IResultSetVTable *MockResultSet::table()
+{
+    static IResultSetVTable t = [] {
+        IResultSetVTable v = IResultSetVTable();
+        v.version = 3;
+        v.addRef = addRef<MockResultSet, IResultSet>;
+        v.release = releaseRef<MockResultSet, IResultSet>;
+        v.fetchNext = [](IResultSet *self, IStatus *status, void *message) {
+            return static_cast<MockResultSet *>(self)->fetchNext(status, message);
+        };
+        v.fetchPrior = [](IResultSet *self, IStatus *status, void *message) {
+            MockResultSet *rs = static_cast<MockResultSet *>(self);
+            return rs->move(status, message, rs->current - 1);
+        };
+        v.fetchFirst = [](IResultSet *self, IStatus *status, void *message) {
+            return static_cast<MockResultSet *>(self)->move(status, message, 0);
+        };
+        v.fetchLast = [](IResultSet *self, IStatus *status, void *message) {
+            MockResultSet *rs = static_cast<MockResultSet *>(self);
+            MockStatement *st = lookup(statements, rs->id);
+            return rs->move(status, message, st == 0 ? -1 : st->rows - 1);
+        };
+        v.fetchAbsolute = [](IResultSet *self, IStatus *status, int position, void *message) {
+            // From 1, or from the end when negative
+            MockResultSet *rs = static_cast<MockResultSet *>(self);
+            MockStatement *st = lookup(statements, rs->id);
+            const long rows = st == 0 ? 0 : st->rows;
+            return rs->move(status, message, position > 0 ? position - 1L
+                            : position < 0 ? rows + position : -1L);
+        };
+        v.fetchRelative = [](IResultSet *self, IStatus *status, int offset, void *message) {
+            MockResultSet *rs = static_cast<MockResultSet *>(self);
+            return rs->move(status, message, rs->current + offset);
+        };
+        return v;
+    }();
+    return &t;
+}
+
+struct MockCompletionState : IBatchCompletionState
+{
+    MockCompletionState() { cloopDummy[0] = 0; cloopVTable = table(); }
+
+    static IBatchCompletionStateVTable *table();
+
+    std::vector<int> states;                    // Per row
+    std::map<unsigned, std::vector<ISC_STATUS> > errors;
+};
+
+IBatchCompletionStateVTable *MockCompletionState::table()
+{
+    static IBatchCompletionStateVTable t = [] {
+        IBatchCompletionStateVTable v = IBatchCompletionStateVTable();
+        v.version = 3;
+        v.dispose = [](IBatchCompletionState *self) {
+            delete static_cast<MockCompletionState *>(self);
+        };
+        v.getSize = [](IBatchCompletionState *self, IStatus *) {
+            return unsigned(static_cast<MockCompletionState *>(self)->states.size());
+        };
+        v.getState = [](IBatchCompletionState *self, IStatus *, unsigned pos) {
+            return static_cast<MockCompletionState *>(self)->states.at(pos);
+        };
+        v.findError = [](IBatchCompletionState *self, IStatus *, unsigned pos) {
+            const MockCompletionState *cs = static_cast<MockCompletionState *>(self);
+            std::map<unsigned, std::vector<ISC_STATUS> >::const_iterator it = cs->errors.lower_bound(pos);
+            return it == cs->errors.end() ? unsigned(IBatchCompletionState::NO_MORE_ERRORS) : it->first;
+        };
+        v.getStatus = [](IBatchCompletionState *self, IStatus *, IStatus *to, unsigned pos) {
+            const MockCompletionState *cs = static_cast<MockCompletionState *>(self);
+            std::map<unsigned, std::vector<ISC_STATUS> >::const_iterator it = cs->errors.find(pos);
+            if (it != cs->errors.end())
+                report(to, &it->second[0]);
+        };
+        return v;
+    }();
+    return &t;
+}
+
+// The rows are executed one after the other, up to the first that fails
+// unless TAG_MULTIERROR was set
+struct MockBatch : IBatch
+{
+    MockBatch(unsigned long stmt, const MockMetadata &inMeta, unsigned parLength,
+              const unsigned char *par)
+        : id(stmt), meta(inMeta), messageLength(inMeta.length), multiError(false),
+          recordCounts(false), refs(1)
+    {
+        cloopDummy[0] = 0;
+        cloopVTable = table();
+        // Version byte, then tag, 4 bytes little endian length, value
+        for (unsigned i = 1; par != 0 && par[0] == IBatch::VERSION1 && i + 5 <= parLength; )
+        {
+            const unsigned char tag = par[i];
+            const unsigned len = unsigned(isc_vax_integer((const ISC_SCHAR *)par + i + 1, 4));
+            const bool on = len > 0 && i + 5 + len <= parLength
+                && isc_vax_integer((const ISC_SCHAR *)par + i + 5, short(len)) != 0;
+            if (tag == IBatch::TAG_MULTIERROR) multiError = on;
+            else if (tag == IBatch::TAG_RECORD_COUNTS) recordCounts = on;
+            i += 5 + len;
+        }
+    }
+
+    static IBatchVTable *table();
+
+    unsigned long id;
+    MockMetadata meta;
+    unsigned messageLength;
+    bool multiError;
+    bool recordCounts;
+    std::vector<char> rows;
+    int refs;
+};
+
+IBatchVTable *MockBatch::table()
+{
+    static IBatchVTable t = [] {
+        IBatchVTable v = IBatchVTable();
+        v.version = 3;
+        v.addRef = addRef<MockBatch, IBatch>;
+        v.release = releaseRef<MockBatch, IBatch>;
+        v.add = [](IBatch *self, IStatus *, unsigned count, const void *message) {
+            MockBatch *b = static_cast<MockBatch *>(self);
+            b->rows.insert(b->rows.end(), (const char *)message,
+                           (const char *)message + count * b->messageLength);
+        };
+        v.execute = [](IBatch *self, IStatus *, ITransaction *transaction) {
+            MockBatch *b = static_cast<MockBatch *>(self);
+            MockCompletionState *cs = new MockCompletionState;
+            const size_t count = b->messageLength == 0 ? 0 : b->rows.size() / b->messageLength;
+            isc_stmt_handle stmt;
+            setHandle(&stmt, b->id);
+            for (size_t i = 0; i < count; ++i)
+            {
+                ISC_STATUS vector[20];
+                MessageDA in(&b->meta, &b->rows[i * b->messageLength]);
+                if (executeStatement(vector, transactionId(transaction), &stmt, in.da, 0) != 0)
+                {
+                    cs->states.push_back(int(IBatchCompletionState::EXECUTE_FAILED));
+                    std::vector<ISC_STATUS> &error = cs->errors[unsigned(i)];
+                    for (int k = 0; vector[k] != isc_arg_end; ++k)
+                        error.push_back(vector[k]);
+                    error.push_back(isc_arg_end);
+                    if (!b->multiError)
+                        break;
+                }
+                else
+                    cs->states.push_back(b->recordCounts ? 1 : IBatchCompletionState::SUCCESS_NO_INFO);
+            }
+            b->rows.clear();
+            return (IBatchCompletionState *)cs;
+        };
+        return v;
+    }();
+    return &t;
+}
+
+struct MockOOStatement : IStatement
+{
+    explicit MockOOStatement(unsigned long stmt) : id(stmt), refs(1)
+    {
+        cloopDummy[0] = 0;
+        cloopVTable = table();
+    }
+
+    static IStatementVTable *table();
+
+    unsigned long id;
+    int refs;
+};
+
+MockStatement *statementOf(IStatement *self, IStatus *status)
+{
+    MockStatement *st = lookup(statements, static_cast<MockOOStatement *>(self)->id);
+    if (st == 0)
+    {
+        ISC_STATUS vector[20];
+        failure(vector, isc_bad_stmt_handle, "fbmock: invalid statement handle");
+        report(status, vector);
+    }
+    return st;
+}
+
+IStatementVTable *MockOOStatement::table()
+{
+    static IStatementVTable t = [] {
+        IStatementVTable v = IStatementVTable();
+        v.version = IStatement::VERSION_FB4;
+        v.addRef = addRef<MockOOStatement, IStatement>;
+        v.release = releaseRef<MockOOStatement, IStatement>;
+        v.getInputMetadata = [](IStatement *self, IStatus *status) {
+            MockStatement *st = statementOf(self, status);
+            return st == 0 ? (IMessageMetadata *)0
+                : new MockMetadata(*st->columns, st->params);
+        };
+        v.getOutputMetadata = [](IStatement *self, IStatus *status) {
+            MockStatement *st = statementOf(self, status);
+            return st == 0 ? (IMessageMetadata *)0
+                : new MockMetadata(*st->columns, st->type == isc_info_sql_stmt_select
+                                   ? int(st->columns->size()) : 0);
+        };
+        v.execute = [](IStatement *self, IStatus *status, ITransaction *transaction,
+                       IMessageMetadata *inMeta, void *in, IMessageMetadata *outMeta, void *out) {
+            isc_stmt_handle stmt;
+            setHandle(&stmt, static_cast<MockOOStatement *>(self)->id);
+            ISC_STATUS vector[20];
+            std::unique_ptr<MessageDA> inDA(inMeta != 0 && in != 0 ? new MessageDA(inMeta, in) : 0);
+            std::unique_ptr<MessageDA> outDA(outMeta != 0 && out != 0 ? new MessageDA(outMeta, out) : 0);
+            executeStatement(vector, transactionId(transaction), &stmt,
+                             inDA ? inDA->da : 0, outDA ? outDA->da : 0);
+            return report(status, vector) ? transaction : (ITransaction *)0;
+        };
+        v.openCursor = [](IStatement *self, IStatus *status, ITransaction *,
+                          IMessageMetadata *, void *, IMessageMetadata *outMeta, unsigned flags) {
+            isc_stmt_handle stmt;
+            setHandle(&stmt, static_cast<MockOOStatement *>(self)->id);
+            ISC_STATUS vector[20];
+            const bool scroll = (flags & IStatement::CURSOR_TYPE_SCROLLABLE) != 0;
+            if (scroll && !scrollable.load())
+                failure(vector, isc_wish_list, "fbmock: scrollable cursors are not supported");
+            else
+                executeStatement(vector, 0, &stmt, 0, 0);
+            if (!report(status, vector))
+                return (IResultSet *)0;
+            return (IResultSet *)new MockResultSet(static_cast<MockOOStatement *>(self)->id,
+                                                   outMeta, scroll);
+        };
+        v.setTimeout = [](IStatement *self, IStatus *status, unsigned msecs) {
+            MockStatement *st = statementOf(self, status);
+            if (st != 0)
+                st->timeout = msecs;
+        };
+        v.createBatch = [](IStatement *self, IStatus *, IMessageMetadata *inMeta,
+                           unsigned parLength, const unsigned char *par) {
+            return (IBatch *)new MockBatch(static_cast<MockOOStatement *>(self)->id,
+                                           inMeta == 0 ? MockMetadata(MockColumns(), 0)
+                                           : *static_cast<MockMetadata *>(inMeta),
+                                           parLength, par);
+        };
+        return v;
+    }();
+    return &t;
+}
+
+// Decodes the name of the zone only, the date and time fields are left at 0
+struct MockUtil : IUtil
+{
+    MockUtil() { cloopDummy[0] = 0; cloopVTable = table(); }
+
+    static IUtilVTable *table()
+    {
+        static IUtilVTable t = [] {
+            IUtilVTable v = IUtilVTable();
+            v.version = 4;
+            v.decodeTimeStampTz = [](IUtil *, IStatus *status, const ibpp_oo::TimestampTz *ts,
+                                     unsigned *year, unsigned *month, unsigned *day,
+                                     unsigned *hours, unsigned *minutes, unsigned *seconds,
+                                     unsigned *fractions, unsigned length, char *buffer) {
+                *year = *month = *day = *hours = *minutes = *seconds = *fractions = 0;
+                ISC_STATUS vector[20];
+                const MockZone *zone = findZone(ts->time_zone);
+                if (zone == 0)
+                    failure(vector, isc_random, "fbmock: unknown time zone");
+                else
+                {
+                    success(vector);
+                    snprintf(buffer, length, "%s", zone->name);
+                }
+                report(status, vector);
+            };
+            return v;
+        }();
+        return &t;
+    }
+};
+
+struct MockMaster : IMaster
+{
+    MockMaster() { cloopDummy[0] = 0; cloopVTable = table(); }
+
+    static IMasterVTable *table()
+    {
+        static IMasterVTable t = [] {
+            IMasterVTable v = IMasterVTable();
+            v.version = 2;
+            v.getStatus = [](IMaster *) { return (IStatus *)new MockStatus; };
+            v.getDispatcher = [](IMaster *) { return (IProvider *)new MockProvider; };
+            v.getUtilInterface = [](IMaster *) {
+                static MockUtil util;
+                return (IUtil *)&util;
+            };
+            return v;
+        }();
+        return &t;
+    }
+};
+
+} // namespace
+
+// Not declared by this ibase.h (Firebird 2.5)
+extern "C" IMaster *ISC_EXPORT fb_get_master_interface()
+{
+    FBMOCK_CALL();
+    static MockMaster master;
+    return &master;
+}
+
+extern "C" ISC_STATUS ISC_EXPORT fb_get_database_handle(ISC_STATUS *status, isc_db_handle *db,
+                                                       IAttachment *attachment)
+{
+    FBMOCK_CALL();
+    if (attachment == 0)
+        return failure(status, isc_bad_db_handle, "fbmock: invalid attachment");
+    setHandle(db, static_cast<MockAttachment *>(attachment)->id);
+    return success(status);
+}
+
+extern "C" ISC_STATUS ISC_EXPORT fb_get_transaction_handle(ISC_STATUS *status, isc_tr_handle *tr,
+                                                          ITransaction *transaction)
+{
+    FBMOCK_CALL();
+    if (transaction == 0)
+        return failure(status, isc_bad_trans_handle, "fbmock: invalid transaction");
+    setHandle(tr, static_cast<MockTransaction *>(transaction)->id);
+    return success(status);
+}
+
+extern "C" ISC_STATUS ISC_EXPORT fb_get_transaction_interface(ISC_STATUS *status,
+                                                             ITransaction **transaction,
+                                                             isc_tr_handle *tr)
+{
+    FBMOCK_CALL();
+    if (handleId(tr) == 0)
+        return failure(status, isc_bad_trans_handle, "fbmock: invalid transaction handle");
+    *transaction = new MockTransaction(handleId(tr));
+    return success(status);
+}
+
+extern "C" ISC_STATUS ISC_EXPORT fb_get_statement_interface(ISC_STATUS *status,
+                                                           IStatement **statement,
+                                                           isc_stmt_handle *stmt)
+{
+    FBMOCK_CALL();
+    if (lookup(statements, handleId(stmt)) == 0)
+        return failure(status, isc_bad_stmt_handle, "fbmock: invalid statement handle");
+    *statement = new MockOOStatement(handleId(stmt));
+    return success(status);
+}
@@ -0,0 +1,90 @@
+/*
+* This file is part of QtFirebirdIBPPSQLDriver - Qt SQL driver for Firebird with IBPP library
+* Copyright (C) 2006-2010 Alex Wencel
+*
+* Contact e-mail: Alex Wencel <alex.wencel@gmail.com>
+* Program URL   : http://code.google.com/p/qtfirebirdibppsqldriver
+*
+* GNU Lesser General Public License Usage
+* This file may be used under the terms of the GNU Lesser
+* General Public License version 2.1 as published by the Free Software
+* Foundation and appearing in the file LICENSE.LGPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU Lesser General Public License version 2.1 requirements
+* will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+*
+* GNU General Public License Usage
+* Alternatively, this file may be used under the terms of the GNU
+* General Public License version 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU General Public License version 3.0 requirements will be
+* met: http://www.gnu.org/copyleft/gpl.html.
+*
+*/
+
+#ifndef FBMOCK_H
+#define FBMOCK_H
+
+// Extra entry points of the mock client library (libfbmock), for the programs
+// linked against it instead of fbclient. The settings are read from the
+// environment on first use (FBMOCK_COLUMNS, FBMOCK_ROWS, FBMOCK_BLOB_SIZE,
+// FBMOCK_NULL_EVERY); fbmock_configure() replaces them for the statements
+// prepared afterwards.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// columns: comma separated SQL types of the result set of every SELECT, as in
+// "INTEGER,BIGINT,NUMERIC(18,4),VARCHAR(40),TIMESTAMP,BLOB SUB_TYPE TEXT",
+// "INTEGER[8]" being a one dimension array of a numeric type. INT128 and the
+// NUMERIC of 19 to 38 digits are stored in 16 bytes, with values beyond 64
+// bits.
+// A null columns, or a negative rows / blobSize, keeps the current value.
+// Returns 0, or -1 when columns can't be parsed (nothing is changed then).
+int fbmock_configure(const char *columns, int rows, int blobSize);
+
+// Every nullEvery-th row of a SELECT has NULL in all its columns (0: never)
+void fbmock_set_null_every(int nullEvery);
+
+// Number of calls made to the isc_* and fb_* entry points since the library
+// was loaded; the methods of the OO API interfaces are not counted
+unsigned long long fbmock_calls(void);
+
+// Every execution waits msecs first (0: none), unless fb_cancel_operation()
+// cancels it meanwhile: it then fails with isc_cancelled
+void fbmock_set_execute_delay(int msecs);
+
+// The fetch of the row-th row (from 0) of every SELECT fails (-1: never)
+void fbmock_set_fetch_error(int row);
+
+// With 0, IStatement::openCursor() refuses the scrollable cursors, as a
+// server older than Firebird 5 does (default 1)
+void fbmock_set_scrollable_cursors(int enabled);
+
+// The executions of an INSERT or EXECUTE BLOCK with a parameter of this text
+// value fail with isc_unique_key_violation (SQLCODE -803) and keep no row;
+// in an IBatch only the row holding it fails. Null or "": none fails.
+void fbmock_set_insert_error(const char *value);
+
+// The rows committed by INSERT and EXECUTE BLOCK since the last clear, their
+// parameters cut in rows of as many values as the configured columns. A row
+// is the text of its values separated by '|', "NULL" for a null, numbers at
+// their scale ("12.5000"), dates and times as their ISC_DATE / ISC_TIME
+// numbers. The rows of a transaction are kept on its commit, and dropped by
+// its rollback or a ROLLBACK TO SAVEPOINT (isc_dsql_execute_immediate())
+// back to the savepoint.
+int fbmock_inserted_rows(void);
+
+// Writes the index-th committed row (from 0) in buffer, truncated to size - 1
+// bytes and ended by '\0'. Returns its length, or -1 past the last row.
+int fbmock_inserted_row(int index, char *buffer, int size);
+
+void fbmock_clear_inserted_rows(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FBMOCK_H
@@ -0,0 +1,12 @@
+# Mock client library: the isc_* entry points of fbclient answered from
+# memory with generated rows, to measure the driver without a server.
+# Programs built with "CONFIG += fb_mock" link it instead of fbclient.
+TEMPLATE = lib
+CONFIG -= qt
+CONFIG += c++11
+TARGET = fbmock
+DESTDIR = $$PWD/../../lib
+
+INCLUDEPATH += $$PWD/../../ibpp2531/core
+HEADERS += fbmock.h
+SOURCES += fbmock.cpp
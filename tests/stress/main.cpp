@@ -0,0 +1,248 @@
+/*
+* This file is part of QtFirebirdIBPPSQLDriver - Qt SQL driver for Firebird with IBPP library
+* Copyright (C) 2006-2010 Alex Wencel
+*
+* Contact e-mail: Alex Wencel <alex.wencel@gmail.com>
+* Program URL   : http://code.google.com/p/qtfirebirdibppsqldriver
+*
+* GNU Lesser General Public License Usage
+* This file may be used under the terms of the GNU Lesser
+* General Public License version 2.1 as published by the Free Software
+* Foundation and appearing in the file LICENSE.LGPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU Lesser General Public License version 2.1 requirements
+* will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+*
+* GNU General Public License Usage
+* Alternatively, this file may be used under the terms of the GNU
+* General Public License version 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in the
+* packaging of this file.  Please review the following information to
+* ensure the GNU General Public License version 3.0 requirements will be
+* met: http://www.gnu.org/copyleft/gpl.html.
+*
+*/
+
+#include <QtDebug>
+#include <QCoreApplication>
+#include <QAtomicInt>
+#include <QSemaphore>
+#include <QSqlDatabase>
+#include <QSqlDriverCreator>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QThread>
+
+#include "ibpp.h"
+#include "qfbparallelquery.h"
+#include "qsql_ibpp.h"
+
+static QString dbName, dbUser, dbPassword;
+static int iterations = 200;
+
+static QAtomicInt failures;
+static QSemaphore startGate;
+
+static void fail(int thread, const QString &what)
+{
+    failures.fetchAndAddOrdered(1);
+    qWarning("thread %d: %s", thread, what.toLocal8Bit().constData());
+}
+
+//-----------------------------------------------------------------------//
+// Copies and drops Ptr's to one shared object from every thread at once.
+class RefCountThread : public QThread
+{
+public:
+    RefCountThread(IBPP::Database db) : iDb(db) {}
+
+protected:
+    void run() Q_DECL_OVERRIDE
+    {
+        startGate.acquire();
+        for (int i = 0; i < 200000; ++i)
+        {
+            IBPP::Database copy1(iDb);
+            IBPP::Database copy2 = copy1;
+            copy1.clear();
+        }
+        iDb.clear();
+    }
+
+private:
+    IBPP::Database iDb;
+};
+
+//-----------------------------------------------------------------------//
+// Opens a QFBDriver attachment (all threads at the same time, so that the
+// first GDS::Call() races) and runs queries and transactions on it.
+class DriverThread : public QThread
+{
+public:
+    DriverThread(int id, int expected) : mId(id), mExpected(expected) {}
+
+protected:
+    void run() Q_DECL_OVERRIDE
+    {
+        QFBDriver driver;
+        startGate.acquire();
+
+        if (!driver.open(dbName, dbUser, dbPassword, QString(), 0, QString()))
+        {
+            fail(mId, QLatin1String("open: ") + driver.lastError().text());
+            return;
+        }
+
+        for (int i = 0; i < iterations; ++i)
+        {
+            if (!driver.beginTransaction())
+            {
+                fail(mId, QLatin1String("begin: ") + driver.lastError().text());
+                break;
+            }
+
+            QSqlQuery q(driver.createResult());
+            q.setForwardOnly(true);
+            if (!q.exec(QLatin1String("SELECT COUNT(*) FROM RDB$RELATIONS")) || !q.next())
+                fail(mId, QLatin1String("select: ") + q.lastError().text());
+            else if (q.value(0).toInt() != mExpected)
+                fail(mId, QString::fromLatin1("select: got %1, expected %2")
+                     .arg(q.value(0).toInt()).arg(mExpected));
+            q.finish();
+
+            const bool ok = (i % 2) ? driver.commitTransaction() : driver.rollbackTransaction();
+            if (!ok)
+                fail(mId, QLatin1String("end: ") + driver.lastError().text());
+        }
+
+        driver.close();
+    }
+
+private:
+    int mId;
+    int mExpected;
+};
+
+//-----------------------------------------------------------------------//
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+
+    if (args.count() < 2)
+    {
+        qWarning("usage: stress <database> [user] [password] [threads] [iterations]");
+        return 2;
+    }
+
+    dbName = args.at(1);
+    dbUser = args.value(2, QString::fromLocal8Bit(qgetenv("ISC_USER")));
+    dbPassword = args.value(3, QString::fromLocal8Bit(qgetenv("ISC_PASSWORD")));
+    const int threads = args.value(4, QString::number(QThread::idealThreadCount())).toInt();
+    iterations = args.value(5, QString::number(iterations)).toInt();
+
+    qDebug("stress: %d threads, %d iterations", threads, iterations);
+
+    // Phase 1 : concurrent first use of the client library, then
+    // transactions and queries on one attachment per thread.
+    int expected = -1;
+    {
+        QFBDriver driver;
+        if (driver.open(dbName, dbUser, dbPassword, QString(), 0, QString()))
+        {
+            QSqlQuery q(driver.createResult());
+            if (q.exec(QLatin1String("SELECT COUNT(*) FROM RDB$RELATIONS")) && q.next())
+                expected = q.value(0).toInt();
+            q.finish();
+            driver.close();
+        }
+        if (expected < 0)
+        {
+            qWarning("stress: unable to read the reference count: %s",
+                     driver.lastError().text().toLocal8Bit().constData());
+            return 2;
+        }
+    }
+
+    QList<QThread *> workers;
+    for (int i = 0; i < threads; ++i)
+        workers << new DriverThread(i, expected);
+    foreach (QThread *t, workers)
+        t->start();
+    startGate.release(threads);
+    foreach (QThread *t, workers)
+        t->wait();
+    qDeleteAll(workers);
+    workers.clear();
+
+    // Phase 2 : Ptr reference counting across threads
+    {
+        IBPP::Database shared = IBPP::DatabaseFactory("", dbName.toStdString(),
+                                                      dbUser.toStdString(),
+                                                      dbPassword.toStdString());
+        for (int i = 0; i < threads; ++i)
+            workers << new RefCountThread(shared);
+        foreach (QThread *t, workers)
+            t->start();
+        startGate.release(threads);
+        foreach (QThread *t, workers)
+            t->wait();
+        qDeleteAll(workers);
+
+        // the worker copies are all gone : this one must still be alive
+        if (shared->DatabaseName() != dbName.toStdString())
+            fail(-1, QLatin1String("refcount: shared database object damaged"));
+    }
+
+    // Phase 3 : more parallel queries queued than the executor has
+    // attachments; each one waits for its partitions, which must still run
+    {
+        QSqlDatabase::registerSqlDriver(QLatin1String("QFIREBIRD"),
+                                        new QSqlDriverCreator<QFBDriver>);
+        QSqlDatabase db = QSqlDatabase::addDatabase(QLatin1String("QFIREBIRD"),
+                                                    QLatin1String("parallel"));
+        db.setDatabaseName(dbName);
+        db.setUserName(dbUser);
+        db.setPassword(dbPassword);
+
+        {
+            QFBParallelQuery pq(db);
+            pq.setConnections(2);
+            pq.setBatchSize(8);
+            pq.setMaxPendingBatches(1);
+            QList<QFBRowStream *> streams;
+            for (int i = 0; i < threads + 2; ++i)
+                streams << pq.execByKey(QLatin1String("SELECT RDB$RELATION_ID FROM RDB$RELATIONS"),
+                                        QLatin1String("RDB$RELATION_ID"));
+
+            // small batches and a single pending one: the partitions wait
+            // for this thread to take them
+            for (int i = 0; i < streams.count(); ++i)
+            {
+                int rows = 0;
+                while (streams.at(i)->waitForBatch(120000))
+                {
+                    const QFBRowBatch batch = streams.at(i)->takeBatch();
+                    if (batch.error.isValid())
+                        fail(-1, QLatin1String("parallel: ") + batch.error.text());
+                    rows += batch.rows.count();
+                }
+                if (!streams.at(i)->isFinished())
+                    qFatal("stress: a queued parallel query never completed");
+                if (rows != expected)
+                    fail(-1, QString::fromLatin1("parallel: got %1 rows, expected %2")
+                         .arg(rows).arg(expected));
+            }
+            if (!pq.waitForDone(120000))
+                qFatal("stress: the parallel queries never ended");
+        }
+
+        db = QSqlDatabase();
+        QSqlDatabase::removeDatabase(QLatin1String("parallel"));
+    }
+
+    const int failed = failures.load();
+    qDebug("stress: %s (%d failures)", failed ? "FAILED" : "passed", failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,14 @@
+# Concurrency stress test: N threads, each with its own QFBDriver attachment.
+# Usage: stress <database> [user] [password] [threads] [iterations]
+QT += core sql sql-private core-private
+QT -= gui
+CONFIG += console
+CONFIG -= app_bundle
+TEMPLATE = app
+TARGET = stress
+
+DEFINES += QT_NO_CAST_TO_ASCII \
+    QT_NO_CAST_FROM_ASCII
+
+SOURCES += main.cpp
+include(../../src/qsqlfb.pri) # +=   driver, IBPP
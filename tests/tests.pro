@@ -0,0 +1,13 @@
+# Test and benchmark programs of the driver, built with their own copy of
+# the driver sources: qmake tests/tests.pro
+# (qmake "CONFIG += fb_mock" tests/tests.pro links them with tests/fbmock)
+TEMPLATE = subdirs
+SUBDIRS = fbmock \
+    stress \
+    bench \
+    allocs \
+    driver
+stress.depends = fbmock
+bench.depends = fbmock
+allocs.depends = fbmock
+driver.depends = fbmock